@@ -20,7 +20,12 @@ struct OrtArenaCfg {
                   initial_chunk_size_bytes(-1),
                   max_dead_bytes_per_chunk(-1),
                   initial_growth_chunk_size_bytes(-1),
-                  max_power_of_two_extend_bytes(-1) {}
+                  max_power_of_two_extend_bytes(-1),
+                  idle_region_release_ms(-1),
+                  trim_high_watermark_bytes(-1),
+                  trim_low_watermark_bytes(-1),
+                  background_trim_interval_ms(-1),
+                  size_class_cache_max_bytes(-1) {}
   OrtArenaCfg(size_t max_mem, int arena_extend_strategy, int initial_chunk_size_bytes,
               int max_dead_bytes_per_chunk, int initial_growth_chunk_size_bytes,
               int64_t max_power_of_two_extend_bytes)
@@ -29,7 +34,12 @@ struct OrtArenaCfg {
         initial_chunk_size_bytes(initial_chunk_size_bytes),
         max_dead_bytes_per_chunk(max_dead_bytes_per_chunk),
         initial_growth_chunk_size_bytes(initial_growth_chunk_size_bytes),
-        max_power_of_two_extend_bytes(max_power_of_two_extend_bytes) {}
+        max_power_of_two_extend_bytes(max_power_of_two_extend_bytes),
+        idle_region_release_ms(-1),
+        trim_high_watermark_bytes(-1),
+        trim_low_watermark_bytes(-1),
+        background_trim_interval_ms(-1),
+        size_class_cache_max_bytes(-1) {}
 
   size_t max_mem;                         // use 0 to allow ORT to choose the default
   int arena_extend_strategy;              // use -1 to allow ORT to choose the default, 0 = kNextPowerOfTwo, 1 = kSameAsRequested
@@ -37,6 +47,11 @@ struct OrtArenaCfg {
   int max_dead_bytes_per_chunk;           // use -1 to allow ORT to choose the default
   int initial_growth_chunk_size_bytes;    // use -1 to allow ORT to choose the default
   int64_t max_power_of_two_extend_bytes;  // use -1 to allow ORT to choose the default
+  int64_t idle_region_release_ms;         // use -1 to allow ORT to choose the default
+  int64_t trim_high_watermark_bytes;      // use -1 to allow ORT to choose the default
+  int64_t trim_low_watermark_bytes;       // use -1 to allow ORT to choose the default
+  int64_t background_trim_interval_ms;    // use -1 to allow ORT to choose the default
+  int64_t size_class_cache_max_bytes;     // use -1 to allow ORT to choose the default
 };
 
 namespace onnxruntime {
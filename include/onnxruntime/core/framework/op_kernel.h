@@ -129,6 +129,40 @@ class OpKernel {
     return Status::OK();
   }
 
+  // Override this function, along with UsePersistedPrePackedBuffers(), to allow the pre-packed weights of the kernel
+  // to be persisted across processes (see kOrtSessionOptionsPrepackedWeightsCacheDir).
+  // It is called once PrePack() has been called for all the constant initializers of the kernel, for each input index
+  // PrePack() packed.
+  // @param input_idx: The input index of the tensor in this kernel
+  // @param prepacked_buffers: The pre-packed buffers for the input index, in the order UsePersistedPrePackedBuffers()
+  //                           expects them. Leave it empty if the buffers can't be persisted.
+  virtual Status GetPrePackedBuffersToPersist(int /*input_idx*/,
+                                              /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const {
+    prepacked_buffers.clear();
+    return Status::OK();
+  }
+
+  // Override this function to use pre-packed buffers persisted by an earlier session in place of PrePack().
+  // Unlike UseSharedPrePackedBuffers(), PrePack() is NOT called for the input index beforehand, so the kernel has to
+  // set up any state it derives from the constant initializer in PrePack().
+  // @param tensor: The constant initializer the buffers were packed from
+  // @param prepacked_buffers: The buffers returned by GetPrePackedBuffersToPersist(). As for
+  //                           UseSharedPrePackedBuffers() they are raw pointers that remain valid for the lifetime of
+  //                           the session. Each buffer is aligned to at least 64 bytes.
+  // @param prepacked_buffer_sizes: The size in bytes of each buffer. The kernel must check them against the sizes
+  //                                PrePack() would produce, as the entry may come from a different build or model.
+  // @param input_idx: The input index of the tensor in this kernel
+  // @param used_persisted_buffers: Set to true if the kernel uses the buffers. The constant initializer is then
+  //                                released as if PrePack() had packed it. If false, PrePack() is called instead.
+  virtual Status UsePersistedPrePackedBuffers(const Tensor& /*tensor*/,
+                                              std::vector<BufferUniquePtr>& /*prepacked_buffers*/,
+                                              gsl::span<const size_t> /*prepacked_buffer_sizes*/,
+                                              int /*input_idx*/,
+                                              /*out*/ bool& used_persisted_buffers) {
+    used_persisted_buffers = false;
+    return Status::OK();
+  }
+
   const OrtDevice GetDevice(OrtMemType mem_type) const;
   const OpKernelInfo& Info() const {
     return *op_kernel_info_;
@@ -39,7 +39,10 @@
 #pragma warning(disable : 4127)
 #pragma warning(disable : 4805)
 #endif
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <vector>
 #include "unsupported/Eigen/CXX11/ThreadPool"
 
 #if defined(__GNUC__)
@@ -77,6 +80,10 @@
 //
 //   This spin-then-block behavior is configured via a flag provided
 //   when creating the thread pool, and by the constant spin_count.
+//   With ThreadOptions::adaptive_spinning, each worker instead learns
+//   how long to spin from the gaps it observes between tasks (see
+//   AdaptiveSpinPolicy).  Callers may temporarily force full-length
+//   spinning via EnterLatencyMode.
 //
 // - Although all tasks are simple void()->void functions,
 //   conceptually there are three different kinds:
@@ -230,6 +237,9 @@ class ThreadPoolProfiler {
   void LogCoreAndBlock(std::ptrdiff_t){};
   void LogThreadId(int) {};
   void LogRun(int) {};
+  void LogSpin(int, uint64_t, bool) {};
+  void LogBlock(int) {};
+  bool IsEnabled() const { return false; }
   std::string DumpChildThreadStat() { return {}; }
 };
 #else
@@ -256,6 +266,10 @@ class ThreadPoolProfiler {
   void LogCoreAndBlock(std::ptrdiff_t block_size);  // called in main thread to log core and block size for task breakdown
   void LogThreadId(int thread_idx);                 // called in child thread to log its id
   void LogRun(int thread_idx);                      // called in child thread to log num of run
+  // called in child thread to log time spent spinning for work, and whether the spin found work
+  void LogSpin(int thread_idx, uint64_t spin_ns, bool found_work);
+  void LogBlock(int thread_idx);                    // called in child thread to log that it blocked waiting for work
+  bool IsEnabled() const { return enabled_; }
   std::string DumpChildThreadStat();                // return all child statitics collected so far
 
  private:
@@ -283,6 +297,10 @@ class ThreadPoolProfiler {
   struct ORT_ALIGN_TO_AVOID_FALSE_SHARING ChildThreadStat {
     std::thread::id thread_id_;
     uint64_t num_run_ = 0;
+    uint64_t spin_ns_ = 0;        // time spent spinning for work
+    uint64_t num_spin_hit_ = 0;   // spins that found work, avoiding a wake-up
+    uint64_t num_spin_miss_ = 0;  // spins that ended with the thread blocking
+    uint64_t num_block_ = 0;      // times the thread blocked, each adding wake-up latency to the next task
     onnxruntime::TimePoint last_logged_point_ = Clock::now();
     int32_t core_ = -1;  // core that the child thread is running on
   };
@@ -694,6 +712,60 @@ class RunQueue {
 
 static std::atomic<uint32_t> next_tag{1};
 
+// AdaptiveSpinPolicy decides how long an idle worker spins for new work
+// before blocking, when ThreadOptions::adaptive_spinning is set.
+//
+// Spinning avoids the wake-up latency of a blocked thread, but burns CPU
+// if the next task is far away.  The policy learns a spin limit from the
+// gaps the worker observes between running out of work and receiving
+// the next task, using exponential backoff:
+//
+// - If the worker blocked and the next task arrived within twice the
+//   limit, spinning a little longer would have avoided the wake-up, so
+//   the limit doubles.
+//
+// - If the next task arrived later than that, the spin was wasted, so
+//   the limit halves.
+//
+// Spinning is also bounded by a budget: a worker earns spin credit
+// while running tasks and spends it while spinning, so that beyond a
+// small initial allowance a worker does not spin for longer than it
+// runs tasks.
+
+class AdaptiveSpinPolicy {
+ public:
+  static constexpr uint64_t kMinSpinNs = 2000;     // about the cost of waking a blocked thread
+  static constexpr uint64_t kMaxSpinNs = 5000000;  // spin no longer than this regardless of history
+  static constexpr uint64_t kInitialSpinNs = 64000;
+  static constexpr int64_t kMaxCreditNs = 2 * kMaxSpinNs;
+
+  // Returns the time to spin for, or 0 if the worker should block immediately.
+  uint64_t SpinLimitNs() const {
+    return credit_ns_ > 0 ? spin_limit_ns_ : 0;
+  }
+
+  void OnTaskRun(uint64_t run_ns) {
+    credit_ns_ = std::min<int64_t>(kMaxCreditNs, credit_ns_ + static_cast<int64_t>(run_ns));
+  }
+
+  void OnSpin(uint64_t spin_ns) {
+    credit_ns_ -= static_cast<int64_t>(spin_ns);
+  }
+
+  // Called when the worker blocked, and then woke up with work gap_ns after it ran out of work.
+  void OnWakeUp(uint64_t gap_ns) {
+    if (gap_ns < 2 * spin_limit_ns_) {
+      spin_limit_ns_ = std::min(kMaxSpinNs, 2 * spin_limit_ns_);
+    } else {
+      spin_limit_ns_ = std::max(kMinSpinNs, spin_limit_ns_ / 2);
+    }
+  }
+
+ private:
+  uint64_t spin_limit_ns_ = kInitialSpinNs;
+  int64_t credit_ns_ = kMaxCreditNs;
+};
+
 template <typename Environment>
 class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInterface {
  private:
@@ -772,6 +844,7 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
         env_(env),
         num_threads_(num_threads),
         allow_spinning_(allow_spinning),
+        adaptive_spinning_(thread_options.adaptive_spinning),
         set_denormal_as_zero_(thread_options.set_denormal_as_zero),
         worker_data_(num_threads),
         all_coprimes_(num_threads),
@@ -789,6 +862,8 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
       ComputeCoprimes(i, &all_coprimes_.back());
     }
 
+    InitializeNumaNodes(thread_options.numa_nodes);
+
     // Eigen::MaxSizeVector has neither essential exception safety features
     // such as swap, nor it is movable. So we have to join threads right here
     // on exception
@@ -817,7 +892,14 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
 
   void Schedule(std::function<void()> fn) override {
     PerThread* pt = GetPerThread();
-    int q_idx = Rand(&pt->rand) % num_threads_;
+    int q_idx;
+    if (node_workers_.size() > 1 && pt->pool == this) {
+      // Keep work submitted from a worker on the worker's NUMA node.
+      const auto& local = node_workers_[worker_node_[pt->thread_id]];
+      q_idx = local[Rand(&pt->rand) % local.size()];
+    } else {
+      q_idx = Rand(&pt->rand) % num_threads_;
+    }
     WorkerData& td = worker_data_[q_idx];
     Queue& q = td.queue;
     fn = q.PushBack(std::move(fn));
@@ -1323,6 +1405,19 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     return -1;
   }
 
+  // Returns the number of NUMA nodes the workers are grouped into. This is 1 unless the pool was created
+  // with NUMA information in ThreadOptions::numa_nodes.
+  unsigned NumNumaNodes() const {
+    return static_cast<unsigned>(node_workers_.size());
+  }
+
+  // Returns the NUMA node, in the range [0, NumNumaNodes()), of the calling thread if it is a worker of this
+  // pool, and -1 otherwise.
+  int CurrentNumaNode() const {
+    const int thread_id = CurrentThreadId();
+    return thread_id < 0 ? -1 : static_cast<int>(worker_node_[thread_id]);
+  }
+
   void EnableSpinning() {
     spin_loop_status_ = SpinLoopStatus::kBusy;
   }
@@ -1331,7 +1426,55 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     spin_loop_status_ = SpinLoopStatus::kIdle;
   }
 
+  // While at least one caller is in latency mode, idle workers spin for the full spin count before blocking,
+  // regardless of the adaptive spinning policy and of whether the pool allows spinning.  This trades CPU time
+  // for the lowest wake-up latency on requests that need it.  Calls must be paired.
+  void EnterLatencyMode() {
+    latency_mode_requests_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void ExitLatencyMode() {
+    latency_mode_requests_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Once started, workers accumulate the time they spend running tasks, at the cost of two clock
+  // reads per task.  Tracking cannot be stopped.
+  void StartTrackingBusyTime() {
+    track_busy_time_.store(true, std::memory_order_relaxed);
+  }
+
+  // Total time in nanoseconds the workers have spent running tasks while busy time was tracked.
+  uint64_t BusyTimeNs() const {
+    uint64_t total = 0;
+    for (const auto& td : worker_data_) {
+      total += td.busy_ns.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
  private:
+  // Groups the workers by NUMA node. numa_nodes holds the OS node id of each worker, with -1 for a worker
+  // whose node is unknown; the groups are numbered densely from 0.  Without NUMA information all the workers
+  // form a single group.
+  void InitializeNumaNodes(const std::vector<int>& numa_nodes) {
+    worker_node_.assign(num_threads_, 0);
+    node_workers_.assign(1, std::vector<unsigned>());
+    if (numa_nodes.size() >= num_threads_) {
+      std::vector<int> node_ids;
+      for (unsigned i = 0; i < num_threads_; i++) {
+        auto it = std::find(node_ids.begin(), node_ids.end(), numa_nodes[i]);
+        worker_node_[i] = static_cast<unsigned>(it - node_ids.begin());
+        if (it == node_ids.end()) {
+          node_ids.push_back(numa_nodes[i]);
+        }
+      }
+      node_workers_.resize(std::max<size_t>(node_ids.size(), 1));
+    }
+    for (unsigned i = 0; i < num_threads_; i++) {
+      node_workers_[worker_node_[i]].push_back(i);
+    }
+  }
+
   void ComputeCoprimes(int N, Eigen::MaxSizeVector<unsigned>* coprimes) {
     for (int i = 1; i <= N; i++) {
       unsigned a = i;
@@ -1394,6 +1537,9 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     std::unique_ptr<Thread> thread;
     Queue queue;
 
+    // Time spent running tasks, see StartTrackingBusyTime.  Written only by the worker.
+    std::atomic<uint64_t> busy_ns{0};
+
     // Each thread has a status, available read-only without locking, and protected
     // by the mutex field below for updates.  The status is used for three
     // purposes:
@@ -1491,9 +1637,12 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
   Environment& env_;
   const unsigned num_threads_;
   const bool allow_spinning_;
+  const bool adaptive_spinning_;
   const bool set_denormal_as_zero_;
   Eigen::MaxSizeVector<WorkerData> worker_data_;
   Eigen::MaxSizeVector<Eigen::MaxSizeVector<unsigned>> all_coprimes_;
+  std::vector<unsigned> worker_node_;                // NUMA node group of each worker
+  std::vector<std::vector<unsigned>> node_workers_;  // Workers of each NUMA node group
   std::atomic<unsigned> blocked_;  // Count of blocked workers, used as a termination condition
   std::atomic<bool> done_;
 
@@ -1509,6 +1658,11 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
   // Default is no control over spinning
   std::atomic<SpinLoopStatus> spin_loop_status_{SpinLoopStatus::kBusy};
 
+  // Number of callers currently in latency mode, see EnterLatencyMode.
+  std::atomic<int> latency_mode_requests_{0};
+
+  std::atomic<bool> track_busy_time_{false};
+
   // Wake any blocked workers so that they can cleanly exit WorkerLoop().  For
   // a clean exit, each thread will observe (1) done_ set, indicating that the
   // destructor has been called, (2) all threads blocked, and (3) no
@@ -1532,8 +1686,16 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     assert(td.GetStatus() == WorkerData::ThreadStatus::Spinning);
 
     constexpr int log2_spin = 20;
-    const int spin_count = allow_spinning_ ? (1ull << log2_spin) : 0;
-    const int steal_count = spin_count / 100;
+    constexpr int max_spin_count = 1 << log2_spin;
+    const int spin_count = allow_spinning_ ? max_spin_count : 0;
+    const int steal_count = max_spin_count / 100;
+    const bool adaptive_spinning = allow_spinning_ && adaptive_spinning_;
+    AdaptiveSpinPolicy spin_policy;
+    using SpinClock = std::chrono::steady_clock;
+    auto elapsed_ns = [](SpinClock::time_point since) {
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(SpinClock::now() - since).count());
+    };
 
     SetDenormalAsZero(set_denormal_as_zero_);
     profiler_.LogThreadId(thread_id);
@@ -1541,8 +1703,21 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     while (!should_exit) {
       Task t = q.PopFront();
       if (!t) {
+        // Work out how long to spin.  In latency mode we always spin for the full count.  Otherwise, with
+        // adaptive spinning, the spin is bounded by the time limit learned by spin_policy, checked every
+        // 64 iterations to keep the clock off the fast path.
+        const bool latency_mode = latency_mode_requests_.load(std::memory_order_relaxed) > 0;
+        const bool limit_spin_time = adaptive_spinning && !latency_mode;
+        const uint64_t spin_limit_ns = limit_spin_time ? spin_policy.SpinLimitNs() : 0;
+        int spin_iterations = latency_mode ? max_spin_count : spin_count;
+        if (limit_spin_time && spin_limit_ns == 0) {
+          spin_iterations = 0;  // Out of spin credit
+        }
+        const bool timed = adaptive_spinning || profiler_.IsEnabled();
+        const SpinClock::time_point idle_start = timed ? SpinClock::now() : SpinClock::time_point{};
+
         // Spin waiting for work.
-        for (int i = 0; i < spin_count && !done_; i++) {
+        for (int i = 0; i < spin_iterations && !done_; i++) {
           if (((i + 1) % steal_count == 0)) {
             t = Steal(StealAttemptKind::TRY_ONE);
           } else {
@@ -1553,11 +1728,23 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
           if (spin_loop_status_.load(std::memory_order_relaxed) == SpinLoopStatus::kIdle) {
             break;
           }
+          if (limit_spin_time && (i & 63) == 63 && elapsed_ns(idle_start) >= spin_limit_ns) {
+            break;
+          }
           onnxruntime::concurrency::SpinPause();
         }
 
+        if (timed && spin_iterations > 0) {
+          const uint64_t spin_ns = elapsed_ns(idle_start);
+          if (limit_spin_time) {
+            spin_policy.OnSpin(spin_ns);
+          }
+          profiler_.LogSpin(thread_id, spin_ns, t != nullptr);
+        }
+
         // Attempt to block
         if (!t) {
+          bool blocked = false;
           td.SetBlocked(  // Pre-block test
               [&]() -> bool {
                 bool should_block = true;
@@ -1613,18 +1800,35 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
               // Post-block update (executed only if we blocked)
               [&]() {
                 blocked_--;
+                blocked = true;
               });
           // Thread just unblocked.  Unless we picked up work while
           // blocking, or are exiting, then either work was pushed to
           // us, or it was pushed to an overloaded queue
           if (!t) t = q.PopFront();
           if (!t) t = Steal(StealAttemptKind::TRY_ALL);
+
+          if (blocked) {
+            profiler_.LogBlock(thread_id);
+            if (adaptive_spinning && t) {
+              spin_policy.OnWakeUp(elapsed_ns(idle_start));
+            }
+          }
         }
       }
 
       if (t) {
         td.SetActive();
+        const bool time_task = adaptive_spinning || track_busy_time_.load(std::memory_order_relaxed);
+        const SpinClock::time_point run_start = time_task ? SpinClock::now() : SpinClock::time_point{};
         t();
+        if (time_task) {
+          const uint64_t run_ns = elapsed_ns(run_start);
+          if (adaptive_spinning) {
+            spin_policy.OnTaskRun(run_ns);
+          }
+          td.busy_ns.store(td.busy_ns.load(std::memory_order_relaxed) + run_ns, std::memory_order_relaxed);
+        }
         profiler_.LogRun(thread_id);
         td.SetSpinning();
       }
@@ -1643,10 +1847,27 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
   // is that the thread is busy with other work, and we will avoid
   // "snatching" work from a thread which is just about to notice the
   // work itself.
+  //
+  // When the workers are grouped by NUMA node, victims on the thief's own
+  // node are tried first, so that work and the data it touches stay on
+  // one node while that node has work to spare.
 
   Task Steal(StealAttemptKind steal_kind) {
     PerThread* pt = GetPerThread();
-    unsigned size = num_threads_;
+    if (node_workers_.size() > 1) {
+      const auto& local = node_workers_[worker_node_[pt->thread_id]];
+      Task t = StealFrom(pt, steal_kind, static_cast<unsigned>(local.size()),
+                         [&local](unsigned victim) { return local[victim]; });
+      if (t) {
+        return t;
+      }
+    }
+    return StealFrom(pt, steal_kind, num_threads_, [](unsigned victim) { return victim; });
+  }
+
+  // Walks size victims in a random order, mapping each to a worker index with victim_index.
+  template <typename VictimIndex>
+  Task StealFrom(PerThread* pt, StealAttemptKind steal_kind, unsigned size, VictimIndex victim_index) {
     unsigned num_attempts = (steal_kind == StealAttemptKind::TRY_ALL) ? size : 1;
     unsigned r = Rand(&pt->rand);
     unsigned inc = all_coprimes_[size - 1][r % all_coprimes_[size - 1].size()];
@@ -1654,8 +1875,9 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
 
     for (unsigned i = 0; i < num_attempts; i++) {
       assert(victim < size);
-      if (worker_data_[victim].GetStatus() == WorkerData::ThreadStatus::Active) {
-        Task t = worker_data_[victim].queue.PopBack();
+      WorkerData& td = worker_data_[victim_index(victim)];
+      if (td.GetStatus() == WorkerData::ThreadStatus::Active) {
+        Task t = td.queue.PopBack();
         if (t) {
           return t;
         }
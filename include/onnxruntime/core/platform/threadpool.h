@@ -16,6 +16,7 @@ limitations under the License.
 /* Modifications Copyright (c) Microsoft. */
 
 #pragma once
+#include <atomic>
 #include <string>
 #include <vector>
 #include <functional>
@@ -213,6 +214,35 @@ class ThreadPool {
     ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(ParallelSection);
   };
 
+  // Scheduling attributes of the parallel loops that a thread submits to a
+  // thread pool.  When several callers run loops on the same pool at the same
+  // time (for instance concurrent Run calls of sessions sharing the global
+  // thread pools), a pool created with ThreadOptions::adaptive_parallelism
+  // gives each loop a share of its threads in proportion to the caller's
+  // priority.  max_degree_of_parallelism caps the threads a loop may use,
+  // including the caller, with 0 meaning no cap.
+
+  struct SchedulingContext {
+    unsigned priority = 1;
+    unsigned max_degree_of_parallelism = 0;
+  };
+
+  // Applies a SchedulingContext to the loops that the current thread runs for
+  // the lifetime of the object.  Functions that the thread passes to
+  // ThreadPool::Schedule inherit the context, so that work fanned out to other
+  // threads (e.g. by the parallel executor) is accounted to the same caller.
+
+  class SchedulingScope {
+   public:
+    explicit SchedulingScope(const SchedulingContext& context);
+    ~SchedulingScope();
+
+   private:
+    SchedulingContext context_;
+    const SchedulingContext* previous_;
+    ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(SchedulingScope);
+  };
+
   // The below API allows to disable spinning
   // This is used to support real-time scenarios where
   // spinning between relatively infrequent requests
@@ -221,6 +251,12 @@ class ThreadPool {
 
   void DisableSpinning();
 
+  // While at least one caller is in latency mode, idle threads spin for the full spin duration before blocking,
+  // overriding adaptive spinning and allow_spinning.  Calls must be paired.
+  void EnterLatencyMode();
+
+  void ExitLatencyMode();
+
   // Schedules fn() for execution in the pool of threads.  The function may run
   // synchronously if it cannot be enqueued.  This will occur if the thread pool's
   // degree-of-parallelism is 1, but it may also occur for implementation-dependent
@@ -366,6 +402,14 @@ class ThreadPool {
   static void StartProfiling(concurrency::ThreadPool* tp);
   static std::string StopProfiling(concurrency::ThreadPool* tp);
 
+  // Start accumulating the time the pool's threads spend running tasks, used to report the pool's
+  // utilization. Tracking stays on once started.
+  static void StartTrackingBusyTime(concurrency::ThreadPool* tp);
+
+  // Returns the total time in nanoseconds the pool's threads have spent running tasks since
+  // tracking started, or 0 if tp is null.
+  static uint64_t BusyTimeNs(const concurrency::ThreadPool* tp);
+
  private:
   friend class LoopCounter;
 
@@ -377,11 +421,24 @@ class ThreadPool {
   // thread in the pool. Returns -1 otherwise.
   int CurrentThreadId() const;
 
+  // Returns the number of NUMA nodes the pool's threads are grouped into (1 unless
+  // ThreadOptions::numa_nodes was set), and the node of the calling thread, or -1 if it
+  // is not a thread in the pool.
+  unsigned NumNumaNodes() const;
+  int CurrentNumaNode() const;
+
+  // Returns the degree of parallelism, at most n, for a loop of a caller with the given
+  // priority when the priorities of all the callers running loops on the pool, including
+  // this one, sum to active_priority.
+  unsigned AdaptDegreeOfParallelism(unsigned n, unsigned priority, unsigned active_priority) const;
+
   // Run fn with up to n degree-of-parallelism enlisting the thread pool for
   // help.  The degree-of-parallelism includes the caller, and so if n==1
   // then the function will run directly in the caller.  The fork-join
   // synchronization is handled in the thread pool, and so any state captured
-  // by fn() is safe from concurrent access once RunWithHelp returns.
+  // by fn() is safe from concurrent access once RunWithHelp returns.  The
+  // caller's SchedulingContext may reduce n, so fn must not rely on being
+  // called for every idx below n.
   void RunInParallel(std::function<void(unsigned idx)> fn, unsigned n, std::ptrdiff_t block_size);
 
   // Divides the work represented by the range [0, total) into k shards.
@@ -428,6 +485,10 @@ class ThreadPool {
 
   // Force the thread pool to run in hybrid mode on a normal cpu.
   bool force_hybrid_ = false;
+
+  // Sum of the priorities of the callers currently running parallel loops on the
+  // pool.  Only maintained if ThreadOptions::adaptive_parallelism is set.
+  std::atomic<unsigned> active_priority_{0};
 };
 
 }  // namespace concurrency
@@ -2810,6 +2810,18 @@ struct OrtApi {
    *  Use -1 to allow ORT to choose the default 1GB for max_power_of_two_extend_bytes.
    *  Ultimately, the allocation size is determined by the allocation memory request.
    *  Further allocation sizes are governed by the arena extend strategy.
+   * "idle_region_release_ms": Minimum time that none of the memory of an arena extension must have been in use
+   *  before trimming releases it. Default is 0.
+   * "trim_high_watermark_bytes": Trimming releases nothing while the arena holds at most this many bytes. Default is 0.
+   * "trim_low_watermark_bytes": Trimming stops releasing idle memory once the arena holds at most this many bytes.
+   *  Default is 0.
+   * "background_trim_interval_ms": If not 0, the arena trims itself on a background thread at this interval.
+   *  Requires a nonzero "idle_region_release_ms".
+   *  Trimming can also be requested at the end of a Run with the "memory.enable_memory_arena_trimming" run option.
+   *  Default is 0.
+   * "size_class_cache_max_bytes": Allocations of up to this many bytes (at most 32KB) are served from lock free caches
+   *  of fixed size blocks, which reduces contention on the arena between concurrent Runs. The caches hold 256 blocks
+   *  of every power of 2 size class up to this size for the lifetime of the arena. Default is 0, which disables them.
    *
    * \param[in] arena_config_keys Keys to configure the arena
    * \param[in] arena_config_values Values to configure the arena
@@ -4756,6 +4768,43 @@ struct OrtApi {
    */
   ORT_API2_STATUS(SetEpDynamicOptions, _Inout_ OrtSession* sess, _In_reads_(kv_len) const char* const* keys,
                   _In_reads_(kv_len) const char* const* values, _In_ size_t kv_len);
+
+  /** \brief Adapt the degree of parallelism of the global intra-op thread pool to its load.
+   *
+   * Many sessions sharing the global thread pools may run at the same time. When enabled, each parallel loop
+   * gets a share of the intra-op threads in proportion to the priority of its session among the sessions
+   * currently running loops on the pool, instead of always fanning out to every thread. The priority and an
+   * upper bound on the degree of parallelism of a session are set with the "session.intra_op_priority" and
+   * "session.intra_op_max_degree_of_parallelism" session configuration entries.
+   *
+   * \param[in] tp_options
+   * \param[in] enable 1 to enable, 0 to disable (the default).
+   *
+   * \snippet{doc} snippets.dox OrtStatus Return Value
+   *
+   * \since Version 1.21
+   */
+  ORT_API2_STATUS(SetGlobalIntraOpAdaptiveParallelism, _Inout_ OrtThreadingOptions* tp_options, int enable);
+
+  /** \brief Get the statistics gathered so far by the sampling profiler of a session
+   *
+   * The sampling profiler is enabled with the "session.enable_sampling_profiler" session configuration entry. It
+   * aggregates the latencies of node runs by op type, and is cheap enough to leave on in production. Unlike
+   * OrtApi::SessionEndProfiling this does not stop profiling, and may be called while other threads run the session.
+   *
+   * The statistics are returned as a JSON object with the p50 and p99 latencies, the number of samples and the
+   * bytes of outputs of each op type, and the utilization of the intra op thread pool since the session was created.
+   *
+   * \param[in] session
+   * \param[in] allocator
+   * \param[out] out Null terminated JSON string, allocated using `allocator`. Must be freed using `allocator`
+   *
+   * \snippet{doc} snippets.dox OrtStatus Return Value
+   *
+   * \since Version 1.21
+   */
+  ORT_API2_STATUS(SessionGetSamplingProfile, _In_ const OrtSession* session, _Inout_ OrtAllocator* allocator,
+                  _Outptr_ char** out);
 };
 
 /*
@@ -691,6 +691,9 @@ struct ThreadingOptions : detail::Base<OrtThreadingOptions> {
 
   /// \brief Wraps OrtApi::SetGlobalCustomJoinThreadFn
   ThreadingOptions& SetGlobalCustomJoinThreadFn(OrtCustomJoinThreadFn ort_custom_join_thread_fn);
+
+  /// \brief Wraps OrtApi::SetGlobalIntraOpAdaptiveParallelism
+  ThreadingOptions& SetGlobalIntraOpAdaptiveParallelism(int enable);
 };
 
 /** \brief The Env (Environment)
@@ -1079,6 +1082,15 @@ struct ConstSessionImpl : Base<T> {
   AllocatedStringPtr GetOverridableInitializerNameAllocated(size_t index, OrtAllocator* allocator) const;  ///< Wraps OrtApi::SessionGetOverridableInitializerName
 
   uint64_t GetProfilingStartTimeNs() const;  ///< Wraps OrtApi::SessionGetProfilingStartTimeNs
+
+  /** \brief Returns a copy of the statistics gathered so far by the sampling profiler, as a JSON string.
+   *
+   * \param allocator to allocate memory for the copy of the string returned
+   * \return a instance of smart pointer that would deallocate the buffer when out of scope.
+   *  The OrtAllocator instances must be valid at the point of memory release.
+   */
+  AllocatedStringPtr GetSamplingProfileAllocated(OrtAllocator* allocator) const;  ///< Wraps OrtApi::SessionGetSamplingProfile
+
   ModelMetadata GetModelMetadata() const;    ///< Wraps OrtApi::SessionGetModelMetadata
 
   TypeInfo GetInputTypeInfo(size_t index) const;                   ///< Wraps OrtApi::SessionGetInputTypeInfo
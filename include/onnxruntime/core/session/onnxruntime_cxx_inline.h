@@ -477,6 +477,11 @@ inline ThreadingOptions& ThreadingOptions::SetGlobalCustomJoinThreadFn(OrtCustom
   return *this;
 }
 
+inline ThreadingOptions& ThreadingOptions::SetGlobalIntraOpAdaptiveParallelism(int enable) {
+  ThrowOnError(GetApi().SetGlobalIntraOpAdaptiveParallelism(p_, enable));
+  return *this;
+}
+
 inline Env::Env(OrtLoggingLevel logging_level, _In_ const char* logid) {
   ThrowOnError(GetApi().CreateEnv(logging_level, logid, &p_));
   if (strcmp(logid, "onnxruntime-node") == 0) {
@@ -1016,6 +1021,13 @@ inline AllocatedStringPtr ConstSessionImpl<T>::GetOverridableInitializerNameAllo
   return AllocatedStringPtr(out, detail::AllocatedFree(allocator));
 }
 
+template <typename T>
+inline AllocatedStringPtr ConstSessionImpl<T>::GetSamplingProfileAllocated(OrtAllocator* allocator) const {
+  char* out = nullptr;
+  ThrowOnError(GetApi().SessionGetSamplingProfile(this->p_, allocator, &out));
+  return AllocatedStringPtr(out, detail::AllocatedFree(allocator));
+}
+
 template <typename T>
 inline uint64_t ConstSessionImpl<T>::GetProfilingStartTimeNs() const {
   uint64_t out;
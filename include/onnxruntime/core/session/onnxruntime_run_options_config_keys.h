@@ -26,6 +26,14 @@
 // By default, the value for this key is empty (i.e.) no memory arenas are shrunk
 static const char* const kOrtRunOptionsConfigEnableMemoryArenaShrinkage = "memory.enable_memory_arena_shrinkage";
 
+// Key for trimming user listed device memory arenas at the end of the run.
+// Expects a list of devices in the same format as "memory.enable_memory_arena_shrinkage".
+// Unlike shrinkage, trimming only releases the memory that the arena's OrtArenaCfg allows it to release
+// ("idle_region_release_ms", "trim_high_watermark_bytes" and "trim_low_watermark_bytes"), and does not
+// reset how the arena grows, so it is cheap enough to request on every run.
+// By default, the value for this key is empty (i.e.) no memory arenas are trimmed
+static const char* const kOrtRunOptionsConfigEnableMemoryArenaTrimming = "memory.enable_memory_arena_trimming";
+
 // Set to '1' to not synchronize execution providers with CPU at the end of session run.
 // Per default it will be set to '0'
 // Taking CUDA EP as an example, it omit triggering cudaStreamSynchronize on the compute stream.
@@ -49,3 +57,10 @@ static const char* const kOrtRunOptionsConfigQnnRpcControlLatency = "qnn.rpc_con
 // If the value is set to -1, cuda graph capture/replay is disabled in that run.
 // User are not expected to set the value to 0 as it is reserved for internal use.
 static const char* const kOrtRunOptionsConfigCudaGraphAnnotation = "gpu_graph_id";
+
+// Set to '1' to run this request in latency mode: while it runs, idle threads of the intra-op thread pool spin
+// for the full spin duration before blocking, instead of following the adaptive spinning policy
+// (session.intra_op.adaptive_spinning) or the session's allow_spinning setting.
+// This lowers the wake-up latency of parallel loops at the cost of CPU time.
+// Per default it will be set to '0'.
+static const char* const kOrtRunOptionsConfigIntraOpLatencyMode = "run.intra_op_latency_mode";
@@ -111,12 +111,34 @@ static const char* const kOrtSessionOptionsDisableSpecifiedOptimizers = "optimiz
 // Using device allocators means the memory allocation is made using malloc/new.
 static const char* const kOrtSessionOptionsUseDeviceAllocatorForInitializers = "session.use_device_allocator_for_initializers";
 
+// Control how initializers with data in external files are loaded for CPU.
+// "1": Each external data file is mapped into memory once and initializers reference the mapped data directly,
+//      so sessions and processes loading the same model share the physical pages. Initializers whose data is not
+//      aligned for their element type are copied. [DEFAULT]
+// "0": The data of each initializer is read into memory allocated by the session.
+static const char* const kOrtSessionOptionsMapExternalInitializers = "session.map_external_initializers";
+
+// Directory used to persist pre-packed weights of CPU kernels across process restarts.
+// When set, the weights a kernel pre-packs are written to this directory, and later sessions with the same node,
+// constant inputs and session configuration map the stored buffers instead of packing them again.
+// Entries written by a different ONNX Runtime version or on a CPU with a different instruction set are ignored
+// and replaced. The directory is created if it does not exist.
+// Pre-packed weights shared across sessions through a PrepackedWeightsContainer are not persisted.
+// Default is an empty string which disables the cache.
+static const char* const kOrtSessionOptionsPrepackedWeightsCacheDir = "session.prepacked_weights_cache_dir";
+
 // Configure whether to allow the inter_op/intra_op threads spinning a number of times before blocking
 // "0": thread will block if found no job to run
 // "1": default, thread will spin a number of times before blocking
 static const char* const kOrtSessionOptionsConfigAllowInterOpSpinning = "session.inter_op.allow_spinning";
 static const char* const kOrtSessionOptionsConfigAllowIntraOpSpinning = "session.intra_op.allow_spinning";
 
+// Configure whether intra_op threads adapt how long they spin before blocking. Only applies if spinning is allowed.
+// "0": default, thread will spin a fixed number of times before blocking
+// "1": thread will spin for a duration learned from recent gaps between tasks, bounded by a budget of spin time
+//      earned while running tasks. See also the run option "run.intra_op_latency_mode".
+static const char* const kOrtSessionOptionsConfigIntraOpAdaptiveSpinning = "session.intra_op.adaptive_spinning";
+
 // Key for using model bytes directly for ORT format
 // If a session is created using an input byte array contains the ORT format model data,
 // By default we will copy the model bytes at the time of session creation to ensure the model bytes
@@ -214,6 +236,35 @@ static const char* const kNodePartitionConfigFile = "session.node_partition_conf
 //    Hence 64-65 is an invalid configuration, because a windows thread cannot be attached to processors across group boundary.
 static const char* const kOrtSessionOptionsConfigIntraOpThreadAffinities = "session.intra_op_thread_affinities";
 
+// This option makes the intra op thread pool NUMA aware on machines with more than one NUMA node.
+// Threads are grouped by node: tasks are queued and stolen within a node first, and parallel loops hand out
+// contiguous ranges of iterations to the threads of one node. Threads without an explicit affinity are split into
+// one contiguous block per node and bound to the logical processors of their node.
+// On Linux each thread also prefers to allocate memory from its node. NUMA topology detection is Linux only.
+// "0": disabled (default). "1": enabled.
+static const char* const kOrtSessionOptionsConfigIntraOpThreadNumaAware = "session.intra_op_thread_numa_aware";
+
+// Scheduling priority and quota of the parallel loops of this session on the intra op thread pool.
+// They take effect on a thread pool shared by several sessions, i.e. the global thread pools with
+// OrtApi::SetGlobalIntraOpAdaptiveParallelism enabled, where each loop gets a share of the threads proportional to
+// the priority of its session among the sessions running loops at the same time.
+// "session.intra_op_priority": positive integer weight, default "1".
+// "session.intra_op_max_degree_of_parallelism": maximum number of threads, including the calling thread, used by
+// a parallel loop of this session; default "0" for no limit. The limit applies to per session thread pools too.
+static const char* const kOrtSessionOptionsConfigIntraOpPriority = "session.intra_op_priority";
+static const char* const kOrtSessionOptionsConfigIntraOpMaxDegreeOfParallelism =
+    "session.intra_op_max_degree_of_parallelism";
+
+// Enables the sampling profiler, which aggregates the latencies of node runs by op type into histograms instead of
+// recording a trace, and also reports the bytes of node outputs and the utilization of the intra op thread pool.
+// It is cheap enough to leave enabled in production. Its statistics are read with OrtApi::SessionGetSamplingProfile
+// while the session keeps running. It is independent of the trace profiler enabled by OrtApi::EnableProfiling.
+// "0": disabled (default). "1": enabled.
+static const char* const kOrtSessionOptionsConfigEnableSamplingProfiler = "session.enable_sampling_profiler";
+
+// The sampling profiler samples one out of every N node runs on each thread. Default is "1", every node run.
+static const char* const kOrtSessionOptionsConfigSamplingProfilerInterval = "session.sampling_profiler_interval";
+
 // This option will dump out the model to assist debugging any issues with layout transformation,
 // and is primarily intended for developer usage. It is only relevant if an execution provider that requests
 // NHWC layout is enabled such as NNAPI, XNNPACK or QNN.
@@ -278,11 +329,98 @@ static const char* const kOrtSessionOptionShareEpContexts = "ep.share_ep_context
 // - "1": Gemm FastMath mode is enabled.
 static const char* const kOrtSessionOptionsMlasGemmFastMathArm64Bfloat16 = "mlas.enable_gemm_fastmath_arm64_bfloat16";
 
+// Gemm fastmath mode for x64: fp32 MatMul is computed with bfloat16 inputs and fp32 accumulation on processors
+// supporting AVX512-BF16 (and AMX-BF16 when available). Only used on Linux.
+// Option values:
+// - "0": Gemm FastMath mode is not enabled. [DEFAULT]
+// - "1": Gemm FastMath mode is enabled.
+static const char* const kOrtSessionOptionsMlasGemmFastMathX64Bfloat16 = "mlas.enable_gemm_fastmath_x64_bfloat16";
+
+// Compute fp32 3x3 stride 1 convolutions with enough channels using the Winograd algorithm. This is faster than the
+// default im2col based algorithm but rounds differently, so outputs may differ slightly.
+// Option values:
+// - "0": Winograd convolution is not enabled. [DEFAULT]
+// - "1": Winograd convolution is enabled.
+static const char* const kOrtSessionOptionsMlasConvWinograd = "mlas.enable_conv_winograd";
+
 // When converting DQ + MatMul -> MatMulNBits, the accuracy level of the MatMulNBits is controlled by this option.
 // Refer to MatMulNBits op schema for more details.
 // If not provided, default is 4.
 static const char* const kOrtSessionOptionsQDQMatMulNBitsAccuracyLevel = "session.qdq_matmulnbits_accuracy_level";
 
+// Maximum number of memory plans cached per graph when memory patterns are enabled.
+// A plan is specialized for one tuple of concrete input shapes and records where every intermediate tensor lives
+// in a single block per device. When the cache is full the least recently used plan is evicted.
+// "0" means unbounded. Default is "64".
+static const char* const kOrtSessionOptionsShapePlanCacheCapacity = "session.shape_plan_cache_capacity";
+
+// Keep the memory pattern blocks of a cached plan between runs instead of freeing them at the end of each run.
+// Runs whose input shapes hit the cache then do not need to allocate memory for planned intermediate tensors.
+// This trades steady state memory usage for fewer allocator calls. Only applies to CPU memory.
+// Option values:
+// - "0": Blocks are released at the end of each run. [DEFAULT]
+// - "1": Blocks are kept with the cached plan.
+static const char* const kOrtSessionOptionsShapePlanCacheRetainBuffers = "session.shape_plan_cache_retain_buffers";
+
+// Enable dynamic batching of RunAsync requests.
+// When enabled, concurrent RunAsync calls that use the same RunOptions, feed names and fetch names are coalesced
+// into a single Run by concatenating inputs along the batch axis. Outputs are split along the same axis and each
+// caller's callback receives its own slice.
+// Option values:
+// - "0": Batching is disabled. [DEFAULT]
+// - "1": Batching is enabled.
+static const char* const kOrtSessionOptionsBatchingEnable = "session.batching.enable";
+
+// Maximum number of requests merged into one Run. Default is 8.
+static const char* const kOrtSessionOptionsBatchingMaxBatchSize = "session.batching.max_batch_size";
+
+// Maximum time in microseconds the oldest pending request waits for further requests before its batch is run.
+// Default is 1000.
+static const char* const kOrtSessionOptionsBatchingMaxWaitMicroseconds = "session.batching.max_wait_us";
+
+// Axis along which inputs are concatenated and outputs are split. Default is 0.
+static const char* const kOrtSessionOptionsBatchingAxis = "session.batching.batch_axis";
+
+// Allow merging requests whose inputs differ in non-batch dimensions (e.g. ragged sequence lengths).
+// Inputs are zero padded to the largest extent in the batch and outputs are returned with the padded extents.
+// Option values:
+// - "0": Requests with differing non-batch dimensions are run separately. [DEFAULT]
+// - "1": Pad ragged dimensions.
+static const char* const kOrtSessionOptionsBatchingPadRaggedAxes = "session.batching.pad_ragged_axes";
+
+// Run CPU-only graphs as a dataflow graph when the execution mode is ORT_PARALLEL.
+// Nodes are started as soon as their producers have completed and independent branches are run on the inter-op
+// thread pool. Only applies when all nodes are assigned to a single CPU stream.
+// Option values:
+// - "0": Nodes are run one after another in the topological order of the execution plan. [DEFAULT]
+// - "1": Dataflow execution is enabled.
+static const char* const kOrtSessionOptionsDataflowExecution = "session.dataflow.enable";
+
+// Maximum number of nodes the dataflow executor runs at the same time.
+// Kernels parallelize internally on the intra-op thread pool, so running many heavy nodes concurrently
+// oversubscribes the machine. Default is the degree of parallelism of the inter-op thread pool.
+static const char* const kOrtSessionOptionsDataflowMaxConcurrentNodes = "session.dataflow.max_concurrent_nodes";
+
+// Nodes whose average measured run time is below this number of microseconds are run on the thread that made
+// them ready instead of being dispatched to the inter-op thread pool. Default is 20.
+static const char* const kOrtSessionOptionsDataflowInlineCostMicroseconds = "session.dataflow.inline_cost_us";
+
+// Evaluate CPU tree ensembles (TreeEnsembleRegressor, TreeEnsembleClassifier, TreeEnsemble) with a QuickScorer
+// bitvector engine instead of walking every tree node by node. The engine is only used when all nodes share the
+// BRANCH_LEQ or BRANCH_LT rule and every tree has at most 64 leaves, other models use the node traversal.
+// Option values:
+// - "0": Trees are always walked node by node.
+// - "1": The bitvector engine is used when the model fits. [DEFAULT]
+static const char* const kOrtSessionOptionsTreeEnsembleQuickScorer = "ml.tree_ensemble.enable_quickscorer";
+
+// Evaluate CPU tree ensembles which do not fit the QuickScorer engine on a flattened breadth first copy of the trees,
+// several rows at a time. The layout is only used when all nodes share one rule other than BRANCH_MEMBER, other
+// models use the node traversal.
+// Option values:
+// - "0": The flat layout is not used.
+// - "1": The flat layout is used when the model fits. [DEFAULT]
+static const char* const kOrtSessionOptionsTreeEnsembleFlatLayout = "ml.tree_ensemble.enable_flat_layout";
+
 // THIS OPTION IS NOT A REGULAR SESSION OPTION SINCE IT CAN BE MODIFIED AT ANY TIME
 // Meant to be used with SetEpDynamicOptions
 // Specify the type of workload for this session.
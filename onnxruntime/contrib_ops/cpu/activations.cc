@@ -5,6 +5,22 @@
 #include "contrib_ops/cpu/activations.h"
 
 namespace onnxruntime {
+namespace functors {
+template <>
+void ParametricSoftplus<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const {
+  ptrdiff_t len = last - first;
+  const float* input_ptr = input + first;
+  float* output_ptr = output + first;
+  for (ptrdiff_t i = 0; i < len; i++) {
+    output_ptr[i] = input_ptr[i] * beta;
+  }
+  MlasComputeSoftplus(output_ptr, output_ptr, static_cast<size_t>(len));
+  for (ptrdiff_t i = 0; i < len; i++) {
+    output_ptr[i] *= alpha;
+  }
+}
+}  // namespace functors
+
 namespace contrib {
 
 ONNX_CPU_OPERATOR_KERNEL(
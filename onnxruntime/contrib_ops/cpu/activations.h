@@ -48,6 +48,9 @@ struct ParametricSoftplus : public ElementWiseRangedTransform<T> {
              .select(xm * (T)beta + ((-xm * (T)beta).exp() + 1.0f).log(), ((xm * (T)beta).exp() + 1.0f).log());
   }
 };
+
+template <>
+void ParametricSoftplus<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const;
 }  // namespace functors
 
 namespace contrib {
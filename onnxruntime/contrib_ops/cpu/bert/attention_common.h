@@ -164,6 +164,10 @@ struct GroupQueryAttentionParameters {
   AttentionQkvFormat past_kv_format;
   int zeros_count;
   int* zero_ptr;
+  bool paged_kv_cache;          // past and present kv are block pools indexed by a block table
+  int num_kv_cache_blocks;      // number of blocks in the paged kv cache pools
+  int kv_cache_block_size;      // number of tokens per block of the paged kv cache
+  int max_blocks_per_sequence;  // number of entries per sequence in the block table
 };
 
 // Parameters for sparse attention.
@@ -9,6 +9,9 @@
 #include "core/common/safeint.h"
 #include "core/framework/op_kernel.h"
 #include "contrib_ops/cpu/utils/dump_tensor.h"
+#include "core/mlas/inc/mlas.h"
+
+#include <type_traits>
 
 namespace onnxruntime {
 namespace contrib {
@@ -130,6 +133,8 @@ class AttentionCPUBase : public AttentionBase {
   //  attention_probs(B, N, S, T) = 1/sqrt(H) x Q(B, N, S, H) x K'(B, N, T, H -> B, N, H, T) +
   //                                1 x mask_data(B, N, S, T)
   //  attention_probs(B, N, S, T) = Softmax(attention_probs)
+  // For float, the mask, the attention bias and the softmax are fused into one pass over each
+  // S x T block right after it is produced, unless the pre-softmax scores are requested.
   template <typename T>
   void ComputeAttentionProbs(T* attention_probs,                       // output buffer with size BxNxSxT
                              const T* Q,                               // Q data. Its size is BxNxSxH
@@ -163,6 +168,9 @@ class AttentionCPUBase : public AttentionBase {
     DUMP_CPU_TENSOR("K", K, batch_size, num_heads_, total_sequence_length, head_size);
     DUMP_CPU_TENSOR("Attn_Bias", attn_bias_data, attn_bias_dims);
 
+    // The scaled Q*K' can only be fused with the softmax when it is not an output.
+    const bool fuse_softmax = std::is_same_v<T, float> && output_qk_data == nullptr;
+
     {
       const int loop_len = batch_size * num_heads_;
       const float alpha = scale;
@@ -193,6 +201,11 @@ class AttentionCPUBase : public AttentionBase {
         unit_cost.bytes_stored += probs_matrix_bytes;
       }
 
+      if (fuse_softmax) {
+        // The softmax of the block is computed while it is still in cache.
+        unit_cost.compute_cycles += static_cast<double>(SafeInt<ptrdiff_t>(4) * probs_matrix_size);
+      }
+
       ThreadPool::TryParallelFor(tp, loop_len, unit_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
         for (std::ptrdiff_t i = begin; i != end; ++i) {
           const int batch_index = static_cast<int>(i) / num_heads_;
@@ -203,17 +216,20 @@ class AttentionCPUBase : public AttentionBase {
 
           T* output = attention_probs + output_offset;
 
+          // Attention bias has shape (B or 1, N or 1, S, T)
+          // Here we handle the broadcast of batch_size and num_heads dimensions.
+          ptrdiff_t attn_bias_offset = 0;
           if (attn_bias_data != nullptr) {
-            // Attention bias has shape (B or 1, N or 1, S, T)
-            // Here we handle the broadcast of batch_size and num_heads dimensions.
-            ptrdiff_t attn_bias_offset = 0;
             if (attn_bias_dims[0] != 1) {
               attn_bias_offset += SafeInt<ptrdiff_t>(batch_index) * num_heads_ * probs_matrix_size;
             }
             if (attn_bias_dims[1] != 1) {
               attn_bias_offset += head_index * probs_matrix_size;
             }
+          }
 
+          // When the softmax is fused, the mask and the attention bias are added by the softmax below.
+          if (!fuse_softmax && attn_bias_data != nullptr) {
             memcpy(output, attn_bias_data + attn_bias_offset, probs_matrix_bytes);
 
             if (mask_data != nullptr) {
@@ -222,7 +238,7 @@ class AttentionCPUBase : public AttentionBase {
                 output[j] += mask_data[mask_offset + j];
               }
             }
-          } else if (mask_data != nullptr) {
+          } else if (!fuse_softmax && mask_data != nullptr) {
             // Broadcast mask data: (Bx)SxT -> (BxNx)SxT
             memcpy(output, mask_data + mask_offset, probs_matrix_bytes);
           }
@@ -247,8 +263,21 @@ class AttentionCPUBase : public AttentionBase {
           // C: attention_probs  (B x N x) S x T          (B x N x) S x T        S x T
           math::Gemm<T, ThreadPool>(CblasNoTrans, CblasTrans, sequence_length, total_sequence_length, head_size, alpha,
                                     Q + q_input_chunk_length * i, k,
-                                    (mask_data != nullptr || attn_bias_data != nullptr) ? 1.0f : 0.0f,
+                                    (!fuse_softmax && (mask_data != nullptr || attn_bias_data != nullptr)) ? 1.0f : 0.0f,
                                     output, nullptr);
+
+          if constexpr (std::is_same_v<T, float>) {
+            if (fuse_softmax) {
+              // attention_probs(S, T) = Softmax(attention_probs + attention_bias + mask_data)
+              MLAS_SOFTMAX_FUSED_PARAMS params;
+              params.Bias = attn_bias_data != nullptr ? attn_bias_data + attn_bias_offset : nullptr;
+              params.ldBias = static_cast<size_t>(total_sequence_length);
+              params.Mask = mask_data != nullptr ? mask_data + mask_offset : nullptr;
+              params.ldMask = static_cast<size_t>(total_sequence_length);
+              MlasComputeSoftmax(output, output, static_cast<size_t>(sequence_length),
+                                 static_cast<size_t>(total_sequence_length), params, nullptr);
+            }
+          }
         }
       });
     }
@@ -262,7 +291,7 @@ class AttentionCPUBase : public AttentionBase {
     DUMP_CPU_TENSOR("QK (scaled)", attention_probs, batch_size, num_heads_, sequence_length, total_sequence_length);
 
     // attention_probs(B, N, S, T) = Softmax(attention_probs)
-    {
+    if (!fuse_softmax) {
       const int N = batch_size * num_heads_ * sequence_length;
       const int D = total_sequence_length;
       ComputeAttentionSoftmaxInplace(attention_probs, N, D, tp);
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include "core/util/math.h"
 #include "core/util/math_cpuonly.h"
@@ -113,6 +115,45 @@ void ComputeAttentionSoftcapInplace(T* scores, int sequence_length, float softca
 
 template void ComputeAttentionSoftcapInplace<float>(float* scores, int sequence_length, float softcap);
 
+// Quantizes a row of the k-v cache with a symmetric scale: int8 for 8 bits, or int4 packed in pairs (low nibble first)
+// for 4 bits.
+inline void QuantizeKVCacheRow(const float* input, size_t count, int bit_width, uint8_t* output, float* scale) {
+  float min_value;
+  float max_value;
+  MlasFindMinMaxElement(input, &min_value, &max_value, count);
+  const float max_abs = std::max(std::fabs(min_value), std::fabs(max_value));
+  const float max_quantized = bit_width == 8 ? 127.0f : 7.0f;
+  const float row_scale = max_abs > 0.0f ? max_abs / max_quantized : 1.0f;
+
+  if (bit_width == 8) {
+    MlasQuantizeLinear<int8_t>(input, reinterpret_cast<int8_t*>(output), count, row_scale, 0);
+  } else {
+    MlasQuantizeLinearS4(input, output, count, row_scale, 0);
+  }
+  *scale = row_scale;
+}
+
+// Dequantizes consecutive rows of the k-v cache quantized by QuantizeKVCacheRow.
+inline void DequantizeKVCacheRows(const uint8_t* input, const float* scales, size_t rows, size_t count, int bit_width,
+                                  float* output) {
+  for (size_t r = 0; r < rows; r++) {
+    const float scale = scales[r];
+    if (bit_width == 8) {
+      const int8_t* row = reinterpret_cast<const int8_t*>(input) + r * count;
+      for (size_t i = 0; i < count; i++) {
+        output[i] = scale * static_cast<float>(row[i]);
+      }
+    } else {
+      const uint8_t* row = input + r * (count / 2);
+      for (size_t i = 0; i < count / 2; i++) {
+        output[2 * i] = scale * static_cast<float>(static_cast<int8_t>(row[i] << 4) >> 4);
+        output[2 * i + 1] = scale * static_cast<float>(static_cast<int8_t>(row[i]) >> 4);
+      }
+    }
+    output += count;
+  }
+}
+
 template <typename T>
 void PrepareMask(const int32_t* mask_index,
                  gsl::span<const int64_t> mask_index_dims,
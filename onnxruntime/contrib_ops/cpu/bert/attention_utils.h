@@ -4,6 +4,7 @@
 #include "core/framework/transpose_helper.h"
 #include "core/providers/cpu/tensor/reshape_helper.h"
 #include "core/providers/cpu/math/element_wise_ops.h"
+#include "core/mlas/inc/mlas.h"
 
 namespace onnxruntime {
 namespace contrib {
@@ -57,5 +58,12 @@ Status MaybeTransposeToBNSH(AllocatorPtr allocator,
                             int batch_size, int num_heads, int sequence_length, int head_size,
                             const Tensor* in, OrtValue& out);
 
+// Set the q_block_size and kv_block_size of the flash attention for the size of the L2 cache,
+// and allocate the per-thread buffers of args.thread_count threads.
+// The sequence lengths, head sizes and data type (fp32 or fp16 pointers) of args shall be set.
+IAllocatorUniquePtr<void> PrepareFlashAttention(MlasFlashAttentionThreadedArgs& args,
+                                                int l2_cache_size,
+                                                AllocatorPtr allocator);
+
 }  // namespace contrib
 }  // namespace onnxruntime
@@ -5,11 +5,15 @@
 
 #include "contrib_ops/cpu/bert/attention_base.h"
 #include "contrib_ops/cpu/bert/attention_helper.h"
+#include "contrib_ops/cpu/bert/attention_utils.h"
 
 #include "core/common/common.h"
 #include "contrib_ops/cpu/bert/attention_common.h"
 #include "core/common/safeint.h"
 #include "core/framework/op_kernel.h"
+#include "core/mlas/inc/mlas.h"
+#include "core/platform/env.h"
+#include "core/platform/env_var_utils.h"
 
 namespace onnxruntime {
 namespace contrib {
@@ -34,6 +38,11 @@ class GQAAttentionBase {
     use_smooth_softmax_ = info.GetAttrOrDefault<int64_t>("smooth_softmax", 0) == 1;
 
     local_window_size_ = has_local ? static_cast<int>(info.GetAttrOrDefault<int64_t>("local_window_size", -1)) : -1;
+
+    kv_cache_bit_width_ = static_cast<int>(info.GetAttrOrDefault<int64_t>("kv_cache_bit_width", 0));
+
+    l2_cache_size_ = Env::Default().GetL2CacheSize();
+    disable_flash_ = ParseEnvironmentVariableWithDefault<bool>(attention::kDisableFlashAttention, false);
   }
 
   int num_heads_;     // number of attention heads of Q
@@ -46,6 +55,11 @@ class GQAAttentionBase {
 
   bool use_smooth_softmax_;
 
+  int kv_cache_bit_width_;  // number of bits of the quantized kv cache, 0 if the kv cache is not quantized
+
+  bool disable_flash_;
+  int l2_cache_size_;
+
   template <typename T>
   Status ApplyAttention(const T* Q,                                 // Q data with shape BxNxSxH
                         const T* K,                                 // K data with shape BxN_kvxSxH
@@ -74,11 +88,6 @@ class GQAAttentionBase {
     }
     int seqlen_present_kv_cache = static_cast<int>(present_key->Shape().GetDims()[2]);
 
-    // Compute the attention score.
-    size_t bytes = SafeInt<size_t>(batch_size) * num_heads_ * sequence_length * seqlen_present_kv_cache * sizeof(float);
-    auto attention_probs = allocator->Alloc(bytes);
-    BufferUniquePtr scratch_buffer(attention_probs, BufferDeleter(allocator));
-
     const T* past_key_data = past_key != nullptr ? past_key->Data<T>() : nullptr;
     T* present_key_data = present_key != nullptr ? present_key->MutableData<T>() : nullptr;
     const T* past_value_data = past_value != nullptr ? past_value->Data<T>() : nullptr;
@@ -86,6 +95,18 @@ class GQAAttentionBase {
 
     bool past_present_share_buffer = past_key_data == present_key_data && past_value_data == present_value_data;
 
+    if (!disable_flash_ && l2_cache_size_ > 0 && softcap_ == 0.0f && !use_smooth_softmax_) {
+      return ApplyFlashAttention(Q, K, V, past_key_data, past_value_data, present_key_data, present_value_data,
+                                 output->MutableData<T>(), seqlens_k->Data<int32_t>(), batch_size, sequence_length,
+                                 seqlen_past_kv_cache, seqlen_present_kv_cache, head_size, past_present_share_buffer,
+                                 packed_qkv, is_prompt, tp, allocator);
+    }
+
+    // Compute the attention score.
+    size_t bytes = SafeInt<size_t>(batch_size) * num_heads_ * sequence_length * seqlen_present_kv_cache * sizeof(float);
+    auto attention_probs = allocator->Alloc(bytes);
+    BufferUniquePtr scratch_buffer(attention_probs, BufferDeleter(allocator));
+
     const T* k = packed_qkv ? Q + num_heads_ * sequence_length * head_size : K;
     ComputeAttentionProbs<T>(static_cast<float*>(attention_probs), Q, k, seqlens_k->Data<int32_t>(), batch_size,
                              sequence_length, seqlen_past_kv_cache, seqlen_present_kv_cache, head_size, past_key_data,
@@ -102,7 +123,608 @@ class GQAAttentionBase {
     return Status::OK();
   }
 
+  // Attention over a paged kv cache. past_key and past_value are pools of blocks with shape (NB, N_kv, BS, H) and
+  // block_table maps block i of each sequence, holding positions [i * BS, (i + 1) * BS), to a block of the pools.
+  // The new keys and values are written to the blocks in place, so the blocks holding the new positions of a
+  // sequence shall not be shared with other sequences. Copy-on-write of shared prefix blocks is left to the caller.
+  template <typename T>
+  Status ApplyPagedAttention(const T* Q,                                 // Q data with shape BxNxSxH
+                             const T* K,                                 // K data with shape BxN_kvxSxH
+                             const T* V,                                 // V data with shape BxN_kvxSxH
+                             const Tensor* past_key,                     // past K block pool
+                             const Tensor* past_value,                   // past V block pool
+                             Tensor* output,                             // output tensor
+                             Tensor* present_key,                        // present K block pool
+                             Tensor* present_value,                      // present V block pool
+                             const Tensor* seqlens_k,                    // past sequence lengths tensor
+                             const Tensor* block_table,                  // block table with shape BxMB
+                             GroupQueryAttentionParameters& parameters,  // attention parameters
+                             AllocatorPtr allocator,                     // allocator for temporary tensors
+                             OpKernelContext* context) const {
+    const bool is_prompt = parameters.is_first_prompt;
+    const size_t batch_size = static_cast<size_t>(parameters.batch_size);
+    const size_t sequence_length = static_cast<size_t>(parameters.sequence_length);
+    const size_t head_size = static_cast<size_t>(parameters.head_size);
+    const size_t hidden_size = static_cast<size_t>(parameters.hidden_size);
+    const size_t block_size = static_cast<size_t>(parameters.kv_cache_block_size);
+    const size_t max_blocks_per_sequence = static_cast<size_t>(parameters.max_blocks_per_sequence);
+    // the attention probs of each head have a row for each query position and a column for each position of the
+    // longest sequence in the batch
+    const size_t probs_row_stride = static_cast<size_t>(parameters.total_sequence_length);
+    const bool packed_qkv = parameters.is_packed_qkv;
+
+    auto* tp = context->GetOperatorThreadPool();
+
+    T* present_key_data = present_key->MutableData<T>();
+    T* present_value_data = present_value->MutableData<T>();
+    // The whole pools are copied when the present ones do not share their buffers, since the blocks not referenced
+    // by this batch hold the cache of other sequences.
+    if (present_key_data != past_key->Data<T>()) {
+      memcpy(present_key_data, past_key->Data<T>(), past_key->SizeInBytes());
+    }
+    if (present_value_data != past_value->Data<T>()) {
+      memcpy(present_value_data, past_value->Data<T>(), past_value->SizeInBytes());
+    }
+
+    const int32_t* seqlens_k_data = seqlens_k->Data<int32_t>();
+    const int32_t* block_table_data = block_table->Data<int32_t>();
+    const size_t kv_num_heads_factor = num_heads_ / kv_num_heads_;
+    const size_t input_chunk_length = sequence_length * head_size;  // S x H
+    const size_t block_chunk_length = block_size * head_size;       // BS x H
+    const size_t packed_batch_stride =
+        packed_qkv ? SafeInt<size_t>(num_heads_ + 2 * kv_num_heads_) * input_chunk_length : SafeInt<size_t>(0);
+    if (packed_qkv) {
+      K = Q + num_heads_ * input_chunk_length;
+      V = Q + (num_heads_ + kv_num_heads_) * input_chunk_length;
+    }
+
+    auto total_seqlen_of = [&](size_t batch_index) {
+      return static_cast<size_t>(seqlens_k_data[batch_index]) + 1;
+    };
+    auto past_seqlen_of = [&](size_t batch_index) {
+      return is_prompt ? size_t{0} : total_seqlen_of(batch_index) - sequence_length;  // Assume no padding
+    };
+    auto block_offset = [&](size_t batch_index, size_t block_index, size_t kv_head_index) {
+      const size_t block = static_cast<size_t>(block_table_data[batch_index * max_blocks_per_sequence + block_index]);
+      return (block * kv_num_heads_ + kv_head_index) * block_chunk_length;
+    };
+    auto kv_input_offset = [&](size_t batch_index, size_t kv_head_index) {
+      return packed_qkv ? packed_batch_stride * batch_index + input_chunk_length * kv_head_index
+                        : input_chunk_length * (batch_index * kv_num_heads_ + kv_head_index);
+    };
+
+    // Write the new keys and values of each sequence to its blocks. Positions beyond the total sequence length of a
+    // sequence are padding and are not written.
+    TensorOpCost cost;
+    cost.compute_cycles = 0;
+    cost.bytes_loaded = static_cast<double>(2 * input_chunk_length * sizeof(T));
+    cost.bytes_stored = cost.bytes_loaded;
+    ThreadPool::TryParallelFor(tp, batch_size * kv_num_heads_, cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+      for (std::ptrdiff_t i = begin; i != end; ++i) {
+        const size_t batch_index = i / kv_num_heads_;
+        const size_t kv_head_index = i % kv_num_heads_;
+        const size_t total_seqlen = total_seqlen_of(batch_index);
+        const size_t past_seqlen = past_seqlen_of(batch_index);
+        const T* k = K + kv_input_offset(batch_index, kv_head_index);
+        const T* v = V + kv_input_offset(batch_index, kv_head_index);
+        for (size_t seq = 0; seq < sequence_length && past_seqlen + seq < total_seqlen; seq++) {
+          const size_t position = past_seqlen + seq;
+          const size_t offset =
+              block_offset(batch_index, position / block_size, kv_head_index) + (position % block_size) * head_size;
+          memcpy(present_key_data + offset, k + seq * head_size, head_size * sizeof(T));
+          memcpy(present_value_data + offset, v + seq * head_size, head_size * sizeof(T));
+        }
+      }
+    });
+
+    // Compute the attention score and apply the score to V, one block at a time.
+    size_t probs_bytes = SafeInt<size_t>(batch_size) * num_heads_ * sequence_length * probs_row_stride * sizeof(float);
+    auto attention_probs = allocator->Alloc(probs_bytes);
+    BufferUniquePtr scratch_buffer(attention_probs, BufferDeleter(allocator));
+
+    size_t output_fp32_bytes = 0;
+    if constexpr (std::is_same<T, MLFloat16>::value) {
+      output_fp32_bytes = SafeInt<size_t>(sequence_length) * batch_size * num_heads_ * head_size * sizeof(float);
+    }
+    auto output_fp32 = allocator->Alloc(output_fp32_bytes);
+    BufferUniquePtr output_fp32_buffer(output_fp32, BufferDeleter(allocator));
+
+    const float alpha = scale_ == 0.0f ? 1.0f / sqrt(static_cast<float>(head_size)) : scale_;
+    T* output_data = output->MutableData<T>();
+
+    TensorOpCost unit_cost;
+    unit_cost.compute_cycles =
+        static_cast<double>(SafeInt<ptrdiff_t>(4) * sequence_length * head_size * probs_row_stride);
+    unit_cost.bytes_loaded =
+        static_cast<double>((sequence_length + 2 * probs_row_stride) * head_size * sizeof(T));
+    unit_cost.bytes_stored = static_cast<double>(sequence_length * head_size * sizeof(T));
+
+    ThreadPool::TryParallelFor(tp, batch_size * num_heads_, unit_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+      for (std::ptrdiff_t i = begin; i != end; ++i) {
+        const size_t batch_index = i / num_heads_;
+        const size_t head_index = i % num_heads_;
+        const size_t kv_head_index = head_index / kv_num_heads_factor;
+        const size_t total_seqlen = total_seqlen_of(batch_index);
+        const size_t past_seqlen = past_seqlen_of(batch_index);
+        const size_t num_blocks = (total_seqlen + block_size - 1) / block_size;
+
+        const ptrdiff_t probs_offset = SafeInt<ptrdiff_t>(i) * sequence_length * probs_row_stride;
+        float* probs = static_cast<float*>(attention_probs) + probs_offset;
+        const T* q = packed_qkv ? Q + packed_batch_stride * batch_index + input_chunk_length * head_index
+                                : Q + input_chunk_length * i;
+        const size_t output_offset = (batch_index * sequence_length * num_heads_ + head_index) * head_size;
+
+        // fp16 Q and blocks are converted to fp32 for the Gemm
+        const float* q_fp32 = nullptr;
+        [[maybe_unused]] float* block_fp32 = nullptr;
+        BufferUniquePtr fp32_buffer;
+        if constexpr (std::is_same<T, MLFloat16>::value) {
+          size_t bytes = head_size * (sequence_length + block_size) * sizeof(float);
+          auto buffer = allocator->Alloc(bytes);
+          fp32_buffer = BufferUniquePtr(buffer, BufferDeleter(allocator));
+          float* q_buffer = static_cast<float*>(buffer);
+          MlasConvertHalfToFloatBuffer(q, q_buffer, input_chunk_length);
+          q_fp32 = q_buffer;
+          block_fp32 = q_buffer + input_chunk_length;
+        } else {
+          q_fp32 = q;
+        }
+
+        // Compute Q*K' for each block of keys
+        for (size_t block_index = 0; block_index < num_blocks; block_index++) {
+          const size_t block_tokens = std::min(block_size, total_seqlen - block_index * block_size);
+          const T* k = present_key_data + block_offset(batch_index, block_index, kv_head_index);
+          const float* k_fp32;
+          if constexpr (std::is_same<T, MLFloat16>::value) {
+            MlasConvertHalfToFloatBuffer(k, block_fp32, block_tokens * head_size);
+            k_fp32 = block_fp32;
+          } else {
+            k_fp32 = k;
+          }
+          math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasTrans, sequence_length, block_tokens, head_size, alpha,
+                                          q_fp32, static_cast<int>(head_size), k_fp32, static_cast<int>(head_size),
+                                          0.0f /*beta*/, probs + block_index * block_size,
+                                          static_cast<int>(probs_row_stride), nullptr);
+        }
+
+        ComputeCausalSoftmax(probs, sequence_length, past_seqlen, total_seqlen, probs_row_stride);
+
+        // Accumulate attention_probs x V for each block of values
+        float* output_current;
+        if constexpr (std::is_same<T, MLFloat16>::value) {
+          output_current = static_cast<float*>(output_fp32) + output_offset;
+        } else {
+          output_current = output_data + output_offset;
+        }
+        for (size_t block_index = 0; block_index < num_blocks; block_index++) {
+          const size_t block_tokens = std::min(block_size, total_seqlen - block_index * block_size);
+          const T* v = present_value_data + block_offset(batch_index, block_index, kv_head_index);
+          const float* v_fp32;
+          if constexpr (std::is_same<T, MLFloat16>::value) {
+            MlasConvertHalfToFloatBuffer(v, block_fp32, block_tokens * head_size);
+            v_fp32 = block_fp32;
+          } else {
+            v_fp32 = v;
+          }
+          math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasNoTrans, sequence_length, head_size, block_tokens,
+                                          1.f /*alpha*/, probs + block_index * block_size,
+                                          static_cast<int>(probs_row_stride), v_fp32, static_cast<int>(head_size),
+                                          block_index == 0 ? 0.0f : 1.0f /*beta*/, output_current,
+                                          static_cast<int>(hidden_size), nullptr);
+        }
+      }
+    });
+
+    if constexpr (std::is_same<T, MLFloat16>::value) {
+      MlasConvertFloatToHalfBuffer(static_cast<float*>(output_fp32), output_data,
+                                   SafeInt<size_t>(sequence_length) * batch_size * num_heads_ * head_size);
+    }
+
+    return Status::OK();
+  }
+
+  // Attention over a kv cache quantized to kv_cache_bit_width_ bits: int8, or int4 packed in pairs. Each row of
+  // head_size values of the cache has a float scale in past_key_scale and past_value_scale, with the shape of the cache
+  // without the head size. The cache is either contiguous with shape (B, N_kv, S*, H), or a paged block pool with shape
+  // (NB, N_kv, BS, H) when block_table is given. The new keys and values are quantized into the present cache, and the
+  // cache is dequantized a tile of rows at a time, so the fp32 keys and values of the whole sequence are never
+  // materialized.
+  template <typename T>
+  Status ApplyQuantizedKVAttention(const T* Q,                                 // Q data with shape BxNxSxH
+                                   const T* K,                                 // K data with shape BxN_kvxSxH
+                                   const T* V,                                 // V data with shape BxN_kvxSxH
+                                   const Tensor* past_key,                     // past K cache (optional if contiguous)
+                                   const Tensor* past_value,                   // past V cache (optional if contiguous)
+                                   const Tensor* past_key_scale,               // scales of past K
+                                   const Tensor* past_value_scale,             // scales of past V
+                                   Tensor* output,                             // output tensor
+                                   Tensor* present_key,                        // present K cache
+                                   Tensor* present_value,                      // present V cache
+                                   Tensor* present_key_scale,                  // scales of present K
+                                   Tensor* present_value_scale,                // scales of present V
+                                   const Tensor* seqlens_k,                    // past sequence lengths tensor
+                                   const Tensor* block_table,                  // block table with shape BxMB, or nullptr
+                                   GroupQueryAttentionParameters& parameters,  // attention parameters
+                                   AllocatorPtr allocator,                     // allocator for temporary tensors
+                                   OpKernelContext* context) const {
+    constexpr size_t kTileTokens = 64;  // number of cached tokens dequantized at a time
+
+    const bool is_prompt = parameters.is_first_prompt;
+    const bool paged = block_table != nullptr;
+    const size_t batch_size = static_cast<size_t>(parameters.batch_size);
+    const size_t sequence_length = static_cast<size_t>(parameters.sequence_length);
+    const size_t head_size = static_cast<size_t>(parameters.head_size);
+    const size_t hidden_size = static_cast<size_t>(parameters.hidden_size);
+    const size_t row_bytes = kv_cache_bit_width_ == 8 ? head_size : head_size / 2;
+    const bool packed_qkv = parameters.is_packed_qkv;
+
+    // A contiguous cache is handled as a paged cache with a block of seqlen_present_kv_cache tokens per sequence.
+    const size_t block_size = paged ? static_cast<size_t>(parameters.kv_cache_block_size)
+                                    : static_cast<size_t>(present_key->Shape().GetDims()[2]);
+    const size_t max_blocks_per_sequence = paged ? static_cast<size_t>(parameters.max_blocks_per_sequence) : 1;
+    const size_t probs_row_stride = paged ? static_cast<size_t>(parameters.total_sequence_length) : block_size;
+
+    if (present_key_scale == nullptr || present_value_scale == nullptr) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Output 'present_key_scale' and 'present_value_scale' are required with a quantized kv "
+                             "cache.");
+    }
+
+    auto* tp = context->GetOperatorThreadPool();
+
+    uint8_t* present_key_data = static_cast<uint8_t*>(present_key->MutableDataRaw());
+    uint8_t* present_value_data = static_cast<uint8_t*>(present_value->MutableDataRaw());
+    float* present_key_scale_data = present_key_scale->MutableData<float>();
+    float* present_value_scale_data = present_value_scale->MutableData<float>();
+
+    const int32_t* seqlens_k_data = seqlens_k->Data<int32_t>();
+    const int32_t* block_table_data = paged ? block_table->Data<int32_t>() : nullptr;
+    const size_t kv_num_heads_factor = num_heads_ / kv_num_heads_;
+    const size_t input_chunk_length = sequence_length * head_size;  // S x H
+    const size_t packed_batch_stride =
+        packed_qkv ? SafeInt<size_t>(num_heads_ + 2 * kv_num_heads_) * input_chunk_length : SafeInt<size_t>(0);
+    if (packed_qkv) {
+      K = Q + num_heads_ * input_chunk_length;
+      V = Q + (num_heads_ + kv_num_heads_) * input_chunk_length;
+    }
+
+    auto total_seqlen_of = [&](size_t batch_index) {
+      return static_cast<size_t>(seqlens_k_data[batch_index]) + 1;
+    };
+    auto past_seqlen_of = [&](size_t batch_index) {
+      return is_prompt ? size_t{0} : total_seqlen_of(batch_index) - sequence_length;  // Assume no padding
+    };
+    // index of the cache row holding the given position of a sequence and kv head
+    auto row_of = [&](size_t batch_index, size_t position, size_t kv_head_index) {
+      const size_t block_index = position / block_size;
+      const size_t block =
+          paged ? static_cast<size_t>(block_table_data[batch_index * max_blocks_per_sequence + block_index])
+                : batch_index;
+      return (block * kv_num_heads_ + kv_head_index) * block_size + position % block_size;
+    };
+    auto kv_input_offset = [&](size_t batch_index, size_t kv_head_index) {
+      return packed_qkv ? packed_batch_stride * batch_index + input_chunk_length * kv_head_index
+                        : input_chunk_length * (batch_index * kv_num_heads_ + kv_head_index);
+    };
+
+    // Copy the past cache and its scales to the present ones when they do not share the buffers.
+    if (past_key != nullptr) {
+      const bool copy_cache = present_key_data != past_key->DataRaw();
+      const bool copy_scales = present_key_scale_data != past_key_scale->Data<float>();
+      if (paged) {
+        if (copy_cache) {
+          memcpy(present_key_data, past_key->DataRaw(), past_key->SizeInBytes());
+          memcpy(present_value_data, past_value->DataRaw(), past_value->SizeInBytes());
+        }
+        if (copy_scales) {
+          memcpy(present_key_scale_data, past_key_scale->Data<float>(), past_key_scale->SizeInBytes());
+          memcpy(present_value_scale_data, past_value_scale->Data<float>(), past_value_scale->SizeInBytes());
+        }
+      } else if (copy_cache || copy_scales) {
+        const size_t past_buffer_length = static_cast<size_t>(past_key->Shape().GetDims()[2]);
+        for (size_t i = 0; i < batch_size * kv_num_heads_; i++) {
+          const size_t past_seqlen = std::min(past_seqlen_of(i / kv_num_heads_), past_buffer_length);
+          const size_t past_row = i * past_buffer_length;
+          const size_t present_row = i * block_size;
+          if (copy_cache) {
+            memcpy(present_key_data + present_row * row_bytes,
+                   static_cast<const uint8_t*>(past_key->DataRaw()) + past_row * row_bytes, past_seqlen * row_bytes);
+            memcpy(present_value_data + present_row * row_bytes,
+                   static_cast<const uint8_t*>(past_value->DataRaw()) + past_row * row_bytes,
+                   past_seqlen * row_bytes);
+          }
+          if (copy_scales) {
+            memcpy(present_key_scale_data + present_row, past_key_scale->Data<float>() + past_row,
+                   past_seqlen * sizeof(float));
+            memcpy(present_value_scale_data + present_row, past_value_scale->Data<float>() + past_row,
+                   past_seqlen * sizeof(float));
+          }
+        }
+      }
+    }
+
+    // Quantize the new keys and values of each sequence into the present cache. Positions beyond the total sequence
+    // length of a sequence are padding and are not written.
+    TensorOpCost cost;
+    cost.compute_cycles = static_cast<double>(4 * input_chunk_length);
+    cost.bytes_loaded = static_cast<double>(2 * input_chunk_length * sizeof(T));
+    cost.bytes_stored = static_cast<double>(2 * sequence_length * (row_bytes + sizeof(float)));
+    ThreadPool::TryParallelFor(tp, batch_size * kv_num_heads_, cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+      [[maybe_unused]] float* row_fp32 = nullptr;
+      BufferUniquePtr row_buffer;
+      if constexpr (std::is_same<T, MLFloat16>::value) {
+        auto buffer = allocator->Alloc(head_size * sizeof(float));
+        row_buffer = BufferUniquePtr(buffer, BufferDeleter(allocator));
+        row_fp32 = static_cast<float*>(buffer);
+      }
+      auto quantize_row = [&](const T* input, size_t row, uint8_t* data, float* scales) {
+        const float* input_fp32;
+        if constexpr (std::is_same<T, MLFloat16>::value) {
+          MlasConvertHalfToFloatBuffer(input, row_fp32, head_size);
+          input_fp32 = row_fp32;
+        } else {
+          input_fp32 = input;
+        }
+        QuantizeKVCacheRow(input_fp32, head_size, kv_cache_bit_width_, data + row * row_bytes, scales + row);
+      };
+
+      for (std::ptrdiff_t i = begin; i != end; ++i) {
+        const size_t batch_index = i / kv_num_heads_;
+        const size_t kv_head_index = i % kv_num_heads_;
+        const size_t total_seqlen = total_seqlen_of(batch_index);
+        const size_t past_seqlen = past_seqlen_of(batch_index);
+        const T* k = K + kv_input_offset(batch_index, kv_head_index);
+        const T* v = V + kv_input_offset(batch_index, kv_head_index);
+        for (size_t seq = 0; seq < sequence_length && past_seqlen + seq < total_seqlen; seq++) {
+          const size_t row = row_of(batch_index, past_seqlen + seq, kv_head_index);
+          quantize_row(k + seq * head_size, row, present_key_data, present_key_scale_data);
+          quantize_row(v + seq * head_size, row, present_value_data, present_value_scale_data);
+        }
+      }
+    });
+
+    // Compute the attention score and apply the score to V, one tile of dequantized rows at a time.
+    size_t probs_bytes = SafeInt<size_t>(batch_size) * num_heads_ * sequence_length * probs_row_stride * sizeof(float);
+    auto attention_probs = allocator->Alloc(probs_bytes);
+    BufferUniquePtr scratch_buffer(attention_probs, BufferDeleter(allocator));
+
+    size_t output_fp32_bytes = 0;
+    if constexpr (std::is_same<T, MLFloat16>::value) {
+      output_fp32_bytes = SafeInt<size_t>(sequence_length) * batch_size * num_heads_ * head_size * sizeof(float);
+    }
+    auto output_fp32 = allocator->Alloc(output_fp32_bytes);
+    BufferUniquePtr output_fp32_buffer(output_fp32, BufferDeleter(allocator));
+
+    const float alpha = scale_ == 0.0f ? 1.0f / sqrt(static_cast<float>(head_size)) : scale_;
+    T* output_data = output->MutableData<T>();
+
+    TensorOpCost unit_cost;
+    unit_cost.compute_cycles =
+        static_cast<double>(SafeInt<ptrdiff_t>(4) * sequence_length * head_size * probs_row_stride +
+                            SafeInt<ptrdiff_t>(2) * head_size * probs_row_stride);
+    unit_cost.bytes_loaded =
+        static_cast<double>(sequence_length * head_size * sizeof(T) + 2 * probs_row_stride * row_bytes);
+    unit_cost.bytes_stored = static_cast<double>(sequence_length * head_size * sizeof(T));
+
+    ThreadPool::TryParallelFor(tp, batch_size * num_heads_, unit_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+      // fp16 Q is converted to fp32 for the Gemm, and the tiles of the cache are dequantized to fp32
+      const size_t q_fp32_length = std::is_same<T, MLFloat16>::value ? input_chunk_length : 0;
+      auto buffer = allocator->Alloc((q_fp32_length + kTileTokens * head_size) * sizeof(float));
+      BufferUniquePtr fp32_buffer(buffer, BufferDeleter(allocator));
+      [[maybe_unused]] float* q_buffer = static_cast<float*>(buffer);
+      float* tile_fp32 = static_cast<float*>(buffer) + q_fp32_length;
+
+      // Calls fn(start, tokens, row) for each tile of cached positions, where the rows of a tile are consecutive.
+      auto for_each_tile = [&](size_t batch_index, size_t kv_head_index, size_t total_seqlen, auto&& fn) {
+        for (size_t start = 0; start < total_seqlen;) {
+          const size_t tokens = std::min({kTileTokens, block_size - start % block_size, total_seqlen - start});
+          fn(start, tokens, row_of(batch_index, start, kv_head_index));
+          start += tokens;
+        }
+      };
+
+      for (std::ptrdiff_t i = begin; i != end; ++i) {
+        const size_t batch_index = i / num_heads_;
+        const size_t head_index = i % num_heads_;
+        const size_t kv_head_index = head_index / kv_num_heads_factor;
+        const size_t total_seqlen = total_seqlen_of(batch_index);
+        const size_t past_seqlen = past_seqlen_of(batch_index);
+
+        const ptrdiff_t probs_offset = SafeInt<ptrdiff_t>(i) * sequence_length * probs_row_stride;
+        float* probs = static_cast<float*>(attention_probs) + probs_offset;
+        const T* q = packed_qkv ? Q + packed_batch_stride * batch_index + input_chunk_length * head_index
+                                : Q + input_chunk_length * i;
+        const size_t output_offset = (batch_index * sequence_length * num_heads_ + head_index) * head_size;
+
+        const float* q_fp32;
+        if constexpr (std::is_same<T, MLFloat16>::value) {
+          MlasConvertHalfToFloatBuffer(q, q_buffer, input_chunk_length);
+          q_fp32 = q_buffer;
+        } else {
+          q_fp32 = q;
+        }
+
+        // Compute Q*K' for each tile of keys
+        for_each_tile(batch_index, kv_head_index, total_seqlen, [&](size_t start, size_t tokens, size_t row) {
+          DequantizeKVCacheRows(present_key_data + row * row_bytes, present_key_scale_data + row, tokens, head_size,
+                                kv_cache_bit_width_, tile_fp32);
+          math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasTrans, sequence_length, tokens, head_size, alpha,
+                                          q_fp32, static_cast<int>(head_size), tile_fp32, static_cast<int>(head_size),
+                                          0.0f /*beta*/, probs + start, static_cast<int>(probs_row_stride), nullptr);
+        });
+
+        ComputeCausalSoftmax(probs, sequence_length, past_seqlen, total_seqlen, probs_row_stride);
+
+        // Accumulate attention_probs x V for each tile of values
+        float* output_current;
+        if constexpr (std::is_same<T, MLFloat16>::value) {
+          output_current = static_cast<float*>(output_fp32) + output_offset;
+        } else {
+          output_current = output_data + output_offset;
+        }
+        for_each_tile(batch_index, kv_head_index, total_seqlen, [&](size_t start, size_t tokens, size_t row) {
+          DequantizeKVCacheRows(present_value_data + row * row_bytes, present_value_scale_data + row, tokens,
+                                head_size, kv_cache_bit_width_, tile_fp32);
+          math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasNoTrans, sequence_length, head_size, tokens,
+                                          1.f /*alpha*/, probs + start, static_cast<int>(probs_row_stride), tile_fp32,
+                                          static_cast<int>(head_size), start == 0 ? 0.0f : 1.0f /*beta*/,
+                                          output_current, static_cast<int>(hidden_size), nullptr);
+        });
+      }
+    });
+
+    if constexpr (std::is_same<T, MLFloat16>::value) {
+      MlasConvertFloatToHalfBuffer(static_cast<float*>(output_fp32), output_data,
+                                   SafeInt<size_t>(sequence_length) * batch_size * num_heads_ * head_size);
+    }
+
+    return Status::OK();
+  }
+
  private:
+  // Flash attention over the present kv cache. The new keys and values are first concatenated with the past ones into
+  // present_key and present_value, then each block of queries attends its causal (and local window) range of keys
+  // without materializing the attention probs.
+  template <typename T>
+  Status ApplyFlashAttention(const T* Q,                                   // Q data with shape BxNxSxH
+                             const T* K,                                   // K data with shape BxN_kvxSxH
+                             const T* V,                                   // V data with shape BxN_kvxSxH
+                             const T* past_key,                            // past key only
+                             const T* past_value,                          // past value only
+                             T* present_key,                               // present key only
+                             T* present_value,                             // present value only
+                             T* output,                                    // output with shape BxSxNxH
+                             const int32_t* seqlens_k,                     // total - 1 sequence lengths tensor
+                             const size_t batch_size,                      // batch size of self-attention
+                             const size_t sequence_length,                 // sequence length of self-attention (S)
+                             const size_t past_buffer_sequence_length,     // sequence length of past state
+                             const size_t present_buffer_sequence_length,  // sequence length of present state
+                             const size_t head_size,                       // head size of self-attention
+                             const bool past_present_share_buffer,         // whether past and present share the buffer
+                             const bool packed_qkv,                        // whether Q, K, V are packed
+                             const bool is_prompt,                         // whether it is prompt
+                             ThreadPool* tp,                               // thread pool
+                             AllocatorPtr allocator) const {               // allocator for temporary buffer
+    const size_t packed_batch_stride =
+        packed_qkv ? SafeInt<size_t>(num_heads_ + 2 * kv_num_heads_) * sequence_length * head_size
+                   : SafeInt<size_t>(0);
+    const size_t kv_input_chunk_length = sequence_length * head_size;                     // L x H
+    const size_t past_buff_chunk_length = past_buffer_sequence_length * head_size;        // L x H
+    const size_t present_buff_chunk_length = present_buffer_sequence_length * head_size;  // T x H
+    if (packed_qkv) {
+      K = Q + num_heads_ * kv_input_chunk_length;
+      V = Q + (num_heads_ + kv_num_heads_) * kv_input_chunk_length;
+    }
+
+    if (!past_present_share_buffer) {
+      memset((void*)present_key, 0, batch_size * kv_num_heads_ * present_buff_chunk_length * sizeof(T));
+      memset((void*)present_value, 0, batch_size * kv_num_heads_ * present_buff_chunk_length * sizeof(T));
+    }
+
+    // The number of keys of each sequence, the flash attention treats the remaining positions as padding.
+    std::vector<int32_t> total_seqlens(batch_size);
+    for (size_t batch_index = 0; batch_index < batch_size; batch_index++) {
+      total_seqlens[batch_index] = seqlens_k[batch_index] + 1;
+    }
+
+    TensorOpCost cost;
+    cost.compute_cycles = 0;
+    cost.bytes_loaded = static_cast<double>(2 * present_buff_chunk_length * sizeof(T));
+    cost.bytes_stored = cost.bytes_loaded;
+    ThreadPool::TryParallelFor(tp, batch_size * kv_num_heads_, cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+      for (std::ptrdiff_t i = begin; i != end; ++i) {
+        const size_t batch_index = i / kv_num_heads_;
+        const size_t kv_head_index = i % kv_num_heads_;
+        const size_t total_seqlen = static_cast<size_t>(total_seqlens[batch_index]);
+        const size_t past_seqlen = is_prompt ? 0 : total_seqlen - sequence_length;  // Assume no padding sequence length
+        const size_t past_chunk_length = past_seqlen * head_size;
+        const size_t input_offset = packed_qkv ? packed_batch_stride * batch_index + kv_input_chunk_length * kv_head_index
+                                               : kv_input_chunk_length * i;
+        ConcatStateChunkGQA(past_key, K + input_offset, present_key, present_buff_chunk_length, past_buff_chunk_length,
+                            past_chunk_length, kv_input_chunk_length, past_present_share_buffer, i);
+        ConcatStateChunkGQA(past_value, V + input_offset, present_value, present_buff_chunk_length,
+                            past_buff_chunk_length, past_chunk_length, kv_input_chunk_length, past_present_share_buffer,
+                            i);
+      }
+    });
+
+    MlasFlashAttentionThreadedArgs args;
+    args.batch_size = static_cast<int>(batch_size);
+    args.num_heads = num_heads_;
+    args.kv_num_heads = kv_num_heads_;
+    args.q_sequence_length = static_cast<int>(sequence_length);
+    args.kv_sequence_length = static_cast<int>(present_buffer_sequence_length);
+    args.kv_buffer_sequence_length = static_cast<int>(present_buffer_sequence_length);
+    args.kv_sequence_lengths = total_seqlens.data();
+    args.query_batch_stride = packed_batch_stride;
+    args.qk_head_size = static_cast<int>(head_size);
+    args.v_head_size = static_cast<int>(head_size);
+    args.scale = scale_ == 0.0f ? 1.0f / sqrt(static_cast<float>(head_size)) : scale_;
+    args.is_causal = true;
+    args.local_window_size = local_window_size_ > 0 ? local_window_size_ : -1;
+    args.thread_count = concurrency::ThreadPool::DegreeOfParallelism(tp);
+    if constexpr (std::is_same<T, float>::value) {
+      args.query = Q;
+      args.key = present_key;
+      args.value = present_value;
+      args.output = output;
+    } else {
+      args.query_fp16 = reinterpret_cast<const MLAS_FP16*>(Q);
+      args.key_fp16 = reinterpret_cast<const MLAS_FP16*>(present_key);
+      args.value_fp16 = reinterpret_cast<const MLAS_FP16*>(present_value);
+      args.output_fp16 = reinterpret_cast<MLAS_FP16*>(output);
+    }
+    IAllocatorUniquePtr<void> buffer = PrepareFlashAttention(args, l2_cache_size_, allocator);
+
+    MlasFlashAttention(&args, tp);
+    return Status::OK();
+  }
+
+  // Softmax of the rows of attention_probs(S, T) over the causal (and local window) range of each query position.
+  // The probabilities of the positions outside of that range are set to 0.
+  void ComputeCausalSoftmax(float* attention_probs,    // attention probs of one head with S rows
+                            size_t sequence_length,    // sequence length of Q (S)
+                            size_t past_seqlen,        // number of past tokens before the first query position
+                            size_t total_seqlen,       // number of valid columns
+                            size_t row_stride) const {  // distance between the rows of attention_probs
+    float* output_softmax = attention_probs;
+    for (size_t seq = 0; seq < sequence_length; seq++) {
+      size_t seq_causal_length = past_seqlen + seq + 1;
+      if (local_window_size_ > 0 && seq_causal_length > static_cast<size_t>(local_window_size_) + 1) {
+        for (size_t total_seq_id = 0; total_seq_id < seq_causal_length - local_window_size_ - 1; total_seq_id++) {
+          output_softmax[total_seq_id] = 0.f;
+        }
+        if (softcap_ > 0.f) {
+          ComputeAttentionSoftcapInplace(output_softmax + seq_causal_length - local_window_size_ - 1,
+                                         local_window_size_ + 1, softcap_);
+        }
+        if (use_smooth_softmax_) {
+          ComputeSmoothSoftmaxInplace(output_softmax + seq_causal_length - local_window_size_ - 1, 1,
+                                      local_window_size_ + 1, nullptr);
+        } else {
+          ComputeAttentionSoftmaxInplace(output_softmax + seq_causal_length - local_window_size_ - 1, 1,
+                                         local_window_size_ + 1, nullptr);
+        }
+      } else {
+        if (softcap_ > 0.f) {
+          ComputeAttentionSoftcapInplace(output_softmax, static_cast<int>(seq_causal_length), softcap_);
+        }
+        if (use_smooth_softmax_) {
+          ComputeSmoothSoftmaxInplace(output_softmax, 1, static_cast<int>(seq_causal_length), nullptr);
+        } else {
+          ComputeAttentionSoftmaxInplace(output_softmax, 1, static_cast<int>(seq_causal_length), nullptr);
+        }
+      }
+
+      // set causal [seq_causal_length, total_seqlen) to 0.f
+      for (size_t total_seq_id = seq_causal_length; total_seq_id < total_seqlen; total_seq_id++) {
+        output_softmax[total_seq_id] = 0.f;
+      }
+
+      output_softmax += row_stride;
+    }
+  }
+
   // Helper function to compute the attention probs. It does 2 things:
   //  attention_probs(B, N, S, T) = 1/sqrt(H) x Q(B, N, S, H) x K'(B, N, T, H -> B, N, H, T)
   //  attention_probs(B, N, S, T) = Softmax(attention_probs)
@@ -215,42 +837,7 @@ class GQAAttentionBase {
         }
 
         // compute Softmax
-        float* output_softmax = output;
-        for (size_t seq = 0; seq < sequence_length; seq++) {
-          size_t seq_causal_length = past_seqlen + seq + 1;
-          if (local_window_size_ > 0 && seq_causal_length > static_cast<size_t>(local_window_size_) + 1) {
-            for (size_t total_seq_id = 0; total_seq_id < seq_causal_length - local_window_size_ - 1; total_seq_id++) {
-              output_softmax[total_seq_id] = 0.f;
-            }
-            if (softcap_ > 0.f) {
-              ComputeAttentionSoftcapInplace(output_softmax + seq_causal_length - local_window_size_ - 1,
-                                             local_window_size_ + 1, softcap_);
-            }
-            if (use_smooth_softmax_) {
-              ComputeSmoothSoftmaxInplace(output_softmax + seq_causal_length - local_window_size_ - 1, 1,
-                                          local_window_size_ + 1, nullptr);
-            } else {
-              ComputeAttentionSoftmaxInplace(output_softmax + seq_causal_length - local_window_size_ - 1, 1,
-                                             local_window_size_ + 1, nullptr);
-            }
-          } else {
-            if (softcap_ > 0.f) {
-              ComputeAttentionSoftcapInplace(output_softmax, static_cast<int>(seq_causal_length), softcap_);
-            }
-            if (use_smooth_softmax_) {
-              ComputeSmoothSoftmaxInplace(output_softmax, 1, static_cast<int>(seq_causal_length), nullptr);
-            } else {
-              ComputeAttentionSoftmaxInplace(output_softmax, 1, static_cast<int>(seq_causal_length), nullptr);
-            }
-          }
-
-          // set causal [seq_causal_length, total_seqlen) to 0.f
-          for (size_t total_seq_id = seq_causal_length; total_seq_id < total_seqlen; total_seq_id++) {
-            output_softmax[total_seq_id] = 0.f;
-          }
-
-          output_softmax += present_buffer_sequence_length;
-        }
+        ComputeCausalSoftmax(output, sequence_length, past_seqlen, total_seqlen, present_buffer_sequence_length);
       }
     });
   }
@@ -22,16 +22,20 @@ namespace onnxruntime {
 namespace contrib {
 
 // These ops are internal-only, so register outside of onnx
-#define REGISTER_KERNEL_TYPED(T)                                        \
-  ONNX_OPERATOR_TYPED_KERNEL_EX(                                        \
-      GroupQueryAttention,                                              \
-      kMSDomain,                                                        \
-      1,                                                                \
-      T,                                                                \
-      kCpuExecutionProvider,                                            \
-      KernelDefBuilder()                                                \
-          .TypeConstraint("T", DataTypeImpl::GetTensorType<T>())        \
-          .TypeConstraint("M", DataTypeImpl::GetTensorType<int32_t>()), \
+#define REGISTER_KERNEL_TYPED(T)                                              \
+  ONNX_OPERATOR_TYPED_KERNEL_EX(                                              \
+      GroupQueryAttention,                                                    \
+      kMSDomain,                                                              \
+      1,                                                                      \
+      T,                                                                      \
+      kCpuExecutionProvider,                                                  \
+      KernelDefBuilder()                                                      \
+          .TypeConstraint("T", DataTypeImpl::GetTensorType<T>())              \
+          .TypeConstraint("T_CACHE", {DataTypeImpl::GetTensorType<T>(),       \
+                                      DataTypeImpl::GetTensorType<int8_t>(),  \
+                                      DataTypeImpl::GetTensorType<Int4x2>()}) \
+          .TypeConstraint("T_KV_SCALE", DataTypeImpl::GetTensorType<float>()) \
+          .TypeConstraint("M", DataTypeImpl::GetTensorType<int32_t>()),       \
       GroupQueryAttention<T>);
 
 REGISTER_KERNEL_TYPED(float)
@@ -52,13 +56,19 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
   const Tensor* total_seqlen_tensor = context->Input<Tensor>(6);
   const Tensor* cos_cache = context->Input<Tensor>(7);
   const Tensor* sin_cache = context->Input<Tensor>(8);
+  const Tensor* block_table = context->Input<Tensor>(9);
+  const Tensor* past_key_scale = context->Input<Tensor>(10);
+  const Tensor* past_value_scale = context->Input<Tensor>(11);
+
+  // With the paged kv cache, past key and value are block pools which are checked separately
+  const bool paged_kv_cache = block_table != nullptr;
 
   GroupQueryAttentionParameters parameters = {};
   ORT_RETURN_IF_ERROR(group_query_attention_helper::CheckInputs(query,
                                                                 key,
                                                                 value,
-                                                                past_key,
-                                                                past_value,
+                                                                paged_kv_cache ? nullptr : past_key,
+                                                                paged_kv_cache ? nullptr : past_value,
                                                                 cos_cache,
                                                                 sin_cache,
                                                                 &parameters,
@@ -68,6 +78,30 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
                                                                 total_seqlen_tensor,
                                                                 scale_,
                                                                 softcap_));
+  if (paged_kv_cache) {
+    ORT_RETURN_IF_ERROR(group_query_attention_helper::CheckPagedKVCacheInputs(past_key,
+                                                                              past_value,
+                                                                              block_table,
+                                                                              seqlens_k,
+                                                                              &parameters));
+  }
+  const bool quantized_kv_cache = kv_cache_bit_width_ != 0;
+  if (quantized_kv_cache) {
+    ORT_RETURN_IF_ERROR(group_query_attention_helper::CheckQuantizedKVCacheInputs(past_key,
+                                                                                  past_value,
+                                                                                  past_key_scale,
+                                                                                  past_value_scale,
+                                                                                  kv_cache_bit_width_,
+                                                                                  &parameters));
+  } else if (past_key_scale != nullptr || past_value_scale != nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key_scale' and 'past_value_scale' require a non-zero kv_cache_bit_width.");
+  } else if ((past_key != nullptr && !past_key->IsDataType<T>()) ||
+             (past_value != nullptr && !past_value->IsDataType<T>())) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' and 'past_value' shall have the type of query with a zero "
+                           "kv_cache_bit_width.");
+  }
 
   const int batch_size = parameters.batch_size;
   const int sequence_length = parameters.sequence_length;
@@ -84,8 +118,30 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
 
   std::vector<int64_t> present_k_shape({static_cast<int64_t>(batch_size), static_cast<int64_t>(kv_num_heads_), static_cast<int64_t>(present_kv_seqlen), static_cast<int64_t>(head_size)});
   std::vector<int64_t> present_v_shape({static_cast<int64_t>(batch_size), static_cast<int64_t>(kv_num_heads_), static_cast<int64_t>(present_kv_seqlen), static_cast<int64_t>(head_size)});
+  if (paged_kv_cache) {
+    // present key and value are the updated block pools
+    const auto& pool_dims = past_key->Shape().GetDims();
+    present_k_shape.assign(pool_dims.begin(), pool_dims.end());
+    present_v_shape.assign(pool_dims.begin(), pool_dims.end());
+  }
   Tensor* present_k = context->Output(1, present_k_shape);
   Tensor* present_v = context->Output(2, present_v_shape);
+  if (paged_kv_cache && (present_k == nullptr || present_v == nullptr)) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Output 'present_key' and 'present_value' are required with paged kv cache.");
+  }
+  Tensor* present_k_scale = nullptr;
+  Tensor* present_v_scale = nullptr;
+  if (quantized_kv_cache) {
+    if (present_k == nullptr || present_v == nullptr) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Output 'present_key' and 'present_value' are required with quantized kv cache.");
+    }
+    // a scale for each row of head_size values of the present key and value
+    std::vector<int64_t> present_k_scale_shape(present_k_shape.begin(), present_k_shape.end() - 1);
+    present_k_scale = context->Output(3, present_k_scale_shape);
+    present_v_scale = context->Output(4, present_k_scale_shape);
+  }
 
   AllocatorPtr allocator;
   ORT_RETURN_IF_ERROR(context->GetTempSpaceAllocator(&allocator));
@@ -192,6 +248,18 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
   }
 
   ORT_RETURN_IF_ERROR(context->GetTempSpaceAllocator(&allocator));
+  if (quantized_kv_cache) {
+    return ApplyQuantizedKVAttention(q_rotary, packed_qkv ? nullptr : k_rotary,
+                                     packed_qkv ? nullptr : V.Get<Tensor>().Data<T>(), past_key, past_value,
+                                     past_key_scale, past_value_scale, output, present_k, present_v, present_k_scale,
+                                     present_v_scale, seqlens_k, block_table, parameters, allocator, context);
+  }
+  if (paged_kv_cache) {
+    return ApplyPagedAttention(q_rotary, packed_qkv ? nullptr : k_rotary,
+                               packed_qkv ? nullptr : V.Get<Tensor>().Data<T>(), past_key, past_value, output,
+                               present_k, present_v, seqlens_k, block_table, parameters, allocator, context);
+  }
+
   // Compute the attention score and apply the score to V
   return ApplyAttention(q_rotary, packed_qkv ? nullptr : k_rotary, packed_qkv ? nullptr : V.Get<Tensor>().Data<T>(),
                         past_key, past_value, output, present_k, present_v,
@@ -286,6 +286,141 @@ Status CheckInputs(const Tensor* query,
 
   return CheckInputs(query, key, value, past_key, past_value, cos_cache, sin_cache, parameters, num_heads, kv_num_heads, seqlens_k, total_seqlen, scale, softcap);
 }
+
+// Checks the inputs of the paged kv cache. CheckInputs shall be called first without past_key and past_value.
+// Note: Here NB is the number of blocks in the pools, BS is the block size and MB is max_blocks_per_sequence
+//     past_key                   : (NB, N_k, BS, H)
+//     past_value                 : (NB, N_k, BS, H)
+//     block_table                : (B, MB)
+Status CheckPagedKVCacheInputs(const Tensor* past_key,
+                               const Tensor* past_value,
+                               const Tensor* block_table,
+                               const Tensor* seqlens_k,
+                               GroupQueryAttentionParameters* parameters) {
+  if (past_key == nullptr || past_value == nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' and 'past_value' shall be present when 'block_table' is given.");
+  }
+
+  const auto& past_key_dims = past_key->Shape().GetDims();
+  if (past_key_dims.size() != 4) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' is expected to have 4 dimensions with paged kv cache, got ",
+                           past_key_dims.size());
+  }
+  if (past_value->Shape() != past_key->Shape()) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' and 'past_value' shall have the same shape with paged kv cache.");
+  }
+  if (past_key_dims[1] != parameters->kv_num_heads) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' dimension 1 should be kv_num_heads, got ", past_key_dims[1]);
+  }
+  if (past_key_dims[3] != parameters->head_size) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' dimension 3 should be same as head_size, got ", past_key_dims[3]);
+  }
+  if (past_key_dims[0] <= 0 || past_key_dims[2] <= 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' shall have at least one block of at least one token.");
+  }
+  const int num_blocks = static_cast<int>(past_key_dims[0]);
+  const int block_size = static_cast<int>(past_key_dims[2]);
+
+  const auto& block_table_dims = block_table->Shape().GetDims();
+  if (block_table_dims.size() != 2 || block_table_dims[0] != parameters->batch_size) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "block_table must be shape (batch_size, max_blocks_per_sequence).");
+  }
+  const int max_blocks_per_sequence = static_cast<int>(block_table_dims[1]);
+
+  // every position up to the total sequence length of each sequence shall be mapped to a block of the pools
+  const int32_t* seqlens_k_data = seqlens_k->Data<int32_t>();
+  const int32_t* block_table_data = block_table->Data<int32_t>();
+  for (int b = 0; b < parameters->batch_size; b++) {
+    const int total_seqlen = seqlens_k_data[b] + 1;
+    if (total_seqlen <= 0 || total_seqlen > parameters->total_sequence_length) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "seqlens_k[", b, "] + 1 shall be in the range [1, total_sequence_length], got ",
+                             total_seqlen);
+    }
+    const int num_sequence_blocks = (total_seqlen + block_size - 1) / block_size;
+    if (num_sequence_blocks > max_blocks_per_sequence) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "block_table has ", max_blocks_per_sequence, " blocks per sequence but sequence ", b,
+                             " needs ", num_sequence_blocks, " blocks of ", block_size, " tokens.");
+    }
+    for (int i = 0; i < num_sequence_blocks; i++) {
+      const int32_t block = block_table_data[static_cast<ptrdiff_t>(b) * max_blocks_per_sequence + i];
+      if (block < 0 || block >= num_blocks) {
+        return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                               "block_table[", b, "][", i, "] shall be in the range [0, ", num_blocks, "), got ",
+                               block);
+      }
+    }
+  }
+
+  parameters->paged_kv_cache = true;
+  parameters->num_kv_cache_blocks = num_blocks;
+  parameters->kv_cache_block_size = block_size;
+  parameters->max_blocks_per_sequence = max_blocks_per_sequence;
+
+  return Status::OK();
+}
+
+// Checks the inputs of the quantized kv cache. The cache holds int8 (kv_cache_bit_width 8) or int4 (kv_cache_bit_width 4)
+// values with a float scale per token and kv head, so each scale tensor has the shape of its cache without the head size.
+//     past_key                   : (B, N_k, S*, H) or (NB, N_k, BS, H) with block_table
+//     past_key_scale             : (B, N_k, S*) or (NB, N_k, BS) with block_table
+Status CheckQuantizedKVCacheInputs(const Tensor* past_key,
+                                   const Tensor* past_value,
+                                   const Tensor* past_key_scale,
+                                   const Tensor* past_value_scale,
+                                   int kv_cache_bit_width,
+                                   GroupQueryAttentionParameters* parameters) {
+  if (kv_cache_bit_width != 8 && kv_cache_bit_width != 4) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "kv_cache_bit_width shall be 0, 4 or 8, got ", kv_cache_bit_width);
+  }
+  if (kv_cache_bit_width == 4 && parameters->head_size % 2 != 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "head_size shall be even with a 4 bits kv cache, got ", parameters->head_size);
+  }
+
+  if (past_key == nullptr) {
+    if (past_key_scale != nullptr || past_value_scale != nullptr) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Input 'past_key_scale' and 'past_value_scale' shall be absent without past_key.");
+    }
+    return Status::OK();
+  }
+
+  const bool is_int8 = past_key->IsDataType<int8_t>() && past_value->IsDataType<int8_t>();
+  const bool is_int4 = past_key->IsDataType<Int4x2>() && past_value->IsDataType<Int4x2>();
+  if ((kv_cache_bit_width == 8 && !is_int8) || (kv_cache_bit_width == 4 && !is_int4)) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' and 'past_value' shall be ", kv_cache_bit_width == 8 ? "int8" : "int4",
+                           " tensors with kv_cache_bit_width ", kv_cache_bit_width, ".");
+  }
+
+  if (past_key_scale == nullptr || past_value_scale == nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key_scale' and 'past_value_scale' shall be present with a quantized past_key.");
+  }
+  const auto& past_key_dims = past_key->Shape().GetDims();
+  const auto& scale_dims = past_key_scale->Shape().GetDims();
+  if (scale_dims.size() != 3 || scale_dims[0] != past_key_dims[0] || scale_dims[1] != past_key_dims[1] ||
+      scale_dims[2] != past_key_dims[2]) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key_scale' shall have the shape of past_key without the head size.");
+  }
+  if (past_value_scale->Shape() != past_key_scale->Shape()) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key_scale' and 'past_value_scale' shall have the same shape.");
+  }
+
+  return Status::OK();
+}
 }  // namespace group_query_attention_helper
 }  // namespace contrib
 }  // namespace onnxruntime
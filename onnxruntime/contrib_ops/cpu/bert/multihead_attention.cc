@@ -145,64 +145,76 @@ Status MultiHeadAttention<T>::Compute(OpKernelContext* context) const {
   ORT_RETURN_IF_ERROR(MaybeTransposeToBNSHAndAddBias<T>(
       context, allocator, batch_size, num_heads_, kv_sequence_length, v_head_size, value, bias, v_bias_offset, V));
 
+  // The flash attention supports causal masks, and key padding masks given as the number of valid keys of each batch.
+  // The causal mask of the regular path does not depend on the padding, so the two are not combined.
+  const bool flash_supports_mask =
+      key_padding_mask == nullptr ||
+      (parameters.mask_type == AttentionMaskType::MASK_1D_KEY_SEQ_LEN && !is_unidirectional_);
   if (std::is_same_v<T, float> &&
       !disable_flash_ &&
-      !is_unidirectional_ &&
-      key_padding_mask == nullptr &&
+      flash_supports_mask &&
       attn_bias == nullptr &&
-      past_key == nullptr &&
-      past_value == nullptr &&
-      present_k == nullptr &&
-      present_v == nullptr &&
+      (past_key == nullptr || present_k != nullptr) &&
+      (past_value == nullptr || present_v != nullptr) &&
       l2_cache_size_ > 0) {
+    auto* tp = context->GetOperatorThreadPool();
+
+    // Concatenate the past and new keys and values into the present outputs, and attend to those.
+    const float* k_data = K.Get<Tensor>().Data<float>();
+    const float* v_data = V.Get<Tensor>().Data<float>();
+    if (present_k != nullptr || present_v != nullptr) {
+      const int past_sequence_length = total_kv_sequence_length - kv_sequence_length;
+      const float* past_k_data = past_key != nullptr ? past_key->Data<float>() : nullptr;
+      const float* past_v_data = past_value != nullptr ? past_value->Data<float>() : nullptr;
+      float* present_k_data = present_k != nullptr ? present_k->MutableData<float>() : nullptr;
+      float* present_v_data = present_v != nullptr ? present_v->MutableData<float>() : nullptr;
+      const size_t k_chunk_length = SafeInt<size_t>(kv_sequence_length) * qk_head_size;
+      const size_t v_chunk_length = SafeInt<size_t>(kv_sequence_length) * v_head_size;
+
+      TensorOpCost cost;
+      cost.compute_cycles = 0;
+      cost.bytes_loaded = static_cast<double>(SafeInt<size_t>(total_kv_sequence_length) *
+                                              (qk_head_size + v_head_size) * sizeof(float));
+      cost.bytes_stored = cost.bytes_loaded;
+      ThreadPool::TryParallelFor(tp, batch_size * num_heads_, cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+        for (std::ptrdiff_t i = begin; i != end; ++i) {
+          if (present_k_data != nullptr) {
+            ConcatStateChunk(past_k_data, k_data + i * k_chunk_length, present_k_data,
+                             SafeInt<size_t>(past_sequence_length) * qk_head_size,
+                             SafeInt<size_t>(total_kv_sequence_length) * qk_head_size, i);
+          }
+          if (present_v_data != nullptr) {
+            ConcatStateChunk(past_v_data, v_data + i * v_chunk_length, present_v_data,
+                             SafeInt<size_t>(past_sequence_length) * v_head_size,
+                             SafeInt<size_t>(total_kv_sequence_length) * v_head_size, i);
+          }
+        }
+      });
+
+      if (present_k_data != nullptr) {
+        k_data = present_k_data;
+      }
+      if (present_v_data != nullptr) {
+        v_data = present_v_data;
+      }
+    }
+
     MlasFlashAttentionThreadedArgs args;
     args.batch_size = batch_size;
     args.num_heads = num_heads_;
     args.q_sequence_length = q_sequence_length;
-    args.kv_sequence_length = kv_sequence_length;
+    args.kv_sequence_length = total_kv_sequence_length;
     args.qk_head_size = qk_head_size;
     args.v_head_size = v_head_size;
     args.scale = (scale_ == 0.0f) ? 1.0f / sqrt(static_cast<float>(qk_head_size)) : scale_;
-    /*
-      q_block_size, kv_block_size correspond to Br, Bc in the FlashAttention paper.
-      Let M = l2_cache_size / sizeof(float)
-      In the FlashAttention kernel, there are 5 big matrices that we need to keep in L2 cache:
-        slice of Q -- [Br, qk_head_size]
-        slice of K -- [Bc, qk_head_size]
-        slice of V -- [Bc, v_head_size]
-        result of QK -- [Br, Bc]
-        temporary output (same shape as QKV) -- [Br, v_head_size]
-      The total size of these matrices is (Br + Bc) * (qk_head_size + v_head_size) + Br * Bc
-      By taking Bc = M / (4 * (qk_head_size + v_head_size)), and Br = min(Bc, qk_head_size + v_head_size), we have
-        (Br + Bc) * (qk_head_size + v_head_size) + Br * Bc
-        <= 2 * Bc * (qk_head_size + v_head_size) + Br * Bc
-        <= 2 * Bc * (qk_head_size + v_head_size) + M/4
-        <= 2 * M/4 + M/4 = M * (3/4)
-
-      We leave 1/4 of the L2 cache for
-        1. storing small tensors l and m
-        2. instruction (code)
-    */
-    args.kv_block_size = l2_cache_size_ / (static_cast<int>(sizeof(float)) * 4 * (qk_head_size + v_head_size));
-    args.kv_block_size = std::max(args.kv_block_size, 1);  // avoid kv_block_size = 0
-    args.q_block_size = std::min(args.kv_block_size, qk_head_size + v_head_size);
-    args.kv_block_size = std::min(args.kv_block_size, kv_sequence_length);  // No point to have kv_block_size > kv_sequence_length
-    args.q_block_size = std::min(args.q_block_size, q_sequence_length);     // No point to have q_block_size > q_sequence_length
-
-    auto* tp = context->GetOperatorThreadPool();
+    args.is_causal = is_unidirectional_;
+    args.kv_sequence_lengths = key_padding_mask != nullptr ? key_padding_mask->Data<int32_t>() : nullptr;
     args.thread_count = concurrency::ThreadPool::DegreeOfParallelism(tp);
-    args.buffer_size_per_thread = (static_cast<size_t>(args.q_block_size) * 2 +
-                                   static_cast<size_t>(args.q_block_size) * static_cast<size_t>(args.kv_block_size) +
-                                   static_cast<size_t>(args.q_block_size) * static_cast<size_t>(args.v_head_size)) *
-                                  sizeof(float);
-    size_t buffer_bytes = args.buffer_size_per_thread * args.thread_count;
-    IAllocatorUniquePtr<void> buffer = IAllocator::MakeUniquePtr<void>(allocator, buffer_bytes);
-
-    args.buffer = reinterpret_cast<float*>(buffer.get());
+    IAllocatorUniquePtr<void> buffer = PrepareFlashAttention(args, l2_cache_size_, allocator);
 
     args.query = Q.Get<Tensor>().Data<float>();
-    args.key = K.Get<Tensor>().Data<float>();
-    args.value = V.Get<Tensor>().Data<float>();
+    args.key = k_data;
+    args.value = v_data;
     args.output = output->MutableData<float>();
 
     MlasFlashAttention(&args, tp);
@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <type_traits>
+
 #include "core/providers/cpu/math/gemm.h"
 
 namespace onnxruntime {
@@ -20,8 +22,43 @@ class FusedGemm final : public Gemm<T> {
         attrs[p.first.substr(ACTIVATION_NAME_PREFIX_LEN)] = p.second;
       }
     }
+    if constexpr (std::is_same<T, float>::value) {
+      // Activations supported by the MLAS GEMM epilogue are applied while the output is in the cache.
+      MLAS_ACTIVATION mlas_activation;
+      if (GetMlasActivation(info, activation, mlas_activation)) {
+        this->mlas_activation_ = mlas_activation;
+        return;
+      }
+    }
     ORT_THROW_IF_ERROR(functors::ElementWiseRangedTransform<T>::Create(activation, attrs, this->activation_));
   }
+
+ private:
+  static bool GetMlasActivation(const OpKernelInfo& info, const std::string& activation,
+                                MLAS_ACTIVATION& mlas_activation) {
+    if (activation == "Relu") {
+      mlas_activation.ActivationKind = MlasReluActivation;
+    } else if (activation == "Sigmoid") {
+      mlas_activation.ActivationKind = MlasLogisticActivation;
+    } else if (activation == "Tanh") {
+      mlas_activation.ActivationKind = MlasTanhActivation;
+    } else if (activation == "LeakyRelu") {
+      mlas_activation.ActivationKind = MlasLeakyReluActivation;
+      mlas_activation.Parameters.LeakyRelu.alpha = info.GetAttrOrDefault<float>("activation_alpha", 0.01f);
+    } else if (activation == "HardSigmoid") {
+      mlas_activation.ActivationKind = MlasHardSigmoidActivation;
+      mlas_activation.Parameters.HardSigmoid.alpha = info.GetAttrOrDefault<float>("activation_alpha", 0.2f);
+      mlas_activation.Parameters.HardSigmoid.beta = info.GetAttrOrDefault<float>("activation_beta", 0.5f);
+    } else if (activation == "Gelu") {
+      const bool approximate = info.GetAttrOrDefault<std::string>("activation_approximate", "none") == "tanh";
+      mlas_activation.ActivationKind = approximate ? MlasFastGeluActivation : MlasGeluActivation;
+    } else if (activation == "FastGelu") {
+      mlas_activation.ActivationKind = MlasFastGeluActivation;
+    } else {
+      return false;
+    }
+    return true;
+  }
 };
 
 ONNX_CPU_OPERATOR_TYPED_MS_KERNEL(
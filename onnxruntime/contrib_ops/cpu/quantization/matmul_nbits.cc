@@ -125,6 +125,13 @@ class MatMulNBits final : public OpKernel {
   Status UseSharedPrePackedBuffers(std::vector<BufferUniquePtr>& prepacked_buffers, int input_idx,
                                    /*out*/ bool& used_shared_buffers) override;
 
+  Status GetPrePackedBuffersToPersist(int input_idx,
+                                      /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const override;
+
+  Status UsePersistedPrePackedBuffers(const Tensor& tensor, std::vector<BufferUniquePtr>& prepacked_buffers,
+                                      gsl::span<const size_t> prepacked_buffer_sizes,
+                                      int input_idx, /*out*/ bool& used_persisted_buffers) override;
+
  private:
   const size_t K_;
   const size_t N_;
@@ -137,6 +144,8 @@ class MatMulNBits final : public OpKernel {
   const bool column_wise_quant_{true};
   IAllocatorUniquePtr<void> packed_b_{};
   size_t packed_b_size_{0};
+  // a persisted packed B already contains the packed scales and zero points
+  bool packed_b_persisted_{false};
   IAllocatorUniquePtr<float> scales_fp32_{};
   IAllocatorUniquePtr<float> bias_fp32_{};
 
@@ -190,12 +199,12 @@ Status MatMulNBits<T1>::PrePack(const Tensor& tensor, int input_idx, /*out*/ All
     is_packed = true;
   } else if (compute_type_ == SQNBIT_CompInt8) {
 #ifdef MLAS_TARGET_AMD64_IX86
-    if (input_idx == InputIndex::scales && packed_b_ != nullptr) {
+    if (input_idx == InputIndex::scales && packed_b_ != nullptr && !packed_b_persisted_) {
       auto sptr = tensor.Data<float>();
       MlasQNBitGemmPackQuantBData(N_, K_, nbits_, block_size_, compute_type_, nullptr, packed_b_.get(), sptr,
                                   has_zp_input_, nullptr, nullptr);
       is_packed = false;
-    } else if (input_idx == InputIndex::zero_points && packed_b_ != nullptr) {
+    } else if (input_idx == InputIndex::zero_points && packed_b_ != nullptr && !packed_b_persisted_) {
       auto zptr = tensor.Data<uint8_t>();
       MlasQNBitGemmPackQuantBData(N_, K_, nbits_, block_size_, compute_type_, nullptr, packed_b_.get(), nullptr, has_zp_input_, zptr, nullptr);
       is_packed = false;
@@ -246,11 +255,11 @@ Status MatMulNBits<MLFloat16>::PrePack(const Tensor& tensor, int input_idx, /*ou
     is_packed = true;
   } else if (compute_type_ == SQNBIT_CompInt8) {
 #ifdef MLAS_TARGET_AMD64_IX86
-    if (input_idx == InputIndex::scales && packed_b_ != nullptr) {
+    if (input_idx == InputIndex::scales && packed_b_ != nullptr && !packed_b_persisted_) {
       MlasQNBitGemmPackQuantBData(N_, K_, nbits_, block_size_, compute_type_, nullptr, packed_b_.get(),
                                   scales_fp32_.get(), has_zp_input_, nullptr, nullptr);
       is_packed = false;
-    } else if (input_idx == InputIndex::zero_points && packed_b_ != nullptr) {
+    } else if (input_idx == InputIndex::zero_points && packed_b_ != nullptr && !packed_b_persisted_) {
       auto zptr = tensor.Data<uint8_t>();
       MlasQNBitGemmPackQuantBData(N_, K_, nbits_, block_size_, compute_type_, nullptr, packed_b_.get(),
                                   nullptr, has_zp_input_, zptr, nullptr);
@@ -276,6 +285,45 @@ Status MatMulNBits<T1>::UseSharedPrePackedBuffers(std::vector<BufferUniquePtr>&
   return Status::OK();
 }
 
+template <typename T1>
+Status MatMulNBits<T1>::GetPrePackedBuffersToPersist(
+    int input_idx, /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const {
+  prepacked_buffers.clear();
+
+  // called after the scales and zero points were packed into packed_b_ too
+  if (input_idx == InputIndex::B && packed_b_) {
+    prepacked_buffers.emplace_back(static_cast<const std::byte*>(packed_b_.get()), packed_b_size_);
+  }
+
+  return Status::OK();
+}
+
+template <typename T1>
+Status MatMulNBits<T1>::UsePersistedPrePackedBuffers(const Tensor& /*tensor*/,
+                                                     std::vector<BufferUniquePtr>& prepacked_buffers,
+                                                     gsl::span<const size_t> prepacked_buffer_sizes,
+                                                     int input_idx,
+                                                     /*out*/ bool& used_persisted_buffers) {
+  used_persisted_buffers = false;
+
+  // same conditions as PrePack() packing B
+  if (input_idx != InputIndex::B || prepacked_buffers.size() != 1 || has_g_idx_ || has_unquantized_zero_point_ ||
+      !MlasIsQNBitGemmAvailable(nbits_, block_size_, compute_type_)) {
+    return Status::OK();
+  }
+
+  const size_t packed_b_size = MlasQNBitGemmPackQuantBDataSize(N_, K_, nbits_, block_size_, compute_type_);
+  if (packed_b_size == 0 || prepacked_buffer_sizes[0] != packed_b_size) {
+    return Status::OK();
+  }
+
+  packed_b_size_ = packed_b_size;
+  packed_b_ = std::move(prepacked_buffers[0]);
+  packed_b_persisted_ = true;
+  used_persisted_buffers = true;
+  return Status::OK();
+}
+
 template <typename T1>
 Status MatMulNBits<T1>::ComputeBPacked(const Tensor* a,
                                        const Tensor* scales,
@@ -10,6 +10,7 @@
 #endif
 
 #include <assert.h>
+#include <cstring>
 #include <functional>
 #include <string>
 #include <utility>
@@ -74,6 +75,50 @@ std::pair<Status, std::unique_ptr<GptSubgraph>> CreateGptSubgraphAndUpdateParame
 
   return std::make_pair(status, std::move(gpt_subgraph));
 }
+
+void CopyPastState(const Tensor& source, int source_row, int length, Tensor& target, int target_row) {
+  const TensorShape& source_shape = source.Shape();
+  const TensorShape& target_shape = target.Shape();
+  ORT_ENFORCE(source_shape.NumDimensions() == 5 && target_shape.NumDimensions() == 5);
+  ORT_ENFORCE(length <= source_shape[3] && length <= target_shape[3]);
+
+  const int64_t num_heads = source_shape[2];
+  const size_t head_size_bytes = SafeInt<size_t>(source_shape[4]) * source.DataType()->Size();
+  const size_t copy_bytes = SafeInt<size_t>(length) * head_size_bytes;
+  const auto* source_data = static_cast<const uint8_t*>(source.DataRaw());
+  auto* target_data = static_cast<uint8_t*>(target.MutableDataRaw());
+
+  // Both key (index 0) and value (index 1) of the batch entry
+  for (int64_t i = 0; i < 2; i++) {
+    for (int64_t head = 0; head < num_heads; head++) {
+      const int64_t source_head = (i * source_shape[1] + source_row) * num_heads + head;
+      const int64_t target_head = (i * target_shape[1] + target_row) * num_heads + head;
+      const size_t source_offset = SafeInt<size_t>(source_head) * source_shape[3] * head_size_bytes +
+                                   SafeInt<size_t>(source_shape[3] - length) * head_size_bytes;
+      const size_t target_offset = SafeInt<size_t>(target_head) * target_shape[3] * head_size_bytes +
+                                   SafeInt<size_t>(target_shape[3] - length) * head_size_bytes;
+      memcpy(target_data + target_offset, source_data + source_offset, copy_bytes);
+    }
+  }
+}
+
+void SlicePastState(const Tensor& source, int length, Tensor& target) {
+  const TensorShape& source_shape = source.Shape();
+  ORT_ENFORCE(source_shape.NumDimensions() == 5 && length <= source_shape[3]);
+  ORT_ENFORCE(target.Shape() == TensorShape({source_shape[0], source_shape[1], source_shape[2], length,
+                                             source_shape[4]}));
+
+  const size_t head_size_bytes = SafeInt<size_t>(source_shape[4]) * source.DataType()->Size();
+  const size_t source_stride = SafeInt<size_t>(source_shape[3]) * head_size_bytes;
+  const size_t target_stride = SafeInt<size_t>(length) * head_size_bytes;
+  const auto* source_data = static_cast<const uint8_t*>(source.DataRaw());
+  auto* target_data = static_cast<uint8_t*>(target.MutableDataRaw());
+
+  const size_t num_rows = SafeInt<size_t>(source_shape[0]) * source_shape[1] * source_shape[2];
+  for (size_t row = 0; row < num_rows; row++) {
+    memcpy(target_data + row * target_stride, source_data + row * source_stride, target_stride);
+  }
+}
 }  // namespace gpt_details
 
 void GreedySearch::Init(const OpKernelInfo& info) {
@@ -94,6 +139,11 @@ void GreedySearch::Init(const OpKernelInfo& info) {
     if (info.GetAttr<ONNX_NAMESPACE::GraphProto>("init_decoder", &proto).IsOK()) {
       has_init_decoder_ = true;
     }
+
+    // Check if the draft_decoder sub-graph attribute is present for speculative decoding.
+    if (info.GetAttr<ONNX_NAMESPACE::GraphProto>("draft_decoder", &proto).IsOK()) {
+      has_draft_decoder_ = true;
+    }
   }
 
   // Make sure the decoder sub-graph attribute is present for all model types.
@@ -132,6 +182,12 @@ Status GreedySearch::SetupSubgraphExecutionInfo(const SessionState& session_stat
 
       init_run_gpt_subgraph_ = std::move(res.second);
       init_run_decoder_feeds_fetches_manager_ = init_run_gpt_subgraph_->GetFeedsFetchesManager();
+    } else if (attribute_name == "draft_decoder") {
+      ORT_ENFORCE(draft_gpt_subgraph_ == nullptr, "SetupSubgraphExecutionInfo should only be called once for each subgraph.");
+      // The draft model has its own shape of past state, so 'parameters_' is not updated from it.
+      draft_gpt_subgraph_ = std::make_unique<GptSubgraph>(node, attribute_name, subgraph_session_state.GetGraphViewer());
+      ORT_RETURN_IF_ERROR(draft_gpt_subgraph_->Setup(session_state, subgraph_session_state));
+      draft_decoder_feeds_fetches_manager_ = draft_gpt_subgraph_->GetFeedsFetchesManager();
     }
   } else if (parameters_.model_type == IGenerationParameters::kModelTypeT5) {  // encoder-decoder like T5
     ORT_THROW("Not Implemented");
@@ -178,6 +234,12 @@ Status GreedySearch::Compute(OpKernelContext* ctx) const {
                 "past_present_share_buffer mode must be same for init decoder and decoder subgraphes");
   }
 
+  auto* draft_decoder_session_state = ctx_internal->SubgraphSessionState("draft_decoder");
+  if (has_draft_decoder_) {
+    ORT_ENFORCE(draft_decoder_session_state, "Subgraph SessionState was not found for 'draft_decoder' attribute.");
+    ORT_ENFORCE(draft_decoder_feeds_fetches_manager_, "CreateFeedsFetchesManager must be called prior to execution of graph.");
+  }
+
   concurrency::ThreadPool* thread_pool = ctx->GetOperatorThreadPool();
 
   // make a copy since we will update the parameters based on inputs later
@@ -206,6 +268,11 @@ Status GreedySearch::Compute(OpKernelContext* ctx) const {
 #ifdef USE_CUDA
       ORT_RETURN_IF_ERROR(impl.InitializeCuda(reorder_past_state_func_, cuda_device_prop_, cuda_device_arch_));
 #endif
+      if (has_draft_decoder_) {
+        ORT_RETURN_IF_ERROR(impl.InitializeSpeculativeDecoding(draft_decoder_session_state,
+                                                               draft_gpt_subgraph_.get(),
+                                                               draft_decoder_feeds_fetches_manager_));
+      }
       ORT_RETURN_IF_ERROR(impl.Initialize());
 
       return impl.Execute(init_run_decoder_feeds_fetches_manager_, *decoder_feeds_fetches_manager_);
@@ -230,6 +297,11 @@ Status GreedySearch::Compute(OpKernelContext* ctx) const {
 #ifdef USE_CUDA
       ORT_RETURN_IF_ERROR(impl.InitializeCuda(reorder_past_state_func_, cuda_device_prop_, cuda_device_arch_));
 #endif
+      if (has_draft_decoder_) {
+        ORT_RETURN_IF_ERROR(impl.InitializeSpeculativeDecoding(draft_decoder_session_state,
+                                                               draft_gpt_subgraph_.get(),
+                                                               draft_decoder_feeds_fetches_manager_));
+      }
       ORT_RETURN_IF_ERROR(impl.Initialize());
 
       return impl.Execute(init_run_decoder_feeds_fetches_manager_, *decoder_feeds_fetches_manager_);
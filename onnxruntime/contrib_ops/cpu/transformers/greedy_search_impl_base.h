@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #pragma once
+#include <algorithm>
 #include <random>
 #include <vector>
 #include "contrib_ops/cpu/transformers/generation_shared.h"
@@ -192,6 +193,18 @@ class GreedySearchBase : public GenerateBase {
                            int counter,
                            int eos_token_id);
 
+  // Select next tokens from logits with shape (batch_size, num_draft_tokens + 1, vocab_size) computed for the last
+  // token followed by the draft tokens (batch_size, num_draft_tokens), and append them to the sequences. It stops after
+  // the first position where a selected token differs from the draft token of an unfinished sequence, so the
+  // sequences are the same as when the tokens are generated one at a time.
+  Status AcceptDraftTokens(const OrtValue& logits,
+                           gsl::span<const int32_t> draft_tokens,
+                           int num_draft_tokens,
+                           GreedySearchState<T>& greedy_state,
+                           ISamplingState<T>& sampling_state,
+                           int counter,
+                           int& num_appended_tokens);
+
   // Calculate scores from logits, then apply filtering and select next token for each beam.
   Status ProcessLogits(const OrtValue& logits,  // logits output of subgraph
                        GreedySearchState<T>& greedy_state,
@@ -219,6 +232,19 @@ Status GreedySearchBase<T, ParametersT>::CheckInputs(const OpKernelContextIntern
                                             context.Input<Tensor>(7),     // presence_mask
                                             context.Input<Tensor>(10)));  // decoder_input_ids
 
+  if (parameters_->max_active_sequences > 0) {
+    if (this->IsCuda()) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                             "max_active_sequences is only supported by the CPU execution provider");
+    }
+
+    // Rows of the decoding batch change between steps, so masks given per batch entry cannot be applied
+    if (!parameters_->prefix_vocab_mask.empty() || !parameters_->presence_mask.empty()) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "prefix_vocab_mask and presence_mask are not supported with max_active_sequences");
+    }
+  }
+
   return Status::OK();
 }
 
@@ -285,6 +311,66 @@ Status GreedySearchBase<T, ParametersT>::GenerateNextToken(
   return Status::OK();
 }
 
+template <typename T, typename ParametersT>
+Status GreedySearchBase<T, ParametersT>::AcceptDraftTokens(
+    const OrtValue& logits,
+    gsl::span<const int32_t> draft_tokens,
+    int num_draft_tokens,
+    GreedySearchState<T>& greedy_state,
+    ISamplingState<T>& sampling_state,
+    int counter,
+    int& num_appended_tokens) {
+  const Tensor& logits_tensor = logits.Get<Tensor>();
+  const TensorShape& logits_shape = logits_tensor.Shape();
+  ORT_RETURN_IF_NOT(logits_shape.NumDimensions() == 3 && logits_shape[1] == num_draft_tokens + 1,
+                    "logits shall have shape (batch_size, ", num_draft_tokens + 1, ", vocab_size), got ",
+                    logits_shape);
+  const int64_t batch_size = logits_shape[0];
+  const int64_t input_length = logits_shape[1];
+  const int64_t vocab_size = logits_shape[2];
+  ORT_RETURN_IF_NOT(draft_tokens.size() == static_cast<size_t>(batch_size * num_draft_tokens),
+                    "draft_tokens shall have batch_size * num_draft_tokens elements");
+
+  // Logits of one position for each sequence
+  OrtValue step_logits;
+  Tensor::InitOrtValue(logits_tensor.DataType(), TensorShape{batch_size, 1, vocab_size},
+                       this->temp_space_allocator_, step_logits);
+  const T* logits_data = logits_tensor.Data<T>();
+  T* step_logits_data = step_logits.GetMutable<Tensor>()->MutableData<T>();
+
+  num_appended_tokens = 0;
+  for (int i = 0; i <= num_draft_tokens; i++) {
+    for (int64_t batch_id = 0; batch_id < batch_size; batch_id++) {
+      const size_t source_offset = (SafeInt<size_t>(batch_id) * input_length + i) * vocab_size;
+      const size_t target_offset = SafeInt<size_t>(batch_id) * vocab_size;
+      std::copy_n(logits_data + source_offset, vocab_size, step_logits_data + target_offset);
+    }
+
+    gsl::span<int32_t> next_tokens;
+    ORT_RETURN_IF_ERROR(GenerateNextToken(step_logits, next_tokens, greedy_state, sampling_state, counter + i,
+                                          parameters_->eos_token_id));
+    ++num_appended_tokens;
+    if (i == num_draft_tokens) {
+      break;
+    }
+
+    // Finished sequences only append padding, so they accept any draft token.
+    bool accepted = true;
+    bool all_finished = true;
+    for (int64_t batch_id = 0; batch_id < batch_size; batch_id++) {
+      if (!greedy_state.eos_meet[batch_id]) {
+        all_finished = false;
+        accepted = accepted && next_tokens[batch_id] == draft_tokens[batch_id * num_draft_tokens + i];
+      }
+    }
+    if (!accepted || all_finished) {
+      break;
+    }
+  }
+
+  return Status::OK();
+}
+
 }  // namespace transformers
 }  // namespace contrib
 }  // namespace onnxruntime
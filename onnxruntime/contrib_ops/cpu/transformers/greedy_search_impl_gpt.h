@@ -3,6 +3,8 @@
 
 #pragma once
 #include <algorithm>
+#include <cstring>
+#include <limits>
 #include <vector>
 
 #include "core/common/span_utils.h"
@@ -21,6 +23,14 @@ std::pair<Status, std::unique_ptr<GptSubgraph>> CreateGptSubgraphAndUpdateParame
     const std::string& attribute_name,
     const SessionState& subgraph_session_state,
     /*out*/ BeamSearchParameters& parameters);
+
+// Copy the last `length` positions of batch entry `source_row` of a past state with shape
+// (2, batch_size, num_heads, past_sequence_length, head_size) to the last positions of entry `target_row` of `target`.
+void CopyPastState(const Tensor& source, int source_row, int length, Tensor& target, int target_row);
+
+// Copy the first `length` positions of a past state with shape
+// (2, batch_size, num_heads, past_sequence_length, head_size) to `target` with past_sequence_length of `length`.
+void SlicePastState(const Tensor& source, int length, Tensor& target);
 }  // namespace gpt_details
 
 // Greedy search implementation for GPT-2 model.
@@ -79,12 +89,40 @@ class GreedySearchGpt : public GreedySearchBase<T, ParametersT> {
   }
 #endif
 
+  // Use a draft decoder to propose tokens that are verified by the decoder in one run.
+  Status InitializeSpeculativeDecoding(const SessionState* draft_decoder_session_state,
+                                       GptSubgraph* draft_gpt_subgraph,
+                                       const FeedsFetchesManager* draft_feeds_fetches_manager) {
+    ORT_RETURN_IF_NOT(draft_gpt_subgraph->vocab_size == gpt_subgraph_.vocab_size,
+                      "draft_decoder shall have the same vocabulary size as decoder. Got ",
+                      draft_gpt_subgraph->vocab_size, " and ", gpt_subgraph_.vocab_size);
+    ORT_RETURN_IF_NOT(draft_gpt_subgraph->IsOutputFloat16() == gpt_subgraph_.IsOutputFloat16(),
+                      "draft_decoder shall have the same logits type as decoder");
+    draft_decoder_session_state_ = draft_decoder_session_state;
+    draft_gpt_subgraph_ = draft_gpt_subgraph;
+    draft_feeds_fetches_manager_ = draft_feeds_fetches_manager;
+    return Status::OK();
+  }
+
   // Execute beam search in iterations util stopping criteria is reached.
   // In each iteration, GPT subgraph is called, and next token for each sequence is generated.
   Status Execute(const FeedsFetchesManager* init_run_feeds_fetches_manager,
                  const FeedsFetchesManager& feeds_fetches_manager);
 
  private:
+  // A request of input_ids that is being decoded in continuous batching mode.
+  struct ActiveSequence {
+    int request;        // row of input_ids and sequences
+    int prompt_tokens;  // number of non-padding tokens of the request
+    int generated;      // number of tokens generated so far
+    int32_t last_token;
+  };
+
+  // Execute with at most max_active_sequences sequences per decoding step. Finished sequences are evicted and
+  // pending requests are admitted between steps, and the past state is repacked when the batch changes.
+  Status ExecuteContinuousBatching(const FeedsFetchesManager* init_run_feeds_fetches_manager,
+                                   const FeedsFetchesManager& feeds_fetches_manager);
+
   // Prepare the inputs for first inference of subgraph
   Status CreateInitialFeeds(gsl::span<int32_t>& sequence_lengths,
                             OrtValue& expanded_input_ids,
@@ -101,10 +139,18 @@ class GreedySearchGpt : public GreedySearchBase<T, ParametersT> {
       gsl::span<const int32_t> next_tokens,
       int past_sequence_length);
 
+  // Execute with the draft decoder proposing num_speculative_tokens tokens per run of the decoder.
+  Status ExecuteSpeculativeDecoding(const FeedsFetchesManager* init_run_feeds_fetches_manager,
+                                    const FeedsFetchesManager& feeds_fetches_manager);
+
   const SessionState* init_run_decoder_session_state_ = nullptr;
   GptSubgraph* init_run_gpt_subgraph_ = nullptr;
   GptSubgraph& gpt_subgraph_;
 
+  const SessionState* draft_decoder_session_state_ = nullptr;
+  GptSubgraph* draft_gpt_subgraph_ = nullptr;
+  const FeedsFetchesManager* draft_feeds_fetches_manager_ = nullptr;
+
   // Device specific functions
   GenerationDeviceHelper::CreateGptInputsFunc create_inputs_func_;
   GenerationDeviceHelper::AddToFeedsFunc add_to_feeds_func_;
@@ -190,6 +236,14 @@ Status GreedySearchGpt<T, ParametersT>::UpdateFeeds(
 template <typename T, typename ParametersT>
 Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_run_feeds_fetches_manager,
                                                 const FeedsFetchesManager& feeds_fetches_manager) {
+  if (draft_gpt_subgraph_ != nullptr) {
+    return ExecuteSpeculativeDecoding(init_run_feeds_fetches_manager, feeds_fetches_manager);
+  }
+
+  if (this->parameters_->max_active_sequences > 0) {
+    return ExecuteContinuousBatching(init_run_feeds_fetches_manager, feeds_fetches_manager);
+  }
+
   auto status = Status::OK();
   const ParametersT* parameters = this->parameters_;
 
@@ -410,6 +464,606 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
   return status;
 }
 
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::ExecuteContinuousBatching(
+    const FeedsFetchesManager* init_run_feeds_fetches_manager,
+    const FeedsFetchesManager& feeds_fetches_manager) {
+  if (gpt_subgraph_.past_present_share_buffer_ || gpt_subgraph_.has_decoder_masked_attention_) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "max_active_sequences is not supported when past and present share buffer");
+  }
+
+  ParametersT* parameters = this->parameters_;
+  const int num_requests = parameters->batch_size;
+  const int sequence_length = parameters->sequence_length;
+  const int max_length = parameters->max_length;
+  const int vocab_size = parameters->vocab_size;
+  const int max_active_sequences = std::min(parameters->max_active_sequences, num_requests);
+  const int first_past_input_index = gpt_subgraph_.GetFirstPastInputIndex();
+  const int first_present_output_index = gpt_subgraph_.GetFirstPresentOutputIndex();
+  const int num_layers = gpt_subgraph_.num_layers;
+
+  // The min length processor only knows the length of the longest sequence of the batch, so min_length is applied
+  // per sequence below instead.
+  const int min_length = parameters->min_length;
+  parameters->min_length = 0;
+
+  const Tensor& input_ids = this->context_.GetInputOrtValue(0)->Get<Tensor>();
+  const OrtValue* attn_mask_value = this->context_.GetInputOrtValue(6);
+  const int32_t* input_ids_data = input_ids.Data<int32_t>();
+  const int32_t* attn_mask_data = attn_mask_value != nullptr ? attn_mask_value->Get<Tensor>().Data<int32_t>()
+                                                             : nullptr;
+  auto prompt_mask = [&](int request, int position) -> int32_t {
+    const size_t index = SafeInt<size_t>(request) * sequence_length + position;
+    if (attn_mask_data != nullptr) {
+      return attn_mask_data[index];
+    }
+    return input_ids_data[index] == parameters->pad_token_id ? 0 : 1;
+  };
+
+  // Each row of the output starts with its request, and is padded after the generated tokens.
+  int64_t sequences_dims[] = {num_requests, max_length};
+  TensorShape sequences_shape(&sequences_dims[0], sizeof(sequences_dims) / sizeof(sequences_dims[0]));
+  Tensor* output_sequences = this->context_.Output(0, sequences_shape);
+  gsl::span<int32_t> output = output_sequences->MutableDataAsSpan<int32_t>();
+  for (int request = 0; request < num_requests; request++) {
+    const size_t row_offset = SafeInt<size_t>(request) * max_length;
+    const size_t input_offset = SafeInt<size_t>(request) * sequence_length;
+    int32_t* row = output.data() + row_offset;
+    std::copy_n(input_ids_data + input_offset, sequence_length, row);
+    std::fill(row + sequence_length, row + max_length, parameters->pad_token_id);
+  }
+
+  // States are sized for the largest decoding batch. Only the leading entries are used when the batch is smaller.
+  GreedySearchState<T> greedy_state;
+  greedy_state.Init(this->cpu_allocator_,
+                    this->temp_space_allocator_,
+                    max_active_sequences,
+                    vocab_size,
+                    sequence_length,
+                    max_length,
+                    static_cast<int>(parameters->num_heads),
+                    static_cast<int>(parameters->head_size),
+                    false,
+                    false,
+                    this->ort_stream_);
+
+  SamplingState<T> sampling_state;
+  if (std::is_same<ParametersT, SamplingParameters>::value) {
+    sampling_state.Init(this->temp_space_allocator_,
+                        this->cpu_allocator_,
+                        max_active_sequences,
+                        vocab_size,
+                        max_length - sequence_length,
+                        parameters->seed,
+                        false,
+                        this->ort_stream_);
+  }
+
+  AllocatorPtr allocator = this->temp_space_allocator_;
+  auto int32_type = DataTypeImpl::GetType<int32_t>();
+  std::vector<int32_t> prompt_lengths(max_active_sequences);
+  std::vector<int> row_lengths;  // tokens in the sequence of each row of the decoding batch
+
+  // Sequences of the decoding batch in the order of its rows: the ones continued from the previous step, then the
+  // admitted ones. Their past state is padded on the left to past_length.
+  std::vector<ActiveSequence> active;
+  std::vector<OrtValue> past(num_layers);
+  int past_length = 0;
+
+  std::vector<OrtValue> feeds;
+  std::vector<OrtValue> decoder_fetches;
+  std::vector<OrtValue> prompt_fetches;
+  int processors_batch_size = 0;
+  int next_request = 0;
+  int iteration_counter = 0;
+  while (!active.empty() || next_request < num_requests) {
+    ++iteration_counter;
+    const int num_continued = static_cast<int>(active.size());
+    const int num_admitted = std::min(max_active_sequences - num_continued, num_requests - next_request);
+
+    // Feed the last generated token of the continued sequences.
+    if (num_continued > 0) {
+      OrtValue step_input_ids;
+      OrtValue step_position_ids;
+      OrtValue step_attention_mask;
+      const int total_length = past_length + 1;
+      Tensor::InitOrtValue(int32_type, TensorShape{num_continued, 1}, allocator, step_input_ids);
+      Tensor::InitOrtValue(int32_type, TensorShape{num_continued, 1}, allocator, step_position_ids);
+      Tensor::InitOrtValue(int32_type, TensorShape{num_continued, total_length}, allocator, step_attention_mask);
+      int32_t* step_input_ids_data = step_input_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+      int32_t* step_position_ids_data = step_position_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+      int32_t* step_attention_mask_data = step_attention_mask.GetMutable<Tensor>()->MutableData<int32_t>();
+      for (int i = 0; i < num_continued; i++) {
+        const ActiveSequence& sequence = active[i];
+        step_input_ids_data[i] = sequence.last_token;
+        step_position_ids_data[i] = sequence.prompt_tokens + sequence.generated - 1;
+
+        // mask: padding of the batch, the prompt mask, then the generated tokens
+        const size_t mask_offset = SafeInt<size_t>(i) * total_length;
+        int32_t* mask = step_attention_mask_data + mask_offset;
+        const int padding = past_length - (sequence_length + sequence.generated - 1);
+        std::fill_n(mask, padding, 0);
+        for (int j = 0; j < sequence_length; j++) {
+          mask[padding + j] = prompt_mask(sequence.request, j);
+        }
+        std::fill(mask + padding + sequence_length, mask + total_length, 1);
+      }
+
+      feeds[0] = step_input_ids;
+      feeds[1] = step_position_ids;
+      feeds[2] = step_attention_mask;
+      for (int layer = 0; layer < num_layers; layer++) {
+        feeds[static_cast<size_t>(first_past_input_index) + layer] = past[layer];
+      }
+
+      decoder_fetches.clear();
+      ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(this->decoder_session_state_,
+                                                 feeds_fetches_manager,
+                                                 feeds,
+                                                 decoder_fetches,
+                                                 {},
+                                                 ExecutionMode::ORT_SEQUENTIAL,
+                                                 this->context_.GetTerminateFlag(),
+                                                 this->context_.Logger(),
+                                                 this->ort_stream_));
+    }
+
+    // Run the prompts of the admitted requests, which are consecutive rows of input_ids.
+    if (num_admitted > 0) {
+      const size_t prompt_offset = SafeInt<size_t>(next_request) * sequence_length;
+      TensorShape prompt_shape{num_admitted, sequence_length};
+      OrtValue prompt_input_ids;
+      Tensor::InitOrtValue(int32_type, prompt_shape, const_cast<int32_t*>(input_ids_data) + prompt_offset,
+                           input_ids.Location(), prompt_input_ids);
+      OrtValue prompt_attention_mask;
+      if (attn_mask_value != nullptr) {
+        Tensor::InitOrtValue(int32_type, prompt_shape, const_cast<int32_t*>(attn_mask_data) + prompt_offset,
+                             attn_mask_value->Get<Tensor>().Location(), prompt_attention_mask);
+      }
+
+      GptSubgraph& prompt_subgraph = init_run_gpt_subgraph_ != nullptr ? *init_run_gpt_subgraph_ : gpt_subgraph_;
+      std::vector<OrtValue> prompt_feeds;
+      gsl::span<int32_t> sequence_lengths = gsl::make_span(prompt_lengths.data(), num_admitted);
+      IAllocatorUniquePtr<char> buffer;
+      OrtValue expanded_input_ids;
+      ORT_RETURN_IF_ERROR(prompt_subgraph.CreateInitialFeeds(prompt_input_ids.Get<Tensor>(),
+                                                             this->implicit_inputs_,
+                                                             1,
+                                                             parameters->pad_token_id,
+                                                             sequence_lengths,
+                                                             expanded_input_ids,
+                                                             attn_mask_value != nullptr ? &prompt_attention_mask
+                                                                                        : nullptr,
+                                                             prompt_feeds,
+                                                             this->create_inputs_func_,
+                                                             this->add_to_feeds_func_,
+                                                             buffer,
+                                                             this->ort_stream_,
+                                                             max_length));
+
+      prompt_fetches.clear();
+      if (init_run_decoder_session_state_ != nullptr) {
+        ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(*init_run_decoder_session_state_,
+                                                   *init_run_feeds_fetches_manager,
+                                                   prompt_feeds,
+                                                   prompt_fetches,
+                                                   {},
+                                                   ExecutionMode::ORT_SEQUENTIAL,
+                                                   this->context_.GetTerminateFlag(),
+                                                   this->context_.Logger(),
+                                                   this->ort_stream_));
+      } else {
+        ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(this->decoder_session_state_,
+                                                   feeds_fetches_manager,
+                                                   prompt_feeds,
+                                                   prompt_fetches,
+                                                   {},
+                                                   ExecutionMode::ORT_SEQUENTIAL,
+                                                   this->context_.GetTerminateFlag(),
+                                                   this->context_.Logger(),
+                                                   this->ort_stream_));
+      }
+
+      // Later decoding steps reuse the implicit inputs of these feeds.
+      if (feeds.empty()) {
+        feeds = std::move(prompt_feeds);
+      }
+
+      for (int i = 0; i < num_admitted; i++) {
+        active.push_back(ActiveSequence{next_request + i, prompt_lengths[i], 0, parameters->pad_token_id});
+      }
+      next_request += num_admitted;
+    }
+
+    // Logits of the last token of each row: (batch_size, input_length, vocab_size)
+    const int batch_size = num_continued + num_admitted;
+    OrtValue logits;
+    if (num_admitted == 0) {
+      logits = decoder_fetches[0];
+    } else if (num_continued == 0) {
+      logits = prompt_fetches[0];
+    } else {
+      Tensor::InitOrtValue(DataTypeImpl::GetType<T>(), TensorShape{batch_size, 1, vocab_size}, allocator, logits);
+      T* logits_data = logits.GetMutable<Tensor>()->MutableData<T>();
+      const T* decoder_logits = decoder_fetches[0].Get<Tensor>().Data<T>();
+      const size_t decoder_logits_size = SafeInt<size_t>(num_continued) * vocab_size;
+      std::copy_n(decoder_logits, decoder_logits_size, logits_data);
+      const T* prompt_logits = prompt_fetches[0].Get<Tensor>().Data<T>();
+      for (int i = 0; i < num_admitted; i++) {
+        const size_t source_offset = (SafeInt<size_t>(i) * sequence_length + sequence_length - 1) * vocab_size;
+        const size_t target_offset = decoder_logits_size + SafeInt<size_t>(i) * vocab_size;
+        std::copy_n(prompt_logits + source_offset, vocab_size, logits_data + target_offset);
+      }
+    }
+
+    if (min_length > 0) {
+      Tensor* logits_tensor = logits.GetMutable<Tensor>();
+      const int64_t input_length = logits_tensor->Shape()[1];
+      T* logits_data = logits_tensor->MutableData<T>();
+      for (int i = 0; i < batch_size; i++) {
+        if (sequence_length + active[i].generated < min_length) {
+          const size_t eos_offset = (SafeInt<size_t>(i) * input_length + input_length - 1) * vocab_size +
+                                    parameters->eos_token_id;
+          logits_data[eos_offset] = T(std::numeric_limits<float>::lowest());
+        }
+      }
+    }
+
+    // Sequences of the batch rows for the logits processors. Each row keeps its own length rather than being padded
+    // to the longest one, so the repetition penalty and the n-gram blocking only see the tokens of its request.
+    row_lengths.resize(batch_size);
+    int current_length = 0;
+    const size_t sequences_size = SafeInt<size_t>(batch_size) * max_length;
+    gsl::span<int32_t> sequences_space = greedy_state.sequences_space.subspan(0, sequences_size + sequences_size);
+    for (int i = 0; i < batch_size; i++) {
+      const ActiveSequence& sequence = active[i];
+      const int length = sequence_length + sequence.generated;
+      const size_t row_offset = SafeInt<size_t>(i) * max_length;
+      const size_t output_offset = SafeInt<size_t>(sequence.request) * max_length;
+      std::copy_n(output.data() + output_offset, length, sequences_space.data() + row_offset);
+      row_lengths[i] = length;
+      current_length = std::max(current_length, length);
+    }
+    greedy_state.sequences.Init(sequences_space, batch_size, current_length, max_length);
+    greedy_state.sequences.SetSequenceLengths(row_lengths);
+
+    parameters->batch_size = batch_size;
+    if (processors_batch_size != batch_size) {
+      this->logits_processors_.Init(*parameters);
+      processors_batch_size = batch_size;
+    }
+
+    std::fill(greedy_state.eos_meet.begin(), greedy_state.eos_meet.end(), false);
+    gsl::span<int32_t> next_tokens;
+    ORT_RETURN_IF_ERROR(this->GenerateNextToken(logits,
+                                                next_tokens,
+                                                greedy_state,
+                                                sampling_state,
+                                                iteration_counter,
+                                                parameters->eos_token_id));
+
+    // Append the tokens to the output, and evict the finished sequences.
+    std::vector<int> kept_rows;
+    std::vector<int> kept_lengths;  // tokens in the past state of the kept rows
+    for (int i = 0; i < batch_size; i++) {
+      ActiveSequence& sequence = active[i];
+      const int length = sequence_length + sequence.generated;
+      const size_t token_offset = SafeInt<size_t>(sequence.request) * max_length + length;
+      output[token_offset] = next_tokens[i];
+      sequence.generated++;
+      sequence.last_token = next_tokens[i];
+      if (greedy_state.eos_meet[i] || length + 1 == max_length) {
+        continue;
+      }
+      kept_rows.push_back(i);
+      kept_lengths.push_back(length);
+    }
+
+    if (num_admitted == 0 && static_cast<int>(kept_rows.size()) == batch_size) {
+      // The batch is unchanged so the present state is the past state of the next step.
+      for (int layer = 0; layer < num_layers; layer++) {
+        past[layer] = decoder_fetches[static_cast<size_t>(first_present_output_index) + layer];
+      }
+      ++past_length;
+    } else if (!kept_rows.empty()) {
+      const int next_past_length = *std::max_element(kept_lengths.begin(), kept_lengths.end());
+      const size_t num_kept = kept_rows.size();
+      for (int layer = 0; layer < num_layers; layer++) {
+        const size_t present_index = static_cast<size_t>(first_present_output_index) + layer;
+        const Tensor* decoder_present = num_continued > 0 ? &decoder_fetches[present_index].Get<Tensor>() : nullptr;
+        const Tensor* prompt_present = num_admitted > 0 ? &prompt_fetches[present_index].Get<Tensor>() : nullptr;
+        const Tensor& any_present = decoder_present != nullptr ? *decoder_present : *prompt_present;
+
+        OrtValue next_past;
+        TensorShape next_past_shape{2, static_cast<int64_t>(num_kept), any_present.Shape()[2], next_past_length,
+                                    any_present.Shape()[4]};
+        Tensor::InitOrtValue(any_present.DataType(), next_past_shape, allocator, next_past);
+        Tensor* next_past_tensor = next_past.GetMutable<Tensor>();
+        memset(next_past_tensor->MutableDataRaw(), 0, next_past_tensor->SizeInBytes());
+        for (size_t i = 0; i < num_kept; i++) {
+          const int row = kept_rows[i];
+          if (row < num_continued) {
+            gpt_details::CopyPastState(*decoder_present, row, kept_lengths[i], *next_past_tensor, static_cast<int>(i));
+          } else {
+            gpt_details::CopyPastState(*prompt_present, row - num_continued, kept_lengths[i], *next_past_tensor,
+                                       static_cast<int>(i));
+          }
+        }
+        past[layer] = next_past;
+      }
+      past_length = next_past_length;
+    }
+
+    std::vector<ActiveSequence> kept;
+    kept.reserve(kept_rows.size());
+    for (int row : kept_rows) {
+      kept.push_back(active[row]);
+    }
+    active = std::move(kept);
+  }
+
+  return Status::OK();
+}
+
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::ExecuteSpeculativeDecoding(
+    const FeedsFetchesManager* init_run_feeds_fetches_manager,
+    const FeedsFetchesManager& feeds_fetches_manager) {
+  if (this->IsCuda() || std::is_same<ParametersT, SamplingParameters>::value) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "draft_decoder is only supported by GreedySearch on the CPU execution provider");
+  }
+  if (gpt_subgraph_.past_present_share_buffer_ || draft_gpt_subgraph_->past_present_share_buffer_) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "draft_decoder is not supported when past and present share buffer");
+  }
+  if (this->parameters_->max_active_sequences > 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "draft_decoder cannot be used with max_active_sequences");
+  }
+
+  const ParametersT* parameters = this->parameters_;
+  const int batch_size = parameters->batch_size;
+  const int sequence_length = parameters->sequence_length;
+  const int max_length = parameters->max_length;
+
+  // Allocate output tensors.
+  int64_t sequences_dims[] = {batch_size, max_length};
+  TensorShape sequences_shape(&sequences_dims[0], sizeof(sequences_dims) / sizeof(sequences_dims[0]));
+  Tensor* output_sequences = this->context_.Output(0, sequences_shape);
+
+  GreedySearchState<T> greedy_state;
+  greedy_state.Init(this->cpu_allocator_,
+                    this->temp_space_allocator_,
+                    batch_size,
+                    static_cast<int>(parameters->vocab_size),
+                    sequence_length,
+                    max_length,
+                    static_cast<int>(parameters->num_heads),
+                    static_cast<int>(parameters->head_size),
+                    false,
+                    false,
+                    this->ort_stream_);
+  SamplingState<T> sampling_state;  // not used by greedy search
+
+  std::vector<OrtValue> feeds;
+  IAllocatorUniquePtr<char> buffer;
+  OrtValue expanded_input_ids_in_cpu;
+  ORT_RETURN_IF_ERROR(CreateInitialFeeds(greedy_state.sequence_lengths, expanded_input_ids_in_cpu, feeds, buffer));
+  greedy_state.SetSequence(expanded_input_ids_in_cpu.Get<Tensor>().DataAsSpan<int32_t>(),
+                           static_cast<size_t>(batch_size),
+                           max_length,
+                           sequence_length);
+
+  // Inputs after the prompt have the attention mask of the prompt followed by ones, and the positions continue from
+  // the number of non-padding tokens of the prompt.
+  gsl::span<const int32_t> prompt_mask_span = feeds[2].Get<Tensor>().DataAsSpan<int32_t>();
+  const std::vector<int32_t> prompt_mask(prompt_mask_span.begin(), prompt_mask_span.end());
+  const std::vector<int32_t> prompt_lengths(greedy_state.sequence_lengths.begin(), greedy_state.sequence_lengths.end());
+
+  std::vector<OrtValue> draft_feeds;
+  IAllocatorUniquePtr<char> draft_buffer;
+  OrtValue draft_expanded_input_ids;
+  std::vector<int32_t> draft_sequence_lengths(batch_size);
+  gsl::span<int32_t> draft_sequence_lengths_span(draft_sequence_lengths);
+  ORT_RETURN_IF_ERROR(draft_gpt_subgraph_->CreateInitialFeeds(this->context_.GetInputOrtValue(0)->Get<Tensor>(),
+                                                              this->implicit_inputs_,
+                                                              1,
+                                                              parameters->pad_token_id,
+                                                              draft_sequence_lengths_span,
+                                                              draft_expanded_input_ids,
+                                                              this->context_.GetInputOrtValue(6),
+                                                              draft_feeds,
+                                                              this->create_inputs_func_,
+                                                              this->add_to_feeds_func_,
+                                                              draft_buffer,
+                                                              this->ort_stream_,
+                                                              max_length));
+
+  AllocatorPtr allocator = this->temp_space_allocator_;
+  auto int32_type = DataTypeImpl::GetType<int32_t>();
+
+  auto run_subgraph = [&](const SessionState& session_state,
+                          const FeedsFetchesManager& subgraph_feeds_fetches_manager,
+                          std::vector<OrtValue>& subgraph_feeds,
+                          std::vector<OrtValue>& fetches) {
+    fetches.clear();
+    return utils::ExecuteSubgraph(session_state,
+                                  subgraph_feeds_fetches_manager,
+                                  subgraph_feeds,
+                                  fetches,
+                                  {},
+                                  ExecutionMode::ORT_SEQUENTIAL,
+                                  this->context_.GetTerminateFlag(),
+                                  this->context_.Logger(),
+                                  this->ort_stream_);
+  };
+
+  // Set inputs that feed tokens with shape (batch_size, num_tokens) after past_length tokens of past state.
+  auto update_feeds = [&](std::vector<OrtValue>& subgraph_feeds,
+                          int first_past_input_index,
+                          const std::vector<OrtValue>& past,
+                          int past_length,
+                          gsl::span<const int32_t> tokens,
+                          int num_tokens) {
+    const int total_length = past_length + num_tokens;
+    OrtValue step_input_ids;
+    OrtValue step_position_ids;
+    OrtValue step_attention_mask;
+    Tensor::InitOrtValue(int32_type, TensorShape{batch_size, num_tokens}, allocator, step_input_ids);
+    Tensor::InitOrtValue(int32_type, TensorShape{batch_size, num_tokens}, allocator, step_position_ids);
+    Tensor::InitOrtValue(int32_type, TensorShape{batch_size, total_length}, allocator, step_attention_mask);
+    int32_t* step_input_ids_data = step_input_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+    int32_t* step_position_ids_data = step_position_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+    int32_t* step_attention_mask_data = step_attention_mask.GetMutable<Tensor>()->MutableData<int32_t>();
+    for (int i = 0; i < batch_size; i++) {
+      for (int j = 0; j < num_tokens; j++) {
+        step_input_ids_data[i * num_tokens + j] = tokens[static_cast<size_t>(i) * num_tokens + j];
+        step_position_ids_data[i * num_tokens + j] = prompt_lengths[i] + past_length - sequence_length + j;
+      }
+      int32_t* mask = step_attention_mask_data + static_cast<size_t>(i) * total_length;
+      std::copy_n(prompt_mask.data() + static_cast<size_t>(i) * sequence_length, sequence_length, mask);
+      std::fill(mask + sequence_length, mask + total_length, 1);
+    }
+
+    subgraph_feeds[0] = step_input_ids;
+    subgraph_feeds[1] = step_position_ids;
+    subgraph_feeds[2] = step_attention_mask;
+    for (size_t layer = 0; layer < past.size(); layer++) {
+      subgraph_feeds[static_cast<size_t>(first_past_input_index) + layer] = past[layer];
+    }
+  };
+
+  // Keep the first past_length positions of the present state as the past state of the next run.
+  auto update_past = [&](const std::vector<OrtValue>& fetches,
+                         int first_present_output_index,
+                         int past_length,
+                         std::vector<OrtValue>& past) {
+    for (size_t layer = 0; layer < past.size(); layer++) {
+      const OrtValue& present = fetches[static_cast<size_t>(first_present_output_index) + layer];
+      const Tensor& present_tensor = present.Get<Tensor>();
+      if (present_tensor.Shape()[3] == past_length) {
+        past[layer] = present;
+        continue;
+      }
+      const TensorShape& shape = present_tensor.Shape();
+      OrtValue sliced;
+      Tensor::InitOrtValue(present_tensor.DataType(), TensorShape{shape[0], shape[1], shape[2], past_length, shape[4]},
+                           allocator, sliced);
+      gpt_details::SlicePastState(present_tensor, past_length, *sliced.GetMutable<Tensor>());
+      past[layer] = sliced;
+    }
+  };
+
+  // Both models process the prompt, and the decoder generates the first token.
+  std::vector<OrtValue> fetches;
+  if (init_run_decoder_session_state_ != nullptr) {
+    ORT_RETURN_IF_ERROR(run_subgraph(*init_run_decoder_session_state_, *init_run_feeds_fetches_manager, feeds,
+                                     fetches));
+  } else {
+    ORT_RETURN_IF_ERROR(run_subgraph(this->decoder_session_state_, feeds_fetches_manager, feeds, fetches));
+  }
+  std::vector<OrtValue> past(gpt_subgraph_.num_layers);
+  int past_length = sequence_length;
+  update_past(fetches, gpt_subgraph_.GetFirstPresentOutputIndex(), past_length, past);
+
+  std::vector<OrtValue> draft_fetches;
+  ORT_RETURN_IF_ERROR(run_subgraph(*draft_decoder_session_state_, *draft_feeds_fetches_manager_, draft_feeds,
+                                   draft_fetches));
+  std::vector<OrtValue> draft_past(draft_gpt_subgraph_->num_layers);
+  int draft_past_length = sequence_length;
+  update_past(draft_fetches, draft_gpt_subgraph_->GetFirstPresentOutputIndex(), draft_past_length, draft_past);
+
+  int iteration_counter = 1;
+  gsl::span<int32_t> next_tokens;
+  ORT_RETURN_IF_ERROR(this->GenerateNextToken(fetches[0], next_tokens, greedy_state, sampling_state,
+                                              iteration_counter, parameters->eos_token_id));
+
+  std::vector<int32_t> tokens;
+  std::vector<int32_t> draft_tokens;
+  while (std::find(greedy_state.eos_meet.begin(), greedy_state.eos_meet.end(), false) != greedy_state.eos_meet.end()) {
+    const int current_length = greedy_state.sequences.GetSequenceLength();
+    if (current_length >= max_length) {
+      break;
+    }
+
+    // The draft tokens and the token selected after them shall fit in max_length.
+    const int num_draft_tokens = std::min(parameters->num_speculative_tokens, max_length - current_length - 1);
+
+    // The draft decoder proposes tokens greedily, starting from the generated tokens that it has not seen.
+    draft_tokens.resize(static_cast<size_t>(batch_size) * num_draft_tokens);
+    for (int i = 0; i < num_draft_tokens; i++) {
+      const int num_tokens = (i == 0) ? current_length - draft_past_length : 1;
+      tokens.resize(static_cast<size_t>(batch_size) * num_tokens);
+      for (int batch_id = 0; batch_id < batch_size; batch_id++) {
+        if (i == 0) {
+          gsl::span<const int32_t> sequence = greedy_state.sequences.GetSequence(batch_id);
+          std::copy_n(sequence.begin() + draft_past_length, num_tokens,
+                      tokens.begin() + static_cast<size_t>(batch_id) * num_tokens);
+        } else {
+          tokens[batch_id] = draft_tokens[static_cast<size_t>(batch_id) * num_draft_tokens + i - 1];
+        }
+      }
+
+      update_feeds(draft_feeds, draft_gpt_subgraph_->GetFirstPastInputIndex(), draft_past, draft_past_length, tokens,
+                   num_tokens);
+      ORT_RETURN_IF_ERROR(run_subgraph(*draft_decoder_session_state_, *draft_feeds_fetches_manager_, draft_feeds,
+                                       draft_fetches));
+      draft_past_length += num_tokens;
+      update_past(draft_fetches, draft_gpt_subgraph_->GetFirstPresentOutputIndex(), draft_past_length, draft_past);
+
+      const Tensor& draft_logits = draft_fetches[0].Get<Tensor>();
+      const int64_t logits_length = draft_logits.Shape()[1];
+      const int64_t vocab_size = draft_logits.Shape()[2];
+      for (int batch_id = 0; batch_id < batch_size; batch_id++) {
+        const size_t offset = (SafeInt<size_t>(batch_id) * logits_length + logits_length - 1) * vocab_size;
+        const T* scores = draft_logits.Data<T>() + offset;
+        draft_tokens[static_cast<size_t>(batch_id) * num_draft_tokens + i] =
+            static_cast<int32_t>(std::max_element(scores, scores + vocab_size) - scores);
+      }
+    }
+
+    // The decoder runs the last generated token and the draft tokens in one run.
+    const int num_tokens = num_draft_tokens + 1;
+    tokens.resize(static_cast<size_t>(batch_size) * num_tokens);
+    for (int batch_id = 0; batch_id < batch_size; batch_id++) {
+      const size_t offset = static_cast<size_t>(batch_id) * num_tokens;
+      tokens[offset] = greedy_state.sequences.GetSequence(batch_id)[current_length - 1];
+      std::copy_n(draft_tokens.begin() + static_cast<size_t>(batch_id) * num_draft_tokens, num_draft_tokens,
+                  tokens.begin() + offset + 1);
+    }
+    update_feeds(feeds, gpt_subgraph_.GetFirstPastInputIndex(), past, past_length, tokens, num_tokens);
+    ORT_RETURN_IF_ERROR(run_subgraph(this->decoder_session_state_, feeds_fetches_manager, feeds, fetches));
+
+    int num_appended_tokens = 0;
+    ORT_RETURN_IF_ERROR(this->AcceptDraftTokens(fetches[0], draft_tokens, num_draft_tokens, greedy_state,
+                                                sampling_state, iteration_counter + 1, num_appended_tokens));
+    iteration_counter += num_appended_tokens;
+
+    // Keep the past state of the last token and the accepted draft tokens, which are also the only draft tokens
+    // that the draft decoder may keep.
+    past_length += num_appended_tokens;
+    update_past(fetches, gpt_subgraph_.GetFirstPresentOutputIndex(), past_length, past);
+    if (draft_past_length > past_length) {
+      draft_past_length = past_length;
+      std::vector<OrtValue> draft_present = draft_past;
+      update_past(draft_present, 0, draft_past_length, draft_past);
+    }
+  }
+
+  // Copy the sequences to output, and pad after the generated tokens.
+  gsl::span<int32_t> output = output_sequences->MutableDataAsSpan<int32_t>();
+  for (int batch_id = 0; batch_id < batch_size; ++batch_id) {
+    auto batch_output = output.subspan(static_cast<size_t>(batch_id) * max_length, max_length);
+    gsl::span<const int32_t> sequence_source = greedy_state.sequences.GetSequence(batch_id);
+    gsl::copy(sequence_source, batch_output);
+    std::fill(batch_output.begin() + sequence_source.size(), batch_output.end(), parameters->pad_token_id);
+  }
+
+  return Status::OK();
+}
+
 }  // namespace transformers
 }  // namespace contrib
 }  // namespace onnxruntime
@@ -15,6 +15,10 @@ void GreedySearchParameters::ParseFromAttributes(const OpKernelInfo& info) {
   decoder_start_token_id = static_cast<int>(info.GetAttrOrDefault<int64_t>("decoder_start_token_id", -1));
   no_repeat_ngram_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("no_repeat_ngram_size", 0));
   vocab_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("vocab_size", -1));
+  max_active_sequences = static_cast<int>(info.GetAttrOrDefault<int64_t>("max_active_sequences", 0));
+  ORT_ENFORCE(max_active_sequences >= 0, "max_active_sequences shall not be negative, got ", max_active_sequences);
+  num_speculative_tokens = static_cast<int>(info.GetAttrOrDefault<int64_t>("num_speculative_tokens", 4));
+  ORT_ENFORCE(num_speculative_tokens > 0, "num_speculative_tokens shall be positive, got ", num_speculative_tokens);
 }
 
 void GreedySearchParameters::ParseFromInputs(OpKernelContext* context) {
@@ -16,6 +16,13 @@ struct GreedySearchParameters : public BeamSearchParameters {
   void ParseFromAttributes(const OpKernelInfo& info) override;
 
   void ParseFromInputs(OpKernelContext* context);
+
+  // When positive, at most this many sequences are decoded together. Finished sequences are evicted and the next
+  // requests of input_ids are admitted between decoding steps (continuous batching).
+  int max_active_sequences = 0;
+
+  // Number of tokens proposed by the draft decoder for each run of the decoder in speculative decoding.
+  int num_speculative_tokens = 4;
 };
 
 }  // namespace transformers
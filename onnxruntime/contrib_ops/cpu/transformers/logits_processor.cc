@@ -75,6 +75,9 @@ void NoRepeatNGramLogitsProcessor<T>::Process(const ISequences* sequences,
   for (int i = 0; i < batch_beam_size; i++) {
     gsl::span<T> beam_token_scores = next_token_scores.GetScores(i);
     gsl::span<const int32_t> sequence = sequences->GetSequence(i);
+    if (sequence.size() < static_cast<size_t>(ngram_size_)) {
+      continue;
+    }
 
     gsl::span<const int32_t> prefix = sequence.subspan(sequence.size() - prefix_length);
     ORT_ENFORCE(prefix.size() == narrow<size_t>(prefix_length));
@@ -19,6 +19,8 @@ void SamplingParameters::ParseFromAttributes(const OpKernelInfo& info) {
   presence_penalty = info.GetAttrOrDefault<float>("presence_penalty", 0.0f);
   custom_sampling = static_cast<int>(info.GetAttrOrDefault<int64_t>("custom", 0));
   vocab_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("vocab_size", -1));
+  max_active_sequences = static_cast<int>(info.GetAttrOrDefault<int64_t>("max_active_sequences", 0));
+  ORT_ENFORCE(max_active_sequences >= 0, "max_active_sequences shall not be negative, got ", max_active_sequences);
 }
 
 void SamplingParameters::ParseFromInputs(OpKernelContext* context) {
@@ -20,6 +20,7 @@ void Sequences::Init(gsl::span<int32_t> buffer, int batch_beam_size, int sequenc
   batch_beam_size_ = batch_beam_size;
   max_length_ = max_length;
   current_length_ = sequence_length;
+  sequence_lengths_ = {};
 }
 
 void Sequences::InitDevice(gsl::span<int32_t> buffer) {
@@ -29,13 +30,19 @@ void Sequences::InitDevice(gsl::span<int32_t> buffer) {
 
 gsl::span<const int32_t> Sequences::GetSequence(int beam_index) const {
   gsl::span<const int32_t> buffer = sequences[current_sequences_buffer];
-  return buffer.subspan(SafeInt<size_t>(beam_index) * max_length_, static_cast<gsl::index>(current_length_));
+  const int length = sequence_lengths_.empty() ? current_length_ : sequence_lengths_[beam_index];
+  return buffer.subspan(SafeInt<size_t>(beam_index) * max_length_, static_cast<gsl::index>(length));
 }
 
 int Sequences::GetSequenceLength() const {
   return current_length_;
 }
 
+void Sequences::SetSequenceLengths(gsl::span<const int> lengths) {
+  assert(lengths.size() == static_cast<size_t>(batch_beam_size_));
+  sequence_lengths_ = lengths;
+}
+
 #ifdef DEBUG_GENERATION
 void Sequences::PrintSequences(const IConsoleDumper* dumper) const {
   for (int i = 0; i < batch_beam_size_; i++) {
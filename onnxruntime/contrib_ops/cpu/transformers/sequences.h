@@ -25,6 +25,10 @@ class Sequences : public ISequences {
   // Returns current sequence length.
   int GetSequenceLength() const override;
 
+  // Set the length of each sequence when they are shorter than the current length. The sequences are stored from
+  // the start of their rows, and `lengths` must outlive the next Init.
+  void SetSequenceLengths(gsl::span<const int> lengths);
+
 #ifdef DEBUG_GENERATION
   // Print the sequences to StdOut in debug mode
   void PrintSequences(const IConsoleDumper* dumper) const;
@@ -53,6 +57,9 @@ class Sequences : public ISequences {
   int batch_beam_size_;
   int max_length_;
   int current_length_;
+
+  // Length of each sequence, empty when they all have the current length.
+  gsl::span<const int> sequence_lengths_;
 };
 
 }  // namespace transformers
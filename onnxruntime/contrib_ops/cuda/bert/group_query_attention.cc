@@ -53,6 +53,8 @@ GroupQueryAttention<T>::GroupQueryAttention(const OpKernelInfo& info)
   scale_ = info.GetAttrOrDefault<float>("scale", 0.0f);
   softcap_ = info.GetAttrOrDefault<float>("softcap", 0.0f);
   use_smooth_softmax_ = info.GetAttrOrDefault<int64_t>("smooth_softmax", 0) == 1;
+  ORT_ENFORCE(info.GetAttrOrDefault<int64_t>("kv_cache_bit_width", 0) == 0,
+              "Quantized kv cache (kv_cache_bit_width) is only supported on CPU.");
 
   kernel_options_ = this->GetAttentionKernelOptions();
 
@@ -77,6 +79,9 @@ Status GroupQueryAttention<T>::ComputeInternal(OpKernelContext* context) const {
   const Tensor* total_seqlen = context->Input<Tensor>(6);
   const Tensor* cos_cache = context->Input<Tensor>(7);
   const Tensor* sin_cache = context->Input<Tensor>(8);
+  if (context->Input<Tensor>(9) != nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED, "Paged kv cache (block_table) is only supported on CPU.");
+  }
 
   auto& device_prop = GetDeviceProp();
   GroupQueryAttentionParameters parameters;
@@ -110,10 +110,13 @@ void CPUIDInfo::X86Init() {
   int num_IDs = data[0];
   if (num_IDs >= 1) {
     GetCPUID(1, data);
+    feature_registers_.push_back(static_cast<uint32_t>(data[2]));
+    feature_registers_.push_back(static_cast<uint32_t>(data[3]));
     if (data[2] & (1 << 27)) {
       constexpr int AVX_MASK = 0x6;
       constexpr int AVX512_MASK = 0xE6;
       int value = XGETBV();
+      feature_registers_.push_back(static_cast<uint32_t>(value));
       bool has_sse2 = (data[3] & (1 << 26));
       has_sse3_ = (data[2] & 0x1);
       has_sse4_1_ = (data[2] & (1 << 19));
@@ -124,6 +127,9 @@ void CPUIDInfo::X86Init() {
 
       if (num_IDs >= 7) {
         GetCPUID(7, data);
+        feature_registers_.push_back(static_cast<uint32_t>(data[1]));
+        feature_registers_.push_back(static_cast<uint32_t>(data[2]));
+        feature_registers_.push_back(static_cast<uint32_t>(data[3]));
         const uint32_t max_SubLeaves = data[0];
         has_amx_bf16_ = (data[3] & (1 << 22));
         has_avx2_ = has_avx_ && (data[1] & (1 << 5));
@@ -134,6 +140,7 @@ void CPUIDInfo::X86Init() {
         is_hybrid_ = (data[3] & (1 << 15));
         if (max_SubLeaves >= 1) {
           GetCPUID(7, 1, data);
+          feature_registers_.push_back(static_cast<uint32_t>(data[0]));
           has_avx512_bf16_ = has_avx512 && (data[0] & (1 << 5));
         }
       }
@@ -92,6 +92,14 @@ class CPUIDInfo {
     return has_fp16_;
   }
 
+  /**
+   * @return raw feature registers read from CPUID (and XCR0) on x86, empty on other architectures.
+   *         Changes to any instruction set extension, including ones not exposed above, change these values.
+   */
+  const std::vector<uint32_t>& GetFeatureRegisters() const {
+    return feature_registers_;
+  }
+
  private:
   CPUIDInfo();
   bool has_amx_bf16_{false};
@@ -105,6 +113,8 @@ class CPUIDInfo {
   bool has_sse4_1_{false};
   bool is_hybrid_{false};
 
+  std::vector<uint32_t> feature_registers_;
+
   std::vector<uint32_t> core_uarchs_;  // micro-arch of each core
 
   // In ARMv8 systems, some power efficient cores has narrower
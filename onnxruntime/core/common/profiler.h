@@ -10,6 +10,7 @@
 #include <tuple>
 
 #include "core/common/profiler_common.h"
+#include "core/common/sampling_profiler.h"
 #include "core/common/logging/logging.h"
 #include <mutex>
 
@@ -110,6 +111,22 @@ class Profiler {
     global_max_num_events_.store(new_max_num_events);
   }
 
+  /*
+  Start the sampling mode, which aggregates node latencies by op type instead of recording trace events,
+  and is cheap enough to leave on in production. It is independent of StartProfiling, and stays on until
+  the profiler is destroyed.
+  */
+  void StartSampling(uint32_t sampling_interval, concurrency::ThreadPool* thread_pool) {
+    sampling_profiler_ = std::make_unique<SamplingProfiler>(sampling_interval, thread_pool);
+  }
+
+  /*
+  Return the sampling profiler, or nullptr if sampling was not started.
+  */
+  SamplingProfiler* GetSamplingProfiler() const {
+    return sampling_profiler_.get();
+  }
+
   void AddEpProfilers(std::unique_ptr<EpProfiler> ep_profiler) {
     if (ep_profiler) {
       ep_profilers_.push_back(std::move(ep_profiler));
@@ -156,6 +173,7 @@ class Profiler {
 #endif
 
   std::vector<std::unique_ptr<EpProfiler>> ep_profilers_;
+  std::unique_ptr<SamplingProfiler> sampling_profiler_;
 };
 
 }  // namespace profiling
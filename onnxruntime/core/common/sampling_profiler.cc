@@ -0,0 +1,304 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/common/sampling_profiler.h"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+#include "core/common/inlined_containers.h"
+#include "core/platform/threadpool.h"
+
+namespace onnxruntime {
+namespace profiling {
+
+namespace {
+
+std::atomic<uint64_t> next_profiler_id{1};
+
+// Each thread maps the ids of the profilers it has run nodes for to its buffers, so that threads
+// running several sessions do not go back to the registry on every node run. The entries are not
+// erased by the destructor of the profiler, which may run on another thread or after the
+// thread_local map of the destroying thread is gone. Profiler ids are never reused, so the entry of
+// a destroyed profiler is never looked up again, and each thread prunes those entries when it
+// registers with a new profiler, which is the only time its map grows.
+struct ThreadBufferEntry {
+  void* buffer;
+  std::weak_ptr<const void> profiler;  // expires when the profiler is destroyed
+};
+thread_local InlinedHashMap<uint64_t, ThreadBufferEntry> thread_buffers;
+
+// Starts tracking the busy time of tp, and returns the busy time so far.
+uint64_t StartTrackingBusyTime(concurrency::ThreadPool* tp) {
+  concurrency::ThreadPool::StartTrackingBusyTime(tp);
+  return concurrency::ThreadPool::BusyTimeNs(tp);
+}
+
+// Adds to a counter that only the calling thread writes.
+inline void Accumulate(std::atomic<uint64_t>& counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Writes s as the contents of a JSON string. Op types of custom ops may contain any characters.
+void WriteJsonString(std::ostream& os, const std::string& s) {
+  for (const char c : s) {
+    switch (c) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      case '\r':
+        os << "\\r";
+        break;
+      case '\t':
+        os << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          const char* hex = "0123456789abcdef";
+          os << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        } else {
+          os << c;
+        }
+    }
+  }
+}
+
+}  // namespace
+
+SamplingProfiler::SamplingProfiler(uint32_t sampling_interval, concurrency::ThreadPool* thread_pool)
+    : id_(next_profiler_id.fetch_add(1, std::memory_order_relaxed)),
+      lifetime_(std::make_shared<char>()),
+      sampling_interval_(std::max<uint32_t>(sampling_interval, 1)),
+      thread_pool_(thread_pool),
+      start_time_(std::chrono::steady_clock::now()),
+      start_busy_ns_(StartTrackingBusyTime(thread_pool)) {
+}
+
+SamplingProfiler::ThreadBuffer::~ThreadBuffer() {
+  for (auto& s : stats) {
+    delete s.load(std::memory_order_relaxed);
+  }
+}
+
+SamplingProfiler::ThreadBuffer& SamplingProfiler::GetThreadBuffer() {
+  const auto it = thread_buffers.find(id_);
+  if (it != thread_buffers.end()) {
+    return *static_cast<ThreadBuffer*>(it->second.buffer);
+  }
+  return RegisterThread();
+}
+
+SamplingProfiler::ThreadBuffer& SamplingProfiler::RegisterThread() {
+  const auto thread_id = std::this_thread::get_id();
+  ThreadBuffer* buffer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    for (const auto& t : threads_) {
+      if (t->thread_id == thread_id) {
+        buffer = t.get();
+        break;
+      }
+    }
+    if (buffer == nullptr) {
+      threads_.push_back(std::make_unique<ThreadBuffer>());
+      buffer = threads_.back().get();
+      buffer->thread_id = thread_id;
+    }
+  }
+
+  for (auto it = thread_buffers.begin(); it != thread_buffers.end();) {
+    if (it->second.profiler.expired()) {
+      thread_buffers.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  thread_buffers[id_] = ThreadBufferEntry{buffer, lifetime_};
+  return *buffer;
+}
+
+bool SamplingProfiler::ShouldSample() {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  if (buffer.runs_until_sample == 0) {
+    buffer.runs_until_sample = sampling_interval_ - 1;
+    return true;
+  }
+  --buffer.runs_until_sample;
+  return false;
+}
+
+int SamplingProfiler::GetOpTypeId(const std::string& op_type) {
+  const size_t start = std::hash<std::string>{}(op_type) % kMaxOpTypes;
+  for (size_t probe = 0; probe < kMaxOpTypes; ++probe) {
+    const size_t i = (start + probe) % kMaxOpTypes;
+    OpTypeSlot& slot = op_types_[i];
+    int state = slot.state.load(std::memory_order_acquire);
+    if (state == OpTypeSlot::kEmpty) {
+      if (slot.state.compare_exchange_strong(state, OpTypeSlot::kWriting, std::memory_order_acquire)) {
+        slot.name = op_type;
+        slot.state.store(OpTypeSlot::kReady, std::memory_order_release);
+        return static_cast<int>(i);
+      }
+    }
+    // Another thread is publishing this slot. This happens only the first time an op type is seen.
+    while (state == OpTypeSlot::kWriting) {
+      std::this_thread::yield();
+      state = slot.state.load(std::memory_order_acquire);
+    }
+    if (slot.name == op_type) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void SamplingProfiler::RecordNode(const std::string& op_type, uint64_t duration_ns, size_t output_bytes) {
+  const int op_type_id = GetOpTypeId(op_type);
+  if (op_type_id < 0) {
+    dropped_samples_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  ThreadBuffer& buffer = GetThreadBuffer();
+  OpTypeStats* stats = buffer.stats[op_type_id].load(std::memory_order_relaxed);
+  if (stats == nullptr) {
+    stats = new OpTypeStats();
+    buffer.stats[op_type_id].store(stats, std::memory_order_release);
+  }
+
+  Accumulate(stats->count, 1);
+  Accumulate(stats->total_ns, duration_ns);
+  Accumulate(stats->output_bytes, output_bytes);
+  Accumulate(stats->buckets[BucketIndex(duration_ns)], 1);
+  if (duration_ns > stats->max_ns.load(std::memory_order_relaxed)) {
+    stats->max_ns.store(duration_ns, std::memory_order_relaxed);
+  }
+}
+
+size_t SamplingProfiler::BucketIndex(uint64_t value_ns) {
+  constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+  if (value_ns < kSubBuckets) {
+    return static_cast<size_t>(value_ns);
+  }
+  size_t log2 = 0;
+  for (uint64_t v = value_ns; v > 1; v >>= 1) {
+    ++log2;
+  }
+  const size_t sub_bucket = static_cast<size_t>(value_ns >> (log2 - kSubBucketBits)) & (kSubBuckets - 1);
+  return std::min((log2 - kSubBucketBits + 1) * kSubBuckets + sub_bucket, kNumBuckets - 1);
+}
+
+double SamplingProfiler::BucketMidpoint(size_t index) {
+  constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  if (index < kSubBuckets) {
+    return static_cast<double>(index);
+  }
+  const size_t shift = index / kSubBuckets - 1;
+  const double lower = static_cast<double>(uint64_t{kSubBuckets + index % kSubBuckets} << shift);
+  const double width = static_cast<double>(uint64_t{1} << shift);
+  return lower + width / 2;
+}
+
+std::string SamplingProfiler::Snapshot() const {
+  struct Merged {
+    std::string op_type;
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t output_bytes = 0;
+    std::array<uint64_t, kNumBuckets> buckets{};
+  };
+  std::vector<Merged> merged;
+
+  {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    for (size_t i = 0; i < kMaxOpTypes; ++i) {
+      if (op_types_[i].state.load(std::memory_order_acquire) != OpTypeSlot::kReady) {
+        continue;
+      }
+      Merged m;
+      for (const auto& t : threads_) {
+        const OpTypeStats* stats = t->stats[i].load(std::memory_order_acquire);
+        if (stats == nullptr) {
+          continue;
+        }
+        m.count += stats->count.load(std::memory_order_relaxed);
+        m.total_ns += stats->total_ns.load(std::memory_order_relaxed);
+        m.max_ns = std::max(m.max_ns, stats->max_ns.load(std::memory_order_relaxed));
+        m.output_bytes += stats->output_bytes.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < kNumBuckets; ++b) {
+          m.buckets[b] += stats->buckets[b].load(std::memory_order_relaxed);
+        }
+      }
+      if (m.count != 0) {
+        m.op_type = op_types_[i].name;
+        merged.push_back(std::move(m));
+      }
+    }
+  }
+
+  std::sort(merged.begin(), merged.end(),
+            [](const Merged& a, const Merged& b) { return a.total_ns > b.total_ns; });
+
+  // The counters are read without synchronizing with the threads recording them, so the bucket
+  // counts may be slightly ahead of or behind count. Percentiles are taken over the bucket counts.
+  auto percentile_us = [](const Merged& m, double p) {
+    uint64_t total = 0;
+    for (auto c : m.buckets) {
+      total += c;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * static_cast<double>(total) + 0.5));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kNumBuckets; ++b) {
+      seen += m.buckets[b];
+      if (seen >= rank) {
+        return std::min(BucketMidpoint(b), static_cast<double>(m.max_ns)) / 1000.0;
+      }
+    }
+    return static_cast<double>(m.max_ns) / 1000.0;
+  };
+
+  const auto elapsed_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time_).count());
+  const int num_threads = concurrency::ThreadPool::DegreeOfParallelism(thread_pool_) - 1;
+  const uint64_t busy_ns = concurrency::ThreadPool::BusyTimeNs(thread_pool_) - start_busy_ns_;
+  const double utilization = (num_threads > 0 && elapsed_ns > 0)
+                                 ? static_cast<double>(busy_ns) / (static_cast<double>(elapsed_ns) * num_threads)
+                                 : 0.0;
+
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  ss << "{\"sampling_interval\": " << sampling_interval_ << ", ";
+  ss << "\"elapsed_us\": " << elapsed_ns / 1000 << ", ";
+  ss << "\"dropped_samples\": " << dropped_samples_.load(std::memory_order_relaxed) << ", ";
+  ss << "\"thread_pool\": {\"num_threads\": " << std::max(num_threads, 0) << ", "
+     << "\"utilization\": " << std::min(utilization, 1.0) << "}, ";
+  ss << "\"nodes\": [";
+  for (size_t i = 0; i < merged.size(); ++i) {
+    const Merged& m = merged[i];
+    ss << (i == 0 ? "" : ", ");
+    ss << "{\"op_type\": \"";
+    WriteJsonString(ss, m.op_type);
+    ss << "\", "
+       << "\"samples\": " << m.count << ", "
+       << "\"mean_us\": " << static_cast<double>(m.total_ns) / static_cast<double>(m.count) / 1000.0 << ", "
+       << "\"p50_us\": " << percentile_us(m, 0.50) << ", "
+       << "\"p99_us\": " << percentile_us(m, 0.99) << ", "
+       << "\"max_us\": " << static_cast<double>(m.max_ns) / 1000.0 << ", "
+       << "\"output_bytes\": " << m.output_bytes << "}";
+  }
+  ss << "]}";
+  return ss.str();
+}
+
+}  // namespace profiling
+}  // namespace onnxruntime
@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/common/common.h"
+
+namespace onnxruntime {
+
+namespace concurrency {
+class ThreadPool;
+}
+
+namespace profiling {
+
+/**
+ * Low overhead profiler meant to stay enabled on production traffic.
+ *
+ * Rather than recording a trace event for every node run, it folds a sample of the node runs into
+ * latency histograms aggregated by op type. Each thread that runs nodes writes only to its own set
+ * of histograms, so recording a sample takes no locks and no writes shared with other threads.
+ * Snapshot() merges the histograms of all the threads, and may be called at any time while the
+ * session keeps running.
+ */
+class SamplingProfiler {
+ public:
+  /*
+  Samples one out of every sampling_interval node runs on each thread. Utilization is reported for
+  thread_pool, which may be null.
+  */
+  SamplingProfiler(uint32_t sampling_interval, concurrency::ThreadPool* thread_pool);
+
+  /*
+  Called before each node run. Returns true if the run is sampled, in which case the caller times it
+  and passes the result to RecordNode.
+  */
+  bool ShouldSample();
+
+  /*
+  Record a sampled node run of the given op type, which took duration_ns and produced output_bytes bytes
+  of output tensors.
+  */
+  void RecordNode(const std::string& op_type, uint64_t duration_ns, size_t output_bytes);
+
+  /*
+  Return the statistics gathered since the profiler was created as a JSON object:
+  {
+    "sampling_interval": 1, "elapsed_us": 123456, "dropped_samples": 0,
+    "thread_pool": {"num_threads": 3, "utilization": 0.25},
+    "nodes": [{"op_type": "Conv", "samples": 100, "mean_us": 12.5, "p50_us": 11.8, "p99_us": 20.1,
+               "max_us": 25.3, "output_bytes": 409600}, ...]
+  }
+  The nodes are sorted by the total time sampled, largest first. Latency percentiles are accurate
+  to within about 12%.
+  */
+  std::string Snapshot() const;
+
+  // Latencies are bucketed by their top 3 significant bits: 4 buckets per power of 2.
+  static constexpr size_t kSubBucketBits = 2;
+  static constexpr size_t kNumBuckets = 4 * 40;
+  static constexpr size_t kMaxOpTypes = 512;
+
+  static size_t BucketIndex(uint64_t value_ns);
+  static double BucketMidpoint(size_t index);
+
+ private:
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(SamplingProfiler);
+
+  // Statistics of one op type on one thread. Written only by the owning thread, and read by Snapshot.
+  struct OpTypeStats {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> output_bytes{0};
+    std::array<std::atomic<uint64_t>, kNumBuckets> buckets{};
+  };
+
+  struct ThreadBuffer {
+    ~ThreadBuffer();
+
+    std::thread::id thread_id;
+    uint32_t runs_until_sample = 0;  // accessed only by the owning thread
+    // Allocated by the owning thread when it first records the op type.
+    std::array<std::atomic<OpTypeStats*>, kMaxOpTypes> stats{};
+  };
+
+  // Interned op type names. A slot is claimed once and its name never changes after it is published.
+  struct OpTypeSlot {
+    enum State : int { kEmpty, kWriting, kReady };
+    std::atomic<int> state{kEmpty};
+    std::string name;
+  };
+
+  ThreadBuffer& GetThreadBuffer();
+  ThreadBuffer& RegisterThread();
+
+  // Returns the slot of op_type, claiming one if it is new, or -1 if the table is full.
+  int GetOpTypeId(const std::string& op_type);
+
+  const uint64_t id_;  // unique over all instances, used to find the calling thread's buffer
+  const std::shared_ptr<const char> lifetime_;  // lets threads prune their entries once the profiler is gone
+  const uint32_t sampling_interval_;
+  concurrency::ThreadPool* const thread_pool_;
+  const std::chrono::steady_clock::time_point start_time_;
+  const uint64_t start_busy_ns_;
+
+  mutable std::mutex threads_mutex_;  // guards threads_, taken once per thread and by Snapshot
+  std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+
+  std::array<OpTypeSlot, kMaxOpTypes> op_types_;
+  std::atomic<uint64_t> dropped_samples_{0};
+};
+
+}  // namespace profiling
+}  // namespace onnxruntime
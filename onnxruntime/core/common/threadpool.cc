@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <memory>
 #include <optional>
+#include <gsl/gsl>
 
 #include "core/platform/threadpool.h"
 #include "core/common/common.h"
@@ -231,11 +232,33 @@ void ThreadPoolProfiler::LogRun(int thread_idx) {
   }
 }
 
+void ThreadPoolProfiler::LogSpin(int thread_idx, uint64_t spin_ns, bool found_work) {
+  if (enabled_) {
+    auto& stat = child_thread_stats_[thread_idx];
+    stat.spin_ns_ += spin_ns;
+    if (found_work) {
+      stat.num_spin_hit_++;
+    } else {
+      stat.num_spin_miss_++;
+    }
+  }
+}
+
+void ThreadPoolProfiler::LogBlock(int thread_idx) {
+  if (enabled_) {
+    child_thread_stats_[thread_idx].num_block_++;
+  }
+}
+
 std::string ThreadPoolProfiler::DumpChildThreadStat() {
   std::stringstream ss;
   for (int i = 0; i < num_threads_; ++i) {
     ss << "\"" << child_thread_stats_[i].thread_id_ << "\": {"
        << "\"num_run\": " << child_thread_stats_[i].num_run_ << ", "
+       << "\"spin_us\": " << child_thread_stats_[i].spin_ns_ / 1000 << ", "
+       << "\"num_spin_hit\": " << child_thread_stats_[i].num_spin_hit_ << ", "
+       << "\"num_spin_miss\": " << child_thread_stats_[i].num_spin_miss_ << ", "
+       << "\"num_block\": " << child_thread_stats_[i].num_block_ << ", "
        << "\"core\": " << child_thread_stats_[i].core_ << "}"
        << (i == num_threads_ - 1 ? "" : ",");
   }
@@ -272,9 +295,11 @@ class alignas(CACHE_LINE_BYTES) LoopCounter {
  public:
   LoopCounter(uint64_t num_iterations,
               uint64_t d_of_p,
-              uint64_t block_size = 1) : _num_shards(GetNumShards(num_iterations,
-                                                                  d_of_p,
-                                                                  block_size)) {
+              uint64_t block_size = 1,
+              unsigned num_nodes = 1) : _num_shards(GetNumShards(num_iterations,
+                                                                 d_of_p,
+                                                                 block_size)),
+                                        _num_nodes(std::max(1u, std::min(num_nodes, _num_shards))) {
     // Divide the iteration space between the shards.  If the iteration
     // space does not divide evenly into shards of multiples of
     // block_size then the final shard is left uneven.
@@ -292,6 +317,17 @@ class alignas(CACHE_LINE_BYTES) LoopCounter {
       bool is_last_shard = (shard == _num_shards - 1);
       _shards[shard]._end = is_last_shard ? num_iterations : ((shard + 1) * iterations_per_shard);
     }
+
+    // Assign contiguous ranges of shards, and hence of iterations, to each
+    // NUMA node.  Without NUMA information all shards belong to one node.
+    for (unsigned node = 0; node < _num_nodes; node++) {
+      unsigned begin = GetNodeShardBegin(node);
+      unsigned end = GetNodeShardBegin(node + 1);
+      for (unsigned shard = begin; shard < end; shard++) {
+        _node_begin[shard] = static_cast<uint8_t>(begin);
+        _node_end[shard] = static_cast<uint8_t>(end);
+      }
+    }
   }
 
   // Allocate each thread to a home shard, from which it starts
@@ -303,19 +339,37 @@ class alignas(CACHE_LINE_BYTES) LoopCounter {
   // tend to run the same iterations in the next loop.  This helps
   // operators with a series of short loops, such as GRU.
 
-  unsigned GetHomeShard(unsigned idx) const {
+  //
+  // When the pool groups its workers by NUMA node, the home shard of a
+  // worker is taken from its own node's range of shards, so that the
+  // iterations a node runs are contiguous.
+
+  unsigned GetHomeShard(unsigned idx, int node = -1) const {
+    if (_num_nodes > 1 && node >= 0) {
+      unsigned begin = GetNodeShardBegin(static_cast<unsigned>(node) % _num_nodes);
+      unsigned end = _node_end[begin];
+      return begin + idx % (end - begin);
+    }
     return idx % _num_shards;
   }
 
   // Attempt to claim iterations from the sharded counter.  The function either
   // returns true, along with a block of exactly block_size iterations, or it returns false
-  // if all of the iterations have been claimed.
+  // if all of the iterations have been claimed.  my_step counts the shards visited so far,
+  // starting at 0: the shards of the home shard's node are visited first, beginning with
+  // the home shard, followed by the shards of the other nodes.
   bool ClaimIterations(unsigned my_home_shard,
-                       unsigned& my_shard,
+                       unsigned& my_step,
                        uint64_t& my_start,
                        uint64_t& my_end,
                        uint64_t block_size) {
-    do {
+    const unsigned local_begin = _node_begin[my_home_shard];
+    const unsigned local_end = _node_end[my_home_shard];
+    const unsigned num_local = local_end - local_begin;
+    while (my_step < _num_shards) {
+      unsigned my_shard = (my_step < num_local)
+                              ? local_begin + (my_home_shard - local_begin + my_step) % num_local
+                              : (local_end + my_step - num_local) % _num_shards;
       if (_shards[my_shard]._next < _shards[my_shard]._end) {
         // Appears to be work in the current shard, try to claim with atomic fetch-and-add
         uint64_t temp_start = _shards[my_shard]._next.fetch_add(block_size);
@@ -326,9 +380,9 @@ class alignas(CACHE_LINE_BYTES) LoopCounter {
         }
       }
       // Work in the current shard is exhausted, move to the next shard, until
-      // we are back at the home shard.
-      my_shard = (my_shard + 1) % _num_shards;
-    } while (my_shard != my_home_shard);
+      // all shards have been visited.
+      my_step++;
+    }
     return false;
   }
 
@@ -362,8 +416,15 @@ class alignas(CACHE_LINE_BYTES) LoopCounter {
     return num_shards;
   }
 
+  unsigned GetNodeShardBegin(unsigned node) const {
+    return node * _num_shards / _num_nodes;
+  }
+
   alignas(CACHE_LINE_BYTES) LoopCounterShard _shards[MAX_SHARDS];
   const unsigned _num_shards;
+  const unsigned _num_nodes;
+  uint8_t _node_begin[MAX_SHARDS];
+  uint8_t _node_end[MAX_SHARDS];
 };
 
 #ifdef _MSC_VER
@@ -390,6 +451,11 @@ ThreadPool::ThreadPool(Env* env,
       assert(thread_options_.affinities.size() >= size_t(threads_to_create));
     }
 
+    if (!thread_options_.numa_nodes.empty()) {
+      // Likewise, the first NUMA node element belongs to the caller thread
+      thread_options_.numa_nodes.erase(thread_options_.numa_nodes.begin());
+    }
+
     extended_eigen_threadpool_ =
         std::make_unique<ThreadPoolTempl<Env> >(name,
                                                 threads_to_create,
@@ -425,12 +491,12 @@ void ThreadPool::ParallelForFixedBlockSizeScheduling(const std::ptrdiff_t total,
     int num_work_items = static_cast<int>(std::min(static_cast<std::ptrdiff_t>(num_threads_inc_main), num_blocks));
     assert(num_work_items > 0);
 
-    LoopCounter lc(total, d_of_p, block_size);
+    LoopCounter lc(total, d_of_p, block_size, NumNumaNodes());
     std::function<void(unsigned)> run_work = [&](unsigned idx) {
-      unsigned my_home_shard = lc.GetHomeShard(idx);
-      unsigned my_shard = my_home_shard;
+      unsigned my_home_shard = lc.GetHomeShard(idx, CurrentNumaNode());
+      unsigned my_step = 0;
       uint64_t my_iter_start, my_iter_end;
-      while (lc.ClaimIterations(my_home_shard, my_shard, my_iter_start, my_iter_end, block_size)) {
+      while (lc.ClaimIterations(my_home_shard, my_step, my_iter_start, my_iter_end, block_size)) {
         fn(static_cast<std::ptrdiff_t>(my_iter_start),
            static_cast<std::ptrdiff_t>(my_iter_end));
       }
@@ -443,13 +509,13 @@ void ThreadPool::ParallelForFixedBlockSizeScheduling(const std::ptrdiff_t total,
     int num_of_blocks = d_of_p * thread_options_.dynamic_block_base_;
     std::ptrdiff_t base_block_size = static_cast<std::ptrdiff_t>(std::max(1LL, std::llroundl(static_cast<long double>(total) / num_of_blocks)));
     alignas(CACHE_LINE_BYTES) std::atomic<std::ptrdiff_t> left{total};
-    LoopCounter lc(total, d_of_p, base_block_size);
+    LoopCounter lc(total, d_of_p, base_block_size, NumNumaNodes());
     std::function<void(unsigned)> run_work = [&](unsigned idx) {
       std::ptrdiff_t b = base_block_size;
-      unsigned my_home_shard = lc.GetHomeShard(idx);
-      unsigned my_shard = my_home_shard;
+      unsigned my_home_shard = lc.GetHomeShard(idx, CurrentNumaNode());
+      unsigned my_step = 0;
       uint64_t my_iter_start, my_iter_end;
-      while (lc.ClaimIterations(my_home_shard, my_shard, my_iter_start, my_iter_end, b)) {
+      while (lc.ClaimIterations(my_home_shard, my_step, my_iter_start, my_iter_end, b)) {
         fn(static_cast<std::ptrdiff_t>(my_iter_start),
            static_cast<std::ptrdiff_t>(my_iter_end));
         auto todo = left.fetch_sub(static_cast<std::ptrdiff_t>(my_iter_end - my_iter_start), std::memory_order_relaxed);
@@ -472,8 +538,28 @@ void ThreadPool::SimpleParallelFor(std::ptrdiff_t total, const std::function<voi
   });
 }
 
+namespace {
+thread_local const ThreadPool::SchedulingContext* current_scheduling_context = nullptr;
+}
+
+ThreadPool::SchedulingScope::SchedulingScope(const SchedulingContext& context)
+    : context_(context), previous_(current_scheduling_context) {
+  current_scheduling_context = &context_;
+}
+
+ThreadPool::SchedulingScope::~SchedulingScope() {
+  current_scheduling_context = previous_;
+}
+
 void ThreadPool::Schedule(std::function<void()> fn) {
   if (underlying_threadpool_) {
+    if (current_scheduling_context) {
+      // Run fn under the scheduling context of the thread that scheduled it
+      fn = [context = *current_scheduling_context, fn = std::move(fn)]() {
+        SchedulingScope scope(context);
+        fn();
+      };
+    }
     underlying_threadpool_->Schedule(std::move(fn));
   } else {
     fn();
@@ -516,8 +602,30 @@ ThreadPool::ParallelSection::~ParallelSection() {
   }
 }
 
+unsigned ThreadPool::AdaptDegreeOfParallelism(unsigned n, unsigned priority, unsigned active_priority) const {
+  // The caller always works on its own loop; the pool's threads are shared between
+  // the active callers in proportion to their priorities.
+  unsigned share = 1 + static_cast<unsigned>(static_cast<uint64_t>(NumThreads()) * priority / active_priority);
+  return std::min(n, share);
+}
+
 void ThreadPool::RunInParallel(std::function<void(unsigned idx)> fn, unsigned n, std::ptrdiff_t block_size) {
   if (underlying_threadpool_) {
+    const SchedulingContext* context = current_scheduling_context;
+    unsigned priority = 0;
+    if (thread_options_.adaptive_parallelism) {
+      priority = context ? std::max(context->priority, 1u) : 1u;
+      unsigned active_priority = active_priority_.fetch_add(priority, std::memory_order_relaxed) + priority;
+      n = AdaptDegreeOfParallelism(n, priority, active_priority);
+    }
+    auto release_priority = gsl::finally([this, priority]() {
+      if (priority > 0) {
+        active_priority_.fetch_sub(priority, std::memory_order_relaxed);
+      }
+    });
+    if (context && context->max_degree_of_parallelism > 0) {
+      n = std::max(1u, std::min(n, context->max_degree_of_parallelism));
+    }
     if (current_parallel_section.has_value()) {
       underlying_threadpool_->RunInParallelSection(*current_parallel_section,
                                                    std::move(fn),
@@ -664,6 +772,19 @@ std::string ThreadPool::StopProfiling(concurrency::ThreadPool* tp) {
   }
 }
 
+void ThreadPool::StartTrackingBusyTime(concurrency::ThreadPool* tp) {
+  if (tp && tp->extended_eigen_threadpool_) {
+    tp->extended_eigen_threadpool_->StartTrackingBusyTime();
+  }
+}
+
+uint64_t ThreadPool::BusyTimeNs(const concurrency::ThreadPool* tp) {
+  if (tp && tp->extended_eigen_threadpool_) {
+    return tp->extended_eigen_threadpool_->BusyTimeNs();
+  }
+  return 0;
+}
+
 void ThreadPool::EnableSpinning() {
   if (extended_eigen_threadpool_) {
     extended_eigen_threadpool_->EnableSpinning();
@@ -676,6 +797,18 @@ void ThreadPool::DisableSpinning() {
   }
 }
 
+void ThreadPool::EnterLatencyMode() {
+  if (extended_eigen_threadpool_) {
+    extended_eigen_threadpool_->EnterLatencyMode();
+  }
+}
+
+void ThreadPool::ExitLatencyMode() {
+  if (extended_eigen_threadpool_) {
+    extended_eigen_threadpool_->ExitLatencyMode();
+  }
+}
+
 // Return the number of threads created by the pool.
 int ThreadPool::NumThreads() const {
   if (underlying_threadpool_) {
@@ -695,6 +828,22 @@ int ThreadPool::CurrentThreadId() const {
   }
 }
 
+unsigned ThreadPool::NumNumaNodes() const {
+  if (extended_eigen_threadpool_) {
+    return extended_eigen_threadpool_->NumNumaNodes();
+  } else {
+    return 1;
+  }
+}
+
+int ThreadPool::CurrentNumaNode() const {
+  if (extended_eigen_threadpool_) {
+    return extended_eigen_threadpool_->CurrentNumaNode();
+  } else {
+    return -1;
+  }
+}
+
 void ThreadPool::TryParallelFor(concurrency::ThreadPool* tp, std::ptrdiff_t total, const TensorOpCost& cost_per_unit,
                                 const std::function<void(std::ptrdiff_t first, std::ptrdiff_t last)>& fn) {
   if (tp == nullptr) {
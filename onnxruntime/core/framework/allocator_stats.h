@@ -22,6 +22,10 @@ struct AllocatorStats {
                                   // is known. Certain allocator may return 0 to indicate the limit is
                                   // unknown.
   int64_t bytes_limit;
+  int64_t num_arena_trims;              // Number of idle allocation regions released by arena trimming
+  int64_t trimmed_bytes;                // Number of bytes released by arena trimming
+  int64_t num_size_class_cache_hits;    // Number of allocations served from the arena's size class caches
+  int64_t num_size_class_cache_misses;  // Number of cacheable allocations that found their size class cache empty
 
   AllocatorStats() { Clear(); }
 
@@ -35,6 +39,10 @@ struct AllocatorStats {
     this->max_alloc_size = 0;
     this->bytes_limit = 0;
     this->total_allocated_bytes = 0;
+    this->num_arena_trims = 0;
+    this->trimmed_bytes = 0;
+    this->num_size_class_cache_hits = 0;
+    this->num_size_class_cache_misses = 0;
   }
 
   std::string DebugString() const {
@@ -47,7 +55,11 @@ struct AllocatorStats {
        << "NumReserves:              " << this->num_reserves << "\n"
        << "NumArenaExtensions:       " << this->num_arena_extensions << "\n"
        << "NumArenaShrinkages:       " << this->num_arena_shrinkages << "\n"
-       << "MaxAllocSize:             " << this->max_alloc_size << "\n";
+       << "MaxAllocSize:             " << this->max_alloc_size << "\n"
+       << "NumArenaTrims:            " << this->num_arena_trims << "\n"
+       << "TrimmedBytes:             " << this->trimmed_bytes << "\n"
+       << "NumSizeClassCacheHits:    " << this->num_size_class_cache_hits << "\n"
+       << "NumSizeClassCacheMisses:  " << this->num_size_class_cache_misses << "\n";
     return ss.str();
   }
 };
@@ -34,6 +34,25 @@ AllocatorPtr CreateAllocator(const AllocatorCreationInfo& info) {
     int64_t max_power_of_two_extend_bytes = info.arena_cfg.max_power_of_two_extend_bytes == -1
                                                 ? BFCArena::DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES
                                                 : info.arena_cfg.max_power_of_two_extend_bytes;
+
+    // Values of -1 keep the defaults, which leave trimming and the size class caches disabled.
+    ArenaMemoryPressureConfig memory_pressure_config;
+    if (info.arena_cfg.idle_region_release_ms != -1) {
+      memory_pressure_config.idle_region_release_ms = info.arena_cfg.idle_region_release_ms;
+    }
+    if (info.arena_cfg.trim_high_watermark_bytes != -1) {
+      memory_pressure_config.trim_high_watermark_bytes = narrow<size_t>(info.arena_cfg.trim_high_watermark_bytes);
+    }
+    if (info.arena_cfg.trim_low_watermark_bytes != -1) {
+      memory_pressure_config.trim_low_watermark_bytes = narrow<size_t>(info.arena_cfg.trim_low_watermark_bytes);
+    }
+    if (info.arena_cfg.background_trim_interval_ms != -1) {
+      memory_pressure_config.background_trim_interval_ms = info.arena_cfg.background_trim_interval_ms;
+    }
+    if (info.arena_cfg.size_class_cache_max_bytes != -1) {
+      memory_pressure_config.size_class_cache_max_bytes = narrow<size_t>(info.arena_cfg.size_class_cache_max_bytes);
+    }
+
     ArenaExtendStrategy arena_extend_str;
     switch (info.arena_cfg.arena_extend_strategy) {
       case static_cast<int>(ArenaExtendStrategy::kSameAsRequested):
@@ -58,7 +77,9 @@ AllocatorPtr CreateAllocator(const AllocatorCreationInfo& info) {
                                              arena_extend_str,
                                              initial_chunk_size_bytes,
                                              max_dead_bytes_per_chunk,
-                                             initial_growth_chunk_size_bytes));
+                                             initial_growth_chunk_size_bytes,
+                                             max_power_of_two_extend_bytes,
+                                             memory_pressure_config));
 #else
       ORT_THROW("StreamAwareArena should be transparent to minimal build.");
 #endif
@@ -70,7 +91,8 @@ AllocatorPtr CreateAllocator(const AllocatorCreationInfo& info) {
                                      initial_chunk_size_bytes,
                                      max_dead_bytes_per_chunk,
                                      initial_growth_chunk_size_bytes,
-                                     max_power_of_two_extend_bytes));
+                                     max_power_of_two_extend_bytes,
+                                     memory_pressure_config));
     }
   } else {
     return device_allocator;
@@ -6,13 +6,23 @@
 #include <type_traits>
 
 namespace onnxruntime {
+namespace {
+// Spreads the threads allocating from a size class cache over the words of its bitmask.
+size_t SizeClassCacheStartWord() {
+  static std::atomic<size_t> next_thread{0};
+  thread_local const size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+  return thread_index;
+}
+}  // namespace
+
 BFCArena::BFCArena(std::unique_ptr<IAllocator> resource_allocator,
                    size_t total_memory,
                    ArenaExtendStrategy arena_extend_strategy,
                    int initial_chunk_size_bytes,
                    int max_dead_bytes_per_chunk,
                    int initial_growth_chunk_size_bytes,
-                   int64_t max_power_of_two_extend_bytes)
+                   int64_t max_power_of_two_extend_bytes,
+                   const ArenaMemoryPressureConfig& memory_pressure_config)
     : IAllocator(OrtMemoryInfo(resource_allocator->Info().name,
                                OrtAllocatorType::OrtArenaAllocator,
                                resource_allocator->Info().device,
@@ -25,14 +35,20 @@ BFCArena::BFCArena(std::unique_ptr<IAllocator> resource_allocator,
       initial_chunk_size_bytes_(initial_chunk_size_bytes),
       max_dead_bytes_per_chunk_(max_dead_bytes_per_chunk),
       initial_growth_chunk_size_bytes_(initial_growth_chunk_size_bytes),
-      max_power_of_two_extend_bytes_(max_power_of_two_extend_bytes) {
+      max_power_of_two_extend_bytes_(max_power_of_two_extend_bytes),
+      memory_pressure_config_(memory_pressure_config) {
   LOGS_DEFAULT(INFO) << "Creating BFCArena for " << device_allocator_->Info().name
                      << " with following configs: initial_chunk_size_bytes: " << initial_chunk_size_bytes_
                      << " max_dead_bytes_per_chunk: " << max_dead_bytes_per_chunk_
                      << " initial_growth_chunk_size_bytes: " << initial_growth_chunk_size_bytes_
                      << " max_power_of_two_extend_bytes: " << max_power_of_two_extend_bytes_
                      << " memory limit: " << total_memory
-                     << " arena_extend_strategy: " << static_cast<int32_t>(arena_extend_strategy);
+                     << " arena_extend_strategy: " << static_cast<int32_t>(arena_extend_strategy)
+                     << " idle_region_release_ms: " << memory_pressure_config_.idle_region_release_ms
+                     << " trim_high_watermark_bytes: " << memory_pressure_config_.trim_high_watermark_bytes
+                     << " trim_low_watermark_bytes: " << memory_pressure_config_.trim_low_watermark_bytes
+                     << " background_trim_interval_ms: " << memory_pressure_config_.background_trim_interval_ms
+                     << " size_class_cache_max_bytes: " << memory_pressure_config_.size_class_cache_max_bytes;
 
   // static_cast<std::underlying_type_t<ArenaExtendStrategy>>(arena_extend_strategy); doesn't work on this compiler
 
@@ -75,9 +91,37 @@ BFCArena::BFCArena(std::unique_ptr<IAllocator> resource_allocator,
       ORT_ENFORCE(BinForSize(bin_size * 2) != BinFromIndex(b));
     }
   }
+
+  if (memory_pressure_config_.size_class_cache_max_bytes > 0) {
+    num_size_classes_ = std::min(SizeClassIndex(memory_pressure_config_.size_class_cache_max_bytes) + 1,
+                                 kMaxSizeClasses);
+    for (size_t i = 0; i < num_size_classes_; ++i) {
+      size_class_caches_[i].block_size = kMinAllocationSize << i;
+    }
+  }
+
+  track_region_use_ = memory_pressure_config_.idle_region_release_ms > 0 ||
+                      memory_pressure_config_.trim_high_watermark_bytes > 0 ||
+                      memory_pressure_config_.trim_low_watermark_bytes > 0 ||
+                      memory_pressure_config_.background_trim_interval_ms > 0;
+
+  if (memory_pressure_config_.background_trim_interval_ms > 0) {
+    ORT_ENFORCE(memory_pressure_config_.idle_region_release_ms > 0,
+                "background_trim_interval_ms requires a positive idle_region_release_ms");
+    trim_thread_ = std::thread(&BFCArena::TrimInBackground, this);
+  }
 }
 
 BFCArena::~BFCArena() {
+  if (trim_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(trim_thread_mutex_);
+      stop_trim_thread_ = true;
+    }
+    trim_thread_cv_.notify_one();
+    trim_thread_.join();
+  }
+
   for (const auto& region : region_manager_.regions()) {
     device_allocator_->Free(region.ptr());
   }
@@ -269,9 +313,71 @@ size_t BFCArena::RoundedBytes(size_t bytes) {
 }
 
 void* BFCArena::Alloc(size_t size) {
+  if (num_size_classes_ != 0 && size != 0 && size <= memory_pressure_config_.size_class_cache_max_bytes &&
+      SizeClassIndex(size) < num_size_classes_) {
+    void* p = AllocFromSizeClassCache(size);
+    if (p != nullptr) {
+      return p;
+    }
+  }
   return AllocateRawInternal(size, false, nullptr, false, nullptr);
 }
 
+void* BFCArena::AllocFromSizeClassCache(size_t num_bytes) {
+  SizeClassCache& cache = size_class_caches_[SizeClassIndex(num_bytes)];
+  std::call_once(cache.init, [this, &cache]() {
+    void* blocks = nullptr;
+    ORT_TRY {
+      blocks = AllocateRawInternal(cache.block_size * kSizeClassCacheBlocks, false, nullptr, false, nullptr);
+    }
+    ORT_CATCH(const std::exception& ex) {
+      ORT_HANDLE_EXCEPTION([&]() {
+        LOGS_DEFAULT(WARNING) << "Unable to create the cache for size class " << cache.block_size
+                              << " of BFCArena for " << device_allocator_->Info().name << ": " << ex.what();
+      });
+    }
+    if (blocks != nullptr) {
+      for (auto& mask : cache.free_blocks) {
+        mask.bits.store(~uint64_t{0}, std::memory_order_relaxed);
+      }
+      cache.blocks.store(static_cast<char*>(blocks), std::memory_order_release);
+    }
+  });
+
+  char* blocks = cache.blocks.load(std::memory_order_acquire);
+  if (blocks != nullptr) {
+    const size_t start_word = SizeClassCacheStartWord();
+    for (size_t i = 0; i < kSizeClassCacheWords; ++i) {
+      const size_t word = (start_word + i) % kSizeClassCacheWords;
+      std::atomic<uint64_t>& mask = cache.free_blocks[word].bits;
+      uint64_t bits = mask.load(std::memory_order_relaxed);
+      while (bits != 0) {
+        const size_t bit = static_cast<size_t>(Log2FloorNonZero(bits & (~bits + 1)));
+        if (mask.compare_exchange_weak(bits, bits & ~(uint64_t{1} << bit),
+                                       std::memory_order_acquire, std::memory_order_relaxed)) {
+          size_class_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+          return blocks + (word * 64 + bit) * cache.block_size;
+        }
+      }
+    }
+  }
+
+  size_class_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+BFCArena::SizeClassCache* BFCArena::SizeClassCacheFor(const void* p) {
+  const auto p_int = reinterpret_cast<std::uintptr_t>(p);
+  for (size_t i = 0; i < num_size_classes_; ++i) {
+    SizeClassCache& cache = size_class_caches_[i];
+    const auto blocks_int = reinterpret_cast<std::uintptr_t>(cache.blocks.load(std::memory_order_acquire));
+    if (blocks_int != 0 && p_int >= blocks_int && p_int < blocks_int + cache.block_size * kSizeClassCacheBlocks) {
+      return &cache;
+    }
+  }
+  return nullptr;
+}
+
 void* BFCArena::Reserve(size_t size) {
   if (size == 0)
     return nullptr;
@@ -293,6 +399,9 @@ void* BFCArena::Reserve(size_t size) {
 }
 
 size_t BFCArena::RequestedSize(const void* ptr) {
+  if (const SizeClassCache* cache = SizeClassCacheFor(ptr)) {
+    return cache->block_size;
+  }
   std::lock_guard<std::mutex> lock(lock_);
   BFCArena::ChunkHandle h = region_manager_.get_handle(ptr);
   ORT_ENFORCE(h != kInvalidChunkHandle);
@@ -301,6 +410,9 @@ size_t BFCArena::RequestedSize(const void* ptr) {
 }
 
 size_t BFCArena::AllocatedSize(const void* ptr) {
+  if (const SizeClassCache* cache = SizeClassCacheFor(ptr)) {
+    return cache->block_size;
+  }
   std::lock_guard<std::mutex> lock(lock_);
   BFCArena::ChunkHandle h = region_manager_.get_handle(ptr);
   ORT_ENFORCE(h != kInvalidChunkHandle);
@@ -379,6 +491,8 @@ void* BFCArena::AllocateRawInternal(size_t num_bytes,
 void BFCArena::GetStats(AllocatorStats* stats) {
   std::lock_guard<std::mutex> lock(lock_);
   *stats = stats_;
+  stats->num_size_class_cache_hits = size_class_cache_hits_.load(std::memory_order_relaxed);
+  stats->num_size_class_cache_misses = size_class_cache_misses_.load(std::memory_order_relaxed);
 }
 
 BFCArena::Chunk* BFCArena::SplitFreeChunkFromBin(BFCArena::Bin::FreeChunkSet* free_chunks,
@@ -496,6 +610,14 @@ void BFCArena::Free(void* p) {
   if (p == nullptr) {
     return;
   }
+  if (num_size_classes_ != 0) {
+    if (SizeClassCache* cache = SizeClassCacheFor(p)) {
+      const size_t index = static_cast<size_t>(static_cast<char*>(p) - cache->blocks.load(std::memory_order_relaxed)) /
+                           cache->block_size;
+      cache->free_blocks[index / 64].bits.fetch_or(uint64_t{1} << (index % 64), std::memory_order_release);
+      return;
+    }
+  }
   std::lock_guard<std::mutex> lock(lock_);
   auto it = reserved_chunks_.find(p);
   if (it != reserved_chunks_.end()) {
@@ -525,42 +647,9 @@ Status BFCArena::Shrink() {
 
   size_t i = 0;
   for (void* region_ptr : region_ptrs) {
-    bool deallocate_region = true;
-    ChunkHandle region_begin_chunk = region_manager_.get_handle(region_ptr);
-    ChunkHandle h = region_begin_chunk;
-    while (h != kInvalidChunkHandle) {
-      const Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
-        // at-least one used chunk found in the allocation region -
-        // so we cannot deallocate it
-        deallocate_region = false;
-        break;
-      }
-      h = c->next;
-    }
-
-    if (deallocate_region) {
-      auto shrink_size = region_sizes[i];
-      stats_.num_arena_shrinkages += 1;
-      stats_.total_allocated_bytes -= shrink_size;
-
-      LOGS_DEFAULT(VERBOSE) << device_allocator_->Info().name << " BFC Arena shrunk by "
-                            << shrink_size << " bytes. "
-                            << " The total allocated bytes is now " << stats_.total_allocated_bytes;
-
-      h = region_begin_chunk;
-      ChunkHandle temp = region_begin_chunk;
-      while (h != kInvalidChunkHandle) {
-        const Chunk* c = ChunkFromHandle(h);
-        temp = c->next;
-        RemoveFreeChunkFromBin(h);
-        DeleteChunk(h);
-        h = temp;
-      }
-
-      device_allocator_->Free(region_ptr);
-      region_manager_.RemoveAllocationRegion(region_ptr);
-      stats_.num_arena_extensions--;
+    // if at-least one used chunk is found in the allocation region, we cannot deallocate it
+    if (!IsRegionInUse(region_ptr)) {
+      FreeRegion(region_ptr, region_sizes[i]);
     }
 
     ++i;
@@ -573,6 +662,92 @@ Status BFCArena::Shrink() {
   return Status::OK();
 }
 
+Status BFCArena::TrimIdleRegions() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (static_cast<size_t>(stats_.total_allocated_bytes) <= memory_pressure_config_.trim_high_watermark_bytes) {
+    return Status::OK();
+  }
+
+  struct IdleRegion {
+    std::chrono::steady_clock::time_point last_used;
+    void* ptr;
+    size_t size;
+  };
+  std::vector<IdleRegion> idle_regions;
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto min_idle_time = std::chrono::milliseconds(memory_pressure_config_.idle_region_release_ms);
+  for (const auto& region : region_manager_.regions()) {
+    if ((consider_first_allocation_region_for_shrinkage_ || region.id() != 0) &&
+        now - region.last_used() >= min_idle_time &&
+        !IsRegionInUse(region.ptr())) {
+      idle_regions.push_back({region.last_used(), region.ptr(), region.memory_size()});
+    }
+  }
+
+  std::sort(idle_regions.begin(), idle_regions.end(),
+            [](const IdleRegion& a, const IdleRegion& b) { return a.last_used < b.last_used; });
+
+  const size_t low_watermark = std::min(memory_pressure_config_.trim_low_watermark_bytes,
+                                        memory_pressure_config_.trim_high_watermark_bytes);
+  for (const auto& region : idle_regions) {
+    if (static_cast<size_t>(stats_.total_allocated_bytes) <= low_watermark) {
+      break;
+    }
+    FreeRegion(region.ptr, region.size);
+    stats_.num_arena_trims += 1;
+    stats_.trimmed_bytes += static_cast<int64_t>(region.size);
+  }
+
+  return Status::OK();
+}
+
+void BFCArena::TrimInBackground() {
+  const auto interval = std::chrono::milliseconds(memory_pressure_config_.background_trim_interval_ms);
+  std::unique_lock<std::mutex> lock(trim_thread_mutex_);
+  while (!trim_thread_cv_.wait_for(lock, interval, [this]() { return stop_trim_thread_; })) {
+    auto status = TrimIdleRegions();
+    if (!status.IsOK()) {
+      LOGS_DEFAULT(WARNING) << "Unable to trim arena: " << device_allocator_->Info().ToString()
+                            << " error message: " << status.ErrorMessage();
+    }
+  }
+}
+
+bool BFCArena::IsRegionInUse(void* region_ptr) {
+  ChunkHandle h = region_manager_.get_handle(region_ptr);
+  while (h != kInvalidChunkHandle) {
+    const Chunk* c = ChunkFromHandle(h);
+    if (c->in_use()) {
+      return true;
+    }
+    h = c->next;
+  }
+  return false;
+}
+
+void BFCArena::FreeRegion(void* region_ptr, size_t region_size) {
+  stats_.num_arena_shrinkages += 1;
+  stats_.total_allocated_bytes -= region_size;
+
+  LOGS_DEFAULT(VERBOSE) << device_allocator_->Info().name << " BFC Arena shrunk by "
+                        << region_size << " bytes. "
+                        << " The total allocated bytes is now " << stats_.total_allocated_bytes;
+
+  ChunkHandle h = region_manager_.get_handle(region_ptr);
+  while (h != kInvalidChunkHandle) {
+    const Chunk* c = ChunkFromHandle(h);
+    ChunkHandle next = c->next;
+    RemoveFreeChunkFromBin(h);
+    DeleteChunk(h);
+    h = next;
+  }
+
+  device_allocator_->Free(region_ptr);
+  region_manager_.RemoveAllocationRegion(region_ptr);
+  stats_.num_arena_extensions--;
+}
+
 void BFCArena::DeallocateRawInternal(void* ptr) {
   // Find the chunk from the ptr.
   BFCArena::ChunkHandle h = region_manager_.get_handle(ptr);
@@ -659,6 +834,10 @@ void BFCArena::FreeAndMaybeCoalesce(BFCArena::ChunkHandle h) {
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
 
+  if (track_region_use_) {
+    region_manager_.set_last_used(c->ptr, std::chrono::steady_clock::now());
+  }
+
   // This chunk is no longer in-use, consider coalescing the chunk
   // with adjacent chunks.
   ChunkHandle chunk_to_reassign = Coalesce(h);
@@ -856,14 +1035,17 @@ StreamAwareArena::StreamAwareArena(std::unique_ptr<IAllocator> resource_allocato
                                    int initial_chunk_size_bytes,
                                    int max_dead_bytes_per_chunk,
                                    int initial_growth_chunk_size_bytes,
-                                   int64_t max_power_of_two_extend_bytes) : BFCArena(std::move(resource_allocator),
-                                                                                     total_memory,
-                                                                                     arena_extend_strategy,
-                                                                                     initial_chunk_size_bytes,
-                                                                                     max_dead_bytes_per_chunk,
-                                                                                     initial_growth_chunk_size_bytes,
-                                                                                     max_power_of_two_extend_bytes),
-                                                                            enable_cross_stream_reusing_(enable_cross_stream_sharing) {
+                                   int64_t max_power_of_two_extend_bytes,
+                                   const ArenaMemoryPressureConfig& memory_pressure_config)
+    : BFCArena(std::move(resource_allocator),
+               total_memory,
+               arena_extend_strategy,
+               initial_chunk_size_bytes,
+               max_dead_bytes_per_chunk,
+               initial_growth_chunk_size_bytes,
+               max_power_of_two_extend_bytes,
+               memory_pressure_config),
+      enable_cross_stream_reusing_(enable_cross_stream_sharing) {
   arena_type_ = ArenaType::StreamAwareArena;
 }
 
@@ -16,9 +16,13 @@ limitations under the License.
 
 #pragma once
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <sstream>
+#include <thread>
 
 #include "onnxruntime_config.h"
 
@@ -45,6 +49,29 @@ namespace onnxruntime {
 #endif
 
 class StreamAwareArena;
+
+// Controls how a BFCArena gives memory back when it is no longer needed, and how it serves small
+// allocations without taking the arena lock. The defaults disable all of it.
+struct ArenaMemoryPressureConfig {
+  // An allocation region becomes idle when none of its chunks are in use. TrimIdleRegions() only
+  // releases regions that have been idle for at least this long.
+  int64_t idle_region_release_ms = 0;
+  // TrimIdleRegions() does nothing while the arena holds no more than trim_high_watermark_bytes.
+  // Above it, idle regions are released, least recently used first, until the arena holds no more
+  // than trim_low_watermark_bytes.
+  size_t trim_high_watermark_bytes = 0;
+  size_t trim_low_watermark_bytes = 0;
+  // If positive, a background thread calls TrimIdleRegions() at this interval. Requires a positive
+  // idle_region_release_ms, otherwise regions freed between runs would be released and allocated
+  // again on every interval.
+  int64_t background_trim_interval_ms = 0;
+  // Allocations of up to this many bytes are served from lock-free caches of fixed size blocks,
+  // one per power of 2 size class from 256 bytes to kMaxSizeClassCacheBytes. 0 disables the caches.
+  size_t size_class_cache_max_bytes = 0;
+
+  static constexpr size_t kMaxSizeClassCacheBytes = 32 * 1024;
+};
+
 // A memory allocator that implements a 'best-fit with coalescing'
 // algorithm.  This is essentially a very simple version of Doug Lea's
 // malloc (dlmalloc).
@@ -73,7 +100,8 @@ class BFCArena : public IAllocator {
            int initial_chunk_size_bytes = DEFAULT_INITIAL_CHUNK_SIZE_BYTES,
            int max_dead_bytes_per_chunk = DEFAULT_MAX_DEAD_BYTES_PER_CHUNK,
            int initial_growth_chunk_size_bytes = DEFAULT_INITIAL_GROWTH_CHUNK_SIZE_BYTES,
-           int64_t max_power_of_two_extend_bytes = DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES);
+           int64_t max_power_of_two_extend_bytes = DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES,
+           const ArenaMemoryPressureConfig& memory_pressure_config = {});
 
   ~BFCArena() override;
 
@@ -93,10 +121,17 @@ class BFCArena : public IAllocator {
   // and the allocation request.
   Status Shrink();
 
+  // Frees allocation regions that have been idle for at least idle_region_release_ms if the arena
+  // holds more than trim_high_watermark_bytes, least recently used first, until it holds no more
+  // than trim_low_watermark_bytes. Unlike Shrink(), does not reset how the arena grows.
+  // With the default ArenaMemoryPressureConfig this frees every region Shrink() would.
+  Status TrimIdleRegions();
+
   void* Reserve(size_t size) override;
 
   void GetStats(AllocatorStats* stats) override;
 
+  // For a block served from a size class cache, both return the size of the size class.
   size_t RequestedSize(const void* ptr);
 
   size_t AllocatedSize(const void* ptr);
@@ -259,6 +294,8 @@ class BFCArena : public IAllocator {
     void* end_ptr() const { return end_ptr_; }
     size_t memory_size() const { return memory_size_; }
     int64_t id() const { return id_; }
+    std::chrono::steady_clock::time_point last_used() const { return last_used_; }
+    void set_last_used(std::chrono::steady_clock::time_point t) { last_used_ = t; }
     ChunkHandle get_handle(const void* p) const {
       return handles_[IndexFor(p)];
     }
@@ -271,6 +308,7 @@ class BFCArena : public IAllocator {
       std::swap(memory_size_, other.memory_size_);
       std::swap(end_ptr_, other.end_ptr_);
       std::swap(id_, other.id_);
+      std::swap(last_used_, other.last_used_);
       std::swap(handles_, other.handles_);
     }
 
@@ -290,6 +328,10 @@ class BFCArena : public IAllocator {
     // (May be used by the client to track which allocation region was allocated first, second, and so on)
     int64_t id_ = -1;
 
+    // When a chunk of this region was last freed, or when the region was added.
+    // Only tracked if idle regions are trimmed.
+    std::chrono::steady_clock::time_point last_used_ = std::chrono::steady_clock::now();
+
     // Array of size "memory_size / kMinAllocationSize".  It is
     // indexed by (p-base) / kMinAllocationSize, contains ChunkHandle
     // for the memory allocation represented by "p"
@@ -333,6 +375,10 @@ class BFCArena : public IAllocator {
     }
     void erase(const void* p) { return MutableRegionFor(p)->erase(p); }
 
+    void set_last_used(const void* p, std::chrono::steady_clock::time_point t) {
+      MutableRegionFor(p)->set_last_used(t);
+    }
+
     const std::vector<AllocationRegion>& regions() const { return regions_; }
 
    private:
@@ -410,6 +456,44 @@ class BFCArena : public IAllocator {
   // Removes the chunk metadata represented by 'h'.
   void DeleteChunk(ChunkHandle h);
 
+  // Returns true if any chunk of the allocation region starting at 'region_ptr' is in use.
+  bool IsRegionInUse(void* region_ptr);
+
+  // Frees the allocation region starting at 'region_ptr', none of whose chunks may be in use.
+  void FreeRegion(void* region_ptr, size_t region_size);
+
+  void TrimInBackground();
+
+  // A cache of kSizeClassCacheBlocks blocks of block_size bytes, carved out of a single chunk of
+  // the arena when the size class is first used. A set bit in free_blocks marks a free block.
+  // Blocks are claimed and released with atomic operations on the bitmask, so threads allocating
+  // from the cache never take the arena lock. Each thread starts looking for a free block in a
+  // different word of the bitmask so that threads do not contend on the same cache line.
+  static constexpr size_t kSizeClassCacheWords = 4;
+  static constexpr size_t kSizeClassCacheBlocks = kSizeClassCacheWords * 64;
+  static constexpr size_t kMaxSizeClasses = 8;  // 256 bytes to ArenaMemoryPressureConfig::kMaxSizeClassCacheBytes
+
+  struct SizeClassCache {
+    struct alignas(64) FreeBlockMask {
+      std::atomic<uint64_t> bits{0};
+    };
+
+    size_t block_size = 0;
+    std::once_flag init;
+    std::atomic<char*> blocks{nullptr};
+    std::array<FreeBlockMask, kSizeClassCacheWords> free_blocks;
+  };
+
+  size_t SizeClassIndex(size_t bytes) {
+    return bytes <= kMinAllocationSize ? 0 : static_cast<size_t>(Log2FloorNonZero((bytes - 1) >> kMinAllocationBits)) + 1;
+  }
+
+  // Returns a free block of the size class of num_bytes, or nullptr if there is none.
+  void* AllocFromSizeClassCache(size_t num_bytes);
+
+  // Returns the cache that p was allocated from, or nullptr if p was not allocated from a size class cache.
+  SizeClassCache* SizeClassCacheFor(const void* p);
+
   void DumpMemoryLog(size_t num_bytes);
 
   ChunkHandle AllocateChunk();
@@ -514,6 +598,21 @@ class BFCArena : public IAllocator {
   // is to be considered for shrinkage or not.
   bool consider_first_allocation_region_for_shrinkage_;
 
+  const ArenaMemoryPressureConfig memory_pressure_config_;
+  // Whether freeing a chunk records the last use of its region, which TrimIdleRegions() needs to
+  // check the idle time and to release the least recently used regions first.
+  bool track_region_use_ = false;
+
+  std::array<SizeClassCache, kMaxSizeClasses> size_class_caches_;
+  size_t num_size_classes_ = 0;
+  std::atomic<int64_t> size_class_cache_hits_{0};
+  std::atomic<int64_t> size_class_cache_misses_{0};
+
+  std::mutex trim_thread_mutex_;
+  std::condition_variable trim_thread_cv_;
+  bool stop_trim_thread_ = false;
+  std::thread trim_thread_;
+
   ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(BFCArena);
 };
 #ifdef ORT_ENABLE_STREAM
@@ -526,7 +625,8 @@ class StreamAwareArena : public BFCArena {
                    int initial_chunk_size_bytes = DEFAULT_INITIAL_CHUNK_SIZE_BYTES,
                    int max_dead_bytes_per_chunk = DEFAULT_MAX_DEAD_BYTES_PER_CHUNK,
                    int initial_growth_chunk_size_bytes = DEFAULT_INITIAL_GROWTH_CHUNK_SIZE_BYTES,
-                   int64_t max_power_of_two_extend_bytes = DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES);
+                   int64_t max_power_of_two_extend_bytes = DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES,
+                   const ArenaMemoryPressureConfig& memory_pressure_config = {});
 
   // If size is 0, then this function returns either NULL,
   // or a unique pointer value that can later be successfully
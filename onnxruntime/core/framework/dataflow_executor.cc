@@ -0,0 +1,345 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/dataflow_executor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "core/common/parse_string.h"
+#include "core/framework/sequential_executor.h"
+#include "core/framework/stream_execution_context.h"
+#include "core/platform/threadpool.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
+
+namespace onnxruntime {
+
+namespace {
+
+constexpr int64_t kDefaultInlineCostMicroseconds = 20;
+
+// Operators that are usually expensive enough to be worth a thread pool dispatch before their cost is known.
+constexpr std::string_view kExpensiveOps[] = {
+    "Attention", "Conv", "ConvTranspose", "DynamicQuantizeMatMul", "Einsum", "FusedConv", "FusedGemm",
+    "FusedMatMul", "Gemm", "GroupQueryAttention", "GRU", "If", "Loop", "LSTM", "MatMul", "MatMulInteger",
+    "MatMulNBits", "MultiHeadAttention", "QLinearConv", "QLinearMatMul", "RNN", "Scan"};
+
+bool IsExpensiveOp(const std::string& op_type) {
+  return std::find(std::begin(kExpensiveOps), std::end(kExpensiveOps), op_type) != std::end(kExpensiveOps);
+}
+
+template <typename T>
+Status ReadConfig(const ConfigOptions& config_options, const char* key, T& value) {
+  const auto entry = config_options.GetConfigEntry(key);
+  if (entry.has_value()) {
+    ORT_RETURN_IF_NOT(TryParseStringWithClassicLocale(*entry, value) && value >= 0,
+                      "Invalid value of session config entry ", key, ": ", *entry);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status DataflowSchedule::Create(const GraphViewer& graph_viewer, const SequentialExecutionPlan& plan,
+                                const ConfigOptions& config_options, std::unique_ptr<DataflowSchedule>& schedule) {
+  schedule.reset();
+  if (config_options.GetConfigOrDefault(kOrtSessionOptionsDataflowExecution, "0") != "1") {
+    return Status::OK();
+  }
+
+  // cross-stream synchronization steps are only created when there is more than one stream
+  if (!plan.notification_owners.empty() || plan.num_barriers != 0) {
+    return Status::OK();
+  }
+
+  const SequentialExecutionPlan::LogicStream* stream = nullptr;
+  size_t stream_idx = 0;
+  for (size_t i = 0; i < plan.execution_plan.size(); ++i) {
+    const auto& logic_stream = plan.execution_plan[i];
+    if (logic_stream && !logic_stream->steps_.empty()) {
+      if (stream != nullptr) {
+        return Status::OK();
+      }
+      stream = logic_stream.get();
+      stream_idx = i;
+    }
+  }
+
+  if (stream == nullptr || stream->device_.Type() != OrtDevice::CPU ||
+      stream->steps_.size() != static_cast<size_t>(graph_viewer.NumberOfNodes())) {
+    return Status::OK();
+  }
+
+  int max_concurrent_nodes = 0;
+  int64_t inline_cost_us = kDefaultInlineCostMicroseconds;
+  ORT_RETURN_IF_ERROR(ReadConfig(config_options, kOrtSessionOptionsDataflowMaxConcurrentNodes, max_concurrent_nodes));
+  ORT_RETURN_IF_ERROR(ReadConfig(config_options, kOrtSessionOptionsDataflowInlineCostMicroseconds, inline_cost_us));
+
+  std::unique_ptr<DataflowSchedule> result(new DataflowSchedule());
+  result->stream_idx_ = stream_idx;
+  result->max_concurrent_nodes_ = max_concurrent_nodes;
+  result->inline_cost_ns_ = inline_cost_us * 1000;
+
+  constexpr size_t kNotInStream = std::numeric_limits<size_t>::max();
+  std::vector<size_t> position(graph_viewer.MaxNodeIndex(), kNotInStream);
+  result->nodes_.reserve(stream->steps_.size());
+  for (const auto& step : stream->steps_) {
+    const NodeIndex node_index = step->GetNodeIndex();
+    const Node* node = graph_viewer.GetNode(node_index);
+    if (node == nullptr || position[node_index] != kNotInStream) {
+      return Status::OK();
+    }
+
+    position[node_index] = result->nodes_.size();
+    result->nodes_.push_back(NodeInfo{node_index, 0, {}, IsExpensiveOp(node->OpType())});
+  }
+
+  for (size_t i = 0; i < result->nodes_.size(); ++i) {
+    const Node& node = *graph_viewer.GetNode(result->nodes_[i].node_index);
+    InlinedHashSet<size_t> producers;
+    for (auto it = node.InputEdgesBegin(), end = node.InputEdgesEnd(); it != end; ++it) {
+      const size_t producer = position[it->GetNode().Index()];
+      if (producer != kNotInStream && producers.insert(producer).second) {
+        result->nodes_[producer].successors.push_back(i);
+      }
+    }
+
+    result->nodes_[i].num_predecessors = static_cast<int32_t>(producers.size());
+    if (producers.empty()) {
+      result->roots_.push_back(i);
+    }
+  }
+
+  result->avg_cost_ns_ = std::make_unique<std::atomic<int64_t>[]>(result->nodes_.size());
+  for (size_t i = 0; i < result->nodes_.size(); ++i) {
+    result->avg_cost_ns_[i].store(0, std::memory_order_relaxed);
+  }
+
+  schedule = std::move(result);
+  return Status::OK();
+}
+
+bool DataflowSchedule::IsCheap(size_t node) const {
+  const int64_t avg_cost = avg_cost_ns_[node].load(std::memory_order_relaxed);
+  if (avg_cost == 0) {
+    return !nodes_[node].expensive_op;
+  }
+  return avg_cost < inline_cost_ns_;
+}
+
+void DataflowSchedule::RecordCost(size_t node, int64_t cost_ns) const {
+  cost_ns = std::max<int64_t>(cost_ns, 1);
+  // concurrent runs may race on the update. losing a sample is fine for a scheduling hint.
+  const int64_t avg_cost = avg_cost_ns_[node].load(std::memory_order_relaxed);
+  avg_cost_ns_[node].store(avg_cost == 0 ? cost_ns : avg_cost + (cost_ns - avg_cost) / 8,
+                           std::memory_order_relaxed);
+}
+
+// State of one run of a DataflowSchedule.
+//
+// Each worker runs nodes until it finds no more work. When a node completes, its ready consumers that are cheap
+// are run by the same worker. Of the expensive ones, the worker keeps one as its continuation and publishes the
+// rest to a shared queue, starting new workers on the inter-op thread pool while fewer than the maximum number of
+// nodes are running.
+//
+// A worker is only counted once its task has started on the thread pool, and the calling thread keeps taking nodes
+// from the queue while it waits for the other workers. A nested run, e.g. in the subgraph of an If node, therefore
+// never waits on tasks queued behind it on the same thread pool. Tasks that start after the run has completed find
+// the queue empty and exit, so they hold a reference to the execution rather than to the caller's stack.
+class DataflowSchedule::Execution : public std::enable_shared_from_this<DataflowSchedule::Execution> {
+ public:
+  Execution(const DataflowSchedule& schedule, StreamExecutionContext& ctx, SessionScope& session_scope,
+            concurrency::ThreadPool* tp, const bool& terminate_flag)
+      : schedule_(schedule),
+        ctx_(ctx),
+        session_scope_(session_scope),
+        tp_(tp),
+        terminate_flag_(terminate_flag),
+        pending_(std::make_unique<std::atomic<int32_t>[]>(schedule.nodes_.size())) {
+    for (size_t i = 0; i < schedule_.nodes_.size(); ++i) {
+      pending_[i].store(schedule_.nodes_[i].num_predecessors, std::memory_order_relaxed);
+    }
+
+    // the intra-op thread pool is shared by all running nodes, so default to the inter-op parallelism
+    const int dop = concurrency::ThreadPool::DegreeOfParallelism(tp_);
+    max_workers_ = schedule_.max_concurrent_nodes_ > 0 ? std::min(schedule_.max_concurrent_nodes_, dop) : dop;
+    max_workers_ = std::max(max_workers_, 1);
+  }
+
+  Status Run() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // the calling thread is the first worker
+      active_workers_ = 1;
+    }
+    Publish(schedule_.roots_);
+    WorkerLoop();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      // run the nodes published by the other workers instead of waiting for a thread pool task to pick them up
+      cv_.wait(lock, [this]() { return active_workers_ == 0 || !queue_.empty(); });
+      if (queue_.empty()) {
+        break;
+      }
+      ++active_workers_;
+      lock.unlock();
+      WorkerLoop();
+      lock.lock();
+    }
+    return status_;
+  }
+
+ private:
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+  void Publish(gsl::span<const size_t> nodes) {
+    if (nodes.empty()) {
+      return;
+    }
+
+    int workers_to_start = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.insert(queue_.end(), nodes.begin(), nodes.end());
+      workers_to_start = std::min(static_cast<int>(std::min<size_t>(nodes.size(), max_workers_)),
+                                  std::max(max_workers_ - active_workers_ - starting_workers_, 0));
+      starting_workers_ += workers_to_start;
+    }
+    // wake up the calling thread if it is waiting for the other workers
+    cv_.notify_all();
+
+    for (int i = 0; i < workers_to_start; ++i) {
+      concurrency::ThreadPool::Schedule(tp_, [self = shared_from_this()]() {
+        {
+          std::lock_guard<std::mutex> lock(self->mutex_);
+          --self->starting_workers_;
+          ++self->active_workers_;
+        }
+        self->WorkerLoop();
+      });
+    }
+  }
+
+  void WorkerLoop() {
+    InlinedVector<size_t> cheap;
+    InlinedVector<size_t> expensive;
+    size_t continuation = kNone;
+
+    for (;;) {
+      size_t node = kNone;
+      if (!cheap.empty()) {
+        node = cheap.back();
+        cheap.pop_back();
+      } else if (continuation != kNone) {
+        node = continuation;
+        continuation = kNone;
+      } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+          if (--active_workers_ == 0) {
+            cv_.notify_all();
+          }
+          return;
+        }
+        node = queue_.front();
+        queue_.pop_front();
+      }
+
+      RunNode(node);
+
+      expensive.clear();
+      for (size_t successor : schedule_.nodes_[node].successors) {
+        if (pending_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          if (schedule_.IsCheap(successor)) {
+            cheap.push_back(successor);
+          } else if (continuation == kNone) {
+            continuation = successor;
+          } else {
+            expensive.push_back(successor);
+          }
+        }
+      }
+
+      Publish(expensive);
+    }
+  }
+
+  void RunNode(size_t node) {
+    if (failed_.load(std::memory_order_acquire)) {
+      // keep walking the graph so that every worker drains, but do not run anything else
+      return;
+    }
+
+#ifdef ENABLE_TRAINING
+    // same filter as LaunchKernelStep: nodes that the requested fetches do not depend on are skipped,
+    // their successors are still released
+    const auto* node_to_execute = ctx_.GetNodeToExecute();
+    if (node_to_execute && node_to_execute->count(schedule_.nodes_[node].node_index) == 0) {
+      return;
+    }
+#endif
+
+    Status status;
+    if (terminate_flag_) {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Exiting due to terminate flag being set to true.");
+    } else {
+      const auto start = std::chrono::steady_clock::now();
+      ORT_TRY {
+        status = ExecuteKernel(ctx_, schedule_.nodes_[node].node_index, schedule_.stream_idx_, terminate_flag_,
+                               session_scope_);
+      }
+      ORT_CATCH(const std::exception& ex) {
+        ORT_HANDLE_EXCEPTION([&]() {
+          status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, ex.what());
+        });
+      }
+      schedule_.RecordCost(node, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+    }
+
+    if (!status.IsOK()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (status_.IsOK()) {
+        status_ = std::move(status);
+      }
+      failed_.store(true, std::memory_order_release);
+    }
+  }
+
+  const DataflowSchedule& schedule_;
+  StreamExecutionContext& ctx_;
+  SessionScope& session_scope_;
+  concurrency::ThreadPool* const tp_;
+  const bool& terminate_flag_;
+
+  // number of producers of each node that have not completed yet in this run
+  std::unique_ptr<std::atomic<int32_t>[]> pending_;
+  int max_workers_ = 1;
+
+  std::mutex mutex_;
+  // signaled when nodes are published and when the last active worker exits
+  std::condition_variable cv_;
+  std::deque<size_t> queue_;
+  // workers running WorkerLoop, and thread pool tasks scheduled to become workers that have not started yet
+  int active_workers_ = 0;
+  int starting_workers_ = 0;
+  Status status_;
+  std::atomic<bool> failed_{false};
+};
+
+Status ExecuteDataflow(const DataflowSchedule& schedule, StreamExecutionContext& ctx, SessionScope& session_scope,
+                       concurrency::ThreadPool* tp, const bool& terminate_flag) {
+  // thread pool tasks may outlive the run, see DataflowSchedule::Execution
+  auto execution = std::make_shared<DataflowSchedule::Execution>(schedule, ctx, session_scope, tp, terminate_flag);
+  return execution->Run();
+}
+
+}  // namespace onnxruntime
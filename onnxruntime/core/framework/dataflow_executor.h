@@ -0,0 +1,90 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "core/common/common.h"
+#include "core/common/inlined_containers.h"
+#include "core/framework/config_options.h"
+#include "core/framework/sequential_execution_plan.h"
+#include "core/graph/graph_viewer.h"
+
+namespace onnxruntime {
+
+class SessionScope;
+class StreamExecutionContext;
+
+namespace concurrency {
+class ThreadPool;
+}
+
+/**
+ * Dependency graph of the nodes of a single CPU stream, used to run independent branches concurrently.
+ *
+ * The sequential plan serializes all nodes of a stream even when they do not depend on each other.
+ * In ORT_PARALLEL mode the allocation planner does not reuse buffers between values, so any topological
+ * order is valid and nodes can be started as soon as their producers have completed.
+ *
+ * The schedule also keeps a running average of the cost of every node. Cheap nodes are run on the thread
+ * that made them ready as the overhead of dispatching them to the thread pool would exceed their run time.
+ */
+class DataflowSchedule {
+ public:
+  /**
+   * Build the schedule for `plan`.
+   * `schedule` is left empty if dataflow execution is disabled or the plan is not eligible for it, i.e.
+   * the nodes are spread over several streams, the stream is not on a CPU device, or the stream contains
+   * steps other than kernel launches.
+   */
+  static Status Create(const GraphViewer& graph_viewer, const SequentialExecutionPlan& plan,
+                       const ConfigOptions& config_options, std::unique_ptr<DataflowSchedule>& schedule);
+
+  size_t NumNodes() const { return nodes_.size(); }
+
+ private:
+  friend Status ExecuteDataflow(const DataflowSchedule& schedule, StreamExecutionContext& ctx,
+                                SessionScope& session_scope, concurrency::ThreadPool* tp,
+                                const bool& terminate_flag);
+
+  class Execution;
+
+  struct NodeInfo {
+    NodeIndex node_index;
+    // number of distinct producers in the same stream
+    int32_t num_predecessors;
+    // positions in nodes_ of the consumers
+    InlinedVector<size_t> successors;
+    // static hint used until the cost of the node has been measured
+    bool expensive_op;
+  };
+
+  DataflowSchedule() = default;
+
+  bool IsCheap(size_t node) const;
+
+  void RecordCost(size_t node, int64_t cost_ns) const;
+
+  size_t stream_idx_ = 0;
+  InlinedVector<NodeInfo> nodes_;
+  InlinedVector<size_t> roots_;
+
+  int max_concurrent_nodes_ = 0;
+  int64_t inline_cost_ns_ = 0;
+
+  // exponentially weighted average of the run time of each node in nanoseconds. 0 if not measured yet.
+  mutable std::unique_ptr<std::atomic<int64_t>[]> avg_cost_ns_;
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(DataflowSchedule);
+};
+
+/**
+ * Run all nodes of `schedule` in dependency order, using `tp` to run ready nodes concurrently.
+ * The calling thread participates and returns once every node has completed or been skipped after an error.
+ */
+Status ExecuteDataflow(const DataflowSchedule& schedule, StreamExecutionContext& ctx, SessionScope& session_scope,
+                       concurrency::ThreadPool* tp, const bool& terminate_flag);
+
+}  // namespace onnxruntime
@@ -406,11 +406,14 @@ ExecutionFrame::ExecutionFrame(gsl::span<const int> feed_mlvalue_idxs, gsl::span
 
     // if there are some traditional ml value type in inputs disable the memory pattern optimization.
     if (all_tensors) {
-      mem_patterns_ = session_state.GetMemoryPatternGroup(feeds, feed_mlvalue_idxs, inferred_shapes_);
+      shape_plan_ = session_state.GetShapeSpecializedPlan(feeds, feed_mlvalue_idxs);
       // if no existing patterns, generate one in this execution frame
-      if (!mem_patterns_) {
+      if (!shape_plan_) {
         planner_.emplace(*session_state.GetExecutionPlan());
       } else {
+        mem_patterns_ = &shape_plan_->MemoryPatterns();
+        inferred_shapes_ = &shape_plan_->InferredShapes();
+        const bool retain_buffers = session_state.GetShapePlanCache().RetainBuffers();
         // pre-allocate the big chunk requested in memory pattern.
         // all the internal kernel's input/output tensors will be allocated on these buffer.
         buffers_.reserve(mem_patterns_->locations.size());
@@ -418,6 +421,15 @@ ExecutionFrame::ExecutionFrame(gsl::span<const int> feed_mlvalue_idxs, gsl::span
           const auto& location = mem_patterns_->locations[i];
           ORT_ENFORCE(buffers_.find(location) == buffers_.end());
           if (mem_patterns_->patterns[i].PeakSize() > 0) {
+            // a block left behind by a previous run with the same shapes can be used as is
+            if (retain_buffers && location.Type() == OrtDevice::CPU) {
+              auto retained = shape_plan_->AcquireBuffer(location);
+              if (retained != nullptr) {
+                buffers_[location] = std::move(retained);
+                continue;
+              }
+            }
+
             AllocatorPtr alloc = GetAllocator(location);
             void* buffer = nullptr;
             // it's possible we can't allocate the large block. if we have memory patterns we know we have successfully
@@ -492,7 +504,16 @@ ExecutionFrame::ExecutionFrame(gsl::span<const int> feed_mlvalue_idxs, gsl::span
   }
 }
 
-ExecutionFrame::~ExecutionFrame() = default;
+ExecutionFrame::~ExecutionFrame() {
+  // hand the pattern blocks back to the plan so the next run with the same shapes skips the allocator
+  if (shape_plan_ && session_state_.GetShapePlanCache().RetainBuffers()) {
+    for (auto& buffer : buffers_) {
+      if (buffer.first.Type() == OrtDevice::CPU) {
+        shape_plan_->ReleaseBuffer(buffer.first, std::move(buffer.second));
+      }
+    }
+  }
+}
 
 Status ExecutionFrame::CopyTensor(const Tensor& src, Tensor& dest) const {
   return session_state_.GetDataTransferMgr().CopyTensor(src, dest);
@@ -14,6 +14,7 @@
 #include "core/framework/node_index_info.h"
 #include "core/framework/ort_value_pattern_planner.h"
 #include "core/framework/sequential_execution_plan.h"
+#include "core/framework/shape_plan_cache.h"
 #include "core/framework/tensor.h"
 #include "core/graph/graph_viewer.h"
 
@@ -228,9 +229,11 @@ class ExecutionFrame final : public IExecutionFrame {
   // map of index to custom allocator
   InlinedHashMap<int, IExecutor::CustomAllocator> custom_allocators_;
 
-  // If we already have cached memory pattern on these input shapes
-  // Use this mem pattern that create a big chunk for all the internal
+  // If we already have a cached plan for these input shapes
+  // use its mem pattern that create a big chunk for all the internal
   // kernel's input/output tensors.
+  // shape_plan_ owns mem_patterns_ and inferred_shapes_ and keeps them alive for the frame's lifetime.
+  std::shared_ptr<const ShapeSpecializedPlan> shape_plan_;
   const MemoryPatternGroup* mem_patterns_;
 
   // If no cached memory pattern, and we enable the memory pattern optimization
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/external_data_mapper.h"
+
+#include <filesystem>
+#include <limits>
+
+#include "core/common/narrow.h"
+#include "core/common/safeint.h"
+
+namespace onnxruntime {
+
+namespace {
+
+void ReleaseMappedRegion(void* param) noexcept {
+  // the region keeps the whole file mapping alive
+  delete reinterpret_cast<std::shared_ptr<const void>*>(param);
+}
+
+}  // namespace
+
+Status ExternalDataFileMapper::GetRegion(const std::basic_string<ORTCHAR_T>& file_path, FileOffsetType offset,
+                                         size_t length, void*& region, OrtCallback& region_deleter) {
+  region = nullptr;
+  region_deleter = OrtCallback{nullptr, nullptr};
+  if (!map_files_ || length == 0) {
+    return Status::OK();
+  }
+
+  auto it = files_.find(file_path);
+  if (it == files_.end()) {
+    std::shared_ptr<MappedFile> mapped_file;
+    std::error_code error;
+    const auto file_length = std::filesystem::file_size(file_path, error);
+    if (!error && file_length > 0 && file_length <= std::numeric_limits<size_t>::max()) {
+      Env::MappedMemoryPtr memory;
+      if (env_.MapFileIntoMemory(file_path.c_str(), 0, narrow<size_t>(file_length), memory).IsOK()) {
+        mapped_file = std::make_shared<MappedFile>();
+        mapped_file->memory = std::move(memory);
+        mapped_file->length = narrow<size_t>(file_length);
+      }
+    }
+
+    it = files_.emplace(file_path, std::move(mapped_file)).first;
+  }
+
+  const auto& mapped_file = it->second;
+  if (mapped_file == nullptr) {
+    return Status::OK();
+  }
+
+  SafeInt<FileOffsetType> end_of_region(offset);
+  end_of_region += length;
+  ORT_RETURN_IF(offset < 0 || static_cast<size_t>(static_cast<FileOffsetType>(end_of_region)) > mapped_file->length,
+                "External data region at offset ", offset, " with length ", length,
+                " is out of bounds of the file with length ", mapped_file->length);
+
+  region = mapped_file->memory.get() + offset;
+  region_deleter = OrtCallback{ReleaseMappedRegion, new std::shared_ptr<const void>(mapped_file)};
+  return Status::OK();
+}
+
+}  // namespace onnxruntime
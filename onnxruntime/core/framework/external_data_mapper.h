@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "core/common/common.h"
+#include "core/framework/callback.h"
+#include "core/platform/env.h"
+
+namespace onnxruntime {
+
+/**
+ * Maps the files holding external initializer data into memory so that initializers can reference them in place.
+ *
+ * Each file is mapped once, as a whole, the first time one of its regions is requested. Every region handed out
+ * holds a reference to the mapping and the file is unmapped when the last region is released, so the mapper itself
+ * only needs to live while initializers are being loaded.
+ * As the mappings are backed by the file, sessions and processes loading the same model share the physical pages.
+ */
+class ExternalDataFileMapper {
+ public:
+  // If `map_files` is false no file is mapped and GetRegion always returns a null region.
+  ExternalDataFileMapper(const Env& env, bool map_files) : env_(env), map_files_(map_files) {}
+
+  bool MapFiles() const { return map_files_; }
+
+  /**
+   * Get `length` bytes at `offset` in `file_path`.
+   * `region` is set to nullptr if the file could not be mapped, e.g. because it is too large for the address space.
+   * The caller must invoke `region_deleter` once it no longer uses the region.
+   */
+  Status GetRegion(const std::basic_string<ORTCHAR_T>& file_path, FileOffsetType offset, size_t length,
+                   void*& region, OrtCallback& region_deleter);
+
+ private:
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(ExternalDataFileMapper);
+
+  struct MappedFile {
+    Env::MappedMemoryPtr memory;
+    size_t length = 0;
+  };
+
+  const Env& env_;
+  const bool map_files_;
+  // nullptr for files that failed to map so that the mapping is not retried for each of their regions
+  std::unordered_map<std::basic_string<ORTCHAR_T>, std::shared_ptr<MappedFile>> files_;
+};
+
+}  // namespace onnxruntime
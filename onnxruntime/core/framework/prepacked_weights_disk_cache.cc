@@ -0,0 +1,249 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/prepacked_weights_disk_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "core/common/cpuid_info.h"
+#include "core/common/narrow.h"
+#include "core/common/safeint.h"
+#include "core/framework/murmurhash3.h"
+#include "core/mlas/inc/mlas.h"
+#include "core/mlas/inc/mlas_qnbit.h"
+#include "onnxruntime_config.h"
+
+namespace onnxruntime {
+
+namespace {
+
+constexpr char kEntryMagic[8] = {'O', 'R', 'T', 'P', 'P', 'W', '\0', '\0'};
+constexpr uint32_t kEntryFormatVersion = 1;
+
+struct EntryHeader {
+  char magic[8];
+  uint32_t format_version;
+  uint32_t num_buffers;
+  uint64_t fingerprint;
+  uint64_t key[2];
+  // followed by num_buffers uint64_t buffer sizes, and the buffers at kBufferAlignment aligned offsets
+};
+
+size_t AlignEntryOffset(size_t offset) {
+  constexpr size_t alignment = PrepackedWeightsDiskCache::kBufferAlignment;
+  return (SafeInt<size_t>(offset) + (alignment - 1)) / alignment * alignment;
+}
+
+void AppendRaw(std::string& data, const void* value, size_t size) {
+  data.append(static_cast<const char*>(value), size);
+}
+
+}  // namespace
+
+PrepackedWeightsDiskCache::KeyBuilder& PrepackedWeightsDiskCache::KeyBuilder::Add(const std::string& value) {
+  Add(static_cast<int64_t>(value.size()));
+  data_.append(value);
+  return *this;
+}
+
+PrepackedWeightsDiskCache::KeyBuilder& PrepackedWeightsDiskCache::KeyBuilder::Add(int64_t value) {
+  AppendRaw(data_, &value, sizeof(value));
+  return *this;
+}
+
+PrepackedWeightsDiskCache::KeyBuilder& PrepackedWeightsDiskCache::KeyBuilder::AddBytes(
+    gsl::span<const std::byte> data) {
+  // MurmurHash3 takes an int length so hash in chunks
+  constexpr size_t kChunkSize = size_t{1} << 30;
+  Add(narrow<int64_t>(data.size()));
+  for (size_t offset = 0; offset < data.size(); offset += kChunkSize) {
+    const size_t chunk_size = std::min(kChunkSize, data.size() - offset);
+    uint64_t digest[2];
+    MurmurHash3::x86_128(data.data() + offset, static_cast<int>(chunk_size), 0, digest);
+    AppendRaw(data_, digest, sizeof(digest));
+  }
+  return *this;
+}
+
+PrepackedWeightsDiskCache::Key PrepackedWeightsDiskCache::KeyBuilder::Build() const {
+  Key key;
+  MurmurHash3::x86_128(data_.data(), narrow<int>(data_.size()), 0, key.data());
+  return key;
+}
+
+PrepackedWeightsDiskCache::PrepackedWeightsDiskCache(const Env& env, std::filesystem::path cache_dir,
+                                                     const logging::Logger& logger)
+    : env_(env), cache_dir_(std::move(cache_dir)), logger_(logger), fingerprint_(PlatformFingerprint()) {
+}
+
+uint64_t PrepackedWeightsDiskCache::PlatformFingerprint() {
+  const auto& cpuid_info = CPUIDInfo::GetCPUIDInfo();
+
+  KeyBuilder builder;
+  builder.Add(ORT_VERSION)
+      .Add(static_cast<int64_t>(sizeof(void*)))
+      .Add(cpuid_info.HasAVX())
+      .Add(cpuid_info.HasAVX2())
+      .Add(cpuid_info.HasAVX512f())
+      .Add(cpuid_info.HasAVX512Skylake())
+      .Add(cpuid_info.HasAVX512_BF16())
+      .Add(cpuid_info.HasAMX_BF16())
+      .Add(cpuid_info.HasF16C())
+      .Add(cpuid_info.HasArmNeonDot())
+      .Add(cpuid_info.HasArmNeon_I8MM())
+      .Add(cpuid_info.HasArmSVE_I8MM())
+      .Add(cpuid_info.HasArmNeon_BF16())
+      .Add(cpuid_info.HasFp16VectorAcceleration());
+  for (uint32_t feature_register : cpuid_info.GetFeatureRegisters()) {
+    builder.Add(static_cast<int64_t>(feature_register));
+  }
+
+  // the packed layouts are chosen by the MLAS kernels dispatched on this platform
+  builder.Add(narrow<int64_t>(MlasGemmPackBSize(64, 64)))
+      .Add(narrow<int64_t>(MlasGemmPackBSize(64, 64, false, true)))
+      .Add(narrow<int64_t>(MlasGemmPackBSize(64, 64, false, false)));
+  for (auto compute_type : {SQNBIT_CompFp32, HQNBIT_CompFp16, SQNBIT_CompInt8}) {
+    builder.Add(MlasIsQNBitGemmAvailable(4, 32, compute_type))
+        .Add(narrow<int64_t>(MlasQNBitGemmPackQuantBDataSize(64, 64, 4, 32, compute_type)));
+  }
+
+  return builder.Build()[0];
+}
+
+std::filesystem::path PrepackedWeightsDiskCache::EntryPath(const Key& key) const {
+  std::ostringstream name;
+  name << std::hex << std::setfill('0') << std::setw(16) << key[0] << std::setw(16) << key[1] << ".prepacked";
+  return cache_dir_ / name.str();
+}
+
+bool PrepackedWeightsDiskCache::Load(const Key& key, std::vector<BufferUniquePtr>& buffers,
+                                     std::vector<size_t>& buffer_sizes) {
+  buffers.clear();
+  buffer_sizes.clear();
+
+  const auto entry_path = EntryPath(key);
+  std::error_code error;
+  const auto file_size = std::filesystem::file_size(entry_path, error);
+  if (error || file_size < sizeof(EntryHeader) || file_size > std::numeric_limits<size_t>::max()) {
+    return false;
+  }
+
+  const size_t entry_size = static_cast<size_t>(file_size);
+  Env::MappedMemoryPtr entry;
+  auto status = env_.MapFileIntoMemory(entry_path.native().c_str(), 0, entry_size, entry);
+  if (!status.IsOK()) {
+    LOGS(logger_, WARNING) << "Failed to map pre-packed weights cache entry " << entry_path << ": "
+                           << status.ErrorMessage();
+    return false;
+  }
+
+  EntryHeader header;
+  memcpy(&header, entry.get(), sizeof(header));
+  if (memcmp(header.magic, kEntryMagic, sizeof(kEntryMagic)) != 0 || header.format_version != kEntryFormatVersion ||
+      header.fingerprint != fingerprint_ || header.key[0] != key[0] || header.key[1] != key[1]) {
+    LOGS(logger_, VERBOSE) << "Ignoring stale pre-packed weights cache entry " << entry_path;
+    return false;
+  }
+
+  const size_t sizes_end = sizeof(EntryHeader) + SafeInt<size_t>(header.num_buffers) * sizeof(uint64_t);
+  if (sizes_end > entry_size) {
+    LOGS(logger_, WARNING) << "Ignoring malformed pre-packed weights cache entry " << entry_path;
+    return false;
+  }
+
+  std::vector<BufferUniquePtr> entry_buffers;
+  std::vector<size_t> entry_buffer_sizes;
+  size_t offset = sizes_end;
+  for (uint32_t i = 0; i < header.num_buffers; ++i) {
+    uint64_t buffer_size;
+    memcpy(&buffer_size, entry.get() + sizeof(EntryHeader) + i * sizeof(uint64_t), sizeof(buffer_size));
+    offset = AlignEntryOffset(offset);
+    if (buffer_size > entry_size - std::min(offset, entry_size)) {
+      LOGS(logger_, WARNING) << "Ignoring truncated pre-packed weights cache entry " << entry_path;
+      return false;
+    }
+
+    // BufferDeleter is nullptr as the buffers live in the mapping owned by the cache
+    entry_buffers.emplace_back(entry.get() + offset, BufferDeleter(nullptr));
+    entry_buffer_sizes.push_back(static_cast<size_t>(buffer_size));
+    offset += static_cast<size_t>(buffer_size);
+  }
+
+  buffers = std::move(entry_buffers);
+  buffer_sizes = std::move(entry_buffer_sizes);
+  mapped_entries_.emplace_back(key, std::move(entry));
+  return true;
+}
+
+void PrepackedWeightsDiskCache::Release(const Key& key) {
+  mapped_entries_.erase(std::remove_if(mapped_entries_.begin(), mapped_entries_.end(),
+                                       [&key](const auto& mapped_entry) { return mapped_entry.first == key; }),
+                        mapped_entries_.end());
+}
+
+Status PrepackedWeightsDiskCache::Store(const Key& key, gsl::span<const gsl::span<const std::byte>> buffers) {
+  std::error_code error;
+  std::filesystem::create_directories(cache_dir_, error);
+  ORT_RETURN_IF(error, "Failed to create the pre-packed weights cache directory ", cache_dir_, ": ", error.message());
+
+  const auto entry_path = EntryPath(key);
+
+  // an entry is only stored when it was missing or rejected, so drop any mapping of it before the file is replaced.
+  // Windows can't replace a mapped file, and elsewhere the mapping would keep the old file alive for nothing.
+  Release(key);
+
+  // a name unique to this process and entry so that concurrent writers don't share the temporary file
+  auto temp_path = entry_path;
+  temp_path += "." + std::to_string(env_.GetSelfPid()) + "." + std::to_string(num_stored_entries_++) + ".tmp";
+
+  EntryHeader header{};
+  memcpy(header.magic, kEntryMagic, sizeof(kEntryMagic));
+  header.format_version = kEntryFormatVersion;
+  header.num_buffers = narrow<uint32_t>(buffers.size());
+  header.fingerprint = fingerprint_;
+  header.key[0] = key[0];
+  header.key[1] = key[1];
+
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    ORT_RETURN_IF(!out, "Failed to create pre-packed weights cache entry ", temp_path);
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& buffer : buffers) {
+      const uint64_t buffer_size = buffer.size();
+      out.write(reinterpret_cast<const char*>(&buffer_size), sizeof(buffer_size));
+    }
+
+    const char padding[kBufferAlignment] = {};
+    size_t offset = sizeof(header) + buffers.size() * sizeof(uint64_t);
+    for (const auto& buffer : buffers) {
+      const size_t aligned_offset = AlignEntryOffset(offset);
+      out.write(padding, narrow<std::streamsize>(aligned_offset - offset));
+      out.write(reinterpret_cast<const char*>(buffer.data()), narrow<std::streamsize>(buffer.size()));
+      offset = aligned_offset + buffer.size();
+    }
+
+    out.close();
+    if (!out) {
+      std::filesystem::remove(temp_path, error);
+      return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Failed to write pre-packed weights cache entry ", temp_path);
+    }
+  }
+
+  std::filesystem::rename(temp_path, entry_path, error);
+  if (error) {
+    const auto message = error.message();
+    std::filesystem::remove(temp_path, error);
+    return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Failed to write pre-packed weights cache entry ", entry_path, ": ",
+                           message);
+  }
+
+  return Status::OK();
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "core/common/common.h"
+#include "core/common/logging/logging.h"
+#include "core/framework/buffer_deleter.h"
+#include "core/platform/env.h"
+
+namespace onnxruntime {
+
+/**
+ * Persists the pre-packed weights of kernels in a directory so that later processes can map them instead of
+ * packing the weights again.
+ *
+ * Each entry holds the pre-packed buffers of one kernel input and is stored in its own file, named after the key.
+ * The key must identify everything the packed data depends on (see KeyBuilder). The entry records a fingerprint of
+ * the ONNX Runtime version and the CPU features MLAS dispatches on, and entries with a different fingerprint are
+ * treated as missing so they are re-packed and overwritten.
+ *
+ * Entries are written to a temporary file which is then renamed, so concurrent writers and readers of the same
+ * directory never observe a partially written entry.
+ */
+class PrepackedWeightsDiskCache {
+ public:
+  using Key = std::array<uint64_t, 2>;
+
+  // Accumulates the data identifying a set of pre-packed buffers into a Key.
+  class KeyBuilder {
+   public:
+    KeyBuilder& Add(const std::string& value);
+    KeyBuilder& Add(int64_t value);
+    // Large data is hashed as it is added, so only a digest of it is kept.
+    KeyBuilder& AddBytes(gsl::span<const std::byte> data);
+
+    Key Build() const;
+
+   private:
+    std::string data_;
+  };
+
+  PrepackedWeightsDiskCache(const Env& env, std::filesystem::path cache_dir, const logging::Logger& logger);
+
+  // Fingerprint of the ONNX Runtime version and the platform features the packed data layouts depend on.
+  static uint64_t PlatformFingerprint();
+
+  /**
+   * Look up the buffers stored for `key`.
+   * On a hit `buffers` holds non-owning pointers into a mapping of the entry that stays valid for the lifetime of
+   * the cache and `buffer_sizes` their sizes in bytes. Each buffer is aligned to kBufferAlignment bytes.
+   * Missing, stale or malformed entries are misses.
+   */
+  bool Load(const Key& key, std::vector<BufferUniquePtr>& buffers, std::vector<size_t>& buffer_sizes);
+
+  // Unmap the entry loaded for `key` when its buffers were not used. Buffers returned by Load for it become invalid.
+  void Release(const Key& key);
+
+  // Write the buffers for `key`, replacing any existing entry. A loaded mapping of the entry is released first.
+  Status Store(const Key& key, gsl::span<const gsl::span<const std::byte>> buffers);
+
+  static constexpr size_t kBufferAlignment = 64;
+
+ private:
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(PrepackedWeightsDiskCache);
+
+  std::filesystem::path EntryPath(const Key& key) const;
+
+  const Env& env_;
+  const std::filesystem::path cache_dir_;
+  const logging::Logger& logger_;
+  const uint64_t fingerprint_;
+  size_t num_stored_entries_ = 0;
+  // mappings of the loaded entries, the kernels reference the buffers in place
+  std::vector<std::pair<Key, Env::MappedMemoryPtr>> mapped_entries_;
+};
+
+}  // namespace onnxruntime
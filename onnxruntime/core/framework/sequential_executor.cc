@@ -10,6 +10,7 @@
 #include "core/common/common.h"
 #include "core/common/logging/logging.h"
 #include "core/framework/allocation_planner.h"
+#include "core/framework/dataflow_executor.h"
 #include "core/framework/execution_frame.h"
 #include "core/framework/stream_execution_context.h"
 #include "core/framework/session_state.h"
@@ -346,6 +347,13 @@ class KernelScope {
                                input_activation_sizes_, input_parameter_sizes_,
                                node_name_, input_type_shape_);
     }
+
+    sampling_profiler_ = session_state_.Profiler().GetSamplingProfiler();
+    if (sampling_profiler_ && sampling_profiler_->ShouldSample()) {
+      sample_begin_time_ = std::chrono::steady_clock::now();
+    } else {
+      sampling_profiler_ = nullptr;
+    }
   }
 
   ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(KernelScope);
@@ -355,6 +363,21 @@ class KernelScope {
     node_compute_range_.End();
 #endif
 
+    if (sampling_profiler_) {
+      const auto duration = std::chrono::steady_clock::now() - sample_begin_time_;
+      size_t output_bytes = 0;
+      for (int i = 0, end = kernel_context_.OutputCount(); i < end; i++) {
+        const OrtValue* p_output = kernel_context_.GetOutputMLValue(i);
+        if (p_output != nullptr && p_output->IsTensor()) {
+          output_bytes += p_output->Get<Tensor>().SizeInBytes();
+        }
+      }
+      sampling_profiler_->RecordNode(
+          kernel_.Node().OpType(),
+          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()),
+          output_bytes);
+    }
+
     if (session_state_.Profiler().IsEnabled()) {
       auto& profiler = session_state_.Profiler();
       std::string output_type_shape_;
@@ -409,6 +432,10 @@ class KernelScope {
   size_t total_output_sizes_{};
   std::string input_type_shape_;
 
+  // Set only if this node run is sampled.
+  profiling::SamplingProfiler* sampling_profiler_{};
+  std::chrono::steady_clock::time_point sample_begin_time_;
+
 #ifdef CONCURRENCY_VISUALIZER
   diagnostic::span span_;
 #endif
@@ -567,21 +594,27 @@ onnxruntime::Status ExecuteThePlan(const SessionState& session_state, gsl::span<
 
   auto* tp = single_thread_mode ? nullptr : session_state.GetInterOpThreadPool();
 
-  for (size_t i = 0; i < execution_plan->execution_plan.size(); ++i) {
-    if (execution_plan->execution_plan[i]->steps_.empty()) {
-      // execution context is initialized with number of valid streams
-      // for invalid stream (0 steps), it doesn't count in number of tasks
-      // so don't need to invoke CompleteTask here
-      // ctx.CompleteTask();
-    } else {
-      concurrency::ThreadPool::Schedule(tp, [i, &ctx, &terminate_flag, &session_scope]() {
-        RunSince(i, ctx, session_scope, terminate_flag, 0);
-      });
+  const auto* dataflow_schedule = session_state.GetDataflowSchedule();
+  if (tp != nullptr && dataflow_schedule != nullptr) {
+    // all nodes are in one CPU stream. run independent nodes of it concurrently instead of in plan order.
+    ORT_RETURN_IF_ERROR(ExecuteDataflow(*dataflow_schedule, ctx, session_scope, tp, terminate_flag));
+  } else {
+    for (size_t i = 0; i < execution_plan->execution_plan.size(); ++i) {
+      if (execution_plan->execution_plan[i]->steps_.empty()) {
+        // execution context is initialized with number of valid streams
+        // for invalid stream (0 steps), it doesn't count in number of tasks
+        // so don't need to invoke CompleteTask here
+        // ctx.CompleteTask();
+      } else {
+        concurrency::ThreadPool::Schedule(tp, [i, &ctx, &terminate_flag, &session_scope]() {
+          RunSince(i, ctx, session_scope, terminate_flag, 0);
+        });
+      }
     }
-  }
 
-  ctx.WaitAll();
-  ORT_RETURN_IF_ERROR(ctx.TaskStatus());
+    ctx.WaitAll();
+    ORT_RETURN_IF_ERROR(ctx.TaskStatus());
+  }
   ORT_RETURN_IF_ERROR(ctx.GetExecutionFrame().GetOutputs(fetches));
   if (ctx.GetExecutionFrame().HasMemoryPatternPlanner()) {
     bool all_tensors = true;
@@ -3,10 +3,15 @@
 
 #include "core/framework/session_state.h"
 
+#include <functional>
+#include <map>
+#include <optional>
 #include <sstream>
 
 #include <mutex>
 #include "core/common/logging/logging.h"
+#include "core/common/parse_string.h"
+#include "core/common/path_string.h"
 #include "core/common/safeint.h"
 #include "core/flatbuffers/schema/ort.fbs.h"
 #include "core/framework/allocator.h"
@@ -89,6 +94,12 @@ SessionState::SessionState(Graph& graph,
 {
   enable_mem_pattern_ = sess_options_.enable_mem_pattern &&
                         sess_options_.execution_mode == ExecutionMode::ORT_SEQUENTIAL;
+  if (enable_mem_pattern_) {
+    shape_plan_cache_.SetCapacity(ParseStringWithClassicLocale<size_t>(
+        sess_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsShapePlanCacheCapacity, "64")));
+    shape_plan_cache_.SetRetainBuffers(
+        sess_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsShapePlanCacheRetainBuffers, "0") == "1");
+  }
   if (parent_allocators) {
     allocators_ = parent_allocators;
   } else {
@@ -396,12 +407,92 @@ static std::string GenerateKeyForPrepackedWeightsMap(const std::string& op_type,
   return ss_1.str();
 }
 
+// The persisted pre-packed weights of a node depend on the kernel, its attributes and constant inputs, and the
+// session configuration the kernel may read.
+static PrepackedWeightsDiskCache::Key GenerateKeyForPersistedPrepackedWeights(
+    const Node& node, const OpKernel& kernel, const std::function<const Tensor*(const std::string&)>& get_constant) {
+  PrepackedWeightsDiskCache::KeyBuilder builder;
+  builder.Add(node.Domain())
+      .Add(node.OpType())
+      .Add(node.SinceVersion())
+      .Add(node.GetExecutionProviderType());
+
+  int64_t input_idx = 0;
+  for (const auto* input_def : node.InputDefs()) {
+    builder.Add(input_idx++);
+    if (!input_def->Exists()) {
+      continue;
+    }
+    builder.Add(input_def->Type() != nullptr ? *input_def->Type() : std::string());
+    const Tensor* constant = get_constant(input_def->Name());
+    if (constant != nullptr && !constant->IsDataTypeString()) {
+      builder.Add(constant->GetElementType());
+      for (auto dim : constant->Shape().GetDims()) {
+        builder.Add(dim);
+      }
+      builder.AddBytes(gsl::make_span(static_cast<const std::byte*>(constant->DataRaw()), constant->SizeInBytes()));
+    }
+  }
+
+  for (const auto* output_def : node.OutputDefs()) {
+    builder.Add(output_def->Exists() && output_def->Type() != nullptr ? *output_def->Type() : std::string());
+  }
+
+  const auto& attributes = node.GetAttributes();
+  std::map<std::string, std::string> sorted_attributes;
+  for (const auto& attribute : attributes) {
+    sorted_attributes.emplace(attribute.first, attribute.second.SerializeAsString());
+  }
+  for (const auto& attribute : sorted_attributes) {
+    builder.Add(attribute.first).Add(attribute.second);
+  }
+
+  const auto& configurations = kernel.Info().GetConfigOptions().configurations;
+  std::map<std::string, std::string> sorted_configurations(configurations.begin(), configurations.end());
+  sorted_configurations.erase(kOrtSessionOptionsPrepackedWeightsCacheDir);
+  for (const auto& configuration : sorted_configurations) {
+    builder.Add(configuration.first).Add(configuration.second);
+  }
+
+  return builder.Build();
+}
+
 Status SessionState::PrepackConstantInitializedTensors(InlinedHashMap<std::string, size_t>& constant_initializers_use_count,
                                                        const std::unordered_map<std::string, const OrtValue*>& initializers_to_share_map) {
-  auto prepacked_constant_weights = [this, &constant_initializers_use_count, &initializers_to_share_map](
+  // find the constant initialized tensor for the input of a node in this or an outer scope graph
+  auto get_constant_initialized_tensor = [this](const std::string& input_name) -> const Tensor* {
+    SessionState* st = this;
+    do {
+      int ort_value_idx;
+      if (st->GetOrtValueNameIdxMap().GetIdx(input_name, ort_value_idx).IsOK()) {
+        auto it = st->constant_initialized_tensors_.find(ort_value_idx);
+        if (it != st->constant_initialized_tensors_.end()) {
+          return &it->second.Get<Tensor>();
+        }
+        if (st != this || !st->graph_.IsOuterScopeValue(input_name)) {
+          break;
+        }
+      }
+      st = st->Parent();
+    } while (st);
+    return nullptr;
+  };
+
+  // pre-packed weights to write to the disk cache once all the constant initializers of their kernel are pre-packed
+  struct PersistedPrepackedWeightsToWrite {
+    const OpKernel* kernel;
+    int input_idx;
+    PrepackedWeightsDiskCache::Key key;
+  };
+  std::vector<PersistedPrepackedWeightsToWrite> persisted_weights_to_write;
+
+  auto prepacked_constant_weights = [this, &constant_initializers_use_count, &initializers_to_share_map,
+                                     &get_constant_initialized_tensor, &persisted_weights_to_write](
                                         bool should_cache_prepacked_weights_for_shared_initializers) -> Status {
     for (auto& node : GetGraphViewer().Nodes()) {
       auto kernel = GetMutableKernel(node.Index());
+      // computed for the first constant initializer of the node, before any of them is released
+      std::optional<PrepackedWeightsDiskCache::Key> persisted_node_key;
       int input_idx = 0;
       for (auto& input_def : node.InputDefs()) {
         if (input_def->Exists()) {
@@ -479,12 +570,49 @@ Status SessionState::PrepackConstantInitializedTensors(InlinedHashMap<std::strin
                   }
 
                 } else {  // caching of pre-packed weights' turned OFF
-                  AllocatorPtr session_cpu_alloc = GetAllocator(kernel->Info().GetDevice(OrtMemType::OrtMemTypeDefault));
-                  ORT_RETURN_IF_ERROR(kernel->PrePack(const_initialized_tensor, input_idx,
-                                                      session_cpu_alloc,  // use allocator tied to this session
-                                                      is_packed,
-                                                      nullptr  // no caching required
-                                                      ));
+                  std::optional<PrepackedWeightsDiskCache::Key> persisted_key;
+                  if (prepacked_weights_disk_cache_ != nullptr) {
+                    if (!persisted_node_key.has_value()) {
+                      persisted_node_key = GenerateKeyForPersistedPrepackedWeights(node, *kernel,
+                                                                                   get_constant_initialized_tensor);
+                    }
+                    persisted_key = PrepackedWeightsDiskCache::KeyBuilder()
+                                        .Add(static_cast<int64_t>((*persisted_node_key)[0]))
+                                        .Add(static_cast<int64_t>((*persisted_node_key)[1]))
+                                        .Add(input_idx)
+                                        .Build();
+
+                    std::vector<BufferUniquePtr> persisted_buffers;
+                    std::vector<size_t> persisted_buffer_sizes;
+                    if (prepacked_weights_disk_cache_->Load(*persisted_key, persisted_buffers,
+                                                            persisted_buffer_sizes)) {
+                      ORT_RETURN_IF_ERROR(kernel->UsePersistedPrePackedBuffers(const_initialized_tensor,
+                                                                               persisted_buffers,
+                                                                               persisted_buffer_sizes, input_idx,
+                                                                               is_packed));
+                      if (!is_packed) {
+                        // the kernel rejected the entry, so it is packed again and the entry overwritten
+                        prepacked_weights_disk_cache_->Release(*persisted_key);
+                      }
+                    }
+                  }
+
+                  if (is_packed) {
+                    LOGS(logger_, INFO) << "Using persisted pre-packed weight for constant initializer: " << input_name
+                                        << " used in the node: " << node.Name() << " which is of op type: "
+                                        << node.OpType();
+                    ++used_persisted_pre_packed_weights_counter_;
+                  } else {
+                    AllocatorPtr session_cpu_alloc = GetAllocator(kernel->Info().GetDevice(OrtMemType::OrtMemTypeDefault));
+                    ORT_RETURN_IF_ERROR(kernel->PrePack(const_initialized_tensor, input_idx,
+                                                        session_cpu_alloc,  // use allocator tied to this session
+                                                        is_packed,
+                                                        nullptr  // no caching required
+                                                        ));
+                    if (is_packed && persisted_key.has_value()) {
+                      persisted_weights_to_write.push_back({kernel, input_idx, *persisted_key});
+                    }
+                  }
                 }
                 if (is_packed) {
                   ++number_of_prepacks_counter_;
@@ -519,18 +647,29 @@ Status SessionState::PrepackConstantInitializedTensors(InlinedHashMap<std::strin
     // serialize calls to the method that looks up the container, calls UseCachedPrePackedWeight/PrePack
     // and writes pre-packed weights to the container
     std::lock_guard<std::mutex> l(prepacked_weights_container_->mutex_);
-    return prepacked_constant_weights(true);
+    ORT_RETURN_IF_ERROR(prepacked_constant_weights(true));
   } else {
-    return prepacked_constant_weights(false);
+    ORT_RETURN_IF_ERROR(prepacked_constant_weights(false));
   }
-}
 
-static int64_t CalculateMemoryPatternsKey(const gsl::span<const OrtValue>& tensor_inputs) {
-  int64_t key = 0;
-  for (const auto& input : tensor_inputs) {
-    for (auto dim : input.Get<Tensor>().Shape().GetDims()) key ^= dim;
+  // a kernel may update the pre-packed buffers of an input while pre-packing its other inputs,
+  // so they are only written once all of them are pre-packed
+  for (const auto& weights_to_write : persisted_weights_to_write) {
+    std::vector<gsl::span<const std::byte>> buffers;
+    ORT_RETURN_IF_ERROR(weights_to_write.kernel->GetPrePackedBuffersToPersist(weights_to_write.input_idx, buffers));
+    if (buffers.empty()) {
+      continue;
+    }
+
+    auto status = prepacked_weights_disk_cache_->Store(weights_to_write.key, buffers);
+    if (!status.IsOK()) {
+      // the cache is an optimization, so failing to write it is not an error for the session
+      LOGS(logger_, WARNING) << "Failed to persist pre-packed weights of node "
+                             << weights_to_write.kernel->Node().Name() << ": " << status.ErrorMessage();
+    }
   }
-  return key;
+
+  return Status::OK();
 }
 
 #ifdef ENABLE_TRAINING
@@ -767,38 +906,26 @@ Status SessionState::GeneratePatternGroupCache(gsl::span<const OrtValue> tensor_
 
 #endif
 
-// MemoryPatternGroup pointer is cached. It only inserted upon creation
-// and is not updated if already present.
-const MemoryPatternGroup* SessionState::GetMemoryPatternGroup(
+std::shared_ptr<const ShapeSpecializedPlan> SessionState::GetShapeSpecializedPlan(
     gsl::span<const OrtValue> tensor_inputs,
-    gsl::span<const int> feed_mlvalue_idxs,
-    const InlinedHashMap<int, TensorShape>*& out_inferred_shapes) const {
-  out_inferred_shapes = nullptr;
-  int64_t key = CalculateMemoryPatternsKey(tensor_inputs);
-  std::lock_guard<std::mutex> lock(mem_patterns_lock_);
-  auto it = mem_patterns_.find(key);
-  if (it == mem_patterns_.end()) {
-#ifdef ENABLE_TRAINING
-    MemoryPatternGroup mem_patterns;
-    InlinedHashMap<int, TensorShape> inferred_shapes;
-    if (GeneratePatternGroupCache(tensor_inputs, feed_mlvalue_idxs, mem_patterns, inferred_shapes).IsOK()) {
-      auto patt_insert = mem_patterns_.insert_or_assign(key, std::move(mem_patterns));
-      auto ptr = &patt_insert.first->second;
-      auto shape_insert = shape_patterns_.insert_or_assign(key, std::move(inferred_shapes));
-      out_inferred_shapes = &shape_insert.first->second;
-      return ptr;
-    }
-#else
-    ORT_UNUSED_PARAMETER(feed_mlvalue_idxs);
-#endif
-    return nullptr;
+    gsl::span<const int> feed_mlvalue_idxs) const {
+  const auto key = ShapePlanCache::MakeKey(tensor_inputs);
+  auto plan = shape_plan_cache_.Find(key);
+  if (plan) {
+    return plan;
   }
 
-  auto patt_hit = shape_patterns_.find(key);
-  if (patt_hit != shape_patterns_.cend()) {
-    out_inferred_shapes = &patt_hit->second;
+#ifdef ENABLE_TRAINING
+  MemoryPatternGroup mem_patterns;
+  InlinedHashMap<int, TensorShape> inferred_shapes;
+  if (GeneratePatternGroupCache(tensor_inputs, feed_mlvalue_idxs, mem_patterns, inferred_shapes).IsOK()) {
+    return shape_plan_cache_.Insert(
+        key, std::make_shared<ShapeSpecializedPlan>(std::move(mem_patterns), std::move(inferred_shapes)));
   }
-  return &it->second;
+#else
+  ORT_UNUSED_PARAMETER(feed_mlvalue_idxs);
+#endif
+  return nullptr;
 }
 
 void SessionState::ResolveMemoryPatternFlag() {
@@ -849,11 +976,10 @@ void SessionState::ResolveMemoryPatternFlag() {
 
 Status SessionState::UpdateMemoryPatternGroupCache(gsl::span<const OrtValue> tensor_inputs,
                                                    MemoryPatternGroup mem_patterns) const {
-  int64_t key = CalculateMemoryPatternsKey(tensor_inputs);
-
-  std::lock_guard<std::mutex> lock(mem_patterns_lock_);
-  // Do not update if present, as the pointer to the existing one is cached
-  mem_patterns_.emplace(key, std::move(mem_patterns));
+  // Do not update if present, as the existing plan may be in use by other runs
+  shape_plan_cache_.Insert(ShapePlanCache::MakeKey(tensor_inputs),
+                           std::make_shared<ShapeSpecializedPlan>(std::move(mem_patterns),
+                                                                  InlinedHashMap<int, TensorShape>{}));
   return Status::OK();
 }
 
@@ -1475,6 +1601,16 @@ Status SessionState::FinalizeSessionStateImpl(const std::basic_string<PATH_CHAR_
   }
 #endif
 
+  if (session_options.execution_mode == ExecutionMode::ORT_PARALLEL) {
+#ifdef ORT_ENABLE_STREAM
+    if (!has_device_stream_enabled_ep_)
+#endif
+    {
+      ORT_RETURN_IF_ERROR(DataflowSchedule::Create(*graph_viewer_, *p_seq_exec_plan_, session_options.config_options,
+                                                   dataflow_schedule_));
+    }
+  }
+
   ORT_RETURN_IF_ERROR(
       session_state_utils::SaveInitializedTensors(
           Env::Default(), graph_location, *graph_viewer_,
@@ -1506,6 +1642,13 @@ Status SessionState::FinalizeSessionStateImpl(const std::basic_string<PATH_CHAR_
   ORT_RETURN_IF_ERROR(CreateKernels(kernel_registry_manager));
 
   if (!disable_prepacking) {
+    const auto prepacked_weights_cache_dir =
+        session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsPrepackedWeightsCacheDir, "");
+    if (!prepacked_weights_cache_dir.empty()) {
+      prepacked_weights_disk_cache_ = std::make_unique<PrepackedWeightsDiskCache>(
+          Env::Default(), ToPathString(prepacked_weights_cache_dir), logger_);
+    }
+
     ORT_RETURN_IF_ERROR(PrepackConstantInitializedTensors(constant_initializers_use_count,
                                                           session_options.initializers_to_share_map));
   }
@@ -20,15 +20,18 @@
 #include "core/framework/allocation_planner.h"
 #include "core/framework/callback.h"
 #include "core/framework/data_transfer_manager.h"
+#include "core/framework/dataflow_executor.h"
 #include "core/framework/external_data_loader_manager.h"
 #include "core/framework/execution_providers.h"
 #include "core/framework/stream_execution_context.h"
 #include "core/framework/feeds_fetches_manager.h"
 #include "core/framework/framework_common.h"
 #include "core/framework/prepacked_weights_container.h"
+#include "core/framework/prepacked_weights_disk_cache.h"
 #include "core/framework/fuse_nodes_funcs.h"
 #include "core/framework/kernel_registry_manager.h"
 #include "core/framework/mem_pattern.h"
+#include "core/framework/shape_plan_cache.h"
 #include "core/framework/ort_value.h"
 #include "core/framework/node_index_info.h"
 #include "core/framework/op_kernel.h"
@@ -215,18 +218,14 @@ class SessionState {
 #endif
 
   /**
-  Get cached memory pattern based on input shapes
-  Must be called only when all values contain tensors
-  In training scenarios, the cache may be updated so
-  the callers would receive a copy of inferred shapes
-  made under mutex being held. In inference scenarios,
-  it is not mutable, we do not obtain a lock and simply get a pointer
-  w/o copying a hashtable
+  Get the cached shape specialized plan for the given input shapes.
+  Must be called only when all values contain tensors.
+  Returns nullptr on a cache miss. In training builds the plan is generated from static shape
+  inference on a miss where possible.
+  The returned plan stays valid for as long as the caller holds it, even if it is evicted.
   */
-  const MemoryPatternGroup* GetMemoryPatternGroup(
-      gsl::span<const OrtValue> tensor_inputs,
-      gsl::span<const int> feed_mlvalue_idxs,
-      const InlinedHashMap<int, TensorShape>*& inferred_shapes) const;
+  std::shared_ptr<const ShapeSpecializedPlan> GetShapeSpecializedPlan(gsl::span<const OrtValue> tensor_inputs,
+                                                                      gsl::span<const int> feed_mlvalue_idxs) const;
 
   /**
   Set generated memory pattern with a given input shapes.
@@ -236,6 +235,17 @@ class SessionState {
   Status UpdateMemoryPatternGroupCache(gsl::span<const OrtValue> tensor_inputs,
                                        MemoryPatternGroup mem_patterns) const;
 
+  /**
+  Get the cache of shape specialized plans. Exposes the hit/miss counters.
+  */
+  const ShapePlanCache& GetShapePlanCache() const { return shape_plan_cache_; }
+
+  /**
+  Get the dependency graph used to run the nodes of a CPU-only plan concurrently in ORT_PARALLEL mode.
+  Returns nullptr if the plan is run stream by stream.
+  */
+  const DataflowSchedule* GetDataflowSchedule() const { return dataflow_schedule_.get(); }
+
   bool GetUseDeterministicCompute() const { return sess_options_.use_deterministic_compute; }
 
   /**
@@ -333,6 +343,10 @@ class SessionState {
     return used_shared_pre_packed_weights_counter_;
   }
 
+  size_t GetUsedPersistedPrePackedWeightCounter() const {
+    return used_persisted_pre_packed_weights_counter_;
+  }
+
   const KernelCreateInfoMap& GetKernelCreateInfoMap() const {
     return kernel_create_info_map_;
   }
@@ -417,6 +431,10 @@ class SessionState {
   // fused_funcs_mgr_ must live longer than the session_kernels_, becaues a kernel could be created from this manager
   FuncManager fused_funcs_mgr_;
 
+  // holds the mappings of the persisted pre-packed weights the kernels use so it must outlive session_kernels_.
+  // nullptr if kOrtSessionOptionsPrepackedWeightsCacheDir is not set.
+  std::unique_ptr<PrepackedWeightsDiskCache> prepacked_weights_disk_cache_;
+
   // cache of the constructed kernels to avoid spending construction time per executor
   std::vector<std::unique_ptr<OpKernel>> session_kernels_;
   Graph& graph_;
@@ -493,18 +511,12 @@ class SessionState {
   // switch for enable memory pattern optimization or not.
   bool enable_mem_pattern_;
 
-  // lock for the mem_patterns_
-  mutable std::mutex mem_patterns_lock_;
-  // cache for the generated mem_patterns. key is calculated based on input shapes.
-  // must be a node based container as a pointer is cached.
-  mutable NodeHashMap<int64_t, MemoryPatternGroup> mem_patterns_;
-  // This is mutable under mutex in training scenarios so execution frame would make a copy
-  // of the value when created.
-#ifdef ENABLE_TRAINING
-  mutable NodeHashMap<int64_t, InlinedHashMap<int, TensorShape>> shape_patterns_;
-#else
-  NodeHashMap<int64_t, InlinedHashMap<int, TensorShape>> shape_patterns_;
-#endif
+  // cache of memory plans keyed by the exact input shapes.
+  // capacity and buffer retention are configured from the session options.
+  ShapePlanCache shape_plan_cache_;
+
+  // set in ORT_PARALLEL mode when all nodes are in a single CPU stream
+  std::unique_ptr<DataflowSchedule> dataflow_schedule_;
 
   NameNodeInfoMapType input_names_to_nodeinfo_mapping_;
   NameNodeInfoMapType output_names_to_nodeinfo_mapping_;
@@ -559,6 +571,9 @@ class SessionState {
   // a constant initialized weight was used by the session state
   size_t used_shared_pre_packed_weights_counter_ = 0;
 
+  // Counter for number of times pre-packed weights persisted by an earlier session were used instead of pre-packing
+  size_t used_persisted_pre_packed_weights_counter_ = 0;
+
 #ifdef DEBUG_NODE_INPUTS_OUTPUTS
   // Counter for number of times the session graph has been executed
   size_t graph_executions_counter_ = 0;
@@ -1,6 +1,9 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <functional>
 #include <limits>
 #include <memory>
@@ -16,6 +19,7 @@
 #include "core/common/logging/logging.h"
 #include "core/graph/graph_viewer.h"
 #include "core/framework/data_transfer_manager.h"
+#include "core/framework/external_data_mapper.h"
 #include "core/framework/graph_partitioner.h"
 #include "core/framework/ort_value.h"
 #include "core/framework/ort_value_pattern_planner.h"
@@ -28,6 +32,7 @@
 #include "core/session/onnxruntime_session_options_config_keys.h"
 #include "core/framework/mem_buffer.h"
 #include "core/framework/tensor_allocator.h"
+#include "core/platform/path_lib.h"
 #if !defined(ORT_MINIMAL_BUILD) && defined(ORT_MEMORY_PROFILE)
 #include "core/framework/memory_info.h"
 #endif
@@ -91,6 +96,64 @@ static inline common::Status ExtDataTensorProtoToTensor(const Env& env,
   return common::Status::OK();
 }
 
+#if !defined(__wasm__)
+// Create a CPU tensor for an initializer whose data is stored at `file_offset` in `file_path`.
+// The tensor references the data in the mapped file if it is suitably aligned for the element type.
+// Otherwise the data is copied into memory from `m` or `alloc`.
+static common::Status ExternalFileDataToTensor(const Env& env, const std::basic_string<ORTCHAR_T>& file_path,
+                                               FileOffsetType file_offset, size_t data_length,
+                                               const ONNX_NAMESPACE::TensorProto& tensor_proto,
+                                               ExternalDataFileMapper& ext_data_mapper, const MemBuffer* m,
+                                               const AllocatorPtr& alloc, bool use_device_allocator_for_initializers,
+                                               OrtValue& ort_value) {
+  TensorShape tensor_shape = utils::GetTensorShapeFromTensorProto(tensor_proto);
+  const DataTypeImpl* const type = DataTypeImpl::TensorTypeFromONNXEnum(tensor_proto.data_type())->GetElementType();
+
+  void* region = nullptr;
+  OrtCallback region_deleter{nullptr, nullptr};
+  ORT_RETURN_IF_ERROR(ext_data_mapper.GetRegion(file_path, file_offset, data_length, region, region_deleter));
+
+  std::unique_ptr<Tensor> p_tensor;
+  const size_t alignment = std::max<size_t>(std::min<size_t>(type->Size(), alignof(std::max_align_t)), 1);
+  if (region != nullptr && reinterpret_cast<uintptr_t>(region) % alignment == 0) {
+    p_tensor = std::make_unique<Tensor>(type, tensor_shape, region,
+                                        OrtMemoryInfo(CPU, OrtAllocatorType::OrtDeviceAllocator));
+    if (p_tensor->SizeInBytes() != data_length) {
+      region_deleter.f(region_deleter.param);
+      return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "External data of initializer ", tensor_proto.name(), " has ",
+                             data_length, " bytes but the tensor requires ", p_tensor->SizeInBytes());
+    }
+
+    // the OrtValue owns the reference to the mapping from here
+    ExtDataValueDeleter deleter{region_deleter, p_tensor.get()};
+    MLDataType ml_tensor_type = DataTypeImpl::GetType<Tensor>();
+    ort_value.Init(p_tensor.release(), ml_tensor_type, deleter);
+    return common::Status::OK();
+  }
+
+  // the data is copied below so the mapping is not needed after this function
+  ScopedOrtCallbackInvoker region_invoker(region_deleter);
+  ORT_RETURN_IF_ERROR(AllocateTensor(m, p_tensor, type, tensor_shape, use_device_allocator_for_initializers, alloc));
+  ORT_RETURN_IF_NOT(p_tensor->SizeInBytes() == data_length, "External data of initializer ", tensor_proto.name(),
+                    " has ", data_length, " bytes but the tensor requires ", p_tensor->SizeInBytes());
+
+  if (data_length > 0) {
+    if (region != nullptr) {
+      // mapped but misaligned
+      memcpy(p_tensor->MutableDataRaw(), region, data_length);
+    } else {
+      ORT_RETURN_IF_ERROR(env.ReadFileIntoBuffer(
+          file_path.c_str(), file_offset, data_length,
+          gsl::make_span(static_cast<char*>(p_tensor->MutableDataRaw()), data_length)));
+    }
+  }
+
+  auto ml_tensor = DataTypeImpl::GetType<Tensor>();
+  ort_value.Init(p_tensor.release(), ml_tensor, ml_tensor->GetDeleteFunc());
+  return common::Status::OK();
+}
+#endif
+
 // If tensor_proto's external file path is kTensorProtoMemoryAddressTag, and
 // buffered_tensor is not null, buffered_tensor holds the real buffer pointed
 // by tensor_proto. buffered_tensor must be the owner of the buffer and deleter
@@ -100,6 +163,7 @@ static common::Status DeserializeTensorProto(const Env& env, const std::basic_st
                                              const AllocatorPtr& alloc, const AllocatorPtr& default_cpu_alloc,
                                              OrtValue& ort_value, const DataTransferManager& data_transfer_mgr,
                                              const ExternalDataLoaderManager& external_data_loader_mgr,
+                                             ExternalDataFileMapper& ext_data_mapper,
                                              bool use_device_allocator_for_initializers = false,
                                              Tensor* buffered_tensor = nullptr) {
   if (bool(alloc) == (m != nullptr)) {
@@ -131,6 +195,28 @@ static common::Status DeserializeTensorProto(const Env& env, const std::basic_st
       ort_value.Init(p_tensor.release(), ml_tensor, ml_tensor->GetDeleteFunc());
       return common::Status::OK();
     } else if (device_type == OrtDevice::CPU) {
+#if !defined(__wasm__)
+      if (buffered_tensor == nullptr) {
+        std::basic_string<ORTCHAR_T> tensor_proto_dir;
+        if (!proto_path.empty()) {
+          ORT_RETURN_IF_ERROR(GetDirNameFromFilePath(proto_path, tensor_proto_dir));
+        }
+
+        std::basic_string<ORTCHAR_T> external_data_file_path;
+        FileOffsetType file_offset;
+        SafeInt<size_t> data_length = 0;
+        ORT_RETURN_IF_ERROR(utils::GetExternalDataInfo(tensor_proto, tensor_proto_dir, external_data_file_path,
+                                                       file_offset, data_length));
+        if (external_data_file_path != utils::kTensorProtoMemoryAddressTag) {
+          return ExternalFileDataToTensor(env, external_data_file_path, file_offset, data_length, tensor_proto,
+                                          ext_data_mapper, m, alloc, use_device_allocator_for_initializers,
+                                          ort_value);
+        }
+      }
+#else
+      ORT_UNUSED_PARAMETER(ext_data_mapper);
+#endif
+
       // for external initializer on CPU we will use mmap for large initializers so don't need to allocate memory in advance
       p_tensor = std::make_unique<Tensor>();
 
@@ -305,6 +391,9 @@ common::Status SaveInitializedTensors(
     return retval;
   };
 
+  ExternalDataFileMapper ext_data_mapper(
+      env, session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsMapExternalInitializers, "1") == "1");
+
   // 1. first plan the memory
   const InitializedTensorSet& initialized_tensor_set = graph.GetAllInitializedTensors();
   InlinedHashMap<int, const ONNX_NAMESPACE::TensorProto*> id_to_initialized_tensor;
@@ -344,6 +433,11 @@ common::Status SaveInitializedTensors(
     if (user_supplied_initializer_ids.find(entry.first) != user_supplied_initializer_ids.end()) {
       continue;
     }
+    // external data on CPU references the mapped file, or gets its own buffer if it can't
+    if (ext_data_mapper.MapFiles() && utils::HasExternalData(*entry.second) &&
+        exec_plan.GetLocation(entry.first).Type() == OrtDevice::CPU) {
+      continue;
+    }
     if (entry.second->data_type() == ONNX_NAMESPACE::TensorProto_DataType_STRING) {
       // do not trace string tensor
       continue;
@@ -367,6 +461,9 @@ common::Status SaveInitializedTensors(
 
   OrtCallback deleter{nullptr, nullptr};
 
+  const bool use_device_allocator_for_initializers =
+      session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsUseDeviceAllocatorForInitializers, "0") == "1";
+
   // 3. create weight tensors based on weights buffer
   for (const auto& entry : id_to_initialized_tensor) {
     int ort_value_index = entry.first;
@@ -389,8 +486,6 @@ common::Status SaveInitializedTensors(
       AllocatorPtr alloc;
       // TODO: if the tensor need be copied, does it have enough room?
       ORT_RETURN_IF_ERROR(planner.GetPreallocatedBuffer(ort_value_index, name, m, alloc));
-      bool use_device_allocator_for_initializers =
-          session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsUseDeviceAllocatorForInitializers, "0") == "1";
 
       Tensor* p_tensor = nullptr;
       if (auto iter = buffered_tensors.find(name);
@@ -401,7 +496,7 @@ common::Status SaveInitializedTensors(
 
       Status st = DeserializeTensorProto(env, graph_loc, tensor_proto, (m.has_value()) ? &*m : nullptr, alloc,
                                          default_cpu_alloc, ort_value, data_transfer_mgr, external_data_loader_mgr,
-                                         use_device_allocator_for_initializers, p_tensor);
+                                         ext_data_mapper, use_device_allocator_for_initializers, p_tensor);
       if (!st.IsOK()) {
         std::ostringstream oss;
         oss << "Deserialize tensor " << name << " failed." << st.ErrorMessage();
@@ -0,0 +1,100 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/shape_plan_cache.h"
+
+#include "core/framework/tensor.h"
+
+namespace onnxruntime {
+
+BufferUniquePtr ShapeSpecializedPlan::AcquireBuffer(const OrtDevice& location) const {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  auto it = free_buffers_.find(location);
+  if (it == free_buffers_.end() || it->second.empty()) {
+    return BufferUniquePtr(nullptr, BufferDeleter(nullptr));
+  }
+
+  BufferUniquePtr buffer = std::move(it->second.back());
+  it->second.pop_back();
+  return buffer;
+}
+
+void ShapeSpecializedPlan::ReleaseBuffer(const OrtDevice& location, BufferUniquePtr buffer) const {
+  if (buffer == nullptr) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  free_buffers_[location].push_back(std::move(buffer));
+}
+
+ShapePlanCache::Key ShapePlanCache::MakeKey(gsl::span<const OrtValue> tensor_inputs) {
+  Key key;
+  key.reserve(tensor_inputs.size() * 4);
+  for (const auto& input : tensor_inputs) {
+    const auto dims = input.Get<Tensor>().Shape().GetDims();
+    // the rank is part of the key so that e.g. {[2, 3], [4]} and {[2], [3, 4]} differ
+    key.push_back(static_cast<int64_t>(dims.size()));
+    key.insert(key.end(), dims.begin(), dims.end());
+  }
+  return key;
+}
+
+size_t ShapePlanCache::KeyHash::operator()(const Key& key) const noexcept {
+  size_t hash = key.size();
+  for (int64_t dim : key) {
+    hash ^= std::hash<int64_t>{}(dim) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+void ShapePlanCache::SetCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = capacity;
+  EvictLocked();
+}
+
+std::shared_ptr<const ShapeSpecializedPlan> ShapePlanCache::Find(const Key& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+
+  ++stats_.hits;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->second;
+}
+
+std::shared_ptr<const ShapeSpecializedPlan> ShapePlanCache::Insert(
+    const Key& key, std::shared_ptr<const ShapeSpecializedPlan> plan) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    // another run with the same shapes got here first
+    return it->second->second;
+  }
+
+  lru_.emplace_front(key, std::move(plan));
+  index_.emplace(key, lru_.begin());
+  EvictLocked();
+  return lru_.front().second;
+}
+
+void ShapePlanCache::EvictLocked() const {
+  while (capacity_ != 0 && lru_.size() > capacity_) {
+    index_.erase(lru_.back().first);
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+ShapePlanCache::Stats ShapePlanCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.size = lru_.size();
+  return stats;
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/common/inlined_containers.h"
+#include "core/framework/buffer_deleter.h"
+#include "core/framework/mem_pattern.h"
+#include "core/framework/ort_value.h"
+#include "core/framework/tensor_shape.h"
+
+namespace onnxruntime {
+
+/**
+ * Memory plan frozen for one tuple of concrete input shapes.
+ * It holds the memory pattern (offsets of every planned activation in one contiguous block per location) and,
+ * when shape inference could resolve them, the concrete shapes of intermediate values.
+ * The blocks the pattern was laid out in can be kept with the plan between runs so that a hot shape runs
+ * without going back to the allocator for its activations.
+ */
+class ShapeSpecializedPlan {
+ public:
+  ShapeSpecializedPlan(MemoryPatternGroup mem_patterns, InlinedHashMap<int, TensorShape> inferred_shapes)
+      : mem_patterns_(std::move(mem_patterns)), inferred_shapes_(std::move(inferred_shapes)) {}
+
+  const MemoryPatternGroup& MemoryPatterns() const { return mem_patterns_; }
+
+  const InlinedHashMap<int, TensorShape>& InferredShapes() const { return inferred_shapes_; }
+
+  // Take a block previously returned by a completed run at `location`. Returns nullptr if none is available.
+  BufferUniquePtr AcquireBuffer(const OrtDevice& location) const;
+
+  // Return a block that was allocated for `location` with the peak size of this plan.
+  void ReleaseBuffer(const OrtDevice& location, BufferUniquePtr buffer) const;
+
+ private:
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(ShapeSpecializedPlan);
+
+  const MemoryPatternGroup mem_patterns_;
+  const InlinedHashMap<int, TensorShape> inferred_shapes_;
+
+  mutable std::mutex buffers_mutex_;
+  mutable InlinedHashMap<OrtDevice, InlinedVector<BufferUniquePtr>> free_buffers_;
+};
+
+/**
+ * LRU cache of ShapeSpecializedPlan instances keyed by the exact shapes of the graph inputs.
+ * Thread-safe. Plans are reference counted so an evicted plan stays valid for runs that are still using it.
+ */
+class ShapePlanCache {
+ public:
+  using Key = std::vector<int64_t>;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+  };
+
+  // A capacity of 0 means the cache is unbounded.
+  explicit ShapePlanCache(size_t capacity = 0, bool retain_buffers = false)
+      : capacity_(capacity), retain_buffers_(retain_buffers) {}
+
+  // Build the key from the rank and dims of every input. All inputs must be tensors.
+  static Key MakeKey(gsl::span<const OrtValue> tensor_inputs);
+
+  void SetCapacity(size_t capacity);
+
+  void SetRetainBuffers(bool retain_buffers) { retain_buffers_ = retain_buffers; }
+
+  // Whether blocks used by a plan should be handed back to it at the end of a run instead of being freed.
+  bool RetainBuffers() const { return retain_buffers_; }
+
+  // Look up a plan and mark it as most recently used. Updates the hit/miss counters.
+  std::shared_ptr<const ShapeSpecializedPlan> Find(const Key& key) const;
+
+  // Insert a plan unless one already exists for `key`. Evicts the least recently used plan when full.
+  std::shared_ptr<const ShapeSpecializedPlan> Insert(const Key& key,
+                                                     std::shared_ptr<const ShapeSpecializedPlan> plan) const;
+
+  Stats GetStats() const;
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const noexcept;
+  };
+
+  using Entry = std::pair<Key, std::shared_ptr<const ShapeSpecializedPlan>>;
+  using LruList = std::list<Entry>;
+
+  void EvictLocked() const;
+
+  size_t capacity_;
+  bool retain_buffers_;
+
+  mutable std::mutex mutex_;
+  // most recently used at the front
+  mutable LruList lru_;
+  mutable std::unordered_map<Key, LruList::iterator, KeyHash> index_;
+  mutable Stats stats_;
+};
+
+}  // namespace onnxruntime
@@ -318,8 +318,32 @@ void BaseGroupQueryAttentionTypeAndShapeInference(ONNX_NAMESPACE::InferenceConte
 
 void GroupQueryAttentionTypeAndShapeInference(ONNX_NAMESPACE::InferenceContext& ctx, int past_key_index) {
   // TODO(aciddelgado): propagate output shapes depending if kv-share buffer is on or not
-  constexpr int use_max_past_present_buffer = -1;
+  // The paged k-v cache (input 9, block_table) always updates the block pools in place.
+  constexpr int kBlockTableIndex = 9;
+  const int use_max_past_present_buffer = ctx.hasInput(kBlockTableIndex) ? 1 : -1;
   BaseGroupQueryAttentionTypeAndShapeInference(ctx, past_key_index, use_max_past_present_buffer);
+
+  // The quantized k-v cache holds int8 or int4 values, and a float scale per row in outputs 3 and 4.
+  const int64_t kv_cache_bit_width = getAttribute(ctx, "kv_cache_bit_width", 0);
+  if (kv_cache_bit_width != 0 && ctx.getNumOutputs() > 1) {
+    const auto cache_type = kv_cache_bit_width == 4 ? ONNX_NAMESPACE::TensorProto::INT4
+                                                    : ONNX_NAMESPACE::TensorProto::INT8;
+    ONNX_NAMESPACE::updateOutputElemType(ctx, 1, cache_type);
+    ONNX_NAMESPACE::updateOutputElemType(ctx, 2, cache_type);
+    for (size_t i = 3; i < ctx.getNumOutputs(); i++) {
+      ONNX_NAMESPACE::updateOutputElemType(ctx, i, ONNX_NAMESPACE::TensorProto::FLOAT);
+    }
+
+    constexpr int kPastKeyScaleIndex = 10;
+    if (use_max_past_present_buffer == 1 && ctx.getNumOutputs() > 4) {
+      if (hasInputShape(ctx, kPastKeyScaleIndex)) {
+        ONNX_NAMESPACE::propagateShapeFromInputToOutput(ctx, kPastKeyScaleIndex, 3);
+      }
+      if (hasInputShape(ctx, kPastKeyScaleIndex + 1)) {
+        ONNX_NAMESPACE::propagateShapeFromInputToOutput(ctx, kPastKeyScaleIndex + 1, 4);
+      }
+    }
+  }
 }
 
 void SparseAttentionTypeAndShapeInference(ONNX_NAMESPACE::InferenceContext& ctx, int past_key_index) {
@@ -1050,6 +1074,18 @@ Supports rotary position embedding for CPU and CUDA.
 Supports packed input for CPU and CUDA.
 Supports continuous decoding for batch_size == 1 for CPU and CUDA.
 
+Supports a paged k-v cache for CPU. When block_table is given, past_key and past_value are pools of fixed size blocks
+with shape (num_blocks, kv_num_heads, block_size, head_size), and block_table maps the i-th block of each sequence to
+a block of the pool. The new keys and values are written to the blocks holding positions
+[total_sequence_length - sequence_length, total_sequence_length) of each sequence, so present_key and present_value
+should share the buffer of past_key and past_value. Blocks may be shared by several sequences (like a common prompt
+prefix) as long as no new keys or values are written to them.
+
+Supports a quantized k-v cache for CPU. With kv_cache_bit_width 8 or 4, past_key, past_value, present_key and
+present_value hold int8 or int4 values, each row of head_size values being quantized symmetrically with a float scale.
+The scales are given in past_key_scale and past_value_scale and returned in present_key_scale and present_value_scale,
+with the shape of the k-v cache without the head_size dimension. It can be combined with the paged k-v cache.
+
 )DOC";
 
 ONNX_MS_OPERATOR_SET_SCHEMA(
@@ -1082,6 +1118,11 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
               "Use a smooth factor in softmax.",
               AttributeProto::INT,
               static_cast<int64_t>(-1))
+        .Attr("kv_cache_bit_width",
+              "Number of bits of the quantized k-v cache: 8 for int8, 4 for int4. Default value is 0 meaning the "
+              "k-v cache has the type of query.",
+              AttributeProto::INT,
+              static_cast<int64_t>(0))
         .Input(0,
                "query",
                "Query with shape (batch_size, sequence_length, hidden_size), or packed QKV with shape"
@@ -1101,13 +1142,13 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                "past_key",
                "past state key with support for format BNSH. When past_key uses same tensor as present_key"
                "(k-v cache), it is of length max_sequence_length... otherwise of length past_sequence_length.",
-               "T",
+               "T_CACHE",
                OpSchema::Optional)
         .Input(4,
                "past_value",
                "past state value with support for format BNSH. When past_value uses same tensor as present_value"
                "(k-v cache), it is of length max_sequence_length... otherwise of length past_sequence_length.",
-               "T",
+               "T_CACHE",
                OpSchema::Optional)
         .Input(5,
                "seqlens_k",
@@ -1128,6 +1169,22 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                "2D tensor with shape (max_sequence_length, head_size / 2).",
                "T",
                OpSchema::Optional)
+        .Input(9,
+               "block_table",
+               "2D tensor with shape (batch_size, max_blocks_per_sequence) holding the indices of the blocks of "
+               "past_key and past_value used by each sequence, in order. Enables the paged k-v cache.",
+               "M",
+               OpSchema::Optional)
+        .Input(10,
+               "past_key_scale",
+               "Scales of the quantized past_key, with the shape of past_key without the last dimension.",
+               "T_KV_SCALE",
+               OpSchema::Optional)
+        .Input(11,
+               "past_value_scale",
+               "Scales of the quantized past_value, with the shape of past_value without the last dimension.",
+               "T_KV_SCALE",
+               OpSchema::Optional)
         .Output(0,
                 "output",
                 "3D output tensor with shape (batch_size, sequence_length, hidden_size)",
@@ -1136,15 +1193,28 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                 "present_key",
                 "present state key with support for format BNSH. When past_key uses same tensor as present_key"
                 "(k-v buffer), it is of length max_sequence_length... otherwise of length past_sequence_length +"
-                "kv_sequence_length.",
-                "T")
+                "kv_sequence_length. With block_table it has the same shape as past_key.",
+                "T_CACHE")
         .Output(2,
                 "present_value",
                 "present state value with support for format BNSH. When past_value uses same tensor as present_value"
                 "(k-v buffer), it is of length max_sequence_length... otherwise of length past_sequence_length +"
-                "kv_sequence_length.",
-                "T")
+                "kv_sequence_length. With block_table it has the same shape as past_value.",
+                "T_CACHE")
+        .Output(3,
+                "present_key_scale",
+                "Scales of the quantized present_key, with the shape of present_key without the last dimension.",
+                "T_KV_SCALE",
+                OpSchema::Optional)
+        .Output(4,
+                "present_value_scale",
+                "Scales of the quantized present_value, with the shape of present_value without the last dimension.",
+                "T_KV_SCALE",
+                OpSchema::Optional)
         .TypeConstraint("T", {"tensor(float16)", "tensor(bfloat16)", "tensor(float)"}, "Constrain input and output to float tensors.")
+        .TypeConstraint("T_CACHE", {"tensor(float16)", "tensor(bfloat16)", "tensor(float)", "tensor(int8)", "tensor(int4)"},
+                        "Constrain the k-v cache to the type of query, or to int8 and int4 for the quantized k-v cache.")
+        .TypeConstraint("T_KV_SCALE", {"tensor(float)"}, "Constrain the scales of the quantized k-v cache to float tensors.")
         .TypeConstraint("M", {"tensor(int32)"}, "Constrain mask to int tensor.")
         .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
           GroupQueryAttentionTypeAndShapeInference(ctx, 3);
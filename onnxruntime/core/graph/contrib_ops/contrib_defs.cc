@@ -1321,10 +1321,22 @@ ONNX_MS_OPERATOR_SET_SCHEMA(GreedySearch, 1,
                                       "This is relevant only for the GPT2 model. If this attribute is missing, the `decoder` subgraph will be used for all decoding runs",
                                       AttributeProto::GRAPH, OPTIONAL_VALUE)
                                 .Attr("decoder", "Decoder subgraph to execute in a loop.", AttributeProto::GRAPH)
+                                .Attr("draft_decoder",
+                                      "Optional draft subgraph with the same inputs and outputs as `decoder` for speculative decoding. "
+                                      "It proposes num_speculative_tokens tokens greedily, and `decoder` verifies them in one run that takes "
+                                      "the proposed tokens as input_ids after the past state. Only supported by the CPU execution provider.",
+                                      AttributeProto::GRAPH, OPTIONAL_VALUE)
+                                .Attr("num_speculative_tokens", "Number of tokens proposed by `draft_decoder` for each run of `decoder`.",
+                                      AttributeProto::INT, static_cast<int64_t>(4))
                                 .Attr("vocab_size",
                                       "Size of the vocabulary. "
                                       "If not provided, it will be inferred from the decoder subgraph's output shape",
                                       AttributeProto::INT, static_cast<int64_t>(-1))
+                                .Attr("max_active_sequences",
+                                      "Maximum number of sequences decoded together. When it is positive, the batch of input_ids is a queue of "
+                                      "requests: finished sequences are evicted and pending requests are admitted between decoding steps. "
+                                      "Only supported by the CPU execution provider for GPT models. Default 0 decodes the whole batch together.",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
                                 .Input(0, "input_ids", "The sequence used as a prompt for the generation. Shape is (batch_size, sequence_length)", "I")
                                 .Input(1, "max_length", "The maximum length of the sequence to be generated. Shape is (1)", "I")
                                 .Input(2, "min_length", "The minimum length below which the score of eos_token_id is set to -Inf. Shape is (1)", "I", OpSchema::Optional)
@@ -1366,6 +1378,11 @@ ONNX_MS_OPERATOR_SET_SCHEMA(Sampling, 1,
                                       "Size of the vocabulary. "
                                       "If not provided, it will be inferred from the decoder subgraph's output shape",
                                       AttributeProto::INT, static_cast<int64_t>(-1))
+                                .Attr("max_active_sequences",
+                                      "Maximum number of sequences decoded together. When it is positive, the batch of input_ids is a queue of "
+                                      "requests: finished sequences are evicted and pending requests are admitted between decoding steps. "
+                                      "Only supported by the CPU execution provider for GPT models. Default 0 decodes the whole batch together.",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
                                 .Input(0, "input_ids", "The sequence used as a prompt for the generation. Shape is (batch_size, sequence_length)", "I")
                                 .Input(1, "max_length", "The maximum length of the sequence to be generated. Shape is (1)", "I")
                                 .Input(2, "min_length", "The minimum length below which the score of eos_token_id is set to -Inf. Shape is (1)", "I", OpSchema::Optional)
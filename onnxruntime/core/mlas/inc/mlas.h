@@ -81,6 +81,10 @@ Abstract:
 #define MLAS_SUPPORTS_GEMM_DOUBLE
 #endif
 
+#if defined(__linux__) && (defined(MLAS_TARGET_ARM64) || defined(MLAS_TARGET_AMD64))
+#define MLAS_SBGEMM_SUPPORTED
+#endif
+
 #if (!defined(_MSC_VER)) || (_MSC_VER >= 1930)
 #if defined(MLAS_TARGET_ARM64) || defined(MLAS_TARGET_ARM64EC)
 #if !defined(__APPLE__)
@@ -162,6 +166,9 @@ enum MLAS_ACTIVATION_KIND {
     MlasLogisticActivation,
     MlasClipActivation,
     MlasHardSigmoidActivation,
+    MlasGeluActivation,
+    MlasFastGeluActivation,
+    MlasSiluActivation,
     MlasActivationKindCount,
 };
 
@@ -200,6 +207,22 @@ MlasActivation(
 // op(X) = X or op(X) = transpose(X) or op(X) = conjg(transpose(X))
 //
 
+/**
+ * @brief Epilogue applied by the single precision GEMM to each block of the
+ *        output matrix as soon as its last K slice has been accumulated,
+ *        while the block is still in the cache:
+ *
+ *        C = Activation(C + Bias) + Residual
+ *
+ *        Unlike MlasActivation, the bias is indexed by the column of C.
+ */
+struct MLAS_SGEMM_EPILOGUE {
+    const float* Bias = nullptr;      /**< Optional bias vector of N elements added to each row */
+    MLAS_ACTIVATION Activation{MlasIdentityActivation, {{0.0f}}}; /**< Activation applied after the bias */
+    const float* Residual = nullptr;  /**< Optional M x N matrix added after the activation */
+    size_t ldr = 0;                   /**< Supplies the first dimension of matrix Residual */
+};
+
 /**
  * @brief Supply matrices data information to single precision gemm functions
  */
@@ -213,6 +236,7 @@ struct MLAS_SGEMM_DATA_PARAMS {
     float alpha = 1.0f;       /**< Supplies the scalar alpha multiplier (see SGEMM definition) */
     float beta = 0.0f;        /**< Supplies the scalar beta multiplier (see SGEMM definition) */
     bool BIsPacked = false;   /**< Whether B is pre-packed */
+    const MLAS_SGEMM_EPILOGUE* Epilogue = nullptr; /**< Optional epilogue fused into the operation */
 };
 
 /**
@@ -755,6 +779,7 @@ enum MLAS_CONV_ALGORITHM {
     MlasConvAlgorithmGemmDirect,
     MlasConvAlgorithmExpandThenGemm,
     MlasConvAlgorithmExpandThenGemmSegmented,
+    MlasConvAlgorithmWinograd,
 #if defined(MLAS_TARGET_WASM_SCALAR)
     MlasConvAlgorithmDepthwise,
 #endif
@@ -787,6 +812,13 @@ struct MLAS_CONV_PARAMETERS {
         struct {
             size_t ThreadStrideN;
         } ExpandThenGemmSegmented;
+        struct {
+            size_t OutputTile;          // output tile edge, 2 for F(2x2,3x3) or 4 for F(4x4,3x3)
+            size_t TileCount;           // output tiles per image
+            size_t TileBlockSize;       // output tiles transformed per GEMM
+            size_t PackedFilterSize;    // elements of the transformed filter
+            const float* PackedFilter;  // optional filter from MlasConvWinogradPackFilter
+        } Winograd;
     } u;
 };
 
@@ -806,7 +838,8 @@ MlasConvPrepare(MLAS_CONV_PARAMETERS* Parameters,
                 const MLAS_ACTIVATION* Activation,
                 size_t* WorkingBufferSize,
                 float Beta,
-                MLAS_THREADPOOL* ThreadPool);
+                MLAS_THREADPOOL* ThreadPool,
+                bool AllowWinograd = false);
 
 void
 MLASCALL
@@ -820,6 +853,59 @@ MlasConv(
     MLAS_THREADPOOL* ThreadPool
     );
 
+/**
+ * @brief Returns the output tile, 2 or 4, that MlasConvPrepare chooses for a
+ *        Winograd convolution with the given channels per group and output
+ *        size.
+ */
+size_t
+MLASCALL
+MlasConvWinogradOutputTile(
+    size_t InputChannels,
+    size_t FilterCount,
+    size_t OutputHeight,
+    size_t OutputWidth
+    );
+
+/**
+ * @brief Returns the number of elements of a 3x3 filter transformed for the
+ *        Winograd algorithm with the given output tile.
+ */
+size_t
+MLASCALL
+MlasConvWinogradPackedFilterSize(
+    size_t GroupCount,
+    size_t InputChannels,
+    size_t FilterCount,
+    size_t OutputTile
+    );
+
+/**
+ * @brief Transforms a 3x3 filter for the Winograd algorithm.
+ *
+ * The result may be passed as u.Winograd.PackedFilter of the parameters
+ * returned by MlasConvPrepare when the output tile matches. The working
+ * buffer then does not need the trailing u.Winograd.PackedFilterSize
+ * elements.
+ *
+ * @param GroupCount     number of channel groups
+ * @param InputChannels  number of input channels per group
+ * @param FilterCount    number of filters per group
+ * @param OutputTile     output tile edge, 2 or 4
+ * @param Filter         filter tensor of GroupCount * FilterCount * InputChannels * 9 elements
+ * @param PackedFilter   receives MlasConvWinogradPackedFilterSize elements
+ */
+void
+MLASCALL
+MlasConvWinogradPackFilter(
+    size_t GroupCount,
+    size_t InputChannels,
+    size_t FilterCount,
+    size_t OutputTile,
+    const float* Filter,
+    float* PackedFilter
+    );
+
 void
 MLASCALL
 MlasConvDepthwise(
@@ -1018,6 +1104,54 @@ MlasComputeSoftmax(
     MLAS_THREADPOOL* ThreadPool
     );
 
+/**
+ * @brief Parameters of a softmax operation with the attention score
+ *        transformations fused in. Each row of the input is transformed to
+ *
+ *            Scale * Input[n] + Bias[n] + Mask[n]
+ *
+ *        before the softmax is computed over its columns.
+ */
+struct MLAS_SOFTMAX_FUSED_PARAMS {
+    float Scale = 1.0f;           /**< Supplies the scale applied to the input */
+    const float* Bias = nullptr;  /**< Optionally supplies an additive bias of D columns per row */
+    size_t ldBias = 0;            /**< Supplies the row stride of Bias, 0 to broadcast one row to all rows */
+    const float* Mask = nullptr;  /**< Optionally supplies an additive mask of D columns per row */
+    size_t ldMask = 0;            /**< Supplies the row stride of Mask, 0 to broadcast one row to all rows */
+    bool Causal = false;          /**< Row n only attends to the columns [0, n + CausalOffset] */
+    size_t CausalOffset = 0;      /**< Supplies the number of leading columns visible to every row */
+    bool LogSoftmax = false;      /**< Whether to compute the log softmax */
+    bool SmoothSoftmax = false;   /**< Whether a smooth factor is used in the softmax */
+};
+
+/**
+ * @brief Computes the softmax or log softmax function with the scale,
+ *        additive bias and mask and causal masking fused into a single pass
+ *        over each row. Columns hidden by the causal mask produce zero (or
+ *        negative infinity for log softmax).
+ *
+ *        N.B. This implementation supports in place updates of the output
+ *        buffer.
+ *
+ * @param Input      Supplies the input buffer.
+ * @param Output     Supplies the output buffer.
+ * @param N          Supplies the number of rows to process.
+ * @param D          Supplies the number of columns per row to process.
+ * @param Params     Supplies the fused transformations of the input.
+ * @param ThreadPool Supplies the thread pool object to use, else nullptr if the
+                     base library threading support should be used.
+ */
+void
+MLASCALL
+MlasComputeSoftmax(
+    const float* Input,
+    float* Output,
+    size_t N,
+    size_t D,
+    const MLAS_SOFTMAX_FUSED_PARAMS& Params,
+    MLAS_THREADPOOL* ThreadPool
+    );
+
 void
 MLASCALL
 MlasComputeTanh(
@@ -1026,6 +1160,57 @@ MlasComputeTanh(
     size_t N
     );
 
+void
+MLASCALL
+MlasComputeGeluErf(
+    const float* Input,
+    float* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeSilu(
+    const float* Input,
+    float* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeSoftplus(
+    const float* Input,
+    float* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeLog(
+    const float* Input,
+    float* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeElu(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Alpha
+    );
+
+void
+MLASCALL
+MlasComputeSelu(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Alpha,
+    float Gamma
+    );
+
 //
 // Transpose routines.
 //
@@ -1435,12 +1620,77 @@ MLAS_FP16* Destination,
 size_t Count
 );
 
+/**
+ * @brief Half precision forms of the transcendental routines. The values are
+ *        computed in single precision and rounded to half precision.
+ */
+
+void
+MLASCALL
+MlasComputeGeluErf(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeSilu(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeSoftplus(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeLog(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    );
+
+void
+MLASCALL
+MlasComputeElu(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N,
+    float Alpha
+    );
+
+void
+MLASCALL
+MlasComputeSelu(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N,
+    float Alpha,
+    float Gamma
+    );
+
     /**
  * @brief Whether current CPU supports FP16 acceleration.
 */
 bool MLASCALL
 MlasFp16AccelerationSupported();
 
+/**
+ * @brief Whether MlasHalfGemmBatch has a vectorized kernel on the current
+ *        CPU, instead of the slow reference implementation. On x64 this
+ *        only requires AVX2/FMA3/F16C, the other fp16 kernels may still
+ *        be unavailable.
+*/
+bool MLASCALL
+MlasHalfGemmAccelerationSupported();
+
 /**
  * @brief Interface for half gemm post processors.
  *
@@ -1643,7 +1893,7 @@ MlasHalfGemmConvertPackB(
     void* PackedB
     );
 
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(MLAS_SBGEMM_SUPPORTED)
 /**
  * @brief Whether current CPU supports Bfloat16(bf16) acceleration.
  */
@@ -1855,13 +2105,34 @@ struct MlasFlashAttentionThreadedArgs {
     const float* key;
     const float* value;
     float* output;
+    /** Number of K/V heads, each shared by num_heads / kv_num_heads query heads. 0 means num_heads. */
+    int kv_num_heads = 0;
+    /** Distance in rows between two K/V heads, e.g. the max length of a KV cache. 0 means kv_sequence_length. */
+    int kv_buffer_sequence_length = 0;
+    /** Distance in elements between two batches of the query, e.g. for packed QKV. 0 means dense BxNxSxH. */
+    size_t query_batch_stride = 0;
+    /** Optional number of valid keys of each batch, the remaining keys are padding. */
+    const int32_t* kv_sequence_lengths = nullptr;
+    /**
+     * Query i of a batch with L valid keys attends the keys up to i + max(L - q_sequence_length, 0),
+     * so the queries are the last positions of the sequence.
+     */
+    bool is_causal = false;
+    /** If is_causal and >= 0, query i also only attends the local_window_size keys before its last key. */
+    int local_window_size = -1;
+    /** fp16 inputs and output. When set, these are used instead of query, key, value and output. */
+    const MLAS_FP16* query_fp16 = nullptr;
+    const MLAS_FP16* key_fp16 = nullptr;
+    const MLAS_FP16* value_fp16 = nullptr;
+    MLAS_FP16* output_fp16 = nullptr;
 };
 
 /**
- * @brief Per-thread worker function for fp32 Flash Attention
- * @param thread_id    Thread index
+ * @brief Flash Attention: output(B, S, N, H_v) = softmax(scale * Q K^T) V, where Q is
+ *        (B, N, S, H) and K and V are (B, N_kv, L, H). Q K^T is computed for a block of
+ *        queries and keys at a time and never materialized.
  * @param args         Arguments
- * @return
+ * @param ThreadPool   Thread pool, args->thread_count threads are used
 */
 void
 MLASCALL
@@ -1869,3 +2140,13 @@ MlasFlashAttention(
     MlasFlashAttentionThreadedArgs* args,
     MLAS_THREADPOOL* ThreadPool
 );
+
+/**
+ * @brief Returns the size in bytes of the per-thread buffer needed by MlasFlashAttention
+ *        for the block sizes, head sizes and input type of args.
+*/
+size_t
+MLASCALL
+MlasFlashAttentionGetBufferSizePerThread(
+    const MlasFlashAttentionThreadedArgs* args
+);
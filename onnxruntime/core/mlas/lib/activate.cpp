@@ -406,6 +406,70 @@ Return Value:
     }
 }
 
+void
+MlasActivationTranscendental(
+    MLAS_ACTIVATION_KIND ActivationKind,
+    float* Buffer,
+    size_t N
+    )
+/*++
+
+Routine Description:
+
+    This routine applies the activations that are built from the vectorized
+    transcendental routines: Gelu, FastGelu (the tanh approximation of Gelu)
+    and Silu.
+
+Arguments:
+
+    ActivationKind - Supplies the kind of activation.
+
+    Buffer - Supplies the vector to update in place.
+
+    N - Supplies the number of elements of the vector.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    if (ActivationKind == MlasGeluActivation) {
+        MlasComputeGeluErf(Buffer, Buffer, N);
+        return;
+    }
+
+    if (ActivationKind == MlasSiluActivation) {
+        MlasComputeSilu(Buffer, Buffer, N);
+        return;
+    }
+
+    constexpr float FastGeluB = 0.7978845608028654f;    // sqrt(2.0 / M_PI)
+    constexpr float FastGeluC = 0.035677408136300125f;  // 0.044715 * sqrt(2.0 / M_PI)
+
+    constexpr size_t TempElements = 256;
+    MLAS_DECLSPEC_ALIGN(float Temp[TempElements], 64);
+
+    while (N > 0) {
+
+        const size_t Count = std::min(N, TempElements);
+
+        for (size_t i = 0; i < Count; i++) {
+            const float Value = Buffer[i];
+            Temp[i] = Value * (FastGeluC * Value * Value + FastGeluB);
+        }
+
+        MlasComputeTanh(Temp, Temp, Count);
+
+        for (size_t i = 0; i < Count; i++) {
+            Buffer[i] = 0.5f * Buffer[i] * (Temp[i] + 1.0f);
+        }
+
+        Buffer += Count;
+        N -= Count;
+    }
+}
+
 void
 MLASCALL
 MlasActivation(
@@ -512,6 +576,26 @@ Return Value:
             break;
         }
 
+        case MlasGeluActivation:
+        case MlasFastGeluActivation:
+        case MlasSiluActivation:
+        {
+            if (Bias != nullptr) {
+                MlasActivationKernel<MlasIdentityActivation, true>(Activation, Buffer, Bias, M, N, ldc);
+            }
+
+            if (N == ldc) {
+                MlasActivationTranscendental(Activation->ActivationKind, Buffer, M * N);
+            } else {
+                while (M-- > 0) {
+                    MlasActivationTranscendental(Activation->ActivationKind, Buffer, N);
+                    Buffer += ldc;
+                }
+            }
+
+            break;
+        }
+
         case MlasActivationKindCount:
         {
             MLAS_THROW_EX(std::runtime_error, "bad mlas activation kind");
@@ -27,6 +27,10 @@ Abstract:
 
 #define tile_dpbuud(dst, src1, src2) _tile_dpbuud(dst, src1, src2)
 
+#define tile_dpbf16ps(dst, src1, src2) _tile_dpbf16ps(dst, src1, src2)
+
+#define tile_zero(dst) _tile_zero(dst)
+
 #define tile_loadd(dst, base, stride) _tile_loadd(dst, base, stride)
 
 #define tile_stream_loadd(dst, base, stride) _tile_stream_loadd(dst, base, stride)
@@ -51,6 +55,36 @@ __asm__ volatile (".set Payload1, 0x01\n\t"    \
 #define tile_dpbusd(dst,src1,src2)					\
 tile_dpbusd_internal(dst,src1,src2)
 
+#define tile_dpbsud_internal(dst,src1,src2)  \
+__asm__ volatile (".set Payload1, 0x02\n\t"    \
+	".set Payload1, Payload1 + (("#src2" & 15) ^ 15) << 3\n\t"  \
+	".set ModRMByte, 0xC0\n\t" 		\
+	".set ModRMByte, ModRMByte + ("#dst" << 3)\n\t"     \
+	".set ModRMByte, ModRMByte + ("#src1")\n\t"     \
+	".byte 0xC4, 0xE2, Payload1, 0x5E, ModRMByte\n\t")
+
+#define tile_dpbsud(dst,src1,src2)					\
+tile_dpbsud_internal(dst,src1,src2)
+
+#define tile_dpbf16ps_internal(dst,src1,src2)  \
+__asm__ volatile (".set Payload1, 0x02\n\t"    \
+	".set Payload1, Payload1 + (("#src2" & 15) ^ 15) << 3\n\t"  \
+	".set ModRMByte, 0xC0\n\t" 		\
+	".set ModRMByte, ModRMByte + ("#dst" << 3)\n\t"     \
+	".set ModRMByte, ModRMByte + ("#src1")\n\t"     \
+	".byte 0xC4, 0xE2, Payload1, 0x5C, ModRMByte\n\t")
+
+#define tile_dpbf16ps(dst,src1,src2)					\
+tile_dpbf16ps_internal(dst,src1,src2)
+
+#define tile_zero_internal(dst)  \
+__asm__ volatile (".set ModRMByte, 0xC0\n\t" 		\
+	".set ModRMByte, ModRMByte + ("#dst" << 3)\n\t"     \
+	".byte 0xC4, 0xE2, 0x7B, 0x49, ModRMByte\n\t")
+
+#define tile_zero(dst)					\
+tile_zero_internal(dst)
+
 #define tile_loadd_internal1(dst,base,stride)				\
   __asm__ volatile (".set ModRMByte, 0x04\n\t" 		\
 	".set ModRMByte, ModRMByte + ("#dst" << 3)\n\t"     \
@@ -78,3 +112,24 @@ __asm__ volatile (".byte 0xC4, 0xE2, 0x78, 0x49, 0x00" :: "a" (((const void *)co
 __asm__ volatile (".byte 0xC4, 0xE2, 0x79, 0x49, 0x00" :: "a" (((const void *)config)))  \
 
 #endif
+
+//
+// The tile instructions are emitted as opaque assembly on Linux, so memory
+// accessed by the tile loads and stores is fenced from the compiler.
+//
+#if defined(_WIN32)
+#define MLAS_AMX_TILE_MEMORY_BARRIER()
+#else
+#define MLAS_AMX_TILE_MEMORY_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+
+// Tile configure structure
+struct tileconfig_t {
+    uint8_t palette_id = 0;
+    uint8_t start_row = 0;
+    uint8_t reserved1[14] = {0};
+    uint16_t colb[8] = {0};
+    uint8_t reserved2[16] = {0};
+    uint8_t rows[8] = {0};
+    uint8_t reserved3[8] = {0};
+};
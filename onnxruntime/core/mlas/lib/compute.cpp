@@ -70,8 +70,7 @@ MLAS_INTERNAL_DATA const float MlasMinimumF32Value = std::numeric_limits<float>:
 
 struct MLAS_SOFTMAX_WORK_BLOCK {
     ptrdiff_t ThreadCountN;
-    bool LogSoftmax;
-    bool SmoothSoftmax;
+    MLAS_SOFTMAX_FUSED_PARAMS Params;
     const float* Input;
     float* Output;
     size_t N;
@@ -783,6 +782,127 @@ Return Value:
     }
 }
 
+template<bool HasBias, bool HasMask>
+MLAS_FORCEINLINE
+float
+MlasComputeSoftmaxInputF32KernelImpl(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Scale,
+    const float* Bias,
+    const float* Mask
+    )
+{
+    const MLAS_FLOAT32X4 ScaleVector = MlasBroadcastFloat32x4(Scale);
+
+    float Maximum = MlasMinimumF32Value;
+
+    auto TransformVector = [&](size_t Offset) {
+        MLAS_FLOAT32X4 Vector = MlasMultiplyFloat32x4(ScaleVector, MlasLoadFloat32x4(Input + Offset));
+        if (HasBias) {
+            Vector = MlasAddFloat32x4(Vector, MlasLoadFloat32x4(Bias + Offset));
+        }
+        if (HasMask) {
+            Vector = MlasAddFloat32x4(Vector, MlasLoadFloat32x4(Mask + Offset));
+        }
+        MlasStoreFloat32x4(Output + Offset, Vector);
+        return Vector;
+    };
+
+    size_t n = 0;
+
+    if (N >= 4) {
+        MLAS_FLOAT32X4 MaximumVector0 = MlasBroadcastFloat32x4(Maximum);
+
+        if (N >= 8) {
+            MLAS_FLOAT32X4 MaximumVector1 = MaximumVector0;
+
+            for (; n + 8 <= N; n += 8) {
+                MaximumVector0 = MlasMaximumFloat32x4(MaximumVector0, TransformVector(n));
+                MaximumVector1 = MlasMaximumFloat32x4(MaximumVector1, TransformVector(n + 4));
+            }
+
+            MaximumVector0 = MlasMaximumFloat32x4(MaximumVector0, MaximumVector1);
+        }
+
+        for (; n + 4 <= N; n += 4) {
+            MaximumVector0 = MlasMaximumFloat32x4(MaximumVector0, TransformVector(n));
+        }
+
+        Maximum = MlasReduceMaximumFloat32x4(MaximumVector0);
+    }
+
+    for (; n < N; n++) {
+        float Value = Scale * Input[n];
+        if (HasBias) {
+            Value += Bias[n];
+        }
+        if (HasMask) {
+            Value += Mask[n];
+        }
+        Output[n] = Value;
+        Maximum = std::max(Maximum, Value);
+    }
+
+    return Maximum;
+}
+
+float
+MLASCALL
+MlasComputeSoftmaxInputF32Kernel(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Scale,
+    const float* Bias,
+    const float* Mask
+    )
+/*++
+
+Routine Description:
+
+    This routine implements the generic kernel to transform a row of the
+    input of a fused softmax operation:
+
+        Output = Scale * Input + Bias + Mask
+
+    and to find the maximum value of the transformed row.
+
+    N.B. The input and output buffers may be the same buffer.
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+    Scale - Supplies the scale applied to the input.
+
+    Bias - Optionally supplies an additive bias.
+
+    Mask - Optionally supplies an additive mask.
+
+Return Value:
+
+    Returns the maximum value of the transformed row.
+
+--*/
+{
+    if (Bias != nullptr) {
+        if (Mask != nullptr) {
+            return MlasComputeSoftmaxInputF32KernelImpl<true, true>(Input, Output, N, Scale, Bias, Mask);
+        }
+        return MlasComputeSoftmaxInputF32KernelImpl<true, false>(Input, Output, N, Scale, Bias, Mask);
+    }
+    if (Mask != nullptr) {
+        return MlasComputeSoftmaxInputF32KernelImpl<false, true>(Input, Output, N, Scale, Bias, Mask);
+    }
+    return MlasComputeSoftmaxInputF32KernelImpl<false, false>(Input, Output, N, Scale, Bias, Mask);
+}
+
 void
 MlasComputeSoftmaxThreaded(
     void* Context,
@@ -823,11 +943,15 @@ Return Value:
     //
 
     const size_t D = WorkBlock->D;
-    const bool LogSoftmax = WorkBlock->LogSoftmax;
-    const bool SmoothSoftmax = WorkBlock->SmoothSoftmax;
+    const MLAS_SOFTMAX_FUSED_PARAMS& Params = WorkBlock->Params;
+    const bool LogSoftmax = Params.LogSoftmax;
+    const bool SmoothSoftmax = Params.SmoothSoftmax;
+    const bool FuseInput = Params.Scale != 1.0f || Params.Bias != nullptr || Params.Mask != nullptr;
 
     const float* Input = WorkBlock->Input + n * D;
     float* Output = WorkBlock->Output + n * D;
+    const float* Bias = (Params.Bias != nullptr) ? Params.Bias + n * Params.ldBias : nullptr;
+    const float* Mask = (Params.Mask != nullptr) ? Params.Mask + n * Params.ldMask : nullptr;
 
 #if defined(MLAS_SSE2_INTRINSICS)
     // TODO: Use std::hardware_constructive_interference_size
@@ -847,14 +971,40 @@ Return Value:
 #endif
 
         //
-        // Find the maximum value for the row.
+        // Columns beyond the causal limit of the row do not contribute to the
+        // softmax of the row.
+        //
+
+        size_t CountD = D;
+
+        if (Params.Causal) {
+            CountD = std::min(D, n + Params.CausalOffset + 1);
+        }
+
+        //
+        // Find the maximum value for the row. When the input is transformed,
+        // the transformed row is written to the output buffer and all later
+        // passes read from the output buffer.
         //
 
+        const float* RowInput = Input;
+        float Maximum;
+
+        if (FuseInput) {
+#if defined(MLAS_TARGET_AMD64)
+            Maximum = GetMlasPlatform().ComputeSoftmaxInputF32Kernel(Input, Output, CountD, Params.Scale, Bias, Mask);
+#else
+            Maximum = MlasComputeSoftmaxInputF32Kernel(Input, Output, CountD, Params.Scale, Bias, Mask);
+#endif
+            RowInput = Output;
+        } else {
 #if defined(MLAS_TARGET_AMD64) || defined(MLAS_TARGET_LARCH64)
-        float Maximum = GetMlasPlatform().ReduceMaximumF32Kernel(Input, D);
+            Maximum = GetMlasPlatform().ReduceMaximumF32Kernel(Input, CountD);
 #else
-        float Maximum = MlasReduceMaximumF32Kernel(Input, D);
+            Maximum = MlasReduceMaximumF32Kernel(Input, CountD);
 #endif
+        }
+
         float NegativeMaximum = -Maximum;
         if (SmoothSoftmax && NegativeMaximum > 0.0f) {
             NegativeMaximum = 0.0f;
@@ -866,9 +1016,9 @@ Return Value:
         //
         float* Temp = LogSoftmax ? nullptr : Output;
 #if defined(MLAS_TARGET_AMD64)
-        float Accumulation = GetMlasPlatform().ComputeSumExpF32Kernel(Input, Temp, D, &NegativeMaximum);
+        float Accumulation = GetMlasPlatform().ComputeSumExpF32Kernel(RowInput, Temp, CountD, &NegativeMaximum);
 #else
-        float Accumulation = MlasComputeSumExpF32Kernel(Input, Temp, D, &NegativeMaximum);
+        float Accumulation = MlasComputeSumExpF32Kernel(RowInput, Temp, CountD, &NegativeMaximum);
 #endif
 
         if (SmoothSoftmax) {
@@ -882,9 +1032,9 @@ Return Value:
             float Parameters[] = {NegativeMaximum, std::log(Accumulation)};
 
 #if defined(MLAS_TARGET_AMD64) || defined(MLAS_TARGET_LARCH64)
-            GetMlasPlatform().ComputeLogSoftmaxOutputF32Kernel(Input, Output, D, Parameters);
+            GetMlasPlatform().ComputeLogSoftmaxOutputF32Kernel(RowInput, Output, CountD, Parameters);
 #else
-            MlasComputeLogSoftmaxOutputF32Kernel(Input, Output, D, Parameters);
+            MlasComputeLogSoftmaxOutputF32Kernel(RowInput, Output, CountD, Parameters);
 #endif
 
         } else {
@@ -894,14 +1044,26 @@ Return Value:
             float Parameters[] = {1.0f / Accumulation};
 
 #if defined(MLAS_TARGET_AMD64) || defined(MLAS_TARGET_LARCH64)
-            GetMlasPlatform().ComputeSoftmaxOutputF32Kernel(Output, D, Parameters);
+            GetMlasPlatform().ComputeSoftmaxOutputF32Kernel(Output, CountD, Parameters);
 #else
-            MlasComputeSoftmaxOutputF32Kernel(Output, D, Parameters);
+            MlasComputeSoftmaxOutputF32Kernel(Output, CountD, Parameters);
 #endif
         }
 
+        if (CountD < D) {
+            std::fill_n(Output + CountD, D - CountD,
+                        LogSoftmax ? -std::numeric_limits<float>::infinity() : 0.0f);
+        }
+
         Input += D;
         Output += D;
+        if (Bias != nullptr) {
+            Bias += Params.ldBias;
+        }
+        if (Mask != nullptr) {
+            Mask += Params.ldMask;
+        }
+        n++;
         CountN--;
     }
 }
@@ -947,6 +1109,60 @@ Return Value:
 
     None.
 
+--*/
+{
+    MLAS_SOFTMAX_FUSED_PARAMS Params;
+
+    Params.LogSoftmax = LogSoftmax;
+    Params.SmoothSoftmax = SmoothSoftmax;
+
+    MlasComputeSoftmax(Input, Output, N, D, Params, ThreadPool);
+}
+
+void
+MLASCALL
+MlasComputeSoftmax(
+    const float* Input,
+    float* Output,
+    size_t N,
+    size_t D,
+    const MLAS_SOFTMAX_FUSED_PARAMS& Params,
+    MLAS_THREADPOOL* ThreadPool
+)
+/*++
+
+Routine Description:
+
+    This routine computes the softmax or log softmax function of the rows of
+    the input after transforming each row to:
+
+        Scale * Input + Bias + Mask
+
+    The transformation, the causal masking and the softmax are computed in a
+    single pass over each row, so the rows are read from and written to
+    memory once instead of once per transformation.
+
+    N.B. This implementation supports in place updates of the output buffer.
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of rows to process.
+
+    D - Supplies the number of columns per row to process.
+
+    Params - Supplies the fused transformations of the input.
+
+    ThreadPool - Supplies the thread pool object to use, else nullptr if the
+        base library threading support should be used.
+
+Return Value:
+
+    None.
+
 --*/
 {
     MLAS_SOFTMAX_WORK_BLOCK WorkBlock;
@@ -955,8 +1171,7 @@ Return Value:
     // Capture the softmax parameters to the work block.
     //
 
-    WorkBlock.LogSoftmax = LogSoftmax;
-    WorkBlock.SmoothSoftmax = SmoothSoftmax;
+    WorkBlock.Params = Params;
     WorkBlock.Input = Input;
     WorkBlock.Output = Output;
     WorkBlock.N = N;
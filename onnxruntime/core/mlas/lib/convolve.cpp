@@ -878,6 +878,17 @@ Return Value:
     // Schedule batches of GEMMs across multiple threads.
     //
 
+    if (Algorithm == MlasConvAlgorithmWinograd) {
+
+        //
+        // The Winograd algorithm threads over all batches and groups.
+        //
+
+        MlasConvWinograd(Parameters, Input, Filter, Bias, WorkingBuffer, Output, ThreadPool);
+
+        return;
+    }
+
     if (Algorithm == MlasConvAlgorithmGemmDirect && ((BatchCount > 1) || (GroupCount > 1))) {
 
         const size_t BatchGroupCount = BatchCount * GroupCount;
@@ -1002,6 +1013,16 @@ Return Value:
 
                     break;
                 }
+
+                case MlasConvAlgorithmWinograd:
+                {
+                    //
+                    // The Winograd algorithm is dispatched above for all batches
+                    // and groups.
+                    //
+
+                    break;
+                }
             }
 
             //
@@ -1041,7 +1062,8 @@ MlasConvPrepare(
     const MLAS_ACTIVATION* Activation,
     size_t* WorkingBufferSize,
     float Beta,
-    MLAS_THREADPOOL* ThreadPool
+    MLAS_THREADPOOL* ThreadPool,
+    bool AllowWinograd
     )
 /*++
 
@@ -1088,6 +1110,10 @@ Arguments:
     ThreadPool - Supplies the thread pool object to use, else nullptr if the
         base library threading support should be used.
 
+    AllowWinograd - Supplies true if a 3x3 convolution may use the Winograd
+        algorithm. The Winograd algorithm is faster for larger channel counts
+        but rounds differently than the other algorithms.
+
 Return Value:
 
     None.
@@ -1211,6 +1237,20 @@ Return Value:
         }
     }
 
+    if (AllowWinograd && Dimensions == 2 && AllStridesAreOne && AllDilationsAreOne &&
+        Parameters->KernelShape[0] == 3 && Parameters->KernelShape[1] == 3 &&
+        InputChannels >= 64 && FilterCount >= 64) {
+
+        //
+        // Transform 3x3 convolutions with enough channels to amortize the
+        // transforms.
+        //
+
+        MlasConvWinogradPrepare(Parameters, WorkingBufferSize, ThreadPool);
+
+        return;
+    }
+
     if (FilterCount > OutputSize) {
 
         //
@@ -0,0 +1,977 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    convolve_winograd.cpp
+
+Abstract:
+
+    This module implements the 3x3 stride 1 convolution operation using the
+    Winograd minimal filtering algorithms F(2x2,3x3) and F(4x4,3x3).
+
+    The filter is transformed to an Alpha x Alpha tile (Alpha = OutputTile + 2)
+    and the input is transformed one overlapping Alpha x Alpha tile at a time.
+    The element wise products of the transformed tiles are then batched into
+    Alpha * Alpha independent GEMMs that reduce over the input channels, and
+    the inverse transform produces an OutputTile x OutputTile block of the
+    output for each input tile.
+
+    The transformed buffers use the following layouts, where xi is the index
+    of the element within the transformed Alpha x Alpha tile:
+
+        PackedFilter    [GroupCount][xi][FilterCount][InputChannels]
+        Input           [xi][InputChannels][TileBlockSize]
+        Output          [xi][FilterCount][TileBlockSize]
+
+    The transforms are applied to a block of tiles at a time with the tile
+    index as the innermost dimension so that the compiler can vectorize them.
+
+--*/
+
+#include "mlasi.h"
+
+//
+// Define the number of working buffer elements to target for the transformed
+// input and output of a block of tiles.
+//
+
+#define MLAS_CONV_WINOGRAD_WORKING_SET_SIZE         (size_t(512) * size_t(1024))
+
+//
+// Define the limits of the number of tiles processed by a single GEMM.
+//
+
+#define MLAS_CONV_WINOGRAD_MINIMUM_TILE_BLOCK       8
+#define MLAS_CONV_WINOGRAD_MAXIMUM_TILE_BLOCK       256
+
+//
+// Define the minimum number of tiles per GEMM for the F(4x4,3x3) algorithm.
+// The F(4x4,3x3) algorithm needs fewer multiplies than F(2x2,3x3), but each
+// tile uses more of the working set, so deep layers with short GEMMs do
+// better with F(2x2,3x3).
+//
+
+#define MLAS_CONV_WINOGRAD_F4X3_MINIMUM_TILE_BLOCK  16
+
+//
+// Define the transforms of the Winograd algorithms. Each routine applies the
+// one dimensional transform to N independent vectors: element i of the
+// source vectors is read from Source + i * SourceStride and element i of the
+// destination vectors is written to Destination + i * DestinationStride.
+//
+
+template<size_t OutputTile>
+struct MLAS_WINOGRAD_TRANSFORM;
+
+template<>
+struct MLAS_WINOGRAD_TRANSFORM<2>
+{
+    static constexpr size_t Alpha = 4;
+
+    static
+    MLAS_FORCEINLINE
+    void
+    Input(
+        const float* Source,
+        size_t SourceStride,
+        float* Destination,
+        size_t DestinationStride,
+        size_t N
+        )
+    {
+        const float* d0 = Source;
+        const float* d1 = d0 + SourceStride;
+        const float* d2 = d1 + SourceStride;
+        const float* d3 = d2 + SourceStride;
+
+        float* v0 = Destination;
+        float* v1 = v0 + DestinationStride;
+        float* v2 = v1 + DestinationStride;
+        float* v3 = v2 + DestinationStride;
+
+        for (size_t n = 0; n < N; n++) {
+            v0[n] = d0[n] - d2[n];
+            v1[n] = d1[n] + d2[n];
+            v2[n] = d2[n] - d1[n];
+            v3[n] = d1[n] - d3[n];
+        }
+    }
+
+    static
+    MLAS_FORCEINLINE
+    void
+    Filter(
+        const float g[3],
+        size_t SourceStride,
+        float* u,
+        size_t DestinationStride
+        )
+    {
+        const float g0 = g[0];
+        const float g1 = g[SourceStride];
+        const float g2 = g[2 * SourceStride];
+
+        u[0] = g0;
+        u[DestinationStride] = 0.5f * (g0 + g1 + g2);
+        u[2 * DestinationStride] = 0.5f * (g0 - g1 + g2);
+        u[3 * DestinationStride] = g2;
+    }
+
+    static
+    MLAS_FORCEINLINE
+    void
+    Output(
+        const float* Source,
+        size_t SourceStride,
+        float* Destination,
+        size_t DestinationStride,
+        size_t N
+        )
+    {
+        const float* m0 = Source;
+        const float* m1 = m0 + SourceStride;
+        const float* m2 = m1 + SourceStride;
+        const float* m3 = m2 + SourceStride;
+
+        float* y0 = Destination;
+        float* y1 = y0 + DestinationStride;
+
+        for (size_t n = 0; n < N; n++) {
+            y0[n] = m0[n] + m1[n] + m2[n];
+            y1[n] = m1[n] - m2[n] - m3[n];
+        }
+    }
+};
+
+template<>
+struct MLAS_WINOGRAD_TRANSFORM<4>
+{
+    static constexpr size_t Alpha = 6;
+
+    static
+    MLAS_FORCEINLINE
+    void
+    Input(
+        const float* Source,
+        size_t SourceStride,
+        float* Destination,
+        size_t DestinationStride,
+        size_t N
+        )
+    {
+        const float* d0 = Source;
+        const float* d1 = d0 + SourceStride;
+        const float* d2 = d1 + SourceStride;
+        const float* d3 = d2 + SourceStride;
+        const float* d4 = d3 + SourceStride;
+        const float* d5 = d4 + SourceStride;
+
+        float* v0 = Destination;
+        float* v1 = v0 + DestinationStride;
+        float* v2 = v1 + DestinationStride;
+        float* v3 = v2 + DestinationStride;
+        float* v4 = v3 + DestinationStride;
+        float* v5 = v4 + DestinationStride;
+
+        for (size_t n = 0; n < N; n++) {
+            const float t0 = d4[n] - 4.0f * d2[n];
+            const float t1 = d3[n] - 4.0f * d1[n];
+            const float t2 = d4[n] - d2[n];
+            const float t3 = 2.0f * (d3[n] - d1[n]);
+            v0[n] = 4.0f * d0[n] - 5.0f * d2[n] + d4[n];
+            v1[n] = t0 + t1;
+            v2[n] = t0 - t1;
+            v3[n] = t2 + t3;
+            v4[n] = t2 - t3;
+            v5[n] = 4.0f * d1[n] - 5.0f * d3[n] + d5[n];
+        }
+    }
+
+    static
+    MLAS_FORCEINLINE
+    void
+    Filter(
+        const float g[3],
+        size_t SourceStride,
+        float* u,
+        size_t DestinationStride
+        )
+    {
+        const float g0 = g[0];
+        const float g1 = g[SourceStride];
+        const float g2 = g[2 * SourceStride];
+
+        u[0] = g0 * (1.0f / 4.0f);
+        u[DestinationStride] = -(g0 + g1 + g2) * (1.0f / 6.0f);
+        u[2 * DestinationStride] = -(g0 - g1 + g2) * (1.0f / 6.0f);
+        u[3 * DestinationStride] = g0 * (1.0f / 24.0f) + g1 * (1.0f / 12.0f) + g2 * (1.0f / 6.0f);
+        u[4 * DestinationStride] = g0 * (1.0f / 24.0f) - g1 * (1.0f / 12.0f) + g2 * (1.0f / 6.0f);
+        u[5 * DestinationStride] = g2;
+    }
+
+    static
+    MLAS_FORCEINLINE
+    void
+    Output(
+        const float* Source,
+        size_t SourceStride,
+        float* Destination,
+        size_t DestinationStride,
+        size_t N
+        )
+    {
+        const float* m0 = Source;
+        const float* m1 = m0 + SourceStride;
+        const float* m2 = m1 + SourceStride;
+        const float* m3 = m2 + SourceStride;
+        const float* m4 = m3 + SourceStride;
+        const float* m5 = m4 + SourceStride;
+
+        float* y0 = Destination;
+        float* y1 = y0 + DestinationStride;
+        float* y2 = y1 + DestinationStride;
+        float* y3 = y2 + DestinationStride;
+
+        for (size_t n = 0; n < N; n++) {
+            const float t0 = m1[n] + m2[n];
+            const float t1 = m1[n] - m2[n];
+            const float t2 = m3[n] + m4[n];
+            const float t3 = m3[n] - m4[n];
+            y0[n] = m0[n] + t0 + t2;
+            y1[n] = t1 + 2.0f * t3;
+            y2[n] = t0 + 4.0f * t2;
+            y3[n] = t1 + 8.0f * t3 + m5[n];
+        }
+    }
+};
+
+//
+// Define the parameters to execute segments of a Winograd convolution
+// operation on worker threads.
+//
+
+struct MLAS_CONV_WINOGRAD_WORK_BLOCK {
+    const MLAS_CONV_PARAMETERS* Parameters;
+    const float* Input;
+    const float* PackedFilter;
+    const float* Bias;
+    float* WorkingBuffer;
+    float* Output;
+    size_t TileBlockCount;
+};
+
+template<size_t OutputTile>
+size_t
+MlasConvWinogradWorkingBufferSizePerThread(
+    size_t InputChannels,
+    size_t FilterCount,
+    size_t TileBlockSize
+    )
+/*++
+
+Routine Description:
+
+    This routine returns the number of working buffer elements required by
+    a thread: the transformed input and output of a block of tiles and two
+    scratch tiles for the two passes of each transform.
+
+--*/
+{
+    constexpr size_t Alpha = MLAS_WINOGRAD_TRANSFORM<OutputTile>::Alpha;
+
+    return Alpha * Alpha * TileBlockSize * (InputChannels + FilterCount + 2);
+}
+
+template<size_t OutputTile>
+void
+MlasConvWinogradPackFilterRange(
+    size_t InputChannels,
+    size_t FilterCount,
+    const float* Filter,
+    float* PackedFilter,
+    size_t FilterStart,
+    size_t FilterEnd
+    )
+/*++
+
+Routine Description:
+
+    This routine transforms a range of the 3x3 filters of all groups.
+
+Arguments:
+
+    InputChannels - Supplies the number of input channels per group.
+
+    FilterCount - Supplies the number of filters per group.
+
+    Filter - Supplies the filter tensor.
+
+    PackedFilter - Supplies the buffer to receive the transformed filter.
+
+    FilterStart - Supplies the index of the first filter to transform,
+        counting the filters of all groups.
+
+    FilterEnd - Supplies the index after the last filter to transform.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    using Transform = MLAS_WINOGRAD_TRANSFORM<OutputTile>;
+    constexpr size_t Alpha = Transform::Alpha;
+
+    const size_t PackedXiStride = FilterCount * InputChannels;
+    const size_t PackedGroupSize = Alpha * Alpha * PackedXiStride;
+
+    float Temporary[3 * Alpha];
+
+    for (size_t f = FilterStart; f < FilterEnd; f++) {
+
+        const size_t group = f / FilterCount;
+        const size_t filter = f % FilterCount;
+
+        const float* g = Filter + f * InputChannels * 9;
+        float* u = PackedFilter + group * PackedGroupSize + filter * InputChannels;
+
+        for (size_t c = 0; c < InputChannels; c++) {
+
+            //
+            // Transform each row of the filter and then each column of the
+            // intermediate result.
+            //
+
+            for (size_t row = 0; row < 3; row++) {
+                Transform::Filter(g + row * 3, 1, Temporary + row * Alpha, 1);
+            }
+
+            for (size_t column = 0; column < Alpha; column++) {
+                Transform::Filter(Temporary + column, Alpha, u + column * PackedXiStride + c,
+                    Alpha * PackedXiStride);
+            }
+
+            g += 9;
+        }
+    }
+}
+
+template<size_t OutputTile>
+void
+MlasConvWinogradTileBlock(
+    const MLAS_CONV_PARAMETERS* Parameters,
+    const float* Input,
+    const float* PackedFilter,
+    const float* Bias,
+    float* WorkingBuffer,
+    float* Output,
+    size_t TileStart,
+    size_t TileCount
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the output of a block of tiles of a single batch
+    and group.
+
+Arguments:
+
+    Parameters - Supplies the structure that contains the convolution
+        parameters.
+
+    Input - Supplies the input tensor of the batch and group.
+
+    PackedFilter - Supplies the transformed filter of the group.
+
+    Bias - Optionally supplies the bias of the group.
+
+    WorkingBuffer - Supplies the working buffer of the thread.
+
+    Output - Supplies the output tensor of the batch and group.
+
+    TileStart - Supplies the index of the first tile of the block.
+
+    TileCount - Supplies the number of tiles of the block.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    using Transform = MLAS_WINOGRAD_TRANSFORM<OutputTile>;
+    constexpr size_t Alpha = Transform::Alpha;
+
+    const size_t InputChannels = Parameters->InputChannels;
+    const size_t FilterCount = Parameters->FilterCount;
+    const size_t InputHeight = Parameters->InputShape[0];
+    const size_t InputWidth = Parameters->InputShape[1];
+    const size_t OutputHeight = Parameters->OutputShape[0];
+    const size_t OutputWidth = Parameters->OutputShape[1];
+    const size_t PaddingTop = Parameters->Padding[0];
+    const size_t PaddingLeft = Parameters->Padding[1];
+    const size_t InputSize = Parameters->InputSize;
+    const size_t OutputSize = Parameters->OutputSize;
+    const size_t TileBlockSize = Parameters->u.Winograd.TileBlockSize;
+    const size_t TileCountWidth = (OutputWidth + OutputTile - 1) / OutputTile;
+    const float Beta = Parameters->Beta;
+
+    float* TransformedInput = WorkingBuffer;
+    float* TransformedOutput = TransformedInput + Alpha * Alpha * InputChannels * TileBlockSize;
+    float* Tile = TransformedOutput + Alpha * Alpha * FilterCount * TileBlockSize;
+    float* Temporary = Tile + Alpha * Alpha * TileBlockSize;
+
+    //
+    // Compute the input origin of each tile of the block. The origin may be
+    // outside of the input image due to padding.
+    //
+
+    ptrdiff_t OriginY[MLAS_CONV_WINOGRAD_MAXIMUM_TILE_BLOCK];
+    ptrdiff_t OriginX[MLAS_CONV_WINOGRAD_MAXIMUM_TILE_BLOCK];
+
+    for (size_t t = 0; t < TileCount; t++) {
+        const size_t tile = TileStart + t;
+        OriginY[t] = ptrdiff_t((tile / TileCountWidth) * OutputTile) - ptrdiff_t(PaddingTop);
+        OriginX[t] = ptrdiff_t((tile % TileCountWidth) * OutputTile) - ptrdiff_t(PaddingLeft);
+    }
+
+    //
+    // Transform the input tiles of each channel.
+    //
+
+    const size_t TransformedInputXiStride = InputChannels * TileBlockSize;
+
+    for (size_t c = 0; c < InputChannels; c++) {
+
+        const float* input = Input + c * InputSize;
+
+        for (size_t t = 0; t < TileCount; t++) {
+
+            const ptrdiff_t oy = OriginY[t];
+            const ptrdiff_t ox = OriginX[t];
+
+            const bool ColumnsInBounds = ox >= 0 && size_t(ox) + Alpha <= InputWidth;
+
+            for (size_t row = 0; row < Alpha; row++) {
+
+                float* tile = Tile + row * Alpha * TileBlockSize + t;
+                const ptrdiff_t iy = oy + ptrdiff_t(row);
+
+                if (iy < 0 || size_t(iy) >= InputHeight) {
+                    for (size_t column = 0; column < Alpha; column++) {
+                        tile[column * TileBlockSize] = 0.0f;
+                    }
+                    continue;
+                }
+
+                const float* input_row = input + size_t(iy) * InputWidth;
+
+                if (ColumnsInBounds) {
+                    for (size_t column = 0; column < Alpha; column++) {
+                        tile[column * TileBlockSize] = input_row[size_t(ox) + column];
+                    }
+                } else {
+                    for (size_t column = 0; column < Alpha; column++) {
+                        const ptrdiff_t ix = ox + ptrdiff_t(column);
+                        tile[column * TileBlockSize] =
+                            (ix >= 0 && size_t(ix) < InputWidth) ? input_row[ix] : 0.0f;
+                    }
+                }
+            }
+        }
+
+        for (size_t row = 0; row < Alpha; row++) {
+            Transform::Input(Tile + row * Alpha * TileBlockSize, TileBlockSize,
+                Temporary + row * Alpha * TileBlockSize, TileBlockSize, TileCount);
+        }
+
+        for (size_t column = 0; column < Alpha; column++) {
+            Transform::Input(Temporary + column * TileBlockSize, Alpha * TileBlockSize,
+                TransformedInput + column * TransformedInputXiStride + c * TileBlockSize,
+                Alpha * TransformedInputXiStride, TileCount);
+        }
+    }
+
+    //
+    // Multiply the transformed filter by the transformed input for each
+    // element of the transformed tile.
+    //
+
+    const size_t PackedFilterXiStride = FilterCount * InputChannels;
+    const size_t TransformedOutputXiStride = FilterCount * TileBlockSize;
+
+    for (size_t xi = 0; xi < Alpha * Alpha; xi++) {
+
+        MlasSgemmOperation(CblasNoTrans, CblasNoTrans, FilterCount, TileCount, InputChannels,
+            1.0f, PackedFilter + xi * PackedFilterXiStride, InputChannels,
+            TransformedInput + xi * TransformedInputXiStride, TileBlockSize, 0.0f,
+            TransformedOutput + xi * TransformedOutputXiStride, TileBlockSize);
+    }
+
+    //
+    // Transform the output tiles of each filter and store the valid portion of
+    // each tile to the output tensor.
+    //
+
+    for (size_t f = 0; f < FilterCount; f++) {
+
+        const float* transformed_output = TransformedOutput + f * TileBlockSize;
+
+        for (size_t row = 0; row < Alpha; row++) {
+            Transform::Output(transformed_output + row * Alpha * TransformedOutputXiStride,
+                TransformedOutputXiStride, Temporary + row * OutputTile * TileBlockSize,
+                TileBlockSize, TileCount);
+        }
+
+        for (size_t column = 0; column < OutputTile; column++) {
+            Transform::Output(Temporary + column * TileBlockSize, OutputTile * TileBlockSize,
+                Tile + column * TileBlockSize, OutputTile * TileBlockSize, TileCount);
+        }
+
+        const float BiasValue = (Bias != nullptr) ? Bias[f] : 0.0f;
+        float* output = Output + f * OutputSize;
+
+        for (size_t t = 0; t < TileCount; t++) {
+
+            const size_t oy = size_t(OriginY[t] + ptrdiff_t(PaddingTop));
+            const size_t ox = size_t(OriginX[t] + ptrdiff_t(PaddingLeft));
+
+            const size_t rows = std::min(OutputTile, OutputHeight - oy);
+            const size_t columns = std::min(OutputTile, OutputWidth - ox);
+
+            for (size_t row = 0; row < rows; row++) {
+
+                const float* tile = Tile + row * OutputTile * TileBlockSize + t;
+                float* output_row = output + (oy + row) * OutputWidth + ox;
+
+                if (Beta == 0.0f) {
+                    for (size_t column = 0; column < columns; column++) {
+                        output_row[column] = tile[column * TileBlockSize] + BiasValue;
+                    }
+                } else {
+                    for (size_t column = 0; column < columns; column++) {
+                        output_row[column] = tile[column * TileBlockSize] + BiasValue +
+                            Beta * output_row[column];
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<size_t OutputTile>
+void
+MlasConvWinogradThreaded(
+    void* Context,
+    ptrdiff_t Index
+    )
+/*++
+
+Routine Description:
+
+    This routine is invoked from a worker thread to execute a segment of a
+    Winograd convolution operation.
+
+Arguments:
+
+    Context - Supplies the pointer to the context for the threaded operation.
+
+    Index - Supplies the current index of the threaded operation.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    const auto* WorkBlock = (MLAS_CONV_WINOGRAD_WORK_BLOCK*)Context;
+
+    const MLAS_CONV_PARAMETERS* Parameters = WorkBlock->Parameters;
+
+    const size_t GroupCount = Parameters->GroupCount;
+    const size_t InputChannels = Parameters->InputChannels;
+    const size_t FilterCount = Parameters->FilterCount;
+    const size_t TileCount = Parameters->u.Winograd.TileCount;
+    const size_t TileBlockSize = Parameters->u.Winograd.TileBlockSize;
+    const size_t TileBlockCount = WorkBlock->TileBlockCount;
+
+    const size_t InputGroupSize = InputChannels * Parameters->InputSize;
+    const size_t OutputGroupSize = FilterCount * Parameters->OutputSize;
+    const size_t PackedFilterGroupSize = Parameters->u.Winograd.PackedFilterSize / GroupCount;
+
+    float* WorkingBuffer = WorkBlock->WorkingBuffer + Index *
+        MlasConvWinogradWorkingBufferSizePerThread<OutputTile>(InputChannels, FilterCount, TileBlockSize);
+
+    //
+    // Compute the range of tile blocks over all batches and groups to use for
+    // this thread.
+    //
+
+    size_t WorkIndex;
+    size_t WorkRemaining;
+
+    MlasPartitionWork(Index, Parameters->ThreadCount,
+        Parameters->BatchCount * GroupCount * TileBlockCount, &WorkIndex, &WorkRemaining);
+
+    for (; WorkRemaining > 0; WorkIndex++, WorkRemaining--) {
+
+        const size_t bg = WorkIndex / TileBlockCount;
+        const size_t group = bg % GroupCount;
+        const size_t TileStart = (WorkIndex % TileBlockCount) * TileBlockSize;
+
+        const float* bias = WorkBlock->Bias;
+
+        if (bias != nullptr) {
+            bias += group * FilterCount;
+        }
+
+        MlasConvWinogradTileBlock<OutputTile>(Parameters, WorkBlock->Input + bg * InputGroupSize,
+            WorkBlock->PackedFilter + group * PackedFilterGroupSize, bias, WorkingBuffer,
+            WorkBlock->Output + bg * OutputGroupSize, TileStart,
+            std::min(TileBlockSize, TileCount - TileStart));
+    }
+}
+
+template<size_t OutputTile>
+void
+MlasConvWinogradOperation(
+    const MLAS_CONV_PARAMETERS* Parameters,
+    const float* Input,
+    const float* Filter,
+    const float* Bias,
+    float* WorkingBuffer,
+    float* Output,
+    MLAS_THREADPOOL* ThreadPool
+    )
+{
+    const size_t GroupCount = Parameters->GroupCount;
+    const size_t InputChannels = Parameters->InputChannels;
+    const size_t FilterCount = Parameters->FilterCount;
+    const ptrdiff_t ThreadCount = Parameters->ThreadCount;
+
+    //
+    // Transform the filter to the end of the working buffer if the caller
+    // did not supply a transformed filter.
+    //
+
+    const float* PackedFilter = Parameters->u.Winograd.PackedFilter;
+
+    if (PackedFilter == nullptr) {
+
+        float* PackedFilterBuffer = WorkingBuffer + ThreadCount *
+            MlasConvWinogradWorkingBufferSizePerThread<OutputTile>(InputChannels, FilterCount,
+                Parameters->u.Winograd.TileBlockSize);
+
+        MlasTrySimpleParallel(ThreadPool, ThreadCount, [&](ptrdiff_t tid) {
+            size_t FilterStart;
+            size_t FilterRemaining;
+            MlasPartitionWork(tid, ThreadCount, GroupCount * FilterCount, &FilterStart, &FilterRemaining);
+            MlasConvWinogradPackFilterRange<OutputTile>(InputChannels, FilterCount, Filter,
+                PackedFilterBuffer, FilterStart, FilterStart + FilterRemaining);
+        });
+
+        PackedFilter = PackedFilterBuffer;
+    }
+
+    MLAS_CONV_WINOGRAD_WORK_BLOCK WorkBlock;
+
+    WorkBlock.Parameters = Parameters;
+    WorkBlock.Input = Input;
+    WorkBlock.PackedFilter = PackedFilter;
+    WorkBlock.Bias = Bias;
+    WorkBlock.WorkingBuffer = WorkingBuffer;
+    WorkBlock.Output = Output;
+    WorkBlock.TileBlockCount = (Parameters->u.Winograd.TileCount +
+        Parameters->u.Winograd.TileBlockSize - 1) / Parameters->u.Winograd.TileBlockSize;
+
+    MlasExecuteThreaded(MlasConvWinogradThreaded<OutputTile>, &WorkBlock, ThreadCount, ThreadPool);
+
+    //
+    // Apply the activation. The bias has already been applied by the output
+    // transform.
+    //
+
+    if (Parameters->Activation->ActivationKind != MlasIdentityActivation) {
+
+        const size_t OutputSize = Parameters->OutputSize;
+        const size_t RowCount = Parameters->BatchCount * GroupCount * FilterCount;
+
+        MlasTrySimpleParallel(ThreadPool, ThreadCount, [&](ptrdiff_t tid) {
+            size_t RowStart;
+            size_t RowRemaining;
+            MlasPartitionWork(tid, ThreadCount, RowCount, &RowStart, &RowRemaining);
+            MlasActivation(Parameters->Activation, Output + RowStart * OutputSize, nullptr,
+                RowRemaining, OutputSize, OutputSize);
+        });
+    }
+}
+
+void
+MlasConvWinograd(
+    const MLAS_CONV_PARAMETERS* Parameters,
+    const float* Input,
+    const float* Filter,
+    const float* Bias,
+    float* WorkingBuffer,
+    float* Output,
+    MLAS_THREADPOOL* ThreadPool
+    )
+/*++
+
+Routine Description:
+
+    This routine implements the Winograd convolution operation for all
+    batches and groups.
+
+Arguments:
+
+    Parameters - Supplies the structure that contains the convolution
+        parameters.
+
+    Input - Supplies the input tensor.
+
+    Filter - Supplies the filter tensor. This is unused if the parameters
+        supply a transformed filter.
+
+    Bias - Optionally supplies the bias vector.
+
+    WorkingBuffer - Supplies a working buffer sized to the number of elements
+        returned by MlasConvPrepare.
+
+    Output - Supplies the output tensor.
+
+    ThreadPool - Supplies the thread pool object to use, else nullptr if the
+        base library threading support should be used.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    if (Parameters->u.Winograd.OutputTile == 4) {
+        MlasConvWinogradOperation<4>(Parameters, Input, Filter, Bias, WorkingBuffer, Output, ThreadPool);
+    } else {
+        MlasConvWinogradOperation<2>(Parameters, Input, Filter, Bias, WorkingBuffer, Output, ThreadPool);
+    }
+}
+
+void
+MlasConvWinogradPrepare(
+    MLAS_CONV_PARAMETERS* Parameters,
+    size_t* WorkingBufferSize,
+    MLAS_THREADPOOL* ThreadPool
+    )
+/*++
+
+Routine Description:
+
+    This routine prepares for a Winograd convolution operation. The caller
+    has verified that the convolution is a two dimensional 3x3 convolution
+    with unit strides and dilations.
+
+Arguments:
+
+    Parameters - Supplies the structure that stores the provided and computed
+        parameters for the convolution operation.
+
+    WorkingBufferSize - Receives the number of elements to allocate for the
+        working buffer.
+
+    ThreadPool - Supplies the thread pool object to use, else nullptr if the
+        base library threading support should be used.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    const size_t BatchGroupCount = Parameters->BatchCount * Parameters->GroupCount;
+    const size_t InputChannels = Parameters->InputChannels;
+    const size_t FilterCount = Parameters->FilterCount;
+    const size_t OutputHeight = Parameters->OutputShape[0];
+    const size_t OutputWidth = Parameters->OutputShape[1];
+
+    const size_t OutputTile =
+        MlasConvWinogradOutputTile(InputChannels, FilterCount, OutputHeight, OutputWidth);
+
+    const size_t Alpha = OutputTile + 2;
+    const size_t TileCount = ((OutputHeight + OutputTile - 1) / OutputTile) *
+        ((OutputWidth + OutputTile - 1) / OutputTile);
+
+    //
+    // Size the block of tiles so that the transformed input and output fit in
+    // the working set, then shrink the block if needed to give every thread
+    // some work.
+    //
+
+    size_t TileBlockSize = MLAS_CONV_WINOGRAD_WORKING_SET_SIZE /
+        (Alpha * Alpha * (InputChannels + FilterCount));
+
+    TileBlockSize = std::max(TileBlockSize, size_t(MLAS_CONV_WINOGRAD_MINIMUM_TILE_BLOCK));
+    TileBlockSize = std::min(TileBlockSize, size_t(MLAS_CONV_WINOGRAD_MAXIMUM_TILE_BLOCK));
+
+    const size_t MaximumThreadCount = size_t(MlasGetMaximumThreadCount(ThreadPool));
+    const size_t TileBlockSizePerThread =
+        (BatchGroupCount * TileCount + MaximumThreadCount - 1) / MaximumThreadCount;
+
+    if (TileBlockSize > TileBlockSizePerThread) {
+        TileBlockSize = std::max(TileBlockSizePerThread, size_t(MLAS_CONV_WINOGRAD_MINIMUM_TILE_BLOCK));
+    }
+
+    TileBlockSize = std::min(TileBlockSize, TileCount);
+
+    const size_t TileBlockCount = (TileCount + TileBlockSize - 1) / TileBlockSize;
+    const size_t ThreadCount = std::min(MaximumThreadCount, BatchGroupCount * TileBlockCount);
+
+    Parameters->Algorithm = MlasConvAlgorithmWinograd;
+    Parameters->ThreadCount = ptrdiff_t(ThreadCount);
+    Parameters->u.Winograd.OutputTile = OutputTile;
+    Parameters->u.Winograd.TileCount = TileCount;
+    Parameters->u.Winograd.TileBlockSize = TileBlockSize;
+    Parameters->u.Winograd.PackedFilterSize =
+        MlasConvWinogradPackedFilterSize(Parameters->GroupCount, InputChannels, FilterCount, OutputTile);
+    Parameters->u.Winograd.PackedFilter = nullptr;
+
+    //
+    // The transformed filter is stored after the per thread buffers, so a
+    // caller that supplies a transformed filter may allocate
+    // PackedFilterSize fewer elements.
+    //
+
+    *WorkingBufferSize = ThreadCount * Alpha * Alpha * TileBlockSize * (InputChannels + FilterCount + 2) +
+        Parameters->u.Winograd.PackedFilterSize;
+}
+
+size_t
+MLASCALL
+MlasConvWinogradOutputTile(
+    size_t InputChannels,
+    size_t FilterCount,
+    size_t OutputHeight,
+    size_t OutputWidth
+    )
+/*++
+
+Routine Description:
+
+    This routine returns the output tile MlasConvPrepare chooses for a
+    Winograd convolution.
+
+Arguments:
+
+    InputChannels - Supplies the number of input channels per group.
+
+    FilterCount - Supplies the number of filters per group.
+
+    OutputHeight - Supplies the height of the output.
+
+    OutputWidth - Supplies the width of the output.
+
+Return Value:
+
+    Returns the edge of the output tile, 2 or 4.
+
+--*/
+{
+    //
+    // Use F(4x4,3x3) unless the output is too small to fill the larger tiles
+    // or the channel counts leave too few tiles per GEMM.
+    //
+
+    if (OutputHeight >= 8 && OutputWidth >= 8 &&
+        MLAS_CONV_WINOGRAD_WORKING_SET_SIZE / (36 * (InputChannels + FilterCount)) >=
+            MLAS_CONV_WINOGRAD_F4X3_MINIMUM_TILE_BLOCK) {
+        return 4;
+    }
+
+    return 2;
+}
+
+size_t
+MLASCALL
+MlasConvWinogradPackedFilterSize(
+    size_t GroupCount,
+    size_t InputChannels,
+    size_t FilterCount,
+    size_t OutputTile
+    )
+/*++
+
+Routine Description:
+
+    This routine returns the number of elements of a 3x3 filter transformed
+    for the Winograd convolution operation.
+
+Arguments:
+
+    GroupCount - Supplies the number of channel groups.
+
+    InputChannels - Supplies the number of input channels per group.
+
+    FilterCount - Supplies the number of filters per group.
+
+    OutputTile - Supplies the edge of the output tile, 2 or 4.
+
+Return Value:
+
+    Returns the number of elements of the transformed filter.
+
+--*/
+{
+    const size_t Alpha = OutputTile + 2;
+
+    return GroupCount * Alpha * Alpha * FilterCount * InputChannels;
+}
+
+void
+MLASCALL
+MlasConvWinogradPackFilter(
+    size_t GroupCount,
+    size_t InputChannels,
+    size_t FilterCount,
+    size_t OutputTile,
+    const float* Filter,
+    float* PackedFilter
+    )
+/*++
+
+Routine Description:
+
+    This routine transforms a 3x3 filter for the Winograd convolution
+    operation.
+
+Arguments:
+
+    GroupCount - Supplies the number of channel groups.
+
+    InputChannels - Supplies the number of input channels per group.
+
+    FilterCount - Supplies the number of filters per group.
+
+    OutputTile - Supplies the edge of the output tile, 2 or 4.
+
+    Filter - Supplies the filter tensor.
+
+    PackedFilter - Supplies the buffer to receive the transformed filter.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    if (OutputTile == 4) {
+        MlasConvWinogradPackFilterRange<4>(InputChannels, FilterCount, Filter, PackedFilter,
+            0, GroupCount * FilterCount);
+    } else {
+        MlasConvWinogradPackFilterRange<2>(InputChannels, FilterCount, Filter, PackedFilter,
+            0, GroupCount * FilterCount);
+    }
+}
@@ -2,6 +2,26 @@
 
 #include "mlasi.h"
 
+size_t
+MLASCALL
+MlasFlashAttentionGetBufferSizePerThread(
+    const MlasFlashAttentionThreadedArgs* args
+)
+{
+    const size_t q_block_size = static_cast<size_t>(args->q_block_size);
+    const size_t kv_block_size = static_cast<size_t>(args->kv_block_size);
+    const size_t qk_head_size = static_cast<size_t>(args->qk_head_size);
+    const size_t v_head_size = static_cast<size_t>(args->v_head_size);
+
+    // l, m, S and the temporary output
+    size_t elements = q_block_size * 2 + q_block_size * kv_block_size + q_block_size * v_head_size;
+    if (args->query_fp16 != nullptr) {
+        // fp32 copies of the blocks of Q, K and V
+        elements += q_block_size * qk_head_size + kv_block_size * (qk_head_size + v_head_size);
+    }
+    return elements * sizeof(float);
+}
+
 void
 MlasFlashAttentionThreaded(
     void* argptr,
@@ -17,13 +37,18 @@ MlasFlashAttentionThreaded(
     ptrdiff_t kv_sequence_length = static_cast<ptrdiff_t>(args->kv_sequence_length);
     ptrdiff_t qk_head_size = static_cast<ptrdiff_t>(args->qk_head_size);
     ptrdiff_t v_head_size = static_cast<ptrdiff_t>(args->v_head_size);
+    ptrdiff_t kv_num_heads = args->kv_num_heads > 0 ? static_cast<ptrdiff_t>(args->kv_num_heads) : num_heads;
+    ptrdiff_t kv_buffer_sequence_length = args->kv_buffer_sequence_length > 0
+                                              ? static_cast<ptrdiff_t>(args->kv_buffer_sequence_length)
+                                              : kv_sequence_length;
+    ptrdiff_t query_batch_stride = args->query_batch_stride > 0
+                                       ? static_cast<ptrdiff_t>(args->query_batch_stride)
+                                       : num_heads * q_sequence_length * qk_head_size;
+    ptrdiff_t local_window_size = static_cast<ptrdiff_t>(args->local_window_size);
     float* buffer = args->buffer;
     ptrdiff_t buffer_size_per_thread = static_cast<ptrdiff_t>(args->buffer_size_per_thread);
     ptrdiff_t thread_count = static_cast<ptrdiff_t>(args->thread_count);
-    const float* query = args->query;
-    const float* key = args->key;
-    const float* value = args->value;
-    float* output = args->output;
+    const bool is_fp16 = args->query_fp16 != nullptr;
 
 #if defined(MLAS_TARGET_AMD64) || defined(MLAS_TARGET_LARCH64)
     auto&& mlas_platform = GetMlasPlatform();
@@ -50,6 +75,7 @@ MlasFlashAttentionThreaded(
         batch_idx /= q_chunk_count;
         ptrdiff_t head_idx = batch_idx % num_heads;
         batch_idx /= num_heads;
+        ptrdiff_t kv_head_idx = head_idx / (num_heads / kv_num_heads);
 
         char* buffer_current_thread = reinterpret_cast<char*>(buffer) + thread_id * buffer_size_per_thread;
         float* l = reinterpret_cast<float*>(buffer_current_thread);
@@ -59,25 +85,72 @@ MlasFlashAttentionThreaded(
         }
         float* intermediate = m + q_block_size;
         float* temp_output = intermediate + q_block_size * kv_block_size;
+        float* q_fp32 = temp_output + q_block_size * v_head_size;
+        float* k_fp32 = q_fp32 + q_block_size * qk_head_size;
+        float* v_fp32 = k_fp32 + kv_block_size * qk_head_size;
         float negmax = 0;
 
-        for (ptrdiff_t ir = 0; ir < kv_sequence_length; ir += kv_block_size) {
+        ptrdiff_t row_size_q_valid = std::min(q_block_size, q_sequence_length - q_idx);
+
+        // The keys attended by query q are [kv_range_start(q), kv_range_end(q)).
+        ptrdiff_t kv_valid_length = kv_sequence_length;
+        if (args->kv_sequence_lengths != nullptr) {
+            kv_valid_length = std::min(kv_valid_length, static_cast<ptrdiff_t>(args->kv_sequence_lengths[batch_idx]));
+        }
+        ptrdiff_t causal_offset = std::max(kv_valid_length - q_sequence_length, ptrdiff_t{0});
+        auto kv_range_end = [&](ptrdiff_t q) {
+            return args->is_causal ? std::min(q + causal_offset + 1, kv_valid_length) : kv_valid_length;
+        };
+        auto kv_range_start = [&](ptrdiff_t q) {
+            if (args->is_causal && local_window_size >= 0) {
+                return std::max(q + causal_offset - local_window_size, ptrdiff_t{0});
+            }
+            return ptrdiff_t{0};
+        };
+
+        // Skip the blocks of keys that none of the queries of this block attend.
+        ptrdiff_t kv_start = (kv_range_start(q_idx) / kv_block_size) * kv_block_size;
+        ptrdiff_t kv_end = kv_range_end(q_idx + row_size_q_valid - 1);
+
+        ptrdiff_t q_offset = batch_idx * query_batch_stride + (head_idx * q_sequence_length + q_idx) * qk_head_size;
+        ptrdiff_t kv_head_offset = (batch_idx * kv_num_heads + kv_head_idx) * kv_buffer_sequence_length;
+
+        const float* inputQ;
+        if (is_fp16) {
+            MlasConvertHalfToFloatBuffer(args->query_fp16 + q_offset, q_fp32,
+                                         static_cast<size_t>(row_size_q_valid * qk_head_size));
+            inputQ = q_fp32;
+        } else {
+            inputQ = args->query + q_offset;
+        }
+
+        bool first_block = true;
+        for (ptrdiff_t ir = kv_start; ir < kv_end; ir += kv_block_size) {
             /*
-                S = Q[batch_idx, head_idx, q_idx:q_idx+q_block_size, :] * (K[batch_idx, head_idx, ir:ir+kv_block_size, :]).T
+                S = Q[batch_idx, head_idx, q_idx:q_idx+q_block_size, :] * (K[batch_idx, kv_head_idx, ir:ir+kv_block_size, :]).T
                 old_m = m
                 m = max(m, rowmax(S))
                 diff = old_m - m
                 S = exp(S - m)
                 l = exp(diff) * l + rowsum(S)
-                O = diag(exp(diff)) * O + S * V[batch_idx, head_idx, ir:ir+kv_block_size, :]
+                O = diag(exp(diff)) * O + S * V[batch_idx, kv_head_idx, ir:ir+kv_block_size, :]
             */
-            ptrdiff_t h = batch_idx * num_heads + head_idx;
-            const float* inputQ = query + (h * q_sequence_length + q_idx) * qk_head_size;
-            const float* inputK = key + (h * kv_sequence_length + ir) * qk_head_size;
-            const float* inputV = value + (h * kv_sequence_length + ir) * v_head_size;
+            size_t row_size_q_capped = static_cast<size_t>(row_size_q_valid);
+            size_t row_size_kv_capped = static_cast<size_t>(std::min(kv_block_size, kv_end - ir));
 
-            size_t row_size_q_capped = static_cast<size_t>(std::min(q_block_size, q_sequence_length - q_idx));
-            size_t row_size_kv_capped = static_cast<size_t>(std::min(kv_block_size, kv_sequence_length - ir));
+            const float* inputK;
+            const float* inputV;
+            if (is_fp16) {
+                MlasConvertHalfToFloatBuffer(args->key_fp16 + (kv_head_offset + ir) * qk_head_size, k_fp32,
+                                             row_size_kv_capped * static_cast<size_t>(qk_head_size));
+                MlasConvertHalfToFloatBuffer(args->value_fp16 + (kv_head_offset + ir) * v_head_size, v_fp32,
+                                             row_size_kv_capped * static_cast<size_t>(v_head_size));
+                inputK = k_fp32;
+                inputV = v_fp32;
+            } else {
+                inputK = args->key + (kv_head_offset + ir) * qk_head_size;
+                inputV = args->value + (kv_head_offset + ir) * v_head_size;
+            }
 
             MlasSgemmOperation(CBLAS_TRANSPOSE::CblasNoTrans,
                      CBLAS_TRANSPOSE::CblasTrans,
@@ -96,10 +169,25 @@ MlasFlashAttentionThreaded(
             for (ptrdiff_t irow = 0; irow < static_cast<ptrdiff_t>(row_size_q_capped); ++irow) {
                 float* p = intermediate + irow * row_size_kv_capped;
 
+                // Only the columns [col_start, col_end) of this row are attended, the others get a zero weight.
+                ptrdiff_t col_start = std::max(kv_range_start(q_idx + irow) - ir, ptrdiff_t{0});
+                ptrdiff_t col_end = std::min(kv_range_end(q_idx + irow) - ir, static_cast<ptrdiff_t>(row_size_kv_capped));
+                if (col_start >= col_end) {
+                    std::fill_n(p, row_size_kv_capped, 0.0f);
+                    if (first_block) {
+                        l[irow] = 0.0f;
+                    }
+                    continue;
+                }
+                std::fill(p, p + col_start, 0.0f);
+                std::fill(p + col_end, p + row_size_kv_capped, 0.0f);
+                p += col_start;
+                size_t col_count = static_cast<size_t>(col_end - col_start);
+
 #if defined(MLAS_TARGET_AMD64) || defined(MLAS_TARGET_LARCH64)
-                float rowmax = mlas_platform.ReduceMaximumF32Kernel(p, row_size_kv_capped);
+                float rowmax = mlas_platform.ReduceMaximumF32Kernel(p, col_count);
 #else
-                float rowmax = MlasReduceMaximumF32Kernel(p, row_size_kv_capped);
+                float rowmax = MlasReduceMaximumF32Kernel(p, col_count);
 #endif
                 float m_diff = m[irow];
                 m[irow] = std::max(m[irow], rowmax);  // new m
@@ -107,13 +195,14 @@ MlasFlashAttentionThreaded(
                 m_diff -= m[irow];  // old - new (less than 0)
 
 #if defined(MLAS_TARGET_AMD64)
-                float rowsum = mlas_platform.ComputeSumExpF32Kernel(p, p, row_size_kv_capped, &negmax);
+                float rowsum = mlas_platform.ComputeSumExpF32Kernel(p, p, col_count, &negmax);
 #else
-                float rowsum = MlasComputeSumExpF32Kernel(p, p, row_size_kv_capped, &negmax);
+                float rowsum = MlasComputeSumExpF32Kernel(p, p, col_count, &negmax);
 #endif
 
-                // Note: for ir == 0, there is actually no need to calculate exp_diff
-                if (ir != 0) {
+                // Note: for the first block, there is actually no need to calculate exp_diff
+                if (!first_block) {
+                    // exp_diff is 0 if the previous blocks had no attended key for this row.
                     float exp_diff = std::exp(m_diff);
                     l[irow] = exp_diff * l[irow] + rowsum;
 
@@ -122,7 +211,7 @@ MlasFlashAttentionThreaded(
                     }
                 } else {
                     l[irow] = rowsum;
-                    // When ir == 0, there is no need to scale the old result because it is zero.
+                    // For the first block, there is no need to scale the old result because it is zero.
                 }
             }
             MlasSgemmOperation(CBLAS_TRANSPOSE::CblasNoTrans,
@@ -135,19 +224,29 @@ MlasFlashAttentionThreaded(
                      row_size_kv_capped,
                      inputV,
                      static_cast<size_t>(v_head_size),
-                     ir == 0 ? 0.0f : 1.0f,
+                     first_block ? 0.0f : 1.0f,
                      temp_output,
                      static_cast<size_t>(v_head_size));
+            first_block = false;
         }
 
-        float* output_row = output + ((batch_idx * q_sequence_length + q_idx) * num_heads + head_idx) * v_head_size;
-        ptrdiff_t row_size_q_valid = std::min(q_block_size, q_sequence_length - q_idx);
+        ptrdiff_t output_offset = ((batch_idx * q_sequence_length + q_idx) * num_heads + head_idx) * v_head_size;
         // TODO: leverage advanced instruction sets
         for (ptrdiff_t irow = 0; irow < row_size_q_valid; ++irow) {
-            for (ptrdiff_t icol = 0; icol < v_head_size; ++icol) {
-                output_row[icol] = temp_output[irow * v_head_size + icol] / l[irow];
+            float* temp_row = temp_output + irow * v_head_size;
+            float* output_row = is_fp16 ? temp_row : args->output + output_offset;
+            if (first_block || l[irow] == 0.0f) {
+                // No key is attended by this query.
+                std::fill_n(output_row, v_head_size, 0.0f);
+            } else {
+                for (ptrdiff_t icol = 0; icol < v_head_size; ++icol) {
+                    output_row[icol] = temp_row[icol] / l[irow];
+                }
+            }
+            if (is_fp16) {
+                MlasConvertFloatToHalfBuffer(temp_row, args->output_fp16 + output_offset, static_cast<size_t>(v_head_size));
             }
-            output_row += num_heads * v_head_size;
+            output_offset += num_heads * v_head_size;
         }
     }
 }
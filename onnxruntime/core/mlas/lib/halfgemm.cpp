@@ -32,6 +32,16 @@ MlasFp16AccelerationSupported()
 #endif
 }
 
+bool MLASCALL
+MlasHalfGemmAccelerationSupported()
+{
+#if defined(MLAS_TARGET_AMD64)
+    return GetMlasPlatform().HalfGemmDispatch != nullptr;
+#else
+    return MlasFp16AccelerationSupported();
+#endif
+}
+
 
 void
 MLASCALL
@@ -217,55 +217,65 @@ MlasHalfGemmNoPackOperation(
 
     const auto* pa = reinterpret_cast<const _mlas_fp16_*>(Data->A)
         + RangeStartM * lda;
-    const _mlas_fp16_* pb;
+    const auto* B = reinterpret_cast<const _mlas_fp16_*>(Data->B);
     if (ldb == 0) {
-        pb = MlasHalfGemmPackedBOffset<KernelType>(
-            reinterpret_cast<const _mlas_fp16_*>(Data->B),
-            N,
-            K,
-            RangeStartN,
-            0);
         ldb = MlasHalfGemmPackedBLeadingDim<KernelType>(N, K);
-    } else {
-        pb = reinterpret_cast<const _mlas_fp16_*>(Data->B) + RangeStartN;
     }
 
     const _mlas_fp16_* Bias = (nullptr == Data->Bias)
         ? nullptr
         : reinterpret_cast<const _mlas_fp16_*>(Data->Bias) + RangeStartN;
-    _mlas_fp16_* c = reinterpret_cast<_mlas_fp16_*>(Data->C)
+    _mlas_fp16_* pc = reinterpret_cast<_mlas_fp16_*>(Data->C)
         + RangeStartM * ldc + RangeStartN;
 
-    size_t RowsRemaining = RangeCountM;
-    while (RowsRemaining > 0) {
-        MlasHalfGemmKernel<KernelType>(
-            RowsRemaining,
-            RangeCountN,
-            K,
-            c,
-            ldc,
-            Bias,
-            pa,
-            lda,
-            pb,
-            ldb,
-            true);
-
-        size_t RowsHandled = std::min(RowsRemaining, KernelType::KernelMaxM);
-
-        if (Data->OutputProcessor != nullptr) {
-            Data->OutputProcessor->Process(
-                Data->C,
-                RangeStartM + RangeCountM - RowsRemaining,
-                RangeStartN,
-                RowsHandled,
-                RangeCountN,
-                Data->ldc);
-        }
+    //
+    // Step through each slice of matrix B along the N dimension so that the
+    // columns of B used by the kernel stay in the cache while all the rows of
+    // A are processed.
+    //
+
+    constexpr size_t StrideN = KernelType::Strides.N;
+
+    for (size_t n = 0; n < RangeCountN; n += StrideN) {
+        const size_t CountN = std::min(RangeCountN - n, StrideN);
+
+        const _mlas_fp16_* pb = (Data->ldb == 0)
+            ? MlasHalfGemmPackedBOffset<KernelType>(B, N, K, RangeStartN + n, 0)
+            : B + RangeStartN + n;
+        const _mlas_fp16_* a = pa;
+        _mlas_fp16_* c = pc + n;
+
+        size_t RowsRemaining = RangeCountM;
+        while (RowsRemaining > 0) {
+            MlasHalfGemmKernel<KernelType>(
+                RowsRemaining,
+                CountN,
+                K,
+                c,
+                ldc,
+                (Bias == nullptr) ? nullptr : Bias + n,
+                a,
+                lda,
+                pb,
+                ldb,
+                true);
+
+            size_t RowsHandled = std::min(RowsRemaining, KernelType::KernelMaxM);
+
+            if (Data->OutputProcessor != nullptr) {
+                Data->OutputProcessor->Process(
+                    Data->C,
+                    RangeStartM + RangeCountM - RowsRemaining,
+                    RangeStartN + n,
+                    RowsHandled,
+                    CountN,
+                    Data->ldc);
+            }
 
-        c += ldc * RowsHandled;
-        pa += lda * RowsHandled;
-        RowsRemaining -= RowsHandled;
+            c += ldc * RowsHandled;
+            a += lda * RowsHandled;
+            RowsRemaining -= RowsHandled;
+        }
     }
 }
 
@@ -509,6 +519,9 @@ MlasHalfGemmGetDispatch()
 {
 #if defined(MLAS_F16VEC_INTRINSICS_SUPPORTED) && defined(MLAS_TARGET_ARM64)
     return &MlasHalfGemmDispatchNeon;
+#elif defined(MLAS_TARGET_AMD64)
+    const MLAS_HALFGEMM_DISPATCH* dispatch = GetMlasPlatform().HalfGemmDispatch;
+    return dispatch != nullptr ? dispatch : &MlasHalfGemmDispatchDefault;
 #else
     return &MlasHalfGemmDispatchDefault;
 #endif
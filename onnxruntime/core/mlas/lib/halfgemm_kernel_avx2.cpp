@@ -0,0 +1,372 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    halfgemm_kernel_avx2.cpp
+
+Abstract:
+
+    This module implements the half precision GEMM kernel for processors
+    supporting AVX2/FMA3/F16C.
+
+    The operands stay in half precision in memory. Each panel of A and each
+    row of B is converted to single precision when loaded and the products
+    are accumulated in single precision, the result is rounded to half
+    precision when stored to C.
+
+--*/
+
+#include "mlasi.h"
+#include "halfgemm.h"
+
+#include <immintrin.h>
+
+struct MLAS_HALF_GEMM_KERNEL_AVX2 {
+    static constexpr bool PackNeeded = false;
+    static constexpr size_t KernelMaxM = 6;  // max # rows the vectorized kernel can process
+    static constexpr size_t PackedK = 1;
+
+    static constexpr MLAS_HALF_GEMM_STRIDES Strides{24, 256, 512};
+};
+
+//
+// Number of columns of A converted to single precision at a time.
+//
+
+constexpr size_t MlasHalfGemmAvx2SliceK = 128;
+
+MLAS_FORCEINLINE
+__m256
+MlasHalfGemmLoadAvx2(
+    const _mlas_fp16_* Buffer,
+    size_t Count
+    )
+{
+    if (Count >= 8) {
+        return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Buffer)));
+    }
+
+    MLAS_DECLSPEC_ALIGN(_mlas_fp16_ Partial[8], 16) = {};
+    std::memcpy(Partial, Buffer, Count * sizeof(_mlas_fp16_));
+    return _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(Partial)));
+}
+
+MLAS_FORCEINLINE
+void
+MlasHalfGemmStoreAvx2(
+    _mlas_fp16_* Buffer,
+    __m256 Vector,
+    size_t Count
+    )
+{
+    const __m128i Half = _mm256_cvtps_ph(Vector, _MM_FROUND_TO_NEAREST_INT);
+
+    if (Count >= 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Buffer), Half);
+        return;
+    }
+
+    MLAS_DECLSPEC_ALIGN(_mlas_fp16_ Partial[8], 16);
+    _mm_store_si128(reinterpret_cast<__m128i*>(Partial), Half);
+    std::memcpy(Buffer, Partial, Count * sizeof(_mlas_fp16_));
+}
+
+MLAS_FORCEINLINE
+void
+MlasHalfGemmCvtHalfToFloatAvx2(
+    float* Destination,
+    const _mlas_fp16_* Source,
+    size_t Count
+    )
+{
+    while (Count >= 8) {
+        _mm256_storeu_ps(Destination, MlasHalfGemmLoadAvx2(Source, 8));
+        Source += 8;
+        Destination += 8;
+        Count -= 8;
+    }
+
+    for (size_t i = 0; i < Count; i++) {
+        Destination[i] = MLAS_Half2Float(Source[i]);
+    }
+}
+
+MLAS_FORCEINLINE
+void
+MlasHalfGemmCvtFloatToHalfAvx2(
+    _mlas_fp16_* Destination,
+    const float* Source,
+    size_t Count
+    )
+{
+    while (Count >= 8) {
+        MlasHalfGemmStoreAvx2(Destination, _mm256_loadu_ps(Source), 8);
+        Source += 8;
+        Destination += 8;
+        Count -= 8;
+    }
+
+    for (size_t i = 0; i < Count; i++) {
+        Destination[i] = MLAS_Float2Half(Source[i]);
+    }
+}
+
+//
+// Templates used to unroll a loop over the rows of the output so that the
+// accumulators are kept in registers.
+//
+
+template<size_t Count, size_t Index>
+struct MlasHalfGemmLoopUnrollStepAvx2
+{
+    template<typename IterationType, typename... IterationArgs>
+    MLAS_FORCEINLINE
+    static
+    void
+    Step(
+        IterationArgs&&... Arguments
+        )
+    {
+        IterationType::template Iteration<Count, Index>(Arguments...);
+        MlasHalfGemmLoopUnrollStepAvx2<Count, Index + 1>::template Step<IterationType>(Arguments...);
+    }
+};
+
+template<size_t Count>
+struct MlasHalfGemmLoopUnrollStepAvx2<Count, Count>
+{
+    template<typename IterationType, typename... IterationArgs>
+    MLAS_FORCEINLINE
+    static
+    void
+    Step(
+        IterationArgs&&...
+        )
+    {
+        // Terminate the loop.
+    }
+};
+
+template<size_t Count, typename IteratorType>
+struct MlasHalfGemmLoopUnrollAvx2
+{
+    template<typename... IterationArgs>
+    MLAS_FORCEINLINE
+    void
+    operator()(
+        IterationArgs&&... Arguments
+        )
+    {
+        MlasHalfGemmLoopUnrollStepAvx2<Count, 0>::template Step<IteratorType>(Arguments...);
+    }
+};
+
+struct MlasHalfGemmZeroAccumulatorsAvx2
+{
+    template<size_t RowCount, size_t Row>
+    MLAS_FORCEINLINE
+    static
+    void
+    Iteration(
+        __m256 Accumulators[RowCount][2]
+        )
+    {
+        Accumulators[Row][0] = _mm256_setzero_ps();
+        Accumulators[Row][1] = _mm256_setzero_ps();
+    }
+};
+
+struct MlasHalfGemmMultiplyAccumulateAvx2
+{
+    template<size_t RowCount, size_t Row>
+    MLAS_FORCEINLINE
+    static
+    void
+    Iteration(
+        __m256 Accumulators[RowCount][2],
+        const float* PanelA,
+        __m256 b0,
+        __m256 b1
+        )
+    {
+        const __m256 a = _mm256_broadcast_ss(PanelA + Row * MlasHalfGemmAvx2SliceK);
+        Accumulators[Row][0] = _mm256_fmadd_ps(a, b0, Accumulators[Row][0]);
+        Accumulators[Row][1] = _mm256_fmadd_ps(a, b1, Accumulators[Row][1]);
+    }
+};
+
+/**
+ * @brief Computes RowCount rows of C for all CountN columns, 16 columns at
+ *        a time. The accumulators of a block of columns stay in single
+ *        precision for the whole K dimension.
+ */
+template<size_t RowCount>
+void
+MlasHalfGemmKernelAvx2Rows(
+    size_t CountN,
+    size_t CountK,
+    _mlas_fp16_* C,
+    size_t ldc,
+    const _mlas_fp16_* Bias,
+    const _mlas_fp16_* A,
+    size_t lda,
+    const _mlas_fp16_* B,
+    size_t ldb,
+    bool ZeroMode
+    )
+{
+    MLAS_DECLSPEC_ALIGN(float PanelA[RowCount][MlasHalfGemmAvx2SliceK], 32);
+
+    for (size_t n = 0; n < CountN; n += 16) {
+
+        const size_t CountColumns = std::min(CountN - n, size_t(16));
+        __m256 Accumulators[RowCount][2];
+
+        MlasHalfGemmLoopUnrollAvx2<RowCount, MlasHalfGemmZeroAccumulatorsAvx2>()(Accumulators);
+
+        for (size_t k = 0; k < CountK; k += MlasHalfGemmAvx2SliceK) {
+
+            const size_t CountSliceK = std::min(CountK - k, MlasHalfGemmAvx2SliceK);
+
+            for (size_t r = 0; r < RowCount; r++) {
+                MlasHalfGemmCvtHalfToFloatAvx2(PanelA[r], A + r * lda + k, CountSliceK);
+            }
+
+            const _mlas_fp16_* b = B + k * ldb + n;
+
+            if (CountColumns == 16) {
+                for (size_t kk = 0; kk < CountSliceK; kk++) {
+                    const __m256 b0 = MlasHalfGemmLoadAvx2(b, 8);
+                    const __m256 b1 = MlasHalfGemmLoadAvx2(b + 8, 8);
+                    MlasHalfGemmLoopUnrollAvx2<RowCount, MlasHalfGemmMultiplyAccumulateAvx2>()(
+                        Accumulators, &PanelA[0][kk], b0, b1);
+                    b += ldb;
+                }
+            } else {
+                const size_t Count0 = std::min(CountColumns, size_t(8));
+                const size_t Count1 = CountColumns - Count0;
+                for (size_t kk = 0; kk < CountSliceK; kk++) {
+                    const __m256 b0 = MlasHalfGemmLoadAvx2(b, Count0);
+                    const __m256 b1 = (Count1 > 0) ? MlasHalfGemmLoadAvx2(b + 8, Count1) : _mm256_setzero_ps();
+                    MlasHalfGemmLoopUnrollAvx2<RowCount, MlasHalfGemmMultiplyAccumulateAvx2>()(
+                        Accumulators, &PanelA[0][kk], b0, b1);
+                    b += ldb;
+                }
+            }
+        }
+
+        //
+        // Add the bias or the existing output and store the result.
+        //
+
+        const size_t Count0 = std::min(CountColumns, size_t(8));
+        const size_t Count1 = CountColumns - Count0;
+        const __m256 Bias0 = (Bias != nullptr) ? MlasHalfGemmLoadAvx2(Bias + n, Count0) : _mm256_setzero_ps();
+        const __m256 Bias1 = (Bias != nullptr && Count1 > 0) ? MlasHalfGemmLoadAvx2(Bias + n + 8, Count1)
+                                                              : _mm256_setzero_ps();
+
+        for (size_t r = 0; r < RowCount; r++) {
+            _mlas_fp16_* c = C + r * ldc + n;
+            __m256 Result0 = _mm256_add_ps(Accumulators[r][0], Bias0);
+            __m256 Result1 = _mm256_add_ps(Accumulators[r][1], Bias1);
+            if (!ZeroMode) {
+                Result0 = _mm256_add_ps(Result0, MlasHalfGemmLoadAvx2(c, Count0));
+                if (Count1 > 0) {
+                    Result1 = _mm256_add_ps(Result1, MlasHalfGemmLoadAvx2(c + 8, Count1));
+                }
+            }
+            MlasHalfGemmStoreAvx2(c, Result0, Count0);
+            if (Count1 > 0) {
+                MlasHalfGemmStoreAvx2(c + 8, Result1, Count1);
+            }
+        }
+    }
+}
+
+template<>
+MLAS_FORCEINLINE
+void
+MlasHalfGemmConvertPackA<MLAS_HALF_GEMM_KERNEL_AVX2>(
+    _mlas_fp16_* D,
+    const float* A,
+    size_t lda,
+    size_t CountM,
+    size_t CountK
+)
+{
+    for (size_t m = 0; m < CountM; m++) {
+        MlasHalfGemmCvtFloatToHalfAvx2(D, A, CountK);
+        A += lda;
+        D += CountK;
+    }
+}
+
+template<>
+MLAS_FORCEINLINE
+void
+MlasHalfGemmConvertPackB<MLAS_HALF_GEMM_KERNEL_AVX2>(
+    _mlas_fp16_* D,
+    const float* B,
+    size_t ldb,
+    size_t CountN,
+    size_t CountK
+)
+{
+    for (size_t k = 0; k < CountK; k++) {
+        MlasHalfGemmCvtFloatToHalfAvx2(D, B, CountN);
+        B += ldb;
+        D += CountN;
+    }
+}
+
+template<>
+MLAS_FORCEINLINE
+void
+MlasHalfGemmKernel<MLAS_HALF_GEMM_KERNEL_AVX2>(
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    _mlas_fp16_* C,
+    size_t ldc,
+    const _mlas_fp16_* Bias,
+    const _mlas_fp16_* A,
+    size_t lda,
+    const _mlas_fp16_* B,
+    size_t ldb,
+    const bool ZeroMode)
+{
+    switch (std::min(CountM, MLAS_HALF_GEMM_KERNEL_AVX2::KernelMaxM)) {
+        case 1:
+            MlasHalfGemmKernelAvx2Rows<1>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 2:
+            MlasHalfGemmKernelAvx2Rows<2>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 3:
+            MlasHalfGemmKernelAvx2Rows<3>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 4:
+            MlasHalfGemmKernelAvx2Rows<4>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 5:
+            MlasHalfGemmKernelAvx2Rows<5>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        default:
+            MlasHalfGemmKernelAvx2Rows<6>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+    }
+}
+
+
+const MLAS_HALFGEMM_DISPATCH MlasHalfGemmDispatchAvx2 = {
+    MlasHalfGemmOperation<MLAS_HALF_GEMM_KERNEL_AVX2>,
+    nullptr,
+    MlasHalfGemmConvertPackB<MLAS_HALF_GEMM_KERNEL_AVX2>,
+    MLAS_HALF_GEMM_KERNEL_AVX2::PackedK,
+    MLAS_HALF_GEMM_KERNEL_AVX2::KernelMaxM,
+    0
+};
@@ -0,0 +1,222 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    halfgemm_kernel_avx512fp16.cpp
+
+Abstract:
+
+    This module implements the half precision GEMM kernel for processors
+    supporting AVX512-FP16.
+
+    Like the NEON kernel, the products are accumulated in half precision
+    with fused multiply add instructions operating on 32 elements.
+
+--*/
+
+#include "mlasi.h"
+#include "halfgemm.h"
+
+#include <immintrin.h>
+
+struct MLAS_HALF_GEMM_KERNEL_AVX512FP16 {
+    static constexpr bool PackNeeded = false;
+    static constexpr size_t KernelMaxM = 6;  // max # rows the vectorized kernel can process
+    static constexpr size_t PackedK = 1;
+
+    static constexpr MLAS_HALF_GEMM_STRIDES Strides{24, 256, 512};
+};
+
+MLAS_FORCEINLINE
+__mmask32
+MlasHalfGemmMaskAvx512Fp16(
+    size_t Count
+    )
+{
+    return static_cast<__mmask32>((uint64_t(1) << std::min(Count, size_t(32))) - 1);
+}
+
+MLAS_FORCEINLINE
+__m512h
+MlasHalfGemmLoadAvx512Fp16(
+    const _mlas_fp16_* Buffer,
+    __mmask32 Mask
+    )
+{
+    return _mm512_castsi512_ph(_mm512_maskz_loadu_epi16(Mask, Buffer));
+}
+
+MLAS_FORCEINLINE
+void
+MlasHalfGemmCvtFloatToHalfAvx512Fp16(
+    _mlas_fp16_* Destination,
+    const float* Source,
+    size_t Count
+    )
+{
+    while (Count > 0) {
+        const size_t CountThisIteration = std::min(Count, size_t(16));
+        const __mmask16 Mask = static_cast<__mmask16>((1u << CountThisIteration) - 1);
+        const __m256i Half = _mm512_cvtps_ph(_mm512_maskz_loadu_ps(Mask, Source), _MM_FROUND_TO_NEAREST_INT);
+        _mm256_mask_storeu_epi16(Destination, Mask, Half);
+        Source += CountThisIteration;
+        Destination += CountThisIteration;
+        Count -= CountThisIteration;
+    }
+}
+
+/**
+ * @brief Computes RowCount rows of C for all CountN columns, 64 columns at
+ *        a time. Partial blocks of columns use masked loads and stores.
+ */
+template<size_t RowCount>
+void
+MlasHalfGemmKernelAvx512Fp16Rows(
+    size_t CountN,
+    size_t CountK,
+    _mlas_fp16_* C,
+    size_t ldc,
+    const _mlas_fp16_* Bias,
+    const _mlas_fp16_* A,
+    size_t lda,
+    const _mlas_fp16_* B,
+    size_t ldb,
+    bool ZeroMode
+    )
+{
+    for (size_t n = 0; n < CountN; n += 64) {
+
+        const size_t CountColumns = std::min(CountN - n, size_t(64));
+        const __mmask32 Mask0 = MlasHalfGemmMaskAvx512Fp16(CountColumns);
+        const __mmask32 Mask1 = MlasHalfGemmMaskAvx512Fp16(CountColumns > 32 ? CountColumns - 32 : 0);
+
+        __m512h Accumulators[RowCount][2];
+
+        if (Bias != nullptr) {
+            const __m512h Bias0 = MlasHalfGemmLoadAvx512Fp16(Bias + n, Mask0);
+            const __m512h Bias1 = MlasHalfGemmLoadAvx512Fp16(Bias + n + 32, Mask1);
+            for (size_t r = 0; r < RowCount; r++) {
+                Accumulators[r][0] = Bias0;
+                Accumulators[r][1] = Bias1;
+            }
+        } else {
+            for (size_t r = 0; r < RowCount; r++) {
+                Accumulators[r][0] = _mm512_setzero_ph();
+                Accumulators[r][1] = _mm512_setzero_ph();
+            }
+        }
+
+        const _mlas_fp16_* b = B + n;
+
+        for (size_t k = 0; k < CountK; k++) {
+            const __m512h b0 = MlasHalfGemmLoadAvx512Fp16(b, Mask0);
+            const __m512h b1 = MlasHalfGemmLoadAvx512Fp16(b + 32, Mask1);
+            for (size_t r = 0; r < RowCount; r++) {
+                const __m512h a = _mm512_castsi512_ph(_mm512_set1_epi16(static_cast<short>(A[r * lda + k])));
+                Accumulators[r][0] = _mm512_fmadd_ph(a, b0, Accumulators[r][0]);
+                Accumulators[r][1] = _mm512_fmadd_ph(a, b1, Accumulators[r][1]);
+            }
+            b += ldb;
+        }
+
+        for (size_t r = 0; r < RowCount; r++) {
+            _mlas_fp16_* c = C + r * ldc + n;
+            __m512h Result0 = Accumulators[r][0];
+            __m512h Result1 = Accumulators[r][1];
+            if (!ZeroMode) {
+                Result0 = _mm512_add_ph(Result0, MlasHalfGemmLoadAvx512Fp16(c, Mask0));
+                Result1 = _mm512_add_ph(Result1, MlasHalfGemmLoadAvx512Fp16(c + 32, Mask1));
+            }
+            _mm512_mask_storeu_epi16(c, Mask0, _mm512_castph_si512(Result0));
+            _mm512_mask_storeu_epi16(c + 32, Mask1, _mm512_castph_si512(Result1));
+        }
+    }
+}
+
+template<>
+MLAS_FORCEINLINE
+void
+MlasHalfGemmConvertPackA<MLAS_HALF_GEMM_KERNEL_AVX512FP16>(
+    _mlas_fp16_* D,
+    const float* A,
+    size_t lda,
+    size_t CountM,
+    size_t CountK
+)
+{
+    for (size_t m = 0; m < CountM; m++) {
+        MlasHalfGemmCvtFloatToHalfAvx512Fp16(D, A, CountK);
+        A += lda;
+        D += CountK;
+    }
+}
+
+template<>
+MLAS_FORCEINLINE
+void
+MlasHalfGemmConvertPackB<MLAS_HALF_GEMM_KERNEL_AVX512FP16>(
+    _mlas_fp16_* D,
+    const float* B,
+    size_t ldb,
+    size_t CountN,
+    size_t CountK
+)
+{
+    for (size_t k = 0; k < CountK; k++) {
+        MlasHalfGemmCvtFloatToHalfAvx512Fp16(D, B, CountN);
+        B += ldb;
+        D += CountN;
+    }
+}
+
+template<>
+MLAS_FORCEINLINE
+void
+MlasHalfGemmKernel<MLAS_HALF_GEMM_KERNEL_AVX512FP16>(
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    _mlas_fp16_* C,
+    size_t ldc,
+    const _mlas_fp16_* Bias,
+    const _mlas_fp16_* A,
+    size_t lda,
+    const _mlas_fp16_* B,
+    size_t ldb,
+    const bool ZeroMode)
+{
+    switch (std::min(CountM, MLAS_HALF_GEMM_KERNEL_AVX512FP16::KernelMaxM)) {
+        case 1:
+            MlasHalfGemmKernelAvx512Fp16Rows<1>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 2:
+            MlasHalfGemmKernelAvx512Fp16Rows<2>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 3:
+            MlasHalfGemmKernelAvx512Fp16Rows<3>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 4:
+            MlasHalfGemmKernelAvx512Fp16Rows<4>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        case 5:
+            MlasHalfGemmKernelAvx512Fp16Rows<5>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+        default:
+            MlasHalfGemmKernelAvx512Fp16Rows<6>(CountN, CountK, C, ldc, Bias, A, lda, B, ldb, ZeroMode);
+            break;
+    }
+}
+
+
+const MLAS_HALFGEMM_DISPATCH MlasHalfGemmDispatchAvx512Fp16 = {
+    MlasHalfGemmOperation<MLAS_HALF_GEMM_KERNEL_AVX512FP16>,
+    nullptr,
+    MlasHalfGemmConvertPackB<MLAS_HALF_GEMM_KERNEL_AVX512FP16>,
+    MLAS_HALF_GEMM_KERNEL_AVX512FP16::PackedK,
+    MLAS_HALF_GEMM_KERNEL_AVX512FP16::KernelMaxM,
+    0
+};
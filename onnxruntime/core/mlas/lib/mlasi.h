@@ -444,6 +444,23 @@ void
     float beta
     );
 
+typedef
+void
+(MLASCALL MLAS_SGEMM_SMALL_KERNEL)(
+    CBLAS_TRANSPOSE TransA,
+    size_t M,
+    size_t N,
+    size_t K,
+    float alpha,
+    const float* A,
+    size_t lda,
+    const float* B,
+    size_t ldb,
+    float beta,
+    float* C,
+    size_t ldc
+    );
+
 typedef
 void
 (MLASCALL MLAS_SGEMM_TRANSPOSE_PACKB_BLOCK_ROUTINE)(
@@ -610,6 +627,17 @@ void
     const float* Parameters
     );
 
+typedef
+float
+(MLASCALL MLAS_COMPUTE_SOFTMAX_INPUT_FLOAT_KERNEL)(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Scale,
+    const float* Bias,
+    const float* Mask
+    );
+
 typedef
 float
 (MLASCALL MLAS_REDUCE_MAXIMUM_FLOAT_KERNEL)(
@@ -806,6 +834,7 @@ extern "C" {
 #if defined(MLAS_TARGET_AMD64)
     MLAS_SGEMM_KERNEL_M1_ROUTINE MlasSgemmKernelM1Avx;
     MLAS_SGEMM_KERNEL_M1_ROUTINE MlasSgemmKernelM1TransposeBAvx;
+    MLAS_SGEMM_SMALL_KERNEL MlasSgemmSmallKernelFma3;
 #elif defined(MLAS_TARGET_ARM64) || defined(MLAS_TARGET_WASM)
     MLAS_GEMV_FLOAT_KERNEL MlasGemvFloatKernel;
 #endif
@@ -874,6 +903,7 @@ extern "C" {
     MLAS_COMPUTE_SUMEXP_FLOAT_KERNEL MlasComputeSumExpF32Kernel;
     MLAS_COMPUTE_SOFTMAX_OUTPUT_FLOAT_KERNEL MlasComputeSoftmaxOutputF32Kernel;
     MLAS_COMPUTE_LOGSOFTMAX_OUTPUT_FLOAT_KERNEL MlasComputeLogSoftmaxOutputF32Kernel;
+    MLAS_COMPUTE_SOFTMAX_INPUT_FLOAT_KERNEL MlasComputeSoftmaxInputF32Kernel;
     MLAS_QLINEAR_BINARY_OP_S8_KERNEL MlasQLinearAddS8Kernel;
     MLAS_QLINEAR_BINARY_OP_U8_KERNEL MlasQLinearAddU8Kernel;
     MLAS_QUANTIZE_LINEAR_S8_KERNEL MlasQuantizeLinearS8Kernel;
@@ -892,6 +922,7 @@ extern "C" {
     MLAS_COMPUTE_SUMEXP_FLOAT_KERNEL MlasComputeSumExpF32KernelAvx512F;
     MLAS_COMPUTE_SOFTMAX_OUTPUT_FLOAT_KERNEL MlasComputeSoftmaxOutputF32KernelAvx;
     MLAS_COMPUTE_LOGSOFTMAX_OUTPUT_FLOAT_KERNEL MlasComputeLogSoftmaxOutputF32KernelAvx;
+    MLAS_COMPUTE_SOFTMAX_INPUT_FLOAT_KERNEL MlasComputeSoftmaxInputF32KernelAvx512F;
     MLAS_QLINEAR_BINARY_OP_S8_KERNEL MlasQLinearAddS8KernelAvx2;
     MLAS_QLINEAR_BINARY_OP_U8_KERNEL MlasQLinearAddU8KernelAvx2;
     MLAS_QUANTIZE_LINEAR_S8_KERNEL MlasQuantizeLinearS8KernelAvx512F;
@@ -945,7 +976,7 @@ extern "C" {
 #define MLAS_DGEMM_THREAD_COMPLEXITY                (size_t(64) * size_t(1024))
 #define MLAS_QGEMM_THREAD_COMPLEXITY                65536
 
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(MLAS_SBGEMM_SUPPORTED)
 #define MLAS_SBGEMM_THREAD_COMPLEXITY (size_t(64) * size_t(1024))
 #endif
 
@@ -967,7 +998,8 @@ MlasSgemmOperation(
     size_t ldb,
     float beta,
     float* C,
-    size_t ldc
+    size_t ldc,
+    const MLAS_SGEMM_EPILOGUE* Epilogue = nullptr
     );
 
 //
@@ -1049,6 +1081,42 @@ extern const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512;
 
 extern const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512vnni;
 
+extern const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512vnniAmx;
+
+//
+// Bfloat16 precision matrix/matrix multiply dispatch structure.
+//
+
+struct MLAS_SBGEMM_DISPATCH;
+
+extern const MLAS_SBGEMM_DISPATCH MlasSBGemmDispatchAvx512Bf16;
+
+extern const MLAS_SBGEMM_DISPATCH MlasSBGemmDispatchAmx;
+
+//
+// Half precision matrix/matrix multiply dispatch structure.
+//
+
+struct MLAS_HALFGEMM_DISPATCH;
+
+extern const MLAS_HALFGEMM_DISPATCH MlasHalfGemmDispatchAvx2;
+
+extern const MLAS_HALFGEMM_DISPATCH MlasHalfGemmDispatchAvx512Fp16;
+
+//
+// Vectorized transcendental routines dispatch structure.
+//
+
+struct MLAS_TRANSCENDENTAL_DISPATCH;
+
+extern const MLAS_TRANSCENDENTAL_DISPATCH MlasTranscendentalDispatchDefault;
+
+#if defined(MLAS_TARGET_AMD64)
+extern const MLAS_TRANSCENDENTAL_DISPATCH MlasTranscendentalDispatchFma3;
+
+extern const MLAS_TRANSCENDENTAL_DISPATCH MlasTranscendentalDispatchAvx512F;
+#endif
+
 //
 // Quantized depthwise convolution kernels.
 //
@@ -1163,6 +1231,7 @@ struct MLAS_PLATFORM {
 #if defined(MLAS_TARGET_AMD64)
     MLAS_SGEMM_KERNEL_M1_ROUTINE* KernelM1Routine;
     MLAS_SGEMM_KERNEL_M1_ROUTINE* KernelM1TransposeBRoutine;
+    MLAS_SGEMM_SMALL_KERNEL* SgemmSmallKernel{nullptr};
     MLAS_SGEMM_TRANSPOSE_PACKB_BLOCK_ROUTINE* TransposePackB16x4Routine;
     MLAS_GEMM_DOUBLE_KERNEL* GemmDoubleKernel;
     MLAS_GEMM_U8S8_KERNEL* GemmU8S8Kernel;
@@ -1184,6 +1253,7 @@ struct MLAS_PLATFORM {
     MLAS_COMPUTE_SUMEXP_FLOAT_KERNEL* ComputeSumExpF32Kernel;
     MLAS_COMPUTE_SOFTMAX_OUTPUT_FLOAT_KERNEL* ComputeSoftmaxOutputF32Kernel;
     MLAS_COMPUTE_LOGSOFTMAX_OUTPUT_FLOAT_KERNEL* ComputeLogSoftmaxOutputF32Kernel;
+    MLAS_COMPUTE_SOFTMAX_INPUT_FLOAT_KERNEL* ComputeSoftmaxInputF32Kernel;
     MLAS_REDUCE_MAXIMUM_FLOAT_KERNEL* ReduceMaximumF32Kernel;
     MLAS_REDUCE_MINIMUM_MAXIMUM_FLOAT_KERNEL* ReduceMinimumMaximumF32Kernel;
     MLAS_QUANTIZE_LINEAR_S8_KERNEL* QuantizeLinearS8Kernel;
@@ -1206,6 +1276,12 @@ struct MLAS_PLATFORM {
 
     const MLAS_QNBIT_GEMM_DISPATCH* QNBitGemmDispatch{nullptr};
 
+#if defined(MLAS_TARGET_AMD64)
+    const MLAS_SBGEMM_DISPATCH* SBGemmDispatch{nullptr};
+    const MLAS_HALFGEMM_DISPATCH* HalfGemmDispatch{nullptr};
+    const MLAS_TRANSCENDENTAL_DISPATCH* TranscendentalDispatch{&MlasTranscendentalDispatchDefault};
+#endif
+
     MLAS_CAST_F16_TO_F32_KERNEL* CastF16ToF32Kernel;
     MLAS_CAST_F32_TO_F16_KERNEL* CastF32ToF16Kernel;
 };
@@ -1372,6 +1448,28 @@ MlasConvDepthwiseFloat_CHW(
 
 #endif
 
+//
+// Winograd convolution routines (see convolve_winograd.cpp).
+//
+
+void
+MlasConvWinogradPrepare(
+    MLAS_CONV_PARAMETERS* Parameters,
+    size_t* WorkingBufferSize,
+    MLAS_THREADPOOL* ThreadPool
+    );
+
+void
+MlasConvWinograd(
+    const MLAS_CONV_PARAMETERS* Parameters,
+    const float* Input,
+    const float* Filter,
+    const float* Bias,
+    float* WorkingBuffer,
+    float* Output,
+    MLAS_THREADPOOL* ThreadPool
+    );
+
 
 //
 // Define the missing ARM64 NEON intrinsic macros from arm64_neon.h that enable
@@ -275,6 +275,7 @@ Return Value:
     this->ComputeSumExpF32Kernel = MlasComputeSumExpF32Kernel;
     this->ComputeSoftmaxOutputF32Kernel = MlasComputeSoftmaxOutputF32Kernel;
     this->ComputeLogSoftmaxOutputF32Kernel = MlasComputeLogSoftmaxOutputF32Kernel;
+    this->ComputeSoftmaxInputF32Kernel = MlasComputeSoftmaxInputF32Kernel;
     this->ReduceMaximumF32Kernel = MlasReduceMaximumF32Kernel;
     this->ReduceMinimumMaximumF32Kernel = MlasReduceMinimumMaximumF32Kernel;
     this->QLinearAddS8Kernel = MlasQLinearAddS8Kernel;
@@ -382,6 +383,7 @@ Return Value:
                 this->ConvSymU8S8Dispatch = &MlasConvSymDispatchAvx2;
 
                 this->GemmFloatKernel = MlasGemmFloatKernelFma3;
+                this->SgemmSmallKernel = MlasSgemmSmallKernelFma3;
                 this->GemmDoubleKernel = MlasGemmDoubleKernelFma3;
                 this->ConvNchwFloatKernel = MlasConvNchwFloatKernelFma3;
                 this->ConvNchwcFloatKernel = MlasConvNchwcFloatKernelFma3;
@@ -391,6 +393,7 @@ Return Value:
                 this->LogisticKernelRoutine = MlasComputeLogisticF32KernelFma3;
                 this->TanhKernelRoutine = MlasComputeTanhF32KernelFma3;
                 this->ErfKernelRoutine = MlasErfKernelFma3;
+                this->TranscendentalDispatch = &MlasTranscendentalDispatchFma3;
                 this->QLinearAddS8Kernel = MlasQLinearAddS8KernelAvx2;
                 this->QLinearAddU8Kernel = MlasQLinearAddU8KernelAvx2;
                 this->ConvDepthwiseU8S8Kernel = MlasConvDepthwiseKernelAvx2<uint8_t, int8_t>;
@@ -402,6 +405,14 @@ Return Value:
                 this->CastF16ToF32Kernel = &MlasCastF16ToF32KernelAvx2;
                 this->CastF32ToF16Kernel = &MlasCastF32ToF16KernelAvx2;
 
+                //
+                // Check if the processor supports F16C, used by the half
+                // precision GEMM kernel to convert on load.
+                //
+
+                if ((Cpuid1[2] & 0x20000000) != 0) {
+                    this->HalfGemmDispatch = &MlasHalfGemmDispatchAvx2;
+                }
 
                 //
                 // Check if the processor supports Hybrid core architecture.
@@ -450,8 +461,10 @@ Return Value:
                     this->PoolFloatKernel[MlasAveragePoolingExcludePad] = MlasPoolAverageExcludePadFloatKernelAvx512F;
                     this->PoolFloatKernel[MlasAveragePoolingIncludePad] = MlasPoolAverageIncludePadFloatKernelAvx512F;
                     this->ComputeExpF32Kernel = MlasComputeExpF32KernelAvx512F;
+                    this->TranscendentalDispatch = &MlasTranscendentalDispatchAvx512F;
                     this->ComputeSumExpF32Kernel = MlasComputeSumExpF32KernelAvx512F;
                     this->ReduceMaximumF32Kernel = MlasReduceMaximumF32KernelAvx512F;
+                    this->ComputeSoftmaxInputF32Kernel = MlasComputeSoftmaxInputF32KernelAvx512F;
                     this->QuantizeLinearS8Kernel = MlasQuantizeLinearS8KernelAvx512F;
                     this->QuantizeLinearU8Kernel = MlasQuantizeLinearU8KernelAvx512F;
                     this->NchwcBlockSize = 16;
@@ -484,6 +497,28 @@ Return Value:
                             this->Q8Q4GemmDispatch = &MlasQ8Q4GemmDispatchAvx512vnni;
                             this->QNBitGemmDispatch = &MlasSQNBitGemmDispatchAvx512vnni;
                         }
+
+#if defined(MLAS_SBGEMM_SUPPORTED)
+                        //
+                        // Check if the processor supports AVX512-BF16.
+                        //
+
+                        if ((Cpuid7_1[0] & 0x20) != 0) {
+
+                            this->SBGemmDispatch = &MlasSBGemmDispatchAvx512Bf16;
+                        }
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 12) && !defined(__APPLE__)
+                        //
+                        // Check if the processor supports AVX512-FP16.
+                        //
+
+                        if ((Cpuid7[3] & 0x800000) != 0) {
+
+                            this->HalfGemmDispatch = &MlasHalfGemmDispatchAvx512Fp16;
+                        }
+#endif
                     }
                 }
 
@@ -519,8 +554,27 @@ Return Value:
                     if (MlasInitAMX()) {
                         this->GemmU8U8Dispatch = &MlasGemmU8S8DispatchAmx;
                         this->GemmU8S8Dispatch = &MlasGemmU8S8DispatchAmx;
+                        if (this->QNBitGemmDispatch == &MlasSQNBitGemmDispatchAvx512vnni) {
+                            this->QNBitGemmDispatch = &MlasSQNBitGemmDispatchAvx512vnniAmx;
+                        }
                     }
                 }
+
+#if defined(MLAS_SBGEMM_SUPPORTED)
+                //
+                // Check if the processor supports AMX-TILE and AMX-BF16
+                // features. The AVX512-BF16 kernel handles the rows that do
+                // not fill a tile.
+                //
+                if ((Cpuid7[3] & 0b1 << 22) != 0 &&
+                    (Cpuid7[3] & 0b1 << 24) != 0 &&
+                    (xcr0 & XFEATURE_MASK_XTILE) == XFEATURE_MASK_XTILE &&
+                    this->SBGemmDispatch != nullptr) {
+                    if (MlasInitAMX()) {
+                        this->SBGemmDispatch = &MlasSBGemmDispatchAmx;
+                    }
+                }
+#endif
 #endif // __APPLE__
 
 #endif // ORT_MINIMAL_BUILD
@@ -30,8 +30,6 @@ Abstract:
         MLAS_SBGEMM_STRIDES Strides{128, 128, 256};
 --*/
 
-#if defined(__aarch64__) && defined(__linux__)
-
 #pragma once
 
 #include <cassert>
@@ -39,6 +37,15 @@ Abstract:
 
 #include "mlasi.h"
 
+#if defined(MLAS_SBGEMM_SUPPORTED)
+
+#if defined(MLAS_TARGET_AMD64)
+//
+// The x86 kernels only move bfloat16 values around as raw 16-bit patterns.
+//
+typedef uint16_t bfloat16_t;
+#endif
+
 /**
  * @brief Define the default striding parameters for
  *        the bfloat16 precision gemm operation
@@ -134,7 +141,11 @@ MlasSBGemmPackedOperation(size_t M, size_t RangeStartN, size_t RangeCountN, size
             bool ZeroMode = (k == 0);
             CountK = std::min(K - k, PackedStrideK);
 
-            const bfloat16_t* pb = (const bfloat16_t*)PackedB + AlignedN * k + CountK * SliceStartN;
+            //
+            // Every column of the last slice is padded to the packed alignment on the K dimension.
+            //
+            const size_t PackedCountK = (CountK + KernelType::PackedK - 1) & ~(KernelType::PackedK - 1);
+            const bfloat16_t* pb = (const bfloat16_t*)PackedB + AlignedN * k + PackedCountK * SliceStartN;
             float* c = C + n;
             const float* pbias = ((nullptr == Bias) ? nullptr : Bias + RangeStartN + n);
             MlasSBGemmKernel<KernelType>(M, CountN, CountK, A + k, lda, pb, c, ldc, ZeroMode ? pbias : nullptr, ZeroMode);
@@ -173,7 +184,8 @@ MlasSBGemmNonPackedOperation(size_t M, size_t N, size_t K, const float* A, size_
         }
     }
 
-    constexpr size_t packBSize = UpAlignSize(Strides.N * Strides.K * sizeof(bfloat16_t));
+    const size_t PackedStrideK = (StrideK + KernelType::PackedK - 1) & ~(KernelType::PackedK - 1);
+    const size_t packBSize = UpAlignSize(StrideN * PackedStrideK * sizeof(bfloat16_t));
     MlasThreadedBufAlloc(packBSize);
     uint8_t* p = ThreadedBufHolder.get();
     auto* PanelB = reinterpret_cast<bfloat16_t*>(p);
@@ -291,8 +303,10 @@ MlasSBGemmGetDispatch()
 {
 #if defined(MLAS_TARGET_ARM64)
     return &MlasSBGemmDispatchNeon;
+#elif defined(MLAS_TARGET_AMD64)
+    return GetMlasPlatform().SBGemmDispatch;
 #else
-    std::cerr << "SBGemm Kernel is supported only on ARM64 platform.";
+    std::cerr << "SBGemm Kernel is supported only on ARM64 and AMD64 platforms.";
     exit(1);
 #endif
 }
@@ -396,4 +410,4 @@ MlasSBGemmBatch(const size_t M, const size_t N, const size_t K, const size_t Bat
         }
     );
 }
-#endif  // defined(__aarch64__) && defined(__linux__)
+#endif  // defined(MLAS_SBGEMM_SUPPORTED)
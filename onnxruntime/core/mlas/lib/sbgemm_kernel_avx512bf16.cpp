@@ -0,0 +1,515 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    sbgemm_kernel_avx512bf16.cpp
+
+Abstract:
+
+    This module implements the bfloat16 precision GEMM kernels for processors
+    supporting AVX512-BF16 and AMX-BF16.
+
+    Both kernels use the same packed B layout: every group of 16 columns
+    stores one 64 byte row per pair of rows of B, holding the bfloat16 values
+    (B[k][n], B[k+1][n]) of the 16 columns next to each other. A row is the
+    operand expected by VDPBF16PS, and 16 consecutive rows form a B tile for
+    TDPBF16PS. The AMX kernel pads K to a multiple of 32 so that the packed
+    panel is a sequence of whole tiles.
+
+    Matrix A is converted to bfloat16 on the fly, one block of rows and a
+    slice of K at a time.
+
+--*/
+
+#include "sbgemm.h"
+
+#if defined(MLAS_SBGEMM_SUPPORTED) && defined(MLAS_TARGET_AMD64)
+
+#include "amx_common.h"
+
+struct MLAS_SBGEMM_KERNEL_AVX512BF16 {
+    static constexpr bool PackNeeded = true;
+    static constexpr size_t KernelMaxM = 8;  // max # rows the vectorized kernel can process
+    static constexpr size_t PackedK = 2;
+    static constexpr size_t PackedN = MLAS_SGEMM_STRIDEN_THREAD_ALIGN;
+    static constexpr MLAS_SBGEMM_STRIDES Strides{128, 128, 256};  // M:N:K
+};
+
+struct MLAS_SBGEMM_KERNEL_AMX {
+    static constexpr bool PackNeeded = true;
+    static constexpr size_t KernelMaxM = 16;  // rows of a tile
+    static constexpr size_t PackedK = 32;     // bfloat16 values in a tile row
+    static constexpr size_t PackedN = MLAS_SGEMM_STRIDEN_THREAD_ALIGN;
+    static constexpr MLAS_SBGEMM_STRIDES Strides{128, 128, 256};  // M:N:K
+};
+
+//
+// Number of columns in a group of the packed B buffer.
+//
+constexpr size_t MlasSBGemmGroupN = 16;
+
+//
+// Slice of K converted from matrix A at once by the kernels. This is also
+// the slice of K used to pack matrix B.
+//
+constexpr size_t MlasSBGemmSliceK = 256;
+
+static_assert(MLAS_SBGEMM_KERNEL_AVX512BF16::Strides.K == MlasSBGemmSliceK);
+static_assert(MLAS_SBGEMM_KERNEL_AMX::Strides.K == MlasSBGemmSliceK);
+
+bool MLASCALL
+MlasBf16AccelerationSupported()
+{
+    return GetMlasPlatform().SBGemmDispatch != nullptr;
+}
+
+MLAS_FORCEINLINE
+__mmask16
+MlasSBGemmColumnMask(size_t CountN)
+{
+    return CountN >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << CountN) - 1);
+}
+
+MLAS_FORCEINLINE
+__mmask32
+MlasSBGemmPairMask(size_t Count)
+{
+    return Count >= 32 ? __mmask32(0xFFFFFFFF) : __mmask32((1u << Count) - 1);
+}
+
+/*
+    This routine converts fp32 to bf16 and copies elements from the source
+    matrix to the destination packed buffer.
+
+    Two rows of 16 columns are interleaved so that every 32-bit element holds
+    the pair (B[k][n], B[k+1][n]). Columns past CountN and rows past CountK
+    are filled with zeros up to the next multiple of 16 columns and PackedK
+    rows.
+*/
+template <size_t PackedK>
+void
+MlasSBGemmConvertCopyPackBAvx512Bf16(bfloat16_t* D, const float* B, size_t ldb, size_t CountN, size_t CountK)
+{
+    MLAS_DECLSPEC_ALIGN(static const uint16_t InterleaveIndex[32], 64) = {
+        0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23,
+        8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31,
+    };
+
+    const __m512i Interleave = _mm512_load_si512(InterleaveIndex);
+    const size_t PackedCountK = (CountK + PackedK - 1) & ~(PackedK - 1);
+
+    for (size_t n = 0; n < CountN; n += MlasSBGemmGroupN) {
+        const __mmask16 Mask = MlasSBGemmColumnMask(CountN - n);
+        const float* b = B + n;
+
+        for (size_t k = 0; k < PackedCountK; k += 2) {
+            __m512 Row0 = _mm512_setzero_ps();
+            __m512 Row1 = _mm512_setzero_ps();
+            if (k < CountK) {
+                Row0 = _mm512_maskz_loadu_ps(Mask, b + k * ldb);
+            }
+            if (k + 1 < CountK) {
+                Row1 = _mm512_maskz_loadu_ps(Mask, b + (k + 1) * ldb);
+            }
+
+            //
+            // The conversion places Row0 in the lower half and Row1 in the
+            // upper half, the permutation interleaves both halves.
+            //
+            __m512i Pairs = (__m512i)_mm512_cvtne2ps_pbh(Row1, Row0);
+            Pairs = _mm512_permutexvar_epi16(Interleave, Pairs);
+            _mm512_storeu_si512(D, Pairs);
+            D += 2 * MlasSBGemmGroupN;
+        }
+    }
+}
+
+template <typename KernelType>
+void
+MlasSBGemmConvertPackB(bfloat16_t* PackedB, const float* B, size_t ldb, size_t CountN, size_t CountK)
+{
+    const size_t AlignedN = (CountN + KernelType::PackedN - 1) & ~(KernelType::PackedN - 1);
+
+    //
+    // Step through each slice of matrix B along the K dimension.
+    //
+    size_t K_block_size;
+    constexpr MLAS_SBGEMM_STRIDES Strides = KernelType::Strides;
+
+    for (size_t k = 0; k < CountK; k += K_block_size) {
+        K_block_size = std::min(CountK - k, Strides.K);
+
+        MlasSBGemmConvertCopyPackBAvx512Bf16<KernelType::PackedK>(PackedB, B + k * ldb, ldb, CountN, K_block_size);
+        PackedB = PackedB + AlignedN * K_block_size;
+    }
+}
+
+/*
+    This routine converts CountM rows of CountK elements of matrix A to bf16.
+    Every row of the destination holds PackedCountK elements, the elements
+    past CountK are set to zero.
+*/
+MLAS_FORCEINLINE
+void
+MlasSBGemmConvertA(bfloat16_t* D, size_t ldd, const float* A, size_t lda, size_t CountM, size_t CountK, size_t PackedCountK)
+{
+    for (size_t m = 0; m < CountM; m++) {
+        const float* a = A + m * lda;
+        bfloat16_t* d = D + m * ldd;
+
+        for (size_t k = 0; k < PackedCountK; k += 32) {
+            const size_t Remaining = k < CountK ? CountK - k : 0;
+            __m512 Low = _mm512_maskz_loadu_ps(MlasSBGemmColumnMask(Remaining), a + k);
+            __m512 High = _mm512_setzero_ps();
+            if (Remaining > 16) {
+                High = _mm512_maskz_loadu_ps(MlasSBGemmColumnMask(Remaining - 16), a + k + 16);
+            }
+            __m512i Values = (__m512i)_mm512_cvtne2ps_pbh(High, Low);
+            _mm512_mask_storeu_epi16(d + k, MlasSBGemmPairMask(PackedCountK - k), Values);
+        }
+    }
+}
+
+/*
+    This routine stores a block of accumulators to matrix C, adding the bias
+    in zero mode and the previous content of C otherwise.
+*/
+MLAS_FORCEINLINE
+void
+MlasSBGemmStoreOutput(float* C, __m512 Accumulator, __mmask16 Mask, const float* Bias, bool ZeroMode)
+{
+    if (ZeroMode) {
+        if (Bias != nullptr) {
+            Accumulator = _mm512_add_ps(Accumulator, _mm512_maskz_loadu_ps(Mask, Bias));
+        }
+    } else {
+        Accumulator = _mm512_add_ps(Accumulator, _mm512_maskz_loadu_ps(Mask, C));
+    }
+    _mm512_mask_storeu_ps(C, Mask, Accumulator);
+}
+
+/*
+    This routine multiplies RowCount rows of the converted matrix A with up
+    to 16 * GroupCount columns of the packed matrix B.
+
+    A is a sequence of CountPairs pairs of bf16 values per row, lda counts
+    pairs. GroupStride is the number of bf16 values between two column groups
+    of B.
+*/
+template <size_t RowCount, size_t GroupCount>
+MLAS_FORCEINLINE
+void
+MlasSBGemmKernelAvx512Bf16Block(
+    const uint32_t* A,
+    size_t lda,
+    const bfloat16_t* B,
+    size_t GroupStride,
+    size_t CountPairs,
+    size_t CountN,
+    float* C,
+    size_t ldc,
+    const float* Bias,
+    bool ZeroMode
+)
+{
+    __m512 Accumulators[RowCount][GroupCount];
+
+    for (size_t r = 0; r < RowCount; r++) {
+        for (size_t g = 0; g < GroupCount; g++) {
+            Accumulators[r][g] = _mm512_setzero_ps();
+        }
+    }
+
+    for (size_t p = 0; p < CountPairs; p++) {
+        __m512bh BElements[GroupCount];
+        for (size_t g = 0; g < GroupCount; g++) {
+            BElements[g] = (__m512bh)_mm512_loadu_si512(B + g * GroupStride + p * 2 * MlasSBGemmGroupN);
+        }
+        for (size_t r = 0; r < RowCount; r++) {
+            const __m512bh ABroadcast = (__m512bh)_mm512_set1_epi32(int32_t(A[r * lda + p]));
+            for (size_t g = 0; g < GroupCount; g++) {
+                Accumulators[r][g] = _mm512_dpbf16_ps(Accumulators[r][g], ABroadcast, BElements[g]);
+            }
+        }
+    }
+
+    for (size_t g = 0; g < GroupCount; g++) {
+        const size_t StartN = g * MlasSBGemmGroupN;
+        const __mmask16 Mask = MlasSBGemmColumnMask(CountN - StartN);
+        const float* bias = (Bias == nullptr) ? nullptr : Bias + StartN;
+        for (size_t r = 0; r < RowCount; r++) {
+            MlasSBGemmStoreOutput(C + r * ldc + StartN, Accumulators[r][g], Mask, bias, ZeroMode);
+        }
+    }
+}
+
+template <size_t RowCount>
+void
+MlasSBGemmKernelAvx512Bf16Rows(
+    const uint32_t* A,
+    size_t lda,
+    const bfloat16_t* B,
+    size_t GroupStride,
+    size_t CountPairs,
+    size_t CountN,
+    float* C,
+    size_t ldc,
+    const float* Bias,
+    bool ZeroMode
+)
+{
+    while (CountN > MlasSBGemmGroupN) {
+        MlasSBGemmKernelAvx512Bf16Block<RowCount, 2>(A, lda, B, GroupStride, CountPairs, CountN, C, ldc, Bias, ZeroMode);
+
+        const size_t CountHandled = std::min(CountN, 2 * MlasSBGemmGroupN);
+        B += 2 * GroupStride;
+        C += CountHandled;
+        if (Bias != nullptr) {
+            Bias += CountHandled;
+        }
+        CountN -= CountHandled;
+    }
+
+    if (CountN > 0) {
+        MlasSBGemmKernelAvx512Bf16Block<RowCount, 1>(A, lda, B, GroupStride, CountPairs, CountN, C, ldc, Bias, ZeroMode);
+    }
+}
+
+/*
+    This routine computes up to 8 rows of C with the AVX512-BF16 instructions.
+
+    B is laid out as consecutive slices of MlasSBGemmSliceK rows. Inside a
+    slice, every group of 16 columns holds the rows of the slice padded to a
+    multiple of PackedK.
+*/
+template <size_t PackedK>
+void
+MlasSBGemmKernelAvx512Bf16(
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    const float* A,
+    size_t lda,
+    const bfloat16_t* B,
+    float* C,
+    size_t ldc,
+    const float* Bias,
+    bool ZeroMode
+)
+{
+    constexpr size_t KernelMaxM = MLAS_SBGEMM_KERNEL_AVX512BF16::KernelMaxM;
+    MLAS_DECLSPEC_ALIGN(uint32_t PanelA[KernelMaxM * MlasSBGemmSliceK / 2], 64);
+
+    const size_t AlignedN = (CountN + MlasSBGemmGroupN - 1) & ~(MlasSBGemmGroupN - 1);
+
+    for (size_t k = 0; k < CountK; k += MlasSBGemmSliceK) {
+        const size_t SliceK = std::min(CountK - k, MlasSBGemmSliceK);
+        const size_t CountPairs = (SliceK + 1) / 2;
+        const size_t GroupStride = ((SliceK + PackedK - 1) & ~(PackedK - 1)) * MlasSBGemmGroupN;
+        const bfloat16_t* b = B + AlignedN * k;
+        const bool SliceZeroMode = ZeroMode && (k == 0);
+        const float* bias = SliceZeroMode ? Bias : nullptr;
+
+        MlasSBGemmConvertA(reinterpret_cast<bfloat16_t*>(PanelA), 2 * CountPairs, A + k, lda, CountM, SliceK, 2 * CountPairs);
+
+        switch (CountM) {
+            case 1:
+                MlasSBGemmKernelAvx512Bf16Rows<1>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+            case 2:
+                MlasSBGemmKernelAvx512Bf16Rows<2>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+            case 3:
+                MlasSBGemmKernelAvx512Bf16Rows<3>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+            case 4:
+                MlasSBGemmKernelAvx512Bf16Rows<4>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+            case 5:
+                MlasSBGemmKernelAvx512Bf16Rows<5>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+            case 6:
+                MlasSBGemmKernelAvx512Bf16Rows<6>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+            case 7:
+                MlasSBGemmKernelAvx512Bf16Rows<7>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+            default:
+                MlasSBGemmKernelAvx512Bf16Rows<8>(PanelA, CountPairs, b, GroupStride, CountPairs, CountN, C, ldc, bias, SliceZeroMode);
+                break;
+        }
+    }
+}
+
+template <>
+MLAS_FORCEINLINE void
+MlasSBGemmKernel<MLAS_SBGEMM_KERNEL_AVX512BF16>(size_t CountM, size_t CountN, size_t CountK, const float* A, size_t lda, const bfloat16_t* B, float* C, size_t ldc, const float* Bias, const bool ZeroMode)
+{
+    constexpr size_t KernelMaxM = MLAS_SBGEMM_KERNEL_AVX512BF16::KernelMaxM;
+    constexpr size_t PackedK = MLAS_SBGEMM_KERNEL_AVX512BF16::PackedK;
+
+    while (CountM > 0) {
+        const size_t RowsHandled = std::min(CountM, KernelMaxM);
+        MlasSBGemmKernelAvx512Bf16<PackedK>(RowsHandled, CountN, CountK, A, lda, B, C, ldc, Bias, ZeroMode);
+        C += ldc * RowsHandled;
+        A += lda * RowsHandled;
+        CountM -= RowsHandled;
+    }
+}
+
+/*
+    This routine loads the tile configuration used by the AMX kernel: every
+    tile holds 16 rows of 64 bytes. The configuration is the same as the one
+    of the quantized AMX GEMM, so both kernels can run on the same thread
+    without reloading it.
+*/
+MLAS_FORCEINLINE
+void
+MlasSBGemmTileConfigAmx()
+{
+    static thread_local struct tileconfig_t tc = {0};
+    struct tileconfig_t current_tc = {0};
+    tile_storeconfig(&current_tc);
+
+    if (tc.palette_id == 0 || (std::memcmp(&current_tc.colb, &tc.colb, sizeof(uint16_t) * 8) != 0 &&
+                               std::memcmp(&current_tc.rows, &tc.rows, sizeof(uint8_t) * 8) != 0)) {
+        tc.palette_id = 1;
+        for (int t = 0; t < 8; t++) {
+            tc.rows[t] = 16;
+            tc.colb[t] = 64;
+        }
+
+        tile_loadconfig(&tc);
+    }
+}
+
+/*
+    This routine computes 16 rows of C with TDPBF16PS. Every iteration
+    produces a block of 16 rows by 32 columns held in tiles 0 and 1, tile 2
+    holds the rows of A and tiles 3 and 4 hold the columns of B.
+*/
+void
+MlasSBGemmKernelAmx16Rows(
+    size_t CountN,
+    size_t CountK,
+    const float* A,
+    size_t lda,
+    const bfloat16_t* B,
+    float* C,
+    size_t ldc,
+    const float* Bias,
+    bool ZeroMode
+)
+{
+    constexpr size_t TileRows = MLAS_SBGEMM_KERNEL_AMX::KernelMaxM;
+    constexpr size_t TileK = MLAS_SBGEMM_KERNEL_AMX::PackedK;
+    constexpr size_t TileStride = 2 * MlasSBGemmGroupN * sizeof(bfloat16_t);
+
+    MLAS_DECLSPEC_ALIGN(bfloat16_t PanelA[TileRows * MlasSBGemmSliceK], 64);
+    MLAS_DECLSPEC_ALIGN(float Output[2][TileRows * MlasSBGemmGroupN], 64);
+
+    const size_t AlignedN = (CountN + MlasSBGemmGroupN - 1) & ~(MlasSBGemmGroupN - 1);
+
+    for (size_t k = 0; k < CountK; k += MlasSBGemmSliceK) {
+        const size_t SliceK = std::min(CountK - k, MlasSBGemmSliceK);
+        const size_t PackedSliceK = (SliceK + TileK - 1) & ~(TileK - 1);
+        const size_t GroupStride = PackedSliceK * MlasSBGemmGroupN;
+        const bool SliceZeroMode = ZeroMode && (k == 0);
+        const float* bias = SliceZeroMode ? Bias : nullptr;
+
+        MlasSBGemmConvertA(PanelA, PackedSliceK, A + k, lda, TileRows, SliceK, PackedSliceK);
+        MLAS_AMX_TILE_MEMORY_BARRIER();
+
+        const bfloat16_t* b = B + AlignedN * k;
+
+        for (size_t n = 0; n < CountN; n += 2 * MlasSBGemmGroupN) {
+            const bool TwoGroups = (CountN - n) > MlasSBGemmGroupN;
+
+            tile_zero(0);
+            tile_zero(1);
+
+            for (size_t kk = 0; kk < PackedSliceK; kk += TileK) {
+                tile_loadd(2, PanelA + kk, PackedSliceK * sizeof(bfloat16_t));
+                tile_loadd(3, b + kk * MlasSBGemmGroupN, TileStride);
+                tile_dpbf16ps(0, 2, 3);
+                if (TwoGroups) {
+                    tile_loadd(4, b + GroupStride + kk * MlasSBGemmGroupN, TileStride);
+                    tile_dpbf16ps(1, 2, 4);
+                }
+            }
+
+            tile_stored(0, Output[0], MlasSBGemmGroupN * sizeof(float));
+            if (TwoGroups) {
+                tile_stored(1, Output[1], MlasSBGemmGroupN * sizeof(float));
+            }
+            MLAS_AMX_TILE_MEMORY_BARRIER();
+
+            const size_t GroupCount = TwoGroups ? 2 : 1;
+            for (size_t g = 0; g < GroupCount; g++) {
+                const size_t StartN = n + g * MlasSBGemmGroupN;
+                const __mmask16 Mask = MlasSBGemmColumnMask(CountN - StartN);
+                const float* gbias = (bias == nullptr) ? nullptr : bias + StartN;
+                for (size_t r = 0; r < TileRows; r++) {
+                    __m512 Accumulator = _mm512_load_ps(Output[g] + r * MlasSBGemmGroupN);
+                    MlasSBGemmStoreOutput(C + r * ldc + StartN, Accumulator, Mask, gbias, SliceZeroMode);
+                }
+            }
+
+            b += 2 * GroupStride;
+        }
+    }
+}
+
+template <>
+MLAS_FORCEINLINE void
+MlasSBGemmKernel<MLAS_SBGEMM_KERNEL_AMX>(size_t CountM, size_t CountN, size_t CountK, const float* A, size_t lda, const bfloat16_t* B, float* C, size_t ldc, const float* Bias, const bool ZeroMode)
+{
+    constexpr size_t TileRows = MLAS_SBGEMM_KERNEL_AMX::KernelMaxM;
+    constexpr size_t PackedK = MLAS_SBGEMM_KERNEL_AMX::PackedK;
+
+    if (CountM >= TileRows) {
+        MlasSBGemmTileConfigAmx();
+    }
+
+    while (CountM >= TileRows) {
+        MlasSBGemmKernelAmx16Rows(CountN, CountK, A, lda, B, C, ldc, Bias, ZeroMode);
+        C += ldc * TileRows;
+        A += lda * TileRows;
+        CountM -= TileRows;
+    }
+
+    //
+    // The remaining rows do not fill a tile, the AVX512-BF16 kernel handles
+    // them on the same packed panel.
+    //
+    while (CountM > 0) {
+        const size_t RowsHandled = std::min(CountM, MLAS_SBGEMM_KERNEL_AVX512BF16::KernelMaxM);
+        MlasSBGemmKernelAvx512Bf16<PackedK>(RowsHandled, CountN, CountK, A, lda, B, C, ldc, Bias, ZeroMode);
+        C += ldc * RowsHandled;
+        A += lda * RowsHandled;
+        CountM -= RowsHandled;
+    }
+}
+
+const MLAS_SBGEMM_DISPATCH MlasSBGemmDispatchAvx512Bf16 = {
+    MlasSBGemmOperation<MLAS_SBGEMM_KERNEL_AVX512BF16>,
+    MlasSBGemmConvertPackB<MLAS_SBGEMM_KERNEL_AVX512BF16>,
+    MLAS_SBGEMM_KERNEL_AVX512BF16::PackedK,
+    MLAS_SBGEMM_KERNEL_AVX512BF16::PackedN,
+    MLAS_SBGEMM_KERNEL_AVX512BF16::KernelMaxM,
+    0  // kernel does not read beyond the packed buffer
+};
+
+const MLAS_SBGEMM_DISPATCH MlasSBGemmDispatchAmx = {
+    MlasSBGemmOperation<MLAS_SBGEMM_KERNEL_AMX>,
+    MlasSBGemmConvertPackB<MLAS_SBGEMM_KERNEL_AMX>,
+    MLAS_SBGEMM_KERNEL_AMX::PackedK,
+    MLAS_SBGEMM_KERNEL_AMX::PackedN,
+    MLAS_SBGEMM_KERNEL_AMX::KernelMaxM,
+    0  // kernel does not read beyond the packed buffer
+};
+#endif  // defined(MLAS_SBGEMM_SUPPORTED) && defined(MLAS_TARGET_AMD64)
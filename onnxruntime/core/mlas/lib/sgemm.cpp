@@ -26,6 +26,26 @@ Abstract:
 
 #define MLAS_SGEMM_TRANSA_ROWS              12
 
+//
+// Define the maximum number of rows of matrix A for which the small kernel
+// is used. The small kernel reads matrix B directly once for every 4 rows of
+// matrix A, while the packed kernels first copy each panel of matrix B and
+// only amortize the copy when enough rows share the panel. A second pass over
+// matrix B is always slower than packing it, so the small kernel is limited
+// to a single block of rows.
+//
+
+#define MLAS_SGEMM_SMALL_KERNEL_MAX_M       4
+
+//
+// Define the maximum number of elements of matrix B for which the small
+// kernel is used with a full block of rows. The small kernel does not block
+// the K dimension, so once matrix B no longer fits in the outer cache levels
+// the packed kernels win at four rows.
+//
+
+#define MLAS_SGEMM_SMALL_KERNEL_MAX_B_ELEMENTS  (2048 * 2048)
+
 //
 // Define the parameters to execute segments of a SGEMM operation on worker
 // threads.
@@ -1003,6 +1023,88 @@ Return Value:
 
 #endif
 
+void
+MlasSgemmApplyEpilogue(
+    const MLAS_SGEMM_EPILOGUE* Epilogue,
+    float* C,
+    size_t StartM,
+    size_t StartN,
+    size_t CountM,
+    size_t CountN,
+    size_t ldc
+    )
+/*++
+
+Routine Description:
+
+    This routine applies the bias, the activation and the residual addition of
+    the epilogue to a block of the output matrix.
+
+Arguments:
+
+    Epilogue - Supplies the epilogue parameters.
+
+    C - Supplies the address of the block of matrix C.
+
+    StartM - Supplies the row of the block relative to the epilogue origin.
+
+    StartN - Supplies the column of the block relative to the epilogue origin.
+
+    CountM - Supplies the number of rows of the block.
+
+    CountN - Supplies the number of columns of the block.
+
+    ldc - Supplies the first dimension of matrix C.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    const float* Bias = (Epilogue->Bias != nullptr) ? Epilogue->Bias + StartN : nullptr;
+    const float* Residual = (Epilogue->Residual != nullptr) ?
+        Epilogue->Residual + StartM * Epilogue->ldr + StartN : nullptr;
+    const bool HasActivation = (Epilogue->Activation.ActivationKind != MlasIdentityActivation);
+
+    while (CountM-- > 0) {
+
+        if (Bias != nullptr) {
+
+            size_t n = 0;
+
+            for (; n + 4 <= CountN; n += 4) {
+                MlasStoreFloat32x4(C + n, MlasAddFloat32x4(MlasLoadFloat32x4(C + n), MlasLoadFloat32x4(Bias + n)));
+            }
+
+            for (; n < CountN; n++) {
+                C[n] += Bias[n];
+            }
+        }
+
+        if (HasActivation) {
+            MlasActivation(&Epilogue->Activation, C, nullptr, 1, CountN, CountN);
+        }
+
+        if (Residual != nullptr) {
+
+            size_t n = 0;
+
+            for (; n + 4 <= CountN; n += 4) {
+                MlasStoreFloat32x4(C + n, MlasAddFloat32x4(MlasLoadFloat32x4(C + n), MlasLoadFloat32x4(Residual + n)));
+            }
+
+            for (; n < CountN; n++) {
+                C[n] += Residual[n];
+            }
+
+            Residual += Epilogue->ldr;
+        }
+
+        C += ldc;
+    }
+}
+
 MLAS_FORCEINLINE
 float*
 MlasSgemmKernelLoop(
@@ -1015,7 +1117,10 @@ MlasSgemmKernelLoop(
     size_t lda,
     size_t ldc,
     float alpha,
-    bool ZeroMode
+    bool ZeroMode,
+    const MLAS_SGEMM_EPILOGUE* Epilogue,
+    size_t EpilogueStartM,
+    size_t EpilogueStartN
     )
 /*++
 
@@ -1051,6 +1156,16 @@ Arguments:
     ZeroMode - Supplies true if the output matrix must be zero initialized,
         else false if the output matrix is accumulated into.
 
+    Epilogue - Supplies the optional epilogue to apply to the rows produced by
+        each kernel call, nullptr unless this is the last slice along the K
+        dimension.
+
+    EpilogueStartM - Supplies the row of matrix C relative to the epilogue
+        origin.
+
+    EpilogueStartN - Supplies the column of matrix C relative to the epilogue
+        origin.
+
 Return Value:
 
     Returns the next address of matrix C.
@@ -1071,6 +1186,11 @@ Return Value:
         }
 #endif
 
+        if (Epilogue != nullptr) {
+            MlasSgemmApplyEpilogue(Epilogue, C, EpilogueStartM, EpilogueStartN, RowsHandled, CountN, ldc);
+            EpilogueStartM += RowsHandled;
+        }
+
         C += ldc * RowsHandled;
         A += lda * RowsHandled;
         CountM -= RowsHandled;
@@ -1093,7 +1213,8 @@ MlasSgemmOperation(
     size_t ldb,
     float beta,
     float* C,
-    size_t ldc
+    size_t ldc,
+    const MLAS_SGEMM_EPILOGUE* Epilogue
     )
 /*++
 
@@ -1131,6 +1252,9 @@ Arguments:
 
     ldc - Supplies the first dimension of matrix C.
 
+    Epilogue - Supplies the optional epilogue to apply to matrix C, with the
+        bias and residual positioned at the origin of matrix C.
+
 Return Value:
 
     None.
@@ -1147,6 +1271,9 @@ Return Value:
 
     if (K == 0) {
         MlasSgemmMultiplyBeta(C, M, N, ldc, beta);
+        if (Epilogue != nullptr) {
+            MlasSgemmApplyEpilogue(Epilogue, C, 0, 0, M, N, ldc);
+        }
         return;
     }
 
@@ -1171,6 +1298,9 @@ Return Value:
 
         if (SgemmKernelM1Routine != nullptr) {
             SgemmKernelM1Routine(A, B, C, K, N, ldb, beta);
+            if (Epilogue != nullptr) {
+                MlasSgemmApplyEpilogue(Epilogue, C, 0, 0, 1, N, ldc);
+            }
             return;
         }
 
@@ -1178,6 +1308,9 @@ Return Value:
 
         if (TransB == CblasNoTrans) {
             MlasGemvFloatKernel(A, B, C, K, N, ldb, (beta == 0.0f));
+            if (Epilogue != nullptr) {
+                MlasSgemmApplyEpilogue(Epilogue, C, 0, 0, 1, N, ldc);
+            }
             return;
         }
 
@@ -1207,6 +1340,9 @@ Return Value:
 
         if (SgemmKernelM1Routine != nullptr) {
             SgemmKernelM1Routine(B, A, C, K, M, lda, beta);
+            if (Epilogue != nullptr) {
+                MlasSgemmApplyEpilogue(Epilogue, C, 0, 0, M, 1, ldc);
+            }
             return;
         }
 
@@ -1214,6 +1350,29 @@ Return Value:
 
     }
 
+    //
+    // Handle the case of a matrix A with few rows and a matrix B that is not
+    // transposed with the small kernel, which does not pack matrix B.
+    //
+
+#if defined(MLAS_TARGET_AMD64) && !defined(FORCE_GENERIC_ALGORITHMS)
+
+    if (M <= MLAS_SGEMM_SMALL_KERNEL_MAX_M && TransB == CblasNoTrans &&
+        (M < MLAS_SGEMM_SMALL_KERNEL_MAX_M || K * N <= MLAS_SGEMM_SMALL_KERNEL_MAX_B_ELEMENTS)) {
+
+        MLAS_SGEMM_SMALL_KERNEL* SgemmSmallKernel = GetMlasPlatform().SgemmSmallKernel;
+
+        if (SgemmSmallKernel != nullptr) {
+            SgemmSmallKernel(TransA, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+            if (Epilogue != nullptr) {
+                MlasSgemmApplyEpilogue(Epilogue, C, 0, 0, M, N, ldc);
+            }
+            return;
+        }
+    }
+
+#endif
+
     //
     // Compute the strides to step through slices of the input matrices.
     //
@@ -1269,6 +1428,8 @@ Return Value:
 
             CountK = std::min(K - k, StrideK);
 
+            const MLAS_SGEMM_EPILOGUE* SliceEpilogue = (k + CountK == K) ? Epilogue : nullptr;
+
             //
             // Copy or transpose a panel of matrix B to a local packed buffer.
             //
@@ -1287,7 +1448,8 @@ Return Value:
 
             if (TransA == CblasNoTrans) {
 
-                MlasSgemmKernelLoop(A + k, PanelB, c, CountK, M, CountN, lda, ldc, alpha, ZeroMode);
+                MlasSgemmKernelLoop(A + k, PanelB, c, CountK, M, CountN, lda, ldc, alpha, ZeroMode,
+                    SliceEpilogue, 0, n);
 
             } else {
 
@@ -1311,7 +1473,8 @@ Return Value:
                     // Step through the rows of the local buffer.
                     //
 
-                    c = MlasSgemmKernelLoop(PanelA, PanelB, c, CountK, RowsTransposed, CountN, CountK, ldc, alpha, ZeroMode);
+                    c = MlasSgemmKernelLoop(PanelA, PanelB, c, CountK, RowsTransposed, CountN, CountK, ldc, alpha, ZeroMode,
+                        SliceEpilogue, M - RowsRemaining - RowsTransposed, n);
                 }
             }
 
@@ -1334,7 +1497,8 @@ MlasSgemmPackedOperation(
     size_t AlignedN,
     float beta,
     float* C,
-    size_t ldc
+    size_t ldc,
+    const MLAS_SGEMM_EPILOGUE* Epilogue
     )
 /*++
 
@@ -1374,6 +1538,9 @@ Arguments:
 
     ldc - Supplies the first dimension of matrix C.
 
+    Epilogue - Supplies the optional epilogue to apply to matrix C, with the
+        bias and residual positioned at the origin of matrix C.
+
 Return Value:
 
     None.
@@ -1382,6 +1549,19 @@ Return Value:
 {
     float PanelA[MLAS_SGEMM_TRANSA_ROWS * MLAS_SGEMM_PACKED_STRIDEK];
 
+    //
+    // Handle the special case of K equals zero. Apply the beta multiplier to
+    // the output matrix and exit.
+    //
+
+    if (K == 0) {
+        MlasSgemmMultiplyBeta(C, M, RangeCountN, ldc, beta);
+        if (Epilogue != nullptr) {
+            MlasSgemmApplyEpilogue(Epilogue, C, 0, 0, M, RangeCountN, ldc);
+        }
+        return;
+    }
+
     //
     // Step through each slice of matrix B along the N dimension.
     //
@@ -1413,6 +1593,8 @@ Return Value:
 
             CountK = std::min(K - k, size_t(MLAS_SGEMM_PACKED_STRIDEK));
 
+            const MLAS_SGEMM_EPILOGUE* SliceEpilogue = (k + CountK == K) ? Epilogue : nullptr;
+
             //
             // Step through each slice of matrix A along the M dimension.
             //
@@ -1422,7 +1604,8 @@ Return Value:
 
             if (TransA == CblasNoTrans) {
 
-                MlasSgemmKernelLoop(A + k, pb, c, CountK, M, CountN, lda, ldc, alpha, ZeroMode);
+                MlasSgemmKernelLoop(A + k, pb, c, CountK, M, CountN, lda, ldc, alpha, ZeroMode,
+                    SliceEpilogue, 0, n);
 
             } else {
 
@@ -1446,7 +1629,8 @@ Return Value:
                     // Step through the rows of the local buffer.
                     //
 
-                    c = MlasSgemmKernelLoop(PanelA, pb, c, CountK, RowsTransposed, CountN, CountK, ldc, alpha, ZeroMode);
+                    c = MlasSgemmKernelLoop(PanelA, pb, c, CountK, RowsTransposed, CountN, CountK, ldc, alpha, ZeroMode,
+                        SliceEpilogue, M - RowsRemaining - RowsTransposed, n);
                 }
             }
 
@@ -1538,11 +1722,34 @@ Return Value:
     const float* A = DataParams->A + RangeStartM * ((TransA == CblasNoTrans) ? lda : 1);
     float* C = DataParams->C + RangeStartM * ldc + RangeStartN;
 
+    //
+    // Position the bias and the residual of the epilogue at the origin of
+    // this partition of matrix C.
+    //
+
+    MLAS_SGEMM_EPILOGUE PartitionEpilogue;
+    const MLAS_SGEMM_EPILOGUE* Epilogue = nullptr;
+
+    if (DataParams->Epilogue != nullptr) {
+
+        PartitionEpilogue = *DataParams->Epilogue;
+
+        if (PartitionEpilogue.Bias != nullptr) {
+            PartitionEpilogue.Bias += RangeStartN;
+        }
+
+        if (PartitionEpilogue.Residual != nullptr) {
+            PartitionEpilogue.Residual += RangeStartM * PartitionEpilogue.ldr + RangeStartN;
+        }
+
+        Epilogue = &PartitionEpilogue;
+    }
+
     if (DataParams->BIsPacked) {
 
         MlasSgemmPackedOperation(TransA, RangeCountM, RangeStartN, RangeCountN,
             K, DataParams->alpha, A, lda, DataParams->B,
-            BlockedN * MLAS_SGEMM_STRIDEN_THREAD_ALIGN, DataParams->beta, C, ldc);
+            BlockedN * MLAS_SGEMM_STRIDEN_THREAD_ALIGN, DataParams->beta, C, ldc, Epilogue);
 
     } else {
 
@@ -1551,7 +1758,7 @@ Return Value:
         const float* B = (const float*)DataParams->B + RangeStartN * ((TransB == CblasNoTrans) ? 1 : ldb);
 
         MlasSgemmOperation(TransA, TransB, RangeCountM, RangeCountN, K,
-            DataParams->alpha, A, lda, B, ldb, DataParams->beta, C, ldc);
+            DataParams->alpha, A, lda, B, ldb, DataParams->beta, C, ldc, Epilogue);
     }
 }
 #if defined(_MSC_VER) && !defined(__clang__)
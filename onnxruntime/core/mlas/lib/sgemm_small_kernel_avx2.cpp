@@ -0,0 +1,280 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    sgemm_small_kernel_avx2.cpp
+
+Abstract:
+
+    This module implements the single precision matrix/matrix multiply
+    operation (SGEMM) for matrices with few rows on processors supporting
+    AVX2/FMA3.
+
+    Matrix B is read directly from the caller's buffer instead of being
+    copied to a packed buffer, which is the dominant cost of the general
+    kernels when only a few rows of A share each packed panel of B. The
+    kernels are specialized for the number of rows, the number of vectors
+    of columns and the transpose of A, so all of the accumulators stay in
+    registers.
+
+--*/
+
+#include "mlasi.h"
+
+#include <immintrin.h>
+
+#include <utility>
+
+//
+// Maximum number of rows and of 8 element vectors of columns computed by one
+// kernel invocation: 4 x 3 accumulators, 3 vectors of B and a broadcast of A
+// fit in the 16 AVX registers.
+//
+
+constexpr size_t MlasSgemmSmallKernelMaxRowsFma3 = 4;
+constexpr size_t MlasSgemmSmallKernelMaxVectorsFma3 = 3;
+
+MLAS_DECLSPEC_ALIGN(static const int32_t MlasSgemmSmallMaskTableFma3[16], 32) = {
+    -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+template<size_t RowCount, size_t VectorCount, bool TransA, size_t... Rows, size_t... Vectors>
+MLAS_FORCEINLINE
+void
+MlasSgemmSmallKernelBlockFma3(
+    std::index_sequence<Rows...>,
+    std::index_sequence<Vectors...>,
+    size_t K,
+    float alpha,
+    const float* A,
+    size_t lda,
+    const float* B,
+    size_t ldb,
+    float beta,
+    float* C,
+    size_t ldc,
+    __m256i LastMask
+    )
+/*++
+
+Routine Description:
+
+    This routine computes a block of RowCount rows and VectorCount vectors of
+    columns of matrix C. The last vector of columns is accessed through
+    LastMask.
+
+    The index sequences enumerate the rows and the vectors so that the
+    loops over them are expanded at compile time.
+
+--*/
+{
+    __m256 Accumulators[RowCount][VectorCount];
+
+    auto ZeroRow = [&](auto Row) {
+        ((Accumulators[decltype(Row)::value][Vectors] = _mm256_setzero_ps()), ...);
+    };
+    (ZeroRow(std::integral_constant<size_t, Rows>{}), ...);
+
+    auto LoadB = [&](const float* b, size_t Vector) {
+        return (Vector + 1 == VectorCount) ? _mm256_maskload_ps(b + Vector * 8, LastMask)
+                                           : _mm256_loadu_ps(b + Vector * 8);
+    };
+
+    for (size_t k = 0; k < K; k++) {
+
+        const float* b = B + k * ldb;
+        const __m256 BElements[VectorCount] = {LoadB(b, Vectors)...};
+
+        auto MultiplyRow = [&](auto Row) {
+            constexpr size_t r = decltype(Row)::value;
+            const __m256 ABroadcast = _mm256_broadcast_ss(TransA ? A + k * lda + r : A + r * lda + k);
+            ((Accumulators[r][Vectors] = _mm256_fmadd_ps(ABroadcast, BElements[Vectors], Accumulators[r][Vectors])), ...);
+        };
+        (MultiplyRow(std::integral_constant<size_t, Rows>{}), ...);
+    }
+
+    const __m256 AlphaBroadcast = _mm256_set1_ps(alpha);
+    const __m256 BetaBroadcast = _mm256_set1_ps(beta);
+
+    auto StoreVector = [&](float* c, size_t Vector, __m256 Accumulator) {
+        const bool IsLast = (Vector + 1 == VectorCount);
+        __m256 Result = _mm256_mul_ps(Accumulator, AlphaBroadcast);
+        if (beta != 0.0f) {
+            const __m256 CElements = IsLast ? _mm256_maskload_ps(c + Vector * 8, LastMask) : _mm256_loadu_ps(c + Vector * 8);
+            Result = _mm256_fmadd_ps(CElements, BetaBroadcast, Result);
+        }
+        if (IsLast) {
+            _mm256_maskstore_ps(c + Vector * 8, LastMask, Result);
+        } else {
+            _mm256_storeu_ps(c + Vector * 8, Result);
+        }
+    };
+
+    auto StoreRow = [&](auto Row) {
+        constexpr size_t r = decltype(Row)::value;
+        (StoreVector(C + r * ldc, Vectors, Accumulators[r][Vectors]), ...);
+    };
+    (StoreRow(std::integral_constant<size_t, Rows>{}), ...);
+}
+
+template<size_t RowCount, bool TransA>
+void
+MlasSgemmSmallKernelRowsFma3(
+    size_t N,
+    size_t K,
+    float alpha,
+    const float* A,
+    size_t lda,
+    const float* B,
+    size_t ldb,
+    float beta,
+    float* C,
+    size_t ldc
+    )
+/*++
+
+Routine Description:
+
+    This routine computes RowCount rows of matrix C, 24 columns at a time.
+
+--*/
+{
+    constexpr size_t ColumnsPerBlock = MlasSgemmSmallKernelMaxVectorsFma3 * 8;
+    constexpr auto RowSequence = std::make_index_sequence<RowCount>{};
+
+    const __m256i FullMask = _mm256_load_si256(reinterpret_cast<const __m256i*>(&MlasSgemmSmallMaskTableFma3[0]));
+
+    while (N >= ColumnsPerBlock) {
+        MlasSgemmSmallKernelBlockFma3<RowCount, 3, TransA>(RowSequence, std::make_index_sequence<3>{},
+            K, alpha, A, lda, B, ldb, beta, C, ldc, FullMask);
+        B += ColumnsPerBlock;
+        C += ColumnsPerBlock;
+        N -= ColumnsPerBlock;
+    }
+
+    if (N == 0) {
+        return;
+    }
+
+    const size_t LastCount = ((N - 1) % 8) + 1;
+    const __m256i LastMask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&MlasSgemmSmallMaskTableFma3[8 - LastCount]));
+
+    if (N > 16) {
+        MlasSgemmSmallKernelBlockFma3<RowCount, 3, TransA>(RowSequence, std::make_index_sequence<3>{},
+            K, alpha, A, lda, B, ldb, beta, C, ldc, LastMask);
+    } else if (N > 8) {
+        MlasSgemmSmallKernelBlockFma3<RowCount, 2, TransA>(RowSequence, std::make_index_sequence<2>{},
+            K, alpha, A, lda, B, ldb, beta, C, ldc, LastMask);
+    } else {
+        MlasSgemmSmallKernelBlockFma3<RowCount, 1, TransA>(RowSequence, std::make_index_sequence<1>{},
+            K, alpha, A, lda, B, ldb, beta, C, ldc, LastMask);
+    }
+}
+
+template<bool TransA>
+void
+MlasSgemmSmallKernelTransAFma3(
+    size_t M,
+    size_t N,
+    size_t K,
+    float alpha,
+    const float* A,
+    size_t lda,
+    const float* B,
+    size_t ldb,
+    float beta,
+    float* C,
+    size_t ldc
+    )
+{
+    while (M > 0) {
+
+        const size_t RowCount = std::min(M, MlasSgemmSmallKernelMaxRowsFma3);
+
+        switch (RowCount) {
+            case 1:
+                MlasSgemmSmallKernelRowsFma3<1, TransA>(N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+                break;
+            case 2:
+                MlasSgemmSmallKernelRowsFma3<2, TransA>(N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+                break;
+            case 3:
+                MlasSgemmSmallKernelRowsFma3<3, TransA>(N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+                break;
+            default:
+                MlasSgemmSmallKernelRowsFma3<4, TransA>(N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+                break;
+        }
+
+        A += TransA ? RowCount : RowCount * lda;
+        C += RowCount * ldc;
+        M -= RowCount;
+    }
+}
+
+void
+MLASCALL
+MlasSgemmSmallKernelFma3(
+    CBLAS_TRANSPOSE TransA,
+    size_t M,
+    size_t N,
+    size_t K,
+    float alpha,
+    const float* A,
+    size_t lda,
+    const float* B,
+    size_t ldb,
+    float beta,
+    float* C,
+    size_t ldc
+    )
+/*++
+
+Routine Description:
+
+    This routine implements the single precision matrix/matrix multiply
+    operation C = alpha * op(A) * B + beta * C without packing matrix B.
+
+Arguments:
+
+    TransA - Supplies the transpose operation for matrix A.
+
+    M - Supplies the number of rows of matrix A and matrix C.
+
+    N - Supplies the number of columns of matrix B and matrix C.
+
+    K - Supplies the number of columns of matrix A and the number of rows of
+        matrix B.
+
+    alpha - Supplies the scalar alpha multiplier (see SGEMM definition).
+
+    A - Supplies the address of matrix A.
+
+    lda - Supplies the first dimension of matrix A.
+
+    B - Supplies the address of matrix B, which is not transposed.
+
+    ldb - Supplies the first dimension of matrix B.
+
+    beta - Supplies the scalar beta multiplier (see SGEMM definition).
+
+    C - Supplies the address of matrix C.
+
+    ldc - Supplies the first dimension of matrix C.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    if (TransA == CblasNoTrans) {
+        MlasSgemmSmallKernelTransAFma3<false>(M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    } else {
+        MlasSgemmSmallKernelTransAFma3<true>(M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+}
@@ -0,0 +1,132 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    softmax_kernel_avx512f.cpp
+
+Abstract:
+
+    This module implements the kernel to transform the input rows of a fused
+    softmax operation on processors supporting AVX512F. The remaining passes
+    of the softmax are shared with the unfused operation (see
+    SoftmaxKernelAvx512F.S).
+
+--*/
+
+#include "mlasi.h"
+
+#include <immintrin.h>
+
+template<bool HasBias, bool HasMask>
+MLAS_FORCEINLINE
+float
+MlasComputeSoftmaxInputF32KernelAvx512FImpl(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Scale,
+    const float* Bias,
+    const float* Mask
+    )
+{
+    const __m512 ScaleVector = _mm512_set1_ps(Scale);
+
+    auto TransformVector = [&](size_t Offset, __mmask16 Mask16) {
+        __m512 Vector = _mm512_mul_ps(ScaleVector, _mm512_maskz_loadu_ps(Mask16, Input + Offset));
+        if (HasBias) {
+            Vector = _mm512_add_ps(Vector, _mm512_maskz_loadu_ps(Mask16, Bias + Offset));
+        }
+        if (HasMask) {
+            Vector = _mm512_add_ps(Vector, _mm512_maskz_loadu_ps(Mask16, Mask + Offset));
+        }
+        _mm512_mask_storeu_ps(Output + Offset, Mask16, Vector);
+        return Vector;
+    };
+
+    __m512 MaximumVector0 = _mm512_set1_ps(std::numeric_limits<float>::lowest());
+    __m512 MaximumVector1 = MaximumVector0;
+    __m512 MaximumVector2 = MaximumVector0;
+    __m512 MaximumVector3 = MaximumVector0;
+
+    size_t n = 0;
+
+    for (; n + 64 <= N; n += 64) {
+        MaximumVector0 = _mm512_max_ps(MaximumVector0, TransformVector(n, 0xFFFF));
+        MaximumVector1 = _mm512_max_ps(MaximumVector1, TransformVector(n + 16, 0xFFFF));
+        MaximumVector2 = _mm512_max_ps(MaximumVector2, TransformVector(n + 32, 0xFFFF));
+        MaximumVector3 = _mm512_max_ps(MaximumVector3, TransformVector(n + 48, 0xFFFF));
+    }
+
+    for (; n + 16 <= N; n += 16) {
+        MaximumVector0 = _mm512_max_ps(MaximumVector0, TransformVector(n, 0xFFFF));
+    }
+
+    if (n < N) {
+        const __mmask16 TailMask = __mmask16((1u << (N - n)) - 1);
+        MaximumVector1 = _mm512_mask_max_ps(MaximumVector1, TailMask, MaximumVector1, TransformVector(n, TailMask));
+    }
+
+    MaximumVector0 = _mm512_max_ps(MaximumVector0, MaximumVector1);
+    MaximumVector2 = _mm512_max_ps(MaximumVector2, MaximumVector3);
+    MaximumVector0 = _mm512_max_ps(MaximumVector0, MaximumVector2);
+
+    return _mm512_reduce_max_ps(MaximumVector0);
+}
+
+float
+MLASCALL
+MlasComputeSoftmaxInputF32KernelAvx512F(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Scale,
+    const float* Bias,
+    const float* Mask
+    )
+/*++
+
+Routine Description:
+
+    This routine transforms a row of the input of a fused softmax operation:
+
+        Output = Scale * Input + Bias + Mask
+
+    and finds the maximum value of the transformed row.
+
+    N.B. The input and output buffers may be the same buffer.
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+    Scale - Supplies the scale applied to the input.
+
+    Bias - Optionally supplies an additive bias.
+
+    Mask - Optionally supplies an additive mask.
+
+Return Value:
+
+    Returns the maximum value of the transformed row.
+
+--*/
+{
+    if (Bias != nullptr) {
+        if (Mask != nullptr) {
+            return MlasComputeSoftmaxInputF32KernelAvx512FImpl<true, true>(Input, Output, N, Scale, Bias, Mask);
+        }
+        return MlasComputeSoftmaxInputF32KernelAvx512FImpl<true, false>(Input, Output, N, Scale, Bias, Mask);
+    }
+    if (Mask != nullptr) {
+        return MlasComputeSoftmaxInputF32KernelAvx512FImpl<false, true>(Input, Output, N, Scale, Bias, Mask);
+    }
+    return MlasComputeSoftmaxInputF32KernelAvx512FImpl<false, false>(Input, Output, N, Scale, Bias, Mask);
+}
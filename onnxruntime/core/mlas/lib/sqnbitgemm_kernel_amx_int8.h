@@ -0,0 +1,349 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    sqnbitgemm_kernel_amx_int8.h
+
+Abstract:
+
+    This module implements the AMX-INT8 kernel for the 4-bit blockwise
+    quantized matrix multiplication with int8 activations (CompInt8).
+
+    The kernel consumes matrix B in the layout packed for the AVX512-VNNI
+    kernels, so the same packed weights serve both the single row and the
+    prefill cases. Every group of 16 columns of B is unpacked into an
+    unsigned 8-bit panel in the VNNI layout consumed by TDPBSUD. Each block
+    of K produces a tile of int32 dot products that is scaled by the block
+    scales of A and B and accumulated in fp32.
+
+--*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "qnbitgemm.h"
+#include "amx_common.h"
+#include "sqnbitgemm_kernel_avx_common.h"
+
+//
+// Rows of a tile and columns of B unpacked into a panel.
+//
+constexpr size_t MlasQ4Int8AmxTileRows = 16;
+constexpr size_t MlasQ4Int8AmxGroupN = 16;
+
+//
+// Sub-block length used to pack B for the CompInt8 AVX512-VNNI kernels.
+//
+constexpr size_t MlasQ4Int8AmxSubBlkLen = 128;
+
+//
+// Minimum number of rows for the AMX kernel. Unpacking B to a panel is not
+// amortized over fewer rows, which stay on the AVX512-VNNI kernels.
+//
+constexpr size_t MlasQ4Int8AmxMinimumM = 32;
+
+/*
+    This routine loads the tile configuration used by the AMX kernel. Tile 0
+    accumulates the 16x16 int32 results, tile 1 holds 16 rows of A and tile 2
+    holds the panel rows of B, both spanning TileK values of K. Every other
+    tile keeps the 16 rows of 64 bytes used by the other AMX kernels.
+*/
+MLAS_FORCEINLINE
+void
+MlasQ4Int8GemmTileConfigAmx(
+    size_t TileK
+)
+{
+    struct tileconfig_t tc = {0};
+    tc.palette_id = 1;
+    for (int t = 0; t < 8; t++) {
+        tc.rows[t] = 16;
+        tc.colb[t] = 64;
+    }
+    tc.colb[1] = static_cast<uint16_t>(TileK);
+    tc.rows[2] = static_cast<uint8_t>(TileK / 4);
+
+    struct tileconfig_t current_tc = {0};
+    tile_storeconfig(&current_tc);
+
+    if (std::memcmp(&current_tc, &tc, sizeof(tc)) != 0) {
+        tile_loadconfig(&tc);
+    }
+}
+
+/*
+    This routine unpacks ByteCount bytes of packed 4-bit values, where byte j
+    holds value j in its low nibble and value j + ByteCount in its high
+    nibble, to 2 * ByteCount unsigned bytes.
+*/
+MLAS_FORCEINLINE
+void
+MlasQ4Int8AmxUnpackNibbles(
+    const std::byte* Src,
+    size_t ByteCount,
+    uint8_t* Dst
+)
+{
+    const __mmask64 Mask = (ByteCount == 64) ? ~__mmask64{0} : ((__mmask64{1} << ByteCount) - 1);
+    const __m512i LowMask = _mm512_set1_epi8(0x0F);
+
+    const __m512i Bytes = _mm512_maskz_loadu_epi8(Mask, Src);
+    _mm512_mask_storeu_epi8(Dst, Mask, _mm512_and_si512(Bytes, LowMask));
+    _mm512_mask_storeu_epi8(Dst + ByteCount, Mask, _mm512_and_si512(_mm512_srli_epi16(Bytes, 4), LowMask));
+}
+
+/*
+    This routine unpacks column n of B from the layout produced by
+    PackQuantB to BlockCountK * BlkLen unsigned bytes in K order.
+*/
+static void
+MlasQ4Int8AmxUnpackColumnB(
+    size_t BlkLen,
+    const std::byte* QuantBData,
+    size_t CountN,
+    size_t n,
+    size_t BlockCountK,
+    uint8_t* Column
+)
+{
+    constexpr size_t SubBlkLen = MlasQ4Int8AmxSubBlkLen;
+    const size_t SubBlkCountK = MlasDivRoundup(BlockCountK * BlkLen, SubBlkLen);
+    const bool PartialSubBlk = SubBlkCountK * SubBlkLen > BlockCountK * BlkLen;
+    const int BlksPerSubBlk = (BlkLen < SubBlkLen) ? static_cast<int>(SubBlkLen / BlkLen) : 1;
+
+    for (size_t k_subblk = 0; k_subblk < SubBlkCountK; k_subblk++) {
+        uint8_t* dst = Column + k_subblk * SubBlkLen;
+
+        if (PartialSubBlk && k_subblk == SubBlkCountK - 1) {
+            //
+            // The last sub-block extends past K and is packed per block.
+            //
+            for (size_t k_blk = k_subblk * BlksPerSubBlk; k_blk < BlockCountK; k_blk++) {
+                const size_t Offset = (BlkLen == 16)
+                                          ? n * BlockCountK + k_blk
+                                          : GetContinueLayoutOffsetBlkInSubBlk(CountN, n, BlockCountK, k_blk, BlksPerSubBlk);
+                MlasQ4Int8AmxUnpackNibbles(QuantBData + Offset * BlkLen / 2, BlkLen / 2, dst);
+                dst += BlkLen;
+            }
+        } else {
+            size_t Offset;
+            if (BlkLen == 16) {
+                Offset = n * BlockCountK * BlkLen / 2 + k_subblk * SubBlkLen / 2;
+            } else if (BlkLen >= SubBlkLen) {
+                Offset = GetContinueLayoutOffsetSubBlk(CountN, n, SubBlkCountK, k_subblk) * SubBlkLen / 2;
+            } else {
+                const size_t k_blk = k_subblk * BlksPerSubBlk;
+                Offset = GetContinueLayoutOffsetBlkInSubBlk(CountN, n, BlockCountK, k_blk, BlksPerSubBlk) * BlkLen / 2;
+            }
+            MlasQ4Int8AmxUnpackNibbles(QuantBData + Offset, SubBlkLen / 2, dst);
+        }
+    }
+}
+
+/*
+    This routine returns the offset of the scale of block k_blk of column n
+    in the layout produced by ComputePackBlkSum.
+*/
+MLAS_FORCEINLINE
+size_t
+MlasQ4Int8AmxScaleOffsetB(
+    size_t BlkLen,
+    size_t CountN,
+    size_t n,
+    size_t BlockCountK,
+    size_t k_blk
+)
+{
+    if (BlkLen == 16) {
+        return n * BlockCountK + k_blk;
+    } else if (BlkLen >= MlasQ4Int8AmxSubBlkLen) {
+        return GetContinueLayoutOffsetSubBlk(CountN, n, BlockCountK, k_blk);
+    } else {
+        const int BlksPerSubBlk = static_cast<int>(MlasQ4Int8AmxSubBlkLen / BlkLen);
+        return GetContinueLayoutOffsetBlkInSubBlk(CountN, n, BlockCountK, k_blk, BlksPerSubBlk);
+    }
+}
+
+/*
+    This routine transposes a 16x16 matrix of 32-bit elements held in 16
+    vectors.
+*/
+MLAS_FORCEINLINE
+void
+MlasQ4Int8AmxTranspose16x16(
+    __m512i v[16]
+)
+{
+    __m512i t[16];
+
+    for (size_t i = 0; i < 16; i += 2) {
+        t[i] = _mm512_unpacklo_epi32(v[i], v[i + 1]);
+        t[i + 1] = _mm512_unpackhi_epi32(v[i], v[i + 1]);
+    }
+
+    for (size_t i = 0; i < 16; i += 4) {
+        v[i] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+        v[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+        v[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+        v[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+
+    for (size_t j = 0; j < 4; j++) {
+        const __m512i u0 = _mm512_shuffle_i32x4(v[j], v[j + 4], 0x44);
+        const __m512i u1 = _mm512_shuffle_i32x4(v[j], v[j + 4], 0xEE);
+        const __m512i w0 = _mm512_shuffle_i32x4(v[j + 8], v[j + 12], 0x44);
+        const __m512i w1 = _mm512_shuffle_i32x4(v[j + 8], v[j + 12], 0xEE);
+        t[j] = _mm512_shuffle_i32x4(u0, w0, 0x88);
+        t[j + 4] = _mm512_shuffle_i32x4(u0, w0, 0xDD);
+        t[j + 8] = _mm512_shuffle_i32x4(u1, w1, 0x88);
+        t[j + 12] = _mm512_shuffle_i32x4(u1, w1, 0xDD);
+    }
+
+    for (size_t i = 0; i < 16; i++) {
+        v[i] = t[i];
+    }
+}
+
+/*
+    This routine unpacks a group of up to 16 columns of B starting at column
+    StartN to a panel of PaddedK / 4 rows of 64 bytes, where every row holds
+    4 consecutive values of K for each of the 16 columns. The scales of the
+    group are gathered to BlockCountK rows of 16 values. Columns past CountN
+    are zero filled.
+*/
+static void
+MlasQ4Int8AmxPackGroupB(
+    size_t BlkLen,
+    const std::byte* QuantBData,
+    const float* QuantBScale,
+    size_t CountN,
+    size_t StartN,
+    size_t BlockCountK,
+    size_t PaddedK,
+    uint8_t* Column,
+    uint8_t* PanelB,
+    float* PanelScale
+)
+{
+    const size_t CountK = BlockCountK * BlkLen;
+    const size_t GroupN = std::min(CountN - StartN, MlasQ4Int8AmxGroupN);
+
+    for (size_t c = 0; c < MlasQ4Int8AmxGroupN; c++) {
+        uint8_t* column = Column + c * PaddedK;
+
+        if (c < GroupN) {
+            const size_t n = StartN + c;
+            MlasQ4Int8AmxUnpackColumnB(BlkLen, QuantBData, CountN, n, BlockCountK, column);
+            std::fill(column + CountK, column + PaddedK, uint8_t{0});
+            for (size_t k_blk = 0; k_blk < BlockCountK; k_blk++) {
+                PanelScale[k_blk * MlasQ4Int8AmxGroupN + c] =
+                    QuantBScale[MlasQ4Int8AmxScaleOffsetB(BlkLen, CountN, n, BlockCountK, k_blk)];
+            }
+        } else {
+            std::fill(column, column + PaddedK, uint8_t{0});
+            for (size_t k_blk = 0; k_blk < BlockCountK; k_blk++) {
+                PanelScale[k_blk * MlasQ4Int8AmxGroupN + c] = 0.0f;
+            }
+        }
+    }
+
+    for (size_t k = 0; k < PaddedK; k += 64) {
+        __m512i v[16];
+        for (size_t c = 0; c < MlasQ4Int8AmxGroupN; c++) {
+            v[c] = _mm512_loadu_si512(Column + c * PaddedK + k);
+        }
+        MlasQ4Int8AmxTranspose16x16(v);
+        for (size_t i = 0; i < 16; i++) {
+            _mm512_storeu_si512(PanelB + (k / 4 + i) * 64, v[i]);
+        }
+    }
+}
+
+/*
+    This routine computes CountM rows of C, a multiple of 16, with TDPBSUD:
+
+        C = Sum_k_blk(ScaleA * ScaleB * Dot(QuantA, QuantB)) + Bias
+
+    The zero points of B are not applied, the caller accumulates the block
+    sums of A and B to C afterwards.
+*/
+static void
+MlasQ4Int8GemmKernelAmx(
+    size_t BlkLen,
+    const std::byte* QuantA,
+    const float* QuantAScale,
+    const std::byte* QuantBData,
+    const float* QuantBScale,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t BlockCountK,
+    const float* Bias,
+    size_t ldc
+)
+{
+    constexpr size_t TileRows = MlasQ4Int8AmxTileRows;
+    constexpr size_t GroupN = MlasQ4Int8AmxGroupN;
+
+    const size_t TileK = std::min(BlkLen, size_t{64});
+    const size_t lda = BlockCountK * BlkLen;
+    const size_t PaddedK = (lda + 63) & ~size_t{63};
+
+    MlasThreadedBufAlloc(2 * GroupN * PaddedK + BlockCountK * GroupN * sizeof(float));
+    uint8_t* Column = ThreadedBufHolder.get();
+    uint8_t* PanelB = Column + GroupN * PaddedK;
+    float* PanelScale = reinterpret_cast<float*>(PanelB + GroupN * PaddedK);
+
+    MLAS_DECLSPEC_ALIGN(int32_t Output[TileRows * GroupN], 64);
+
+    MlasQ4Int8GemmTileConfigAmx(TileK);
+
+    for (size_t n = 0; n < CountN; n += GroupN) {
+        MlasQ4Int8AmxPackGroupB(
+            BlkLen, QuantBData, QuantBScale, CountN, n, BlockCountK, PaddedK, Column, PanelB, PanelScale
+        );
+        MLAS_AMX_TILE_MEMORY_BARRIER();
+
+        const size_t CountGroupN = std::min(CountN - n, GroupN);
+        const __mmask16 Mask = static_cast<__mmask16>((1u << CountGroupN) - 1);
+        const __m512 BiasVector = (Bias == nullptr) ? _mm512_setzero_ps() : _mm512_maskz_loadu_ps(Mask, Bias + n);
+
+        for (size_t m = 0; m < CountM; m += TileRows) {
+            const std::byte* a = QuantA + m * lda;
+            const float* a_scale = QuantAScale + m * BlockCountK;
+
+            __m512 acc[TileRows];
+            UnrolledLoop<TileRows>([&](size_t r) { acc[r] = _mm512_setzero_ps(); });
+
+            for (size_t k_blk = 0; k_blk < BlockCountK; k_blk++) {
+                const size_t k = k_blk * BlkLen;
+
+                tile_zero(0);
+                for (size_t kk = 0; kk < BlkLen; kk += TileK) {
+                    tile_loadd(1, a + k + kk, lda);
+                    tile_loadd(2, PanelB + (k + kk) * GroupN, 64);
+                    tile_dpbsud(0, 1, 2);
+                }
+                tile_stored(0, Output, GroupN * sizeof(int32_t));
+                MLAS_AMX_TILE_MEMORY_BARRIER();
+
+                const __m512 scale_b = _mm512_loadu_ps(PanelScale + k_blk * GroupN);
+                UnrolledLoop<TileRows>([&](size_t r) {
+                    const __m512 scale = _mm512_mul_ps(_mm512_set1_ps(a_scale[r * BlockCountK + k_blk]), scale_b);
+                    const __m512 dot = _mm512_cvtepi32_ps(_mm512_load_si512(Output + r * GroupN));
+                    acc[r] = _mm512_fmadd_ps(dot, scale, acc[r]);
+                });
+            }
+
+            UnrolledLoop<TileRows>([&](size_t r) {
+                _mm512_mask_storeu_ps(C + (m + r) * ldc + n, Mask, _mm512_add_ps(acc[r], BiasVector));
+            });
+        }
+    }
+}
@@ -27,6 +27,9 @@ Abstract:
 #include "sqnbitgemm_kernel_avx512_int8_blklen32.h"
 #include "sqnbitgemm_kernel_avx512_int8_blklen64.h"
 #include "sqnbitgemm_kernel_avx512_int8_blklen128.h"
+#if !defined(__APPLE__)
+#include "sqnbitgemm_kernel_amx_int8.h"
+#endif
 
 MLAS_FORCEINLINE void
 SQ4BitGemmM1Kernel_CompFp32(
@@ -206,6 +209,38 @@ SQ4BitGemmM1Kernel_CompInt8_avx512vnni(
     }
 }
 
+//
+// Accumulates the products of the block sums of A (scale * sum of a block)
+// and of B (-scale * zero point) to C, which applies the zero points of B.
+//
+MLAS_FORCEINLINE
+void
+SQ4BitGemmAccumulateBlkSum(
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t BlockCountK,
+    size_t ldc,
+    const float* ABlockSum,
+    const float* QuantBBlkSum
+)
+{
+    float* c_blk = C;
+    const float* b_blk_sum = QuantBBlkSum;
+
+    size_t RowsRemaining = CountM;
+    const float* a_blksum_row = ABlockSum;
+    while (RowsRemaining > 0) {
+        auto RowsHandled = GetMlasPlatform().GemmFloatKernel(
+            a_blksum_row, b_blk_sum, c_blk, BlockCountK, RowsRemaining, CountN, BlockCountK, ldc, 1.f, false
+        );
+
+        c_blk += ldc * RowsHandled;
+        a_blksum_row += BlockCountK * RowsHandled;
+        RowsRemaining -= RowsHandled;
+    }
+}
+
 MLAS_FORCEINLINE
 size_t
 SQ4BitGemmKernel_BlkSum_CompInt8_avx512vnni(
@@ -282,23 +317,71 @@ SQ4BitGemmKernel_BlkSum_CompInt8_avx512vnni(
         );
     }
 
-    float* c_blk = C;
-    const float* b_blk_sum = QuantBBlkSum;
+    SQ4BitGemmAccumulateBlkSum(C, CountM, CountN, BlockCountK, ldc, ABlockSum, QuantBBlkSum);
+    return CountM;
+}
 
-    size_t RowsRemaining = CountM;
-    const float* a_blksum_row = ABlockSum;
-    while (RowsRemaining > 0) {
-        auto RowsHandled = GetMlasPlatform().GemmFloatKernel(
-            a_blksum_row, b_blk_sum, c_blk, BlockCountK, RowsRemaining, CountN, BlockCountK, ldc, 1.f, false
+#if !defined(__APPLE__)
+
+//
+// Computes the rows that fill AMX tiles with the AMX-INT8 kernel once there
+// are enough rows to amortize unpacking B. The remaining rows go to the
+// AVX512-VNNI kernels.
+//
+static size_t
+SQ4BitGemmKernel_BlkSum_CompInt8_avx512vnniAmx(
+    const size_t BlkLen,
+    const std::byte* QuantA,
+    const float* QuantAScale,
+    const std::byte* QuantBData,
+    const float* QuantBScale,
+    const std::byte* QuantBZeroPoint,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    size_t BlockCountK,
+    const float* Bias,
+    size_t ldc,
+    const float* ABlockSum,
+    const float* QuantBBlkSum
+)
+{
+    const size_t CountMAmx = (CountM >= MlasQ4Int8AmxMinimumM) ? (CountM & ~(MlasQ4Int8AmxTileRows - 1)) : 0;
+
+    if (CountMAmx > 0) {
+        MlasQ4Int8GemmKernelAmx(
+            BlkLen, QuantA, QuantAScale, QuantBData, QuantBScale, C, CountMAmx, CountN, BlockCountK, Bias, ldc
         );
+        SQ4BitGemmAccumulateBlkSum(C, CountMAmx, CountN, BlockCountK, ldc, ABlockSum, QuantBBlkSum);
+    }
 
-        c_blk += ldc * RowsHandled;
-        a_blksum_row += BlockCountK * RowsHandled;
-        RowsRemaining -= RowsHandled;
+    if (CountM > CountMAmx) {
+        const size_t lda = BlockCountK * BlkLen;
+        SQ4BitGemmKernel_BlkSum_CompInt8_avx512vnni(
+            BlkLen,
+            QuantA + CountMAmx * lda,
+            QuantAScale + CountMAmx * BlockCountK,
+            QuantBData,
+            QuantBScale,
+            QuantBZeroPoint,
+            C + CountMAmx * ldc,
+            CountM - CountMAmx,
+            CountN,
+            CountK,
+            BlockCountK,
+            Bias,
+            ldc,
+            ABlockSum + CountMAmx * BlockCountK,
+            QuantBBlkSum
+        );
     }
+
     return CountM;
 }
 
+#endif  // !defined(__APPLE__)
+
 void MLASCALL
 QuantizeARow_CompInt8_avx512(
     size_t BlkLen,
@@ -355,3 +438,17 @@ const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512vnni = []() {
 
     return d;
 }();
+
+#if !defined(__APPLE__)
+//
+// Kernel dispatch structure definition for processors that also support
+// AMX-INT8. The packed layout of B is shared with the AVX512-VNNI kernels.
+//
+const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512vnniAmx = []() {
+    MLAS_QNBIT_GEMM_DISPATCH d = MlasSQNBitGemmDispatchAvx512vnni;
+
+    d.SQ4BitGemmKernel_BlkSum_CompInt8 = SQ4BitGemmKernel_BlkSum_CompInt8_avx512vnniAmx;
+
+    return d;
+}();
+#endif  // !defined(__APPLE__)
@@ -0,0 +1,382 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    transcendental.cpp
+
+Abstract:
+
+    This module implements the vectorized transcendental routines for the
+    elementwise activations: Gelu (erf form), Silu, Softplus, Elu, Selu and
+    the natural logarithm, in single and half precision.
+
+    The kernels in this module target the base instruction set through
+    MLAS_FLOAT32X4 (SSE2, NEON, ...). The AVX2 and AVX512F kernels are built
+    from the same templates in separate modules.
+
+--*/
+
+#include "transcendental.h"
+
+struct MLAS_TRANSCENDENTAL_TRAITS_FLOAT32X4 {
+    using Float = MLAS_FLOAT32X4;
+    using Int = MLAS_INT32X4;
+    using Mask = MLAS_FLOAT32X4;
+
+    static constexpr size_t Count = 4;
+
+    static MLAS_FORCEINLINE Float Broadcast(float Value) { return MlasBroadcastFloat32x4(Value); }
+    static MLAS_FORCEINLINE Int BroadcastInt(int32_t Value) { return MlasBroadcastInt32x4(Value); }
+    static MLAS_FORCEINLINE Float Load(const float* Buffer) { return MlasLoadFloat32x4(Buffer); }
+    static MLAS_FORCEINLINE void Store(float* Buffer, Float Vector) { MlasStoreFloat32x4(Buffer, Vector); }
+
+    static MLAS_FORCEINLINE Float Add(Float a, Float b) { return MlasAddFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float Subtract(Float a, Float b) { return MlasSubtractFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float Multiply(Float a, Float b) { return MlasMultiplyFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float Divide(Float a, Float b) { return MlasDivideFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float MultiplyAdd(Float a, Float b, Float c) { return MlasMultiplyAddFloat32x4(a, b, c); }
+    static MLAS_FORCEINLINE Float Maximum(Float a, Float b) { return MlasMaximumFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float Minimum(Float a, Float b) { return MlasMinimumFloat32x4(a, b); }
+
+    static MLAS_FORCEINLINE Float And(Float a, Float b) { return MlasAndFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float Or(Float a, Float b) { return MlasOrFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float AndNot(Float a, Float b) { return MlasAndNotFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float Xor(Float a, Float b) { return MlasXorFloat32x4(a, b); }
+
+    static MLAS_FORCEINLINE Mask GreaterThan(Float a, Float b) { return MlasGreaterThanFloat32x4(a, b); }
+    static MLAS_FORCEINLINE Float Select(Mask m, Float a, Float b) { return MlasBlendFloat32x4(b, a, m); }
+
+    static MLAS_FORCEINLINE Int ReinterpretAsInt(Float a) { return MlasReinterpretAsInt32x4(a); }
+    static MLAS_FORCEINLINE Float ReinterpretAsFloat(Int a) { return MlasReinterpretAsFloat32x4(a); }
+    static MLAS_FORCEINLINE Int AddInt(Int a, Int b) { return MlasAddInt32x4(a, b); }
+    static MLAS_FORCEINLINE Int ShiftLeftInt23(Int a) { return MlasShiftLeftInt32x4<23>(a); }
+    static MLAS_FORCEINLINE Float ConvertIntToFloat(Int a) { return MlasCastToFloat32x4(a); }
+};
+
+const MLAS_TRANSCENDENTAL_DISPATCH MlasTranscendentalDispatchDefault =
+    MlasTranscendentalMakeDispatch<MLAS_TRANSCENDENTAL_TRAITS_FLOAT32X4>();
+
+MLAS_FORCEINLINE
+const MLAS_TRANSCENDENTAL_DISPATCH&
+MlasGetTranscendentalDispatch()
+{
+#if defined(MLAS_TARGET_AMD64)
+    return *GetMlasPlatform().TranscendentalDispatch;
+#else
+    return MlasTranscendentalDispatchDefault;
+#endif
+}
+
+template<typename Function>
+void
+MlasComputeHalfByChunks(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N,
+    Function ComputeFloat
+    )
+/*++
+
+Routine Description:
+
+    This routine applies a single precision routine to a half precision
+    buffer by converting chunks of the buffer through a local buffer.
+
+--*/
+{
+    constexpr size_t ChunkSize = 256;
+    MLAS_DECLSPEC_ALIGN(float Buffer[ChunkSize], 64);
+
+    while (N > 0) {
+
+        const size_t Count = std::min(N, ChunkSize);
+
+        MlasConvertHalfToFloatBuffer(Input, Buffer, Count);
+        ComputeFloat(Buffer, Count);
+        MlasConvertFloatToHalfBuffer(Buffer, Output, Count);
+
+        Input += Count;
+        Output += Count;
+        N -= Count;
+    }
+}
+
+void
+MLASCALL
+MlasComputeGeluErf(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the Gelu function using the error function:
+
+        0.5 * x * (1 + erf(x / sqrt(2)))
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    MlasGetTranscendentalDispatch().GeluErfKernel(Input, Output, N);
+}
+
+void
+MLASCALL
+MlasComputeSilu(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the Silu (Swish) function: x * sigmoid(x).
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    MlasGetTranscendentalDispatch().SiluKernel(Input, Output, N);
+}
+
+void
+MLASCALL
+MlasComputeSoftplus(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the Softplus function: log(1 + exp(x)).
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    MlasGetTranscendentalDispatch().SoftplusKernel(Input, Output, N);
+}
+
+void
+MLASCALL
+MlasComputeLog(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the natural logarithm.
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    MlasGetTranscendentalDispatch().LogKernel(Input, Output, N);
+}
+
+void
+MLASCALL
+MlasComputeElu(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Alpha
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the Elu function:
+
+        x > 0 ? x : Alpha * (exp(x) - 1)
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+    Alpha - Supplies the scale of the negative part.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    MlasGetTranscendentalDispatch().EluKernel(Input, Output, N, Alpha, 1.0f);
+}
+
+void
+MLASCALL
+MlasComputeSelu(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Alpha,
+    float Gamma
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the Selu function:
+
+        Gamma * (x > 0 ? x : Alpha * (exp(x) - 1))
+
+Arguments:
+
+    Input - Supplies the input buffer.
+
+    Output - Supplies the output buffer.
+
+    N - Supplies the number of elements to process.
+
+    Alpha - Supplies the scale of the negative part.
+
+    Gamma - Supplies the scale of the result.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    MlasGetTranscendentalDispatch().EluKernel(Input, Output, N, Alpha, Gamma);
+}
+
+void
+MLASCALL
+MlasComputeGeluErf(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    )
+{
+    MlasComputeHalfByChunks(Input, Output, N, [](float* Buffer, size_t Count) {
+        MlasComputeGeluErf(Buffer, Buffer, Count);
+    });
+}
+
+void
+MLASCALL
+MlasComputeSilu(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    )
+{
+    MlasComputeHalfByChunks(Input, Output, N, [](float* Buffer, size_t Count) {
+        MlasComputeSilu(Buffer, Buffer, Count);
+    });
+}
+
+void
+MLASCALL
+MlasComputeSoftplus(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    )
+{
+    MlasComputeHalfByChunks(Input, Output, N, [](float* Buffer, size_t Count) {
+        MlasComputeSoftplus(Buffer, Buffer, Count);
+    });
+}
+
+void
+MLASCALL
+MlasComputeLog(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N
+    )
+{
+    MlasComputeHalfByChunks(Input, Output, N, [](float* Buffer, size_t Count) {
+        MlasComputeLog(Buffer, Buffer, Count);
+    });
+}
+
+void
+MLASCALL
+MlasComputeElu(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N,
+    float Alpha
+    )
+{
+    MlasComputeHalfByChunks(Input, Output, N, [Alpha](float* Buffer, size_t Count) {
+        MlasComputeElu(Buffer, Buffer, Count, Alpha);
+    });
+}
+
+void
+MLASCALL
+MlasComputeSelu(
+    const MLAS_FP16* Input,
+    MLAS_FP16* Output,
+    size_t N,
+    float Alpha,
+    float Gamma
+    )
+{
+    MlasComputeHalfByChunks(Input, Output, N, [Alpha, Gamma](float* Buffer, size_t Count) {
+        MlasComputeSelu(Buffer, Buffer, Count, Alpha, Gamma);
+    });
+}
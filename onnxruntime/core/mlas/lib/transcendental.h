@@ -0,0 +1,522 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    transcendental.h
+
+Abstract:
+
+    This module defines the vectorized transcendental routines used to
+    implement the elementwise activations: Gelu (erf form), Silu, Softplus,
+    Elu/Selu and the natural logarithm.
+
+    The algorithms are written once as templates over a vector traits type
+    and instantiated for each instruction set: MLAS_FLOAT32X4 (SSE2, NEON,
+    and the other 128-bit targets), AVX2/FMA3 and AVX512F. A traits type
+    defines:
+
+        Float, Int, Mask        The float, int32 and comparison mask vector
+                                types.
+        Count                   The number of elements of a vector.
+        Broadcast, BroadcastInt, Load, Store
+        Add, Subtract, Multiply, Divide, MultiplyAdd (a * b + c)
+        Maximum, Minimum        With the SSE convention of returning the
+                                second operand when either operand is a NaN.
+        And, Or, AndNot, Xor    Bitwise operations on float vectors.
+        GreaterThan, Select     Comparison producing a Mask and a blend by
+                                that Mask.
+        ReinterpretAsInt, ReinterpretAsFloat, AddInt, ShiftLeftInt23,
+        ConvertIntToFloat
+
+    The accuracy of each routine against the C runtime is verified by the
+    Transcendental unit test.
+
+--*/
+
+#pragma once
+
+#include "mlasi.h"
+
+#include <algorithm>
+#include <limits>
+
+typedef
+void
+(MLASCALL MLAS_COMPUTE_ELU_FLOAT_KERNEL)(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Alpha,
+    float Gamma
+    );
+
+struct MLAS_TRANSCENDENTAL_DISPATCH {
+    MLAS_COMPUTE_UNARY_FLOAT_KERNEL* GeluErfKernel;
+    MLAS_COMPUTE_UNARY_FLOAT_KERNEL* SiluKernel;
+    MLAS_COMPUTE_UNARY_FLOAT_KERNEL* SoftplusKernel;
+    MLAS_COMPUTE_UNARY_FLOAT_KERNEL* LogKernel;
+    MLAS_COMPUTE_ELU_FLOAT_KERNEL* EluKernel;
+};
+
+struct MlasTranscendentalConstants {
+    //
+    // The exponential clamps its input so that 2^round(x/ln2) stays a normal
+    // number. The polynomial is shared with MlasComputeExp.
+    //
+    static constexpr float ExpLowerRange = -87.33654475f;
+    static constexpr float ExpUpperRange = 88.02969193f;
+    static constexpr float Log2Reciprocal = 1.44269504088896341f;
+    static constexpr float Log2High = -6.93145752e-1f;
+    static constexpr float Log2Low = -1.42860677e-6f;
+    static constexpr float ExpP0 = 0x1.694000p-10f;
+    static constexpr float ExpP1 = 0x1.125edcp-7f;
+    static constexpr float ExpP2 = 0x1.555b5ap-5f;
+    static constexpr float ExpP3 = 0x1.555450p-3f;
+    static constexpr float ExpP4 = 0x1.fffff6p-2f;
+    static constexpr int32_t ExpOneBits = 0x3F800000;
+
+    //
+    // Below this magnitude, expm1 is evaluated by its Taylor series to avoid
+    // the cancellation of exp(x) - 1.
+    //
+    static constexpr float Expm1SeriesRange = 0.34657359f;  // ln(2) / 2
+
+    //
+    // The natural logarithm uses the Cephes logf polynomial over a mantissa
+    // reduced to [sqrt(0.5), sqrt(2)).
+    //
+    static constexpr float LogSqrtHalf = 0.707106781186547524f;
+    static constexpr float LogP0 = 7.0376836292e-2f;
+    static constexpr float LogP1 = -1.1514610310e-1f;
+    static constexpr float LogP2 = 1.1676998740e-1f;
+    static constexpr float LogP3 = -1.2420140846e-1f;
+    static constexpr float LogP4 = 1.4249322787e-1f;
+    static constexpr float LogP5 = -1.6668057665e-1f;
+    static constexpr float LogP6 = 2.0000714765e-1f;
+    static constexpr float LogP7 = -2.4999993993e-1f;
+    static constexpr float LogP8 = 3.3333331174e-1f;
+    static constexpr float LogQ1 = -2.12194440e-4f;
+    static constexpr float LogQ2 = 0.693359375f;
+    static constexpr float LogDenormalScale = 8388608.0f;  // 2^23
+    static constexpr int32_t LogExponentMask = 0x7F800000;
+
+    //
+    // The error function uses the polynomials of MlasComputeErf.
+    //
+    static constexpr float ErfUpperAbsRange = 3.925f;
+    static constexpr float ErfSplitBoundary = 0.921875f;
+    static constexpr float ErfSmallP0 = -5.99104969e-4f;
+    static constexpr float ErfSmallP1 = 4.99339588e-3f;
+    static constexpr float ErfSmallP2 = -2.67667342e-2f;
+    static constexpr float ErfSmallP3 = 1.12818025e-1f;
+    static constexpr float ErfSmallP4 = -3.76124859e-1f;
+    static constexpr float ErfSmallP5MinusOne = 1.28379151e-1f;
+    static constexpr float ErfBigP0 = 1.72948930e-5f;
+    static constexpr float ErfBigP1 = -3.83208680e-4f;
+    static constexpr float ErfBigP2 = 3.88393435e-3f;
+    static constexpr float ErfBigP3 = -2.42545605e-2f;
+    static constexpr float ErfBigP4 = 1.06777847e-1f;
+    static constexpr float ErfBigP5 = 6.34846687e-1f;
+    static constexpr float ErfBigP6MinusOne = 1.28717512e-1f;
+
+    static constexpr float SqrtHalf = 0.70710678118654752f;
+};
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalExp(
+    typename Traits::Float Value
+    )
+/*++
+
+Routine Description:
+
+    This routine computes exp(x) as 2^m * exp(r) with m = round(x / ln2).
+
+--*/
+{
+    using C = MlasTranscendentalConstants;
+
+    Value = Traits::Maximum(Traits::Broadcast(C::ExpLowerRange), Value);
+    Value = Traits::Minimum(Traits::Broadcast(C::ExpUpperRange), Value);
+
+    const auto RoundingBias = Traits::Broadcast(MLAS_ROUNDING_BIAS_MAGIC);
+    const auto Biased = Traits::MultiplyAdd(Value, Traits::Broadcast(C::Log2Reciprocal), RoundingBias);
+    const auto m = Traits::Subtract(Biased, RoundingBias);
+
+    Value = Traits::MultiplyAdd(m, Traits::Broadcast(C::Log2High), Value);
+    Value = Traits::MultiplyAdd(m, Traits::Broadcast(C::Log2Low), Value);
+
+    const auto One = Traits::Broadcast(1.0f);
+
+    auto p = Traits::Broadcast(C::ExpP0);
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(C::ExpP1));
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(C::ExpP2));
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(C::ExpP3));
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(C::ExpP4));
+    p = Traits::MultiplyAdd(p, Value, One);
+    p = Traits::MultiplyAdd(p, Value, One);
+
+    //
+    // The low bits of the biased value hold m, so shifting them into the
+    // exponent field and adding the bias of 1.0 yields 2^m.
+    //
+
+    const auto Scale = Traits::ReinterpretAsFloat(Traits::AddInt(
+        Traits::ShiftLeftInt23(Traits::ReinterpretAsInt(Biased)), Traits::BroadcastInt(C::ExpOneBits)));
+
+    return Traits::Multiply(p, Scale);
+}
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalExpm1(
+    typename Traits::Float Value
+    )
+{
+    using C = MlasTranscendentalConstants;
+
+    const auto NegativeZero = Traits::Broadcast(-0.0f);
+    const auto AbsValue = Traits::AndNot(NegativeZero, Value);
+
+    auto p = Traits::Broadcast(1.0f / 5040.0f);
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(1.0f / 720.0f));
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(1.0f / 120.0f));
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(1.0f / 24.0f));
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(1.0f / 6.0f));
+    p = Traits::MultiplyAdd(p, Value, Traits::Broadcast(0.5f));
+    p = Traits::MultiplyAdd(p, Traits::Multiply(Value, Value), Value);
+
+    const auto e = Traits::Subtract(MlasTranscendentalExp<Traits>(Value), Traits::Broadcast(1.0f));
+
+    return Traits::Select(Traits::GreaterThan(Traits::Broadcast(C::Expm1SeriesRange), AbsValue), p, e);
+}
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalLog(
+    typename Traits::Float Value
+    )
+/*++
+
+Routine Description:
+
+    This routine computes the natural logarithm. Zero returns -infinity,
+    negative values and NaNs return NaN and +infinity returns +infinity.
+
+--*/
+{
+    using C = MlasTranscendentalConstants;
+
+    const auto Zero = Traits::Broadcast(0.0f);
+    const auto One = Traits::Broadcast(1.0f);
+
+    //
+    // Scale denormals into the normal range.
+    //
+
+    const auto IsDenormal = Traits::GreaterThan(Traits::Broadcast(std::numeric_limits<float>::min()), Value);
+    auto x = Traits::Select(IsDenormal, Traits::Multiply(Value, Traits::Broadcast(C::LogDenormalScale)), Value);
+
+    //
+    // Split x into a mantissa in [0.5, 1) and an exponent. The exponent
+    // field is a multiple of 2^23 that converts to float exactly.
+    //
+
+    const auto ExponentMask = Traits::ReinterpretAsFloat(Traits::BroadcastInt(C::LogExponentMask));
+    const auto ExponentField = Traits::And(x, ExponentMask);
+    auto e = Traits::ConvertIntToFloat(Traits::ReinterpretAsInt(ExponentField));
+    e = Traits::MultiplyAdd(e, Traits::Broadcast(1.0f / 8388608.0f), Traits::Broadcast(-126.0f));
+    e = Traits::Subtract(e, Traits::Select(IsDenormal, Traits::Broadcast(23.0f), Zero));
+
+    auto m = Traits::Or(Traits::AndNot(ExponentMask, x), Traits::Broadcast(0.5f));
+
+    const auto IsSmall = Traits::GreaterThan(Traits::Broadcast(C::LogSqrtHalf), m);
+    e = Traits::Subtract(e, Traits::Select(IsSmall, One, Zero));
+    x = Traits::Add(Traits::Subtract(m, One), Traits::Select(IsSmall, m, Zero));
+
+    const auto z = Traits::Multiply(x, x);
+
+    auto y = Traits::Broadcast(C::LogP0);
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP1));
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP2));
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP3));
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP4));
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP5));
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP6));
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP7));
+    y = Traits::MultiplyAdd(y, x, Traits::Broadcast(C::LogP8));
+    y = Traits::Multiply(Traits::Multiply(y, x), z);
+
+    y = Traits::MultiplyAdd(e, Traits::Broadcast(C::LogQ1), y);
+    y = Traits::MultiplyAdd(z, Traits::Broadcast(-0.5f), y);
+    x = Traits::Add(x, y);
+    x = Traits::MultiplyAdd(e, Traits::Broadcast(C::LogQ2), x);
+
+    //
+    // Non-positive inputs produce -infinity for zero and NaN otherwise; the
+    // (Value - Value) term carries an input NaN through.
+    //
+
+    auto Special = Traits::Select(Traits::GreaterThan(Zero, Value),
+                                  Traits::Broadcast(std::numeric_limits<float>::quiet_NaN()),
+                                  Traits::Broadcast(-std::numeric_limits<float>::infinity()));
+    Special = Traits::Add(Special, Traits::Subtract(Value, Value));
+
+    x = Traits::Select(Traits::GreaterThan(Value, Zero), x, Special);
+    x = Traits::Select(Traits::GreaterThan(Value, Traits::Broadcast(std::numeric_limits<float>::max())), Value, x);
+
+    return x;
+}
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalErf(
+    typename Traits::Float Value
+    )
+{
+    using C = MlasTranscendentalConstants;
+
+    const auto NegativeZero = Traits::Broadcast(-0.0f);
+    const auto SignBits = Traits::And(Value, NegativeZero);
+    auto AbsValue = Traits::AndNot(NegativeZero, Value);
+    AbsValue = Traits::Minimum(Traits::Broadcast(C::ErfUpperAbsRange), AbsValue);
+
+    const auto SquareValue = Traits::Multiply(AbsValue, AbsValue);
+
+    auto r_small = Traits::Broadcast(C::ErfSmallP0);
+    r_small = Traits::MultiplyAdd(r_small, SquareValue, Traits::Broadcast(C::ErfSmallP1));
+    r_small = Traits::MultiplyAdd(r_small, SquareValue, Traits::Broadcast(C::ErfSmallP2));
+    r_small = Traits::MultiplyAdd(r_small, SquareValue, Traits::Broadcast(C::ErfSmallP3));
+    r_small = Traits::MultiplyAdd(r_small, SquareValue, Traits::Broadcast(C::ErfSmallP4));
+    r_small = Traits::MultiplyAdd(r_small, SquareValue, Traits::Broadcast(C::ErfSmallP5MinusOne));
+    r_small = Traits::MultiplyAdd(r_small, AbsValue, AbsValue);
+
+    auto r_big = Traits::Broadcast(C::ErfBigP0);
+    r_big = Traits::MultiplyAdd(r_big, AbsValue, Traits::Broadcast(C::ErfBigP1));
+    r_big = Traits::MultiplyAdd(r_big, AbsValue, Traits::Broadcast(C::ErfBigP2));
+    r_big = Traits::MultiplyAdd(r_big, AbsValue, Traits::Broadcast(C::ErfBigP3));
+    r_big = Traits::MultiplyAdd(r_big, AbsValue, Traits::Broadcast(C::ErfBigP4));
+    r_big = Traits::MultiplyAdd(r_big, AbsValue, Traits::Broadcast(C::ErfBigP5));
+    r_big = Traits::MultiplyAdd(r_big, AbsValue, Traits::Broadcast(C::ErfBigP6MinusOne));
+    r_big = Traits::MultiplyAdd(r_big, AbsValue, AbsValue);
+
+    // erf(|x|) = 1 - exp(-r_big) for |x| above the split boundary.
+    r_big = Traits::Subtract(Traits::Broadcast(1.0f), MlasTranscendentalExp<Traits>(Traits::Xor(r_big, NegativeZero)));
+
+    const auto IsBig = Traits::GreaterThan(AbsValue, Traits::Broadcast(C::ErfSplitBoundary));
+
+    return Traits::Or(Traits::Select(IsBig, r_big, r_small), SignBits);
+}
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalGeluErf(
+    typename Traits::Float Value
+    )
+{
+    const auto HalfValue = Traits::Multiply(Value, Traits::Broadcast(0.5f));
+    const auto Erf = MlasTranscendentalErf<Traits>(
+        Traits::Multiply(Value, Traits::Broadcast(MlasTranscendentalConstants::SqrtHalf)));
+
+    return Traits::MultiplyAdd(Erf, HalfValue, HalfValue);
+}
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalSilu(
+    typename Traits::Float Value
+    )
+{
+    const auto NegativeValue = Traits::Xor(Value, Traits::Broadcast(-0.0f));
+    const auto Denominator = Traits::Add(Traits::Broadcast(1.0f), MlasTranscendentalExp<Traits>(NegativeValue));
+    const auto Result = Traits::Divide(Value, Denominator);
+
+    //
+    // exp(-x) saturates below the range of the exponential, where the result
+    // has underflowed to zero.
+    //
+
+    const auto Underflow = Traits::GreaterThan(Traits::Broadcast(MlasTranscendentalConstants::ExpLowerRange), Value);
+
+    return Traits::Select(Underflow, Traits::Broadcast(0.0f), Result);
+}
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalSoftplus(
+    typename Traits::Float Value
+    )
+/*++
+
+Routine Description:
+
+    This routine computes log(1 + exp(x)) as max(x, 0) + log1p(exp(-|x|)).
+    log1p(u) is evaluated as log(w) * u / (w - 1) with w = 1 + u, which
+    corrects the rounding of w.
+
+--*/
+{
+    const auto Zero = Traits::Broadcast(0.0f);
+    const auto NegativeZero = Traits::Broadcast(-0.0f);
+
+    const auto u = MlasTranscendentalExp<Traits>(Traits::Or(Value, NegativeZero));
+    const auto w = Traits::Add(Traits::Broadcast(1.0f), u);
+    const auto d = Traits::Subtract(w, Traits::Broadcast(1.0f));
+
+    auto Log1p = Traits::Divide(Traits::Multiply(MlasTranscendentalLog<Traits>(w), u), d);
+    Log1p = Traits::Select(Traits::GreaterThan(d, Zero), Log1p, u);
+
+    return Traits::Add(Traits::Maximum(Zero, Value), Log1p);
+}
+
+template<typename Traits>
+MLAS_FORCEINLINE
+typename Traits::Float
+MlasTranscendentalElu(
+    typename Traits::Float Value,
+    typename Traits::Float Alpha,
+    typename Traits::Float Gamma
+    )
+{
+    const auto Negative = Traits::Multiply(Alpha, MlasTranscendentalExpm1<Traits>(Value));
+    const auto Result = Traits::Select(Traits::GreaterThan(Value, Traits::Broadcast(0.0f)), Value, Negative);
+
+    return Traits::Multiply(Gamma, Result);
+}
+
+template<typename Traits, typename Operation>
+MLAS_FORCEINLINE
+void
+MlasTranscendentalApply(
+    const float* Input,
+    float* Output,
+    size_t N,
+    Operation Op
+    )
+{
+    while (N >= Traits::Count) {
+
+        Traits::Store(Output, Op(Traits::Load(Input)));
+
+        Input += Traits::Count;
+        Output += Traits::Count;
+        N -= Traits::Count;
+    }
+
+    if (N > 0) {
+
+        float Buffer[Traits::Count];
+
+        std::copy_n(Input, N, Buffer);
+        std::fill_n(Buffer + N, Traits::Count - N, 0.0f);
+
+        Traits::Store(Buffer, Op(Traits::Load(Buffer)));
+
+        std::copy_n(Buffer, N, Output);
+    }
+}
+
+//
+// Kernel entry points. Each instruction set instantiates these with its own
+// traits type to build its MLAS_TRANSCENDENTAL_DISPATCH.
+//
+
+template<typename Traits>
+void
+MLASCALL
+MlasGeluErfKernel(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+{
+    MlasTranscendentalApply<Traits>(Input, Output, N, [](typename Traits::Float Value) {
+        return MlasTranscendentalGeluErf<Traits>(Value);
+    });
+}
+
+template<typename Traits>
+void
+MLASCALL
+MlasSiluKernel(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+{
+    MlasTranscendentalApply<Traits>(Input, Output, N, [](typename Traits::Float Value) {
+        return MlasTranscendentalSilu<Traits>(Value);
+    });
+}
+
+template<typename Traits>
+void
+MLASCALL
+MlasSoftplusKernel(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+{
+    MlasTranscendentalApply<Traits>(Input, Output, N, [](typename Traits::Float Value) {
+        return MlasTranscendentalSoftplus<Traits>(Value);
+    });
+}
+
+template<typename Traits>
+void
+MLASCALL
+MlasLogKernel(
+    const float* Input,
+    float* Output,
+    size_t N
+    )
+{
+    MlasTranscendentalApply<Traits>(Input, Output, N, [](typename Traits::Float Value) {
+        return MlasTranscendentalLog<Traits>(Value);
+    });
+}
+
+template<typename Traits>
+void
+MLASCALL
+MlasEluKernel(
+    const float* Input,
+    float* Output,
+    size_t N,
+    float Alpha,
+    float Gamma
+    )
+{
+    const auto AlphaBroadcast = Traits::Broadcast(Alpha);
+    const auto GammaBroadcast = Traits::Broadcast(Gamma);
+
+    MlasTranscendentalApply<Traits>(Input, Output, N, [&](typename Traits::Float Value) {
+        return MlasTranscendentalElu<Traits>(Value, AlphaBroadcast, GammaBroadcast);
+    });
+}
+
+template<typename Traits>
+constexpr MLAS_TRANSCENDENTAL_DISPATCH
+MlasTranscendentalMakeDispatch()
+{
+    return {
+        MlasGeluErfKernel<Traits>,
+        MlasSiluKernel<Traits>,
+        MlasSoftplusKernel<Traits>,
+        MlasLogKernel<Traits>,
+        MlasEluKernel<Traits>,
+    };
+}
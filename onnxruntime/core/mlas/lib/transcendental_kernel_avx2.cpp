@@ -0,0 +1,58 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    transcendental_kernel_avx2.cpp
+
+Abstract:
+
+    This module implements the vectorized transcendental kernels for
+    processors supporting AVX2/FMA3.
+
+--*/
+
+#include "transcendental.h"
+
+#include <immintrin.h>
+
+struct MLAS_TRANSCENDENTAL_TRAITS_AVX2 {
+    using Float = __m256;
+    using Int = __m256i;
+    using Mask = __m256;
+
+    static constexpr size_t Count = 8;
+
+    static MLAS_FORCEINLINE Float Broadcast(float Value) { return _mm256_set1_ps(Value); }
+    static MLAS_FORCEINLINE Int BroadcastInt(int32_t Value) { return _mm256_set1_epi32(Value); }
+    static MLAS_FORCEINLINE Float Load(const float* Buffer) { return _mm256_loadu_ps(Buffer); }
+    static MLAS_FORCEINLINE void Store(float* Buffer, Float Vector) { _mm256_storeu_ps(Buffer, Vector); }
+
+    static MLAS_FORCEINLINE Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static MLAS_FORCEINLINE Float Subtract(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static MLAS_FORCEINLINE Float Multiply(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static MLAS_FORCEINLINE Float Divide(Float a, Float b) { return _mm256_div_ps(a, b); }
+    static MLAS_FORCEINLINE Float MultiplyAdd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+    static MLAS_FORCEINLINE Float Maximum(Float a, Float b) { return _mm256_max_ps(a, b); }
+    static MLAS_FORCEINLINE Float Minimum(Float a, Float b) { return _mm256_min_ps(a, b); }
+
+    static MLAS_FORCEINLINE Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+    static MLAS_FORCEINLINE Float Or(Float a, Float b) { return _mm256_or_ps(a, b); }
+    static MLAS_FORCEINLINE Float AndNot(Float a, Float b) { return _mm256_andnot_ps(a, b); }
+    static MLAS_FORCEINLINE Float Xor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+
+    static MLAS_FORCEINLINE Mask GreaterThan(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static MLAS_FORCEINLINE Float Select(Mask m, Float a, Float b) { return _mm256_blendv_ps(b, a, m); }
+
+    static MLAS_FORCEINLINE Int ReinterpretAsInt(Float a) { return _mm256_castps_si256(a); }
+    static MLAS_FORCEINLINE Float ReinterpretAsFloat(Int a) { return _mm256_castsi256_ps(a); }
+    static MLAS_FORCEINLINE Int AddInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+    static MLAS_FORCEINLINE Int ShiftLeftInt23(Int a) { return _mm256_slli_epi32(a, 23); }
+    static MLAS_FORCEINLINE Float ConvertIntToFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+};
+
+const MLAS_TRANSCENDENTAL_DISPATCH MlasTranscendentalDispatchFma3 =
+    MlasTranscendentalMakeDispatch<MLAS_TRANSCENDENTAL_TRAITS_AVX2>();
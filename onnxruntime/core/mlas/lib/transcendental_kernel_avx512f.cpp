@@ -0,0 +1,74 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    transcendental_kernel_avx512f.cpp
+
+Abstract:
+
+    This module implements the vectorized transcendental kernels for
+    processors supporting AVX512F.
+
+--*/
+
+#include "transcendental.h"
+
+#include <immintrin.h>
+
+struct MLAS_TRANSCENDENTAL_TRAITS_AVX512F {
+    using Float = __m512;
+    using Int = __m512i;
+    using Mask = __mmask16;
+
+    static constexpr size_t Count = 16;
+
+    static MLAS_FORCEINLINE Float Broadcast(float Value) { return _mm512_set1_ps(Value); }
+    static MLAS_FORCEINLINE Int BroadcastInt(int32_t Value) { return _mm512_set1_epi32(Value); }
+    static MLAS_FORCEINLINE Float Load(const float* Buffer) { return _mm512_loadu_ps(Buffer); }
+    static MLAS_FORCEINLINE void Store(float* Buffer, Float Vector) { _mm512_storeu_ps(Buffer, Vector); }
+
+    static MLAS_FORCEINLINE Float Add(Float a, Float b) { return _mm512_add_ps(a, b); }
+    static MLAS_FORCEINLINE Float Subtract(Float a, Float b) { return _mm512_sub_ps(a, b); }
+    static MLAS_FORCEINLINE Float Multiply(Float a, Float b) { return _mm512_mul_ps(a, b); }
+    static MLAS_FORCEINLINE Float Divide(Float a, Float b) { return _mm512_div_ps(a, b); }
+    static MLAS_FORCEINLINE Float MultiplyAdd(Float a, Float b, Float c) { return _mm512_fmadd_ps(a, b, c); }
+    static MLAS_FORCEINLINE Float Maximum(Float a, Float b) { return _mm512_max_ps(a, b); }
+    static MLAS_FORCEINLINE Float Minimum(Float a, Float b) { return _mm512_min_ps(a, b); }
+
+    //
+    // The floating point forms of the bitwise operations require AVX512DQ.
+    //
+
+    static MLAS_FORCEINLINE Float And(Float a, Float b)
+    {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+    static MLAS_FORCEINLINE Float Or(Float a, Float b)
+    {
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+    static MLAS_FORCEINLINE Float AndNot(Float a, Float b)
+    {
+        return _mm512_castsi512_ps(_mm512_andnot_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+    static MLAS_FORCEINLINE Float Xor(Float a, Float b)
+    {
+        return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+
+    static MLAS_FORCEINLINE Mask GreaterThan(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static MLAS_FORCEINLINE Float Select(Mask m, Float a, Float b) { return _mm512_mask_blend_ps(m, b, a); }
+
+    static MLAS_FORCEINLINE Int ReinterpretAsInt(Float a) { return _mm512_castps_si512(a); }
+    static MLAS_FORCEINLINE Float ReinterpretAsFloat(Int a) { return _mm512_castsi512_ps(a); }
+    static MLAS_FORCEINLINE Int AddInt(Int a, Int b) { return _mm512_add_epi32(a, b); }
+    static MLAS_FORCEINLINE Int ShiftLeftInt23(Int a) { return _mm512_slli_epi32(a, 23); }
+    static MLAS_FORCEINLINE Float ConvertIntToFloat(Int a) { return _mm512_cvtepi32_ps(a); }
+};
+
+const MLAS_TRANSCENDENTAL_DISPATCH MlasTranscendentalDispatchAvx512F =
+    MlasTranscendentalMakeDispatch<MLAS_TRANSCENDENTAL_TRAITS_AVX512F>();
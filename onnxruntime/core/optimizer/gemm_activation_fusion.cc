@@ -30,9 +30,13 @@ bool IsFusableActivation(const Node& node) {
          IsSupportedOptypeVersionAndDomain(node, "Softplus", {1}, kOnnxDomain) ||
          IsSupportedOptypeVersionAndDomain(node, "Softsign", {1}, kOnnxDomain) ||
          IsSupportedOptypeVersionAndDomain(node, "Tanh", {6, 13}, kOnnxDomain) ||
+         IsSupportedOptypeVersionAndDomain(node, "Gelu", {20}, kOnnxDomain) ||
 #ifndef DISABLE_CONTRIB_OPS
          IsSupportedOptypeVersionAndDomain(node, "ScaledTanh", {1}, kOnnxDomain) ||
          IsSupportedOptypeVersionAndDomain(node, "ParametricSoftplus", {1}, kOnnxDomain) ||
+         IsSupportedOptypeVersionAndDomain(node, "Gelu", {1}, kMSDomain) ||
+         // FastGelu with a bias input is left to the FastGelu kernel.
+         (IsSupportedOptypeVersionAndDomain(node, "FastGelu", {1}, kMSDomain) && node.InputDefs().size() == 1) ||
 #endif
          IsSupportedOptypeVersionAndDomain(node, "ThresholdedRelu", {1, 10}, kOnnxDomain);
 }
@@ -84,6 +84,20 @@ struct ThreadOptions {
   // The process that owns the thread may consider setting its affinity.
   std::vector<LogicalProcessors> affinities;
 
+  // NUMA node of each thread, indexed the same way as affinities. If the vector is not empty, the thread pool groups
+  // its threads by node: tasks are pushed to and stolen from threads of the same node first, and parallel loops keep
+  // contiguous shards of iterations on one node. On Linux a thread also prefers to allocate memory from its node.
+  std::vector<int> numa_nodes;
+
+  // If true, the degree of parallelism of each parallel loop adapts to the load on the pool: a loop gets a share
+  // of the threads in proportion to the priority of its caller among the callers currently running loops on the
+  // pool. See ThreadPool::SchedulingContext.
+  bool adaptive_parallelism = false;
+
+  // If true, an idle worker learns how long to spin before blocking from the gaps it observes between tasks,
+  // instead of always spinning for a fixed number of iterations. Only takes effect if the pool allows spinning.
+  bool adaptive_spinning = false;
+
   // Set or unset denormal as zero.
   bool set_denormal_as_zero = false;
 
@@ -147,6 +161,12 @@ class Env {
 
   virtual std::vector<LogicalProcessors> GetDefaultThreadAffinities() const = 0;
 
+  /// <summary>
+  /// Returns the logical processors of each NUMA node, indexed by node id. Nodes without processors have an
+  /// empty entry. The result is empty if the topology is unknown.
+  /// </summary>
+  virtual std::vector<LogicalProcessors> GetNumaNodeAffinities() const { return {}; }
+
   virtual int GetL2CacheSize() const = 0;
 
   /// \brief Returns the number of micro-seconds since the Unix epoch.
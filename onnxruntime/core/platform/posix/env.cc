@@ -31,6 +31,7 @@ limitations under the License.
 #endif
 #include <unistd.h>
 
+#include <fstream>
 #include <iostream>
 #include <optional>
 #include <thread>
@@ -124,6 +125,42 @@ struct Freer {
 
 using MallocdStringPtr = std::unique_ptr<char, Freer<char> >;
 
+#if defined(__linux__) && !defined(__ANDROID__)
+// Parses a sysfs cpu or node list such as "0-3,8-11". Returns an empty vector if the file cannot be read.
+std::vector<int> ReadSysfsList(const std::string& path) {
+  std::vector<int> ids;
+  std::ifstream file(path);
+  std::string list;
+  if (!file || !std::getline(file, list)) {
+    return ids;
+  }
+  const char* cursor = list.c_str();
+  while (*cursor != '\0') {
+    char* end = nullptr;
+    const long first = strtol(cursor, &end, 10);
+    if (end == cursor || first < 0) {
+      break;
+    }
+    long last = first;
+    if (*end == '-') {
+      cursor = end + 1;
+      last = strtol(cursor, &end, 10);
+      if (end == cursor || last < first) {
+        break;
+      }
+    }
+    for (long id = first; id <= last; ++id) {
+      ids.push_back(static_cast<int>(id));
+    }
+    if (*end != ',') {
+      break;
+    }
+    cursor = end + 1;
+  }
+  return ids;
+}
+#endif
+
 class PosixThread : public EnvThread {
  private:
   struct Param {
@@ -132,6 +169,7 @@ class PosixThread : public EnvThread {
     unsigned (*start_address)(int id, Eigen::ThreadPoolInterface* param);
     Eigen::ThreadPoolInterface* param;
     std::optional<LogicalProcessors> affinity;
+    int numa_node = -1;
 
     Param(const ORTCHAR_T* name_prefix1,
           int index1,
@@ -156,6 +194,9 @@ class PosixThread : public EnvThread {
     if (narrow<size_t>(index) < thread_options.affinities.size()) {
       param_ptr->affinity = thread_options.affinities[index];
     }
+    if (narrow<size_t>(index) < thread_options.numa_nodes.size()) {
+      param_ptr->numa_node = thread_options.numa_nodes[index];
+    }
 
     if (custom_create_thread_fn) {
       custom_thread_handle = custom_create_thread_fn(custom_thread_creation_options, CustomThreadMain, param_ptr.get());
@@ -239,6 +280,23 @@ class PosixThread : public EnvThread {
 #endif
         }
       }
+#endif
+#if defined(__linux__) && !defined(__ANDROID__) && defined(SYS_set_mempolicy)
+      // Prefer the memory of the thread's NUMA node, so that buffers the thread allocates and first touches
+      // (e.g. the per-thread MLAS scratch buffers) stay local even if its affinity spans several nodes.
+      constexpr int kMpolPreferred = 1;
+      constexpr int kMaxNodes = 1024;
+      if (p->numa_node >= 0 && p->numa_node < kMaxNodes) {
+        constexpr int kBitsPerWord = 8 * sizeof(unsigned long);
+        unsigned long node_mask[kMaxNodes / kBitsPerWord] = {};
+        node_mask[p->numa_node / kBitsPerWord] = 1UL << (p->numa_node % kBitsPerWord);
+        if (syscall(SYS_set_mempolicy, kMpolPreferred, node_mask, kMaxNodes + 1) != 0) {
+          auto [err_no, err_msg] = GetErrnoInfo();
+          LOGS_DEFAULT(WARNING) << "set_mempolicy failed for thread: " << syscall(SYS_gettid)
+                                << ", index: " << p->index << ", numa node: " << p->numa_node
+                                << ", error code: " << err_no << " error msg: " << err_msg;
+        }
+      }
 #endif
       // Ignore the returned value for now
       p->start_address(p->index, p->param);
@@ -308,6 +366,22 @@ class PosixEnv : public Env {
     return ret;
   }
 
+  std::vector<LogicalProcessors> GetNumaNodeAffinities() const override {
+    std::vector<LogicalProcessors> ret;
+#if defined(__linux__) && !defined(__ANDROID__)
+    for (int node : ReadSysfsList("/sys/devices/system/node/online")) {
+      if (node < 0 || node >= 1024) {
+        continue;
+      }
+      if (ret.size() <= static_cast<size_t>(node)) {
+        ret.resize(static_cast<size_t>(node) + 1);
+      }
+      ret[node] = ReadSysfsList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    }
+#endif
+    return ret;
+  }
+
   int GetL2CacheSize() const override {
 #ifdef _SC_LEVEL2_CACHE_SIZE
     return static_cast<int>(sysconf(_SC_LEVEL2_CACHE_SIZE));
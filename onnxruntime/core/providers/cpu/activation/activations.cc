@@ -120,6 +120,27 @@ void Tanh<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const {
   float* output_ptr = output + first;
   MlasComputeTanh(input + first, output_ptr, static_cast<size_t>(len));
 }
+
+template <>
+void Elu<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const {
+  ptrdiff_t len = last - first;
+  float* output_ptr = output + first;
+  MlasComputeElu(input + first, output_ptr, static_cast<size_t>(len), alpha);
+}
+
+template <>
+void Selu<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const {
+  ptrdiff_t len = last - first;
+  float* output_ptr = output + first;
+  MlasComputeSelu(input + first, output_ptr, static_cast<size_t>(len), alpha, gamma);
+}
+
+template <>
+void Softplus<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const {
+  ptrdiff_t len = last - first;
+  float* output_ptr = output + first;
+  MlasComputeSoftplus(input + first, output_ptr, static_cast<size_t>(len));
+}
 }  // namespace functors
 
 }  // namespace onnxruntime
@@ -46,6 +46,9 @@ struct Elu : public ElementWiseRangedTransform<T> {
   }
 };
 
+template <>
+void Elu<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const;
+
 template <typename T>
 struct HardSigmoid : public ElementWiseRangedTransform<T> {
   ORT_GET_FLOAT_ATTR_AND_RETURN_2(alpha, beta);
@@ -102,6 +105,9 @@ struct Softplus : public ElementWiseRangedTransform<T> {
   }
 };
 
+template <>
+void Softplus<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const;
+
 template <typename T>
 struct Relu : public ElementWiseRangedTransform<T> {
   Status Init(const onnxruntime::NodeAttributes&) {
@@ -232,6 +238,9 @@ struct Selu : public ElementWiseRangedTransform<T> {
     ym = (xm > 0).select((T)gamma * xm, (T)gamma * (T)alpha * (xm.exp() - 1.0f));
   }
 };
+
+template <>
+void Selu<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const;
 }  // namespace functors
 
 DEFINE_ELE_KERNEL(Celu);
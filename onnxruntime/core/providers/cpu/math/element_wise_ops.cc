@@ -74,6 +74,13 @@ void Exp<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const {
   float* output_ptr = output + first;
   MlasComputeExp(input + first, output_ptr, static_cast<size_t>(len));
 }
+
+template <>
+void Log<float>::operator()(std::ptrdiff_t first, std::ptrdiff_t last) const {
+  ptrdiff_t len = last - first;
+  float* output_ptr = output + first;
+  MlasComputeLog(input + first, output_ptr, static_cast<size_t>(len));
+}
 }  // namespace functors
 
 #define REG_ELEMENTWISE_TYPED_KERNEL(OP_TYPE, VERSION, TYPE, KERNEL_CLASS)         \
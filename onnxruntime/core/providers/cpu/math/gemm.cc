@@ -100,15 +100,27 @@ ONNX_CPU_OPERATOR_TYPED_KERNEL(
     KernelDefBuilder().TypeConstraint("T", DataTypeImpl::GetTensorType<MLFloat16>()),
     Gemm<MLFloat16>);
 
+size_t GemmPackBFp32Size(const TensorShape& b_shape, bool trans_b) {
+  // Only handle the common case of a 2D weight matrix. Additional matrices
+  // could be handled by stacking the packed buffers.
+  if (b_shape.NumDimensions() != 2) {
+    return 0;
+  }
+
+  const size_t K = trans_b ? static_cast<size_t>(b_shape[1]) : static_cast<size_t>(b_shape[0]);
+  const size_t N = trans_b ? static_cast<size_t>(b_shape[0]) : static_cast<size_t>(b_shape[1]);
+
+  return MlasGemmPackBSize(N, K);
+}
+
 bool GemmPackBFp32(AllocatorPtr& alloc,
                    const Tensor& tensor_b,
                    bool trans_b,
                    IAllocatorUniquePtr<void>& packed_b,
                    size_t& packed_b_size,
                    TensorShape& b_shape) {
-  // Only handle the common case of a 2D weight matrix. Additional matrices
-  // could be handled by stacking the packed buffers.
-  if (tensor_b.Shape().NumDimensions() != 2) {
+  packed_b_size = GemmPackBFp32Size(tensor_b.Shape(), trans_b);
+  if (packed_b_size == 0) {
     return false;
   }
   b_shape = tensor_b.Shape();
@@ -116,11 +128,6 @@ bool GemmPackBFp32(AllocatorPtr& alloc,
   const size_t K = trans_b ? static_cast<size_t>(b_shape[1]) : static_cast<size_t>(b_shape[0]);
   const size_t N = trans_b ? static_cast<size_t>(b_shape[0]) : static_cast<size_t>(b_shape[1]);
 
-  packed_b_size = MlasGemmPackBSize(N, K);
-  if (packed_b_size == 0) {
-    return false;
-  }
-
   packed_b = IAllocator::MakeUniquePtr<void>(alloc, packed_b_size, true);
   auto* packed_b_data = packed_b.get();
 
@@ -199,16 +206,27 @@ void Gemm<MLFloat16>::ComputeGemm(CBLAS_TRANSPOSE trans_a, CBLAS_TRANSPOSE trans
 
   if (c_data == nullptr)
     beta = onnxruntime::MLFloat16::Zero;
-#ifdef MLAS_F16VEC_INTRINSICS_SUPPORTED
+#if defined(MLAS_F16VEC_INTRINSICS_SUPPORTED) || defined(MLAS_TARGET_AMD64)
+  // The MLAS kernel adds a bias broadcast along the rows, the bias must be
+  // missing or a (N) or (1, N) vector.
   bool support_mlas = false;
   if (c_shape == nullptr) {
     support_mlas = true;
   } else if (c_shape->NumDimensions() == 1 && (*c_shape)[0] == N) {
     support_mlas = true;
-  } else if (c_shape->NumDimensions() == 2 && (((*c_shape)[0] == 1 && (*c_shape)[1] == N) || ((*c_shape)[0] == N && (*c_shape)[1] == 1))) {
+  } else if (c_shape->NumDimensions() == 2 && (*c_shape)[0] == 1 && (*c_shape)[1] == N) {
     support_mlas = true;
   }
-  if (trans_a == CblasNoTrans && trans_b == CblasNoTrans && support_mlas && alpha.ToFloat() == 1.0 && beta.ToFloat() == 1.0) {
+  if (MlasHalfGemmAccelerationSupported() && trans_a == CblasNoTrans && support_mlas &&
+      alpha.ToFloat() == 1.0f && (c_data == nullptr || beta.ToFloat() == 1.0f)) {
+    // The kernels only take B as a (K, N) row major matrix.
+    std::vector<MLFloat16> b_transposed;
+    if (trans_b != CblasNoTrans) {
+      b_transposed.resize(SafeInt<size_t>(K) * N);
+      MlasTranspose(b_data, b_transposed.data(), static_cast<size_t>(N), static_cast<size_t>(K));
+      b_data = b_transposed.data();
+    }
+
     MLAS_HALF_GEMM_DATA_PARAMS data;
     data.A = a_data;
     data.lda = K;
@@ -264,6 +282,10 @@ Status Gemm<float>::PrePack(const Tensor& tensor, int input_idx,
   if (input_idx == 1) {
     size_t packed_b_size;
     is_packed = GemmPackBFp32(alloc, tensor, trans_B_ != CblasNoTrans, packed_b_, packed_b_size, b_shape_);
+    if (is_packed) {
+      packed_b_size_ = packed_b_size;
+    }
+
     bool share_prepacked_weights = (prepacked_weights != nullptr);
     if (is_packed && share_prepacked_weights) {
       prepacked_weights->buffers_.push_back(std::move(packed_b_));
@@ -273,6 +295,33 @@ Status Gemm<float>::PrePack(const Tensor& tensor, int input_idx,
   return Status::OK();
 }
 
+template <>
+Status Gemm<MLFloat16>::PrePack(const Tensor& tensor, int input_idx,
+                                AllocatorPtr alloc, /*out*/ bool& is_packed,
+                                /*out*/ PrePackedWeights* prepacked_weights) {
+  is_packed = false;
+
+  // The half GEMM kernels only take B as a (K, N) row major matrix, so a constant B that is used transposed is
+  // transposed once here instead of on every run.
+  if (input_idx != 1 || trans_B_ == CblasNoTrans || tensor.Shape().NumDimensions() != 2) {
+    return Status::OK();
+  }
+
+  b_shape_ = tensor.Shape();
+  const size_t N = static_cast<size_t>(b_shape_[0]);
+  const size_t K = static_cast<size_t>(b_shape_[1]);
+  packed_b_size_ = SafeInt<size_t>(K) * N * sizeof(MLFloat16);
+  packed_b_ = IAllocator::MakeUniquePtr<void>(alloc, packed_b_size_, true);
+  MlasTranspose(tensor.Data<MLFloat16>(), static_cast<MLFloat16*>(packed_b_.get()), N, K);
+  is_packed = true;
+
+  if (prepacked_weights != nullptr) {
+    prepacked_weights->buffers_.push_back(std::move(packed_b_));
+    prepacked_weights->buffer_sizes_.push_back(packed_b_size_);
+  }
+  return Status::OK();
+}
+
 template <typename T>
 Status Gemm<T>::UseSharedPrePackedBuffers(std::vector<BufferUniquePtr>& /*prepacked_buffers*/,
                                           int /*input_idx*/,
@@ -294,6 +343,70 @@ Status Gemm<float>::UseSharedPrePackedBuffers(std::vector<BufferUniquePtr>& prep
   return Status::OK();
 }
 
+template <>
+Status Gemm<MLFloat16>::UseSharedPrePackedBuffers(std::vector<BufferUniquePtr>& prepacked_buffers,
+                                                  int input_idx,
+                                                  /*out*/ bool& used_shared_buffers) {
+  used_shared_buffers = false;
+
+  if (input_idx == 1) {
+    used_shared_buffers = true;
+    packed_b_ = std::move(prepacked_buffers[0]);
+  }
+  return Status::OK();
+}
+
+template <typename T>
+Status Gemm<T>::GetPrePackedBuffersToPersist(int /*input_idx*/,
+                                             /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const {
+  prepacked_buffers.clear();
+  return Status::OK();
+}
+
+template <>
+Status Gemm<float>::GetPrePackedBuffersToPersist(int input_idx,
+                                                 /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const {
+  prepacked_buffers.clear();
+
+  if (input_idx == 1 && packed_b_) {
+    prepacked_buffers.emplace_back(static_cast<const std::byte*>(packed_b_.get()), packed_b_size_);
+  }
+  return Status::OK();
+}
+
+template <typename T>
+Status Gemm<T>::UsePersistedPrePackedBuffers(const Tensor& /*tensor*/,
+                                             std::vector<BufferUniquePtr>& /*prepacked_buffers*/,
+                                             gsl::span<const size_t> /*prepacked_buffer_sizes*/,
+                                             int /*input_idx*/,
+                                             /*out*/ bool& used_persisted_buffers) {
+  used_persisted_buffers = false;
+  return Status::OK();
+}
+
+template <>
+Status Gemm<float>::UsePersistedPrePackedBuffers(const Tensor& tensor,
+                                                 std::vector<BufferUniquePtr>& prepacked_buffers,
+                                                 gsl::span<const size_t> prepacked_buffer_sizes,
+                                                 int input_idx,
+                                                 /*out*/ bool& used_persisted_buffers) {
+  used_persisted_buffers = false;
+
+  // PrePack() only packs a 2D matrix B into a single buffer
+  if (input_idx != 1 || prepacked_buffers.size() != 1) {
+    return Status::OK();
+  }
+
+  const size_t packed_b_size = GemmPackBFp32Size(tensor.Shape(), trans_B_ != CblasNoTrans);
+  if (packed_b_size != 0 && prepacked_buffer_sizes[0] == packed_b_size) {
+    used_persisted_buffers = true;
+    b_shape_ = tensor.Shape();
+    packed_b_ = std::move(prepacked_buffers[0]);
+    packed_b_size_ = packed_b_size;
+  }
+  return Status::OK();
+}
+
 template <typename T>
 void Gemm<T>::ComputeActivation(_Inout_updates_(y_size) T* y_data, ptrdiff_t y_size, _Inout_opt_ concurrency::ThreadPool* thread_pool) const {
   if (activation_) {
@@ -380,7 +493,10 @@ Status Gemm<MLFloat16>::Compute(OpKernelContext* context) const {
     ComputeGemm(trans_A_, trans_B_, M, N, K, static_cast<MLFloat16>(alpha_), A->Data<MLFloat16>(), B->Data<MLFloat16>(), static_cast<MLFloat16>(beta_),
                 c_data, c_shape, y_data, thread_pool);
   } else {
-    ORT_NOT_IMPLEMENTED("Prepacking of B is supported by MLAS half gemm API, but not implemented by this kernel yet");
+    // PrePack() stored the transposed B as a (K, N) row major matrix
+    ComputeGemm(trans_A_, CblasNoTrans, M, N, K, static_cast<MLFloat16>(alpha_),
+                A->Data<MLFloat16>(), static_cast<const MLFloat16*>(packed_b_.get()), static_cast<MLFloat16>(beta_),
+                c_data, c_shape, y_data, thread_pool);
   }
 
   ComputeActivation(y_data, SafeInt<size_t>(M) * N, thread_pool);
@@ -388,6 +504,39 @@ Status Gemm<MLFloat16>::Compute(OpKernelContext* context) const {
   return Status::OK();
 }
 
+template <>
+bool Gemm<float>::GetGemmEpilogue(ptrdiff_t M, ptrdiff_t N, float beta,
+                                  const float* c_data, const TensorShape* c_shape,
+                                  MLAS_SGEMM_EPILOGUE& epilogue) const {
+  if (mlas_activation_) {
+    epilogue.Activation = *mlas_activation_;
+  }
+
+  if (c_data == nullptr || beta == 0.0f) {
+    return true;
+  }
+
+  if (beta != 1.0f) {
+    return false;
+  }
+
+  // A (N) or (1, N) bias is added before the activation. A (M, N) matrix is added after the
+  // activation by the epilogue, which only matches the Gemm semantics without an activation.
+  const size_t num_dims = c_shape->NumDimensions();
+  if ((num_dims == 1 && (*c_shape)[0] == N) || (num_dims == 2 && (*c_shape)[0] == 1 && (*c_shape)[1] == N)) {
+    epilogue.Bias = c_data;
+    return true;
+  }
+
+  if (num_dims == 2 && (*c_shape)[0] == M && (*c_shape)[1] == N && !mlas_activation_) {
+    epilogue.Residual = c_data;
+    epilogue.ldr = static_cast<size_t>(N);
+    return true;
+  }
+
+  return false;
+}
+
 template <>
 Status Gemm<float>::Compute(OpKernelContext* context) const {
   concurrency::ThreadPool* thread_pool = context->GetOperatorThreadPool();
@@ -418,6 +567,31 @@ Status Gemm<float>::Compute(OpKernelContext* context) const {
   const float* c_data = C != nullptr ? C->Data<float>() : nullptr;
   const TensorShape* c_shape = C != nullptr ? &C->Shape() : nullptr;
 
+  // Apply the bias, the activation or a full C matrix in the MLAS epilogue while each block of Y
+  // is still in the cache, instead of broadcasting C into Y first and running the activation as a
+  // separate pass.
+  MLAS_SGEMM_EPILOGUE epilogue;
+  if (K > 0 && !activation_ && GetGemmEpilogue(M, N, beta_, c_data, c_shape, epilogue)) {
+    MLAS_SGEMM_DATA_PARAMS data;
+    data.A = A->Data<float>();
+    data.lda = static_cast<size_t>(trans_A_ != CblasNoTrans ? M : K);
+    if (B) {
+      data.B = B->Data<float>();
+      data.ldb = static_cast<size_t>(trans_B_ != CblasNoTrans ? K : N);
+    } else {
+      data.B = static_cast<const float*>(packed_b_.get());
+      data.BIsPacked = true;
+    }
+    data.C = y_data;
+    data.ldc = static_cast<size_t>(N);
+    data.alpha = alpha_;
+    data.beta = 0.0f;
+    data.Epilogue = &epilogue;
+    MlasGemmBatch(trans_A_, trans_B_, static_cast<size_t>(M), static_cast<size_t>(N), static_cast<size_t>(K),
+                  &data, 1, thread_pool);
+    return Status::OK();
+  }
+
   if (B) {
     ComputeGemm(trans_A_, trans_B_, M, N, K, alpha_, A->Data<float>(), B->Data<float>(), beta_,
                 c_data, c_shape, y_data, thread_pool);
@@ -443,7 +617,18 @@ Status Gemm<float>::Compute(OpKernelContext* context) const {
     }
   }
 
-  ComputeActivation(y_data, SafeInt<size_t>(M) * N, thread_pool);
+  if (mlas_activation_) {
+    const MLAS_ACTIVATION* activation = &*mlas_activation_;
+    concurrency::ThreadPool::TryParallelFor(
+        thread_pool, M,
+        {static_cast<double>(N * sizeof(float)), static_cast<double>(N * sizeof(float)), static_cast<double>(N) * 4.0},
+        [activation, y_data, N](std::ptrdiff_t first, std::ptrdiff_t last) {
+          const size_t count = static_cast<size_t>((last - first) * N);
+          MlasActivation(activation, y_data + first * N, nullptr, 1, count, count);
+        });
+  } else {
+    ComputeActivation(y_data, SafeInt<size_t>(M) * N, thread_pool);
+  }
 
   return Status::OK();
 }
@@ -3,11 +3,14 @@
 
 #pragma once
 
+#include <optional>
+
 #include "gemm_base.h"
 
 #include "core/framework/op_kernel.h"
 #include "core/common/common.h"
 #include "core/util/math.h"
+#include "core/mlas/inc/mlas.h"
 #include "core/providers/cpu/activation/activations.h"
 
 namespace onnxruntime {
@@ -28,6 +31,13 @@ class Gemm : protected GemmBase, public OpKernel {
                                    int input_idx,
                                    /*out*/ bool& used_shared_buffers) override;
 
+  Status GetPrePackedBuffersToPersist(int input_idx,
+                                      /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const override;
+
+  Status UsePersistedPrePackedBuffers(const Tensor& tensor, std::vector<BufferUniquePtr>& prepacked_buffers,
+                                      gsl::span<const size_t> prepacked_buffer_sizes,
+                                      int input_idx, /*out*/ bool& used_persisted_buffers) override;
+
   static void ComputeGemm(CBLAS_TRANSPOSE trans_a, CBLAS_TRANSPOSE trans_b,
                           ptrdiff_t M, ptrdiff_t N, ptrdiff_t K,
                           T alpha,
@@ -40,11 +50,21 @@ class Gemm : protected GemmBase, public OpKernel {
  protected:
   TensorShape b_shape_;
   IAllocatorUniquePtr<void> packed_b_;
+  size_t packed_b_size_ = 0;
 
   // For fused gemm + activation
   std::unique_ptr<functors::ElementWiseRangedTransform<T>> activation_;
 
+  // For fused gemm + activation when the activation is applied by the MLAS GEMM epilogue.
+  // Only used by the float kernel, activation_ is empty when this is set.
+  std::optional<MLAS_ACTIVATION> mlas_activation_;
+
   void ComputeActivation(_Inout_updates_(y_size) T* y_data, ptrdiff_t y_size, _Inout_opt_ concurrency::ThreadPool* thread_pool) const;
+
+  // Describes the bias, activation and C matrix handled by the MLAS epilogue, returns false if
+  // they cannot be fused into the GEMM.
+  bool GetGemmEpilogue(ptrdiff_t M, ptrdiff_t N, T beta, const T* c_data, const TensorShape* c_shape,
+                       MLAS_SGEMM_EPILOGUE& epilogue) const;
 };
 
 }  // namespace onnxruntime
@@ -7,6 +7,9 @@
 
 namespace onnxruntime {
 
+// Size of the buffer GemmPackBFp32() packs tensor_b into, 0 if it does not pack tensor_b.
+size_t GemmPackBFp32Size(const TensorShape& b_shape, bool trans_b);
+
 bool GemmPackBFp32(AllocatorPtr& alloc,
                    const Tensor& tensor_b,
                    bool trans_b,
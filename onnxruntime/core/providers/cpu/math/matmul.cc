@@ -133,7 +133,79 @@ Status MatMul<T>::Compute(OpKernelContext* ctx) const {
 
   return Status::OK();
 }
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(MLAS_F16VEC_INTRINSICS_SUPPORTED) || defined(MLAS_TARGET_AMD64)
+// The fp16 kernels are only registered when MlasHalfGemmAccelerationSupported(),
+// so that the inputs stay in half precision instead of being cast to fp32.
+template <>
+Status MatMul<MLFloat16>::Compute(OpKernelContext* ctx) const {
+  concurrency::ThreadPool* thread_pool = ctx->GetOperatorThreadPool();
+
+  const auto* a = ctx->Input<Tensor>(0);
+  const auto* b = ctx->Input<Tensor>(1);
+
+  MatMulComputeHelper helper;
+  ORT_RETURN_IF_ERROR(helper.Compute(a->Shape(), b->Shape()));
+  Tensor* y = ctx->Output(0, helper.OutputShape());
+
+  // Bail out early if the output is going to be empty
+  if (y->Shape().Size() == 0)
+    return Status::OK();
+
+  auto* y_data = y->MutableData<MLFloat16>();
+
+  if (helper.K() == 0) {
+    // When we have (M, 0, N) then the inputs are empty, but the output should
+    // be filled out with zeros.
+    std::fill_n(y_data, y->Shape().Size(), MLFloat16::Zero);
+    return Status::OK();
+  }
+
+  const auto* a_data = a->Data<MLFloat16>();
+  const auto* b_data = b->Data<MLFloat16>();
+
+  const size_t max_len = helper.OutputOffsets().size();
+  const size_t M = static_cast<size_t>(helper.M());
+  const size_t N = static_cast<size_t>(helper.N());
+  const size_t K = static_cast<size_t>(helper.K());
+
+  std::vector<MLAS_HALF_GEMM_DATA_PARAMS> data(max_len);
+  for (size_t i = 0; i < max_len; i++) {
+    data[i].A = a_data + helper.LeftOffsets()[i];
+    data[i].lda = K;
+    data[i].B = b_data + helper.RightOffsets()[i];
+    data[i].ldb = N;
+    data[i].C = y_data + helper.OutputOffsets()[i];
+    data[i].ldc = N;
+  }
+  MlasHalfGemmBatch(M, N, K, max_len, data.data(), thread_pool);
+
+  return Status::OK();
+}
+
+ONNX_CPU_OPERATOR_VERSIONED_TYPED_KERNEL(
+    MatMul,
+    1, 8,
+    MLFloat16,
+    KernelDefBuilder().TypeConstraint("T", DataTypeImpl::GetTensorType<MLFloat16>()),
+    MatMul<MLFloat16>);
+
+ONNX_CPU_OPERATOR_VERSIONED_TYPED_KERNEL(
+    MatMul,
+    9,
+    12,
+    MLFloat16,
+    KernelDefBuilder().TypeConstraint("T", DataTypeImpl::GetTensorType<MLFloat16>()),
+    MatMul<MLFloat16>);
+
+ONNX_CPU_OPERATOR_TYPED_KERNEL(
+    MatMul,
+    13,
+    MLFloat16,
+    KernelDefBuilder().TypeConstraint("T", DataTypeImpl::GetTensorType<MLFloat16>()),
+    MatMul<MLFloat16>);
+#endif
+
+#if defined(MLAS_SBGEMM_SUPPORTED)
 bool GemmPackBBfloat16(AllocatorPtr& alloc,
                        const Tensor& tensor_b,
                        bool trans_b,
@@ -180,7 +252,7 @@ Status MatMul<float>::PrePack(const Tensor& tensor, int input_idx, /*out*/ Alloc
   // only pack Matrix B
   if (input_idx == 1) {
     size_t packed_b_size;
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(MLAS_SBGEMM_SUPPORTED)
     size_t dim1 = 0;
     size_t dim2 = 0;
     TensorShape b_shape = tensor.Shape();
@@ -198,6 +270,10 @@ Status MatMul<float>::PrePack(const Tensor& tensor, int input_idx, /*out*/ Alloc
       is_packed = GemmPackBFp32(alloc, tensor, trans_b_attr_ != 0, packed_b_, packed_b_size, b_shape_);
     }
 
+    if (is_packed) {
+      packed_b_size_ = packed_b_size;
+    }
+
     bool share_prepacked_weights = (prepacked_weights != nullptr);
     if (is_packed && share_prepacked_weights) {
       prepacked_weights->buffers_.push_back(std::move(packed_b_));
@@ -220,6 +296,51 @@ Status MatMul<float>::UseSharedPrePackedBuffers(std::vector<BufferUniquePtr>& pr
   return Status::OK();
 }
 
+Status MatMul<float>::GetPrePackedBuffersToPersist(int input_idx,
+                                                   /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const {
+  prepacked_buffers.clear();
+
+  if (input_idx == 1 && packed_b_) {
+    prepacked_buffers.emplace_back(static_cast<const std::byte*>(packed_b_.get()), packed_b_size_);
+  }
+
+  return Status::OK();
+}
+
+Status MatMul<float>::UsePersistedPrePackedBuffers(const Tensor& tensor,
+                                                   std::vector<BufferUniquePtr>& prepacked_buffers,
+                                                   gsl::span<const size_t> prepacked_buffer_sizes,
+                                                   int input_idx,
+                                                   /*out*/ bool& used_persisted_buffers) {
+  used_persisted_buffers = false;
+
+  // PrePack() only packs a 2D matrix B into a single buffer
+  if (input_idx != 1 || prepacked_buffers.size() != 1) {
+    return Status::OK();
+  }
+
+  // the size of the buffer PrePack() would have packed for this weight
+  size_t packed_b_size = 0;
+#if defined(MLAS_SBGEMM_SUPPORTED)
+  const auto& b_shape = tensor.Shape();
+  if (use_fastmath_mode_ && (trans_b_attr_ == 0) && b_shape.NumDimensions() == 2 &&
+      (static_cast<size_t>(b_shape[0]) * static_cast<size_t>(b_shape[1])) >= kFastMathModeKernelsizeThreshold) {
+    packed_b_size = MlasSBGemmPackBSize(static_cast<size_t>(b_shape[1]), static_cast<size_t>(b_shape[0]));
+  } else
+#endif
+  {
+    packed_b_size = GemmPackBFp32Size(tensor.Shape(), trans_b_attr_ != 0);
+  }
+  if (packed_b_size != 0 && prepacked_buffer_sizes[0] == packed_b_size) {
+    used_persisted_buffers = true;
+    b_shape_ = tensor.Shape();
+    packed_b_ = std::move(prepacked_buffers[0]);
+    packed_b_size_ = packed_b_size;
+  }
+
+  return Status::OK();
+}
+
 Status MatMul<float>::Compute(OpKernelContext* ctx) const {
   concurrency::ThreadPool* thread_pool = ctx->GetOperatorThreadPool();
 
@@ -258,7 +379,7 @@ Status MatMul<float>::Compute(OpKernelContext* ctx) const {
   const size_t K = static_cast<size_t>(helper.K());
   const size_t lda = helper.Lda(trans_a);
   const size_t ldb = helper.Ldb(trans_b);
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(MLAS_SBGEMM_SUPPORTED)
   if (use_fastmath_mode_ && !trans_b && ((N * K) >= kFastMathModeKernelsizeThreshold)) {
     std::vector<MLAS_SBGEMM_DATA_PARAMS> data(max_len);
     for (size_t i = 0; i < max_len; i++) {
@@ -30,9 +30,15 @@ class MatMul<float> final : public OpKernel {
     trans_batch_a_ = trans_batch_a_attr != 0;
     trans_batch_b_ = trans_batch_b_attr != 0;
 
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(MLAS_SBGEMM_SUPPORTED)
+#if defined(MLAS_TARGET_ARM64)
     auto config_ops = info.GetConfigOptions().GetConfigEntry(kOrtSessionOptionsMlasGemmFastMathArm64Bfloat16);
-    use_fastmath_mode_ = (config_ops == "1") && MlasBf16AccelerationSupported();
+#else
+    auto config_ops = info.GetConfigOptions().GetConfigEntry(kOrtSessionOptionsMlasGemmFastMathX64Bfloat16);
+#endif
+    // The bfloat16 kernels neither transpose A nor scale the product (FusedMatMul attributes).
+    use_fastmath_mode_ = (config_ops == "1") && trans_a_attr_ == 0 && alpha_attr_ == 1.0f &&
+                         MlasBf16AccelerationSupported();
 #endif
   }
 
@@ -43,11 +49,19 @@ class MatMul<float> final : public OpKernel {
   Status UseSharedPrePackedBuffers(std::vector<BufferUniquePtr>& prepacked_buffers, int input_idx,
                                    /*out*/ bool& used_shared_buffers) override;
 
+  Status GetPrePackedBuffersToPersist(int input_idx,
+                                      /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const override;
+
+  Status UsePersistedPrePackedBuffers(const Tensor& tensor, std::vector<BufferUniquePtr>& prepacked_buffers,
+                                      gsl::span<const size_t> prepacked_buffer_sizes,
+                                      int input_idx, /*out*/ bool& used_persisted_buffers) override;
+
   Status Compute(OpKernelContext* context) const override;
 
  private:
   TensorShape b_shape_;
   IAllocatorUniquePtr<void> packed_b_;
+  size_t packed_b_size_ = 0;
 
   // For FusedMatMul contrib ops
   float alpha_attr_;
@@ -56,11 +70,12 @@ class MatMul<float> final : public OpKernel {
   bool trans_batch_a_;
   bool trans_batch_b_;
 
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(MLAS_SBGEMM_SUPPORTED)
   // fastmath mode state
   bool use_fastmath_mode_;
-  // sbgemm kernel is implemented as 8x8 blocks with weights pre-packed to 4 blocks of 4x2
-  // so a minimum of 32 elements is defined to outweigh the additional prepacking overhead
+  // sbgemm kernel is implemented as 8x8 blocks with weights pre-packed to 4 blocks of 4x2 on arm64
+  // (16 columns by pairs of rows on x64) so a minimum of 32 elements is defined to outweigh the
+  // additional prepacking overhead
   const size_t kFastMathModeKernelsizeThreshold = 32;
 #endif
 };
@@ -5,9 +5,12 @@
 
 #include <mutex>
 #include "core/platform/threadpool.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 #include "tree_ensemble_helper.h"
 #include "tree_ensemble_attribute.h"
 #include "tree_ensemble_aggregator.h"
+#include "tree_ensemble_flat_layout.h"
+#include "tree_ensemble_quickscorer.h"
 
 namespace onnxruntime {
 namespace ml {
@@ -53,6 +56,11 @@ class TreeEnsembleCommon : public TreeEnsembleCommonAttributes {
   // `ThresholdType` is used as well for output type (double as well for lightgbm) and not `OutputType`.
   std::vector<SparseValue<ThresholdType>> weights_;
   std::vector<TreeNodeElement<ThresholdType>*> roots_;
+  // Used instead of ProcessTreeNodeLeave when the trees fit, quick_scorer_ is preferred over flat_layout_.
+  TreeEnsembleQuickScorer<ThresholdType> quick_scorer_;
+  TreeEnsembleFlatLayout<ThresholdType> flat_layout_;
+  bool use_quick_scorer_ = true;
+  bool use_flat_layout_ = true;
 
  public:
   TreeEnsembleCommon() {}
@@ -72,6 +80,17 @@ class TreeEnsembleCommon : public TreeEnsembleCommonAttributes {
   template <typename AGG>
   void ComputeAgg(concurrency::ThreadPool* ttp, const Tensor* X, Tensor* Y, Tensor* label, const AGG& agg) const;
 
+  template <bool single_target, typename Engine, typename AGG>
+  void ComputeAggBlocked(concurrency::ThreadPool* ttp, const Engine& engine, const InputType* x_data,
+                         OutputType* z_data, int64_t* label_data, int64_t N, int64_t stride, const AGG& agg) const;
+
+  void ReadSessionConfig(const OpKernelInfo& info) {
+    use_quick_scorer_ = info.GetConfigOptions().GetConfigOrDefault(
+                            kOrtSessionOptionsTreeEnsembleQuickScorer, "1") != "0";
+    use_flat_layout_ = info.GetConfigOptions().GetConfigOrDefault(
+                           kOrtSessionOptionsTreeEnsembleFlatLayout, "1") != "0";
+  }
+
  private:
   bool CheckIfSubtreesAreEqual(const size_t left_id, const size_t right_id, const int64_t tree_id, const InlinedVector<NODE_MODE_ONNX>& cmodes,
                                const InlinedVector<size_t>& truenode_ids, const InlinedVector<size_t>& falsenode_ids, gsl::span<const int64_t> nodes_featureids,
@@ -118,6 +137,7 @@ std::conditional_t<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t> bit_cast_i
 template <typename InputType, typename ThresholdType, typename OutputType>
 Status TreeEnsembleCommon<InputType, ThresholdType, OutputType>::Init(const OpKernelInfo& info) {
   TreeEnsembleAttributesV3<ThresholdType> attributes(info, false);
+  ReadSessionConfig(info);
   return Init(80, 128, 50, attributes);
 }
 
@@ -288,6 +308,13 @@ Status TreeEnsembleCommon<InputType, ThresholdType, OutputType>::Init(
     }
   }
 
+  // If the trees fit neither engine, both stay disabled and trees are walked by ProcessTreeNodeLeave.
+  if (!use_quick_scorer_ || !quick_scorer_.Init(nodes_, roots_)) {
+    if (use_flat_layout_) {
+      flat_layout_.Init(nodes_, roots_, has_missing_tracks_);
+    }
+  }
+
   return Status::OK();
 }
 
@@ -481,6 +508,23 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
   int64_t* label_data = label == nullptr ? nullptr : label->MutableData<int64_t>();
   auto max_num_threads = concurrency::ThreadPool::DegreeOfParallelism(ttp);
 
+  if (quick_scorer_.IsEnabled()) {
+    if (n_targets_or_classes_ == 1) {
+      ComputeAggBlocked<true>(ttp, quick_scorer_, x_data, z_data, label_data, N, stride, agg);
+    } else {
+      ComputeAggBlocked<false>(ttp, quick_scorer_, x_data, z_data, label_data, N, stride, agg);
+    }
+    return;
+  }
+  if (flat_layout_.IsEnabled()) {
+    if (n_targets_or_classes_ == 1) {
+      ComputeAggBlocked<true>(ttp, flat_layout_, x_data, z_data, label_data, N, stride, agg);
+    } else {
+      ComputeAggBlocked<false>(ttp, flat_layout_, x_data, z_data, label_data, N, stride, agg);
+    }
+    return;
+  }
+
   if (n_targets_or_classes_ == 1) {
     if (N == 1) {
       ScoreValue<ThresholdType> score = {0, 0};
@@ -695,6 +739,131 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
   }
 }  // namespace detail
 
+template <typename InputType, typename ThresholdType, typename OutputType>
+template <bool single_target, typename Engine, typename AGG>
+void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAggBlocked(
+    concurrency::ThreadPool* ttp, const Engine& engine, const InputType* x_data, OutputType* z_data,
+    int64_t* label_data, int64_t N, int64_t stride, const AGG& agg) const {
+  using ScoreType = std::conditional_t<single_target, ScoreValue<ThresholdType>,
+                                       InlinedVector<ScoreValue<ThresholdType>>>;
+  using Scratch = typename Engine::Scratch;
+  const int64_t row_block_size = static_cast<int64_t>(Engine::kRowBlockSize);
+  // A thread is only started if it evaluates at least that many (tree, row) pairs.
+  const int64_t min_tree_rows_per_thread = 1024;
+
+  auto reset_scores = [&](ScoreType* scores, int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      if constexpr (single_target) {
+        scores[i] = {0, 0};
+      } else {
+        scores[i].assign(onnxruntime::narrow<size_t>(n_targets_or_classes_), {0, 0});
+      }
+    }
+  };
+  auto finalize_score = [&](int64_t i, ScoreType& score) {
+    if constexpr (single_target) {
+      agg.FinalizeScores1(z_data + i, score, label_data == nullptr ? nullptr : (label_data + i));
+    } else {
+      agg.FinalizeScores(score, z_data + i * n_targets_or_classes_, -1,
+                         label_data == nullptr ? nullptr : (label_data + i));
+    }
+  };
+  // Adds the predictions of tree blocks [block_begin, block_end) on rows [row_begin, row_end) to
+  // scores[0, row_end - row_begin). Every row visits the trees in the same order as ProcessTreeNodeLeave.
+  auto process_rows = [&](int64_t row_begin, int64_t row_end, size_t block_begin, size_t block_end,
+                          ScoreType* scores) {
+    Scratch scratch;
+    for (int64_t batch = row_begin; batch < row_end; batch += row_block_size) {
+      size_t n_rows = static_cast<size_t>(std::min(row_end - batch, row_block_size));
+      ScoreType* batch_scores = scores + (batch - row_begin);
+      for (size_t b = block_begin; b < block_end; ++b) {
+        engine.ComputeLeaves(b, x_data + batch * stride, stride, n_rows, scratch);
+        for (size_t t = 0, n_trees = engine.TreeBlockSize(b); t < n_trees; ++t) {
+          const TreeNodeElement<ThresholdType>* const* leaves = scratch.leaves.data() + t * Engine::kRowBlockSize;
+          for (size_t r = 0; r < n_rows; ++r) {
+            if constexpr (single_target) {
+              agg.ProcessTreeNodePrediction1(batch_scores[r], *leaves[r]);
+            } else {
+              agg.ProcessTreeNodePrediction(batch_scores[r], *leaves[r], weights_);
+            }
+          }
+        }
+      }
+    }
+  };
+
+  // The number of threads follows the amount of work (trees x rows). Rows are split first. Trees are split
+  // only when there are not enough blocks of rows for every thread since partial scores must then be merged.
+  const int64_t n_row_blocks = (N + row_block_size - 1) / row_block_size;
+  const int64_t n_tree_blocks = static_cast<int64_t>(engine.NumTreeBlocks());
+  int64_t num_threads = std::min<int64_t>(concurrency::ThreadPool::DegreeOfParallelism(ttp),
+                                          std::max<int64_t>(1, N * n_trees_ / min_tree_rows_per_thread));
+  num_threads = std::min(num_threads, n_row_blocks * n_tree_blocks);
+  const int64_t row_groups = std::max<int64_t>(1, std::min(n_row_blocks, num_threads));
+  const int64_t tree_groups = std::min(n_tree_blocks, num_threads / row_groups);
+
+  if (num_threads <= 1) { /* no parallelization */
+    std::vector<ScoreType> scores(onnxruntime::narrow<size_t>(N));
+    reset_scores(scores.data(), N);
+    process_rows(0, N, 0, static_cast<size_t>(n_tree_blocks), scores.data());
+    for (int64_t i = 0; i < N; ++i) {
+      finalize_score(i, scores[SafeInt<ptrdiff_t>(i)]);
+    }
+  } else if (tree_groups <= 1) { /* parallelization by rows */
+    concurrency::ThreadPool::TrySimpleParallelFor(
+        ttp,
+        onnxruntime::narrow<ptrdiff_t>(row_groups),
+        [&](ptrdiff_t batch_num) {
+          auto work = concurrency::ThreadPool::PartitionWork(batch_num, onnxruntime::narrow<ptrdiff_t>(row_groups),
+                                                             onnxruntime::narrow<ptrdiff_t>(n_row_blocks));
+          int64_t row_begin = work.start * row_block_size;
+          int64_t row_end = std::min(N, work.end * row_block_size);
+          std::vector<ScoreType> scores(static_cast<size_t>(row_end - row_begin));
+          reset_scores(scores.data(), row_end - row_begin);
+          process_rows(row_begin, row_end, 0, static_cast<size_t>(n_tree_blocks), scores.data());
+          for (int64_t i = row_begin; i < row_end; ++i) {
+            finalize_score(i, scores[SafeInt<ptrdiff_t>(i - row_begin)]);
+          }
+        });
+  } else { /* parallelization by rows and trees */
+    std::vector<ScoreType> scores(SafeInt<size_t>(tree_groups) * N);
+    concurrency::ThreadPool::TrySimpleParallelFor(
+        ttp,
+        onnxruntime::narrow<ptrdiff_t>(row_groups * tree_groups),
+        [&](ptrdiff_t batch_num) {
+          auto row_work = concurrency::ThreadPool::PartitionWork(
+              batch_num % row_groups, onnxruntime::narrow<ptrdiff_t>(row_groups),
+              onnxruntime::narrow<ptrdiff_t>(n_row_blocks));
+          auto tree_work = concurrency::ThreadPool::PartitionWork(
+              batch_num / row_groups, onnxruntime::narrow<ptrdiff_t>(tree_groups),
+              onnxruntime::narrow<ptrdiff_t>(n_tree_blocks));
+          int64_t row_begin = row_work.start * row_block_size;
+          int64_t row_end = std::min(N, row_work.end * row_block_size);
+          ScoreType* group_scores = scores.data() + (batch_num / row_groups) * N + row_begin;
+          reset_scores(group_scores, row_end - row_begin);
+          process_rows(row_begin, row_end, static_cast<size_t>(tree_work.start), static_cast<size_t>(tree_work.end),
+                       group_scores);
+        });
+    concurrency::ThreadPool::TrySimpleParallelFor(
+        ttp,
+        onnxruntime::narrow<ptrdiff_t>(row_groups),
+        [&](ptrdiff_t batch_num) {
+          auto work = concurrency::ThreadPool::PartitionWork(batch_num, onnxruntime::narrow<ptrdiff_t>(row_groups),
+                                                             onnxruntime::narrow<ptrdiff_t>(N));
+          for (auto i = work.start; i < work.end; ++i) {
+            for (int64_t j = 1; j < tree_groups; ++j) {
+              if constexpr (single_target) {
+                agg.MergePrediction1(scores[i], scores[j * SafeInt<ptrdiff_t>(N) + i]);
+              } else {
+                agg.MergePrediction(scores[i], scores[j * SafeInt<ptrdiff_t>(N) + i]);
+              }
+            }
+            finalize_score(i, scores[i]);
+          }
+        });
+  }
+}
+
 #define TREE_FIND_VALUE(CMP)                                                                           \
   if (has_missing_tracks_) {                                                                           \
     while (root->is_not_leaf()) {                                                                      \
@@ -839,6 +1008,7 @@ class TreeEnsembleCommonClassifier : public TreeEnsembleCommon<InputType, Thresh
 template <typename InputType, typename ThresholdType, typename OutputType>
 Status TreeEnsembleCommonClassifier<InputType, ThresholdType, OutputType>::Init(const OpKernelInfo& info) {
   TreeEnsembleAttributesV3<ThresholdType> attributes(info, true);
+  this->ReadSessionConfig(info);
   return Init(80, 128, 50, attributes);
 }
 
@@ -919,6 +1089,7 @@ class TreeEnsembleCommonV5 : public TreeEnsembleCommon<IOType, ThresholdType, IO
 template <typename IOType, typename ThresholdType>
 Status TreeEnsembleCommonV5<IOType, ThresholdType>::Init(const OpKernelInfo& info) {
   TreeEnsembleAttributesV5<ThresholdType> attributes(info);
+  this->ReadSessionConfig(info);
   return Init(80, 128, 50, attributes);
 }
 
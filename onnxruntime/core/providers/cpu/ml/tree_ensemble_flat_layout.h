@@ -0,0 +1,283 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <vector>
+#include "tree_ensemble_aggregator.h"
+
+namespace onnxruntime {
+namespace ml {
+namespace detail {
+
+/**
+ * Flattened copy of the trees used when TreeEnsembleQuickScorer cannot handle the ensemble (deeper trees,
+ * or rules other than BRANCH_LEQ and BRANCH_LT).
+ *
+ * The nodes of every tree are renumbered breadth first and stored as a structure of arrays (feature, threshold,
+ * child), so that the upper levels of every tree share a few cache lines. The true child and the false child of a
+ * node are stored next to each other and only the index of the true child is kept. Leaves are copied into a
+ * separate compact array and are referenced by a negative child index.
+ *
+ * Trees are grouped in blocks of about kTreeBlockNodes nodes. Every tree of a block is evaluated on
+ * kRowBlockSize rows at once: the rows advance one level per iteration, which keeps several independent loads in
+ * flight instead of waiting on the node fetched for a single row. The comparison rule is a template parameter
+ * so that each rule gets its own specialized loop.
+ *
+ * Only ensembles where every internal node uses the same rule (other than BRANCH_MEMBER) and no subtree is
+ * shared between two parents can be handled. `Init` returns false otherwise.
+ */
+template <typename ThresholdType>
+class TreeEnsembleFlatLayout {
+ public:
+  static constexpr size_t kRowBlockSize = 8;
+  static constexpr size_t kTreeBlockNodes = 1 << 14;
+
+  // Per thread buffers used by ComputeLeaves.
+  struct Scratch {
+    std::vector<const TreeNodeElement<ThresholdType>*> leaves;
+  };
+
+  bool Init(const std::vector<TreeNodeElement<ThresholdType>>& nodes,
+            const std::vector<TreeNodeElement<ThresholdType>*>& roots, bool has_missing_tracks);
+
+  bool IsEnabled() const { return enabled_; }
+  size_t NumTreeBlocks() const { return blocks_.size(); }
+  size_t TreeBlockBegin(size_t block) const { return blocks_[block].tree_begin; }
+  size_t TreeBlockSize(size_t block) const { return blocks_[block].n_trees; }
+
+  // Computes the leaf of every tree of a block for n_rows <= kRowBlockSize consecutive rows.
+  // The leaf of tree `t` (relative to the block) for row `r` is stored in scratch.leaves[t * kRowBlockSize + r].
+  template <typename InputType>
+  void ComputeLeaves(size_t block, const InputType* x_data, int64_t stride, size_t n_rows, Scratch& scratch) const;
+
+ private:
+  struct TreeBlock {
+    size_t tree_begin;
+    size_t n_trees;
+  };
+
+  template <typename InputType, typename Compare, bool has_missing_tracks>
+  void ComputeLeaves(size_t block, const InputType* x_data, int64_t stride, size_t n_rows, Scratch& scratch) const;
+
+  void Clear();
+
+  bool enabled_ = false;
+  bool has_missing_tracks_ = false;
+  NODE_MODE_ORT mode_ = NODE_MODE_ORT::LEAF;
+  std::vector<TreeBlock> blocks_;
+  std::vector<int32_t> roots_;
+  // Indexed by node. A non negative child is the index of the true child, the false child follows it.
+  // A negative child marks a leaf, its copy is leaves_[-child - 1].
+  std::vector<int32_t> features_;
+  std::vector<ThresholdType> thresholds_;
+  std::vector<int32_t> children_;
+  std::vector<uint8_t> missing_track_true_;
+  std::vector<TreeNodeElement<ThresholdType>> leaves_;
+};
+
+namespace flat_layout {
+
+struct LEQ {
+  template <typename T1, typename T2>
+  bool operator()(T1 val, T2 threshold) const { return val <= threshold; }
+};
+struct LT {
+  template <typename T1, typename T2>
+  bool operator()(T1 val, T2 threshold) const { return val < threshold; }
+};
+struct GTE {
+  template <typename T1, typename T2>
+  bool operator()(T1 val, T2 threshold) const { return val >= threshold; }
+};
+struct GT {
+  template <typename T1, typename T2>
+  bool operator()(T1 val, T2 threshold) const { return val > threshold; }
+};
+struct EQ {
+  template <typename T1, typename T2>
+  bool operator()(T1 val, T2 threshold) const { return val == threshold; }
+};
+struct NEQ {
+  template <typename T1, typename T2>
+  bool operator()(T1 val, T2 threshold) const { return val != threshold; }
+};
+
+}  // namespace flat_layout
+
+template <typename ThresholdType>
+void TreeEnsembleFlatLayout<ThresholdType>::Clear() {
+  enabled_ = false;
+  blocks_.clear();
+  roots_.clear();
+  features_.clear();
+  thresholds_.clear();
+  children_.clear();
+  missing_track_true_.clear();
+  leaves_.clear();
+}
+
+template <typename ThresholdType>
+bool TreeEnsembleFlatLayout<ThresholdType>::Init(const std::vector<TreeNodeElement<ThresholdType>>& nodes,
+                                                  const std::vector<TreeNodeElement<ThresholdType>*>& roots,
+                                                  bool has_missing_tracks) {
+  Clear();
+  if (roots.empty() || nodes.size() >= static_cast<size_t>(std::numeric_limits<int32_t>::max())) return false;
+
+  mode_ = NODE_MODE_ORT::LEAF;
+  for (const auto& node : nodes) {
+    if (!node.is_not_leaf()) continue;
+    if (mode_ == NODE_MODE_ORT::LEAF) mode_ = node.mode();
+    if (node.mode() != mode_ || node.mode() == NODE_MODE_ORT::BRANCH_MEMBER) return false;
+  }
+  has_missing_tracks_ = has_missing_tracks;
+
+  const TreeNodeElement<ThresholdType>* base = nodes.data();
+  std::vector<uint8_t> visited(nodes.size(), 0);
+  std::deque<const TreeNodeElement<ThresholdType>*> queue;
+  features_.reserve(nodes.size());
+  thresholds_.reserve(nodes.size());
+  children_.reserve(nodes.size());
+  missing_track_true_.reserve(has_missing_tracks ? nodes.size() : 0);
+  roots_.reserve(roots.size());
+
+  auto add_node = [&](const TreeNodeElement<ThresholdType>* node) -> bool {
+    size_t pos = static_cast<size_t>(node - base);
+    if (visited[pos]) return false;
+    visited[pos] = 1;
+    queue.push_back(node);
+    return true;
+  };
+
+  size_t block_nodes = 0;
+  for (size_t t = 0; t < roots.size(); ++t) {
+    // Nodes are numbered in the order they are pushed into the queue.
+    int32_t next_index = static_cast<int32_t>(children_.size()) + 1;
+    roots_.push_back(static_cast<int32_t>(children_.size()));
+    size_t tree_begin = children_.size();
+    if (!add_node(roots[t])) {
+      Clear();
+      return false;
+    }
+    while (!queue.empty()) {
+      const TreeNodeElement<ThresholdType>* node = queue.front();
+      queue.pop_front();
+      if (node->is_not_leaf()) {
+        features_.push_back(node->feature_id);
+        thresholds_.push_back(node->value_or_unique_weight);
+        children_.push_back(next_index);
+        if (has_missing_tracks) missing_track_true_.push_back(node->is_missing_track_true() ? 1 : 0);
+        if (!add_node(node->truenode_or_weight.ptr) || !add_node(node + 1)) {
+          // Subtrees shared by several parents (see AddNodes) break the layout.
+          Clear();
+          return false;
+        }
+        next_index += 2;
+      } else {
+        features_.push_back(0);
+        thresholds_.push_back(node->value_or_unique_weight);
+        children_.push_back(-static_cast<int32_t>(leaves_.size()) - 1);
+        if (has_missing_tracks) missing_track_true_.push_back(0);
+        leaves_.push_back(*node);
+      }
+    }
+
+    size_t tree_nodes = children_.size() - tree_begin;
+    if (blocks_.empty() || block_nodes + tree_nodes > kTreeBlockNodes) {
+      blocks_.push_back({t, 0});
+      block_nodes = 0;
+    }
+    ++blocks_.back().n_trees;
+    block_nodes += tree_nodes;
+  }
+  enabled_ = true;
+  return true;
+}
+
+template <typename ThresholdType>
+template <typename InputType, typename Compare, bool has_missing_tracks>
+void TreeEnsembleFlatLayout<ThresholdType>::ComputeLeaves(size_t block_index, const InputType* x_data, int64_t stride,
+                                                           size_t n_rows, Scratch& scratch) const {
+  const TreeBlock& block = blocks_[block_index];
+  const int32_t* features = features_.data();
+  const ThresholdType* thresholds = thresholds_.data();
+  const int32_t* children = children_.data();
+  Compare compare;
+  int32_t index[kRowBlockSize];
+
+  for (size_t t = 0; t < block.n_trees; ++t) {
+    const int32_t root = roots_[block.tree_begin + t];
+    for (size_t r = 0; r < n_rows; ++r) {
+      index[r] = root;
+    }
+    bool moved = true;
+    while (moved) {
+      moved = false;
+      for (size_t r = 0; r < n_rows; ++r) {
+        const int32_t i = index[r];
+        const int32_t child = children[i];
+        if (child < 0) continue;
+        const InputType val = x_data[static_cast<int64_t>(r) * stride + features[i]];
+        bool cond = compare(val, thresholds[i]);
+        if constexpr (has_missing_tracks) {
+          cond = cond || (missing_track_true_[i] && _isnan_(val));
+        }
+        index[r] = cond ? child : child + 1;
+        moved = true;
+      }
+    }
+    for (size_t r = 0; r < n_rows; ++r) {
+      scratch.leaves[t * kRowBlockSize + r] = &leaves_[static_cast<size_t>(-children[index[r]] - 1)];
+    }
+  }
+}
+
+template <typename ThresholdType>
+template <typename InputType>
+void TreeEnsembleFlatLayout<ThresholdType>::ComputeLeaves(size_t block, const InputType* x_data, int64_t stride,
+                                                           size_t n_rows, Scratch& scratch) const {
+  if (scratch.leaves.size() < blocks_[block].n_trees * kRowBlockSize) {
+    scratch.leaves.resize(blocks_[block].n_trees * kRowBlockSize);
+  }
+
+#define FLAT_LAYOUT_COMPUTE_LEAVES(CMP)                                                          \
+  if (has_missing_tracks_) {                                                                     \
+    ComputeLeaves<InputType, flat_layout::CMP, true>(block, x_data, stride, n_rows, scratch);    \
+  } else {                                                                                       \
+    ComputeLeaves<InputType, flat_layout::CMP, false>(block, x_data, stride, n_rows, scratch);   \
+  }
+
+  switch (mode_) {
+    case NODE_MODE_ORT::BRANCH_LEQ:
+      FLAT_LAYOUT_COMPUTE_LEAVES(LEQ)
+      break;
+    case NODE_MODE_ORT::BRANCH_LT:
+      FLAT_LAYOUT_COMPUTE_LEAVES(LT)
+      break;
+    case NODE_MODE_ORT::BRANCH_GTE:
+      FLAT_LAYOUT_COMPUTE_LEAVES(GTE)
+      break;
+    case NODE_MODE_ORT::BRANCH_GT:
+      FLAT_LAYOUT_COMPUTE_LEAVES(GT)
+      break;
+    case NODE_MODE_ORT::BRANCH_EQ:
+      FLAT_LAYOUT_COMPUTE_LEAVES(EQ)
+      break;
+    case NODE_MODE_ORT::BRANCH_NEQ:
+      FLAT_LAYOUT_COMPUTE_LEAVES(NEQ)
+      break;
+    default:
+      // Every tree is a single leaf, any rule gives the same result.
+      ComputeLeaves<InputType, flat_layout::LEQ, false>(block, x_data, stride, n_rows, scratch);
+      break;
+  }
+
+#undef FLAT_LAYOUT_COMPUTE_LEAVES
+}
+
+}  // namespace detail
+}  // namespace ml
+}  // namespace onnxruntime
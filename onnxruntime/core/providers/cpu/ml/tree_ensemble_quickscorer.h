@@ -0,0 +1,281 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "tree_ensemble_aggregator.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+namespace onnxruntime {
+namespace ml {
+namespace detail {
+
+// Index of the lowest bit set in a non null value.
+inline size_t LowestBitIndex(uint64_t value) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return static_cast<size_t>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+  return static_cast<size_t>(__builtin_ctzll(value));
+#else
+  size_t index = 0;
+  while ((value & 1) == 0) {
+    value >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+/**
+ * Evaluation engine for ensembles of small trees following QuickScorer
+ * (Lucchese et al., "QuickScorer: a Fast Algorithm to Rank Documents with Additive Ensembles of Regression Trees").
+ *
+ * The leaves of every tree are numbered from left to right, the true branch of a node being on the left.
+ * Every internal node stores the bitmask of the leaves which remain reachable when its condition is false.
+ * A node is false for a row when the feature value is above its threshold, so once the nodes of a feature
+ * are sorted by threshold the false nodes for a row are a prefix of that list. Starting from a bitvector with
+ * all bits set and applying the masks of all false nodes, the exit leaf of a tree is the lowest bit still set.
+ *
+ * Trees are processed in blocks of kTreeBlockSize trees so that the bitvectors of a block fit in the L1/L2 cache,
+ * and rows are processed kRowBlockSize at a time with a branch free inner loop over the rows.
+ *
+ * Only ensembles where every internal node uses the same BRANCH_LEQ or BRANCH_LT rule and every tree has at most
+ * kMaxLeaves leaves can be handled. `Init` returns false otherwise and the caller keeps the node by node traversal.
+ */
+template <typename ThresholdType>
+class TreeEnsembleQuickScorer {
+ public:
+  static constexpr size_t kMaxLeaves = 64;
+  static constexpr size_t kTreeBlockSize = 256;
+  static constexpr size_t kRowBlockSize = 8;
+
+  // Per thread buffers used by ComputeLeaves.
+  struct Scratch {
+    std::vector<uint64_t> bitvectors;
+    std::vector<const TreeNodeElement<ThresholdType>*> leaves;
+
+    Scratch() : bitvectors(kTreeBlockSize * kRowBlockSize), leaves(kTreeBlockSize * kRowBlockSize) {}
+  };
+
+  bool Init(const std::vector<TreeNodeElement<ThresholdType>>& nodes,
+            const std::vector<TreeNodeElement<ThresholdType>*>& roots);
+
+  bool IsEnabled() const { return enabled_; }
+  size_t NumTreeBlocks() const { return blocks_.size(); }
+  size_t TreeBlockBegin(size_t block) const { return blocks_[block].tree_begin; }
+  size_t TreeBlockSize(size_t block) const { return blocks_[block].n_trees; }
+
+  // Computes the exit leaf of every tree of a block for n_rows <= kRowBlockSize consecutive rows.
+  // The leaf of tree `t` (relative to the block) for row `r` is stored in scratch.leaves[t * kRowBlockSize + r].
+  template <typename InputType>
+  void ComputeLeaves(size_t block, const InputType* x_data, int64_t stride, size_t n_rows, Scratch& scratch) const;
+
+ private:
+  struct FeatureRange {
+    int64_t feature_id;
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  struct TreeBlock {
+    size_t tree_begin;
+    size_t n_trees;
+    std::vector<FeatureRange> features;
+    // One entry per internal node, grouped by feature and sorted by threshold within a feature.
+    std::vector<ThresholdType> thresholds;
+    std::vector<uint64_t> masks;
+    std::vector<uint16_t> tree_ids;  // relative to tree_begin
+    std::vector<uint8_t> missing_track_true;
+  };
+
+  struct NodeEntry {
+    int64_t feature_id;
+    ThresholdType threshold;
+    uint64_t mask;
+    uint16_t tree_id;
+    uint8_t missing_track_true;
+  };
+
+  bool NumberLeaves(const TreeNodeElement<ThresholdType>* node, uint16_t tree_id,
+                    const TreeNodeElement<ThresholdType>* base, std::vector<uint8_t>& visited,
+                    std::vector<NodeEntry>& entries, size_t& n_leaves);
+
+  bool enabled_ = false;
+  bool strict_ = false;  // BRANCH_LT if true, BRANCH_LEQ otherwise
+  std::vector<TreeBlock> blocks_;
+  std::vector<size_t> leaf_offsets_;
+  std::vector<const TreeNodeElement<ThresholdType>*> leaves_;
+};
+
+template <typename ThresholdType>
+bool TreeEnsembleQuickScorer<ThresholdType>::NumberLeaves(const TreeNodeElement<ThresholdType>* node, uint16_t tree_id,
+                                                           const TreeNodeElement<ThresholdType>* base,
+                                                           std::vector<uint8_t>& visited,
+                                                           std::vector<NodeEntry>& entries, size_t& n_leaves) {
+  // Subtrees shared by several parents (see AddNodes) do not form a tree and cannot be numbered.
+  size_t pos = static_cast<size_t>(node - base);
+  if (visited[pos]) return false;
+  visited[pos] = 1;
+
+  if (!node->is_not_leaf()) {
+    if (n_leaves >= kMaxLeaves) return false;
+    leaves_.push_back(node);
+    ++n_leaves;
+    return true;
+  }
+
+  if (node->mode() != (strict_ ? NODE_MODE_ORT::BRANCH_LT : NODE_MODE_ORT::BRANCH_LEQ) ||
+      !std::isfinite(node->value_or_unique_weight)) {
+    return false;
+  }
+
+  size_t first_leaf = n_leaves;
+  if (!NumberLeaves(node->truenode_or_weight.ptr, tree_id, base, visited, entries, n_leaves)) return false;
+  size_t true_leaves = n_leaves - first_leaf;
+  // The false node removes the leaves of the true branch.
+  // The false branch holds at least one leaf so true_leaves < kMaxLeaves.
+  uint64_t true_bits = (uint64_t(1) << true_leaves) - 1;
+  entries.push_back({node->feature_id, node->value_or_unique_weight, ~(true_bits << first_leaf), tree_id,
+                     static_cast<uint8_t>(node->is_missing_track_true() ? 1 : 0)});
+  return NumberLeaves(node + 1, tree_id, base, visited, entries, n_leaves);
+}
+
+template <typename ThresholdType>
+bool TreeEnsembleQuickScorer<ThresholdType>::Init(const std::vector<TreeNodeElement<ThresholdType>>& nodes,
+                                                   const std::vector<TreeNodeElement<ThresholdType>*>& roots) {
+  enabled_ = false;
+  blocks_.clear();
+  leaf_offsets_.clear();
+  leaves_.clear();
+  if (roots.empty()) return false;
+
+  // Every internal node must use the rule of the first one, this is checked while numbering the leaves.
+  for (const auto& node : nodes) {
+    if (!node.is_not_leaf()) continue;
+    if (node.mode() != NODE_MODE_ORT::BRANCH_LEQ && node.mode() != NODE_MODE_ORT::BRANCH_LT) return false;
+    strict_ = node.mode() == NODE_MODE_ORT::BRANCH_LT;
+    break;
+  }
+
+  std::vector<uint8_t> visited(nodes.size(), 0);
+  std::vector<NodeEntry> entries;
+  leaf_offsets_.reserve(roots.size() + 1);
+  leaves_.reserve(nodes.size());
+  for (size_t block_begin = 0; block_begin < roots.size(); block_begin += kTreeBlockSize) {
+    TreeBlock block;
+    block.tree_begin = block_begin;
+    block.n_trees = std::min(kTreeBlockSize, roots.size() - block_begin);
+    entries.clear();
+    for (size_t t = 0; t < block.n_trees; ++t) {
+      leaf_offsets_.push_back(leaves_.size());
+      size_t n_leaves = 0;
+      if (!NumberLeaves(roots[block_begin + t], static_cast<uint16_t>(t), nodes.data(), visited, entries, n_leaves)) {
+        blocks_.clear();
+        leaf_offsets_.clear();
+        leaves_.clear();
+        return false;
+      }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const NodeEntry& a, const NodeEntry& b) {
+      return a.feature_id < b.feature_id || (a.feature_id == b.feature_id && a.threshold < b.threshold);
+    });
+    block.thresholds.reserve(entries.size());
+    block.masks.reserve(entries.size());
+    block.tree_ids.reserve(entries.size());
+    block.missing_track_true.reserve(entries.size());
+    for (size_t k = 0; k < entries.size(); ++k) {
+      if (k == 0 || entries[k].feature_id != entries[k - 1].feature_id) {
+        if (!block.features.empty()) block.features.back().end = static_cast<uint32_t>(k);
+        block.features.push_back({entries[k].feature_id, static_cast<uint32_t>(k), 0});
+      }
+      block.thresholds.push_back(entries[k].threshold);
+      block.masks.push_back(entries[k].mask);
+      block.tree_ids.push_back(entries[k].tree_id);
+      block.missing_track_true.push_back(entries[k].missing_track_true);
+    }
+    if (!block.features.empty()) block.features.back().end = static_cast<uint32_t>(entries.size());
+    blocks_.push_back(std::move(block));
+  }
+  leaf_offsets_.push_back(leaves_.size());
+  enabled_ = true;
+  return true;
+}
+
+template <typename ThresholdType>
+template <typename InputType>
+void TreeEnsembleQuickScorer<ThresholdType>::ComputeLeaves(size_t block_index, const InputType* x_data, int64_t stride,
+                                                            size_t n_rows, Scratch& scratch) const {
+  const TreeBlock& block = blocks_[block_index];
+  uint64_t* bitvectors = scratch.bitvectors.data();
+  std::fill(bitvectors, bitvectors + block.n_trees * kRowBlockSize, ~uint64_t(0));
+
+  // Compare in the type the node by node traversal compares in, so an input wider than the thresholds (a double
+  // input and float thresholds) is not rounded to a threshold it is close to.
+  using ValueType = std::common_type_t<InputType, ThresholdType>;
+  ValueType values[kRowBlockSize];
+  uint8_t is_nan[kRowBlockSize];
+  for (const FeatureRange& feature : block.features) {
+    // Padding rows get the lowest value so that no node is false for them.
+    ValueType max_value = std::numeric_limits<ValueType>::lowest();
+    bool any_nan = false;
+    for (size_t r = 0; r < kRowBlockSize; ++r) {
+      values[r] = std::numeric_limits<ValueType>::lowest();
+      is_nan[r] = 0;
+      if (r < n_rows) {
+        InputType val = x_data[static_cast<int64_t>(r) * stride + feature.feature_id];
+        if (_isnan_(val)) {
+          is_nan[r] = 1;
+          any_nan = true;
+        } else {
+          values[r] = static_cast<ValueType>(val);
+          max_value = std::max(max_value, values[r]);
+        }
+      }
+    }
+
+    // A missing value follows the true branch only if the node says so, every other node is false.
+    // Without missing values, the scan stops at the first threshold which is true for every row.
+    for (uint32_t k = feature.begin; k < feature.end; ++k) {
+      const ValueType threshold = static_cast<ValueType>(block.thresholds[k]);
+      if (!any_nan && (strict_ ? threshold > max_value : threshold >= max_value)) break;
+      const uint64_t mask = block.masks[k];
+      const uint8_t track_true = block.missing_track_true[k];
+      uint64_t* bv = bitvectors + static_cast<size_t>(block.tree_ids[k]) * kRowBlockSize;
+      if (strict_) {
+        for (size_t r = 0; r < kRowBlockSize; ++r) {
+          const bool is_false = is_nan[r] ? !track_true : threshold <= values[r];
+          bv[r] &= is_false ? mask : ~uint64_t(0);
+        }
+      } else {
+        for (size_t r = 0; r < kRowBlockSize; ++r) {
+          const bool is_false = is_nan[r] ? !track_true : threshold < values[r];
+          bv[r] &= is_false ? mask : ~uint64_t(0);
+        }
+      }
+    }
+  }
+
+  const TreeNodeElement<ThresholdType>** leaves = scratch.leaves.data();
+  for (size_t t = 0; t < block.n_trees; ++t) {
+    const TreeNodeElement<ThresholdType>* const* tree_leaves = leaves_.data() + leaf_offsets_[block.tree_begin + t];
+    for (size_t r = 0; r < n_rows; ++r) {
+      // The last leaf of a tree is never removed, the bitvector cannot be null.
+      leaves[t * kRowBlockSize + r] = tree_leaves[LowestBitIndex(bitvectors[t * kRowBlockSize + r])];
+    }
+  }
+}
+
+}  // namespace detail
+}  // namespace ml
+}  // namespace onnxruntime
@@ -19,6 +19,7 @@
 
 #include "core/common/narrow.h"
 #include "core/common/safeint.h"
+#include "core/framework/tensorprotoutils.h"
 #include "core/util/math_cpuonly.h"
 
 namespace onnxruntime {
@@ -153,6 +154,81 @@ Status Conv<T>::Compute(OpKernelContext* context) const {
   return Status::OK();
 }
 
+Status Conv<float>::PrePack(const Tensor& tensor, int input_idx, AllocatorPtr alloc,
+                            /*out*/ bool& is_packed,
+                            /*out*/ PrePackedWeights* /*prepacked_weights*/) {
+  // The original filter is still needed when MlasConvPrepare does not choose the Winograd algorithm for the
+  // input shape, so the transformed filter is kept in addition to it.
+  is_packed = false;
+
+  if (!use_winograd_ || input_idx != 1) {
+    return Status::OK();
+  }
+
+  const auto& shape = tensor.Shape();
+  if (shape.NumDimensions() != 4 || shape[2] != 3 || shape[3] != 3 || shape[0] % conv_attrs_.group != 0) {
+    return Status::OK();
+  }
+
+  const size_t group_count = narrow<size_t>(conv_attrs_.group);
+  const size_t input_channels = narrow<size_t>(shape[1]);
+  const size_t filter_count = narrow<size_t>(shape[0]) / group_count;
+
+  // Skip the transform when MlasConvPrepare can never choose F(4x4,3x3): it requires at least 64 input and output
+  // channels per group, unit strides and dilations, and MlasConvWinogradOutputTile to pick the larger tile.
+  if (input_channels < 64 || filter_count < 64) {
+    return Status::OK();
+  }
+
+  for (const int64_t stride : conv_attrs_.strides) {
+    if (stride != 1) {
+      return Status::OK();
+    }
+  }
+  for (const int64_t dilation : conv_attrs_.dilations) {
+    if (dilation != 1) {
+      return Status::OK();
+    }
+  }
+
+  // The output size is only checked when the spatial dimensions of X are known here, otherwise it is assumed to be
+  // large enough.
+  size_t output_height = 8;
+  size_t output_width = 8;
+  const auto* x_shape_proto = Node().InputDefs()[0]->Shape();
+  if (x_shape_proto != nullptr && x_shape_proto->dim_size() == 4) {
+    const TensorShape input_shape = utils::GetTensorShapeFromTensorShapeProto(*x_shape_proto).Slice(2);
+    if (input_shape[0] > 0 && input_shape[1] > 0) {
+      const TensorShapeVector kernel_shape{3, 3};
+      const TensorShapeVector ones{1, 1};
+      ConvPadVector pads(conv_attrs_.pads);
+      if (pads.empty()) {
+        pads.resize(4, 0);
+      }
+      TensorShapeVector output_shape;
+      if (!conv_attrs_.InferPadsAndOutputShape(input_shape, kernel_shape, ones, ones, pads, output_shape).IsOK() ||
+          output_shape[0] <= 0 || output_shape[1] <= 0) {
+        return Status::OK();
+      }
+      output_height = narrow<size_t>(output_shape[0]);
+      output_width = narrow<size_t>(output_shape[1]);
+    }
+  }
+
+  if (MlasConvWinogradOutputTile(input_channels, filter_count, output_height, output_width) != 4) {
+    return Status::OK();
+  }
+
+  const size_t packed_filter_size = MlasConvWinogradPackedFilterSize(group_count, input_channels, filter_count, 4);
+  auto* packed_filter_data = alloc->Alloc(SafeInt<size_t>(packed_filter_size) * sizeof(float));
+  winograd_filter_ = BufferUniquePtr(packed_filter_data, BufferDeleter(std::move(alloc)));
+
+  MlasConvWinogradPackFilter(group_count, input_channels, filter_count, 4, tensor.Data<float>(),
+                             static_cast<float*>(packed_filter_data));
+
+  return Status::OK();
+}
+
 Status Conv<float>::Compute(OpKernelContext* context) const {
   size_t num_inputs = OpKernel::Node().InputDefs().size();
   const Tensor* X = context->Input<Tensor>(0);
@@ -231,7 +307,15 @@ Status Conv<float>::Compute(OpKernelContext* context) const {
                     &activation_,
                     &WorkingBufferSize,
                     Beta,
-                    thread_pool);
+                    thread_pool,
+                    use_winograd_);
+
+    // Use the filter transformed by PrePack if the output tile matches.
+    if (Parameters.Algorithm == MlasConvAlgorithmWinograd && winograd_filter_ != nullptr &&
+        Parameters.u.Winograd.OutputTile == 4) {
+      Parameters.u.Winograd.PackedFilter = static_cast<const float*>(winograd_filter_.get());
+      WorkingBufferSize -= Parameters.u.Winograd.PackedFilterSize;
+    }
 
     auto* working_data = WorkingBufferSize > 0 ? alloc->Alloc(sizeof(float) * SafeInt<size_t>(WorkingBufferSize))
                                                : nullptr;
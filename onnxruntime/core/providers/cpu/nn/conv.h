@@ -6,6 +6,7 @@
 #include "core/framework/op_kernel.h"
 #include "core/providers/cpu/nn/conv_attributes.h"
 #include "core/mlas/inc/mlas.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 
 namespace onnxruntime {
 
@@ -26,14 +27,24 @@ class Conv<float> : public OpKernel {
  public:
   Conv(const OpKernelInfo& info) : OpKernel(info), conv_attrs_(info) {
     activation_.ActivationKind = MlasIdentityActivation;
+    use_winograd_ = info.GetConfigOptions().GetConfigEntry(kOrtSessionOptionsMlasConvWinograd) == "1";
   }
 
+  Status PrePack(const Tensor& tensor, int input_idx, AllocatorPtr alloc,
+                 /*out*/ bool& is_packed,
+                 /*out*/ PrePackedWeights* prepacked_weights) override;
+
   Status Compute(OpKernelContext* context) const override;
 
  protected:
   MLAS_ACTIVATION activation_;
 
   ConvAttributes conv_attrs_;
+
+ private:
+  // Winograd convolution state. The filter is transformed for F(4x4,3x3) when it is a constant initializer.
+  bool use_winograd_;
+  BufferUniquePtr winograd_filter_;
 };
 
 }  // namespace onnxruntime
@@ -413,6 +413,28 @@ void InferenceSession::ConstructorCommon(const SessionOptions& session_options,
   use_per_session_threads_ = session_options.use_per_session_threads;
   force_spinning_stop_between_runs_ = session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigForceSpinningStop, "0") == "1";
 
+  {
+    const std::string priority_str =
+        session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigIntraOpPriority, "");
+    const std::string max_dop_str =
+        session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigIntraOpMaxDegreeOfParallelism, "");
+    if (!priority_str.empty() || !max_dop_str.empty()) {
+      concurrency::ThreadPool::SchedulingContext context;
+      int value = 0;
+      if (!priority_str.empty()) {
+        ORT_ENFORCE(TryParseStringWithClassicLocale<int>(priority_str, value) && value > 0,
+                    "Invalid value for ", kOrtSessionOptionsConfigIntraOpPriority, ": ", priority_str);
+        context.priority = static_cast<unsigned>(value);
+      }
+      if (!max_dop_str.empty()) {
+        ORT_ENFORCE(TryParseStringWithClassicLocale<int>(max_dop_str, value) && value >= 0,
+                    "Invalid value for ", kOrtSessionOptionsConfigIntraOpMaxDegreeOfParallelism, ": ", max_dop_str);
+        context.max_degree_of_parallelism = static_cast<unsigned>(value);
+      }
+      intra_op_scheduling_context_ = context;
+    }
+  }
+
   if (use_per_session_threads_) {
     LOGS(*session_logger_, INFO) << "Creating and using per session threadpools since use_per_session_threads_ is true";
     {
@@ -431,6 +453,8 @@ void InferenceSession::ConstructorCommon(const SessionOptions& session_options,
         // If the thread pool can use all the processors, then
         // we set affinity of each thread to each processor.
         to.allow_spinning = allow_intra_op_spinning;
+        to.adaptive_spinning =
+            session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigIntraOpAdaptiveSpinning, "0") == "1";
         to.dynamic_block_base_ = std::stoi(session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigDynamicBlockBase, "0"));
         LOGS(*session_logger_, INFO) << "Dynamic block base set to " << to.dynamic_block_base_;
 
@@ -444,6 +468,8 @@ void InferenceSession::ConstructorCommon(const SessionOptions& session_options,
         to.auto_set_affinity = to.thread_pool_size == 0 &&
                                session_options_.execution_mode == ExecutionMode::ORT_SEQUENTIAL &&
                                to.affinity_str.empty();
+        to.numa_aware =
+            session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigIntraOpThreadNumaAware, "0") == "1";
 
         if (to.custom_create_thread_fn) {
           ORT_ENFORCE(to.custom_join_thread_fn, "custom join thread function not set for intra op thread pool");
@@ -500,6 +526,15 @@ void InferenceSession::ConstructorCommon(const SessionOptions& session_options,
     StartProfiling(session_options_.profile_file_prefix);
   }
 
+  if (session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigEnableSamplingProfiler, "0") == "1") {
+    const std::string interval_str =
+        session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigSamplingProfilerInterval, "1");
+    int interval = 0;
+    ORT_ENFORCE(TryParseStringWithClassicLocale<int>(interval_str, interval) && interval > 0,
+                "Invalid value for ", kOrtSessionOptionsConfigSamplingProfilerInterval, ": ", interval_str);
+    session_profiler_.StartSampling(static_cast<uint32_t>(interval), GetIntraOpThreadPoolToUse());
+  }
+
   telemetry_ = {};
 
 #ifdef _WIN32
@@ -713,6 +748,9 @@ InferenceSession::InferenceSession(const SessionOptions& session_options, const
 #endif  // !defined(ORT_MINIMAL_BUILD)
 
 InferenceSession::~InferenceSession() {
+  // drain any batched requests while the session state and thread pools are still alive
+  request_batcher_.reset();
+
   if (session_options_.enable_profiling) {
     ORT_TRY {
       EndProfiling();
@@ -2121,6 +2159,26 @@ common::Status InferenceSession::Initialize() {
     // Resolve memory pattern flags of the main graph and subgraph session states
     ResolveMemoryPatternFlags(*session_state_);
 
+    if (session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsBatchingEnable, "0") == "1") {
+      RequestBatcherOptions batcher_options;
+      ORT_RETURN_IF_ERROR_SESSIONID_(
+          RequestBatcherOptions::FromConfigOptions(session_options_.config_options, batcher_options));
+      auto* tp = GetIntraOpThreadPoolToUse();
+      if (!tp || concurrency::ThreadPool::DegreeOfParallelism(tp) < 2) {
+        ORT_RETURN_IF_ERROR_SESSIONID_(ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                                                       "Request batching requires an intra op thread pool with a "
+                                                       "degree of parallelism of at least 2."));
+      }
+      request_batcher_ = std::make_unique<RequestBatcher>(
+          batcher_options, session_state_->GetAllocator(OrtDevice()),
+          [this](const RunOptions& run_options, gsl::span<const char* const> feed_names,
+                 gsl::span<const OrtValue* const> feeds, gsl::span<const char* const> fetch_names,
+                 gsl::span<OrtValue*> fetches) {
+            return Run(run_options, feed_names, feeds, fetch_names, fetches);
+          },
+          [tp](std::function<void()> fn) { concurrency::ThreadPool::Schedule(tp, std::move(fn)); });
+    }
+
     is_inited_ = true;
 
     if (!using_ort_model_bytes_for_initializers_) {
@@ -2564,6 +2622,22 @@ Status InferenceSession::Run(const RunOptions& run_options,
   auto* inter_tp = (control_spinning) ? inter_op_thread_pool_.get() : nullptr;
   ThreadPoolSpinningSwitch runs_refcounter_and_tp_spin_control(intra_tp, inter_tp, current_num_runs_);
 
+  // Account the parallel loops of this run to the session's priority and quota.
+  std::optional<concurrency::ThreadPool::SchedulingScope> scheduling_scope;
+  if (intra_op_scheduling_context_) {
+    scheduling_scope.emplace(*intra_op_scheduling_context_);
+  }
+
+  // Keep the intra-op threads spinning for the duration of this run if it asked for latency mode.
+  concurrency::ThreadPool* latency_mode_tp = nullptr;
+  if (run_options.config_options.GetConfigOrDefault(kOrtRunOptionsConfigIntraOpLatencyMode, "0") == "1") {
+    latency_mode_tp = GetIntraOpThreadPoolToUse();
+    if (latency_mode_tp) latency_mode_tp->EnterLatencyMode();
+  }
+  auto exit_latency_mode = gsl::finally([latency_mode_tp]() {
+    if (latency_mode_tp) latency_mode_tp->ExitLatencyMode();
+  });
+
   // Check if this Run() is simply going to be a CUDA Graph replay.
   if (cached_execution_provider_for_graph_replay_.IsGraphCaptured(graph_annotation_id)) {
     LOGS(*session_logger_, INFO) << "Replaying the captured "
@@ -2576,6 +2650,7 @@ Status InferenceSession::Run(const RunOptions& run_options,
     exec_providers_to_stop.reserve(execution_providers_.NumProviders());
 
     InlinedVector<AllocatorPtr> arenas_to_shrink;
+    InlinedVector<AllocatorPtr> arenas_to_trim;
 
     ORT_TRY {
       if (!is_inited_) {
@@ -2597,6 +2672,14 @@ Status InferenceSession::Run(const RunOptions& run_options,
         ORT_RETURN_IF_ERROR_SESSIONID_(ValidateAndParseShrinkArenaString(shrink_memory_arenas, arenas_to_shrink));
       }
 
+      // trim the idle memory of certain memory arenas if the user has requested for it
+      const std::string& trim_memory_arenas =
+          run_options.config_options.GetConfigOrDefault(kOrtRunOptionsConfigEnableMemoryArenaTrimming, "");
+
+      if (!trim_memory_arenas.empty()) {
+        ORT_RETURN_IF_ERROR_SESSIONID_(ValidateAndParseShrinkArenaString(trim_memory_arenas, arenas_to_trim));
+      }
+
       FeedsFetchesInfo info(feed_names, output_names, session_state_->GetOrtValueNameIdxMap());
       FeedsFetchesManager feeds_fetches_manager{std::move(info)};
 
@@ -2697,6 +2780,10 @@ Status InferenceSession::Run(const RunOptions& run_options,
     if (!arenas_to_shrink.empty()) {
       ShrinkMemoryArenas(arenas_to_shrink);
     }
+
+    if (!arenas_to_trim.empty()) {
+      TrimMemoryArenas(arenas_to_trim);
+    }
   }
 
   // keep track of telemetry
@@ -2719,7 +2806,12 @@ Status InferenceSession::Run(const RunOptions& run_options,
 
   // send out profiling events (optional)
   if (session_profiler_.IsEnabled()) {
-    session_profiler_.EndTimeAndRecordEvent(profiling::SESSION_EVENT, "model_run", tp);
+    const auto plan_cache_stats = session_state_->GetShapePlanCache().GetStats();
+    session_profiler_.EndTimeAndRecordEvent(profiling::SESSION_EVENT, "model_run", tp,
+                                            {{"shape_plan_cache_hits", std::to_string(plan_cache_stats.hits)},
+                                             {"shape_plan_cache_misses", std::to_string(plan_cache_stats.misses)},
+                                             {"shape_plan_cache_evictions",
+                                              std::to_string(plan_cache_stats.evictions)}});
   }
 #ifdef ONNXRUNTIME_ENABLE_INSTRUMENT
   TraceLoggingWriteStop(ortrun_activity, "OrtRun");
@@ -2848,6 +2940,29 @@ common::Status InferenceSession::RunAsync(const RunOptions* run_options,
   return Status::OK();
 }
 
+common::Status InferenceSession::RunBatchedAsync(const RunOptions* run_options,
+                                                 gsl::span<const char* const> feed_names,
+                                                 gsl::span<const OrtValue* const> feeds,
+                                                 gsl::span<const char* const> fetch_names,
+                                                 gsl::span<OrtValue*> fetches,
+                                                 RunAsyncCallbackFn callback,
+                                                 void* user_data) {
+  if (!request_batcher_) {
+    return RunAsync(run_options, feed_names, feeds, fetch_names, fetches, callback, user_data);
+  }
+
+  return request_batcher_->Submit(run_options, feed_names, feeds, fetch_names, fetches, callback, user_data);
+}
+
+common::Status InferenceSession::GetRequestBatcherStats(RequestBatcherStats& stats) const {
+  if (!request_batcher_) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Request batching is not enabled for this session.");
+  }
+
+  stats = request_batcher_->GetStats();
+  return Status::OK();
+}
+
 common::Status InferenceSession::Run(const NameMLValMap& feeds, gsl::span<const std::string> output_names,
                                      std::vector<OrtValue>* p_fetches) {
   return Run(RunOptions(), feeds, output_names, p_fetches);
@@ -2983,6 +3098,16 @@ const profiling::Profiler& InferenceSession::GetProfiling() const {
   return session_profiler_;
 }
 
+Status InferenceSession::GetSamplingProfile(std::string& profile) const {
+  const auto* sampling_profiler = session_profiler_.GetSamplingProfiler();
+  if (sampling_profiler == nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "The sampling profiler is not enabled. Set the session config entry ",
+                           kOrtSessionOptionsConfigEnableSamplingProfiler, " to 1 to enable it.");
+  }
+  profile = sampling_profiler->Snapshot();
+  return Status::OK();
+}
+
 #if !defined(ORT_MINIMAL_BUILD)
 std::vector<TuningResults> InferenceSession::GetTuningResults() const {
   std::vector<TuningResults> ret;
@@ -3109,6 +3234,17 @@ void InferenceSession::ShrinkMemoryArenas(gsl::span<const AllocatorPtr> arenas_t
   }
 }
 
+void InferenceSession::TrimMemoryArenas(gsl::span<const AllocatorPtr> arenas_to_trim) {
+  for (auto& alloc : arenas_to_trim) {
+    auto status = static_cast<BFCArena*>(alloc.get())->TrimIdleRegions();
+
+    if (!status.IsOK()) {
+      LOGS(*session_logger_, WARNING) << "Unable to trim arena: " << alloc->Info().ToString()
+                                      << " error message: " << status.ErrorMessage();
+    }
+  }
+}
+
 #if !defined(ORT_MINIMAL_BUILD)
 // assumes model has already been loaded before
 common::Status InferenceSession::DoPostLoadProcessing(onnxruntime::Model& model) {
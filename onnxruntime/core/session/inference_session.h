@@ -29,6 +29,7 @@
 #include "core/optimizer/graph_transformer_level.h"
 #include "core/optimizer/graph_transformer_mgr.h"
 #include "core/optimizer/insert_cast_transformer.h"
+#include "core/session/request_batcher.h"
 #include <mutex>
 #ifdef ENABLE_LANGUAGE_INTEROP_OPS
 #include "core/language_interop_ops/language_interop_ops.h"
@@ -352,6 +353,26 @@ class InferenceSession {
                                         RunAsyncCallbackFn callback,
                                         void* user_data = nullptr);
 
+  /**
+   * Queue a request to be coalesced with other concurrent requests into a single batched Run.
+   * Requires the "session.batching.enable" session config entry. Arguments and lifetime requirements are the
+   * same as RunAsync. If batching is not enabled this is equivalent to RunAsync.
+   * This API is thread-safe.
+   */
+  [[nodiscard]] common::Status RunBatchedAsync(const RunOptions* run_options,
+                                               gsl::span<const char* const> feed_names,
+                                               gsl::span<const OrtValue* const> feeds,
+                                               gsl::span<const char* const> fetch_names,
+                                               gsl::span<OrtValue*> fetches,
+                                               RunAsyncCallbackFn callback,
+                                               void* user_data = nullptr);
+
+  /**
+   * Get latency, batch size and queue depth statistics of the request batcher.
+   * @return an error if batching is not enabled.
+   */
+  [[nodiscard]] common::Status GetRequestBatcherStats(RequestBatcherStats& stats) const;
+
   /**
    * Run a pre-loaded and pre-intialized model.
    * Multiple threads are allowed to run this function; hence its thread-safe.
@@ -495,6 +516,13 @@ class InferenceSession {
     */
   const profiling::Profiler& GetProfiling() const;
 
+  /**
+    * Get the statistics gathered so far by the sampling profiler, without stopping it.
+    @param profile receives the statistics as a JSON object, see profiling::SamplingProfiler::Snapshot.
+    @return an error if the sampling profiler was not enabled for this session.
+    */
+  common::Status GetSamplingProfile(std::string& profile) const;
+
 #if !defined(ORT_MINIMAL_BUILD)
   /**
    * Get the TuningResults of TunableOp for every execution providers.
@@ -699,6 +727,12 @@ class InferenceSession {
    */
   void ShrinkMemoryArenas(gsl::span<const AllocatorPtr> arenas_to_shrink);
 
+  /*
+   * Trims the idle memory of the arenas requested to be trimmed by the user
+   * The `arenas_to_trim` parameter is got from ValidateAndParseShrinkArenaString()
+   */
+  void TrimMemoryArenas(gsl::span<const AllocatorPtr> arenas_to_trim);
+
 #ifdef _WIN32
   static void LogAllSessions();
 #endif
@@ -755,9 +789,18 @@ class InferenceSession {
   // Spinning is restarted on the next Run()
   bool force_spinning_stop_between_runs_ = false;
 
+  // Priority and degree-of-parallelism quota of this session's parallel loops on the intra op thread pool, from the
+  // "session.intra_op_priority" and "session.intra_op_max_degree_of_parallelism" config entries.
+  // Empty if neither is set.
+  std::optional<concurrency::ThreadPool::SchedulingContext> intra_op_scheduling_context_;
+
   std::unique_ptr<onnxruntime::concurrency::ThreadPool> thread_pool_;
   std::unique_ptr<onnxruntime::concurrency::ThreadPool> inter_op_thread_pool_;
 
+  // Coalesces concurrent RunBatchedAsync requests. Created in Initialize() when "session.batching.enable" is set.
+  // Declared after the thread pools so that it is destroyed, and its scheduled work drained, before them.
+  std::unique_ptr<RequestBatcher> request_batcher_;
+
   // Global threadpools. These are intialized and used when use_per_session_threads is false *and*
   // the environment is created with create_global_thread_pools = true.
   onnxruntime::concurrency::ThreadPool* intra_op_thread_pool_from_env_{};
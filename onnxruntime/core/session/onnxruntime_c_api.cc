@@ -928,13 +928,14 @@ ORT_API_STATUS_IMPL(OrtApis::RunAsync, _Inout_ OrtSession* sess, _In_opt_ const
   auto output_name_span = gsl::make_span(output_names, output_names_len);
   auto output_span = gsl::make_span(output, output_names_len);
 
-  return ToOrtStatus(session->RunAsync(run_options,
-                                       input_names_span,
-                                       input_span,
-                                       output_name_span,
-                                       output_span,
-                                       run_async_callback,
-                                       user_data));
+  // requests are coalesced with other concurrent RunAsync calls if "session.batching.enable" is set
+  return ToOrtStatus(session->RunBatchedAsync(run_options,
+                                              input_names_span,
+                                              input_span,
+                                              output_name_span,
+                                              output_span,
+                                              run_async_callback,
+                                              user_data));
   API_IMPL_END
 }
 
@@ -1436,6 +1437,17 @@ ORT_API_STATUS_IMPL(OrtApis::SessionEndProfiling, _In_ OrtSession* sess, _Inout_
   API_IMPL_END
 }
 
+ORT_API_STATUS_IMPL(OrtApis::SessionGetSamplingProfile, _In_ const OrtSession* sess, _Inout_ OrtAllocator* allocator,
+                    _Outptr_ char** out) {
+  API_IMPL_BEGIN
+  auto session = reinterpret_cast<const ::onnxruntime::InferenceSession*>(sess);
+  std::string profile;
+  ORT_API_RETURN_IF_STATUS_NOT_OK(session->GetSamplingProfile(profile));
+  *out = StrDup(profile, allocator);
+  return nullptr;
+  API_IMPL_END
+}
+
 ORT_API_STATUS_IMPL(OrtApis::SessionGetModelMetadata, _In_ const OrtSession* sess,
                     _Outptr_ OrtModelMetadata** out) {
   API_IMPL_BEGIN
@@ -2302,6 +2314,16 @@ ORT_API_STATUS_IMPL(OrtApis::CreateArenaCfgV2, _In_reads_(num_keys) const char*
       cfg->initial_growth_chunk_size_bytes = static_cast<int>(arena_config_values[i]);
     } else if (strcmp(arena_config_keys[i], "max_power_of_two_extend_bytes") == 0) {
       cfg->max_power_of_two_extend_bytes = static_cast<int64_t>(arena_config_values[i]);
+    } else if (strcmp(arena_config_keys[i], "idle_region_release_ms") == 0) {
+      cfg->idle_region_release_ms = static_cast<int64_t>(arena_config_values[i]);
+    } else if (strcmp(arena_config_keys[i], "trim_high_watermark_bytes") == 0) {
+      cfg->trim_high_watermark_bytes = static_cast<int64_t>(arena_config_values[i]);
+    } else if (strcmp(arena_config_keys[i], "trim_low_watermark_bytes") == 0) {
+      cfg->trim_low_watermark_bytes = static_cast<int64_t>(arena_config_values[i]);
+    } else if (strcmp(arena_config_keys[i], "background_trim_interval_ms") == 0) {
+      cfg->background_trim_interval_ms = static_cast<int64_t>(arena_config_values[i]);
+    } else if (strcmp(arena_config_keys[i], "size_class_cache_max_bytes") == 0) {
+      cfg->size_class_cache_max_bytes = static_cast<int64_t>(arena_config_values[i]);
     } else {
       std::ostringstream oss;
       oss << "Invalid key found: " << arena_config_keys[i];
@@ -2809,6 +2831,8 @@ static constexpr OrtApi ort_api_1_to_21 = {
     &OrtApis::RunOptionsAddActiveLoraAdapter,
 
     &OrtApis::SetEpDynamicOptions,
+    &OrtApis::SetGlobalIntraOpAdaptiveParallelism,
+    &OrtApis::SessionGetSamplingProfile,
 };
 
 // OrtApiBase can never change as there is no way to know what version of OrtApiBase is returned by OrtGetApiBase.
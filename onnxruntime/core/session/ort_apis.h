@@ -533,4 +533,9 @@ ORT_API_STATUS_IMPL(RunOptionsAddActiveLoraAdapter, _Inout_ OrtRunOptions* optio
 
 ORT_API_STATUS_IMPL(SetEpDynamicOptions, _Inout_ OrtSession* sess, _In_reads_(kv_len) const char* const* keys,
                     _In_reads_(kv_len) const char* const* values, _In_ size_t kv_len);
+
+ORT_API_STATUS_IMPL(SetGlobalIntraOpAdaptiveParallelism, _Inout_ OrtThreadingOptions* tp_options, int enable);
+
+ORT_API_STATUS_IMPL(SessionGetSamplingProfile, _In_ const OrtSession* sess, _Inout_ OrtAllocator* allocator,
+                    _Outptr_ char** out);
 }  // namespace OrtApis
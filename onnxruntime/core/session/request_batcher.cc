@@ -0,0 +1,542 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/session/request_batcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "core/common/logging/logging.h"
+#include "core/common/narrow.h"
+#include "core/common/parse_string.h"
+#include "core/framework/error_code_helper.h"
+#include "core/framework/tensor.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
+
+namespace onnxruntime {
+
+namespace {
+
+template <typename T>
+Status ReadConfig(const ConfigOptions& config_options, const char* key, T& value) {
+  const auto entry = config_options.GetConfigEntry(key);
+  if (entry.has_value()) {
+    ORT_RETURN_IF_NOT(TryParseStringWithClassicLocale(*entry, value),
+                      "Failed to parse value of session config entry ", key, ": ", *entry);
+  }
+  return Status::OK();
+}
+
+int64_t ToMicroseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+int64_t Percentile(std::vector<int64_t> samples, double percentile) {
+  if (samples.empty()) {
+    return 0;
+  }
+  const size_t index = std::min(samples.size() - 1,
+                                static_cast<size_t>(percentile * static_cast<double>(samples.size())));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+// Copies `src` into the region of `dst` that starts at `batch_offset` along `axis`.
+// `dst` must have the same rank as `src` and every non-batch dimension must be at least as large.
+// Regions of `dst` not covered by `src` are left untouched, so the caller zero fills `dst` when padding.
+void CopyIntoBatch(const Tensor& src, Tensor& dst, size_t axis, int64_t batch_offset) {
+  const auto& src_shape = src.Shape();
+  const auto& dst_shape = dst.Shape();
+  const size_t rank = src_shape.NumDimensions();
+  const size_t element_size = src.DataType()->Size();
+  const auto* src_data = static_cast<const uint8_t*>(src.DataRaw());
+  auto* dst_data = static_cast<uint8_t*>(dst.MutableDataRaw());
+
+  bool same_inner_dims = true;
+  for (size_t d = 0; d < rank; ++d) {
+    if (d != axis && src_shape[d] != dst_shape[d]) {
+      same_inner_dims = false;
+      break;
+    }
+  }
+
+  if (same_inner_dims) {
+    // Fast path: each outer slice of the source is one contiguous block in the destination.
+    const size_t outer = narrow<size_t>(src_shape.SizeToDimension(axis));
+    const size_t inner = narrow<size_t>(src_shape.SizeFromDimension(axis + 1)) * element_size;
+    const size_t src_block = narrow<size_t>(src_shape[axis]) * inner;
+    const size_t dst_block = narrow<size_t>(dst_shape[axis]) * inner;
+    const size_t dst_offset = narrow<size_t>(batch_offset) * inner;
+    for (size_t o = 0; o < outer; ++o) {
+      std::memcpy(dst_data + o * dst_block + dst_offset, src_data + o * src_block, src_block);
+    }
+    return;
+  }
+
+  // Padded path: copy one innermost row at a time, walking an index over all but the last dimension.
+  const size_t row_bytes = narrow<size_t>(src_shape[rank - 1]) * element_size;
+  const size_t num_rows = narrow<size_t>(src_shape.SizeToDimension(rank - 1));
+  InlinedVector<int64_t> index(rank, 0);
+  InlinedVector<int64_t> dst_pitch(rank, 1);
+  for (size_t d = rank - 1; d > 0; --d) {
+    dst_pitch[d - 1] = dst_pitch[d] * dst_shape[d];
+  }
+
+  for (size_t row = 0; row < num_rows; ++row) {
+    int64_t dst_element = 0;
+    for (size_t d = 0; d + 1 < rank; ++d) {
+      dst_element += (index[d] + (d == axis ? batch_offset : 0)) * dst_pitch[d];
+    }
+    if (axis == rank - 1) {
+      dst_element += batch_offset;
+    }
+    std::memcpy(dst_data + narrow<size_t>(dst_element) * element_size, src_data + row * row_bytes, row_bytes);
+
+    for (size_t d = rank - 1; d > 0; --d) {
+      if (++index[d - 1] < src_shape[d - 1]) {
+        break;
+      }
+      index[d - 1] = 0;
+    }
+  }
+}
+
+// Copies the slice [batch_offset, batch_offset + batch_size) along `axis` of `src` into `dst`.
+void CopyFromBatch(const Tensor& src, Tensor& dst, size_t axis, int64_t batch_offset) {
+  const auto& src_shape = src.Shape();
+  const auto& dst_shape = dst.Shape();
+  const size_t element_size = src.DataType()->Size();
+  const size_t outer = narrow<size_t>(src_shape.SizeToDimension(axis));
+  const size_t inner = narrow<size_t>(src_shape.SizeFromDimension(axis + 1)) * element_size;
+  const size_t src_block = narrow<size_t>(src_shape[axis]) * inner;
+  const size_t dst_block = narrow<size_t>(dst_shape[axis]) * inner;
+  const size_t src_offset = narrow<size_t>(batch_offset) * inner;
+  const auto* src_data = static_cast<const uint8_t*>(src.DataRaw());
+  auto* dst_data = static_cast<uint8_t*>(dst.MutableDataRaw());
+  for (size_t o = 0; o < outer; ++o) {
+    std::memcpy(dst_data + o * dst_block, src_data + o * src_block + src_offset, dst_block);
+  }
+}
+
+bool IsMergeableTensor(const OrtValue* value, size_t axis) {
+  if (value == nullptr || !value->IsTensor()) {
+    return false;
+  }
+  const auto& tensor = value->Get<Tensor>();
+  return !tensor.IsDataTypeString() &&
+         tensor.Location().device.Type() == OrtDevice::CPU &&
+         tensor.Shape().NumDimensions() > axis;
+}
+
+}  // namespace
+
+Status RequestBatcherOptions::FromConfigOptions(const ConfigOptions& config_options, RequestBatcherOptions& options) {
+  ORT_RETURN_IF_ERROR(ReadConfig(config_options, kOrtSessionOptionsBatchingMaxBatchSize, options.max_batch_size));
+  ORT_RETURN_IF_ERROR(ReadConfig(config_options, kOrtSessionOptionsBatchingMaxWaitMicroseconds, options.max_wait_us));
+  ORT_RETURN_IF_ERROR(ReadConfig(config_options, kOrtSessionOptionsBatchingAxis, options.batch_axis));
+
+  std::string pad = config_options.GetConfigOrDefault(kOrtSessionOptionsBatchingPadRaggedAxes, "0");
+  ORT_RETURN_IF_NOT(pad == "0" || pad == "1",
+                    "Invalid value for ", kOrtSessionOptionsBatchingPadRaggedAxes, ": ", pad);
+  options.pad_ragged_axes = pad == "1";
+
+  ORT_RETURN_IF_NOT(options.max_batch_size >= 1, "Batching max batch size must be at least 1.");
+  ORT_RETURN_IF_NOT(options.max_wait_us >= 0, "Batching max wait time must not be negative.");
+  return Status::OK();
+}
+
+RequestBatcher::RequestBatcher(const RequestBatcherOptions& options, AllocatorPtr cpu_allocator,
+                               RunFn run_fn, ScheduleFn schedule_fn)
+    : options_(options),
+      cpu_allocator_(std::move(cpu_allocator)),
+      run_fn_(std::move(run_fn)),
+      schedule_fn_(std::move(schedule_fn)) {
+  queue_wait_samples_.reserve(kStatsWindow);
+  latency_samples_.reserve(kStatsWindow);
+  collector_ = std::thread([this]() { CollectLoop(); });
+}
+
+RequestBatcher::~RequestBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  queue_cv_.notify_all();
+  // the collector dispatches the remaining requests before it exits
+  collector_.join();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this]() { return outstanding_tasks_ == 0; });
+}
+
+Status RequestBatcher::Submit(const RunOptions* run_options,
+                              gsl::span<const char* const> feed_names,
+                              gsl::span<const OrtValue* const> feeds,
+                              gsl::span<const char* const> fetch_names,
+                              gsl::span<OrtValue*> fetches,
+                              RunAsyncCallbackFn callback,
+                              void* user_data) {
+  ORT_RETURN_IF(callback == nullptr, "RunAsync callback must not be null.");
+  ORT_RETURN_IF_NOT(feed_names.size() == feeds.size(), "Number of feed names and feeds differ.");
+  ORT_RETURN_IF_NOT(fetch_names.size() == fetches.size(), "Number of fetch names and fetches differ.");
+
+  Request request{run_options, feed_names, feeds, fetch_names, fetches, callback, user_data, {}, Clock::now()};
+
+  // Requests are only merged with others that use the same RunOptions instance and the same inputs/outputs.
+  // Pre-allocated fetches are never merged as the outputs are produced into new buffers.
+  bool can_merge = std::all_of(fetches.begin(), fetches.end(), [](const OrtValue* v) { return v == nullptr; });
+  if (can_merge) {
+    request.key.append(std::to_string(reinterpret_cast<uintptr_t>(run_options))).append(1, '\n');
+    for (const char* name : feed_names) {
+      request.key.append(name).append(1, '\n');
+    }
+    request.key.append(1, '\n');
+    for (const char* name : fetch_names) {
+      request.key.append(name).append(1, '\n');
+    }
+  }
+
+  size_t queue_depth = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ORT_RETURN_IF(shutdown_, "Request batcher is shutting down.");
+    pending_.push_back(std::move(request));
+    queue_depth = pending_.size();
+  }
+
+  // wake the collector to start the batch window of a new request, or to dispatch a full batch
+  if (queue_depth == 1 || queue_depth >= options_.max_batch_size) {
+    queue_cv_.notify_one();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++num_requests_;
+    max_queue_depth_ = std::max(max_queue_depth_, queue_depth);
+  }
+
+  return Status::OK();
+}
+
+RequestBatcher::Batch RequestBatcher::TakeBatchLocked() {
+  Batch batch;
+  batch.reserve(options_.max_batch_size);
+  batch.push_back(std::move(pending_.front()));
+  pending_.pop_front();
+
+  // an empty key marks a request that must run on its own
+  if (!batch.front().key.empty()) {
+    for (auto it = pending_.begin(); it != pending_.end() && batch.size() < options_.max_batch_size;) {
+      if (it->key == batch.front().key) {
+        batch.push_back(std::move(*it));
+        it = pending_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  return batch;
+}
+
+void RequestBatcher::CollectLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    queue_cv_.wait(lock, [this]() { return shutdown_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      break;
+    }
+
+    const auto deadline = pending_.front().submit_time + std::chrono::microseconds(options_.max_wait_us);
+    queue_cv_.wait_until(lock, deadline, [this]() {
+      return shutdown_ || pending_.size() >= options_.max_batch_size;
+    });
+
+    auto batch = std::make_shared<Batch>(TakeBatchLocked());
+    ++outstanding_tasks_;
+    lock.unlock();
+    schedule_fn_([this, batch]() {
+      ExecuteBatch(*batch);
+      OnTaskDone();
+    });
+    lock.lock();
+  }
+}
+
+void RequestBatcher::OnTaskDone() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  --outstanding_tasks_;
+  if (outstanding_tasks_ == 0) {
+    idle_cv_.notify_all();
+  }
+}
+
+void RequestBatcher::ExecuteBatch(Batch& batch) {
+  const auto dispatch_time = Clock::now();
+
+  if (batch.size() > 1) {
+    bool padded = false;
+    bool merged = false;
+    Status status = RunMerged(batch, padded, merged);
+    if (merged) {
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++num_batches_;
+        num_batched_requests_ += batch.size();
+        num_padded_batches_ += padded ? 1 : 0;
+      }
+      for (auto& request : batch) {
+        Complete(request, status, dispatch_time);
+      }
+      return;
+    }
+
+    // A failure of the merged run may be caused by a single request, or by a merged shape the model does not
+    // accept. Run the requests on their own so that each caller gets the result of its own request.
+    if (!status.IsOK()) {
+      LOGS_DEFAULT(VERBOSE) << "Batched run of " << batch.size() << " requests failed, running them separately: "
+                            << status.ErrorMessage();
+    }
+  }
+
+  for (auto& request : batch) {
+    RunUnbatched(request);
+    Complete(request, Status::OK(), dispatch_time);
+  }
+}
+
+void RequestBatcher::RunUnbatched(Request& request) {
+  Status status;
+  ORT_TRY {
+    RunOptions default_run_options;
+    status = run_fn_(request.run_options ? *request.run_options : default_run_options,
+                     request.feed_names, request.feeds, request.fetch_names, request.fetches);
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, ex.what());
+    });
+  }
+  ORT_CATCH(...) {
+    status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, "unknown exception");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++num_batches_;
+    ++num_batched_requests_;
+    ++num_unbatched_requests_;
+  }
+
+  request.callback(request.user_data, request.fetches.data(), status.IsOK() ? request.fetches.size() : 0,
+                   ToOrtStatus(status));
+  // signal to Complete() that the callback has already been invoked
+  request.callback = nullptr;
+}
+
+Status RequestBatcher::RunMerged(Batch& batch, bool& padded, bool& merged) {
+  padded = false;
+  merged = false;
+
+  const size_t axis = options_.batch_axis;
+  const Request& first = batch.front();
+  const size_t num_feeds = first.feeds.size();
+  const size_t num_fetches = first.fetches.size();
+
+  // Work out the merged shape of every input, or bail out to the unbatched path.
+  InlinedVector<int64_t> batch_sizes(batch.size(), 0);
+  std::vector<TensorShapeVector> merged_dims(num_feeds);
+  for (size_t i = 0; i < num_feeds; ++i) {
+    for (size_t r = 0; r < batch.size(); ++r) {
+      const OrtValue* feed = batch[r].feeds[i];
+      if (!IsMergeableTensor(feed, axis)) {
+        return Status::OK();
+      }
+      const auto& tensor = feed->Get<Tensor>();
+      const auto dims = tensor.Shape().GetDims();
+
+      if (i == 0) {
+        batch_sizes[r] = dims[axis];
+      } else if (batch_sizes[r] != dims[axis]) {
+        // all inputs of one request must agree on the batch size
+        return Status::OK();
+      }
+
+      if (r == 0) {
+        merged_dims[i].assign(dims.begin(), dims.end());
+        merged_dims[i][axis] = 0;
+      } else {
+        const auto& first_tensor = first.feeds[i]->Get<Tensor>();
+        if (first_tensor.DataType() != tensor.DataType() || merged_dims[i].size() != dims.size()) {
+          return Status::OK();
+        }
+        for (size_t d = 0; d < dims.size(); ++d) {
+          if (d != axis && merged_dims[i][d] != dims[d]) {
+            if (!options_.pad_ragged_axes) {
+              return Status::OK();
+            }
+            padded = true;
+            merged_dims[i][d] = std::max(merged_dims[i][d], dims[d]);
+          }
+        }
+      }
+      merged_dims[i][axis] += dims[axis];
+    }
+  }
+
+  const int64_t total_batch = std::accumulate(batch_sizes.begin(), batch_sizes.end(), int64_t{0});
+
+  // An allocation failure while merging the inputs or splitting the outputs fails every request of the batch.
+  auto fail_batch = [&merged](const char* step, const char* what) {
+    merged = true;
+    return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Failed to ", step, " of the batched run: ", what);
+  };
+
+  std::vector<OrtValue> merged_feeds(num_feeds);
+  InlinedVector<const OrtValue*> merged_feed_ptrs(num_feeds);
+  Status status;
+  ORT_TRY {
+    for (size_t i = 0; i < num_feeds; ++i) {
+      const auto& first_tensor = first.feeds[i]->Get<Tensor>();
+      Tensor::InitOrtValue(first_tensor.DataType(), TensorShape(merged_dims[i]), cpu_allocator_, merged_feeds[i]);
+      auto& dst = *merged_feeds[i].GetMutable<Tensor>();
+      if (padded) {
+        std::memset(dst.MutableDataRaw(), 0, dst.SizeInBytes());
+      }
+
+      int64_t batch_offset = 0;
+      for (size_t r = 0; r < batch.size(); ++r) {
+        CopyIntoBatch(batch[r].feeds[i]->Get<Tensor>(), dst, axis, batch_offset);
+        batch_offset += batch_sizes[r];
+      }
+      merged_feed_ptrs[i] = &merged_feeds[i];
+    }
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = fail_batch("merge the inputs", ex.what());
+    });
+  }
+  ORT_CATCH(...) {
+    status = fail_batch("merge the inputs", "unknown exception");
+  }
+
+  if (!status.IsOK()) {
+    return status;
+  }
+
+  InlinedVector<OrtValue*> merged_fetches(num_fetches, nullptr);
+  auto release_merged_fetches = gsl::finally([&merged_fetches]() {
+    for (OrtValue* value : merged_fetches) {
+      delete value;
+    }
+  });
+
+  ORT_TRY {
+    RunOptions default_run_options;
+    status = run_fn_(first.run_options ? *first.run_options : default_run_options,
+                     first.feed_names, merged_feed_ptrs, first.fetch_names, merged_fetches);
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, ex.what());
+    });
+  }
+  ORT_CATCH(...) {
+    status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, "unknown exception");
+  }
+
+  if (!status.IsOK()) {
+    return status;
+  }
+
+  // The outputs must also be batched along the same axis for them to be split back to the requests.
+  for (const OrtValue* fetch : merged_fetches) {
+    if (!IsMergeableTensor(fetch, axis) || fetch->Get<Tensor>().Shape()[axis] != total_batch) {
+      return Status::OK();
+    }
+  }
+
+  ORT_TRY {
+    int64_t batch_offset = 0;
+    for (size_t r = 0; r < batch.size(); ++r) {
+      for (size_t o = 0; o < num_fetches; ++o) {
+        const auto& src = merged_fetches[o]->Get<Tensor>();
+        TensorShape dst_shape = src.Shape();
+        dst_shape[axis] = batch_sizes[r];
+        auto value = std::make_unique<OrtValue>();
+        Tensor::InitOrtValue(src.DataType(), dst_shape, cpu_allocator_, *value);
+        CopyFromBatch(src, *value->GetMutable<Tensor>(), axis, batch_offset);
+        batch[r].fetches[o] = value.release();
+      }
+      batch_offset += batch_sizes[r];
+    }
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = fail_batch("split the outputs", ex.what());
+    });
+  }
+  ORT_CATCH(...) {
+    status = fail_batch("split the outputs", "unknown exception");
+  }
+
+  if (!status.IsOK()) {
+    // release the outputs of the requests that were already split
+    for (auto& request : batch) {
+      for (OrtValue*& fetch : request.fetches) {
+        delete fetch;
+        fetch = nullptr;
+      }
+    }
+    return status;
+  }
+
+  merged = true;
+  return Status::OK();
+}
+
+void RequestBatcher::Complete(Request& request, const Status& status, Clock::time_point dispatch_time) {
+  if (request.callback != nullptr) {
+    request.callback(request.user_data, request.fetches.data(), status.IsOK() ? request.fetches.size() : 0,
+                     ToOrtStatus(status));
+  }
+
+  const auto now = Clock::now();
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  const int64_t queue_wait = ToMicroseconds(dispatch_time - request.submit_time);
+  const int64_t latency = ToMicroseconds(now - request.submit_time);
+  if (queue_wait_samples_.size() < kStatsWindow) {
+    queue_wait_samples_.push_back(queue_wait);
+    latency_samples_.push_back(latency);
+  } else {
+    queue_wait_samples_[next_sample_] = queue_wait;
+    latency_samples_[next_sample_] = latency;
+  }
+  next_sample_ = (next_sample_ + 1) % kStatsWindow;
+}
+
+RequestBatcherStats RequestBatcher::GetStats() const {
+  RequestBatcherStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.queue_depth = pending_.size();
+  }
+
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats.num_requests = num_requests_;
+  stats.num_batches = num_batches_;
+  stats.num_padded_batches = num_padded_batches_;
+  stats.num_unbatched_requests = num_unbatched_requests_;
+  stats.mean_batch_size = num_batches_ == 0 ? 0.0
+                                            : static_cast<double>(num_batched_requests_) / static_cast<double>(num_batches_);
+  stats.max_queue_depth = max_queue_depth_;
+  stats.queue_wait_us_p50 = Percentile(queue_wait_samples_, 0.50);
+  stats.queue_wait_us_p99 = Percentile(queue_wait_samples_, 0.99);
+  stats.latency_us_p50 = Percentile(latency_samples_, 0.50);
+  stats.latency_us_p99 = Percentile(latency_samples_, 0.99);
+  return stats;
+}
+
+}  // namespace onnxruntime
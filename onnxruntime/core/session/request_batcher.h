@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/common/inlined_containers.h"
+#include "core/common/status.h"
+#include "core/framework/allocator.h"
+#include "core/framework/config_options.h"
+#include "core/framework/ort_value.h"
+#include "core/framework/run_options.h"
+#include "core/session/onnxruntime_c_api.h"
+
+namespace onnxruntime {
+
+/**
+ * Options controlling how concurrent RunAsync requests are coalesced into a single Run.
+ * Populated from the "session.batching.*" session config entries.
+ */
+struct RequestBatcherOptions {
+  // Maximum number of requests merged into one Run.
+  size_t max_batch_size = 8;
+
+  // Maximum time the oldest pending request waits for more requests to arrive.
+  int64_t max_wait_us = 1000;
+
+  // Axis along which inputs are concatenated and outputs are split.
+  size_t batch_axis = 0;
+
+  // If true, inputs whose non-batch dimensions differ are zero padded to the largest extent in the batch.
+  // Outputs are then returned with the padded extents.
+  bool pad_ragged_axes = false;
+
+  static Status FromConfigOptions(const ConfigOptions& config_options, RequestBatcherOptions& options);
+};
+
+/**
+ * Snapshot of the batcher statistics. Latencies are measured from submission of a request until its callback
+ * is invoked; queue wait is measured from submission until the batch containing the request starts running.
+ * Percentiles are computed over a window of the most recent requests.
+ */
+struct RequestBatcherStats {
+  uint64_t num_requests = 0;
+  uint64_t num_batches = 0;
+  uint64_t num_padded_batches = 0;
+  // Requests that could not be merged (e.g. incompatible shapes) and were run on their own.
+  uint64_t num_unbatched_requests = 0;
+  double mean_batch_size = 0.0;
+
+  size_t queue_depth = 0;
+  size_t max_queue_depth = 0;
+
+  int64_t queue_wait_us_p50 = 0;
+  int64_t queue_wait_us_p99 = 0;
+  int64_t latency_us_p50 = 0;
+  int64_t latency_us_p99 = 0;
+};
+
+/**
+ * Coalesces requests submitted through Submit() into batched Run calls.
+ *
+ * Requests are compatible when they use the same RunOptions instance and the same feed and fetch names.
+ * Inputs are concatenated along RequestBatcherOptions::batch_axis, the merged request is run once, and every
+ * output is split back along the same axis and handed to each caller's RunAsyncCallbackFn.
+ * Only CPU tensors of fixed size element types can be merged; anything else is run request by request.
+ *
+ * Requests are collected on a thread owned by the batcher, which spends most of its time waiting for the batch
+ * window to close. Batches are executed through the supplied function, which the session binds to its intra-op
+ * thread pool in the same way as InferenceSession::RunAsync.
+ */
+class RequestBatcher {
+ public:
+  using RunFn = std::function<Status(const RunOptions& run_options,
+                                     gsl::span<const char* const> feed_names,
+                                     gsl::span<const OrtValue* const> feeds,
+                                     gsl::span<const char* const> fetch_names,
+                                     gsl::span<OrtValue*> fetches)>;
+  using ScheduleFn = std::function<void(std::function<void()>)>;
+
+  RequestBatcher(const RequestBatcherOptions& options, AllocatorPtr cpu_allocator,
+                 RunFn run_fn, ScheduleFn schedule_fn);
+
+  // Flushes any pending requests and waits for all scheduled batches to complete.
+  ~RequestBatcher();
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(RequestBatcher);
+
+  // The caller must keep run_options, names, feeds and fetches alive until the callback is invoked,
+  // which matches the contract of InferenceSession::RunAsync.
+  Status Submit(const RunOptions* run_options,
+                gsl::span<const char* const> feed_names,
+                gsl::span<const OrtValue* const> feeds,
+                gsl::span<const char* const> fetch_names,
+                gsl::span<OrtValue*> fetches,
+                RunAsyncCallbackFn callback,
+                void* user_data);
+
+  RequestBatcherStats GetStats() const;
+
+  const RequestBatcherOptions& Options() const { return options_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Request {
+    const RunOptions* run_options;
+    gsl::span<const char* const> feed_names;
+    gsl::span<const OrtValue* const> feeds;
+    gsl::span<const char* const> fetch_names;
+    gsl::span<OrtValue*> fetches;
+    RunAsyncCallbackFn callback;
+    void* user_data;
+    std::string key;
+    Clock::time_point submit_time;
+  };
+
+  using Batch = std::vector<Request>;
+
+  void CollectLoop();
+  Batch TakeBatchLocked();
+  void ExecuteBatch(Batch& batch);
+  void RunUnbatched(Request& request);
+  // Runs the batch as one request. merged is set if the merged run decided the result of every request: either each
+  // request got its outputs, or allocating the merged inputs or split outputs failed and the returned status fails
+  // them all. Otherwise the returned status is that of the merged run and the requests are run on their own.
+  Status RunMerged(Batch& batch, bool& padded, bool& merged);
+  void Complete(Request& request, const Status& status, Clock::time_point dispatch_time);
+  void OnTaskDone();
+
+  const RequestBatcherOptions options_;
+  AllocatorPtr cpu_allocator_;
+  RunFn run_fn_;
+  ScheduleFn schedule_fn_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::condition_variable idle_cv_;
+  std::deque<Request> pending_;   // GUARDED_BY(mutex_)
+  bool shutdown_ = false;         // GUARDED_BY(mutex_)
+  size_t outstanding_tasks_ = 0;  // GUARDED_BY(mutex_)
+  std::thread collector_;
+
+  // Statistics. Sample windows are ring buffers of the most recent requests.
+  static constexpr size_t kStatsWindow = 1024;
+  mutable std::mutex stats_mutex_;
+  uint64_t num_requests_ = 0;
+  uint64_t num_batches_ = 0;
+  uint64_t num_batched_requests_ = 0;
+  uint64_t num_padded_batches_ = 0;
+  uint64_t num_unbatched_requests_ = 0;
+  size_t max_queue_depth_ = 0;
+  std::vector<int64_t> queue_wait_samples_;
+  std::vector<int64_t> latency_samples_;
+  size_t next_sample_ = 0;
+};
+
+}  // namespace onnxruntime
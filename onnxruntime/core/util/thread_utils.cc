@@ -24,6 +24,9 @@ std::ostream& operator<<(std::ostream& os, const OrtThreadPoolParams& params) {
   os << " affinity_str: " << params.affinity_str;
   // os << " name: " << (params.name ? params.name : L"nullptr");
   os << " set_denormal_as_zero: " << params.set_denormal_as_zero;
+  os << " numa_aware: " << params.numa_aware;
+  os << " adaptive_parallelism: " << params.adaptive_parallelism;
+  os << " adaptive_spinning: " << params.adaptive_spinning;
   // os << " custom_create_thread_fn: " << (params.custom_create_thread_fn ? "set" : "nullptr");
   // os << " custom_thread_creation_options: " << (params.custom_thread_creation_options ? "set" : "nullptr");
   // os << " custom_join_thread_fn: " << (params.custom_join_thread_fn ? "set" : "nullptr");
@@ -89,6 +92,48 @@ static std::vector<LogicalProcessors> ReadThreadAffinityConfig(const std::string
 }
 #endif
 
+// Assigns the threads of a pool of thread_pool_size threads (including the main thread placeholder at index 0)
+// to NUMA nodes. A thread with an affinity goes to the node of its first logical processor. If no affinities are
+// set, the worker threads are split into contiguous blocks, one per node, and bound to the processors of their node.
+static void AssignNumaNodes(const Env& env, int thread_pool_size, ThreadOptions& to) {
+  const std::vector<LogicalProcessors> nodes = env.GetNumaNodeAffinities();
+  std::vector<int> node_ids;
+  for (size_t node = 0; node < nodes.size(); ++node) {
+    if (!nodes[node].empty()) {
+      node_ids.push_back(static_cast<int>(node));
+    }
+  }
+  if (node_ids.size() <= 1) {
+    LOGS_DEFAULT(INFO) << "NUMA aware thread pool requested, but a single NUMA node was found.";
+    return;
+  }
+
+  const size_t num_threads = static_cast<size_t>(thread_pool_size);
+  to.numa_nodes.assign(num_threads, -1);
+  if (to.affinities.empty()) {
+    to.affinities.resize(num_threads);
+    const size_t num_workers = num_threads - 1;
+    for (size_t worker = 0; worker < num_workers; ++worker) {
+      const int node = node_ids[worker * node_ids.size() / num_workers];
+      to.numa_nodes[worker + 1] = node;
+      to.affinities[worker + 1] = nodes[node];
+    }
+  } else {
+    for (size_t i = 1; i < std::min(num_threads, to.affinities.size()); ++i) {
+      if (to.affinities[i].empty()) {
+        continue;
+      }
+      const int processor = to.affinities[i].front();
+      for (int node : node_ids) {
+        if (std::find(nodes[node].begin(), nodes[node].end(), processor) != nodes[node].end()) {
+          to.numa_nodes[i] = node;
+          break;
+        }
+      }
+    }
+  }
+}
+
 static std::unique_ptr<ThreadPool>
 CreateThreadPoolHelper(Env* env, OrtThreadPoolParams options) {
   ThreadOptions to;
@@ -145,6 +190,12 @@ CreateThreadPoolHelper(Env* env, OrtThreadPoolParams options) {
 #endif
   }
 
+  if (options.numa_aware) {
+    AssignNumaNodes(*env, options.thread_pool_size, to);
+  }
+
+  to.adaptive_parallelism = options.adaptive_parallelism;
+  to.adaptive_spinning = options.adaptive_spinning;
   to.set_denormal_as_zero = options.set_denormal_as_zero;
   // set custom thread management members
   to.custom_create_thread_fn = options.custom_create_thread_fn;
@@ -271,4 +322,12 @@ ORT_API_STATUS_IMPL(SetGlobalIntraOpThreadAffinity, _Inout_ OrtThreadingOptions*
 #endif
 }
 
+ORT_API_STATUS_IMPL(SetGlobalIntraOpAdaptiveParallelism, _Inout_ OrtThreadingOptions* tp_options, int enable) {
+  if (!tp_options) {
+    return OrtApis::CreateStatus(ORT_INVALID_ARGUMENT, "Received null OrtThreadingOptions");
+  }
+  tp_options->intra_op_thread_pool_params.adaptive_parallelism = enable != 0;
+  return nullptr;
+}
+
 }  // namespace OrtApis
@@ -42,6 +42,18 @@ struct OrtThreadPoolParams {
   // Set or unset denormal as zero
   bool set_denormal_as_zero = false;
 
+  // If it is true and the machine has more than one NUMA node, group the threads by node. Threads without an
+  // affinity are split into one contiguous block per node and bound to the logical processors of their node.
+  bool numa_aware = false;
+
+  // If it is true, the degree of parallelism of each parallel loop adapts to the number and priorities of the
+  // callers running loops on the pool at the same time. See concurrency::ThreadPool::SchedulingContext.
+  bool adaptive_parallelism = false;
+
+  // If it is true, idle threads spin for a duration learned from recent task inter-arrival times, bounded by a
+  // spin budget, rather than for a fixed count. Has no effect unless allow_spinning is true.
+  bool adaptive_spinning = false;
+
   // members to manage custom threads
   OrtCustomCreateThreadFn custom_create_thread_fn = nullptr;
   void* custom_thread_creation_options = nullptr;
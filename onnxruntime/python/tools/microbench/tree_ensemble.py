@@ -0,0 +1,99 @@
+# -------------------------------------------------------------------------
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT License.
+# --------------------------------------------------------------------------
+
+"""
+Compares the bitvector (QuickScorer) engine and the flat layout with the node by node traversal of the CPU tree
+ensemble kernels on LightGBM and XGBoost models converted with onnxmltools.
+
+Requires lightgbm, xgboost, scikit-learn and onnxmltools:
+    python tree_ensemble.py --frameworks lightgbm xgboost --n_trees 100 1000 5000 --batch_sizes 1 100 10000
+"""
+
+import argparse
+import time
+
+import numpy as np
+
+import onnxruntime as ort
+
+
+def train_model(framework, n_trees, n_features, max_depth):
+    from sklearn.datasets import make_regression
+
+    x, y = make_regression(n_samples=10000, n_features=n_features, noise=0.1, random_state=0)
+    x = x.astype(np.float32)
+    if framework == "lightgbm":
+        from lightgbm import LGBMRegressor
+        from onnxmltools import convert_lightgbm
+        from onnxmltools.convert.common.data_types import FloatTensorType
+
+        model = LGBMRegressor(n_estimators=n_trees, num_leaves=2**max_depth, max_depth=max_depth, verbose=-1)
+        model.fit(x, y)
+        onx = convert_lightgbm(model, initial_types=[("X", FloatTensorType([None, n_features]))])
+    elif framework == "xgboost":
+        from onnxmltools import convert_xgboost
+        from onnxmltools.convert.common.data_types import FloatTensorType
+        from xgboost import XGBRegressor
+
+        model = XGBRegressor(n_estimators=n_trees, max_depth=max_depth, tree_method="hist")
+        model.fit(x, y)
+        onx = convert_xgboost(model, initial_types=[("X", FloatTensorType([None, n_features]))])
+    else:
+        raise ValueError(f"Unknown framework {framework}")
+    return onx.SerializeToString(), x
+
+
+def create_session(model, quick_scorer, flat_layout, intra_op_num_threads):
+    so = ort.SessionOptions()
+    so.intra_op_num_threads = intra_op_num_threads
+    so.add_session_config_entry("ml.tree_ensemble.enable_quickscorer", "1" if quick_scorer else "0")
+    so.add_session_config_entry("ml.tree_ensemble.enable_flat_layout", "1" if flat_layout else "0")
+    return ort.InferenceSession(model, so, providers=["CPUExecutionProvider"])
+
+
+def measure(sess, feeds, repeat):
+    sess.run(None, feeds)
+    start = time.perf_counter()
+    for _ in range(repeat):
+        outputs = sess.run(None, feeds)
+    return (time.perf_counter() - start) / repeat, outputs
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--frameworks", nargs="+", default=["lightgbm", "xgboost"], choices=["lightgbm", "xgboost"])
+    parser.add_argument("--n_trees", nargs="+", type=int, default=[100, 500, 1000, 5000])
+    parser.add_argument("--batch_sizes", nargs="+", type=int, default=[1, 100, 10000])
+    parser.add_argument("--n_features", type=int, default=50)
+    parser.add_argument(
+        "--max_depth", type=int, default=6, help="Trees need at most 64 leaves to use the QuickScorer engine."
+    )
+    parser.add_argument("--intra_op_num_threads", type=int, default=0)
+    parser.add_argument("--repeat", type=int, default=20)
+    args = parser.parse_args()
+
+    for framework in args.frameworks:
+        for n_trees in args.n_trees:
+            model, x = train_model(framework, n_trees, args.n_features, args.max_depth)
+            traversal = create_session(model, False, False, args.intra_op_num_threads)
+            flat_layout = create_session(model, False, True, args.intra_op_num_threads)
+            quick_scorer = create_session(model, True, False, args.intra_op_num_threads)
+            for batch_size in args.batch_sizes:
+                feeds = {"X": x[:batch_size] if batch_size <= x.shape[0] else np.resize(x, (batch_size, x.shape[1]))}
+                t_traversal, expected = measure(traversal, feeds, args.repeat)
+                t_flat_layout, got_flat_layout = measure(flat_layout, feeds, args.repeat)
+                t_quick_scorer, got_quick_scorer = measure(quick_scorer, feeds, args.repeat)
+                np.testing.assert_allclose(expected[0], got_flat_layout[0], rtol=1e-5, atol=1e-5)
+                np.testing.assert_allclose(expected[0], got_quick_scorer[0], rtol=1e-5, atol=1e-5)
+                print(
+                    f"{framework:>8} trees={n_trees:5d} batch={batch_size:6d} "
+                    f"traversal={t_traversal * 1000:9.4f} ms "
+                    f"flat_layout={t_flat_layout * 1000:9.4f} ms ({t_traversal / t_flat_layout:5.2f}x) "
+                    f"quickscorer={t_quick_scorer * 1000:9.4f} ms ({t_traversal / t_quick_scorer:5.2f}x)"
+                )
+
+
+if __name__ == "__main__":
+    main()
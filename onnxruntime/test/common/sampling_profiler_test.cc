@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/common/sampling_profiler.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace onnxruntime {
+namespace test {
+
+using profiling::SamplingProfiler;
+
+TEST(SamplingProfilerTest, BucketsBoundRelativeError) {
+  size_t previous_index = 0;
+  for (uint64_t value = 1; value < (uint64_t{1} << 36); value = value * 5 / 4 + 1) {
+    const size_t index = SamplingProfiler::BucketIndex(value);
+    ASSERT_GE(index, previous_index);
+    ASSERT_LT(index, SamplingProfiler::kNumBuckets);
+    const double midpoint = SamplingProfiler::BucketMidpoint(index);
+    ASSERT_LE(std::abs(midpoint - static_cast<double>(value)), 0.125 * static_cast<double>(value) + 0.5)
+        << "value " << value << " bucket " << index;
+    previous_index = index;
+  }
+  // Values beyond the range of the histogram land in the last bucket.
+  EXPECT_EQ(SamplingProfiler::BucketIndex(~uint64_t{0}), SamplingProfiler::kNumBuckets - 1);
+}
+
+TEST(SamplingProfilerTest, AggregatesByOpType) {
+  SamplingProfiler profiler(1, nullptr);
+  for (int i = 1; i <= 100; i++) {
+    ASSERT_TRUE(profiler.ShouldSample());
+    profiler.RecordNode("Conv", i * 1000, 16);
+  }
+  ASSERT_TRUE(profiler.ShouldSample());
+  profiler.RecordNode("Relu", 1000, 8);
+
+  const std::string snapshot = profiler.Snapshot();
+  // Conv took the most time, so it is listed first.
+  const auto conv = snapshot.find("{\"op_type\": \"Conv\", \"samples\": 100,");
+  const auto relu = snapshot.find("{\"op_type\": \"Relu\", \"samples\": 1,");
+  ASSERT_NE(conv, std::string::npos) << snapshot;
+  ASSERT_NE(relu, std::string::npos) << snapshot;
+  EXPECT_LT(conv, relu);
+  EXPECT_NE(snapshot.find("\"max_us\": 100.000, \"output_bytes\": 1600}"), std::string::npos) << snapshot;
+  EXPECT_NE(snapshot.find("\"thread_pool\": {\"num_threads\": 0, \"utilization\": 0.000}"), std::string::npos)
+      << snapshot;
+
+  // The p50 of 1..100us is about 50us, and the p99 about 99us.
+  const auto p50 = snapshot.find("\"p50_us\": ", conv);
+  const auto p99 = snapshot.find("\"p99_us\": ", conv);
+  EXPECT_NEAR(std::stod(snapshot.substr(p50 + 10)), 50.0, 50.0 * 0.125);
+  EXPECT_NEAR(std::stod(snapshot.substr(p99 + 10)), 99.0, 99.0 * 0.125);
+}
+
+TEST(SamplingProfilerTest, SamplesOneInInterval) {
+  SamplingProfiler profiler(4, nullptr);
+  int sampled = 0;
+  for (int i = 0; i < 40; i++) {
+    if (profiler.ShouldSample()) {
+      sampled++;
+      profiler.RecordNode("Add", 100, 0);
+    }
+  }
+  EXPECT_EQ(sampled, 10);
+  EXPECT_NE(profiler.Snapshot().find("\"op_type\": \"Add\", \"samples\": 10,"), std::string::npos);
+}
+
+TEST(SamplingProfilerTest, SnapshotWhileRecordingOnManyThreads) {
+  SamplingProfiler profiler(1, nullptr);
+  constexpr int num_threads = 4;
+  constexpr int num_samples = 10000;
+  const std::vector<std::string> op_types = {"MatMul", "Add", "Gelu", "LayerNormalization"};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < num_samples; i++) {
+        if (profiler.ShouldSample()) {
+          profiler.RecordNode(op_types[i % op_types.size()], 1000, 4);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 10; i++) {
+    EXPECT_NE(profiler.Snapshot().find("\"dropped_samples\": 0,"), std::string::npos);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const std::string snapshot = profiler.Snapshot();
+  for (const auto& op_type : op_types) {
+    const std::string expected = "\"op_type\": \"" + op_type + "\", \"samples\": " +
+                                 std::to_string(num_threads * num_samples / op_types.size()) + ",";
+    EXPECT_NE(snapshot.find(expected), std::string::npos) << snapshot;
+  }
+}
+
+TEST(SamplingProfilerTest, ManyProfilersOnOneThread) {
+  // A thread that runs nodes of many sessions keeps finding its buffer in each of their profilers.
+  constexpr int num_profilers = 16;
+  constexpr int num_runs = 1000;
+  std::vector<std::unique_ptr<SamplingProfiler>> profilers;
+  for (int p = 0; p < num_profilers; p++) {
+    profilers.push_back(std::make_unique<SamplingProfiler>(p + 1, nullptr));
+  }
+  for (int i = 0; i < num_runs; i++) {
+    for (auto& profiler : profilers) {
+      if (profiler->ShouldSample()) {
+        profiler->RecordNode("Add", 100, 0);
+      }
+    }
+  }
+  for (int p = 0; p < num_profilers; p++) {
+    // The first run is sampled, then one in every p + 1.
+    const std::string expected = "\"op_type\": \"Add\", \"samples\": " + std::to_string((num_runs + p) / (p + 1)) + ",";
+    EXPECT_NE(profilers[p]->Snapshot().find(expected), std::string::npos) << profilers[p]->Snapshot();
+  }
+}
+
+TEST(SamplingProfilerTest, ShortLivedProfilers) {
+  // A thread that runs nodes of many short lived sessions drops its entries of the destroyed profilers.
+  auto long_lived = std::make_unique<SamplingProfiler>(1, nullptr);
+  for (int i = 0; i < 1000; i++) {
+    SamplingProfiler profiler(1, nullptr);
+    ASSERT_TRUE(profiler.ShouldSample());
+    profiler.RecordNode("Add", 100, 0);
+    ASSERT_NE(profiler.Snapshot().find("\"op_type\": \"Add\", \"samples\": 1,"), std::string::npos);
+
+    ASSERT_TRUE(long_lived->ShouldSample());
+    long_lived->RecordNode("Mul", 100, 0);
+  }
+  EXPECT_NE(long_lived->Snapshot().find("\"op_type\": \"Mul\", \"samples\": 1000,"), std::string::npos);
+}
+
+TEST(SamplingProfilerTest, EscapesOpTypes) {
+  SamplingProfiler profiler(1, nullptr);
+  ASSERT_TRUE(profiler.ShouldSample());
+  profiler.RecordNode("My\"Op\\\n\x01", 1000, 0);
+  EXPECT_NE(profiler.Snapshot().find("{\"op_type\": \"My\\\"Op\\\\\\n\\u0001\", \"samples\": 1,"), std::string::npos)
+      << profiler.Snapshot();
+}
+
+TEST(SamplingProfilerTest, ManyOpTypes) {
+  SamplingProfiler profiler(1, nullptr);
+  for (size_t i = 0; i < SamplingProfiler::kMaxOpTypes + 10; i++) {
+    ASSERT_TRUE(profiler.ShouldSample());
+    profiler.RecordNode("CustomOp" + std::to_string(i), 1000, 0);
+  }
+  // Samples of op types beyond the capacity of the table are counted, but not recorded.
+  EXPECT_NE(profiler.Snapshot().find("\"dropped_samples\": 10,"), std::string::npos);
+}
+
+}  // namespace test
+}  // namespace onnxruntime
@@ -1,10 +1,15 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <string>
 #include <vector>
 #include "gtest/gtest.h"
 #include <gsl/gsl>
+#include "core/graph/onnx_protobuf.h"
 #include "core/session/onnxruntime_cxx_api.h"
 #include "test/common/cuda_op_test_utils.h"
 
@@ -183,5 +188,256 @@ TEST(GreedySearchTest, GptGreedySearchFp32) {
   }
 }
 
+namespace {
+
+// Set an attribute of the GreedySearch node, replacing the existing one with the same name.
+void SetGreedySearchAttribute(ONNX_NAMESPACE::ModelProto& model_proto, const ONNX_NAMESPACE::AttributeProto& value) {
+  for (auto& node : *model_proto.mutable_graph()->mutable_node()) {
+    if (node.op_type() != "GreedySearch") {
+      continue;
+    }
+    auto* attributes = node.mutable_attribute();
+    auto it = std::find_if(attributes->begin(), attributes->end(),
+                           [&](const auto& attribute) { return attribute.name() == value.name(); });
+    *(it != attributes->end() ? &*it : node.add_attribute()) = value;
+  }
+}
+
+// Get an attribute of the GreedySearch node.
+ONNX_NAMESPACE::AttributeProto GetGreedySearchAttribute(const ONNX_NAMESPACE::ModelProto& model_proto,
+                                                        const std::string& name) {
+  for (const auto& node : model_proto.graph().node()) {
+    if (node.op_type() != "GreedySearch") {
+      continue;
+    }
+    for (const auto& attribute : node.attribute()) {
+      if (attribute.name() == name) {
+        return attribute;
+      }
+    }
+  }
+  return {};
+}
+
+// Remove an attribute of the GreedySearch node.
+void RemoveGreedySearchAttribute(ONNX_NAMESPACE::ModelProto& model_proto, const std::string& name) {
+  for (auto& node : *model_proto.mutable_graph()->mutable_node()) {
+    if (node.op_type() != "GreedySearch") {
+      continue;
+    }
+    auto* attributes = node.mutable_attribute();
+    attributes->erase(std::remove_if(attributes->begin(), attributes->end(),
+                                     [&](const auto& attribute) { return attribute.name() == name; }),
+                      attributes->end());
+  }
+}
+
+// Copy the decoder into a graph attribute with the given name, with the weight of its logits projection negated so
+// that it selects the token the decoder considers least likely. The weight is a float initializer of the main graph.
+ONNX_NAMESPACE::AttributeProto MakeNegatedLogitsDecoder(const ONNX_NAMESPACE::ModelProto& model_proto,
+                                                        const std::string& name) {
+  ONNX_NAMESPACE::AttributeProto decoder = GetGreedySearchAttribute(model_proto, "decoder");
+  decoder.set_name(name);
+  auto* graph = decoder.mutable_g();
+  graph->set_name(name);
+
+  auto logits_node = std::find_if(graph->mutable_node()->begin(), graph->mutable_node()->end(),
+                                  [](const auto& node) { return node.output(0) == "logits"; });
+  EXPECT_NE(logits_node, graph->mutable_node()->end());
+  EXPECT_EQ(logits_node->op_type(), "MatMul");
+
+  const auto& initializers = model_proto.graph().initializer();
+  auto weight = std::find_if(initializers.begin(), initializers.end(),
+                             [&](const auto& initializer) { return initializer.name() == logits_node->input(1); });
+  EXPECT_NE(weight, initializers.end());
+  EXPECT_EQ(weight->data_type(), ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+
+  auto* negated_weight = graph->add_initializer();
+  *negated_weight = *weight;
+  negated_weight->set_name(name + "_" + weight->name());
+  std::vector<float> values(weight->raw_data().size() / sizeof(float));
+  memcpy(values.data(), weight->raw_data().data(), values.size() * sizeof(float));
+  for (float& value : values) {
+    value = -value;
+  }
+  negated_weight->set_raw_data(values.data(), values.size() * sizeof(float));
+  logits_node->set_input(1, negated_weight->name());
+  return decoder;
+}
+
+ONNX_NAMESPACE::AttributeProto MakeIntAttribute(const std::string& name, int64_t value) {
+  ONNX_NAMESPACE::AttributeProto attribute;
+  attribute.set_name(name);
+  attribute.set_type(ONNX_NAMESPACE::AttributeProto_AttributeType_INT);
+  attribute.set_i(value);
+  return attribute;
+}
+
+// Run the GreedySearch model on CPU and return the sequences.
+std::vector<int32_t> RunGreedySearchOnCpu(const ONNX_NAMESPACE::ModelProto& model_proto,
+                                          std::vector<int32_t> input_ids,
+                                          int64_t batch_size,
+                                          int32_t max_length,
+                                          float repetition_penalty_value = 1.0f) {
+  std::string model_data;
+  EXPECT_TRUE(model_proto.SerializeToString(&model_data));
+  Ort::Session session(*ort_env, model_data.data(), model_data.size(), Ort::SessionOptions{});
+
+  std::vector<int64_t> input_ids_shape{batch_size, static_cast<int64_t>(input_ids.size()) / batch_size};
+  std::vector<int64_t> parameter_shape{1};
+  std::vector<int32_t> max_length_value{max_length};
+  std::vector<int32_t> min_length{1};
+  std::vector<float> repetition_penalty{repetition_penalty_value};
+
+  Ort::MemoryInfo info("Cpu", OrtDeviceAllocator, 0, OrtMemTypeDefault);
+  std::vector<Ort::Value> ort_inputs;
+  ort_inputs.push_back(Ort::Value::CreateTensor(
+      info, input_ids.data(), input_ids.size(), input_ids_shape.data(), input_ids_shape.size()));
+  ort_inputs.push_back(Ort::Value::CreateTensor(
+      info, max_length_value.data(), max_length_value.size(), parameter_shape.data(), parameter_shape.size()));
+  ort_inputs.push_back(Ort::Value::CreateTensor(
+      info, min_length.data(), min_length.size(), parameter_shape.data(), parameter_shape.size()));
+  ort_inputs.push_back(Ort::Value::CreateTensor(
+      info, repetition_penalty.data(), repetition_penalty.size(), parameter_shape.data(), parameter_shape.size()));
+  const char* input_names[] = {"input_ids", "max_length", "min_length", "repetition_penalty"};
+  const char* const output_names[] = {"sequences"};
+
+  auto ort_outputs = session.Run(Ort::RunOptions{}, input_names, ort_inputs.data(), ort_inputs.size(),
+                                 output_names, 1);
+  EXPECT_EQ(ort_outputs.size(), 1U);
+  auto shape = ort_outputs[0].GetTensorTypeAndShapeInfo().GetShape();
+  EXPECT_EQ(shape, (std::vector<int64_t>{batch_size, max_length}));
+  const auto* result_vals = ort_outputs[0].GetTensorData<int32_t>();
+  return std::vector<int32_t>(result_vals, result_vals + batch_size * max_length);
+}
+
+}  // namespace
+
+// The batch is a queue of requests with max_active_sequences, and each request should generate the same tokens as
+// when the whole batch is decoded together.
+TEST(GreedySearchTest, GptGreedySearchContinuousBatching) {
+  std::vector<int32_t> input_ids{
+      0, 0, 0, 52,
+      0, 0, 195, 731,
+      0, 52, 195, 731};
+  constexpr int64_t batch_size = 3;
+  constexpr int32_t max_length = 10;
+
+  ONNX_NAMESPACE::ModelProto model_proto;
+  {
+    std::ifstream model_file("testdata/transformers/tiny_gpt2_greedysearch_with_init_decoder.onnx",
+                             std::ios::binary);
+    ASSERT_TRUE(model_proto.ParseFromIstream(&model_file));
+  }
+
+  const auto expected_output = RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length);
+  SetGreedySearchAttribute(model_proto, MakeIntAttribute("max_active_sequences", 2));
+  EXPECT_EQ(RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length), expected_output);
+  SetGreedySearchAttribute(model_proto, MakeIntAttribute("max_active_sequences", 1));
+  EXPECT_EQ(RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length), expected_output);
+}
+
+// The repetition penalty and the n-gram blocking only see the tokens of each request when the requests of the
+// decoding batch have generated different numbers of tokens.
+TEST(GreedySearchTest, GptGreedySearchContinuousBatchingLogitsProcessors) {
+  std::vector<int32_t> input_ids{
+      0, 0, 0, 52,
+      0, 0, 195, 731,
+      0, 52, 195, 731};
+  constexpr int64_t batch_size = 3;
+  constexpr int32_t max_length = 12;
+  constexpr float repetition_penalty = 1.5f;
+
+  ONNX_NAMESPACE::ModelProto model_proto;
+  {
+    std::ifstream model_file("testdata/transformers/tiny_gpt2_greedysearch_with_init_decoder.onnx",
+                             std::ios::binary);
+    ASSERT_TRUE(model_proto.ParseFromIstream(&model_file));
+  }
+  SetGreedySearchAttribute(model_proto, MakeIntAttribute("no_repeat_ngram_size", 2));
+
+  // Use the second token generated for the first request as the end of sequence, so that it finishes early and the
+  // last request is admitted while the second one is still decoding.
+  const auto output = RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length, repetition_penalty);
+  SetGreedySearchAttribute(model_proto, MakeIntAttribute("eos_token_id", output[5]));
+
+  const auto expected_output = RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length,
+                                                    repetition_penalty);
+  SetGreedySearchAttribute(model_proto, MakeIntAttribute("max_active_sequences", 2));
+  EXPECT_EQ(RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length, repetition_penalty),
+            expected_output);
+}
+
+// Speculative decoding should generate the same tokens as greedy search. The decoder is used as its own draft model
+// so every proposed token is accepted.
+TEST(GreedySearchTest, GptGreedySearchSpeculativeDecoding) {
+  std::vector<int32_t> input_ids{
+      0, 0, 0, 52,
+      0, 0, 195, 731};
+  constexpr int64_t batch_size = 2;
+  constexpr int32_t max_length = 12;
+
+  ONNX_NAMESPACE::ModelProto model_proto;
+  {
+    std::ifstream model_file("testdata/transformers/tiny_gpt2_greedysearch_with_init_decoder.onnx",
+                             std::ios::binary);
+    ASSERT_TRUE(model_proto.ParseFromIstream(&model_file));
+  }
+
+  const auto expected_output = RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length);
+
+  ONNX_NAMESPACE::AttributeProto draft_decoder = GetGreedySearchAttribute(model_proto, "decoder");
+  ASSERT_TRUE(draft_decoder.has_g());
+  draft_decoder.set_name("draft_decoder");
+  draft_decoder.mutable_g()->set_name("draft_decoder");
+  SetGreedySearchAttribute(model_proto, draft_decoder);
+
+  for (int64_t num_speculative_tokens : {1, 3, 4}) {
+    SetGreedySearchAttribute(model_proto, MakeIntAttribute("num_speculative_tokens", num_speculative_tokens));
+    EXPECT_EQ(RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length), expected_output)
+        << "num_speculative_tokens: " << num_speculative_tokens;
+  }
+}
+
+// The draft model only differs from the decoder by its negated logits, so given the same tokens it proposes the token
+// with the lowest logit of the decoder. Every draft token is rejected, and speculative decoding should still generate
+// the same tokens as greedy search.
+TEST(GreedySearchTest, GptGreedySearchSpeculativeDecodingRejectedDrafts) {
+  std::vector<int32_t> input_ids{
+      0, 0, 0, 52,
+      0, 0, 195, 731};
+  constexpr int64_t batch_size = 2;
+  constexpr int64_t sequence_length = 4;
+  constexpr int32_t max_length = 12;
+
+  ONNX_NAMESPACE::ModelProto model_proto;
+  {
+    std::ifstream model_file("testdata/transformers/tiny_gpt2_greedysearch_with_init_decoder.onnx",
+                             std::ios::binary);
+    ASSERT_TRUE(model_proto.ParseFromIstream(&model_file));
+  }
+
+  const auto expected_output = RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length);
+
+  // The draft model disagrees with the decoder on the first token generated from the prompt.
+  {
+    ONNX_NAMESPACE::ModelProto draft_model_proto = model_proto;
+    RemoveGreedySearchAttribute(draft_model_proto, "init_decoder");
+    SetGreedySearchAttribute(draft_model_proto, MakeNegatedLogitsDecoder(model_proto, "decoder"));
+    const auto draft_output = RunGreedySearchOnCpu(draft_model_proto, input_ids, batch_size, max_length);
+    for (int64_t b = 0; b < batch_size; b++) {
+      EXPECT_NE(draft_output[b * max_length + sequence_length], expected_output[b * max_length + sequence_length])
+          << "batch: " << b;
+    }
+  }
+
+  SetGreedySearchAttribute(model_proto, MakeNegatedLogitsDecoder(model_proto, "draft_decoder"));
+  for (int64_t num_speculative_tokens : {1, 3, 4}) {
+    SetGreedySearchAttribute(model_proto, MakeIntAttribute("num_speculative_tokens", num_speculative_tokens));
+    EXPECT_EQ(RunGreedySearchOnCpu(model_proto, input_ids, batch_size, max_length), expected_output)
+        << "num_speculative_tokens: " << num_speculative_tokens;
+  }
+}
+
 }  // namespace test
 }  // namespace onnxruntime
@@ -6,7 +6,10 @@
 #include "core/framework/allocator_utils.h"
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <thread>
 #include "core/framework/stream_handles.h"
 
 namespace onnxruntime {
@@ -307,6 +310,198 @@ TEST(BFCArenaTest, TestShrink) {
   EXPECT_EQ(stats.total_allocated_bytes, 10 * 1024 * 1024) << "Expect 10M bytes but actually " << stats.total_allocated_bytes << " bytes";
 }
 
+TEST(BFCArenaTest, TestTrimIdleRegionsWatermarks) {
+  ArenaMemoryPressureConfig config;
+  config.trim_high_watermark_bytes = 4 * 1024 * 1024;
+  config.trim_low_watermark_bytes = 3 * 1024 * 1024;
+  BFCArena a(std::unique_ptr<IAllocator>(new CPUAllocator()), 1 << 30, ArenaExtendStrategy::kSameAsRequested,
+             BFCArena::DEFAULT_INITIAL_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_DEAD_BYTES_PER_CHUNK,
+             BFCArena::DEFAULT_INITIAL_GROWTH_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES,
+             config);
+  AllocatorStats stats;
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 3; i++) {
+    ptrs.push_back(a.Alloc(1024 * 1024));
+  }
+  for (void* p : ptrs) {
+    a.Free(p);
+  }
+  EXPECT_EQ(a.TrimIdleRegions(), Status::OK());
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_arena_trims, 0) << "the arena does not hold more than the high watermark";
+  EXPECT_EQ(stats.total_allocated_bytes, 3 * 1024 * 1024);
+
+  void* p1M = a.Alloc(1024 * 1024);
+  void* p2M = a.Alloc(2 * 1024 * 1024);
+  a.Free(p2M);
+  EXPECT_EQ(a.TrimIdleRegions(), Status::OK());
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_arena_trims, 2) << "trimming skips the region in use and stops at the low watermark";
+  EXPECT_EQ(stats.trimmed_bytes, 2 * 1024 * 1024);
+  EXPECT_EQ(stats.num_arena_shrinkages, 2);
+  EXPECT_EQ(stats.total_allocated_bytes, 3 * 1024 * 1024);
+  a.Free(p1M);
+}
+
+TEST(BFCArenaTest, TestTrimIdleRegionsIdleTime) {
+  ArenaMemoryPressureConfig config;
+  config.idle_region_release_ms = 50;
+  BFCArena a(std::unique_ptr<IAllocator>(new CPUAllocator()), 1 << 30, ArenaExtendStrategy::kSameAsRequested,
+             BFCArena::DEFAULT_INITIAL_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_DEAD_BYTES_PER_CHUNK,
+             BFCArena::DEFAULT_INITIAL_GROWTH_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES,
+             config);
+  AllocatorStats stats;
+
+  a.Free(a.Alloc(1024 * 1024));
+  EXPECT_EQ(a.TrimIdleRegions(), Status::OK());
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_arena_trims, 0) << "the region was used too recently";
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  EXPECT_EQ(a.TrimIdleRegions(), Status::OK());
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_arena_trims, 1);
+  EXPECT_EQ(stats.total_allocated_bytes, 0);
+}
+
+TEST(BFCArenaTest, TestTrimIdleRegionsLeastRecentlyUsed) {
+  ArenaMemoryPressureConfig config;
+  config.trim_high_watermark_bytes = 2 * 1024 * 1024;
+  config.trim_low_watermark_bytes = 2 * 1024 * 1024;
+  BFCArena a(std::unique_ptr<IAllocator>(new CPUAllocator()), 1 << 30, ArenaExtendStrategy::kSameAsRequested,
+             BFCArena::DEFAULT_INITIAL_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_DEAD_BYTES_PER_CHUNK,
+             BFCArena::DEFAULT_INITIAL_GROWTH_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES,
+             config);
+  AllocatorStats stats;
+
+  // The region allocated last is the one used least recently.
+  void* p2M = a.Alloc(2 * 1024 * 1024);
+  void* p1M = a.Alloc(1024 * 1024);
+  a.Free(p1M);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  a.Free(p2M);
+  EXPECT_EQ(a.TrimIdleRegions(), Status::OK());
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_arena_trims, 1);
+  EXPECT_EQ(stats.trimmed_bytes, 1024 * 1024);
+  EXPECT_EQ(stats.total_allocated_bytes, 2 * 1024 * 1024);
+}
+
+TEST(BFCArenaTest, TestBackgroundTrimming) {
+  OrtArenaCfg arena_cfg(0, 1, -1, -1, -1, -1L);
+  arena_cfg.background_trim_interval_ms = 1;
+  arena_cfg.idle_region_release_ms = 1;
+  AllocatorCreationInfo device_info{
+      [](OrtDevice::DeviceId) { return std::make_unique<CPUAllocator>(); },
+      0, true, arena_cfg};
+  auto allocator = CreateAllocator(device_info);
+  BFCArena& a = *static_cast<BFCArena*>(allocator.get());
+
+  a.Free(a.Alloc(1024 * 1024));
+  AllocatorStats stats;
+  for (int i = 0; i < 1000; i++) {
+    a.GetStats(&stats);
+    if (stats.num_arena_trims != 0) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(stats.num_arena_trims, 1);
+  EXPECT_EQ(stats.total_allocated_bytes, 0);
+
+  // Without an idle time, regions freed between runs would be released on every interval.
+  arena_cfg.idle_region_release_ms = 0;
+  AllocatorCreationInfo no_idle_time_info{
+      [](OrtDevice::DeviceId) { return std::make_unique<CPUAllocator>(); },
+      0, true, arena_cfg};
+  EXPECT_THROW(CreateAllocator(no_idle_time_info), OnnxRuntimeException);
+}
+
+TEST(BFCArenaTest, TestSizeClassCache) {
+  ArenaMemoryPressureConfig config;
+  config.size_class_cache_max_bytes = 1024;
+  BFCArena a(std::unique_ptr<IAllocator>(new CPUAllocator()), 1 << 30, ArenaExtendStrategy::kNextPowerOfTwo,
+             BFCArena::DEFAULT_INITIAL_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_DEAD_BYTES_PER_CHUNK,
+             BFCArena::DEFAULT_INITIAL_GROWTH_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES,
+             config);
+  AllocatorStats stats;
+
+  // A size class cache holds 256 blocks, after which allocations fall back to the arena.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 257; i++) {
+    ptrs.push_back(a.Alloc(1000));
+  }
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_size_class_cache_hits, 256);
+  EXPECT_EQ(stats.num_size_class_cache_misses, 1);
+  EXPECT_EQ(a.AllocatedSize(ptrs[0]), 1024u);
+  EXPECT_EQ(a.AllocatedSize(ptrs[256]), 1024u);
+
+  std::vector<void*> sorted_ptrs = ptrs;
+  std::sort(sorted_ptrs.begin(), sorted_ptrs.end());
+  for (size_t i = 1; i < sorted_ptrs.size(); i++) {
+    ASSERT_GE(static_cast<char*>(sorted_ptrs[i]) - static_cast<char*>(sorted_ptrs[i - 1]), 1024);
+  }
+
+  for (void* p : ptrs) {
+    a.Free(p);
+  }
+  void* p = a.Alloc(512);
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_size_class_cache_hits, 257);
+  a.Free(p);
+
+  // Allocations larger than size_class_cache_max_bytes do not use the caches.
+  a.Free(a.Alloc(1025));
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_size_class_cache_hits + stats.num_size_class_cache_misses, 258);
+}
+
+TEST(BFCArenaTest, TestSizeClassCacheConcurrentAllocations) {
+  ArenaMemoryPressureConfig config;
+  config.size_class_cache_max_bytes = 4096;
+  BFCArena a(std::unique_ptr<IAllocator>(new CPUAllocator()), 1 << 30, ArenaExtendStrategy::kNextPowerOfTwo,
+             BFCArena::DEFAULT_INITIAL_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_DEAD_BYTES_PER_CHUNK,
+             BFCArena::DEFAULT_INITIAL_GROWTH_CHUNK_SIZE_BYTES, BFCArena::DEFAULT_MAX_POWER_OF_TWO_EXTEND_BYTES,
+             config);
+
+  constexpr int num_threads = 4;
+  constexpr int num_iterations = 2000;
+  constexpr int num_live_buffers = 100;
+  std::atomic<int> corrupted_buffers{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<std::pair<int*, size_t>> buffers;
+      for (int i = 0; i < num_iterations; i++) {
+        const size_t num_ints = 16 + (i * 37 + t * 11) % 1000;
+        int* buffer = static_cast<int*>(a.Alloc(num_ints * sizeof(int)));
+        std::fill_n(buffer, num_ints, t * num_iterations + i);
+        buffers.emplace_back(buffer, num_ints);
+        if (buffers.size() == num_live_buffers || i == num_iterations - 1) {
+          for (const auto& [b, n] : buffers) {
+            if (std::any_of(b, b + n, [&](int v) { return v != b[0]; })) {
+              corrupted_buffers++;
+            }
+            a.Free(b);
+          }
+          buffers.clear();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(corrupted_buffers, 0);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(stats.num_size_class_cache_hits + stats.num_size_class_cache_misses, num_threads * num_iterations);
+  EXPECT_GT(stats.num_size_class_cache_hits, 0);
+}
+
 class BadAllocator : public IAllocator {
  public:
   BadAllocator() : IAllocator(OrtMemoryInfo(CPU, OrtAllocatorType::OrtDeviceAllocator)) {}
@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "core/framework/external_data_mapper.h"
+#include "test/util/include/asserts.h"
+#include "test/util/include/file_util.h"
+
+#include "gtest/gtest.h"
+
+namespace onnxruntime {
+namespace test {
+
+#if !defined(__wasm__)
+static std::basic_string<ORTCHAR_T> CreateDataFile(const std::vector<float>& data) {
+  FILE* fp;
+  std::basic_string<ORTCHAR_T> filename(ORT_TSTR("external_data_XXXXXX"));
+  CreateTestFile(fp, filename);
+  EXPECT_EQ(data.size() * sizeof(float), fwrite(data.data(), 1, data.size() * sizeof(float), fp));
+  EXPECT_EQ(0, fclose(fp));
+  return filename;
+}
+
+TEST(ExternalDataFileMapperTest, RegionsShareFileMapping) {
+  const std::vector<float> data{1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+  const auto filename = CreateDataFile(data);
+  ScopedFileDeleter file_deleter(filename);
+
+  ExternalDataFileMapper mapper(Env::Default(), /*map_files*/ true);
+
+  void* region_1 = nullptr;
+  OrtCallback deleter_1{nullptr, nullptr};
+  ASSERT_STATUS_OK(mapper.GetRegion(filename, 0, 2 * sizeof(float), region_1, deleter_1));
+  ASSERT_NE(region_1, nullptr);
+
+  void* region_2 = nullptr;
+  OrtCallback deleter_2{nullptr, nullptr};
+  ASSERT_STATUS_OK(mapper.GetRegion(filename, 2 * sizeof(float), 4 * sizeof(float), region_2, deleter_2));
+  ASSERT_NE(region_2, nullptr);
+
+  // both regions come from a single mapping of the file
+  EXPECT_EQ(static_cast<char*>(region_2) - static_cast<char*>(region_1), static_cast<ptrdiff_t>(2 * sizeof(float)));
+  EXPECT_EQ(memcmp(region_1, data.data(), 2 * sizeof(float)), 0);
+  EXPECT_EQ(memcmp(region_2, data.data() + 2, 4 * sizeof(float)), 0);
+
+  // the mapping outlives the mapper until the last region is released
+  deleter_1.f(deleter_1.param);
+  EXPECT_EQ(memcmp(region_2, data.data() + 2, 4 * sizeof(float)), 0);
+  deleter_2.f(deleter_2.param);
+}
+
+TEST(ExternalDataFileMapperTest, OutOfBoundsRegion) {
+  const auto filename = CreateDataFile({1.f, 2.f});
+  ScopedFileDeleter file_deleter(filename);
+
+  ExternalDataFileMapper mapper(Env::Default(), /*map_files*/ true);
+  void* region = nullptr;
+  OrtCallback deleter{nullptr, nullptr};
+  EXPECT_FALSE(mapper.GetRegion(filename, sizeof(float), 2 * sizeof(float), region, deleter).IsOK());
+  EXPECT_EQ(region, nullptr);
+}
+
+TEST(ExternalDataFileMapperTest, MappingDisabled) {
+  const auto filename = CreateDataFile({1.f, 2.f});
+  ScopedFileDeleter file_deleter(filename);
+
+  ExternalDataFileMapper mapper(Env::Default(), /*map_files*/ false);
+  void* region = nullptr;
+  OrtCallback deleter{nullptr, nullptr};
+  ASSERT_STATUS_OK(mapper.GetRegion(filename, 0, sizeof(float), region, deleter));
+  EXPECT_EQ(region, nullptr);
+  EXPECT_EQ(deleter.f, nullptr);
+}
+#endif
+
+}  // namespace test
+}  // namespace onnxruntime
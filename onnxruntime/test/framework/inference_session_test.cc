@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cfloat>
 #include <functional>
+#include <future>
 #include <iterator>
 #include <thread>
 #include <fstream>
@@ -18,6 +19,7 @@
 #include "core/common/profiler.h"
 #include "core/framework/compute_capability.h"
 #include "core/framework/data_transfer_manager.h"
+#include "core/framework/error_code_helper.h"
 #include "core/framework/execution_provider.h"
 #include "core/framework/kernel_registry.h"
 #include "core/framework/op_kernel.h"
@@ -46,6 +48,7 @@
 #include "core/session/environment.h"
 #include "core/session/IOBinding.h"
 #include "core/session/inference_session_utils.h"
+#include "core/session/ort_apis.h"
 #include "core/session/onnxruntime_session_options_config_keys.h"
 #include "core/session/onnxruntime_run_options_config_keys.h"
 #include "dummy_provider.h"
@@ -818,6 +821,48 @@ TEST(InferenceSessionTests, CheckRunProfilerStartTime) {
   ASSERT_TRUE(before_start_time <= profiling_start_time && profiling_start_time <= after_start_time);
 }
 
+TEST(InferenceSessionTests, CheckRunSamplingProfiler) {
+  SessionOptions so;
+
+  so.session_logid = "CheckRunSamplingProfiler";
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsConfigEnableSamplingProfiler, "1"));
+
+  InferenceSession session_object(so, GetEnvironment());
+  ASSERT_STATUS_OK(session_object.Load(MODEL_URI));
+  ASSERT_STATUS_OK(session_object.Initialize());
+
+  RunOptions run_options;
+  run_options.run_tag = "RunTag";
+
+  // The statistics can be read between runs without stopping the profiler.
+  std::string profile;
+  for (int i = 1; i <= 3; i++) {
+    RunModel(session_object, run_options);
+    ASSERT_STATUS_OK(session_object.GetSamplingProfile(profile));
+    ASSERT_TRUE(profile.find("{\"op_type\": \"Mul\", \"samples\": " + std::to_string(i) + ",") != string::npos)
+        << profile;
+  }
+  // Each run of mul_1.onnx produces a 3x2 float tensor.
+  ASSERT_TRUE(profile.find("\"output_bytes\": " + std::to_string(3 * 3 * 2 * sizeof(float)) + "}") != string::npos)
+      << profile;
+
+  // The trace profiler is not affected.
+  ASSERT_FALSE(session_object.GetProfiling().IsEnabled());
+}
+
+TEST(InferenceSessionTests, CheckSamplingProfilerDisabled) {
+  SessionOptions so;
+
+  so.session_logid = "CheckSamplingProfilerDisabled";
+
+  InferenceSession session_object(so, GetEnvironment());
+  ASSERT_STATUS_OK(session_object.Load(MODEL_URI));
+  ASSERT_STATUS_OK(session_object.Initialize());
+
+  std::string profile;
+  ASSERT_FALSE(session_object.GetSamplingProfile(profile).IsOK());
+}
+
 TEST(InferenceSessionTests, MultipleSessionsNoTimeout) {
   SessionOptions session_options;
 
@@ -3036,5 +3081,183 @@ TEST(InferenceSessionTests, InterThreadPoolWithDenormalAsZero) {
 }
 #endif
 
+namespace {
+struct BatchedRequest {
+  OrtValue input;
+  const OrtValue* feeds[1]{&input};
+  OrtValue* fetches[1]{nullptr};
+  Status status;
+  std::vector<int64_t> output_dims;
+  std::vector<float> output_values;
+  std::promise<void> done;
+};
+
+void BatchedRequestCallback(void* user_data, OrtValue** outputs, size_t num_outputs, OrtStatusPtr status) {
+  auto* request = static_cast<BatchedRequest*>(user_data);
+  request->status = ToStatus(status);
+  OrtApis::ReleaseStatus(status);
+  if (num_outputs == 1) {
+    std::unique_ptr<OrtValue> output(outputs[0]);
+    const auto& tensor = output->Get<Tensor>();
+    const auto dims = tensor.Shape().GetDims();
+    request->output_dims.assign(dims.begin(), dims.end());
+    const auto data = tensor.DataAsSpan<float>();
+    request->output_values.assign(data.begin(), data.end());
+  }
+  request->done.set_value();
+}
+
+// Submits one request per entry of `sequence_lengths` to a session running abs_free_dimensions.onnx
+// (input "x" with shape [batch, sequence, 5]) and waits for all of them to complete.
+void RunBatchedAbsRequests(InferenceSession& session, const std::vector<int64_t>& sequence_lengths,
+                           std::vector<std::unique_ptr<BatchedRequest>>& requests) {
+  static const char* const feed_names[] = {"x"};
+  static const char* const fetch_names[] = {"y"};
+
+  for (size_t r = 0; r < sequence_lengths.size(); ++r) {
+    auto request = std::make_unique<BatchedRequest>();
+    std::vector<int64_t> dims{1, sequence_lengths[r], 5};
+    std::vector<float> values(static_cast<size_t>(sequence_lengths[r] * 5));
+    for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = -static_cast<float>(r * 100 + i + 1);
+    }
+    CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], dims, values, &request->input);
+    requests.push_back(std::move(request));
+  }
+
+  for (auto& request : requests) {
+    ASSERT_STATUS_OK(session.RunBatchedAsync(nullptr, feed_names, request->feeds, fetch_names, request->fetches,
+                                             BatchedRequestCallback, request.get()));
+  }
+
+  for (auto& request : requests) {
+    request->done.get_future().wait();
+    ASSERT_STATUS_OK(request->status);
+  }
+}
+}  // namespace
+
+TEST(InferenceSessionTests, RunBatchedAsync) {
+  if constexpr (!SessionOptions::DEFAULT_USE_PER_SESSION_THREADS) {
+    GTEST_SKIP() << "Skipping the test";
+  }
+  SessionOptions so;
+  so.intra_op_param.thread_pool_size = 2;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingEnable, "1"));
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingMaxBatchSize, "4"));
+  // long enough for all requests to be queued before the first batch is dispatched
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingMaxWaitMicroseconds, "10000000"));
+
+  InferenceSession session{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session.Load(ORT_TSTR("testdata/abs_free_dimensions.onnx")));
+  ASSERT_STATUS_OK(session.Initialize());
+
+  std::vector<std::unique_ptr<BatchedRequest>> requests;
+  RunBatchedAbsRequests(session, {2, 2, 2, 2}, requests);
+
+  for (size_t r = 0; r < requests.size(); ++r) {
+    EXPECT_THAT(requests[r]->output_dims, ::testing::ElementsAre(1, 2, 5));
+    ASSERT_EQ(requests[r]->output_values.size(), 10u);
+    for (size_t i = 0; i < 10; ++i) {
+      EXPECT_EQ(requests[r]->output_values[i], static_cast<float>(r * 100 + i + 1));
+    }
+  }
+
+  RequestBatcherStats stats;
+  ASSERT_STATUS_OK(session.GetRequestBatcherStats(stats));
+  EXPECT_EQ(stats.num_requests, 4u);
+  EXPECT_EQ(stats.num_batches, 1u);
+  EXPECT_EQ(stats.num_unbatched_requests, 0u);
+  EXPECT_EQ(stats.mean_batch_size, 4.0);
+  EXPECT_EQ(stats.max_queue_depth, 4u);
+  EXPECT_EQ(stats.queue_depth, 0u);
+}
+
+TEST(InferenceSessionTests, RunBatchedAsyncRaggedInputs) {
+  if constexpr (!SessionOptions::DEFAULT_USE_PER_SESSION_THREADS) {
+    GTEST_SKIP() << "Skipping the test";
+  }
+  for (const bool pad : {false, true}) {
+    SessionOptions so;
+    so.intra_op_param.thread_pool_size = 2;
+    ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingEnable, "1"));
+    ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingMaxBatchSize, "3"));
+    ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingMaxWaitMicroseconds, "10000000"));
+    ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingPadRaggedAxes, pad ? "1" : "0"));
+
+    InferenceSession session{so, GetEnvironment()};
+    ASSERT_STATUS_OK(session.Load(ORT_TSTR("testdata/abs_free_dimensions.onnx")));
+    ASSERT_STATUS_OK(session.Initialize());
+
+    const std::vector<int64_t> sequence_lengths{1, 3, 2};
+    std::vector<std::unique_ptr<BatchedRequest>> requests;
+    RunBatchedAbsRequests(session, sequence_lengths, requests);
+
+    for (size_t r = 0; r < requests.size(); ++r) {
+      // padded requests get outputs with the padded sequence length, with zeros in the padded positions
+      const int64_t sequence_length = pad ? 3 : sequence_lengths[r];
+      EXPECT_THAT(requests[r]->output_dims, ::testing::ElementsAre(1, sequence_length, 5));
+      ASSERT_EQ(requests[r]->output_values.size(), static_cast<size_t>(sequence_length * 5));
+      for (size_t i = 0; i < requests[r]->output_values.size(); ++i) {
+        const bool is_padding = i >= static_cast<size_t>(sequence_lengths[r] * 5);
+        EXPECT_EQ(requests[r]->output_values[i], is_padding ? 0.0f : static_cast<float>(r * 100 + i + 1));
+      }
+    }
+
+    RequestBatcherStats stats;
+    ASSERT_STATUS_OK(session.GetRequestBatcherStats(stats));
+    EXPECT_EQ(stats.num_requests, 3u);
+    EXPECT_EQ(stats.num_padded_batches, pad ? 1u : 0u);
+    EXPECT_EQ(stats.num_unbatched_requests, pad ? 0u : 3u);
+  }
+}
+
+TEST(InferenceSessionTests, RunBatchedAsyncMergedRunFailure) {
+  if constexpr (!SessionOptions::DEFAULT_USE_PER_SESSION_THREADS) {
+    GTEST_SKIP() << "Skipping the test";
+  }
+  SessionOptions so;
+  so.intra_op_param.thread_pool_size = 2;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingEnable, "1"));
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingMaxBatchSize, "3"));
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsBatchingMaxWaitMicroseconds, "10000000"));
+
+  // mul_1.onnx has an input of fixed shape [3, 2], so the merged input of shape [9, 2] is rejected by Run.
+  InferenceSession session{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session.Load(MODEL_URI));
+  ASSERT_STATUS_OK(session.Initialize());
+
+  static const char* const feed_names[] = {"X"};
+  static const char* const fetch_names[] = {"Y"};
+  std::vector<std::unique_ptr<BatchedRequest>> requests;
+  for (int r = 0; r < 3; ++r) {
+    auto request = std::make_unique<BatchedRequest>();
+    std::vector<float> values(6, static_cast<float>(r + 1));
+    CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], {3, 2}, values,
+                         &request->input);
+    requests.push_back(std::move(request));
+  }
+  for (auto& request : requests) {
+    ASSERT_STATUS_OK(session.RunBatchedAsync(nullptr, feed_names, request->feeds, fetch_names, request->fetches,
+                                             BatchedRequestCallback, request.get()));
+  }
+
+  // Every request still gets the result of running it on its own.
+  for (size_t r = 0; r < requests.size(); ++r) {
+    requests[r]->done.get_future().wait();
+    ASSERT_STATUS_OK(requests[r]->status);
+    EXPECT_THAT(requests[r]->output_dims, ::testing::ElementsAre(3, 2));
+    ASSERT_EQ(requests[r]->output_values.size(), 6u);
+    for (size_t i = 0; i < 6; ++i) {
+      EXPECT_EQ(requests[r]->output_values[i], static_cast<float>((r + 1) * (i + 1)));
+    }
+  }
+
+  RequestBatcherStats stats;
+  ASSERT_STATUS_OK(session.GetRequestBatcherStats(stats));
+  EXPECT_EQ(stats.num_requests, 3u);
+  EXPECT_EQ(stats.num_unbatched_requests, 3u);
+}
+
 }  // namespace test
 }  // namespace onnxruntime
@@ -1,11 +1,17 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <sstream>
+
 #include "core/framework/data_types.h"
 #include "core/framework/op_kernel.h"
 #include "test/providers/provider_test_utils.h"
 #include "test_utils.h"
 #include "core/session/inference_session.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
+#include "test/test_environment.h"
+#include "test/util/include/asserts.h"
+#include "test/util/include/inference_session_wrapper.h"
 
 #include "gtest/gtest.h"
 
@@ -145,5 +151,97 @@ TEST_P(ParallelExecutorThreadPoolTest, TestNullInterOpThreadPool) {
 
 INSTANTIATE_TEST_SUITE_P(ParallelExecutorThreadPoolTests, ParallelExecutorThreadPoolTest,
                          testing::Values(1, 0));
+
+// Y = (-X + Abs(X)) + Relu(X). The three unary nodes are independent of each other.
+static std::string CreateMultiBranchModel() {
+  onnxruntime::Model model("multi_branch", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                           {{kOnnxDomain, 14}}, {}, DefaultLoggingManager().DefaultLogger());
+  auto& graph = model.MainGraph();
+
+  ONNX_NAMESPACE::TypeProto float_tensor;
+  float_tensor.mutable_tensor_type()->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  float_tensor.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(6);
+
+  auto& x = graph.GetOrCreateNodeArg("X", &float_tensor);
+  auto& neg = graph.GetOrCreateNodeArg("neg", &float_tensor);
+  auto& abs = graph.GetOrCreateNodeArg("abs", &float_tensor);
+  auto& relu = graph.GetOrCreateNodeArg("relu", &float_tensor);
+  auto& sum = graph.GetOrCreateNodeArg("sum", &float_tensor);
+  auto& y = graph.GetOrCreateNodeArg("Y", &float_tensor);
+
+  graph.AddNode("neg", "Neg", "", {&x}, {&neg});
+  graph.AddNode("abs", "Abs", "", {&x}, {&abs});
+  graph.AddNode("relu", "Relu", "", {&x}, {&relu});
+  graph.AddNode("add_1", "Add", "", {&neg, &abs}, {&sum});
+  graph.AddNode("add_2", "Add", "", {&sum, &relu}, {&y});
+  EXPECT_STATUS_OK(graph.Resolve());
+
+  std::string serialized;
+  EXPECT_TRUE(model.ToProto().SerializeToString(&serialized));
+  return serialized;
+}
+
+static void RunMultiBranchModel(const SessionOptions& so, bool expect_dataflow) {
+  InferenceSessionWrapper session{so, GetEnvironment()};
+  std::stringstream model(CreateMultiBranchModel());
+  ASSERT_STATUS_OK(session.Load(model));
+  ASSERT_STATUS_OK(session.Initialize());
+
+  const auto* schedule = session.GetSessionState().GetDataflowSchedule();
+  ASSERT_EQ(schedule != nullptr, expect_dataflow);
+  if (expect_dataflow) {
+    EXPECT_EQ(schedule->NumNodes(), 5u);
+  }
+
+  OrtValue x;
+  CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], {6},
+                       {-1.f, 2.f, -3.f, 4.f, -5.f, 6.f}, &x);
+  NameMLValMap feeds{{"X", x}};
+  const std::vector<float> expected{2.f, 2.f, 6.f, 4.f, 10.f, 6.f};
+
+  // repeat so that later runs use the measured node costs for inlining decisions
+  for (int i = 0; i < 20; ++i) {
+    std::vector<OrtValue> fetches;
+    ASSERT_STATUS_OK(session.Run(feeds, {"Y"}, &fetches));
+    ASSERT_EQ(fetches.size(), 1u);
+    auto result = fetches[0].Get<Tensor>().DataAsSpan<float>();
+    ASSERT_EQ(std::vector<float>(result.begin(), result.end()), expected);
+  }
+}
+
+TEST(ParallelExecutor, DataflowExecution) {
+  SessionOptions so;
+  so.session_logid = "ParallelExecutor.DataflowExecution";
+  so.execution_mode = ExecutionMode::ORT_PARALLEL;
+  so.inter_op_param.thread_pool_size = 4;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsDataflowExecution, "1"));
+  RunMultiBranchModel(so, true);
+
+  // dispatch every node to the thread pool
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsDataflowInlineCostMicroseconds, "0"));
+  RunMultiBranchModel(so, true);
+
+  // one node at a time
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsDataflowMaxConcurrentNodes, "1"));
+  RunMultiBranchModel(so, true);
+}
+
+TEST(ParallelExecutor, DataflowExecutionDisabled) {
+  SessionOptions so;
+  so.session_logid = "ParallelExecutor.DataflowExecutionDisabled";
+  so.execution_mode = ExecutionMode::ORT_PARALLEL;
+  so.inter_op_param.thread_pool_size = 4;
+  // off by default
+  RunMultiBranchModel(so, false);
+
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsDataflowExecution, "0"));
+  RunMultiBranchModel(so, false);
+
+  // the schedule is only built in parallel mode
+  SessionOptions sequential_so;
+  sequential_so.session_logid = "ParallelExecutor.DataflowExecutionDisabled";
+  ASSERT_STATUS_OK(sequential_so.config_options.AddConfigEntry(kOrtSessionOptionsDataflowExecution, "1"));
+  RunMultiBranchModel(sequential_so, false);
+}
 }  // namespace test
 }  // namespace onnxruntime
@@ -22,6 +22,7 @@
 #include "gtest/gtest.h"
 #include "test/test_environment.h"
 #include "test/util/include/default_providers.h"
+#include "test/util/include/temp_dir.h"
 #include "core/optimizer/layout_transformation/layout_transformation.h"
 
 using namespace ONNX_NAMESPACE;
@@ -394,8 +395,37 @@ class PrePackingTestOpKernel : public OpKernel {
     return Status::OK();
   }
 
+  Status GetPrePackedBuffersToPersist(int input_idx,
+                                      /*out*/ std::vector<gsl::span<const std::byte>>& prepacked_buffers) const override {
+    ORT_UNUSED_PARAMETER(input_idx);
+
+    prepacked_buffers.clear();
+    if (weight_packed_) {
+      prepacked_buffers.emplace_back(static_cast<const std::byte*>(weight_packed_.get()), 8);
+    }
+    return Status::OK();
+  }
+
+  Status UsePersistedPrePackedBuffers(const Tensor& tensor, std::vector<BufferUniquePtr>& prepacked_buffers,
+                                      gsl::span<const size_t> prepacked_buffer_sizes,
+                                      int input_idx, /*out*/ bool& used_persisted_buffers) override {
+    ORT_UNUSED_PARAMETER(tensor);
+    ORT_UNUSED_PARAMETER(input_idx);
+
+    used_persisted_buffers = false;
+    if (prepacked_buffers.size() != 1 || prepacked_buffer_sizes[0] != 8) {
+      return Status::OK();
+    }
+
+    weight_packed_ = std::move(prepacked_buffers[0]);
+    used_persisted_buffers = true;
+    ++use_persisted_pre_packed_weight_calls_count;
+    return Status::OK();
+  }
+
   int prepack_calls_count = 0;
   int store_pre_packed_weight_calls_count = 0;
+  int use_persisted_pre_packed_weight_calls_count = 0;
   IAllocatorUniquePtr<void> weight_packed_;
 };
 
@@ -999,6 +1029,79 @@ TEST_F(SessionStateTestSharedInitalizersWithPrePacking, test4) {
   ASSERT_EQ(if_node_branches_shared_prepack_counter_2, static_cast<size_t>(2));
 }
 
+// Pre-packing enabled + pre-packed weights cache directory = pre-packed weights persisted across sessions
+TEST_F(SessionStateTestSharedInitalizersWithPrePacking, PersistedPrePackedWeights) {
+  TemporaryDirectory cache_dir(ORT_TSTR("prepacked_weights_cache"));
+
+  SessionOptions sess_options;
+  sess_options.enable_mem_pattern = true;
+  sess_options.execution_mode = ExecutionMode::ORT_SEQUENTIAL;
+  sess_options.use_deterministic_compute = false;
+  sess_options.enable_mem_reuse = true;
+  // Enable pre-packing
+  sess_options.config_options.configurations[kOrtSessionOptionsConfigDisablePrepacking] = "0";
+  sess_options.config_options.configurations[kOrtSessionOptionsPrepackedWeightsCacheDir] =
+      PathToUTF8String(cache_dir.Path());
+
+  auto finalize_session_state = [&](Model& model, std::unique_ptr<SessionState>& session_state) {
+    CreateSimpleGraph(model.MainGraph());
+    PlaceAllNodesToCPUEP(model.MainGraph());
+    session_state = std::make_unique<SessionState>(model.MainGraph(),
+                                                   execution_providers,
+                                                   tp.get(),
+                                                   nullptr, /*inter_op_thread_pool*/
+                                                   dtm,
+                                                   edlm,
+                                                   DefaultLoggingManager().DefaultLogger(),
+                                                   profiler,
+                                                   sess_options);
+    ASSERT_STATUS_OK(session_state->FinalizeSessionState(std::basic_string<PATH_CHAR_TYPE>(),
+                                                         kernel_registry_manager));
+  };
+
+  // First session/model packs the weight and persists it
+  Model model_1("graph_main", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                domain_to_version, std::vector<ONNX_NAMESPACE::FunctionProto>(),
+                DefaultLoggingManager().DefaultLogger());
+  std::unique_ptr<SessionState> session_state_1;
+  finalize_session_state(model_1, session_state_1);
+
+  const auto* kernel = reinterpret_cast<const PrePackingTestOpKernel*>(session_state_1->GetKernel(0));
+  ASSERT_EQ(kernel->prepack_calls_count, 1);
+  ASSERT_EQ(kernel->use_persisted_pre_packed_weight_calls_count, 0);
+  ASSERT_EQ(session_state_1->GetUsedPersistedPrePackedWeightCounter(), static_cast<size_t>(0));
+
+  // Second session/model uses the persisted weight instead of packing it
+  Model model_2("graph_main", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                domain_to_version, std::vector<ONNX_NAMESPACE::FunctionProto>(),
+                DefaultLoggingManager().DefaultLogger());
+  std::unique_ptr<SessionState> session_state_2;
+  finalize_session_state(model_2, session_state_2);
+
+  kernel = reinterpret_cast<const PrePackingTestOpKernel*>(session_state_2->GetKernel(0));
+  ASSERT_EQ(kernel->prepack_calls_count, 0);
+  ASSERT_EQ(kernel->use_persisted_pre_packed_weight_calls_count, 1);
+  ASSERT_EQ(session_state_2->GetNumberOfPrepacksCounter(), static_cast<size_t>(1));
+  ASSERT_EQ(session_state_2->GetUsedPersistedPrePackedWeightCounter(), static_cast<size_t>(1));
+  ASSERT_TRUE(session_state_2->GetConstantInitializedTensors().empty());
+
+  const float* weight_packed = static_cast<const float*>(kernel->weight_packed_.get());
+  ASSERT_EQ(weight_packed[0], 1.2345f);
+  ASSERT_EQ(weight_packed[1], 1.2345f * 2.f);
+
+  // A different configuration doesn't use the persisted weight
+  sess_options.config_options.configurations[kOrtSessionOptionsConfigUseEnvAllocators] = "0";
+  Model model_3("graph_main", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                domain_to_version, std::vector<ONNX_NAMESPACE::FunctionProto>(),
+                DefaultLoggingManager().DefaultLogger());
+  std::unique_ptr<SessionState> session_state_3;
+  finalize_session_state(model_3, session_state_3);
+
+  kernel = reinterpret_cast<const PrePackingTestOpKernel*>(session_state_3->GetKernel(0));
+  ASSERT_EQ(kernel->prepack_calls_count, 1);
+  ASSERT_EQ(kernel->use_persisted_pre_packed_weight_calls_count, 0);
+}
+
 INSTANTIATE_TEST_SUITE_P(SessionStateTests,
                          SessionStatePrepackingTest,
                          testing::Values(PrepackingTestParam{false, false},
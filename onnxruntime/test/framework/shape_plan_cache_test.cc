@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/shape_plan_cache.h"
+#include "core/framework/allocator.h"
+#include "test/framework/test_utils.h"
+#include "gtest/gtest.h"
+
+namespace onnxruntime {
+namespace test {
+
+static std::vector<OrtValue> CreateFeeds(const std::vector<std::vector<int64_t>>& shapes) {
+  auto allocator = TestCPUExecutionProvider()->CreatePreferredAllocators()[0];
+  std::vector<OrtValue> feeds(shapes.size());
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    Tensor::InitOrtValue(DataTypeImpl::GetType<float>(), TensorShape(shapes[i]), allocator, feeds[i]);
+  }
+  return feeds;
+}
+
+static std::shared_ptr<const ShapeSpecializedPlan> CreatePlan() {
+  return std::make_shared<ShapeSpecializedPlan>(MemoryPatternGroup{}, InlinedHashMap<int, TensorShape>{});
+}
+
+TEST(ShapePlanCacheTest, KeyDistinguishesShapes) {
+  // these used to map to the same memory pattern key as their dims XOR to the same value
+  const auto key1 = ShapePlanCache::MakeKey(CreateFeeds({{2, 3}}));
+  const auto key2 = ShapePlanCache::MakeKey(CreateFeeds({{3, 2}}));
+  const auto key3 = ShapePlanCache::MakeKey(CreateFeeds({{2}, {3, 4}}));
+  const auto key4 = ShapePlanCache::MakeKey(CreateFeeds({{2, 3}, {4}}));
+
+  EXPECT_NE(key1, key2);
+  EXPECT_NE(key3, key4);
+  EXPECT_EQ(key1, ShapePlanCache::MakeKey(CreateFeeds({{2, 3}})));
+}
+
+TEST(ShapePlanCacheTest, LeastRecentlyUsedEviction) {
+  ShapePlanCache cache(/*capacity*/ 2);
+  const auto key1 = ShapePlanCache::MakeKey(CreateFeeds({{1, 8}}));
+  const auto key2 = ShapePlanCache::MakeKey(CreateFeeds({{2, 8}}));
+  const auto key3 = ShapePlanCache::MakeKey(CreateFeeds({{3, 8}}));
+
+  EXPECT_EQ(cache.Find(key1), nullptr);
+  auto plan1 = cache.Insert(key1, CreatePlan());
+  cache.Insert(key2, CreatePlan());
+
+  // an existing plan is not replaced
+  EXPECT_EQ(cache.Insert(key1, CreatePlan()), plan1);
+
+  // touch key1 so key2 becomes the least recently used
+  EXPECT_EQ(cache.Find(key1), plan1);
+  cache.Insert(key3, CreatePlan());
+
+  EXPECT_NE(cache.Find(key1), nullptr);
+  EXPECT_EQ(cache.Find(key2), nullptr);
+  EXPECT_NE(cache.Find(key3), nullptr);
+
+  const auto stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.misses, 2u);
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.size, 2u);
+}
+
+TEST(ShapePlanCacheTest, RetainedBuffersAreReused) {
+  auto allocator = TestCPUExecutionProvider()->CreatePreferredAllocators()[0];
+  const OrtDevice& device = allocator->Info().device;
+  auto plan = CreatePlan();
+
+  EXPECT_EQ(plan->AcquireBuffer(device), nullptr);
+
+  void* raw = allocator->Alloc(256);
+  plan->ReleaseBuffer(device, BufferUniquePtr(raw, BufferDeleter(allocator)));
+
+  auto buffer = plan->AcquireBuffer(device);
+  EXPECT_EQ(buffer.get(), raw);
+  EXPECT_EQ(plan->AcquireBuffer(device), nullptr);
+}
+
+}  // namespace test
+}  // namespace onnxruntime
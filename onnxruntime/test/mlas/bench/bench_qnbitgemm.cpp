@@ -134,8 +134,25 @@ static void QNBitGemmArgs(benchmark::internal::Benchmark* b) {
   });
 }
 
+// Sweeps M from a single row (decode) to long prompts (prefill) with int8 activations.
+static void QNBitGemmPrefillArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"BlkLen", "M", "N", "K", "Threads", "Symmetric", "HasBias", "ComputeType"});
+
+  b->ArgsProduct({
+      {32, 128},                                   // BlkLen
+      {1, 16, 32, 64, 128, 256, 512, 1024, 2048},  // M
+      {4096},                                      // N
+      {4096},                                      // K
+      {1, 8},                                      // Threads
+      {int64_t{true}},                             // Symmetric
+      {int64_t{false}},                            // HasBias
+      {int64_t{SQNBIT_CompInt8}},                  // ComputeType
+  });
+}
+
 BENCHMARK(QNBITGEMM<float, 4>)->Apply(QNBitGemmArgs<float>)->UseRealTime();
 BENCHMARK(QNBITGEMM<MLAS_FP16, 4>)->Apply(QNBitGemmArgs<MLAS_FP16>)->UseRealTime();
+BENCHMARK(QNBITGEMM<float, 4>)->Apply(QNBitGemmPrefillArgs)->UseRealTime();
 
 // This test gets benchmark arguments from environment variables.
 template <typename AType, size_t BlkBitWidth>
@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "mlas.h"
+#include "bench_util.h"
+#include "core/util/thread_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(MLAS_SBGEMM_SUPPORTED)
+
+static const std::vector<std::string> sbgemm_bench_arg_names = {"M", "N", "K"};
+
+//
+// Reports the throughput of the bfloat16 GEMM together with the largest error relative
+// to the fp32 MlasGemm result (scaled by the largest reference value), so that the speed
+// up and the accuracy loss of the fast math mode can be read from the same run.
+//
+void SBGEMM(benchmark::State& state, bool pack_b) {
+  if (state.range(0) <= 0) throw std::invalid_argument("M must greater than 0!");
+  if (state.range(1) <= 0) throw std::invalid_argument("N must greater than 0!");
+  if (state.range(2) <= 0) throw std::invalid_argument("K must greater than 0!");
+  const size_t M = static_cast<size_t>(state.range(0));
+  const size_t N = static_cast<size_t>(state.range(1));
+  const size_t K = static_cast<size_t>(state.range(2));
+
+  if (MlasSBGemmPackBSize(N, K) == 0) {
+    state.SkipWithError("bfloat16 GEMM is not supported on this platform");
+    return;
+  }
+
+  auto A = RandomVectorUniform(static_cast<size_t>(M * K), -1.0f, 1.0f);
+  auto B = RandomVectorUniform(static_cast<size_t>(N * K), -1.0f, 1.0f);
+  std::vector<float> C(static_cast<size_t>(M * N));
+  std::vector<float> CReference(static_cast<size_t>(M * N));
+
+  OrtThreadPoolParams tpo;
+  tpo.thread_pool_size = 8;
+  tpo.auto_set_affinity = true;
+  std::unique_ptr<onnxruntime::concurrency::ThreadPool> tp(
+      onnxruntime::concurrency::CreateThreadPool(&onnxruntime::Env::Default(),
+                                                 tpo, onnxruntime::concurrency::ThreadPoolType::INTRA_OP));
+
+  std::vector<uint8_t> B_packed;
+  MLAS_SBGEMM_DATA_PARAMS params;
+  params.A = A.data();
+  params.lda = K;
+  params.C = C.data();
+  params.ldc = N;
+  params.AIsfp32 = true;
+  params.BIsfp32 = true;
+  if (pack_b) {
+    B_packed.resize(MlasSBGemmPackBSize(N, K));
+    MlasSBGemmConvertPackB(N, K, B.data(), N, B_packed.data());
+    params.B = B_packed.data();
+    params.ldb = 0;
+  } else {
+    params.B = B.data();
+    params.ldb = N;
+  }
+
+  MlasSBGemmBatch(M, N, K, 1, &params, tp.get());
+
+  MlasGemm(CblasNoTrans, CblasNoTrans, M, N, K, 1.0f, A.data(), K, B.data(), N, 0.0f,
+           CReference.data(), N, tp.get());
+  float max_reference = 0.0f;
+  float max_error = 0.0f;
+  for (size_t i = 0; i < C.size(); i++) {
+    max_reference = std::max(max_reference, std::fabs(CReference[i]));
+    max_error = std::max(max_error, std::fabs(C[i] - CReference[i]));
+  }
+  state.counters["MaxRelError"] = max_reference > 0.0f ? max_error / max_reference : max_error;
+
+  for (auto _ : state) {
+    MlasSBGemmBatch(M, N, K, 1, &params, tp.get());
+  }
+
+  state.counters["GFLOPS"] = benchmark::Counter(
+      static_cast<double>(2 * M * N * K), benchmark::Counter::kIsIterationInvariantRate, benchmark::Counter::kIs1000);
+}
+
+static void SBGemmSizeProducts(benchmark::internal::Benchmark* b) {
+  b->ArgNames(sbgemm_bench_arg_names);
+  b->ArgsProduct({{1, 63, 255, 1023}, {63, 255, 1023}, {63, 255, 1023}});
+}
+
+static void SBGemmLLMSizeProducts(benchmark::internal::Benchmark* b) {
+  b->ArgNames(sbgemm_bench_arg_names);
+  b->ArgsProduct({{1, 1024, 2048}, {4096, 11008}, {4096, 11008}});
+}
+
+BENCHMARK_CAPTURE(SBGEMM, NORMAL, false)->Apply(SBGemmSizeProducts)->UseRealTime();
+BENCHMARK_CAPTURE(SBGEMM, PACKB, true)->Apply(SBGemmSizeProducts)->UseRealTime();
+BENCHMARK_CAPTURE(SBGEMM, LLM_PACKB, true)->Apply(SBGemmLLMSizeProducts)->UseRealTime();
+
+#endif  // defined(MLAS_SBGEMM_SUPPORTED)
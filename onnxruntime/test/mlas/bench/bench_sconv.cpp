@@ -38,8 +38,7 @@ static const std::vector<std::string>& ArgNamesForConv(size_t rank) {
   return rank_to_args_name[rank];
 }
 
-// dummy for some strange build error when using Bench capture
-void SCONV_NCHW(benchmark::State& state, const char* /*dummy*/) {
+static void SconvNchw(benchmark::State& state, bool allow_winograd) {
   const int64_t rank = state.range(0);                       // Rank
   const int64_t batch_size = state.range(1);                 // N
   const int64_t groups = state.range(2);                     // G
@@ -110,7 +109,8 @@ void SCONV_NCHW(benchmark::State& state, const char* /*dummy*/) {
                   &activation,
                   &WorkingBufferSize,
                   0.0f,
-                  nullptr);
+                  nullptr,
+                  allow_winograd);
 
   auto X = RandomVectorUniform(x_shape, -2.0, 2.0);
   auto F = RandomVectorUniform(f_shape, -1.0, 1.0);
@@ -138,6 +138,15 @@ void SCONV_NCHW(benchmark::State& state, const char* /*dummy*/) {
   }
 }
 
+// dummy for some strange build error when using Bench capture
+void SCONV_NCHW(benchmark::State& state, const char* /*dummy*/) {
+  SconvNchw(state, false);
+}
+
+void SCONV_NCHW_WINOGRAD(benchmark::State& state, const char* /*dummy*/) {
+  SconvNchw(state, true);
+}
+
 static void ResNet50(benchmark::internal::Benchmark* b) {
   b->ArgNames(ArgNamesForConv(2));
 
@@ -245,3 +254,20 @@ static void General_Conv2d(benchmark::internal::Benchmark* b) {
 }
 
 BENCHMARK_CAPTURE(SCONV_NCHW, 2d, "")->Apply(General_Conv2d)->UseRealTime();
+
+static void Conv3x3(benchmark::internal::Benchmark* b) {
+  b->ArgNames(ArgNamesForConv(2));
+
+  // 3x3 stride 1 convolutions from ResNet and UNet style models.
+  //    Rank, N, G, Cpg, Fpg,   I,    , K, , P, , , , S, , D, ,
+  b->Args({2, 1, 1, 64, 64, 56, 56, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1});
+  b->Args({2, 1, 1, 128, 128, 28, 28, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1});
+  b->Args({2, 1, 1, 256, 256, 14, 14, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1});
+  b->Args({2, 1, 1, 512, 512, 7, 7, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1});
+  b->Args({2, 1, 1, 64, 64, 128, 128, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1});
+  b->Args({2, 1, 1, 256, 128, 64, 64, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1});
+  b->Args({2, 4, 1, 128, 128, 28, 28, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1});
+}
+
+BENCHMARK_CAPTURE(SCONV_NCHW, Conv3x3, "")->Apply(Conv3x3)->UseRealTime();
+BENCHMARK_CAPTURE(SCONV_NCHW_WINOGRAD, Conv3x3, "")->Apply(Conv3x3)->UseRealTime();
@@ -126,6 +126,14 @@ BENCHMARK_CAPTURE(SGEMM, GEMV_ABTrans, false, true, true)->Apply(GemmSizeWithOne
 BENCHMARK_CAPTURE(SGEMM, PACKB_NoTransA, true, false, false)->Apply(GemmSizeProducts)->UseRealTime();
 BENCHMARK_CAPTURE(SGEMM, PACKB_TransA, true, true, false)->Apply(GemmSizeProducts)->UseRealTime();
 
+static void GemmSmallSizeProducts(benchmark::internal::Benchmark* b) {
+  b->ArgNames(sgemm_bench_arg_names);
+  b->ArgsProduct({{1, 2, 4, 8}, {16, 64, 256, 1024}, {16, 64, 256, 1024}});
+}
+
+BENCHMARK_CAPTURE(SGEMM, SMALL_NoTrans, false, false, false)->Apply(GemmSmallSizeProducts)->UseRealTime();
+BENCHMARK_CAPTURE(SGEMM, SMALL_TransA, false, true, false)->Apply(GemmSmallSizeProducts)->UseRealTime();
+
 static void GemmLLMSizeProducts(benchmark::internal::Benchmark* b) {
   b->ArgNames(sgemm_bench_arg_names);
   b->ArgsProduct({{1, 1024, 2048}, {4096, 11008}, {4096, 11008}});
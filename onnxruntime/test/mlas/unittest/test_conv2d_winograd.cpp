@@ -0,0 +1,218 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "test_util.h"
+
+template <bool Threaded>
+class MlasConv2DWinogradTest : public MlasTestBase {
+ private:
+  MatrixGuardBuffer<float> BufferInput;
+  MatrixGuardBuffer<float> BufferFilter;
+  MatrixGuardBuffer<float> BufferBias;
+  MatrixGuardBuffer<float> BufferOutput;
+  MatrixGuardBuffer<float> BufferOutputReference;
+  MatrixGuardBuffer<float> BufferWorking;
+  MatrixGuardBuffer<float> BufferPackedFilter;
+  MLAS_THREADPOOL* threadpool_;
+
+  //
+  // Computes the convolution in double precision along with the sum of the
+  // magnitudes of the products, which bounds the rounding error.
+  //
+  void ReferenceConv2D(size_t BatchCount,
+                       size_t GroupCount,
+                       size_t InputChannels,
+                       size_t InputHeight,
+                       size_t InputWidth,
+                       size_t FilterCount,
+                       size_t Padding,
+                       size_t OutputHeight,
+                       size_t OutputWidth,
+                       float Beta,
+                       bool Relu,
+                       const float* Input,
+                       const float* Filter,
+                       const float* Bias,
+                       float* Output,
+                       std::vector<double>& Magnitude) {
+    const size_t InputSize = InputHeight * InputWidth;
+    const size_t OutputSize = OutputHeight * OutputWidth;
+
+    Magnitude.resize(BatchCount * GroupCount * FilterCount * OutputSize);
+
+    for (size_t bg = 0; bg < BatchCount * GroupCount; bg++) {
+      const size_t group = bg % GroupCount;
+
+      for (size_t f = 0; f < FilterCount; f++) {
+        const float* filter = Filter + (group * FilterCount + f) * InputChannels * 9;
+        const size_t output_offset = (bg * FilterCount + f) * OutputSize;
+
+        for (size_t oh = 0; oh < OutputHeight; oh++) {
+          for (size_t ow = 0; ow < OutputWidth; ow++) {
+            double sum = (Bias != nullptr) ? Bias[group * FilterCount + f] : 0.0;
+            double magnitude = std::fabs(sum);
+
+            for (size_t c = 0; c < InputChannels; c++) {
+              const float* input = Input + (bg * InputChannels + c) * InputSize;
+
+              for (size_t kh = 0; kh < 3; kh++) {
+                const ptrdiff_t ih = ptrdiff_t(oh + kh) - ptrdiff_t(Padding);
+                if (ih < 0 || size_t(ih) >= InputHeight) {
+                  continue;
+                }
+                for (size_t kw = 0; kw < 3; kw++) {
+                  const ptrdiff_t iw = ptrdiff_t(ow + kw) - ptrdiff_t(Padding);
+                  if (iw < 0 || size_t(iw) >= InputWidth) {
+                    continue;
+                  }
+                  const double product = double(input[ih * InputWidth + iw]) * double(filter[(c * 3 + kh) * 3 + kw]);
+                  sum += product;
+                  magnitude += std::fabs(product);
+                }
+              }
+            }
+
+            float* output = Output + output_offset + oh * OutputWidth + ow;
+
+            if (Beta != 0.0f) {
+              sum += double(Beta) * double(*output);
+              magnitude += std::fabs(double(Beta) * double(*output));
+            }
+
+            *output = (Relu && sum < 0.0) ? 0.0f : float(sum);
+            Magnitude[output_offset + oh * OutputWidth + ow] = magnitude;
+          }
+        }
+      }
+    }
+  }
+
+  void Test(size_t BatchCount,
+            size_t GroupCount,
+            size_t InputChannels,
+            size_t InputHeight,
+            size_t InputWidth,
+            size_t FilterCount,
+            size_t Padding,
+            float Beta,
+            bool Relu,
+            bool PackFilter) {
+    const size_t OutputHeight = InputHeight + 2 * Padding - 2;
+    const size_t OutputWidth = InputWidth + 2 * Padding - 2;
+
+    const size_t InputElements = BatchCount * GroupCount * InputChannels * InputHeight * InputWidth;
+    const size_t FilterElements = GroupCount * FilterCount * InputChannels * 9;
+    const size_t OutputElements = BatchCount * GroupCount * FilterCount * OutputHeight * OutputWidth;
+
+    float* Input = BufferInput.GetBuffer(InputElements);
+    float* Filter = BufferFilter.GetBuffer(FilterElements);
+    float* Bias = BufferBias.GetBuffer(GroupCount * FilterCount);
+    float* Output = BufferOutput.GetBuffer(OutputElements);
+    float* OutputReference = BufferOutputReference.GetBuffer(OutputElements);
+
+    std::default_random_engine generator(static_cast<unsigned>(InputElements + FilterElements));
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    for (size_t i = 0; i < InputElements; i++) {
+      Input[i] = distribution(generator);
+    }
+    for (size_t i = 0; i < FilterElements; i++) {
+      Filter[i] = distribution(generator);
+    }
+    for (size_t i = 0; i < GroupCount * FilterCount; i++) {
+      Bias[i] = distribution(generator);
+    }
+    for (size_t i = 0; i < OutputElements; i++) {
+      Output[i] = distribution(generator);
+      OutputReference[i] = Output[i];
+    }
+
+    int64_t InputShape[] = {int64_t(InputHeight), int64_t(InputWidth)};
+    int64_t KernelShape[] = {3, 3};
+    int64_t DilationShape[] = {1, 1};
+    int64_t PaddingShape[] = {int64_t(Padding), int64_t(Padding), int64_t(Padding), int64_t(Padding)};
+    int64_t StrideShape[] = {1, 1};
+    int64_t OutputShape[] = {int64_t(OutputHeight), int64_t(OutputWidth)};
+
+    MLAS_ACTIVATION Activation;
+    Activation.ActivationKind = Relu ? MlasReluActivation : MlasIdentityActivation;
+
+    MLAS_CONV_PARAMETERS Parameters;
+    size_t WorkingBufferSize;
+
+    MlasConvPrepare(&Parameters, 2, BatchCount, GroupCount, InputChannels, InputShape, KernelShape,
+                    DilationShape, PaddingShape, StrideShape, OutputShape, FilterCount, &Activation,
+                    &WorkingBufferSize, Beta, threadpool_, true);
+
+    ASSERT_EQ(Parameters.Algorithm, MlasConvAlgorithmWinograd);
+    ASSERT_EQ(Parameters.u.Winograd.OutputTile,
+              MlasConvWinogradOutputTile(InputChannels, FilterCount, OutputHeight, OutputWidth));
+
+    if (PackFilter) {
+      const size_t OutputTile = Parameters.u.Winograd.OutputTile;
+      const size_t PackedFilterSize =
+          MlasConvWinogradPackedFilterSize(GroupCount, InputChannels, FilterCount, OutputTile);
+      ASSERT_EQ(PackedFilterSize, Parameters.u.Winograd.PackedFilterSize);
+
+      float* PackedFilter = BufferPackedFilter.GetBuffer(PackedFilterSize);
+      MlasConvWinogradPackFilter(GroupCount, InputChannels, FilterCount, OutputTile, Filter, PackedFilter);
+
+      Parameters.u.Winograd.PackedFilter = PackedFilter;
+      WorkingBufferSize -= PackedFilterSize;
+    }
+
+    MlasConv(&Parameters, Input, Filter, Bias, BufferWorking.GetBuffer(WorkingBufferSize), Output, threadpool_);
+
+    std::vector<double> Magnitude;
+    ReferenceConv2D(BatchCount, GroupCount, InputChannels, InputHeight, InputWidth, FilterCount, Padding,
+                    OutputHeight, OutputWidth, Beta, Relu, Input, Filter, Bias, OutputReference, Magnitude);
+
+    constexpr double RelativeTolerance = 1e-5;
+
+    for (size_t i = 0; i < OutputElements; i++) {
+      ASSERT_LE(std::fabs(double(Output[i]) - double(OutputReference[i])), Magnitude[i] * RelativeTolerance + 1e-6)
+          << "@" << i << " of " << OutputElements << ", got: " << Output[i] << ", expecting: " << OutputReference[i]
+          << " B=" << BatchCount << " G=" << GroupCount << " C=" << InputChannels << " H=" << InputHeight
+          << " W=" << InputWidth << " M=" << FilterCount << " P=" << Padding << " Tile="
+          << Parameters.u.Winograd.OutputTile;
+    }
+  }
+
+ public:
+  static const char* GetTestSuiteName() {
+    static const std::string suite_name(Threaded ? "Conv2dWinograd_Threaded" : "Conv2dWinograd_SingleThread");
+    return suite_name.c_str();
+  }
+
+  MlasConv2DWinogradTest() : threadpool_(Threaded ? GetMlasThreadPool() : nullptr) {}
+
+  void ExecuteShort(void) override {
+    // F(2x2,3x3) for small images.
+    Test(1, 1, 64, 4, 4, 64, 0, 0.0f, false, false);
+    Test(1, 1, 64, 7, 7, 96, 1, 0.0f, false, false);
+    Test(2, 2, 65, 5, 6, 67, 1, 0.5f, true, true);
+
+    // F(4x4,3x3) including partial tiles at the right and bottom edges.
+    Test(1, 1, 64, 8, 8, 64, 1, 0.0f, false, false);
+    Test(1, 1, 64, 14, 14, 72, 1, 0.0f, false, true);
+    Test(1, 1, 96, 17, 23, 64, 0, 0.0f, true, false);
+    Test(3, 1, 64, 28, 28, 80, 1, 1.0f, false, true);
+    Test(1, 2, 64, 13, 9, 64, 1, 0.0f, true, true);
+
+    // Deep reductions and many tile blocks.
+    Test(1, 1, 256, 14, 14, 64, 1, 0.0f, false, true);
+    Test(1, 1, 640, 10, 10, 384, 1, 0.0f, false, false);
+    Test(1, 1, 64, 56, 56, 64, 1, 0.0f, true, false);
+  }
+};
+
+static UNUSED_VARIABLE bool added_to_main = AddTestRegister([](bool is_short_execute) {
+  size_t count = 0;
+  if (is_short_execute) {
+    count += MlasDirectShortExecuteTests<MlasConv2DWinogradTest<false>>::RegisterShortExecute();
+    if (GetMlasThreadPool() != nullptr) {
+      count += MlasDirectShortExecuteTests<MlasConv2DWinogradTest<true>>::RegisterShortExecute();
+    }
+  }
+  return count;
+});
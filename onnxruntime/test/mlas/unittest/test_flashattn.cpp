@@ -0,0 +1,223 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "test_fp16.h"
+
+class MlasFlashAttentionTest : public MlasTestBase {
+ private:
+  MatrixGuardBuffer<float> BufferQuery;
+  MatrixGuardBuffer<float> BufferKey;
+  MatrixGuardBuffer<float> BufferValue;
+  MatrixGuardBuffer<float> BufferOutput;
+  MatrixGuardBuffer<float> BufferOutputReference;
+  MatrixGuardBuffer<float> BufferWorkspace;
+  MatrixGuardBuffer<MLFp16> BufferQueryFp16;
+  MatrixGuardBuffer<MLFp16> BufferKeyFp16;
+  MatrixGuardBuffer<MLFp16> BufferValueFp16;
+  MatrixGuardBuffer<MLFp16> BufferOutputFp16;
+  MLAS_THREADPOOL* threadpool_;
+
+  struct Config {
+    int batch_size;
+    int num_heads;
+    int kv_num_heads;
+    int q_sequence_length;
+    int kv_sequence_length;
+    int kv_buffer_sequence_length;
+    int head_size;
+    int q_block_size;
+    int kv_block_size;
+    bool is_causal;
+    int local_window_size;
+    bool padding;
+  };
+
+  void ReferenceAttention(const Config& config, const float* Query, const float* Key, const float* Value,
+                          const int32_t* KvLengths, float scale, float* Output) {
+    const int H = config.head_size;
+    const int T = config.kv_buffer_sequence_length;
+    std::vector<float> scores(T);
+
+    for (int b = 0; b < config.batch_size; b++) {
+      const int kv_length = KvLengths != nullptr ? std::min(KvLengths[b], config.kv_sequence_length)
+                                                 : config.kv_sequence_length;
+      const int offset = std::max(kv_length - config.q_sequence_length, 0);
+      for (int h = 0; h < config.num_heads; h++) {
+        const int kv_h = h / (config.num_heads / config.kv_num_heads);
+        const float* key = Key + (size_t(b) * config.kv_num_heads + kv_h) * T * H;
+        const float* value = Value + (size_t(b) * config.kv_num_heads + kv_h) * T * H;
+        for (int s = 0; s < config.q_sequence_length; s++) {
+          const float* query = Query + ((size_t(b) * config.num_heads + h) * config.q_sequence_length + s) * H;
+          float* output = Output + ((size_t(b) * config.q_sequence_length + s) * config.num_heads + h) * H;
+
+          int start = 0;
+          int end = kv_length;
+          if (config.is_causal) {
+            end = std::min(s + offset + 1, kv_length);
+            if (config.local_window_size >= 0) {
+              start = std::max(s + offset - config.local_window_size, 0);
+            }
+          }
+
+          std::fill_n(output, H, 0.0f);
+          if (start >= end) {
+            continue;
+          }
+
+          float maximum = std::numeric_limits<float>::lowest();
+          for (int t = start; t < end; t++) {
+            float dot = 0.0f;
+            for (int i = 0; i < H; i++) {
+              dot += query[i] * key[size_t(t) * H + i];
+            }
+            scores[t] = dot * scale;
+            maximum = std::max(maximum, scores[t]);
+          }
+          double sum = 0.0;
+          for (int t = start; t < end; t++) {
+            scores[t] = std::exp(scores[t] - maximum);
+            sum += scores[t];
+          }
+          for (int t = start; t < end; t++) {
+            const float weight = static_cast<float>(scores[t] / sum);
+            for (int i = 0; i < H; i++) {
+              output[i] += weight * value[size_t(t) * H + i];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  void Test(const Config& config, bool fp16) {
+    const size_t H = config.head_size;
+    const size_t query_elements = size_t(config.batch_size) * config.num_heads * config.q_sequence_length * H;
+    const size_t kv_elements = size_t(config.batch_size) * config.kv_num_heads * config.kv_buffer_sequence_length * H;
+    const size_t output_elements = query_elements;
+
+    float* Query = BufferQuery.GetBuffer(query_elements);
+    float* Key = BufferKey.GetBuffer(kv_elements);
+    float* Value = BufferValue.GetBuffer(kv_elements);
+    float* Output = BufferOutput.GetBuffer(output_elements, true);
+    float* OutputReference = BufferOutputReference.GetBuffer(output_elements, true);
+
+    std::default_random_engine generator(static_cast<unsigned>(query_elements + kv_elements));
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for (size_t i = 0; i < query_elements; i++) {
+      Query[i] = distribution(generator);
+    }
+    for (size_t i = 0; i < kv_elements; i++) {
+      Key[i] = distribution(generator);
+      Value[i] = distribution(generator);
+    }
+
+    std::vector<int32_t> KvLengths(config.batch_size);
+    for (int b = 0; b < config.batch_size; b++) {
+      KvLengths[b] = config.kv_sequence_length - (config.padding ? (b * 3) % (config.kv_sequence_length + 1) : 0);
+    }
+
+    MlasFlashAttentionThreadedArgs args;
+    args.batch_size = config.batch_size;
+    args.num_heads = config.num_heads;
+    args.kv_num_heads = config.kv_num_heads;
+    args.q_sequence_length = config.q_sequence_length;
+    args.kv_sequence_length = config.kv_sequence_length;
+    args.kv_buffer_sequence_length = config.kv_buffer_sequence_length;
+    args.qk_head_size = config.head_size;
+    args.v_head_size = config.head_size;
+    args.q_block_size = config.q_block_size;
+    args.kv_block_size = config.kv_block_size;
+    args.scale = 1.0f / std::sqrt(static_cast<float>(H));
+    args.is_causal = config.is_causal;
+    args.local_window_size = config.local_window_size;
+    args.kv_sequence_lengths = config.padding ? KvLengths.data() : nullptr;
+    args.thread_count = 3;
+
+    MLFp16* OutputFp16 = nullptr;
+    if (fp16) {
+      MLFp16* QueryFp16 = BufferQueryFp16.GetBuffer(query_elements);
+      MLFp16* KeyFp16 = BufferKeyFp16.GetBuffer(kv_elements);
+      MLFp16* ValueFp16 = BufferValueFp16.GetBuffer(kv_elements);
+      OutputFp16 = BufferOutputFp16.GetBuffer(output_elements, true);
+
+      // The reference uses the fp16 rounded inputs.
+      for (size_t i = 0; i < query_elements; i++) {
+        QueryFp16[i] = MLFp16(Query[i]);
+        Query[i] = QueryFp16[i].ToFloat();
+      }
+      for (size_t i = 0; i < kv_elements; i++) {
+        KeyFp16[i] = MLFp16(Key[i]);
+        Key[i] = KeyFp16[i].ToFloat();
+        ValueFp16[i] = MLFp16(Value[i]);
+        Value[i] = ValueFp16[i].ToFloat();
+      }
+      args.query_fp16 = reinterpret_cast<const MLAS_FP16*>(QueryFp16);
+      args.key_fp16 = reinterpret_cast<const MLAS_FP16*>(KeyFp16);
+      args.value_fp16 = reinterpret_cast<const MLAS_FP16*>(ValueFp16);
+      args.output_fp16 = reinterpret_cast<MLAS_FP16*>(OutputFp16);
+    } else {
+      args.query = Query;
+      args.key = Key;
+      args.value = Value;
+      args.output = Output;
+    }
+
+    args.buffer_size_per_thread = MlasFlashAttentionGetBufferSizePerThread(&args);
+    args.buffer = BufferWorkspace.GetBuffer(args.buffer_size_per_thread * args.thread_count / sizeof(float), true);
+
+    MlasFlashAttention(&args, threadpool_);
+
+    if (fp16) {
+      for (size_t i = 0; i < output_elements; i++) {
+        Output[i] = OutputFp16[i].ToFloat();
+      }
+    }
+
+    ReferenceAttention(config, Query, Key, Value, config.padding ? KvLengths.data() : nullptr, args.scale,
+                       OutputReference);
+
+    const float Tolerance = fp16 ? 4e-3f : 1e-4f;
+    for (size_t i = 0; i < output_elements; i++) {
+      ASSERT_TRUE(std::fabs(Output[i] - OutputReference[i]) <= Tolerance)
+          << " @" << i << ", B=" << config.batch_size << ", N=" << config.num_heads
+          << ", N_kv=" << config.kv_num_heads << ", S=" << config.q_sequence_length
+          << ", L=" << config.kv_sequence_length << ", H=" << H << ", Br=" << config.q_block_size
+          << ", Bc=" << config.kv_block_size << ", causal=" << config.is_causal
+          << ", window=" << config.local_window_size << ", padding=" << config.padding << ", fp16=" << fp16
+          << ", got:" << Output[i] << ", expecting:" << OutputReference[i];
+    }
+  }
+
+ public:
+  MlasFlashAttentionTest() : threadpool_(GetMlasThreadPool()) {}
+
+  static const char* GetTestSuiteName() {
+    static const std::string suite_name("FlashAttention");
+    return suite_name.c_str();
+  }
+
+  void ExecuteShort(void) override {
+    static const Config Configs[] = {
+        // B, N, N_kv, S, L, L_buffer, H, Br, Bc, causal, window, padding
+        {2, 4, 4, 17, 17, 17, 16, 8, 8, false, -1, false},
+        {2, 4, 4, 17, 17, 17, 16, 8, 8, true, -1, false},
+        {1, 2, 2, 33, 33, 33, 8, 16, 5, true, -1, false},
+        {2, 8, 2, 13, 13, 13, 16, 4, 8, true, -1, false},
+        {2, 8, 2, 13, 13, 20, 16, 4, 8, true, -1, true},
+        {3, 4, 1, 1, 37, 64, 32, 1, 16, true, -1, true},
+        {2, 4, 2, 5, 29, 32, 16, 3, 7, true, -1, false},
+        {2, 4, 2, 29, 29, 29, 16, 8, 4, true, 6, false},
+        {2, 4, 2, 9, 40, 48, 16, 4, 8, true, 11, true},
+        {2, 2, 2, 7, 23, 23, 8, 4, 8, false, -1, true},
+    };
+
+    for (const auto& config : Configs) {
+      Test(config, false);
+      Test(config, true);
+    }
+  }
+};
+
+static UNUSED_VARIABLE bool added_to_main = AddTestRegister([](bool is_short_execute) {
+  return is_short_execute ? MlasDirectShortExecuteTests<MlasFlashAttentionTest>::RegisterShortExecute() : 0;
+});
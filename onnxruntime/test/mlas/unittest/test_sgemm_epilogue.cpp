@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "test_util.h"
+
+class MlasSgemmEpilogueTest : public MlasTestBase {
+ private:
+  MatrixGuardBuffer<float> BufferA;
+  MatrixGuardBuffer<float> BufferB;
+  MatrixGuardBuffer<float> BufferPackedB;
+  MatrixGuardBuffer<float> BufferBias;
+  MatrixGuardBuffer<float> BufferResidual;
+  MatrixGuardBuffer<float> BufferC;
+  MatrixGuardBuffer<float> BufferCReference;
+
+  static float ReferenceActivation(MLAS_ACTIVATION_KIND ActivationKind, float Value) {
+    switch (ActivationKind) {
+      case MlasReluActivation:
+        return std::max(Value, 0.0f);
+      case MlasGeluActivation:
+        return 0.5f * Value * (1.0f + std::erf(Value * 0.70710678118654752f));
+      case MlasFastGeluActivation:
+        return 0.5f * Value * (1.0f + std::tanh(0.7978845608028654f * (Value + 0.044715f * Value * Value * Value)));
+      case MlasSiluActivation:
+        return Value / (1.0f + std::exp(-Value));
+      default:
+        return Value;
+    }
+  }
+
+  void Test(CBLAS_TRANSPOSE TransA, bool PackB, size_t M, size_t N, size_t K,
+            MLAS_ACTIVATION_KIND ActivationKind, bool HasBias, bool HasResidual) {
+    const float* A = BufferA.GetBuffer(M * K);
+    const float* B = BufferB.GetBuffer(K * N);
+    const float* Bias = BufferBias.GetBuffer(N);
+    const float* Residual = BufferResidual.GetBuffer(M * N);
+    float* C = BufferC.GetBuffer(M * N, true);
+    float* CReference = BufferCReference.GetBuffer(M * N, true);
+
+    MlasGemm(TransA, CblasNoTrans, M, N, K, 1.0f, A, (TransA == CblasNoTrans) ? K : M, B, N,
+             0.0f, CReference, N, threadpool_);
+
+    for (size_t m = 0; m < M; m++) {
+      for (size_t n = 0; n < N; n++) {
+        float Value = CReference[m * N + n] + (HasBias ? Bias[n] : 0.0f);
+        Value = ReferenceActivation(ActivationKind, Value);
+        CReference[m * N + n] = Value + (HasResidual ? Residual[m * N + n] : 0.0f);
+      }
+    }
+
+    MLAS_SGEMM_EPILOGUE Epilogue;
+    Epilogue.Bias = HasBias ? Bias : nullptr;
+    Epilogue.Activation.ActivationKind = ActivationKind;
+    Epilogue.Residual = HasResidual ? Residual : nullptr;
+    Epilogue.ldr = N;
+
+    MLAS_SGEMM_DATA_PARAMS Data;
+    Data.A = A;
+    Data.lda = (TransA == CblasNoTrans) ? K : M;
+    Data.B = B;
+    Data.ldb = N;
+    Data.C = C;
+    Data.ldc = N;
+    Data.Epilogue = &Epilogue;
+
+    if (PackB) {
+      const size_t PackedBSize = MlasGemmPackBSize(N, K);
+      void* PackedB = BufferPackedB.GetBuffer(PackedBSize / sizeof(float), true);
+      MlasGemmPackB(CblasNoTrans, N, K, B, N, PackedB);
+      Data.B = static_cast<const float*>(PackedB);
+      Data.ldb = 0;
+      Data.BIsPacked = true;
+    }
+
+    MlasGemmBatch(TransA, CblasNoTrans, M, N, K, &Data, 1, threadpool_);
+
+    for (size_t i = 0; i < M * N; i++) {
+      ASSERT_TRUE(CloseEnough(C[i], CReference[i]))
+          << " @[" << i / N << "," << i % N << "], M=" << M << ", N=" << N << ", K=" << K
+          << ", TransA=" << int(TransA) << ", PackB=" << PackB << ", Activation=" << int(ActivationKind)
+          << ", Bias=" << HasBias << ", Residual=" << HasResidual
+          << ", got:" << C[i] << ", expecting:" << CReference[i];
+    }
+  }
+
+  MLAS_THREADPOOL* threadpool_;
+
+ public:
+  MlasSgemmEpilogueTest() : threadpool_(GetMlasThreadPool()) {}
+
+  static const char* GetTestSuiteName() {
+    static const std::string suite_name("SGemmEpilogue");
+    return suite_name.c_str();
+  }
+
+  void ExecuteShort(void) override {
+    static const MLAS_ACTIVATION_KIND ActivationKinds[] = {
+        MlasIdentityActivation, MlasReluActivation, MlasGeluActivation, MlasFastGeluActivation, MlasSiluActivation};
+    static const size_t Shapes[][3] = {
+        {1, 1, 1}, {1, 37, 19}, {5, 1, 23}, {7, 19, 0}, {13, 33, 65}, {31, 129, 257}, {64, 300, 160}};
+
+    for (const auto& Shape : Shapes) {
+      for (MLAS_ACTIVATION_KIND ActivationKind : ActivationKinds) {
+        for (int Mask = 0; Mask < 4; Mask++) {
+          const bool HasBias = (Mask & 1) != 0;
+          const bool HasResidual = (Mask & 2) != 0;
+          Test(CblasNoTrans, false, Shape[0], Shape[1], Shape[2], ActivationKind, HasBias, HasResidual);
+          Test(CblasTrans, false, Shape[0], Shape[1], Shape[2], ActivationKind, HasBias, HasResidual);
+          Test(CblasNoTrans, true, Shape[0], Shape[1], Shape[2], ActivationKind, HasBias, HasResidual);
+        }
+      }
+    }
+  }
+};
+
+static UNUSED_VARIABLE bool added_to_main = AddTestRegister([](bool is_short_execute) {
+  return is_short_execute ? MlasDirectShortExecuteTests<MlasSgemmEpilogueTest>::RegisterShortExecute() : 0;
+});
@@ -9,6 +9,9 @@ class MlasSoftmaxTest : public MlasTestBase {
   MatrixGuardBuffer<float> BufferInput;
   MatrixGuardBuffer<float> BufferOutput;
   MatrixGuardBuffer<float> BufferOutputReference;
+  MatrixGuardBuffer<float> BufferBias;
+  MatrixGuardBuffer<float> BufferMask;
+  MatrixGuardBuffer<float> BufferTransformed;
   MLAS_THREADPOOL* threadpool_;
 
   void Test(size_t N, size_t D, float MinimumValue, float MaximumValue) {
@@ -44,6 +47,74 @@ class MlasSoftmaxTest : public MlasTestBase {
     }
   }
 
+  void TestFused(size_t N, size_t D, float Scale, bool HasBias, bool BroadcastMask, bool Causal, bool InPlace) {
+    float* Input = BufferInput.GetBuffer(N * D);
+    float* Output = BufferOutput.GetBuffer(N * D);
+    float* OutputReference = BufferOutputReference.GetBuffer(N * D);
+    float* Bias = BufferBias.GetBuffer(N * D);
+    float* Mask = BufferMask.GetBuffer(N * D);
+    float* Transformed = BufferTransformed.GetBuffer(N * D);
+
+    std::default_random_engine generator(static_cast<unsigned>(N * D));
+    std::uniform_real_distribution<float> distribution(-10.f, 10.f);
+
+    for (size_t nd = 0; nd < N * D; nd++) {
+      Input[nd] = distribution(generator);
+      Bias[nd] = distribution(generator);
+      // Additive masks hide elements with a large negative value.
+      Mask[nd] = (nd % 3 == 1) ? -10000.0f : 0.0f;
+    }
+
+    const size_t ldMask = BroadcastMask ? 0 : D;
+    const size_t CausalOffset = (D > N) ? D - N : 0;
+
+    for (bool LogSoftmax : {false, true}) {
+      MLAS_SOFTMAX_FUSED_PARAMS Params;
+      Params.Scale = Scale;
+      Params.Bias = HasBias ? Bias : nullptr;
+      Params.ldBias = D;
+      Params.Mask = Mask;
+      Params.ldMask = ldMask;
+      Params.Causal = Causal;
+      Params.CausalOffset = CausalOffset;
+      Params.LogSoftmax = LogSoftmax;
+
+      const float* Source = Input;
+      if (InPlace) {
+        std::copy_n(Input, N * D, Output);
+        Source = Output;
+      }
+
+      MlasComputeSoftmax(Source, Output, N, D, Params, threadpool_);
+
+      for (size_t n = 0; n < N; n++) {
+        const size_t CountD = Causal ? std::min(D, n + CausalOffset + 1) : D;
+        for (size_t d = 0; d < CountD; d++) {
+          Transformed[n * D + d] = Scale * Input[n * D + d] + (HasBias ? Bias[n * D + d] : 0.0f) + Mask[n * ldMask + d];
+        }
+        ReferenceSoftmax(Transformed + n * D, OutputReference + n * D, 1, CountD, LogSoftmax, false);
+        for (size_t d = CountD; d < D; d++) {
+          OutputReference[n * D + d] = LogSoftmax ? -std::numeric_limits<float>::infinity() : 0.0f;
+        }
+      }
+
+      constexpr float AbsoluteTolerance = 1e-6f;
+      constexpr float RelativeTolerance = 1e-5f;
+
+      for (size_t nd = 0; nd < N * D; nd++) {
+        if (std::isinf(OutputReference[nd])) {
+          ASSERT_EQ(Output[nd], OutputReference[nd]) << "Fused " << N << "/" << D << " @" << nd;
+          continue;
+        }
+        float diff = std::fabs(Output[nd] - OutputReference[nd]);
+        ASSERT_TRUE(diff <= AbsoluteTolerance || diff <= std::fabs(OutputReference[nd]) * RelativeTolerance)
+            << "Fused LogSoftmax:" << (int)LogSoftmax << " Bias:" << (int)HasBias << " Causal:" << (int)Causal
+            << " difference " << N << "/" << D << " @" << nd
+            << ", got: " << Output[nd] << ", expecting: " << OutputReference[nd];
+      }
+    }
+  }
+
   void ReferenceSoftmax(const float* Input, float* Output, size_t N, size_t D, bool LogSoftmax, bool SmoothSoftmax) {
     for (size_t n = 0; n < N; n++) {
       float MaximumValue = std::numeric_limits<float>::lowest();
@@ -104,6 +175,14 @@ class MlasSoftmaxTest : public MlasTestBase {
     Test(3, 128, 20.f, 30.f);
     Test(63, 95, -150.f, 190.f);
     Test(16, 211, 20.f, 30.f);
+
+    for (size_t d : {1, 3, 16, 17, 63, 64, 100, 257}) {
+      TestFused(7, d, 0.125f, true, false, false, false);
+      TestFused(7, d, 1.0f, false, true, false, true);
+      TestFused(7, d, 0.5f, true, true, true, false);
+      TestFused(7, d, 2.0f, true, false, true, true);
+    }
+    TestFused(64, 64, 0.125f, true, false, true, false);
   }
 };
 
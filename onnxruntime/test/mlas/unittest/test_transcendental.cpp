@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "test_fp16.h"
+
+#include <functional>
+
+class MlasTranscendentalTest : public MlasTestBase {
+ private:
+  MatrixGuardBuffer<float> BufferInput;
+  MatrixGuardBuffer<float> BufferOutput;
+  MatrixGuardBuffer<MLFp16> BufferInputFp16;
+  MatrixGuardBuffer<MLFp16> BufferOutputFp16;
+
+  static constexpr float Alpha = 1.6732632423543772f;
+  static constexpr float Gamma = 1.0507009873554805f;
+
+  struct Routine {
+    const char* Name;
+    std::function<void(const float*, float*, size_t)> Compute;
+    std::function<void(const MLAS_FP16*, MLAS_FP16*, size_t)> ComputeFp16;
+    std::function<double(double)> Reference;
+  };
+
+  static std::vector<Routine> GetRoutines() {
+    return {
+        {"GeluErf",
+         [](const float* x, float* y, size_t n) { MlasComputeGeluErf(x, y, n); },
+         [](const MLAS_FP16* x, MLAS_FP16* y, size_t n) { MlasComputeGeluErf(x, y, n); },
+         [](double x) { return 0.5 * x * (1.0 + std::erf(x * M_SQRT1_2)); }},
+        {"Silu",
+         [](const float* x, float* y, size_t n) { MlasComputeSilu(x, y, n); },
+         [](const MLAS_FP16* x, MLAS_FP16* y, size_t n) { MlasComputeSilu(x, y, n); },
+         [](double x) { return x / (1.0 + std::exp(-x)); }},
+        {"Softplus",
+         [](const float* x, float* y, size_t n) { MlasComputeSoftplus(x, y, n); },
+         [](const MLAS_FP16* x, MLAS_FP16* y, size_t n) { MlasComputeSoftplus(x, y, n); },
+         [](double x) { return std::max(x, 0.0) + std::log1p(std::exp(-std::fabs(x))); }},
+        {"Log",
+         [](const float* x, float* y, size_t n) { MlasComputeLog(x, y, n); },
+         [](const MLAS_FP16* x, MLAS_FP16* y, size_t n) { MlasComputeLog(x, y, n); },
+         [](double x) { return std::log(x); }},
+        {"Elu",
+         [](const float* x, float* y, size_t n) { MlasComputeElu(x, y, n, Alpha); },
+         [](const MLAS_FP16* x, MLAS_FP16* y, size_t n) { MlasComputeElu(x, y, n, Alpha); },
+         [](double x) { return x > 0.0 ? x : Alpha * std::expm1(x); }},
+        {"Selu",
+         [](const float* x, float* y, size_t n) { MlasComputeSelu(x, y, n, Alpha, Gamma); },
+         [](const MLAS_FP16* x, MLAS_FP16* y, size_t n) { MlasComputeSelu(x, y, n, Alpha, Gamma); },
+         [](double x) { return Gamma * (x > 0.0 ? x : Alpha * std::expm1(x)); }},
+    };
+  }
+
+  static bool CloseEnough(float Actual, double Expected, float AbsoluteTolerance, float RelativeTolerance) {
+    if (std::isnan(Expected)) {
+      return std::isnan(Actual);
+    }
+    if (std::isinf(static_cast<float>(Expected))) {
+      return Actual == static_cast<float>(Expected);
+    }
+    const double diff = std::fabs(double(Actual) - Expected);
+    return diff <= AbsoluteTolerance || diff <= std::fabs(Expected) * RelativeTolerance;
+  }
+
+  void Test(const Routine& R, size_t N, float MinimumValue, float MaximumValue) {
+    float* Input = BufferInput.GetBuffer(N);
+    float* Output = BufferOutput.GetBuffer(N);
+
+    std::default_random_engine generator(static_cast<unsigned>(N));
+    std::uniform_real_distribution<float> distribution(MinimumValue, MaximumValue);
+
+    for (size_t n = 0; n < N; n++) {
+      Input[n] = distribution(generator);
+    }
+
+    R.Compute(Input, Output, N);
+
+    for (size_t n = 0; n < N; n++) {
+      ASSERT_TRUE(CloseEnough(Output[n], R.Reference(Input[n]), 1e-6f, 2e-6f))
+          << R.Name << " @" << n << " of " << N << ", input: " << Input[n]
+          << ", got: " << Output[n] << ", expecting: " << R.Reference(Input[n]);
+    }
+  }
+
+  void TestSpecialValues(const Routine& R) {
+    static const float Values[] = {
+        0.0f, -0.0f, 1e-30f, -1e-30f, 1e-7f, -1e-7f, 0.3465f, -0.3467f, 0.5f, -0.5f, 0.921875f, -0.921876f,
+        1.0f, -1.0f, 3.9f, -3.95f, 10.0f, -10.0f, 20.0f, -20.0f, 87.0f, -87.0f, 100.0f, -100.0f,
+        std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::min(),
+        std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN()};
+    constexpr size_t N = sizeof(Values) / sizeof(Values[0]);
+
+    float* Output = BufferOutput.GetBuffer(N);
+
+    R.Compute(Values, Output, N);
+
+    for (size_t n = 0; n < N; n++) {
+      const double Expected = R.Reference(Values[n]);
+      if (std::isinf(Values[n]) && std::strcmp(R.Name, "Log") != 0) {
+        // Only the logarithm is defined to return exact results for infinities.
+        continue;
+      }
+      ASSERT_TRUE(CloseEnough(Output[n], Expected, 1e-6f, 2e-6f))
+          << R.Name << " input: " << Values[n] << ", got: " << Output[n] << ", expecting: " << Expected;
+    }
+  }
+
+  void TestFp16(const Routine& R, size_t N, float MinimumValue, float MaximumValue) {
+    MLFp16* Input = BufferInputFp16.GetBuffer(N);
+    MLFp16* Output = BufferOutputFp16.GetBuffer(N);
+
+    std::default_random_engine generator(static_cast<unsigned>(N));
+    std::uniform_real_distribution<float> distribution(MinimumValue, MaximumValue);
+
+    for (size_t n = 0; n < N; n++) {
+      Input[n] = MLFp16(distribution(generator));
+    }
+
+    R.ComputeFp16(reinterpret_cast<const MLAS_FP16*>(Input), reinterpret_cast<MLAS_FP16*>(Output), N);
+
+    for (size_t n = 0; n < N; n++) {
+      const double Expected = R.Reference(Input[n].ToFloat());
+      ASSERT_TRUE(CloseEnough(Output[n].ToFloat(), Expected, 1e-3f, 1e-3f))
+          << R.Name << " fp16 @" << n << " of " << N << ", input: " << Input[n].ToFloat()
+          << ", got: " << Output[n].ToFloat() << ", expecting: " << Expected;
+    }
+  }
+
+ public:
+  static const char* GetTestSuiteName() {
+    static const std::string suite_name("Transcendental");
+    return suite_name.c_str();
+  }
+
+  void ExecuteShort(void) override {
+    for (const auto& R : GetRoutines()) {
+      const bool PositiveOnly = std::strcmp(R.Name, "Log") == 0;
+      for (size_t n = 1; n < 80; n++) {
+        Test(R, n, PositiveOnly ? 0.0f : -10.0f, 10.0f);
+      }
+      Test(R, 1000, PositiveOnly ? 0.0f : -1.0f, 1.0f);
+      Test(R, 1000, PositiveOnly ? 0.0f : -100.0f, 100.0f);
+      if (PositiveOnly) {
+        Test(R, 1000, 0.0f, 1e-36f);
+        Test(R, 1000, 0.0f, 1e30f);
+      }
+      TestSpecialValues(R);
+      TestFp16(R, 333, PositiveOnly ? 0.01f : -8.0f, 8.0f);
+    }
+  }
+};
+
+static UNUSED_VARIABLE bool added_to_main = AddTestRegister([](bool is_short_execute) {
+  // no long execute needed
+  return is_short_execute ? MlasDirectShortExecuteTests<MlasTranscendentalTest>::RegisterShortExecute() : 0;
+});
@@ -2767,6 +2767,36 @@ TEST_F(GraphTransformationTests, Gemm_LeakyRelu_Fusion) {
   ASSERT_TRUE(op_to_count["Gemm"] == 0);
   ASSERT_TRUE(op_to_count["com.microsoft.FusedGemm"] == 1);
 }
+
+TEST_F(GraphTransformationTests, Gemm_Gelu_Fusion) {
+  auto build_test_case = [&](ModelTestBuilder& builder) {
+    auto* input_arg = builder.MakeInput<float>({{4, 16}});
+    auto* weight_arg = builder.MakeInitializer<float>({16, 8}, -1.0f, 1.0f);
+    auto* bias_arg = builder.MakeInitializer<float>({8}, -1.0f, 1.0f);
+    auto* gemm_out = builder.MakeIntermediate();
+    auto* output_arg = builder.MakeOutput();
+
+    builder.AddNode("Gemm", {input_arg, weight_arg, bias_arg}, {gemm_out});
+    builder.AddNode("Gelu", {gemm_out}, {output_arg}).AddAttribute("approximate", "tanh");
+  };
+
+  auto post_graph_checker = [](Graph& graph) {
+    auto op_to_count = CountOpsInGraph(graph);
+    TEST_RETURN_IF_NOT(op_to_count["Gelu"] == 0);
+    TEST_RETURN_IF_NOT(op_to_count["Gemm"] == 0);
+    TEST_RETURN_IF_NOT(op_to_count["com.microsoft.FusedGemm"] == 1);
+    for (const auto& node : graph.Nodes()) {
+      if (node.OpType() == "FusedGemm") {
+        TEST_RETURN_IF_NOT(node.GetAttributes().at("activation").s() == "Gelu");
+        TEST_RETURN_IF_NOT(node.GetAttributes().at("activation_approximate").s() == "tanh");
+      }
+    }
+    return Status::OK();
+  };
+
+  ASSERT_STATUS_OK(TestGraphTransformer(build_test_case, 20, *logger_, std::make_unique<GemmActivationFusion>(),
+                                        TransformerLevel::Level2, 1, nullptr, post_graph_checker));
+}
 #endif
 
 // (A')'B' = AB'
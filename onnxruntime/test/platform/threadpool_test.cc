@@ -12,8 +12,11 @@
 
 #include "gtest/gtest.h"
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <functional>
+#include <set>
+#include <thread>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -51,15 +54,22 @@ void ValidateTestData(TestData& test_data, int expected = 1) {
 // test the function with a null pointer, reflecting scenarios where we
 // run with just the main thread.  Note that the thread pool API uses
 // static methods and should operate across all of these cases.
-void CreateThreadPoolAndTest(const std::string&, int num_threads, const std::function<void(ThreadPool*)>& test_body, int dynamic_block_base = 0, bool mock_hybrid = false) {
+void CreateThreadPoolAndTest(const std::string&, int num_threads, const std::function<void(ThreadPool*)>& test_body, int dynamic_block_base = 0, bool mock_hybrid = false, bool mock_numa = false) {
   if (num_threads > 0) {
+    onnxruntime::ThreadOptions thread_options;
+    if (mock_numa) {
+      // Split the threads into two groups as if they ran on two NUMA nodes.  The first
+      // group uses an unknown node (-1) so that no memory policy is applied to its threads.
+      for (int i = 0; i < num_threads; i++) {
+        thread_options.numa_nodes.push_back(i < num_threads / 2 ? -1 : 0);
+      }
+    }
     if (dynamic_block_base > 0) {
-      onnxruntime::ThreadOptions thread_options;
       thread_options.dynamic_block_base_ = dynamic_block_base;
       auto tp_dynamic_block_size = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), thread_options, nullptr, num_threads, true, mock_hybrid);
       test_body(tp_dynamic_block_size.get());  // test thread pool with dynamic block size
     } else {
-      auto tp_constant_block_size = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), onnxruntime::ThreadOptions{}, nullptr, num_threads, true, mock_hybrid);
+      auto tp_constant_block_size = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), thread_options, nullptr, num_threads, true, mock_hybrid);
       test_body(tp_constant_block_size.get());  // test thread pool with constant block size
     }
   } else {
@@ -85,7 +95,7 @@ void TestBatchParallelFor(const std::string& name, int num_threads, int num_task
   ValidateTestData(*test_data);
 }
 
-void TestConcurrentParallelFor(const std::string& name, int num_threads, int num_concurrent, int num_tasks, int dynamic_block_base = 0, bool mock_hybrid = false) {
+void TestConcurrentParallelFor(const std::string& name, int num_threads, int num_concurrent, int num_tasks, int dynamic_block_base = 0, bool mock_hybrid = false, bool mock_numa = false) {
   // Test running multiple concurrent loops over the same thread pool.  This aims to provoke a
   // more diverse mix of interleavings than with a single loop running at a time.
   for (int rep = 0; rep < 5; rep++) {
@@ -120,7 +130,7 @@ void TestConcurrentParallelFor(const std::string& name, int num_threads, int num
           }
           td.clear();
         },
-        dynamic_block_base, mock_hybrid);
+        dynamic_block_base, mock_hybrid, mock_numa);
   }
 }
 
@@ -416,6 +426,18 @@ TEST(ThreadPoolTest, TestConcurrentParallelFor_4Thread_4Conc_1MTasks_dynamic_blo
   TestConcurrentParallelFor("TestConcurrentParallelFor_4Thread_4Conc_1MTasks_dynamic_block_base_128", 4, 4, 1000000, 128, true);
 }
 
+TEST(ThreadPoolTest, TestConcurrentParallelFor_4Thread_4Conc_1MTasks_numa) {
+  TestConcurrentParallelFor("TestConcurrentParallelFor_4Thread_4Conc_1MTasks_numa", 4, 4, 1000000, 0, false, true);
+}
+
+TEST(ThreadPoolTest, TestConcurrentParallelFor_8Thread_4Conc_1MTasks_numa) {
+  TestConcurrentParallelFor("TestConcurrentParallelFor_8Thread_4Conc_1MTasks_numa", 8, 4, 1000000, 0, false, true);
+}
+
+TEST(ThreadPoolTest, TestConcurrentParallelFor_4Thread_4Conc_1MTasks_dynamic_block_base_16_numa) {
+  TestConcurrentParallelFor("TestConcurrentParallelFor_4Thread_4Conc_1MTasks_dynamic_block_base_16_numa", 4, 4, 1000000, 16, false, true);
+}
+
 TEST(ThreadPoolTest, TestBurstScheduling_0Tasks) {
   TestBurstScheduling("TestBurstScheduling_0Tasks", 0);
 }
@@ -510,6 +532,139 @@ TEST(ThreadPoolTest, TestStagedMultiLoopSections_4Thread_100Loop) {
   TestStagedMultiLoopSections("TestStagedMultiLoopSections_4Thread_100Loop", 4, 100);
 }
 
+TEST(ThreadPoolTest, TestSchedulingScopeMaxDegreeOfParallelism) {
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), onnxruntime::ThreadOptions(), nullptr, 4, true);
+  constexpr int num_tasks = 1024;
+  std::mutex mutex;
+  std::set<std::thread::id> thread_ids;
+  auto run_loop = [&](TestData& test_data) {
+    ThreadPool::TrySimpleParallelFor(tp.get(), num_tasks, [&](std::ptrdiff_t i) {
+      IncrementElement(test_data, i);
+      std::lock_guard<std::mutex> lock(mutex);
+      thread_ids.insert(std::this_thread::get_id());
+    });
+  };
+
+  // With a quota of one thread the loop runs entirely in the caller.
+  auto test_data = CreateTestData(num_tasks);
+  {
+    ThreadPool::SchedulingScope scope({1, 1});
+    run_loop(*test_data);
+  }
+  ValidateTestData(*test_data);
+  ASSERT_EQ(thread_ids.size(), 1u);
+  ASSERT_EQ(*thread_ids.begin(), std::this_thread::get_id());
+
+  // Work scheduled on the pool inherits the scope of the thread scheduling it.
+  thread_ids.clear();
+  test_data = CreateTestData(num_tasks);
+  onnxruntime::Barrier barrier(1);
+  {
+    ThreadPool::SchedulingScope scope({1, 1});
+    ThreadPool::Schedule(tp.get(), [&]() {
+      run_loop(*test_data);
+      barrier.Notify();
+    });
+  }
+  barrier.Wait();
+  ValidateTestData(*test_data);
+  ASSERT_EQ(thread_ids.size(), 1u);
+}
+
+TEST(ThreadPoolTest, TestAdaptiveParallelism_4Thread_4Callers) {
+  // Run loops from several callers with different priorities at the same time on a pool that
+  // shares its threads between them, and check that every loop still covers its iterations.
+  onnxruntime::ThreadOptions thread_options;
+  thread_options.adaptive_parallelism = true;
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), thread_options, nullptr, 4, true);
+  constexpr int num_callers = 4;
+  constexpr int num_tasks = 10000;
+  std::vector<std::unique_ptr<TestData>> td;
+  for (int c = 0; c < num_callers; c++) {
+    td.push_back(CreateTestData(num_tasks));
+  }
+  std::vector<std::thread> callers;
+  for (int c = 0; c < num_callers; c++) {
+    callers.emplace_back([&, c]() {
+      ThreadPool::SchedulingScope scope({static_cast<unsigned>(c + 1), 0});
+      for (int l = 0; l < 10; l++) {
+        ThreadPool::TrySimpleParallelFor(tp.get(), num_tasks, [&](std::ptrdiff_t i) {
+          IncrementElement(*td[c], i);
+        });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  for (int c = 0; c < num_callers; c++) {
+    ValidateTestData(*td[c], 10);
+  }
+}
+
+TEST(ThreadPoolTest, TestAdaptiveSpinning_4Thread_Bursts) {
+  // Run bursts of loops separated by idle gaps of different lengths, so that the workers both find work
+  // while spinning and block, and check that every loop still covers its iterations.
+  onnxruntime::ThreadOptions thread_options;
+  thread_options.adaptive_spinning = true;
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), thread_options, nullptr, 4, true);
+  constexpr int num_tasks = 1000;
+  auto td = CreateTestData(num_tasks);
+  constexpr int num_bursts = 20;
+  for (int b = 0; b < num_bursts; b++) {
+    for (int l = 0; l < 5; l++) {
+      ThreadPool::TrySimpleParallelFor(tp.get(), num_tasks, [&](std::ptrdiff_t i) {
+        IncrementElement(*td, i);
+      });
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(b % 2 == 0 ? 10 : 2000));
+  }
+  ValidateTestData(*td, num_bursts * 5);
+}
+
+TEST(ThreadPoolTest, TestLatencyMode) {
+  // Latency mode may be entered by several callers at once, and must override a pool that does not spin.
+  onnxruntime::ThreadOptions thread_options;
+  thread_options.adaptive_spinning = true;
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), thread_options, nullptr, 4, false);
+  constexpr int num_tasks = 1000;
+  auto td = CreateTestData(num_tasks);
+  tp->EnterLatencyMode();
+  tp->EnterLatencyMode();
+  for (int l = 0; l < 10; l++) {
+    ThreadPool::TrySimpleParallelFor(tp.get(), num_tasks, [&](std::ptrdiff_t i) {
+      IncrementElement(*td, i);
+    });
+  }
+  tp->ExitLatencyMode();
+  tp->ExitLatencyMode();
+  for (int l = 0; l < 10; l++) {
+    ThreadPool::TrySimpleParallelFor(tp.get(), num_tasks, [&](std::ptrdiff_t i) {
+      IncrementElement(*td, i);
+    });
+  }
+  ValidateTestData(*td, 20);
+}
+
+TEST(ThreadPoolTest, TestBusyTime) {
+  onnxruntime::ThreadOptions thread_options;
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), thread_options, nullptr, 2, true);
+  EXPECT_EQ(ThreadPool::BusyTimeNs(tp.get()), 0u);
+  ThreadPool::StartTrackingBusyTime(tp.get());
+  Notification n;
+  ThreadPool::Schedule(tp.get(), [&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    n.Notify();
+  });
+  n.Wait();
+  // The task is accounted once it returns, which may be shortly after it notifies.
+  while (ThreadPool::BusyTimeNs(tp.get()) == 0) {
+    std::this_thread::yield();
+  }
+  EXPECT_GE(ThreadPool::BusyTimeNs(tp.get()), 2000000u);
+  EXPECT_EQ(ThreadPool::BusyTimeNs(nullptr), 0u);
+}
+
 #ifdef _WIN32
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
 #pragma warning(push)
@@ -170,6 +170,29 @@ TEST(GemmOpTest, GemmTransB_f16) {
         .Config(run_with_tunable_op)
         .RunWithConfig();
   }
+  for (bool is_b_constant : {true, false}) {
+    // bias is a vector and transB is True
+    std::vector<MLFloat16> f_Y(6);
+    std::vector<float> Y{7.6f, -4.1f, -17.8f, -6.6f, 8.3f, 20.2f};
+    ConvertFloatToMLFloat16(Y.data(), f_Y.data(), 6);
+
+    std::vector<MLFloat16> f_C(3);
+    ConvertFloatToMLFloat16(C.data(), f_C.data(), 3);
+    OpTester test("Gemm", 13);
+
+    test.AddAttribute("transA", (int64_t)0);
+    test.AddAttribute("transB", (int64_t)1);
+    test.AddAttribute("alpha", 1.0f);
+    test.AddAttribute("beta", 1.0f);
+    test.AddInput<MLFloat16>("A", {2, 4}, f_A);
+    test.AddInput<MLFloat16>("B", {3, 4}, f_B, is_b_constant);
+    test.AddInput<MLFloat16>("C", {3}, f_C, true);
+    test.AddOutput<MLFloat16>("Y", {2, 3}, f_Y);
+    test.SetOutputTolerance(0.005f);
+    test.ConfigExcludeEps({kTensorrtExecutionProvider})  // TensorRT: fp16 is not supported
+        .Config(run_with_tunable_op)
+        .RunWithConfig();
+  }
 }
 
 #if defined(USE_CUDA) || defined(USE_ROCM) || defined(USE_DNNL)
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include "gtest/gtest.h"
+#include "core/mlas/inc/mlas.h"
 
 #include "test/providers/provider_test_utils.h"
 #include "test/providers/run_options_config_keys.h"
@@ -210,7 +211,8 @@ TEST(MathOpTest, MatMulFloatType) {
   RunMatMulTest<float>(7, false, true);
 }
 
-#if defined(USE_CUDA) || defined(USE_ROCM) || defined(COREML_ENABLE_MLPROGRAM) || defined(USE_XNNPACK)
+#if defined(USE_CUDA) || defined(USE_ROCM) || defined(COREML_ENABLE_MLPROGRAM) || defined(USE_XNNPACK) || \
+    defined(MLAS_TARGET_AMD64)
 TEST(MathOpTest, MatMulFloat16) {
 #ifdef USE_CUDA
   int min_cuda_architecture = 530;
@@ -218,6 +220,13 @@ TEST(MathOpTest, MatMulFloat16) {
     LOGS_DEFAULT(WARNING) << "Hardware NOT support FP16";
     return;
   }
+#endif
+#if defined(MLAS_TARGET_AMD64) && !defined(USE_CUDA) && !defined(USE_ROCM) && !defined(COREML_ENABLE_MLPROGRAM) && \
+    !defined(USE_XNNPACK)
+  // the CPU kernel is only registered when MLAS has a half precision GEMM kernel for the CPU
+  if (!MlasHalfGemmAccelerationSupported()) {
+    GTEST_SKIP() << "Skipping because the CPU has no half precision GEMM kernel";
+  }
 #endif
   // TODO: Unskip when fixed #41968513
   if (DefaultDmlExecutionProvider().get() != nullptr) {
@@ -276,7 +285,8 @@ TEST(MathOpTest, MatMulZeroKInt32Type) {
   RunMatMulZeroKTest<int32_t>();
 }
 
-#if defined(USE_CUDA) || defined(USE_ROCM) || defined(COREML_ENABLE_MLPROGRAM) || defined(USE_XNNPACK)
+#if defined(USE_CUDA) || defined(USE_ROCM) || defined(COREML_ENABLE_MLPROGRAM) || defined(USE_XNNPACK) || \
+    defined(MLAS_TARGET_AMD64)
 TEST(MathOpTest, MatMul_Float16) {
 #ifdef USE_CUDA
   int min_cuda_architecture = 530;
@@ -284,6 +294,13 @@ TEST(MathOpTest, MatMul_Float16) {
     LOGS_DEFAULT(WARNING) << "Hardware NOT support FP16";
     return;
   }
+#endif
+#if defined(MLAS_TARGET_AMD64) && !defined(USE_CUDA) && !defined(USE_ROCM) && !defined(COREML_ENABLE_MLPROGRAM) && \
+    !defined(USE_XNNPACK)
+  // the CPU kernel is only registered when MLAS has a half precision GEMM kernel for the CPU
+  if (!MlasHalfGemmAccelerationSupported()) {
+    GTEST_SKIP() << "Skipping because the CPU has no half precision GEMM kernel";
+  }
 #endif
   std::vector<float> A{1.0f, 2.0f, 3.0f, 4.0f,
                        -1.0f, -2.0f, -3.0f, -4.0f};
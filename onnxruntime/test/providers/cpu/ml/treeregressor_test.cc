@@ -1,7 +1,14 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <type_traits>
 #include "gtest/gtest.h"
+#include "core/providers/cpu/ml/tree_ensemble_quickscorer.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 #include "test/providers/provider_test_utils.h"
 
 namespace onnxruntime {
@@ -844,5 +851,254 @@ TEST(MLOpTest, TreeRegressorTrueNodeBeforeNode) {
   test.Run();
 }
 
+// Random forest of complete trees with missing values. Expected values are computed by walking the trees in the test.
+// Trees of depth 3 fit the bitvector engine, deeper trees or rules other than BRANCH_LEQ and BRANCH_LT use the
+// flat layout. Disabling both engines runs the node by node traversal.
+// Double inputs are placed within one float ulp of the thresholds, so rounding them to float changes the branches.
+template <typename InputType = float>
+void GenRandomForestAndRunTest(const std::string& mode, int64_t n_targets, int64_t n_obs, int depth,
+                               bool use_quick_scorer, bool use_flat_layout) {
+  const int64_t n_features = 6;
+  const int n_trees = 300;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> feature_dist(0, static_cast<int>(n_features) - 1);
+  std::uniform_int_distribution<int> value_dist(-8, 8);
+
+  std::vector<int64_t> lefts, rights, treeids, nodeids, featureids, missing_tracks;
+  std::vector<float> thresholds;
+  std::vector<std::string> modes;
+  std::vector<int64_t> target_treeids, target_nodeids, target_ids;
+  std::vector<float> target_weights;
+
+  // Trees are stored in breadth first order, the children of node i are 2i+1 and 2i+2.
+  const int64_t n_nodes_per_tree = (int64_t(1) << (depth + 1)) - 1;
+  const int64_t n_internal_per_tree = (int64_t(1) << depth) - 1;
+  const int64_t n_leaves_per_tree = n_nodes_per_tree - n_internal_per_tree;
+  for (int t = 0; t < n_trees; ++t) {
+    for (int64_t i = 0; i < n_nodes_per_tree; ++i) {
+      treeids.push_back(t);
+      nodeids.push_back(i);
+      if (i < n_internal_per_tree) {
+        lefts.push_back(2 * i + 1);
+        rights.push_back(2 * i + 2);
+        featureids.push_back(feature_dist(rng));
+        thresholds.push_back(static_cast<float>(value_dist(rng)) / 2);
+        modes.push_back(mode);
+        missing_tracks.push_back(value_dist(rng) > 4 ? 1 : 0);
+      } else {
+        lefts.push_back(0);
+        rights.push_back(0);
+        featureids.push_back(0);
+        thresholds.push_back(0);
+        modes.push_back("LEAF");
+        missing_tracks.push_back(0);
+        for (int64_t k = 0; k < n_targets; ++k) {
+          target_treeids.push_back(t);
+          target_nodeids.push_back(i);
+          target_ids.push_back(k);
+          target_weights.push_back(static_cast<float>(value_dist(rng)));
+        }
+      }
+    }
+  }
+
+  std::vector<InputType> X(n_obs * n_features);
+  std::uniform_int_distribution<int> offset_dist(0, 4);
+  for (size_t i = 0; i < X.size(); ++i) {
+    if (i % 11 == 0) {
+      X[i] = std::numeric_limits<InputType>::quiet_NaN();
+      continue;
+    }
+    const float value = static_cast<float>(value_dist(rng)) / 2;
+    X[i] = value;
+    if constexpr (std::is_same_v<InputType, double>) {
+      const double float_ulp = static_cast<double>(std::nextafter(value, std::numeric_limits<float>::infinity())) -
+                               value;
+      // below, on, or above the value, and within the float ulp above it
+      constexpr double offsets[] = {-0.5, 0.0, 0.25, 0.5, 0.75};
+      X[i] = value + offsets[offset_dist(rng)] * float_ulp;
+    }
+  }
+
+  std::vector<float> Y(n_obs * n_targets, 0.f);
+  for (int64_t n = 0; n < n_obs; ++n) {
+    for (int t = 0; t < n_trees; ++t) {
+      int64_t i = 0;
+      while (i < n_internal_per_tree) {
+        int64_t pos = t * n_nodes_per_tree + i;
+        InputType val = X[n * n_features + featureids[pos]];
+        bool cond;
+        if (mode == "BRANCH_LEQ") {
+          cond = val <= thresholds[pos];
+        } else if (mode == "BRANCH_LT") {
+          cond = val < thresholds[pos];
+        } else if (mode == "BRANCH_GTE") {
+          cond = val >= thresholds[pos];
+        } else {
+          cond = val > thresholds[pos];
+        }
+        i = (cond || (std::isnan(val) && missing_tracks[pos] == 1)) ? lefts[pos] : rights[pos];
+      }
+      for (int64_t k = 0; k < n_targets; ++k) {
+        Y[n * n_targets + k] += target_weights[(t * n_leaves_per_tree + i - n_internal_per_tree) * n_targets + k];
+      }
+    }
+  }
+
+  OpTester test("TreeEnsembleRegressor", 3, onnxruntime::kMLDomain);
+  test.AddAttribute("nodes_truenodeids", lefts);
+  test.AddAttribute("nodes_falsenodeids", rights);
+  test.AddAttribute("nodes_treeids", treeids);
+  test.AddAttribute("nodes_nodeids", nodeids);
+  test.AddAttribute("nodes_featureids", featureids);
+  test.AddAttribute("nodes_values", thresholds);
+  test.AddAttribute("nodes_modes", modes);
+  test.AddAttribute("nodes_missing_value_tracks_true", missing_tracks);
+  test.AddAttribute("target_treeids", target_treeids);
+  test.AddAttribute("target_nodeids", target_nodeids);
+  test.AddAttribute("target_ids", target_ids);
+  test.AddAttribute("target_weights", target_weights);
+  test.AddAttribute("n_targets", n_targets);
+  test.AddInput<InputType>("X", {n_obs, n_features}, X);
+  test.AddOutput<float>("Y", {n_obs, n_targets}, Y);
+
+  SessionOptions so;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsTreeEnsembleQuickScorer,
+                                                    use_quick_scorer ? "1" : "0"));
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsTreeEnsembleFlatLayout,
+                                                    use_flat_layout ? "1" : "0"));
+  test.Config(so).RunWithConfig();
+}
+
+TEST(MLOpTest, TreeRegressorQuickScorerSingleTarget) {
+  for (int64_t n_obs : {1, 7, 100}) {
+    GenRandomForestAndRunTest("BRANCH_LEQ", 1, n_obs, 3, true, false);
+    GenRandomForestAndRunTest("BRANCH_LT", 1, n_obs, 3, true, false);
+    GenRandomForestAndRunTest("BRANCH_LEQ", 1, n_obs, 3, false, false);
+  }
+}
+
+TEST(MLOpTest, TreeRegressorQuickScorerMultiTarget) {
+  for (int64_t n_obs : {1, 7, 100}) {
+    GenRandomForestAndRunTest("BRANCH_LEQ", 3, n_obs, 3, true, false);
+    GenRandomForestAndRunTest("BRANCH_LT", 3, n_obs, 3, true, false);
+    GenRandomForestAndRunTest("BRANCH_LT", 3, n_obs, 3, false, false);
+  }
+}
+
+TEST(MLOpTest, TreeRegressorQuickScorerDoubleInput) {
+  for (int64_t n_obs : {1, 7, 100}) {
+    GenRandomForestAndRunTest<double>("BRANCH_LEQ", 1, n_obs, 3, true, false);
+    GenRandomForestAndRunTest<double>("BRANCH_LT", 3, n_obs, 3, true, false);
+    GenRandomForestAndRunTest<double>("BRANCH_LEQ", 1, n_obs, 3, false, false);
+  }
+}
+
+// The bitvector engine with float thresholds and double inputs within one float ulp of the thresholds should select
+// the same leaves as walking the trees, which compares in double.
+TEST(MLOpTest, TreeEnsembleQuickScorerWiderInput) {
+  using ml::detail::NODE_MODE_ORT;
+  using ml::detail::TreeEnsembleQuickScorer;
+  using ml::detail::TreeNodeElement;
+  constexpr int depth = 3;
+  constexpr int n_trees = 300;
+  constexpr int64_t n_features = 6;
+  constexpr size_t n_rows = 37;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> feature_dist(0, static_cast<int>(n_features) - 1);
+  std::uniform_int_distribution<int> value_dist(-8, 8);
+  std::uniform_int_distribution<int> offset_dist(0, 4);
+
+  for (auto mode : {NODE_MODE_ORT::BRANCH_LEQ, NODE_MODE_ORT::BRANCH_LT}) {
+    // Complete trees, the false child of a node follows it and the true child follows the false subtree.
+    std::vector<TreeNodeElement<float>> nodes;
+    nodes.reserve(static_cast<size_t>(n_trees) * ((size_t(1) << (depth + 1)) - 1));
+    std::vector<size_t> true_children;
+    std::function<size_t(int)> add_node = [&](int level) {
+      const size_t index = nodes.size();
+      nodes.emplace_back();
+      true_children.push_back(0);
+      if (level == depth) {
+        nodes[index].flags = NODE_MODE_ORT::LEAF;
+        return index;
+      }
+      nodes[index].feature_id = feature_dist(rng);
+      nodes[index].value_or_unique_weight = static_cast<float>(value_dist(rng)) / 2;
+      nodes[index].flags = mode;
+      add_node(level + 1);
+      true_children[index] = add_node(level + 1);
+      return index;
+    };
+    std::vector<size_t> root_indices;
+    for (int t = 0; t < n_trees; ++t) {
+      root_indices.push_back(add_node(0));
+    }
+    std::vector<TreeNodeElement<float>*> roots;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (nodes[i].is_not_leaf()) {
+        nodes[i].truenode_or_weight.ptr = &nodes[true_children[i]];
+      }
+    }
+    for (size_t index : root_indices) {
+      roots.push_back(&nodes[index]);
+    }
+
+    TreeEnsembleQuickScorer<float> quick_scorer;
+    ASSERT_TRUE(quick_scorer.Init(nodes, roots));
+
+    std::vector<double> X(n_rows * n_features);
+    for (auto& x : X) {
+      const float value = static_cast<float>(value_dist(rng)) / 2;
+      const double float_ulp = static_cast<double>(std::nextafter(value, std::numeric_limits<float>::infinity())) -
+                               value;
+      constexpr double offsets[] = {-0.5, 0.0, 0.25, 0.5, 0.75};
+      x = value + offsets[offset_dist(rng)] * float_ulp;
+    }
+
+    auto walk = [&](const TreeNodeElement<float>* node, const double* x) {
+      while (node->is_not_leaf()) {
+        const double val = x[node->feature_id];
+        const bool cond = mode == NODE_MODE_ORT::BRANCH_LT ? val < node->value_or_unique_weight
+                                                               : val <= node->value_or_unique_weight;
+        node = cond ? node->truenode_or_weight.ptr : node + 1;
+      }
+      return node;
+    };
+
+    TreeEnsembleQuickScorer<float>::Scratch scratch;
+    constexpr size_t kRowBlockSize = TreeEnsembleQuickScorer<float>::kRowBlockSize;
+    for (size_t row = 0; row < n_rows; row += kRowBlockSize) {
+      const size_t n_block_rows = std::min(kRowBlockSize, n_rows - row);
+      for (size_t block = 0; block < quick_scorer.NumTreeBlocks(); ++block) {
+        quick_scorer.ComputeLeaves(block, X.data() + row * n_features, n_features, n_block_rows, scratch);
+        for (size_t t = 0; t < quick_scorer.TreeBlockSize(block); ++t) {
+          for (size_t r = 0; r < n_block_rows; ++r) {
+            ASSERT_EQ(scratch.leaves[t * kRowBlockSize + r],
+                      walk(roots[quick_scorer.TreeBlockBegin(block) + t], X.data() + (row + r) * n_features))
+                << "tree " << quick_scorer.TreeBlockBegin(block) + t << " row " << row + r;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(MLOpTest, TreeRegressorFlatLayoutSingleTarget) {
+  for (int64_t n_obs : {1, 7, 100}) {
+    GenRandomForestAndRunTest("BRANCH_LEQ", 1, n_obs, 7, true, true);
+    GenRandomForestAndRunTest("BRANCH_GTE", 1, n_obs, 3, true, true);
+    GenRandomForestAndRunTest("BRANCH_GT", 1, n_obs, 3, false, true);
+    GenRandomForestAndRunTest("BRANCH_GT", 1, n_obs, 3, false, false);
+  }
+}
+
+TEST(MLOpTest, TreeRegressorFlatLayoutMultiTarget) {
+  for (int64_t n_obs : {1, 7, 100}) {
+    GenRandomForestAndRunTest("BRANCH_LT", 3, n_obs, 7, true, true);
+    GenRandomForestAndRunTest("BRANCH_GTE", 3, n_obs, 3, true, true);
+    GenRandomForestAndRunTest("BRANCH_GTE", 3, n_obs, 7, false, false);
+  }
+}
+
 }  // namespace test
 }  // namespace onnxruntime
@@ -1,8 +1,10 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 #include "core/graph/constants.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 #include "gtest/gtest.h"
 #include "test/providers/provider_test_utils.h"
+#include "default_providers.h"
 
 using namespace std;
 namespace onnxruntime {
@@ -992,5 +994,76 @@ TEST(ConvTest, Conv_AutoPad_with_non_default_strides) {
   TestConvOp(attrs, {X, W}, {X_shape, W_shape}, expected_vals, Y_shape, true);
 }
 
+// Runs a padded 3x3 convolution of `channels` to `channels` with the MLAS Winograd algorithm enabled. The filter is
+// an initializer, so Conv transforms it in PrePack when MlasConvPrepare will choose the F(4x4,3x3) tile.
+static void TestConvWinograd(int64_t channels, int64_t height, int64_t width) {
+  const vector<int64_t> X_shape = {1, channels, height, width};
+  const vector<int64_t> W_shape = {channels, channels, 3, 3};
+  const vector<int64_t> Y_shape = {1, channels, height, width};
+
+  vector<float> X(static_cast<size_t>(channels * height * width));
+  for (size_t i = 0; i < X.size(); i++) {
+    X[i] = static_cast<float>((i * 37) % 101) / 101.f - 0.5f;
+  }
+  vector<float> W(static_cast<size_t>(channels * channels * 9));
+  for (size_t i = 0; i < W.size(); i++) {
+    W[i] = static_cast<float>((i * 53) % 97) / 97.f - 0.5f;
+  }
+  vector<float> B(static_cast<size_t>(channels));
+  for (size_t i = 0; i < B.size(); i++) {
+    B[i] = static_cast<float>(i % 7) / 7.f;
+  }
+
+  vector<float> Y(static_cast<size_t>(channels * height * width));
+  for (int64_t m = 0; m < channels; m++) {
+    for (int64_t oh = 0; oh < height; oh++) {
+      for (int64_t ow = 0; ow < width; ow++) {
+        double sum = B[m];
+        for (int64_t c = 0; c < channels; c++) {
+          for (int64_t kh = 0; kh < 3; kh++) {
+            for (int64_t kw = 0; kw < 3; kw++) {
+              const int64_t ih = oh + kh - 1;
+              const int64_t iw = ow + kw - 1;
+              if (ih >= 0 && ih < height && iw >= 0 && iw < width) {
+                sum += static_cast<double>(X[(c * height + ih) * width + iw]) *
+                       W[((m * channels + c) * 3 + kh) * 3 + kw];
+              }
+            }
+          }
+        }
+        Y[(m * height + oh) * width + ow] = static_cast<float>(sum);
+      }
+    }
+  }
+
+  OpTester test("Conv", 11);
+  test.AddAttribute("kernel_shape", vector<int64_t>{3, 3});
+  test.AddAttribute("pads", vector<int64_t>{1, 1, 1, 1});
+  test.AddInput<float>("X", X_shape, X);
+  test.AddInput<float>("W", W_shape, W, true);
+  test.AddInput<float>("B", {channels}, B, true);
+  test.AddOutput<float>("Y", Y_shape, Y);
+  // The Winograd transforms round differently than the direct sum.
+  test.SetOutputTolerance(1e-3f);
+
+  SessionOptions so;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsMlasConvWinograd, "1"));
+
+  std::vector<std::unique_ptr<IExecutionProvider>> execution_providers;
+  execution_providers.push_back(DefaultCpuExecutionProvider());
+  test.Config(so)
+      .ConfigEps(std::move(execution_providers))
+      .RunWithConfig();
+}
+
+TEST(ConvTest, Conv2D_Winograd) {
+  // F(4x4,3x3), the filter is transformed in PrePack.
+  TestConvWinograd(64, 10, 10);
+  // F(2x2,3x3) as the output is too small for the larger tiles.
+  TestConvWinograd(64, 6, 6);
+  // F(2x2,3x3) as the channels leave too few of the larger tiles per GEMM in the working set.
+  TestConvWinograd(464, 8, 8);
+}
+
 }  // namespace test
 }  // namespace onnxruntime
@@ -0,0 +1,160 @@
+# -------------------------------------------------------------------------
+# Copyright (c) Microsoft Corporation.  All rights reserved.
+# Licensed under the MIT License.
+# --------------------------------------------------------------------------
+
+"""
+Benchmark token generation of GroupQueryAttention on CPU with a contiguous kv cache of max_sequence_length per
+sequence and with a paged kv cache (block_table input) sized to the tokens of each sequence.
+
+Example: python benchmark_gqa_paged_cpu.py --num_sequences 64 --max_sequence_length 4096 --block_size 16
+"""
+
+import argparse
+import gc
+import time
+
+import numpy
+import psutil
+from onnx import TensorProto, helper
+
+from onnxruntime import InferenceSession, OrtValue, SessionOptions
+
+
+def create_gqa_graph(args, past_shape, paged: bool):
+    hidden_size = args.num_heads * args.head_size
+    kv_hidden_size = args.kv_num_heads * args.head_size
+    inputs = ["query", "key", "value", "past_key", "past_value", "seqlens_k", "total_sequence_length"]
+    if paged:
+        inputs += ["", "", "block_table"]
+    node = helper.make_node(
+        "GroupQueryAttention",
+        inputs,
+        ["output", "present_key", "present_value"],
+        "GroupQueryAttention_0",
+        num_heads=args.num_heads,
+        kv_num_heads=args.kv_num_heads,
+        domain="com.microsoft",
+    )
+
+    batch_size = args.num_sequences
+    graph_input = [
+        helper.make_tensor_value_info("query", TensorProto.FLOAT, [batch_size, 1, hidden_size]),
+        helper.make_tensor_value_info("key", TensorProto.FLOAT, [batch_size, 1, kv_hidden_size]),
+        helper.make_tensor_value_info("value", TensorProto.FLOAT, [batch_size, 1, kv_hidden_size]),
+        helper.make_tensor_value_info("past_key", TensorProto.FLOAT, past_shape),
+        helper.make_tensor_value_info("past_value", TensorProto.FLOAT, past_shape),
+        helper.make_tensor_value_info("seqlens_k", TensorProto.INT32, [batch_size]),
+        helper.make_tensor_value_info("total_sequence_length", TensorProto.INT32, [1]),
+    ]
+    if paged:
+        graph_input.append(helper.make_tensor_value_info("block_table", TensorProto.INT32, [batch_size, None]))
+    graph_output = [
+        helper.make_tensor_value_info("output", TensorProto.FLOAT, [batch_size, 1, hidden_size]),
+        helper.make_tensor_value_info("present_key", TensorProto.FLOAT, past_shape),
+        helper.make_tensor_value_info("present_value", TensorProto.FLOAT, past_shape),
+    ]
+    graph = helper.make_graph([node], "GroupQueryAttention_Graph", graph_input, graph_output)
+    return helper.make_model(graph).SerializeToString()
+
+
+def get_prompt_lengths(args):
+    # Concurrent sequences have different lengths, like requests of a server
+    rng = numpy.random.default_rng(args.seed)
+    max_prompt_length = args.max_sequence_length - args.steps
+    return rng.integers(max(1, max_prompt_length // 16), max_prompt_length + 1, size=args.num_sequences)
+
+
+def run(args, paged: bool):
+    gc.collect()
+    rss_before = psutil.Process().memory_info().rss
+
+    prompt_lengths = get_prompt_lengths(args)
+    batch_size = args.num_sequences
+    if paged:
+        # Each sequence gets the blocks needed for its prompt and generated tokens
+        blocks_per_sequence = (prompt_lengths + args.steps + args.block_size - 1) // args.block_size
+        max_blocks_per_sequence = int(blocks_per_sequence.max())
+        block_table = numpy.zeros((batch_size, max_blocks_per_sequence), dtype=numpy.int32)
+        next_block = 0
+        for b in range(batch_size):
+            block_table[b, : blocks_per_sequence[b]] = numpy.arange(next_block, next_block + blocks_per_sequence[b])
+            next_block += int(blocks_per_sequence[b])
+        past_shape = [next_block, args.kv_num_heads, args.block_size, args.head_size]
+    else:
+        past_shape = [batch_size, args.kv_num_heads, args.max_sequence_length, args.head_size]
+
+    past_key = OrtValue.ortvalue_from_numpy(numpy.random.rand(*past_shape).astype(numpy.float32))
+    past_value = OrtValue.ortvalue_from_numpy(numpy.random.rand(*past_shape).astype(numpy.float32))
+    kv_cache_bytes = 2 * numpy.prod(past_shape) * 4
+
+    sess_options = SessionOptions()
+    sess_options.intra_op_num_threads = args.threads
+    session = InferenceSession(
+        create_gqa_graph(args, past_shape, paged), sess_options, providers=["CPUExecutionProvider"]
+    )
+
+    query = numpy.random.rand(batch_size, 1, args.num_heads * args.head_size).astype(numpy.float32)
+    key = numpy.random.rand(batch_size, 1, args.kv_num_heads * args.head_size).astype(numpy.float32)
+    value = numpy.random.rand(batch_size, 1, args.kv_num_heads * args.head_size).astype(numpy.float32)
+
+    io_binding = session.io_binding()
+    io_binding.bind_cpu_input("query", query)
+    io_binding.bind_cpu_input("key", key)
+    io_binding.bind_cpu_input("value", value)
+    io_binding.bind_ortvalue_input("past_key", past_key)
+    io_binding.bind_ortvalue_input("past_value", past_value)
+    if paged:
+        io_binding.bind_cpu_input("block_table", block_table)
+    io_binding.bind_output("output")
+    io_binding.bind_ortvalue_output("present_key", past_key)
+    io_binding.bind_ortvalue_output("present_value", past_value)
+
+    def step(i):
+        seqlens_k = (prompt_lengths + i).astype(numpy.int32)
+        io_binding.bind_cpu_input("seqlens_k", seqlens_k)
+        io_binding.bind_cpu_input("total_sequence_length", numpy.array([seqlens_k.max() + 1], dtype=numpy.int32))
+        session.run_with_iobinding(io_binding)
+
+    for i in range(args.warmup):
+        step(i % args.steps)
+
+    start = time.perf_counter()
+    for i in range(args.steps):
+        step(i)
+    elapsed = time.perf_counter() - start
+
+    rss_delta = psutil.Process().memory_info().rss - rss_before
+    return {
+        "kv cache": "paged" if paged else "contiguous",
+        "tokens/s": batch_size * args.steps / elapsed,
+        "kv cache MB": kv_cache_bytes / 2**20,
+        "resident delta MB": rss_delta / 2**20,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark GroupQueryAttention on CPU with paged kv cache")
+    parser.add_argument("--num_sequences", type=int, default=64, help="Number of concurrent sequences")
+    parser.add_argument("--max_sequence_length", type=int, default=4096)
+    parser.add_argument("--block_size", type=int, default=16, help="Tokens per block of the paged kv cache")
+    parser.add_argument("--num_heads", type=int, default=32)
+    parser.add_argument("--kv_num_heads", type=int, default=8)
+    parser.add_argument("--head_size", type=int, default=128)
+    parser.add_argument("--steps", type=int, default=32, help="Number of generated tokens per sequence")
+    parser.add_argument("--warmup", type=int, default=2)
+    parser.add_argument("--threads", type=int, default=0, help="Intra-op threads, 0 for the default")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--mode", choices=["both", "contiguous", "paged"], default="both")
+    args = parser.parse_args()
+
+    # The resident memory delta is only meaningful for the first mode run by the process, so run one mode per
+    # process to compare it.
+    modes = {"both": [False, True], "contiguous": [False], "paged": [True]}[args.mode]
+    for paged in modes:
+        result = run(args, paged)
+        print(", ".join(f"{k}: {v:.2f}" if isinstance(v, float) else f"{k}: {v}" for k, v in result.items()))
+
+
+if __name__ == "__main__":
+    main()
@@ -506,6 +506,223 @@ def create_group_query_attention_graph_past(
     return model.SerializeToString()
 
 
+def create_group_query_attention_graph_paged(
+    config,
+    num_blocks,
+    block_size,
+    max_blocks_per_sequence,
+    local_window_size=-1,
+    rotary=False,
+    rotary_interleaved=False,
+    packed=False,
+    softcap=0.0,
+    use_smooth_softmax=False,
+):
+    pool_shape = [num_blocks, config.kv_num_heads, block_size, config.head_size]
+    nodes = [
+        helper.make_node(
+            "GroupQueryAttention",
+            [
+                "query",
+                "key" if not packed else "",
+                "value" if not packed else "",
+                "past_key",
+                "past_value",
+                "seqlens_k",
+                "total_sequence_length",
+                "cos_cache" if rotary else "",
+                "sin_cache" if rotary else "",
+                "block_table",
+            ],
+            ["output", "present_key", "present_value"],
+            "GroupQueryAttention_0",
+            num_heads=config.num_heads,
+            kv_num_heads=config.kv_num_heads,
+            local_window_size=local_window_size,
+            do_rotary=rotary,
+            rotary_interleaved=rotary_interleaved,
+            softcap=softcap,
+            smooth_softmax=1 if use_smooth_softmax else 0,
+            domain="com.microsoft",
+        ),
+    ]
+
+    graph_input = [
+        helper.make_tensor_value_info(
+            "query",
+            ORT_TYPE,
+            [
+                config.batch_size,
+                config.sequence_length,
+                (
+                    (config.num_heads * config.head_size)
+                    if not packed
+                    else (config.num_heads * config.head_size + 2 * config.kv_num_heads * config.head_size)
+                ),
+            ],
+        ),
+        helper.make_tensor_value_info("past_key", ORT_TYPE, pool_shape),
+        helper.make_tensor_value_info("past_value", ORT_TYPE, pool_shape),
+        helper.make_tensor_value_info("seqlens_k", TensorProto.INT32, [config.batch_size]),
+        helper.make_tensor_value_info("total_sequence_length", TensorProto.INT32, [1]),
+        helper.make_tensor_value_info("block_table", TensorProto.INT32, [config.batch_size, max_blocks_per_sequence]),
+    ]
+    if not packed:
+        graph_input += [
+            helper.make_tensor_value_info(
+                "key",
+                ORT_TYPE,
+                [config.batch_size, config.sequence_length, config.kv_num_heads * config.head_size],
+            ),
+            helper.make_tensor_value_info(
+                "value",
+                ORT_TYPE,
+                [config.batch_size, config.sequence_length, config.kv_num_heads * config.head_size],
+            ),
+        ]
+    if rotary:
+        graph_input += [
+            helper.make_tensor_value_info(
+                "cos_cache",
+                ORT_TYPE,
+                [config.kv_sequence_length, (math.floor(config.head_size / 16) * 16) // 2],
+            ),
+            helper.make_tensor_value_info(
+                "sin_cache",
+                ORT_TYPE,
+                [config.kv_sequence_length, (math.floor(config.head_size / 16) * 16) // 2],
+            ),
+        ]
+
+    graph_output = [
+        helper.make_tensor_value_info(
+            "output",
+            ORT_TYPE,
+            [config.batch_size, config.sequence_length, config.num_heads * config.head_size],
+        ),
+        helper.make_tensor_value_info("present_key", ORT_TYPE, pool_shape),
+        helper.make_tensor_value_info("present_value", ORT_TYPE, pool_shape),
+    ]
+
+    graph = helper.make_graph(
+        nodes,
+        "GroupQueryAttention_Graph",
+        graph_input,
+        graph_output,
+    )
+
+    model = helper.make_model(graph)
+    return model.SerializeToString()
+
+
+def create_group_query_attention_graph_quantized(
+    config,
+    kv_cache_bit_width,
+    local_window_size=-1,
+    packed=False,
+    num_blocks=0,
+    block_size=0,
+    max_blocks_per_sequence=0,
+):
+    # with num_blocks > 0, the cache is a paged pool of blocks
+    paged = num_blocks > 0
+    if paged:
+        cache_shape = [num_blocks, config.kv_num_heads, block_size, config.head_size]
+    else:
+        cache_shape = [config.batch_size, config.kv_num_heads, config.kv_sequence_length, config.head_size]
+    scale_shape = cache_shape[:-1]
+    cache_type = TensorProto.INT8 if kv_cache_bit_width == 8 else TensorProto.INT4
+    nodes = [
+        helper.make_node(
+            "GroupQueryAttention",
+            [
+                "query",
+                "key" if not packed else "",
+                "value" if not packed else "",
+                "past_key",
+                "past_value",
+                "seqlens_k",
+                "total_sequence_length",
+                "",
+                "",
+                "block_table" if paged else "",
+                "past_key_scale",
+                "past_value_scale",
+            ],
+            ["output", "present_key", "present_value", "present_key_scale", "present_value_scale"],
+            "GroupQueryAttention_0",
+            num_heads=config.num_heads,
+            kv_num_heads=config.kv_num_heads,
+            local_window_size=local_window_size,
+            kv_cache_bit_width=kv_cache_bit_width,
+            domain="com.microsoft",
+        ),
+    ]
+
+    graph_input = [
+        helper.make_tensor_value_info(
+            "query",
+            ORT_TYPE,
+            [
+                config.batch_size,
+                config.sequence_length,
+                (
+                    (config.num_heads * config.head_size)
+                    if not packed
+                    else (config.num_heads * config.head_size + 2 * config.kv_num_heads * config.head_size)
+                ),
+            ],
+        ),
+        helper.make_tensor_value_info("past_key", cache_type, cache_shape),
+        helper.make_tensor_value_info("past_value", cache_type, cache_shape),
+        helper.make_tensor_value_info("seqlens_k", TensorProto.INT32, [config.batch_size]),
+        helper.make_tensor_value_info("total_sequence_length", TensorProto.INT32, [1]),
+        helper.make_tensor_value_info("past_key_scale", TensorProto.FLOAT, scale_shape),
+        helper.make_tensor_value_info("past_value_scale", TensorProto.FLOAT, scale_shape),
+    ]
+    if paged:
+        graph_input += [
+            helper.make_tensor_value_info(
+                "block_table", TensorProto.INT32, [config.batch_size, max_blocks_per_sequence]
+            ),
+        ]
+    if not packed:
+        graph_input += [
+            helper.make_tensor_value_info(
+                "key",
+                ORT_TYPE,
+                [config.batch_size, config.sequence_length, config.kv_num_heads * config.head_size],
+            ),
+            helper.make_tensor_value_info(
+                "value",
+                ORT_TYPE,
+                [config.batch_size, config.sequence_length, config.kv_num_heads * config.head_size],
+            ),
+        ]
+
+    graph_output = [
+        helper.make_tensor_value_info(
+            "output",
+            ORT_TYPE,
+            [config.batch_size, config.sequence_length, config.num_heads * config.head_size],
+        ),
+        helper.make_tensor_value_info("present_key", cache_type, cache_shape),
+        helper.make_tensor_value_info("present_value", cache_type, cache_shape),
+        helper.make_tensor_value_info("present_key_scale", TensorProto.FLOAT, scale_shape),
+        helper.make_tensor_value_info("present_value_scale", TensorProto.FLOAT, scale_shape),
+    ]
+
+    graph = helper.make_graph(
+        nodes,
+        "GroupQueryAttention_Graph",
+        graph_input,
+        graph_output,
+    )
+
+    model = helper.make_model(graph)
+    return model.SerializeToString()
+
+
 def generate_random_padding_mask(max_seqlen, batch_size, device, mode="random"):
     assert mode in ["full", "random", "third"]
     if mode == "full":
@@ -902,6 +1119,134 @@ def gqa_past_func(
         return output, present_k, present_v
 
 
+def gqa_paged_func(
+    q,
+    k_pool,
+    v_pool,
+    block_table,
+    config,
+    new_k,
+    new_v,
+    cos=None,
+    sin=None,
+    seqlens_k=None,
+    window_size=-1,
+    rotary_interleaved=False,
+    softcap=0.0,
+    use_smooth_softmax=False,
+    in_place=True,
+):
+    assert seqlens_k is not None
+    onnx_model_str = create_group_query_attention_graph_paged(
+        config,
+        k_pool.shape[0],
+        k_pool.shape[2],
+        block_table.shape[1],
+        local_window_size=window_size,
+        rotary=cos is not None,
+        rotary_interleaved=rotary_interleaved,
+        packed=new_k is None,
+        softcap=softcap,
+        use_smooth_softmax=use_smooth_softmax,
+    )
+    q = torch.reshape(q, (config.batch_size, config.sequence_length, -1))
+    past_k = OrtValue.ortvalue_from_numpy(k_pool.detach().cpu().numpy(), "cpu", 0)
+    past_v = OrtValue.ortvalue_from_numpy(v_pool.detach().cpu().numpy(), "cpu", 0)
+    sess_options = SessionOptions()
+    ort_session = InferenceSession(onnx_model_str, sess_options, providers=["CPUExecutionProvider"])
+    io_binding = ort_session.io_binding()
+    if new_k is not None and new_v is not None:
+        new_k = torch.reshape(new_k, (config.batch_size, config.sequence_length, -1))
+        new_v = torch.reshape(new_v, (config.batch_size, config.sequence_length, -1))
+        io_binding.bind_cpu_input("key", new_k.detach().cpu().numpy())
+        io_binding.bind_cpu_input("value", new_v.detach().cpu().numpy())
+    if cos is not None and sin is not None:
+        io_binding.bind_cpu_input("cos_cache", cos.detach().cpu().numpy())
+        io_binding.bind_cpu_input("sin_cache", sin.detach().cpu().numpy())
+    io_binding.bind_cpu_input("query", q.detach().cpu().numpy())
+    io_binding.bind_input("past_key", "cpu", 0, NUMPY_TYPE, past_k.shape(), past_k.data_ptr())
+    io_binding.bind_input("past_value", "cpu", 0, NUMPY_TYPE, past_v.shape(), past_v.data_ptr())
+    io_binding.bind_cpu_input("seqlens_k", seqlens_k.detach().cpu().numpy().astype(numpy.int32))
+    io_binding.bind_cpu_input("total_sequence_length", numpy.array([config.kv_sequence_length], dtype=numpy.int32))
+    io_binding.bind_cpu_input("block_table", block_table.detach().cpu().numpy().astype(numpy.int32))
+    io_binding.bind_output("output")
+    if in_place:
+        # the block pools are updated in place
+        io_binding.bind_ortvalue_output("present_key", past_k)
+        io_binding.bind_ortvalue_output("present_value", past_v)
+    else:
+        io_binding.bind_output("present_key")
+        io_binding.bind_output("present_value")
+    ort_session.run_with_iobinding(io_binding)
+    ort_output, present_k, present_v = io_binding.copy_outputs_to_cpu()
+    output = torch.tensor(numpy.array(ort_output))
+    return output, present_k, present_v
+
+
+def gqa_quantized_func(
+    q,
+    k_cache,
+    v_cache,
+    k_scale,
+    v_scale,
+    config,
+    new_k,
+    new_v,
+    seqlens_k=None,
+    window_size=-1,
+    block_table=None,
+    in_place=True,
+):
+    assert seqlens_k is not None
+    onnx_model_str = create_group_query_attention_graph_quantized(
+        config,
+        8,
+        local_window_size=window_size,
+        packed=new_k is None,
+        num_blocks=k_cache.shape[0] if block_table is not None else 0,
+        block_size=k_cache.shape[2] if block_table is not None else 0,
+        max_blocks_per_sequence=block_table.shape[1] if block_table is not None else 0,
+    )
+    q = torch.reshape(q, (config.batch_size, config.sequence_length, -1))
+    past_k = OrtValue.ortvalue_from_numpy(k_cache, "cpu", 0)
+    past_v = OrtValue.ortvalue_from_numpy(v_cache, "cpu", 0)
+    past_k_scale = OrtValue.ortvalue_from_numpy(k_scale, "cpu", 0)
+    past_v_scale = OrtValue.ortvalue_from_numpy(v_scale, "cpu", 0)
+    sess_options = SessionOptions()
+    ort_session = InferenceSession(onnx_model_str, sess_options, providers=["CPUExecutionProvider"])
+    io_binding = ort_session.io_binding()
+    if new_k is not None and new_v is not None:
+        new_k = torch.reshape(new_k, (config.batch_size, config.sequence_length, -1))
+        new_v = torch.reshape(new_v, (config.batch_size, config.sequence_length, -1))
+        io_binding.bind_cpu_input("key", new_k.detach().cpu().numpy())
+        io_binding.bind_cpu_input("value", new_v.detach().cpu().numpy())
+    io_binding.bind_cpu_input("query", q.detach().cpu().numpy())
+    io_binding.bind_ortvalue_input("past_key", past_k)
+    io_binding.bind_ortvalue_input("past_value", past_v)
+    io_binding.bind_ortvalue_input("past_key_scale", past_k_scale)
+    io_binding.bind_ortvalue_input("past_value_scale", past_v_scale)
+    io_binding.bind_cpu_input("seqlens_k", seqlens_k.detach().cpu().numpy().astype(numpy.int32))
+    io_binding.bind_cpu_input("total_sequence_length", numpy.array([config.kv_sequence_length], dtype=numpy.int32))
+    if block_table is not None:
+        io_binding.bind_cpu_input("block_table", block_table.detach().cpu().numpy().astype(numpy.int32))
+    io_binding.bind_output("output")
+    if in_place:
+        # the quantized cache and its scales are updated in place
+        io_binding.bind_ortvalue_output("present_key", past_k)
+        io_binding.bind_ortvalue_output("present_value", past_v)
+        io_binding.bind_ortvalue_output("present_key_scale", past_k_scale)
+        io_binding.bind_ortvalue_output("present_value_scale", past_v_scale)
+    else:
+        io_binding.bind_output("present_key")
+        io_binding.bind_output("present_value")
+        io_binding.bind_output("present_key_scale")
+        io_binding.bind_output("present_value_scale")
+    ort_session.run_with_iobinding(io_binding)
+    ort_output, present_k, present_v, present_k_scale, present_v_scale = io_binding.copy_outputs_to_cpu()
+    output = torch.tensor(numpy.array(ort_output))
+    return output, present_k, present_v, present_k_scale, present_v_scale
+
+
 def construct_causal_mask(seqlen_q, seqlen_k, query_padding_mask=None, key_padding_mask=None, device=None):
     row_idx = rearrange(torch.arange(seqlen_q, device=device, dtype=torch.long), "s -> s 1")
     col_idx = torch.arange(seqlen_k, device=device, dtype=torch.long)
@@ -1896,46 +2241,493 @@ def parity_check_gqa_past_no_buff(
     return all_close
 
 
-class TestGQA(unittest.TestCase):
-    def test_gqa_no_past(self):
-        torch.manual_seed(69)
-        print("-------- TEST GQA NO PAST (PROMPT CASE) ---------")
-        batches = [3] if pipeline_mode else [1, 3, 5]
-        seqs = (
-            [
-                (127, 127),
-                (240, 240),
-            ]
-            if pipeline_mode
-            else [
-                (127, 127),
-                (35, 35),
-                (2000, 2000),
-                (200, 200),
-                (240, 240),
-                (8000, 8000),
-            ]
-        )
-        num_h = [(32, 8)] if pipeline_mode else [(6, 6), (6, 3), (9, 9), (9, 3)]
-        h_sizes = [128] if pipeline_mode else [32, 40, 64, 80, 96, 128, 160, 192, 224, 256]
-        for b in batches:
-            for sq, skv in seqs:
-                for n, n2 in num_h:
-                    for h in h_sizes:
-                        for local in [False, True]:
-                            for rotary, rotary_interleaved in [(False, False), (True, False), (True, True)]:
-                                for packed in [False, True]:
-                                    for softcap in [0.0, 50.0]:
-                                        for use_smooth_softmax in [False, True]:
-                                            config = PromptConfig(b, sq, skv, sq + skv + 8, n, n2, h)
-                                            past_kv_format = Formats.BNSH
-                                            all_close = parity_check_gqa_prompt(
-                                                config,
-                                                local=local,
-                                                past_format=past_kv_format,
-                                                rotary=rotary,
-                                                rotary_interleaved=rotary_interleaved,
-                                                packed=packed,
+def parity_check_gqa_paged(
+    config,
+    block_size,
+    local=False,
+    rotary=False,
+    rotary_interleaved=False,
+    packed=False,
+    softcap=0.0,
+    use_smooth_softmax=False,
+    share_prefix=False,
+    in_place=True,
+    rtol=RTOL,
+    atol=ATOL,
+):
+    torch.manual_seed(69)
+    q = torch.randn(
+        config.batch_size,
+        config.sequence_length,
+        config.num_heads,
+        config.head_size,
+        device="cpu",
+        dtype=TORCH_TYPE,
+        requires_grad=False,
+    )
+    # contiguous BNSH cache the paged cache is built from
+    k = torch.randn(
+        config.batch_size,
+        config.kv_num_heads,
+        config.kv_sequence_length,
+        config.head_size,
+        device="cpu",
+        dtype=TORCH_TYPE,
+        requires_grad=False,
+    )
+    v = torch.randn_like(k)
+    new_k = torch.randn(
+        config.batch_size,
+        config.sequence_length,
+        config.kv_num_heads,
+        config.head_size,
+        device="cpu",
+        dtype=TORCH_TYPE,
+        requires_grad=False,
+    )
+    new_v = torch.randn_like(new_k)
+
+    window_size = (-1, 0)
+    left_window_size = -1
+    if local:
+        left_window_size = random.randint(1, config.kv_sequence_length)
+        window_size = (left_window_size, 0)
+
+    # With a shared prefix, all sequences use the block holding the first block_size positions of the first sequence
+    min_cache_seqlen = block_size if share_prefix else 0
+    if share_prefix:
+        k[:, :, :block_size] = k[0:1, :, :block_size]
+        v[:, :, :block_size] = v[0:1, :, :block_size]
+    cache_seqlens = torch.randint(
+        min_cache_seqlen,
+        config.kv_sequence_length - config.sequence_length + 1,
+        (config.batch_size,),
+        dtype=torch.int32,
+        device="cpu",
+    )
+
+    # Build the block pools and a block table that scatters the blocks of each sequence over the pools
+    max_blocks_per_sequence = (config.kv_sequence_length + block_size - 1) // block_size
+    num_blocks = config.batch_size * max_blocks_per_sequence + 3
+    padded_length = max_blocks_per_sequence * block_size
+    block_ids = torch.randperm(num_blocks, dtype=torch.int32)
+    block_table = block_ids[: config.batch_size * max_blocks_per_sequence].reshape(
+        config.batch_size, max_blocks_per_sequence
+    )
+    if share_prefix:
+        block_table[:, 0] = block_table[0, 0]
+    k_pool = torch.randn(num_blocks, config.kv_num_heads, block_size, config.head_size, dtype=TORCH_TYPE)
+    v_pool = torch.randn_like(k_pool)
+    k_padded = torch.nn.functional.pad(k, (0, 0, 0, padded_length - config.kv_sequence_length))
+    v_padded = torch.nn.functional.pad(v, (0, 0, 0, padded_length - config.kv_sequence_length))
+    for b in range(config.batch_size):
+        for i in range(max_blocks_per_sequence):
+            k_pool[block_table[b, i]] = k_padded[b, :, i * block_size : (i + 1) * block_size]
+            v_pool[block_table[b, i]] = v_padded[b, :, i * block_size : (i + 1) * block_size]
+
+    if rotary:
+        rotary_dim = math.floor(config.head_size / 16) * 16
+        angle = torch.rand(config.kv_sequence_length, rotary_dim // 2, device="cpu") * 2 * math.pi
+        cos = torch.cos(angle).to(dtype=TORCH_TYPE)
+        sin = torch.sin(angle).to(dtype=TORCH_TYPE)
+        rot = LlamaMSRotaryEmbedding()
+        q_ro = rot(
+            q.clone(), cos.unsqueeze(0).unsqueeze(2), sin.unsqueeze(0).unsqueeze(2), cache_seqlens, rotary_interleaved
+        )
+        k_ro = rot(
+            new_k.clone(),
+            cos.unsqueeze(0).unsqueeze(2),
+            sin.unsqueeze(0).unsqueeze(2),
+            cache_seqlens,
+            rotary_interleaved,
+        )
+    else:
+        cos, sin = None, None
+        q_ro, k_ro = q, new_k
+
+    # Pytorch to compare
+    k_cache_ref = k.clone().transpose(1, 2)
+    v_cache_ref = v.clone().transpose(1, 2)
+    arange = rearrange(torch.arange(config.kv_sequence_length, device="cpu"), "s -> 1 s")
+    cache_seqlens_expanded = rearrange(cache_seqlens, "b -> b 1")
+    update_mask = torch.logical_and(
+        cache_seqlens_expanded <= arange, arange < cache_seqlens_expanded + config.sequence_length
+    )
+    k_cache_ref[update_mask] = rearrange(k_ro, "b s ... -> (b s) ...")
+    v_cache_ref[update_mask] = rearrange(new_v, "b s ... -> (b s) ...")
+    k_cache_rep = repeat(k_cache_ref, "b s h d -> b s (h g) d", g=config.num_heads // config.kv_num_heads)
+    v_cache_rep = repeat(v_cache_ref, "b s h d -> b s (h g) d", g=config.num_heads // config.kv_num_heads)
+    key_padding_mask = arange < cache_seqlens_expanded + config.sequence_length
+    out_ref, _ = attention_ref(
+        q_ro,
+        k_cache_rep,
+        v_cache_rep,
+        None,
+        key_padding_mask,
+        0.0,
+        None,
+        causal=True,
+        window_size=window_size,
+        softcap=softcap,
+        use_smooth_softmax=use_smooth_softmax,
+    )
+    out_ref = out_ref.detach().cpu().numpy()
+
+    cache_seqlens += config.sequence_length - 1
+
+    # ORT function
+    if packed:
+        packed_qkv = torch.concatenate([q, new_k, new_v], dim=2)
+        out, present_k, present_v = gqa_paged_func(
+            packed_qkv,
+            k_pool,
+            v_pool,
+            block_table,
+            config,
+            None,
+            None,
+            cos,
+            sin,
+            cache_seqlens,
+            left_window_size,
+            rotary_interleaved,
+            softcap,
+            use_smooth_softmax=use_smooth_softmax,
+            in_place=in_place,
+        )
+    else:
+        out, present_k, present_v = gqa_paged_func(
+            q,
+            k_pool,
+            v_pool,
+            block_table,
+            config,
+            new_k,
+            new_v,
+            cos,
+            sin,
+            cache_seqlens,
+            left_window_size,
+            rotary_interleaved,
+            softcap,
+            use_smooth_softmax=use_smooth_softmax,
+            in_place=in_place,
+        )
+    out = torch.reshape(out, (config.batch_size, config.sequence_length, config.num_heads, config.head_size))
+    out = out.detach().cpu().numpy()
+
+    # Make sure the blocks of each sequence hold the updated cache
+    k_cache_ref = k_cache_ref.transpose(1, 2).detach().cpu().numpy()
+    v_cache_ref = v_cache_ref.transpose(1, 2).detach().cpu().numpy()
+    present_k = numpy.array(present_k)
+    present_v = numpy.array(present_v)
+    cache_matches = True
+    for b in range(config.batch_size):
+        total_seqlen = int(cache_seqlens[b]) + 1
+        paged_k = numpy.concatenate([present_k[block] for block in block_table[b].tolist()], axis=1)
+        paged_v = numpy.concatenate([present_v[block] for block in block_table[b].tolist()], axis=1)
+        cache_matches &= numpy.allclose(
+            paged_k[:, :total_seqlen], k_cache_ref[b, :, :total_seqlen], rtol=RTOL, atol=ATOL, equal_nan=True
+        )
+        cache_matches &= numpy.allclose(
+            paged_v[:, :total_seqlen], v_cache_ref[b, :, :total_seqlen], rtol=RTOL, atol=ATOL, equal_nan=True
+        )
+
+    # Blocks not used by this batch hold the cache of other sequences and must be left unchanged
+    other_blocks = sorted(set(range(num_blocks)) - set(block_table.flatten().tolist()))
+    cache_matches &= numpy.array_equal(present_k[other_blocks], k_pool[other_blocks].numpy())
+    cache_matches &= numpy.array_equal(present_v[other_blocks], v_pool[other_blocks].numpy())
+
+    # Compare results
+    all_close = cache_matches and numpy.allclose(out, out_ref, rtol=rtol, atol=atol, equal_nan=True)
+    correct = GREEN + "True" + RESET if all_close else RED + "False" + RESET
+    print(
+        "Paged KV-cache",
+        " block size:",
+        block_size,
+        " share prefix:",
+        share_prefix,
+        " packed:",
+        packed,
+        " local:",
+        local,
+        " rotary:",
+        rotary,
+        " rotary_interleaved:",
+        rotary_interleaved,
+        " softcap:",
+        softcap,
+        " smooth_softmax:",
+        use_smooth_softmax,
+        " B:",
+        config.batch_size,
+        " S:",
+        config.sequence_length,
+        " kv S:",
+        config.kv_sequence_length,
+        " N:",
+        config.num_heads,
+        " kv N:",
+        config.kv_num_heads,
+        " h:",
+        config.head_size,
+        " Mean Error:",
+        numpy.mean(numpy.abs(out - out_ref)),
+        correct,
+    )
+    return all_close
+
+
+def quantize_kv_cache_ref(cache):
+    """Quantizes each row of head_size values of a BNSH cache to int8 with a symmetric scale."""
+    max_abs = numpy.abs(cache).max(axis=-1)
+    scale = numpy.where(max_abs > 0, max_abs / numpy.float32(127), numpy.float32(1)).astype(numpy.float32)
+    quantized = numpy.clip(numpy.round(cache / scale[..., None]), -127, 127).astype(numpy.int8)
+    return quantized, scale
+
+
+def parity_check_gqa_quantized_kv_cache(
+    config,
+    local=False,
+    packed=False,
+    block_size=0,
+    in_place=True,
+    rtol=RTOL,
+    atol=ATOL,
+):
+    torch.manual_seed(69)
+    q = torch.randn(
+        config.batch_size,
+        config.sequence_length,
+        config.num_heads,
+        config.head_size,
+        device="cpu",
+        dtype=torch.float32,
+        requires_grad=False,
+    )
+    k = torch.randn(
+        config.batch_size,
+        config.kv_num_heads,
+        config.kv_sequence_length,
+        config.head_size,
+        device="cpu",
+        dtype=torch.float32,
+        requires_grad=False,
+    )
+    v = torch.randn_like(k)
+    new_k = torch.randn(
+        config.batch_size,
+        config.sequence_length,
+        config.kv_num_heads,
+        config.head_size,
+        device="cpu",
+        dtype=torch.float32,
+        requires_grad=False,
+    )
+    new_v = torch.randn_like(new_k)
+
+    window_size = (-1, 0)
+    left_window_size = -1
+    if local:
+        left_window_size = random.randint(1, config.kv_sequence_length)
+        window_size = (left_window_size, 0)
+
+    cache_seqlens = torch.randint(
+        0,
+        config.kv_sequence_length - config.sequence_length + 1,
+        (config.batch_size,),
+        dtype=torch.int32,
+        device="cpu",
+    )
+
+    k_cache, k_scale = quantize_kv_cache_ref(k.numpy())
+    v_cache, v_scale = quantize_kv_cache_ref(v.numpy())
+
+    # Pytorch to compare, with the past and new keys and values going through the quantization of the cache
+    k_cache_ref = k.clone().transpose(1, 2)
+    v_cache_ref = v.clone().transpose(1, 2)
+    arange = rearrange(torch.arange(config.kv_sequence_length, device="cpu"), "s -> 1 s")
+    cache_seqlens_expanded = rearrange(cache_seqlens, "b -> b 1")
+    update_mask = torch.logical_and(
+        cache_seqlens_expanded <= arange, arange < cache_seqlens_expanded + config.sequence_length
+    )
+    k_cache_ref[update_mask] = rearrange(new_k, "b s ... -> (b s) ...")
+    v_cache_ref[update_mask] = rearrange(new_v, "b s ... -> (b s) ...")
+    k_ref_quantized, k_ref_scale = quantize_kv_cache_ref(k_cache_ref.numpy())
+    v_ref_quantized, v_ref_scale = quantize_kv_cache_ref(v_cache_ref.numpy())
+    k_cache_dq = torch.from_numpy(k_ref_quantized.astype(numpy.float32) * k_ref_scale[..., None])
+    v_cache_dq = torch.from_numpy(v_ref_quantized.astype(numpy.float32) * v_ref_scale[..., None])
+    key_padding_mask = arange < cache_seqlens_expanded + config.sequence_length
+    out_ref, _ = attention_ref(
+        q,
+        k_cache_dq,
+        v_cache_dq,
+        None,
+        key_padding_mask,
+        0.0,
+        None,
+        causal=True,
+        window_size=window_size,
+    )
+    out_ref = out_ref.detach().cpu().numpy()
+
+    cache_seqlens += config.sequence_length - 1
+
+    # With a block size, scatter the blocks of each sequence over block pools which also hold blocks of other sequences
+    block_table = None
+    if block_size > 0:
+        max_blocks_per_sequence = (config.kv_sequence_length + block_size - 1) // block_size
+        num_blocks = config.batch_size * max_blocks_per_sequence + 3
+        padded_length = max_blocks_per_sequence * block_size
+        block_table = torch.randperm(num_blocks, dtype=torch.int32)[: config.batch_size * max_blocks_per_sequence]
+        block_table = block_table.reshape(config.batch_size, max_blocks_per_sequence)
+        pad = [(0, 0), (0, 0), (0, padded_length - config.kv_sequence_length)]
+        pools = []
+        for cache, scale in [(k_cache, k_scale), (v_cache, v_scale)]:
+            pool_shape = (num_blocks, config.kv_num_heads, block_size, config.head_size)
+            cache_pool = torch.randint(-127, 128, pool_shape, dtype=torch.int8).numpy()
+            scale_pool = torch.rand(pool_shape[:-1], dtype=torch.float32).numpy()
+            cache_padded = numpy.pad(cache, [*pad, (0, 0)])
+            scale_padded = numpy.pad(scale, pad, constant_values=1)
+            for b in range(config.batch_size):
+                for i in range(max_blocks_per_sequence):
+                    block = int(block_table[b, i])
+                    cache_pool[block] = cache_padded[b, :, i * block_size : (i + 1) * block_size]
+                    scale_pool[block] = scale_padded[b, :, i * block_size : (i + 1) * block_size]
+            pools += [cache_pool, scale_pool]
+        k_cache, k_scale, v_cache, v_scale = pools
+        past_pools = [pool.copy() for pool in pools]
+
+    # ORT function
+    if packed:
+        packed_qkv = torch.concatenate([q, new_k, new_v], dim=2)
+        out, present_k, present_v, present_k_scale, present_v_scale = gqa_quantized_func(
+            packed_qkv,
+            k_cache,
+            v_cache,
+            k_scale,
+            v_scale,
+            config,
+            None,
+            None,
+            cache_seqlens,
+            left_window_size,
+            block_table=block_table,
+            in_place=in_place,
+        )
+    else:
+        out, present_k, present_v, present_k_scale, present_v_scale = gqa_quantized_func(
+            q,
+            k_cache,
+            v_cache,
+            k_scale,
+            v_scale,
+            config,
+            new_k,
+            new_v,
+            cache_seqlens,
+            left_window_size,
+            block_table=block_table,
+            in_place=in_place,
+        )
+    out = torch.reshape(out, (config.batch_size, config.sequence_length, config.num_heads, config.head_size))
+    out = out.detach().cpu().numpy()
+
+    cache_matches = True
+    if block_table is not None:
+        # Blocks not used by this batch hold the cache of other sequences and must be left unchanged
+        presents = [numpy.array(present) for present in [present_k, present_k_scale, present_v, present_v_scale]]
+        other_blocks = sorted(set(range(num_blocks)) - set(block_table.flatten().tolist()))
+        for present, past in zip(presents, past_pools, strict=True):
+            cache_matches &= numpy.array_equal(present[other_blocks], past[other_blocks])
+        # Gather the blocks of each sequence into a contiguous cache to compare with the reference
+        present_k, present_v = (
+            numpy.stack([numpy.concatenate(pool[block_table[b].tolist()], axis=1) for b in range(config.batch_size)])
+            for pool in (presents[0], presents[2])
+        )
+
+    # Make sure the present cache holds the quantized keys and values, allowing a rounding difference of one step
+    k_ref_quantized = k_ref_quantized.transpose(0, 2, 1, 3).astype(numpy.int32)
+    v_ref_quantized = v_ref_quantized.transpose(0, 2, 1, 3).astype(numpy.int32)
+    present_k = numpy.array(present_k).astype(numpy.int32)
+    present_v = numpy.array(present_v).astype(numpy.int32)
+    for b in range(config.batch_size):
+        total_seqlen = int(cache_seqlens[b]) + 1
+        cache_matches &= numpy.abs(present_k[b, :, :total_seqlen] - k_ref_quantized[b, :, :total_seqlen]).max() <= 1
+        cache_matches &= numpy.abs(present_v[b, :, :total_seqlen] - v_ref_quantized[b, :, :total_seqlen]).max() <= 1
+
+    # Compare results
+    all_close = cache_matches and numpy.allclose(out, out_ref, rtol=rtol, atol=atol, equal_nan=True)
+    correct = GREEN + "True" + RESET if all_close else RED + "False" + RESET
+    print(
+        "Quantized KV-cache",
+        " block size:",
+        block_size,
+        " in place:",
+        in_place,
+        " packed:",
+        packed,
+        " local:",
+        local,
+        " B:",
+        config.batch_size,
+        " S:",
+        config.sequence_length,
+        " kv S:",
+        config.kv_sequence_length,
+        " N:",
+        config.num_heads,
+        " kv N:",
+        config.kv_num_heads,
+        " h:",
+        config.head_size,
+        " Mean Error:",
+        numpy.mean(numpy.abs(out - out_ref)),
+        correct,
+    )
+    return all_close
+
+
+class TestGQA(unittest.TestCase):
+    def test_gqa_no_past(self):
+        torch.manual_seed(69)
+        print("-------- TEST GQA NO PAST (PROMPT CASE) ---------")
+        batches = [3] if pipeline_mode else [1, 3, 5]
+        seqs = (
+            [
+                (127, 127),
+                (240, 240),
+            ]
+            if pipeline_mode
+            else [
+                (127, 127),
+                (35, 35),
+                (2000, 2000),
+                (200, 200),
+                (240, 240),
+                (8000, 8000),
+            ]
+        )
+        num_h = [(32, 8)] if pipeline_mode else [(6, 6), (6, 3), (9, 9), (9, 3)]
+        h_sizes = [128] if pipeline_mode else [32, 40, 64, 80, 96, 128, 160, 192, 224, 256]
+        for b in batches:
+            for sq, skv in seqs:
+                for n, n2 in num_h:
+                    for h in h_sizes:
+                        for local in [False, True]:
+                            for rotary, rotary_interleaved in [(False, False), (True, False), (True, True)]:
+                                for packed in [False, True]:
+                                    for softcap in [0.0, 50.0]:
+                                        for use_smooth_softmax in [False, True]:
+                                            config = PromptConfig(b, sq, skv, sq + skv + 8, n, n2, h)
+                                            past_kv_format = Formats.BNSH
+                                            all_close = parity_check_gqa_prompt(
+                                                config,
+                                                local=local,
+                                                past_format=past_kv_format,
+                                                rotary=rotary,
+                                                rotary_interleaved=rotary_interleaved,
+                                                packed=packed,
                                                 softcap=softcap,
                                                 use_smooth_softmax=use_smooth_softmax,
                                             )
@@ -2070,5 +2862,87 @@ class TestGQA(unittest.TestCase):
                                     self.assertTrue(all_close)
 
 
+    def test_gqa_paged_kv_cache(self):
+        print("-------- TEST GQA PAGED KV-CACHE (TOKEN GEN) ---------")
+        batches = [3] if pipeline_mode else [1, 3, 5]
+        seqs = [(1, 128)] if pipeline_mode else [(1, 128), (1, 339), (1, 1024), (1, 799)]
+        num_h = [(9, 3)] if pipeline_mode else [(6, 6), (6, 3), (9, 9), (9, 3)]
+        h_sizes = [64] if pipeline_mode else [32, 64, 128, 256]
+        block_sizes = [16, 48] if pipeline_mode else [1, 16, 48, 128]
+        random.seed(69)
+        for b in batches:
+            for s, s2 in seqs:
+                for n, n2 in num_h:
+                    for h in h_sizes:
+                        for block_size in block_sizes:
+                            for local in [False, True]:
+                                for rotary, rotary_interleaved in [(False, False), (True, False)]:
+                                    for packed in [False, True]:
+                                        for share_prefix in [False, True]:
+                                            if share_prefix and block_size > s2 - s:
+                                                continue
+                                            config = Config(b, s, s2, -1, n, n2, h)
+                                            all_close = parity_check_gqa_paged(
+                                                config,
+                                                block_size,
+                                                local=local,
+                                                rotary=rotary,
+                                                rotary_interleaved=rotary_interleaved,
+                                                packed=packed,
+                                                share_prefix=share_prefix,
+                                            )
+                                            self.assertTrue(all_close)
+
+    def test_gqa_paged_kv_cache_not_in_place(self):
+        print("-------- TEST GQA PAGED KV-CACHE NOT IN PLACE (TOKEN GEN) ---------")
+        for share_prefix in [False, True]:
+            for block_size in [1, 16, 48]:
+                config = Config(3, 1, 339, -1, 9, 3, 64)
+                all_close = parity_check_gqa_paged(
+                    config,
+                    block_size,
+                    rotary=True,
+                    share_prefix=share_prefix,
+                    in_place=False,
+                )
+                self.assertTrue(all_close)
+
+    def test_gqa_quantized_kv_cache(self):
+        print("-------- TEST GQA INT8 KV-CACHE (TOKEN GEN) ---------")
+        batches = [3] if pipeline_mode else [1, 3, 5]
+        seqs = [(1, 128)] if pipeline_mode else [(1, 128), (1, 339), (1, 1024), (1, 799)]
+        num_h = [(9, 3)] if pipeline_mode else [(6, 6), (6, 3), (9, 9), (9, 3)]
+        h_sizes = [64] if pipeline_mode else [32, 64, 128, 256]
+        random.seed(69)
+        for b in batches:
+            for s, s2 in seqs:
+                for n, n2 in num_h:
+                    for h in h_sizes:
+                        for local in [False, True]:
+                            for packed in [False, True]:
+                                config = Config(b, s, s2, -1, n, n2, h)
+                                all_close = parity_check_gqa_quantized_kv_cache(
+                                    config,
+                                    local=local,
+                                    packed=packed,
+                                )
+                                self.assertTrue(all_close)
+
+    def test_gqa_quantized_paged_kv_cache(self):
+        print("-------- TEST GQA INT8 PAGED KV-CACHE (TOKEN GEN) ---------")
+        random.seed(69)
+        for in_place in [True, False]:
+            for block_size in [1, 16, 48]:
+                for packed in [False, True]:
+                    config = Config(3, 1, 339, -1, 9, 3, 64)
+                    all_close = parity_check_gqa_quantized_kv_cache(
+                        config,
+                        packed=packed,
+                        block_size=block_size,
+                        in_place=in_place,
+                    )
+                    self.assertTrue(all_close)
+
+
 if __name__ == "__main__":
     unittest.main()